@@ -310,6 +310,15 @@ fn make_classifier(source_file: &SourceFile) -> Classifier {
                 ("qiniu_ng_batch_uploader_upload_reader", "params"),
             ],
         ));
+        classifier.add_class(Class::new(
+            "CallbackQueue",
+            Some("qiniu_ng_callback_queue_t"),
+            Regex::new("^qiniu_ng_callback_queue_(\\w+)").unwrap(),
+            None,
+            source_file.function_declarations().iter(),
+            None,
+            vec![("qiniu_ng_callback_queue_pop", "events")],
+        ));
         classifier.add_class(Class::new(
             "UploadResponse",
             Some("qiniu_ng_upload_response_t"),
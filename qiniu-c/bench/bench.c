@@ -0,0 +1,282 @@
+// C 接口基准测试
+//
+// 测量通过 FFI 调用 Etag 计算接口和上传接口的开销，结果以 JSON 格式输出到标准输出。
+// 上传请求由模拟的 HTTP 请求处理函数立即响应，因此无需配置七牛账户，也不依赖网络，测量结果仅包含 SDK 自身的开销。
+// 目前仅支持 POSIX 平台
+
+#include "libqiniu_ng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MIN_DURATION_NS (500ULL * 1000 * 1000)
+#define MAX_ITERATIONS (1000000ULL)
+#define BUCKET_NAME "bench-bucket"
+
+typedef bool (*bench_func_t)(void *context);
+
+static bool first_result = true;
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + (unsigned long long) ts.tv_nsec;
+}
+
+// 至少运行 MIN_DURATION_NS 纳秒，输出平均每次调用的耗时和吞吐量
+static void run_bench(const char *name, unsigned long long param, size_t bytes_per_op, bench_func_t func, void *context) {
+    if (!func(context)) {
+        fprintf(stderr, "benchmark %s/%llu failed\n", name, param);
+        exit(1);
+    }
+    unsigned long long iterations = 0, start = now_ns(), elapsed = 0;
+    do {
+        if (!func(context)) {
+            fprintf(stderr, "benchmark %s/%llu failed\n", name, param);
+            exit(1);
+        }
+        iterations++;
+        elapsed = now_ns() - start;
+    } while (elapsed < MIN_DURATION_NS && iterations < MAX_ITERATIONS);
+
+    double ns_per_op = (double) elapsed / (double) iterations;
+    printf("%s\n    {\"name\": \"%s\", \"param\": %llu, \"iterations\": %llu, \"ns_per_op\": %.1f, \"bytes_per_sec\": %.1f}",
+           first_result ? "" : ",", name, param, iterations, ns_per_op,
+           bytes_per_op > 0 ? (double) bytes_per_op * 1e9 / ns_per_op : 0.0);
+    first_result = false;
+    fflush(stdout);
+}
+
+static char *create_bench_file(size_t size) {
+    char *file_path = strdup("/tmp/qiniu_ng_bench_XXXXXX");
+    int fd = mkstemp(file_path);
+    if (fd < 0) {
+        perror("mkstemp() failed");
+        exit(1);
+    }
+    char buf[4096];
+    for (size_t i = 0; i < sizeof(buf); i++) {
+        buf[i] = (char) (i % 251);
+    }
+    for (size_t rest = size; rest > 0;) {
+        size_t to_write = rest < sizeof(buf) ? rest : sizeof(buf);
+        ssize_t written = write(fd, buf, to_write);
+        if (written <= 0) {
+            perror("write() failed");
+            exit(1);
+        }
+        rest -= (size_t) written;
+    }
+    close(fd);
+    return file_path;
+}
+
+struct etag_data_context {
+    const char *data;
+    size_t data_len;
+    size_t chunk_size;
+};
+
+static bool bench_etag_from_data(void *context) {
+    struct etag_data_context *ctx = (struct etag_data_context *) context;
+    char etag[ETAG_SIZE + 1];
+    qiniu_ng_etag_from_data(ctx->data, ctx->data_len, (char *) &etag);
+    return true;
+}
+
+static bool bench_etag_update(void *context) {
+    struct etag_data_context *ctx = (struct etag_data_context *) context;
+    char etag[ETAG_SIZE + 1];
+    qiniu_ng_etag_t hasher = qiniu_ng_etag_new();
+    for (size_t offset = 0; offset < ctx->data_len; offset += ctx->chunk_size) {
+        size_t len = ctx->data_len - offset < ctx->chunk_size ? ctx->data_len - offset : ctx->chunk_size;
+        qiniu_ng_etag_update(hasher, ctx->data + offset, len);
+    }
+    qiniu_ng_etag_result(hasher, &etag);
+    qiniu_ng_etag_free(&hasher);
+    return true;
+}
+
+struct etag_file_context {
+    const char *file_path;
+    size_t threads;
+};
+
+static bool bench_etag_from_file_path(void *context) {
+    struct etag_file_context *ctx = (struct etag_file_context *) context;
+    char etag[ETAG_SIZE + 1];
+    if (ctx->threads > 0) {
+        return qiniu_ng_etag_from_file_path_parallel(ctx->file_path, ctx->threads, (char *) &etag, NULL);
+    }
+    return qiniu_ng_etag_from_file_path(ctx->file_path, (char *) &etag, NULL);
+}
+
+static void set_json_response(qiniu_ng_http_response_t response, const char *body) {
+    qiniu_ng_http_response_set_status_code(response, 200);
+    qiniu_ng_http_response_set_header(response, "Content-Type", "application/json");
+    qiniu_ng_http_response_set_header(response, "X-Reqid", "bench-req-id");
+    qiniu_ng_http_response_set_body(response, body, strlen(body));
+}
+
+// 模拟七牛区域查询服务器和上传服务器，所有请求都立即成功
+static void mock_http_call(qiniu_ng_http_request_t request, qiniu_ng_http_response_t response, qiniu_ng_callback_err_t *err, void *data) {
+    (void)(err);
+    (void)(data);
+    qiniu_ng_str_t url = qiniu_ng_http_request_get_url(request);
+    const char *url_ptr = qiniu_ng_str_get_ptr(url);
+    const char *uploads = strstr(url_ptr, "/uploads");
+    if (strstr(url_ptr, "/v3/query") != NULL) {
+        set_json_response(response,
+            "{\"hosts\":[{\"io\":{\"src\":{\"main\":[\"io.example.com\"]}},"
+            "\"up\":{\"src\":{\"main\":[\"up.example.com\"]},\"acc\":{\"main\":[\"up.example.com\"]},"
+            "\"old_src\":{\"main\":[\"up.example.com\"]},\"old_acc\":{\"main\":[\"up.example.com\"]}}}]}");
+    } else if (uploads == NULL) {
+        set_json_response(response, "{\"hash\":\"bench-hash\",\"key\":\"bench-key\"}");
+    } else if (uploads[strlen("/uploads")] == '\0') {
+        set_json_response(response, "{\"uploadId\":\"bench-upload-id\"}");
+    } else if (strchr(uploads + strlen("/uploads/"), '/') != NULL) {
+        set_json_response(response, "{\"etag\":\"bench-etag\"}");
+    } else {
+        set_json_response(response, "{\"hash\":\"bench-hash\",\"key\":\"bench-key\"}");
+    }
+    qiniu_ng_str_free(&url);
+}
+
+struct upload_context {
+    qiniu_ng_upload_manager_t upload_manager;
+    qiniu_ng_bucket_uploader_t bucket_uploader;
+    qiniu_ng_upload_token_t token;
+    const char *file_path;
+    qiniu_ng_resumable_policy_t resumable_policy;
+    size_t max_concurrency;
+};
+
+static bool bench_upload_manager_upload_file_path(void *context) {
+    struct upload_context *ctx = (struct upload_context *) context;
+    qiniu_ng_upload_params_t params = {
+        .key = "bench-key",
+        .resumable_policy = ctx->resumable_policy,
+        .max_concurrency = ctx->max_concurrency,
+    };
+    qiniu_ng_upload_response_t upload_response;
+    qiniu_ng_err_t err;
+    if (!qiniu_ng_upload_manager_upload_file_path(ctx->upload_manager, ctx->token, ctx->file_path, &params, &upload_response, &err)) {
+        qiniu_ng_err_fputs(err, stderr);
+        return false;
+    }
+    qiniu_ng_upload_response_free(&upload_response);
+    return true;
+}
+
+static bool bench_bucket_uploader_upload_file_path(void *context) {
+    struct upload_context *ctx = (struct upload_context *) context;
+    qiniu_ng_upload_params_t params = {
+        .key = "bench-key",
+        .resumable_policy = ctx->resumable_policy,
+        .max_concurrency = ctx->max_concurrency,
+    };
+    qiniu_ng_upload_response_t upload_response;
+    qiniu_ng_err_t err;
+    if (!qiniu_ng_bucket_uploader_upload_file_path(ctx->bucket_uploader, ctx->token, ctx->file_path, &params, &upload_response, &err)) {
+        qiniu_ng_err_fputs(err, stderr);
+        return false;
+    }
+    qiniu_ng_upload_response_free(&upload_response);
+    return true;
+}
+
+static void bench_etag(void) {
+    const size_t sizes[] = {1, 1 << 12, 1 << 20, (1 << 22) + 1};
+    const size_t max_size = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+    char *data = (char *) malloc(max_size);
+    for (size_t i = 0; i < max_size; i++) {
+        data[i] = (char) (i % 251);
+    }
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        struct etag_data_context ctx = {.data = data, .data_len = sizes[i]};
+        run_bench("qiniu_ng_etag_from_data", sizes[i], sizes[i], bench_etag_from_data, &ctx);
+    }
+    // 以不同的块尺寸多次调用 qiniu_ng_etag_update()，块尺寸越小，FFI 调用的开销所占比例越大
+    const size_t chunk_sizes[] = {64, 1 << 12, 1 << 16};
+    for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); i++) {
+        struct etag_data_context ctx = {.data = data, .data_len = 1 << 20, .chunk_size = chunk_sizes[i]};
+        run_bench("qiniu_ng_etag_update", chunk_sizes[i], 1 << 20, bench_etag_update, &ctx);
+    }
+    free(data);
+
+    const size_t file_size = (1 << 26) + 1;
+    char *file_path = create_bench_file(file_size);
+    const size_t threads[] = {0, 1, 4, 8};
+    for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+        struct etag_file_context ctx = {.file_path = file_path, .threads = threads[i]};
+        run_bench(threads[i] > 0 ? "qiniu_ng_etag_from_file_path_parallel" : "qiniu_ng_etag_from_file_path",
+                  threads[i], file_size, bench_etag_from_file_path, &ctx);
+    }
+    unlink(file_path);
+    free(file_path);
+}
+
+static void bench_upload(void) {
+    qiniu_ng_config_builder_t builder = qiniu_ng_config_builder_new();
+    qiniu_ng_config_builder_set_http_call_handler(builder, mock_http_call, NULL);
+    qiniu_ng_config_builder_disable_uplog(builder);
+    qiniu_ng_config_builder_create_new_domains_manager(builder, NULL, NULL);
+    qiniu_ng_config_builder_domains_manager_disable_url_resolution(builder);
+    qiniu_ng_config_builder_domains_manager_disable_auto_persistent(builder);
+    qiniu_ng_config_t config;
+    qiniu_ng_err_t err;
+    if (!qiniu_ng_config_build(&builder, &config, &err)) {
+        qiniu_ng_err_fputs(err, stderr);
+        exit(1);
+    }
+
+    qiniu_ng_upload_policy_builder_t policy_builder = qiniu_ng_upload_policy_builder_new_for_bucket(BUCKET_NAME, config);
+    qiniu_ng_upload_token_t token = qiniu_ng_upload_token_new_from_policy_builder(policy_builder, "abcdefghklmnopq", "1234567890");
+    qiniu_ng_upload_policy_builder_free(&policy_builder);
+    qiniu_ng_upload_manager_t upload_manager = qiniu_ng_upload_manager_new(config);
+    qiniu_ng_bucket_uploader_t bucket_uploader = qiniu_ng_bucket_uploader_new_from_bucket_name(upload_manager, BUCKET_NAME, "abcdefghklmnopq", 8);
+
+    // 单字节文件的上传几乎不包含数据读取的开销，主要用于衡量每次调用上传接口的固定开销
+    const size_t file_sizes[] = {1, 1 << 25};
+    for (size_t i = 0; i < sizeof(file_sizes) / sizeof(file_sizes[0]); i++) {
+        char *file_path = create_bench_file(file_sizes[i]);
+        struct upload_context ctx = {
+            .upload_manager = upload_manager,
+            .bucket_uploader = bucket_uploader,
+            .token = token,
+            .file_path = file_path,
+            .resumable_policy = qiniu_ng_resumable_policy_never_be_resumeable,
+        };
+        run_bench("qiniu_ng_upload_manager_upload_file_path/form", file_sizes[i], file_sizes[i],
+                  bench_upload_manager_upload_file_path, &ctx);
+        run_bench("qiniu_ng_bucket_uploader_upload_file_path/form", file_sizes[i], file_sizes[i],
+                  bench_bucket_uploader_upload_file_path, &ctx);
+
+        ctx.resumable_policy = qiniu_ng_resumable_policy_always_be_resumeable;
+        const size_t concurrency[] = {1, 4, 8};
+        for (size_t j = 0; j < sizeof(concurrency) / sizeof(concurrency[0]); j++) {
+            char name[128];
+            ctx.max_concurrency = concurrency[j];
+            snprintf(name, sizeof(name), "qiniu_ng_bucket_uploader_upload_file_path/resumable/%zu", file_sizes[i]);
+            run_bench(name, concurrency[j], file_sizes[i], bench_bucket_uploader_upload_file_path, &ctx);
+        }
+        unlink(file_path);
+        free(file_path);
+    }
+
+    qiniu_ng_bucket_uploader_free(&bucket_uploader);
+    qiniu_ng_upload_manager_free(&upload_manager);
+    qiniu_ng_upload_token_free(&token);
+    qiniu_ng_config_free(&config);
+}
+
+int main(void) {
+    printf("{\n  \"version\": \"%s\",\n  \"features\": \"%s\",\n  \"hash_backend\": \"%s\",\n  \"results\": [",
+           qiniu_ng_version(), qiniu_ng_features(), qiniu_ng_hash_backend());
+    bench_etag();
+    bench_upload();
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,233 @@
+use crate::{string::qiniu_ng_char_t, utils::qiniu_ng_str_view_t};
+use libc::{c_void, size_t};
+use std::{
+    mem::{size_of, transmute},
+    ptr::{null, null_mut},
+};
+use tap::TapOps;
+
+const DEFAULT_CHUNK_SIZE: usize = 4096;
+
+/// @brief 内存池
+/// @details
+///     用于集中存放一次上传或查询过程中需要返回的各种字符串。
+///     写入内存池的字符串和字符串列表无需逐一释放，它们将在内存池被重置或释放时一并释放，并且大部分情况下仅需分配一次内存
+/// @note
+///   * 调用 `qiniu_ng_arena_new()` 函数创建 `qiniu_ng_arena_t` 实例。
+///   * 将内存池实例传给以 `_in_arena` 结尾的 API，或调用 `qiniu_ng_arena_alloc_str()` 将字符串视图复制到内存池中。
+///   * 当内存池中的字符串使用完毕后，可以调用 `qiniu_ng_arena_reset()` 方法重置内存池，以便在下一次上传或查询时复用已经分配的内存。
+///   * 当 `qiniu_ng_arena_t` 使用完毕后，请务必调用 `qiniu_ng_arena_free()` 方法释放内存。
+/// @note
+///   该结构体不可以跨线程使用
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct qiniu_ng_arena_t(*mut c_void);
+
+impl Default for qiniu_ng_arena_t {
+    #[inline]
+    fn default() -> Self {
+        Self(null_mut())
+    }
+}
+
+impl qiniu_ng_arena_t {
+    #[inline]
+    pub fn is_null(self) -> bool {
+        self.0.is_null()
+    }
+}
+
+impl From<qiniu_ng_arena_t> for Option<Box<Arena>> {
+    fn from(arena: qiniu_ng_arena_t) -> Self {
+        if arena.is_null() {
+            None
+        } else {
+            Some(unsafe { Box::from_raw(transmute(arena)) })
+        }
+    }
+}
+
+impl From<Option<Box<Arena>>> for qiniu_ng_arena_t {
+    fn from(arena: Option<Box<Arena>>) -> Self {
+        arena.map(|arena| arena.into()).unwrap_or_default()
+    }
+}
+
+impl From<Box<Arena>> for qiniu_ng_arena_t {
+    fn from(arena: Box<Arena>) -> Self {
+        unsafe { transmute(Box::into_raw(arena)) }
+    }
+}
+
+/// @brief 内存池中的字符串列表
+/// @details 由以 `_in_arena` 结尾的 API 返回，`items` 指向 `len` 个 C 字符串地址，字符串编码与 `qiniu_ng_str_get_ptr()` 一致
+/// @note 列表及其中的字符串在内存池被重置或释放前有效，无需单独释放
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct qiniu_ng_arena_str_list_t {
+    /// C 字符串地址数组
+    pub items: *const *const qiniu_ng_char_t,
+    /// 字符串数量
+    pub len: size_t,
+}
+
+impl Default for qiniu_ng_arena_str_list_t {
+    #[inline]
+    fn default() -> Self {
+        Self { items: null(), len: 0 }
+    }
+}
+
+/// 以块为单位分配内存的字符串内存池
+///
+/// 每个块在创建时即确定容量，此后只在容量范围内追加内容，因此已经返回的字符串地址在内存池被重置前始终有效
+pub(crate) struct Arena {
+    chunk_size: usize,
+    chunks: Vec<Vec<qiniu_ng_char_t>>,
+    lists: Vec<Box<[*const qiniu_ng_char_t]>>,
+}
+
+impl Arena {
+    fn new(chunk_size: usize) -> Self {
+        Arena {
+            chunk_size: if chunk_size > 0 { chunk_size } else { DEFAULT_CHUNK_SIZE },
+            chunks: Vec::new(),
+            lists: Vec::new(),
+        }
+    }
+
+    fn chunk_for(&mut self, len: usize) -> &mut Vec<qiniu_ng_char_t> {
+        let fits = self
+            .chunks
+            .last()
+            .map(|chunk| chunk.capacity() - chunk.len() >= len)
+            .unwrap_or(false);
+        if !fits {
+            self.chunks.push(Vec::with_capacity(self.chunk_size.max(len)));
+        }
+        self.chunks.last_mut().unwrap()
+    }
+
+    /// 将字符串复制到内存池中，返回以 `\0` 结尾的 C 字符串地址
+    pub(crate) fn alloc_str(&mut self, s: &str) -> *const qiniu_ng_char_t {
+        #[cfg(not(windows))]
+        let len = s.len() + 1;
+        #[cfg(windows)]
+        let len = s.encode_utf16().count() + 1;
+
+        let chunk = self.chunk_for(len);
+        let start = chunk.len();
+        #[cfg(not(windows))]
+        chunk.extend(s.bytes().map(|b| b as qiniu_ng_char_t));
+        #[cfg(windows)]
+        chunk.extend(s.encode_utf16());
+        chunk.push(0);
+        unsafe { chunk.as_ptr().add(start) }
+    }
+
+    /// 将字符串列表复制到内存池中，返回 C 字符串地址列表
+    pub(crate) fn alloc_str_list<'a>(&mut self, list: impl IntoIterator<Item = &'a str>) -> qiniu_ng_arena_str_list_t {
+        let items = list.into_iter().map(|s| self.alloc_str(s)).collect();
+        self.alloc_list(items)
+    }
+
+    /// 将已经写入内存池的 C 字符串地址组成列表存放在内存池中，列表中可以包含 `NULL`
+    pub(crate) fn alloc_list(&mut self, items: Box<[*const qiniu_ng_char_t]>) -> qiniu_ng_arena_str_list_t {
+        let list = qiniu_ng_arena_str_list_t {
+            items: items.as_ptr(),
+            len: items.len(),
+        };
+        self.lists.push(items);
+        list
+    }
+
+    /// 清空内存池，仅保留容量最大的一个块供之后复用
+    fn reset(&mut self) {
+        self.lists.clear();
+        let largest = self.chunks.drain(..).max_by_key(|chunk| chunk.capacity());
+        if let Some(mut chunk) = largest {
+            chunk.clear();
+            self.chunks.push(chunk);
+        }
+    }
+
+    fn allocated_size(&self) -> usize {
+        self.chunks
+            .iter()
+            .map(|chunk| chunk.capacity() * size_of::<qiniu_ng_char_t>())
+            .sum::<usize>()
+            + self
+                .lists
+                .iter()
+                .map(|list| list.len() * size_of::<*const qiniu_ng_char_t>())
+                .sum::<usize>()
+    }
+}
+
+/// @brief 创建内存池
+/// @param[in] chunk_size 内存池每次分配内存的最小尺寸，单位为字符数，如果传入 0 则使用默认值 4096
+/// @retval qiniu_ng_arena_t 返回创建的内存池实例
+/// @warning 务必在使用完毕后调用 `qiniu_ng_arena_free()` 方法释放 `qiniu_ng_arena_t`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_arena_new(chunk_size: size_t) -> qiniu_ng_arena_t {
+    Box::new(Arena::new(chunk_size)).into()
+}
+
+/// @brief 将字符串视图中的字符串复制到内存池中
+/// @param[in] arena 内存池实例
+/// @param[in] view 字符串视图
+/// @retval *qiniu_ng_char_t 返回复制得到的 C 字符串地址，如果字符串视图为 `NULL` 或其内容不是合法的 UTF-8 字符串，则返回 `NULL`
+/// @note 返回的 C 字符串编码与 `qiniu_ng_str_get_ptr()` 一致，在内存池被重置或释放前有效，无需单独释放
+#[no_mangle]
+pub extern "C" fn qiniu_ng_arena_alloc_str(
+    arena: qiniu_ng_arena_t,
+    view: qiniu_ng_str_view_t,
+) -> *const qiniu_ng_char_t {
+    let mut arena = Option::<Box<Arena>>::from(arena).unwrap();
+    unsafe { view.as_str() }
+        .map(|s| arena.alloc_str(s))
+        .unwrap_or_else(null)
+        .tap(|_| {
+            let _ = qiniu_ng_arena_t::from(arena);
+        })
+}
+
+/// @brief 获取内存池当前已经分配的内存尺寸
+/// @param[in] arena 内存池实例
+/// @retval size_t 已经分配的内存尺寸，单位为字节
+#[no_mangle]
+pub extern "C" fn qiniu_ng_arena_get_allocated_size(arena: qiniu_ng_arena_t) -> size_t {
+    let arena = Option::<Box<Arena>>::from(arena).unwrap();
+    arena.allocated_size().tap(|_| {
+        let _ = qiniu_ng_arena_t::from(arena);
+    })
+}
+
+/// @brief 重置内存池
+/// @details 此前写入内存池的所有字符串和字符串列表都将不再可用，内存池将保留部分已经分配的内存供之后复用
+/// @param[in] arena 内存池实例
+#[no_mangle]
+pub extern "C" fn qiniu_ng_arena_reset(arena: qiniu_ng_arena_t) {
+    let mut arena = Option::<Box<Arena>>::from(arena).unwrap();
+    arena.reset();
+    let _ = qiniu_ng_arena_t::from(arena);
+}
+
+/// @brief 释放内存池
+/// @details 此前写入内存池的所有字符串和字符串列表都将一并释放
+/// @param[in,out] arena 内存池实例地址，释放完毕后该内存池实例将不再可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_arena_free(arena: *mut qiniu_ng_arena_t) {
+    if let Some(arena) = unsafe { arena.as_mut() } {
+        let _ = Option::<Box<Arena>>::from(*arena);
+        *arena = qiniu_ng_arena_t::default();
+    }
+}
+
+/// @brief 判断内存池是否已经被释放
+/// @param[in] arena 内存池实例
+/// @retval bool 如果返回 `true` 则表示内存池已经被释放，该实例不再可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_arena_is_freed(arena: qiniu_ng_arena_t) -> bool {
+    arena.is_null()
+}
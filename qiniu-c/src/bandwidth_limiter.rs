@@ -0,0 +1,115 @@
+use libc::c_void;
+use qiniu_ng::http::BandwidthLimiter;
+use std::{mem::transmute, ptr::null_mut};
+
+/// @brief 带宽限制器
+/// @details
+///     基于令牌桶算法限制上传速率。同一个带宽限制器可以被多个存储空间上传器或多个批量上传任务共用，以限制它们的总上传速率。
+///     调用 `qiniu_ng_bandwidth_limiter_set_rate()` 调整速率将立即对正在进行的上传生效，无需重新开始上传
+/// @note
+///   * 调用 `qiniu_ng_bandwidth_limiter_new()` 函数创建 `qiniu_ng_bandwidth_limiter_t` 实例。
+///   * 当 `qiniu_ng_bandwidth_limiter_t` 使用完毕后，请务必调用 `qiniu_ng_bandwidth_limiter_free()` 方法释放内存。
+///   * 设置给存储空间上传器或批量上传任务的带宽限制器与该实例共享同一个令牌桶，释放该实例不会影响已经设置的带宽限制器
+/// @note
+///   该结构体可以跨线程使用
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct qiniu_ng_bandwidth_limiter_t(*mut c_void);
+
+impl Default for qiniu_ng_bandwidth_limiter_t {
+    #[inline]
+    fn default() -> Self {
+        Self(null_mut())
+    }
+}
+
+impl qiniu_ng_bandwidth_limiter_t {
+    #[inline]
+    pub fn is_null(self) -> bool {
+        self.0.is_null()
+    }
+
+    /// 获取带宽限制器的克隆，如果为空则返回 `None`
+    pub(crate) fn get_cloned(self) -> Option<BandwidthLimiter> {
+        let bandwidth_limiter = Option::<Box<BandwidthLimiter>>::from(self);
+        let cloned = bandwidth_limiter.as_ref().map(|limiter| limiter.as_ref().to_owned());
+        let _ = qiniu_ng_bandwidth_limiter_t::from(bandwidth_limiter);
+        cloned
+    }
+}
+
+impl From<qiniu_ng_bandwidth_limiter_t> for Option<Box<BandwidthLimiter>> {
+    fn from(bandwidth_limiter: qiniu_ng_bandwidth_limiter_t) -> Self {
+        if bandwidth_limiter.is_null() {
+            None
+        } else {
+            Some(unsafe { Box::from_raw(transmute(bandwidth_limiter)) })
+        }
+    }
+}
+
+impl From<Option<Box<BandwidthLimiter>>> for qiniu_ng_bandwidth_limiter_t {
+    fn from(bandwidth_limiter: Option<Box<BandwidthLimiter>>) -> Self {
+        bandwidth_limiter
+            .map(|bandwidth_limiter| bandwidth_limiter.into())
+            .unwrap_or_default()
+    }
+}
+
+impl From<Box<BandwidthLimiter>> for qiniu_ng_bandwidth_limiter_t {
+    fn from(bandwidth_limiter: Box<BandwidthLimiter>) -> Self {
+        unsafe { transmute(Box::into_raw(bandwidth_limiter)) }
+    }
+}
+
+/// @brief 创建带宽限制器
+/// @param[in] bytes_per_second 上传速率上限，单位为字节每秒，传入 `0` 表示不限制速率
+/// @retval qiniu_ng_bandwidth_limiter_t 获取创建的带宽限制器实例
+/// @warning 务必在使用完毕后调用 `qiniu_ng_bandwidth_limiter_free()` 方法释放 `qiniu_ng_bandwidth_limiter_t`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bandwidth_limiter_new(bytes_per_second: u64) -> qiniu_ng_bandwidth_limiter_t {
+    Box::new(BandwidthLimiter::new(bytes_per_second)).into()
+}
+
+/// @brief 获取上传速率上限
+/// @param[in] bandwidth_limiter 带宽限制器实例
+/// @retval uint64_t 上传速率上限，单位为字节每秒，`0` 表示不限制速率
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bandwidth_limiter_get_rate(bandwidth_limiter: qiniu_ng_bandwidth_limiter_t) -> u64 {
+    let bandwidth_limiter = Option::<Box<BandwidthLimiter>>::from(bandwidth_limiter).unwrap();
+    let rate = bandwidth_limiter.rate();
+    let _ = qiniu_ng_bandwidth_limiter_t::from(bandwidth_limiter);
+    rate
+}
+
+/// @brief 调整上传速率上限
+/// @details 正在进行的上传将按照新的速率继续，无需重新开始上传
+/// @param[in] bandwidth_limiter 带宽限制器实例
+/// @param[in] bytes_per_second 上传速率上限，单位为字节每秒，传入 `0` 表示不限制速率
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bandwidth_limiter_set_rate(
+    bandwidth_limiter: qiniu_ng_bandwidth_limiter_t,
+    bytes_per_second: u64,
+) {
+    let bandwidth_limiter = Option::<Box<BandwidthLimiter>>::from(bandwidth_limiter).unwrap();
+    bandwidth_limiter.set_rate(bytes_per_second);
+    let _ = qiniu_ng_bandwidth_limiter_t::from(bandwidth_limiter);
+}
+
+/// @brief 释放带宽限制器实例
+/// @param[in,out] bandwidth_limiter 带宽限制器实例地址，释放完毕后该实例将不再可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bandwidth_limiter_free(bandwidth_limiter: *mut qiniu_ng_bandwidth_limiter_t) {
+    if let Some(bandwidth_limiter) = unsafe { bandwidth_limiter.as_mut() } {
+        let _ = Option::<Box<BandwidthLimiter>>::from(*bandwidth_limiter);
+        *bandwidth_limiter = qiniu_ng_bandwidth_limiter_t::default();
+    }
+}
+
+/// @brief 判断带宽限制器实例是否已经被释放
+/// @param[in] bandwidth_limiter 带宽限制器实例
+/// @retval bool 如果返回 `true` 则表示带宽限制器实例已经被释放，该实例不再可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bandwidth_limiter_is_freed(bandwidth_limiter: qiniu_ng_bandwidth_limiter_t) -> bool {
+    bandwidth_limiter.is_null()
+}
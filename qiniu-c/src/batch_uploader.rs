@@ -1,5 +1,9 @@
 use crate::{
+    bandwidth_limiter::qiniu_ng_bandwidth_limiter_t,
+    bucket_batch::qiniu_ng_bucket_batch_t,
     bucket_uploader::qiniu_ng_bucket_uploader_t,
+    callback_queue::qiniu_ng_callback_queue_t,
+    cancellation_token::qiniu_ng_cancellation_token_t,
     config::qiniu_ng_config_t,
     result::qiniu_ng_err_t,
     string::{qiniu_ng_char_t, ucstr, UCString},
@@ -13,8 +17,12 @@ use crate::{
 };
 use libc::{c_void, size_t, FILE};
 use mime::Mime;
-use qiniu_ng::storage::uploader::{
-    BatchUploadJob, BatchUploadJobBuilder, BatchUploader, BucketUploader, UploadManager, UploadResult, UploadToken,
+use qiniu_ng::storage::{
+    batch::BatchOperations,
+    uploader::{
+        BatchUploadFairnessPolicy, BatchUploadJob, BatchUploadJobBuilder, BatchUploader, BucketUploader, EtagCache,
+        UploadManager, UploadResult, UploadToken,
+    },
 };
 use std::{
     collections::{hash_map::RandomState, HashMap},
@@ -123,6 +131,7 @@ pub extern "C" fn qiniu_ng_batch_uploader_new_from_config(
 
 /// @brief 释放批量上传器实例
 /// @param[in,out] bucket_uploader 批量上传器实例地址，释放完毕后该上传器实例将不再可用
+/// @note 如果已经调用过 `qiniu_ng_batch_uploader_spawn()`，释放前将等待已经推送的任务全部完成，并停止后台上传线程
 #[no_mangle]
 pub extern "C" fn qiniu_ng_batch_uploader_free(batch_uploader: *mut qiniu_ng_batch_uploader_t) {
     if let Some(batch_uploader) = unsafe { batch_uploader.as_mut() } {
@@ -154,7 +163,9 @@ pub extern "C" fn qiniu_ng_batch_uploader_set_expected_jobs_count(
 }
 
 /// @brief 设置批量上传器线程池数量
-/// @details 批量上传器总是优先使用存储空间上传器中的线程池，如果存储空间上传器中没有创建过线程池，则自行创建专用线程池
+/// @details
+///     调用 `qiniu_ng_batch_uploader_start()` 时，批量上传器总是优先使用存储空间上传器中的线程池，如果存储空间上传器中没有创建过线程池，则自行创建专用线程池。
+///     调用 `qiniu_ng_batch_uploader_spawn()` 时，则总是自行创建专用线程池
 /// @param[in] batch_uploader 批量上传器实例
 /// @param[in] thread_pool_size 上传线程池大小，如果传入 `0`，则使用默认的线程池策略
 #[no_mangle]
@@ -167,6 +178,24 @@ pub extern "C" fn qiniu_ng_batch_uploader_set_thread_pool_size(
     let _ = qiniu_ng_batch_uploader_t::from(batch_uploader);
 }
 
+/// @brief 设置批量上传器是否使用进程内共享的上传线程池
+/// @details
+///     默认情况下，如果存储空间上传器中没有线程池，每次调用 `qiniu_ng_batch_uploader_start()` 都将创建专用线程池。
+///     启用后，所有启用该选项的批量上传器将共用同一个线程池，除非调用 `qiniu_ng_batch_uploader_set_thread_pool_size()` 指定了线程池大小
+/// @param[in] batch_uploader 批量上传器实例
+/// @param[in] use_shared_thread_pool 是否使用共享上传线程池
+/// @note 在每次 Fork 新进程后，调用 `qiniu_ng_recreate_global_thread_pool()` 也将重建共享上传线程池
+/// @note 该选项仅对 `qiniu_ng_batch_uploader_start()` 有效，`qiniu_ng_batch_uploader_spawn()` 总是自行创建专用线程池
+#[no_mangle]
+pub extern "C" fn qiniu_ng_batch_uploader_use_shared_thread_pool(
+    batch_uploader: qiniu_ng_batch_uploader_t,
+    use_shared_thread_pool: bool,
+) {
+    let mut batch_uploader = Option::<Box<BatchUploader>>::from(batch_uploader).unwrap();
+    batch_uploader.use_shared_thread_pool(use_shared_thread_pool);
+    let _ = qiniu_ng_batch_uploader_t::from(batch_uploader);
+}
+
 /// @brief 设置上传文件最大并发度
 /// @details 默认情况下，上传文件时的最大并发度等于其使用的线程池大小。调用该方法可以修改最大并发度
 /// @param[in] batch_uploader 批量上传器实例
@@ -181,6 +210,136 @@ pub extern "C" fn qiniu_ng_batch_uploader_set_max_concurrency(
     let _ = qiniu_ng_batch_uploader_t::from(batch_uploader);
 }
 
+/// @brief 设置批量上传器所有正在上传的数据总量上限
+/// @details
+///     文件任务按照文件尺寸计算（至多计为一个分块尺寸），分块任务按照分块尺寸计算。
+///     即将执行的任务将令数据总量超出上限时，该任务将等待其他任务完成后再执行，但总是允许至少一个任务执行
+/// @param[in] batch_uploader 批量上传器实例
+/// @param[in] max_in_flight_bytes 正在上传的数据总量上限，单位为字节，如果传入 `0`，则表示不限制
+#[no_mangle]
+pub extern "C" fn qiniu_ng_batch_uploader_set_max_in_flight_bytes(
+    batch_uploader: qiniu_ng_batch_uploader_t,
+    max_in_flight_bytes: u64,
+) {
+    let mut batch_uploader = Option::<Box<BatchUploader>>::from(batch_uploader).unwrap();
+    batch_uploader.max_in_flight_bytes(max_in_flight_bytes);
+    let _ = qiniu_ng_batch_uploader_t::from(batch_uploader);
+}
+
+/// @brief 批量上传调度策略
+/// @details 决定批量上传器在文件任务与分片上传产生的分块任务之间如何分配线程
+#[repr(C)]
+#[derive(Copy, Clone, Debug, PartialEq, Eq)]
+#[allow(dead_code, non_camel_case_types)]
+pub enum qiniu_ng_batch_upload_fairness_policy_t {
+    /// @brief 小文件优先
+    /// @details
+    ///     总是优先执行数据量最小的任务，尺寸小于分块尺寸的文件将优先于正在上传的大文件的分块执行，
+    ///     以降低大文件上传期间小文件的上传延迟。默认采用该策略
+    qiniu_ng_batch_upload_fairness_small_first = 0,
+    /// @brief 轮流调度
+    /// @details 按照提交顺序执行文件任务，并在新的文件任务与每个正在分片上传的文件之间轮流分配线程
+    qiniu_ng_batch_upload_fairness_round_robin,
+}
+
+impl From<qiniu_ng_batch_upload_fairness_policy_t> for BatchUploadFairnessPolicy {
+    fn from(policy: qiniu_ng_batch_upload_fairness_policy_t) -> Self {
+        match policy {
+            qiniu_ng_batch_upload_fairness_policy_t::qiniu_ng_batch_upload_fairness_small_first => {
+                BatchUploadFairnessPolicy::SmallFirst
+            }
+            qiniu_ng_batch_upload_fairness_policy_t::qiniu_ng_batch_upload_fairness_round_robin => {
+                BatchUploadFairnessPolicy::RoundRobin
+            }
+        }
+    }
+}
+
+/// @brief 设置批量上传调度策略
+/// @param[in] batch_uploader 批量上传器实例
+/// @param[in] fairness_policy 批量上传调度策略，默认为 `qiniu_ng_batch_upload_fairness_small_first`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_batch_uploader_set_fairness_policy(
+    batch_uploader: qiniu_ng_batch_uploader_t,
+    fairness_policy: qiniu_ng_batch_upload_fairness_policy_t,
+) {
+    let mut batch_uploader = Option::<Box<BatchUploader>>::from(batch_uploader).unwrap();
+    batch_uploader.fairness_policy(fairness_policy.into());
+    let _ = qiniu_ng_batch_uploader_t::from(batch_uploader);
+}
+
+/// @brief 设置批量上传器在后台上传时，等待上传的任务数量上限
+/// @details
+///     等待上传的任务达到上限后，推送任务的函数将阻塞，直到有任务开始上传。
+///     仅对调用 `qiniu_ng_batch_uploader_spawn()` 之后推送的任务生效
+/// @param[in] batch_uploader 批量上传器实例
+/// @param[in] jobs_queue_capacity 等待上传的任务数量上限，默认为 `1024`，如果传入 `0`，则表示不限制
+#[no_mangle]
+pub extern "C" fn qiniu_ng_batch_uploader_set_jobs_queue_capacity(
+    batch_uploader: qiniu_ng_batch_uploader_t,
+    jobs_queue_capacity: size_t,
+) {
+    let mut batch_uploader = Option::<Box<BatchUploader>>::from(batch_uploader).unwrap();
+    batch_uploader.jobs_queue_capacity(jobs_queue_capacity);
+    let _ = qiniu_ng_batch_uploader_t::from(batch_uploader);
+}
+
+/// @brief 设置批量上传器跳过已经存在且内容一致的对象
+/// @details
+///     对于指定了对象名称的文件任务，批量上传器将在上传前批量获取这些对象的元信息，并在等待响应期间并行计算文件的 Etag。
+///     Etag 与已经存在的对象一致的文件将不再上传，而是直接调用 `on_completed` 回调函数，
+///     此时对传入的上传响应调用 `qiniu_ng_upload_response_is_skipped()` 将返回 `true`。
+///     数据流任务，以及没有指定对象名称的任务总是会被上传
+/// @param[in] batch_uploader 批量上传器实例
+/// @param[in] bucket_batch 上传目标存储空间的批量操作实例，其中已经添加的操作将被忽略，而批次大小，并发度和重试次数等参数将用于获取对象元信息
+/// @note 设置时，SDK 客户端会复制并存储输入的 `bucket_batch`，因此 `bucket_batch` 在使用完毕后即可调用 `qiniu_ng_bucket_batch_free()` 释放
+/// @warning `bucket_batch` 必须通过上传目标存储空间创建，否则程序将会崩溃
+#[no_mangle]
+pub extern "C" fn qiniu_ng_batch_uploader_skip_if_exists(
+    batch_uploader: qiniu_ng_batch_uploader_t,
+    bucket_batch: qiniu_ng_bucket_batch_t,
+) {
+    let mut batch_uploader = Option::<Box<BatchUploader>>::from(batch_uploader).unwrap();
+    let bucket_batch = Option::<Box<BatchOperations>>::from(bucket_batch).unwrap();
+    batch_uploader.skip_if_exists(bucket_batch.as_ref().to_owned());
+    let _ = qiniu_ng_bucket_batch_t::from(bucket_batch);
+    let _ = qiniu_ng_batch_uploader_t::from(batch_uploader);
+}
+
+/// @brief 设置跳过已经存在的对象时使用的本地 Etag 缓存文件
+/// @details
+///     文件路径，尺寸和修改时间均未改变的文件将直接使用缓存的 Etag，而无需再次读取文件。
+///     如果缓存文件不存在或内容无效，将使用空的缓存。
+///     缓存将在 `qiniu_ng_batch_uploader_start()` 返回前，调用 `qiniu_ng_batch_uploader_spawn()` 检查完已经推送的任务后，
+///     以及调用 `qiniu_ng_batch_uploader_shutdown()` 后写回该文件
+/// @param[in] batch_uploader 批量上传器实例
+/// @param[in] etag_cache_path 本地 Etag 缓存文件路径
+/// @param[out] err 用于返回读取缓存文件时发生的错误，如果传入 `NULL` 表示不获取 `err`。但如果发生错误，返回值将依然是 `false`
+/// @retval bool 是否设置成功，如果返回 `false`，则表示可以读取 `err` 获得错误信息
+/// @note 设置时，SDK 客户端会复制并存储传入的 `etag_cache_path`，因此 `etag_cache_path` 在使用完毕后即可释放
+#[no_mangle]
+pub extern "C" fn qiniu_ng_batch_uploader_set_etag_cache_path(
+    batch_uploader: qiniu_ng_batch_uploader_t,
+    etag_cache_path: *const qiniu_ng_char_t,
+    err: *mut qiniu_ng_err_t,
+) -> bool {
+    let mut batch_uploader = Option::<Box<BatchUploader>>::from(batch_uploader).unwrap();
+    let result = match EtagCache::load(unsafe { UCString::from_ptr(etag_cache_path) }.into_path_buf()) {
+        Ok(etag_cache) => {
+            batch_uploader.etag_cache(etag_cache);
+            true
+        }
+        Err(ref e) => {
+            if let Some(err) = unsafe { err.as_mut() } {
+                *err = e.into();
+            }
+            false
+        }
+    };
+    let _ = qiniu_ng_batch_uploader_t::from(batch_uploader);
+    result
+}
+
 /// @brief 推送上传指定路径的文件的任务
 /// @param[in] batch_uploader 批量上传器实例
 /// @param[in] file_path 文件路径
@@ -240,6 +399,7 @@ pub extern "C" fn qiniu_ng_batch_uploader_upload_reader(
 ///     需要注意的是，该方法会持续阻塞直到上传任务全部执行完毕（不保证执行顺序）。
 ///     该方法不返回任何结果，上传结果由每个上传任务内定义的 `on_completed` 回调函数负责返回。
 ///     方法返回后，当前批量上传器的上传任务将被清空，但其他参数都将保留，可以重新添加任务并复用。
+///     如果已经调用过 `qiniu_ng_batch_uploader_spawn()`，该函数等同于 `qiniu_ng_batch_uploader_drain()`。
 /// @param[in] batch_uploader 批量上传器实例
 #[no_mangle]
 pub extern "C" fn qiniu_ng_batch_uploader_start(batch_uploader: qiniu_ng_batch_uploader_t) {
@@ -248,6 +408,45 @@ pub extern "C" fn qiniu_ng_batch_uploader_start(batch_uploader: qiniu_ng_batch_u
     let _ = qiniu_ng_batch_uploader_t::from(batch_uploader);
 }
 
+/// @brief 在后台启动上传线程
+/// @details
+///     该函数将立即返回。已经推送的任务和之后推送的任务都将在后台上传，上传结果由每个上传任务内定义的 `on_completed` 回调函数负责返回。
+///     可以调用 `qiniu_ng_batch_uploader_drain()` 等待已经推送的任务全部完成，或调用 `qiniu_ng_batch_uploader_shutdown()` 停止上传线程。
+///     上传线程将一直占用线程池，直到调用 `qiniu_ng_batch_uploader_shutdown()` 或 `qiniu_ng_batch_uploader_free()` 为止，
+///     因此该函数总是为上传线程创建专用线程池，不会占用存储空间上传器中的线程池或共享上传线程池。
+///     启动后修改的批量上传器参数，需要在调用 `qiniu_ng_batch_uploader_shutdown()` 后重新启动才能生效。
+///     如果已经启动，则该函数不做任何事情。
+/// @param[in] batch_uploader 批量上传器实例
+/// @warning 后台上传期间，推送任务的函数依然不能被多个线程并发调用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_batch_uploader_spawn(batch_uploader: qiniu_ng_batch_uploader_t) {
+    let mut batch_uploader = Option::<Box<BatchUploader>>::from(batch_uploader).unwrap();
+    batch_uploader.spawn();
+    let _ = qiniu_ng_batch_uploader_t::from(batch_uploader);
+}
+
+/// @brief 等待已经推送的任务全部完成
+/// @details 仅在调用 `qiniu_ng_batch_uploader_spawn()` 后有效。该函数返回后，后台上传线程依然保持运行，可以继续推送任务
+/// @param[in] batch_uploader 批量上传器实例
+/// @warning 请勿在上传任务的回调函数中调用该函数，否则将导致死锁
+#[no_mangle]
+pub extern "C" fn qiniu_ng_batch_uploader_drain(batch_uploader: qiniu_ng_batch_uploader_t) {
+    let mut batch_uploader = Option::<Box<BatchUploader>>::from(batch_uploader).unwrap();
+    batch_uploader.drain();
+    let _ = qiniu_ng_batch_uploader_t::from(batch_uploader);
+}
+
+/// @brief 等待已经推送的任务全部完成，然后停止后台上传线程
+/// @details 该函数返回后，批量上传器将回到调用 `qiniu_ng_batch_uploader_spawn()` 前的状态，可以修改参数后重新启动
+/// @param[in] batch_uploader 批量上传器实例
+/// @warning 请勿在上传任务的回调函数中调用该函数，否则将导致死锁
+#[no_mangle]
+pub extern "C" fn qiniu_ng_batch_uploader_shutdown(batch_uploader: qiniu_ng_batch_uploader_t) {
+    let mut batch_uploader = Option::<Box<BatchUploader>>::from(batch_uploader).unwrap();
+    batch_uploader.shutdown();
+    let _ = qiniu_ng_batch_uploader_t::from(batch_uploader);
+}
+
 fn qiniu_ng_batch_uploader_upload(
     batch_uploader: qiniu_ng_batch_uploader_t,
     upload_target: UploadTarget,
@@ -326,6 +525,15 @@ fn set_params_to_job_builder(
     } else {
         job_builder.enable_checksum()
     };
+    if params.local_etag_enabled {
+        job_builder = job_builder.enable_local_etag();
+    }
+    if let Some(bandwidth_limiter) = params.bandwidth_limiter.get_cloned() {
+        job_builder = job_builder.bandwidth_limiter(bandwidth_limiter);
+    }
+    if let Some(cancellation_token) = params.cancellation_token.get_cloned() {
+        job_builder = job_builder.cancellation_token(cancellation_token);
+    }
     match params.resumable_policy {
         qiniu_ng_resumable_policy_t::qiniu_ng_resumable_policy_threshold => {
             job_builder = job_builder.upload_threshold(params.upload_threshold);
@@ -338,6 +546,20 @@ fn set_params_to_job_builder(
         }
         qiniu_ng_resumable_policy_t::qiniu_ng_resumable_policy_default => {}
     }
+    if let Some(callback_queue) = params.callback_queue.get_cloned() {
+        let callback_data = params.callback_data as usize;
+        // 只有设置了 `on_uploading_progress` 的任务才推送上传进度事件，该函数本身不会被调用
+        if params.on_uploading_progress.is_some() {
+            let callback_queue = callback_queue.to_owned();
+            job_builder = job_builder.on_progress(move |uploaded: u64, total: Option<u64>| {
+                callback_queue.push_uploading_progress(callback_data as *mut c_void, uploaded, total.unwrap_or(0))
+            });
+        }
+        job_builder = job_builder.on_completed(move |result: UploadResult| {
+            callback_queue.push_completed(callback_data as *mut c_void, result)
+        });
+        return job_builder;
+    }
     if let Some(on_uploading_progress) = params.on_uploading_progress {
         let callback_data = unsafe { params.callback_data.as_ref() }.map(|data| &*data);
         job_builder = job_builder.on_progress(move |uploaded: u64, total: Option<u64>| {
@@ -399,6 +621,7 @@ pub struct qiniu_ng_batch_upload_params_t {
     ///     用于接受上传完成后的结果。
     ///     其中第一个参数为上传成功结果，第二个参数为上传失败时的错误。
     ///     应该首先判断上传是否出错，如果没有出错再处理上传成功的情况。
+    ///     如果对象因为已经存在且内容一致而被跳过上传，`qiniu_ng_upload_response_is_skipped()` 将返回 `true`。
     ///     第二个参数总是传入本结构体的 `callback_data` 字段，您可以根据您的需要为 `callback_data` 字段设置上下文数据。
     ///     该函数无需返回任何值
     /// @warning
@@ -410,7 +633,8 @@ pub struct qiniu_ng_batch_upload_params_t {
     /// @brief 回调函数使用的上下文指针
     /// @details
     ///     提供给 `on_uploading_progress` 和 `on_completed` 的 `data` 参数，作为上下文数据使用。
-    ///     由于回调函数可能被多个线程并发调用，因此需要保证该字段数据的线程安全性
+    ///     由于回调函数可能被多个线程并发调用，因此需要保证该字段数据的线程安全性。
+    ///     设置了 `callback_queue` 时，该字段也将作为回调队列中事件所属任务的标识
     pub callback_data: *mut c_void,
     /// @brief 指定上传所用的上传凭证
     /// @details
@@ -419,6 +643,30 @@ pub struct qiniu_ng_batch_upload_params_t {
     pub upload_token: *const qiniu_ng_upload_token_t,
     /// @brief 当且仅当 `resumable_policy` 为 `qiniu_ng_resumable_policy_threshold` 才生效，表示设置的上传策略阙值
     pub upload_threshold: u32,
+    /// @brief 是否在读取上传数据的同时计算本地 Etag
+    /// @details 计算结果可以通过 `qiniu_ng_upload_response_get_local_etag()` 获取，无需再调用 `qiniu_ng_etag_from_file_path()` 预先计算
+    /// @note 分片上传时，如果分块尺寸不是 4 MB 的整数倍且未启用分块自适应调节，或断点续传时已经上传的分块未与 4 MB 的 Etag 块对齐，将不会计算本地 Etag
+    pub local_etag_enabled: bool,
+    /// @brief 为上传任务指定带宽限制器
+    /// @details
+    ///     如果不指定，将使用存储空间上传器的带宽限制器。多个任务可以共用同一个带宽限制器以限制它们的总上传速率，
+    ///     上传期间调用 `qiniu_ng_bandwidth_limiter_set_rate()` 调整速率将立即生效
+    pub bandwidth_limiter: qiniu_ng_bandwidth_limiter_t,
+    /// @brief 为上传任务指定取消令牌
+    /// @details
+    ///     如果不指定，将使用存储空间上传器的取消令牌。取消令牌被取消后，尚未开始的任务将不再上传，正在进行的任务将尽快中止，
+    ///     两者均以用户取消错误调用 `on_completed` 回调函数
+    pub cancellation_token: qiniu_ng_cancellation_token_t,
+    /// @brief 为上传任务指定回调队列
+    /// @details
+    ///     如果指定，`on_uploading_progress` 和 `on_completed` 将不会被调用，上传进度和上传结果将以 `callback_data` 作为标识推入回调队列，
+    ///     由调用 `qiniu_ng_callback_queue_pop()` 的线程取出处理。
+    ///     只有设置了 `on_uploading_progress` 的任务才会推送上传进度事件，上传结果事件则总是推送。
+    ///     多个任务可以共用同一个回调队列，此时应该为每个任务设置不同的 `callback_data`
+    /// @warning
+    ///     尚未取出的上传进度事件按照 `callback_data` 合并，共用同一个回调队列且 `callback_data` 相同（包括均为 `NULL`）的任务，
+    ///     它们的上传进度事件将被互相合并，只保留最新的一个
+    pub callback_queue: qiniu_ng_callback_queue_t,
 }
 
 unsafe impl Sync for qiniu_ng_batch_upload_params_t {}
@@ -1,11 +1,12 @@
 use crate::{
+    arena::{qiniu_ng_arena_str_list_t, qiniu_ng_arena_t, Arena},
     client::qiniu_ng_client_t,
     region::{qiniu_ng_region_id_t, qiniu_ng_region_t, qiniu_ng_regions_t},
     result::qiniu_ng_err_t,
     string::{qiniu_ng_char_t, ucstr},
-    utils::{qiniu_ng_str_list_t, qiniu_ng_str_t},
+    utils::{qiniu_ng_str_list_t, qiniu_ng_str_t, qiniu_ng_str_view_t},
 };
-use libc::c_void;
+use libc::{c_void, size_t};
 use qiniu_ng::{
     storage::{
         bucket::{Bucket, BucketBuilder},
@@ -301,6 +302,41 @@ pub extern "C" fn qiniu_ng_bucket_new(
     })
 }
 
+/// @brief 批量预取多个存储空间的区域信息
+/// @details
+///     并发查询所有尚未缓存区域信息的存储空间，查询结果将随域名管理器持久化，之后创建这些存储空间实例后无需再等待区域查询。
+///     适合在服务启动时，或在 Fork 工作进程前调用。
+///     即使部分存储空间查询失败，其他存储空间的查询依然会继续进行
+/// @param[in] client 七牛 SDK 客户端实例
+/// @param[in] bucket_names 存储空间名称列表
+/// @param[in] bucket_names_size 存储空间名称列表长度
+/// @param[out] error 用于返回错误，如果传入 `NULL` 表示不获取 `error`。但如果运行发生错误，返回值将依然是 `false`
+/// @retval bool 是否运行正常，如果返回 `true`，则表示所有存储空间都查询成功，如果返回 `false`，则表示可以读取 `error` 获得第一个遇到的错误
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_prefetch(
+    client: qiniu_ng_client_t,
+    bucket_names: *const *const qiniu_ng_char_t,
+    bucket_names_size: size_t,
+    error: *mut qiniu_ng_err_t,
+) -> bool {
+    let client = Option::<Box<Client>>::from(client).unwrap();
+    let bucket_names = (0..bucket_names_size)
+        .map(|i| unsafe { ucstr::from_ptr(*bucket_names.add(i)) }.to_string().unwrap())
+        .collect::<Vec<_>>();
+    let bucket_names = bucket_names.iter().map(|name| name.as_str()).collect::<Vec<_>>();
+    match client.storage().prefetch_buckets(&bucket_names).tap(|_| {
+        let _ = qiniu_ng_client_t::from(client);
+    }) {
+        Ok(_) => true,
+        Err(ref err) => {
+            if let Some(error) = unsafe { error.as_mut() } {
+                *error = err.into();
+            }
+            false
+        }
+    }
+}
+
 /// @brief 释放存储空间实例
 /// @param[in,out] bucket 存储空间实例地址，释放完毕后该存储空间实例将不再可用
 #[no_mangle]
@@ -331,6 +367,18 @@ pub extern "C" fn qiniu_ng_bucket_get_name(bucket: qiniu_ng_bucket_t) -> qiniu_n
     })
 }
 
+/// @brief 获取存储空间名称的字符串视图
+/// @param[in] bucket 存储空间实例
+/// @retval qiniu_ng_str_view_t 返回存储空间名称的字符串视图
+/// @note 返回的字符串视图无需释放，但仅在存储空间实例被释放前有效
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_get_name_view(bucket: qiniu_ng_bucket_t) -> qiniu_ng_str_view_t {
+    let bucket = Option::<Box<Bucket>>::from(bucket).unwrap();
+    qiniu_ng_str_view_t::from_str(bucket.name()).tap(|_| {
+        let _ = qiniu_ng_bucket_t::from(bucket);
+    })
+}
+
 /// @brief 获取存储空间区域
 /// @param[in] bucket 存储空间实例
 /// @param[out] region 用于返回区域的内存地址，如果传入 `NULL` 表示不获取 `region`。但如果运行正常，返回值将依然是 `true`
@@ -429,3 +477,81 @@ pub extern "C" fn qiniu_ng_bucket_get_domains(
         }
     }
 }
+
+/// @brief 获取存储空间下载域名列表的字符串视图
+/// @param[in] bucket 存储空间实例
+/// @param[out] views 提供视图数组用于返回下载域名，至多写入 `capacity` 个视图。如果传入 `NULL` 表示不获取 `views`。但如果运行正常，返回值将依然是 `true`
+/// @param[in] capacity 视图数组 `views` 的容量
+/// @param[out] len 用于返回下载域名的实际数量，如果该数量大于 `capacity`，可以提供更大的视图数组重新调用。如果传入 `NULL` 表示不获取 `len`
+/// @param[out] error 用于返回错误，如果传入 `NULL` 表示不获取 `error`。但如果运行发生错误，返回值将依然是 `false`
+/// @retval bool 是否运行正常，如果返回 `true`，则表示可以读取 `views` 获得结果，如果返回 `false`，则表示可以读取 `error` 获得错误信息
+/// @note 下载域名列表在首次获取后即被缓存在存储空间实例中，因此返回的字符串视图无需释放，但仅在存储空间实例被释放前有效
+/// @warning 对于获取的 `error`，一旦使用完毕，应该调用 `qiniu_ng_err_free()` 方法释放内存
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_get_domains_view(
+    bucket: qiniu_ng_bucket_t,
+    views: *mut qiniu_ng_str_view_t,
+    capacity: size_t,
+    len: *mut size_t,
+    error: *mut qiniu_ng_err_t,
+) -> bool {
+    let bucket = Option::<Box<Bucket>>::from(bucket).unwrap();
+    match bucket
+        .domains()
+        .map(|domains| unsafe { qiniu_ng_str_view_t::fill_from_str_slice(&domains, views, capacity) })
+        .tap(|_| {
+            let _ = qiniu_ng_bucket_t::from(bucket);
+        }) {
+        Ok(l) => {
+            if let Some(len) = unsafe { len.as_mut() } {
+                *len = l;
+            }
+            true
+        }
+        Err(ref err) => {
+            if let Some(error) = unsafe { error.as_mut() } {
+                *error = err.into();
+            }
+            false
+        }
+    }
+}
+
+/// @brief 获取存储空间下载域名列表，并将其存放在内存池中
+/// @param[in] bucket 存储空间实例
+/// @param[in] arena 内存池实例
+/// @param[out] domains 用于返回下载域名列表的内存地址。如果传入 `NULL` 表示不获取 `domains`。但如果运行正常，返回值将依然是 `true`
+/// @param[out] error 用于返回错误，如果传入 `NULL` 表示不获取 `error`。但如果运行发生错误，返回值将依然是 `false`
+/// @retval bool 是否运行正常，如果返回 `true`，则表示可以读取 `domains` 获得结果，如果返回 `false`，则表示可以读取 `error` 获得错误信息
+/// @note 返回的 `domains` 无需单独释放，将在内存池被重置或释放时一并释放
+/// @warning 对于获取的 `error`，一旦使用完毕，应该调用 `qiniu_ng_err_free()` 方法释放内存
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_get_domains_in_arena(
+    bucket: qiniu_ng_bucket_t,
+    arena: qiniu_ng_arena_t,
+    domains: *mut qiniu_ng_arena_str_list_t,
+    error: *mut qiniu_ng_err_t,
+) -> bool {
+    let bucket = Option::<Box<Bucket>>::from(bucket).unwrap();
+    let mut arena = Option::<Box<Arena>>::from(arena).unwrap();
+    match bucket
+        .domains()
+        .map(|domains| arena.alloc_str_list(domains.iter().copied()))
+        .tap(|_| {
+            let _ = qiniu_ng_arena_t::from(arena);
+            let _ = qiniu_ng_bucket_t::from(bucket);
+        }) {
+        Ok(ds) => {
+            if let Some(domains) = unsafe { domains.as_mut() } {
+                *domains = ds;
+            }
+            true
+        }
+        Err(ref err) => {
+            if let Some(error) = unsafe { error.as_mut() } {
+                *error = err.into();
+            }
+            false
+        }
+    }
+}
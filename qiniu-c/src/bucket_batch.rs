@@ -0,0 +1,328 @@
+use crate::{
+    arena::{qiniu_ng_arena_str_list_t, qiniu_ng_arena_t, Arena},
+    bucket::qiniu_ng_bucket_t,
+    result::qiniu_ng_err_t,
+    string::{qiniu_ng_char_t, ucstr},
+    utils::qiniu_ng_str_view_t,
+};
+use libc::{c_void, size_t};
+use qiniu_ng::storage::{
+    batch::{BatchOperations, ObjectStat},
+    bucket::Bucket,
+};
+use std::{
+    mem::transmute,
+    ptr::{null, null_mut},
+};
+use tap::TapOps;
+
+/// @brief 存储空间批量操作
+/// @details 用于批量获取对象元信息，删除，复制或移动对象
+/// @note
+///   * 调用 `qiniu_ng_bucket_batch_new()` 函数创建 `qiniu_ng_bucket_batch_t` 实例。
+///   * 调用 `qiniu_ng_bucket_batch_stat()`，`qiniu_ng_bucket_batch_delete()` 等方法添加任意数量的对象操作。
+///   * 调用 `qiniu_ng_bucket_batch_execute()` 执行所有已经添加的操作，所有操作将按照 `batch_max_operation_size` 切分为多个批次并行发送。
+///     执行后已经添加的操作将被清空，可以继续添加新的操作再次执行。
+///   * 当 `qiniu_ng_bucket_batch_t` 使用完毕后，请务必调用 `qiniu_ng_bucket_batch_free()` 方法释放内存。
+/// @note
+///   该结构体不可以跨线程使用
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct qiniu_ng_bucket_batch_t(*mut c_void);
+
+impl Default for qiniu_ng_bucket_batch_t {
+    #[inline]
+    fn default() -> Self {
+        Self(null_mut())
+    }
+}
+
+impl qiniu_ng_bucket_batch_t {
+    #[inline]
+    pub fn is_null(self) -> bool {
+        self.0.is_null()
+    }
+}
+
+impl From<qiniu_ng_bucket_batch_t> for Option<Box<BatchOperations>> {
+    fn from(batch: qiniu_ng_bucket_batch_t) -> Self {
+        if batch.is_null() {
+            None
+        } else {
+            Some(unsafe { Box::from_raw(transmute(batch)) })
+        }
+    }
+}
+
+impl From<Option<Box<BatchOperations>>> for qiniu_ng_bucket_batch_t {
+    fn from(batch: Option<Box<BatchOperations>>) -> Self {
+        batch.map(|batch| batch.into()).unwrap_or_default()
+    }
+}
+
+impl From<Box<BatchOperations>> for qiniu_ng_bucket_batch_t {
+    fn from(batch: Box<BatchOperations>) -> Self {
+        unsafe { transmute(Box::into_raw(batch)) }
+    }
+}
+
+/// @brief 对象元信息
+/// @note 其中的字符串视图仅在回调函数返回前有效
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct qiniu_ng_object_stat_t {
+    /// 对象尺寸，单位为字节
+    pub size: u64,
+    /// 对象上传时间，单位为 100 纳秒
+    pub put_time: u64,
+    /// 对象存储类型，`0` 表示标准存储，`1` 表示低频存储，`2` 表示归档存储
+    pub file_type: u8,
+    /// 对象 Etag
+    pub hash: qiniu_ng_str_view_t,
+    /// 对象 MIME 类型
+    pub mime_type: qiniu_ng_str_view_t,
+}
+
+impl From<&ObjectStat> for qiniu_ng_object_stat_t {
+    fn from(stat: &ObjectStat) -> Self {
+        Self {
+            size: stat.size(),
+            put_time: stat.put_time(),
+            file_type: stat.file_type(),
+            hash: qiniu_ng_str_view_t::from_str(stat.hash()),
+            mime_type: qiniu_ng_str_view_t::from_str(stat.mime_type()),
+        }
+    }
+}
+
+/// @brief 创建存储空间批量操作实例
+/// @param[in] bucket 存储空间实例
+/// @retval qiniu_ng_bucket_batch_t 获取创建的批量操作实例
+/// @note 如果区域在存储空间生成前未指定，则该方法可能会连接七牛服务器查询当前存储空间所在区域，以确定 RS 服务器 URL 列表
+/// @note 创建实例时，SDK 客户端会复制所需的存储空间信息，因此 `bucket` 在调用完毕后即可释放
+/// @warning 务必在使用完毕后调用 `qiniu_ng_bucket_batch_free()` 方法释放 `qiniu_ng_bucket_batch_t`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_new(bucket: qiniu_ng_bucket_t) -> qiniu_ng_bucket_batch_t {
+    let bucket = Option::<Box<Bucket>>::from(bucket).unwrap();
+    qiniu_ng_bucket_batch_t::from(Box::new(bucket.batch())).tap(|_| {
+        let _ = qiniu_ng_bucket_t::from(bucket);
+    })
+}
+
+/// @brief 添加获取对象元信息操作
+/// @param[in] batch 批量操作实例
+/// @param[in] key 对象名称
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_stat(batch: qiniu_ng_bucket_batch_t, key: *const qiniu_ng_char_t) {
+    let mut batch = Option::<Box<BatchOperations>>::from(batch).unwrap();
+    batch.stat(unsafe { ucstr::from_ptr(key) }.to_string().unwrap());
+    let _ = qiniu_ng_bucket_batch_t::from(batch);
+}
+
+/// @brief 添加删除对象操作
+/// @param[in] batch 批量操作实例
+/// @param[in] key 对象名称
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_delete(batch: qiniu_ng_bucket_batch_t, key: *const qiniu_ng_char_t) {
+    let mut batch = Option::<Box<BatchOperations>>::from(batch).unwrap();
+    batch.delete(unsafe { ucstr::from_ptr(key) }.to_string().unwrap());
+    let _ = qiniu_ng_bucket_batch_t::from(batch);
+}
+
+/// @brief 添加复制对象操作
+/// @param[in] batch 批量操作实例
+/// @param[in] key 源对象名称
+/// @param[in] to_bucket 目标存储空间名称
+/// @param[in] to_key 目标对象名称
+/// @param[in] force 是否覆盖已经存在的目标对象
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_copy(
+    batch: qiniu_ng_bucket_batch_t,
+    key: *const qiniu_ng_char_t,
+    to_bucket: *const qiniu_ng_char_t,
+    to_key: *const qiniu_ng_char_t,
+    force: bool,
+) {
+    let mut batch = Option::<Box<BatchOperations>>::from(batch).unwrap();
+    batch.copy(
+        unsafe { ucstr::from_ptr(key) }.to_string().unwrap(),
+        unsafe { ucstr::from_ptr(to_bucket) }.to_string().unwrap(),
+        unsafe { ucstr::from_ptr(to_key) }.to_string().unwrap(),
+        force,
+    );
+    let _ = qiniu_ng_bucket_batch_t::from(batch);
+}
+
+/// @brief 添加移动对象操作
+/// @param[in] batch 批量操作实例
+/// @param[in] key 源对象名称
+/// @param[in] to_bucket 目标存储空间名称
+/// @param[in] to_key 目标对象名称
+/// @param[in] force 是否覆盖已经存在的目标对象
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_move(
+    batch: qiniu_ng_bucket_batch_t,
+    key: *const qiniu_ng_char_t,
+    to_bucket: *const qiniu_ng_char_t,
+    to_key: *const qiniu_ng_char_t,
+    force: bool,
+) {
+    let mut batch = Option::<Box<BatchOperations>>::from(batch).unwrap();
+    batch.move_to(
+        unsafe { ucstr::from_ptr(key) }.to_string().unwrap(),
+        unsafe { ucstr::from_ptr(to_bucket) }.to_string().unwrap(),
+        unsafe { ucstr::from_ptr(to_key) }.to_string().unwrap(),
+        force,
+    );
+    let _ = qiniu_ng_bucket_batch_t::from(batch);
+}
+
+/// @brief 设置每个批次的最大操作数
+/// @param[in] batch 批量操作实例
+/// @param[in] batch_size 每个批次的最大操作数，默认为客户端配置中的 `batch_max_operation_size`，且总是不会超过该值
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_set_batch_size(batch: qiniu_ng_bucket_batch_t, batch_size: size_t) {
+    let mut batch = Option::<Box<BatchOperations>>::from(batch).unwrap();
+    batch.batch_size(batch_size);
+    let _ = qiniu_ng_bucket_batch_t::from(batch);
+}
+
+/// @brief 设置同时发送的最大批次数
+/// @param[in] batch 批量操作实例
+/// @param[in] concurrency 同时发送的最大批次数，默认为 4
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_set_concurrency(batch: qiniu_ng_bucket_batch_t, concurrency: size_t) {
+    let mut batch = Option::<Box<BatchOperations>>::from(batch).unwrap();
+    batch.concurrency(concurrency);
+    let _ = qiniu_ng_bucket_batch_t::from(batch);
+}
+
+/// @brief 为批量操作创建专用线程池指定线程池大小
+/// @details 默认情况下，所有批量操作共用进程内共享的批量操作线程池，不会在每次执行时创建新的线程。
+///     指定线程池大小后，将在第一次执行时创建专用线程池，之后该批量操作实例每次执行都将复用该线程池
+/// @param[in] batch 批量操作实例
+/// @param[in] thread_pool_size 专用线程池大小，传入 `0` 表示使用共享的批量操作线程池
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_set_thread_pool_size(batch: qiniu_ng_bucket_batch_t, thread_pool_size: size_t) {
+    let mut batch = Option::<Box<BatchOperations>>::from(batch).unwrap();
+    batch.thread_pool_size(thread_pool_size);
+    let _ = qiniu_ng_bucket_batch_t::from(batch);
+}
+
+/// @brief 设置失败操作的最大重试次数
+/// @param[in] batch 批量操作实例
+/// @param[in] max_retries 失败操作的最大重试次数，默认为 3
+/// @note 仅当批量操作请求可以安全重试，或是操作被服务器以 5xx 状态码拒绝时才会重试，已经成功的操作不会被再次发送
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_set_max_retries(batch: qiniu_ng_bucket_batch_t, max_retries: size_t) {
+    let mut batch = Option::<Box<BatchOperations>>::from(batch).unwrap();
+    batch.max_retries(max_retries);
+    let _ = qiniu_ng_bucket_batch_t::from(batch);
+}
+
+/// @brief 获取已经添加的操作数
+/// @param[in] batch 批量操作实例
+/// @retval size_t 已经添加但尚未执行的操作数
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_len(batch: qiniu_ng_bucket_batch_t) -> size_t {
+    let batch = Option::<Box<BatchOperations>>::from(batch).unwrap();
+    batch.len().tap(|_| {
+        let _ = qiniu_ng_bucket_batch_t::from(batch);
+    })
+}
+
+/// @brief 执行所有已经添加的操作
+/// @details
+///     所有操作将被切分为多个批次，由多个线程并行发送，每个操作完成后都会立即在调用该方法的线程中回调 `callback`。
+///     回调的顺序为操作完成的顺序，而非添加的顺序。
+///     回调函数的第一个参数为操作的序号，从 0 开始，与操作的添加顺序一致。
+///     第二个参数为对象元信息，仅当获取对象元信息的操作成功时不为 `NULL`，其中的字符串视图仅在回调函数返回前有效。
+///     第三个参数为操作失败时的错误，对于被七牛服务器拒绝的操作，错误为 HTTP 状态码错误。
+///     第四个参数总是传入 `data`。
+///     回调函数返回 `false` 表示放弃尚未发送的批次并立即返回
+/// @param[in] batch 批量操作实例
+/// @param[in] callback 操作完成后的回调函数
+/// @param[in] data 回调函数使用的上下文指针
+/// @retval size_t 已经回调的操作数
+/// @warning 对于获取的 `err`，一旦使用完毕，应该调用 `qiniu_ng_err_ignore()` 等方法释放内存
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_execute(
+    batch: qiniu_ng_bucket_batch_t,
+    callback: extern "C" fn(
+        index: size_t,
+        stat: *const qiniu_ng_object_stat_t,
+        err: qiniu_ng_err_t,
+        data: *mut c_void,
+    ) -> bool,
+    data: *mut c_void,
+) -> size_t {
+    let mut batch = Option::<Box<BatchOperations>>::from(batch).unwrap();
+    let mut completed = 0;
+    for result in batch.execute() {
+        completed += 1;
+        let go_on = match result.result() {
+            Ok(stat) => {
+                let stat = stat.as_ref().map(qiniu_ng_object_stat_t::from);
+                (callback)(
+                    result.index(),
+                    stat.as_ref().map(|stat| stat as *const _).unwrap_or_else(null),
+                    qiniu_ng_err_t::default(),
+                    data,
+                )
+            }
+            Err(err) => (callback)(result.index(), null(), err.into(), data),
+        };
+        if !go_on {
+            break;
+        }
+    }
+    let _ = qiniu_ng_bucket_batch_t::from(batch);
+    completed
+}
+
+/// @brief 执行所有已经添加的操作，并将操作结果存放在内存池中
+/// @details
+///     与 `qiniu_ng_bucket_batch_execute()` 一样切分批次并行发送，但不回调，而是在所有操作完成后一次性返回结果列表。
+///     列表长度为执行的操作数，第 `i` 个元素对应第 `i` 个添加的操作：
+///     获取对象元信息的操作成功时为对象 Etag，其他操作成功时为空字符串，操作失败时为 `NULL`。
+///     如果需要获取失败的原因，请使用 `qiniu_ng_bucket_batch_execute()`
+/// @param[in] batch 批量操作实例
+/// @param[in] arena 内存池实例
+/// @retval qiniu_ng_arena_str_list_t 返回操作结果列表
+/// @note 返回的列表无需单独释放，将在内存池被重置或释放时一并释放
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_execute_in_arena(
+    batch: qiniu_ng_bucket_batch_t,
+    arena: qiniu_ng_arena_t,
+) -> qiniu_ng_arena_str_list_t {
+    let mut batch = Option::<Box<BatchOperations>>::from(batch).unwrap();
+    let mut arena = Option::<Box<Arena>>::from(arena).unwrap();
+    let mut items = vec![null(); batch.len()].into_boxed_slice();
+    for result in batch.execute() {
+        if let (Ok(stat), Some(item)) = (result.result(), items.get_mut(result.index())) {
+            *item = arena.alloc_str(stat.as_ref().map(|stat| stat.hash()).unwrap_or_default());
+        }
+    }
+    arena.alloc_list(items).tap(|_| {
+        let _ = qiniu_ng_arena_t::from(arena);
+        let _ = qiniu_ng_bucket_batch_t::from(batch);
+    })
+}
+
+/// @brief 释放存储空间批量操作实例
+/// @param[in,out] batch 存储空间批量操作实例地址，释放完毕后该实例将不再可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_free(batch: *mut qiniu_ng_bucket_batch_t) {
+    if let Some(batch) = unsafe { batch.as_mut() } {
+        let _ = Option::<Box<BatchOperations>>::from(*batch);
+        *batch = qiniu_ng_bucket_batch_t::default();
+    }
+}
+
+/// @brief 判断存储空间批量操作实例是否已经被释放
+/// @param[in] batch 存储空间批量操作实例
+/// @retval bool 如果返回 `true` 则表示存储空间批量操作实例已经被释放，该实例不再可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_batch_is_freed(batch: qiniu_ng_bucket_batch_t) -> bool {
+    batch.is_null()
+}
@@ -1,12 +1,14 @@
 use crate::{
+    bandwidth_limiter::qiniu_ng_bandwidth_limiter_t,
     bucket::qiniu_ng_bucket_t,
+    cancellation_token::qiniu_ng_cancellation_token_t,
     string::{qiniu_ng_char_t, ucstr},
     upload_manager::qiniu_ng_upload_manager_t,
 };
 use libc::{c_void, size_t};
 use qiniu_ng::storage::{
     bucket::Bucket,
-    uploader::{BucketUploader, UploadManager},
+    uploader::{BucketUploader, BucketUploaderBuilder, UploadManager},
 };
 use std::{mem::transmute, ptr::null_mut};
 use tap::TapOps;
@@ -73,35 +75,99 @@ pub extern "C" fn qiniu_ng_bucket_uploader_new_from_bucket(
     upload_manager: qiniu_ng_upload_manager_t,
     bucket: qiniu_ng_bucket_t,
     thread_pool_size: size_t,
+) -> qiniu_ng_bucket_uploader_t {
+    qiniu_ng_bucket_uploader_new_from_bucket_with_params(
+        upload_manager,
+        bucket,
+        &qiniu_ng_bucket_uploader_params_t {
+            thread_pool_size,
+            ..Default::default()
+        },
+    )
+}
+
+/// @brief 创建存储空间上传器实例
+/// @param[in] upload_manager 上传管理器实例
+/// @param[in] bucket_name 存储空间名称
+/// @param[in] access_key 七牛 Access Key
+/// @param[in] thread_pool_size 上传线程池大小，如果传入 `0`，则使用默认的线程池策略
+/// @retval qiniu_ng_bucket_uploader_t 获取创建的存储空间上传器实例
+/// @warning 务必在使用完毕后调用 `qiniu_ng_bucket_uploader_free()` 方法释放 `qiniu_ng_bucket_uploader_t`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_uploader_new_from_bucket_name(
+    upload_manager: qiniu_ng_upload_manager_t,
+    bucket_name: *const qiniu_ng_char_t,
+    access_key: *const qiniu_ng_char_t,
+    thread_pool_size: size_t,
+) -> qiniu_ng_bucket_uploader_t {
+    qiniu_ng_bucket_uploader_new_from_bucket_name_with_params(
+        upload_manager,
+        bucket_name,
+        access_key,
+        &qiniu_ng_bucket_uploader_params_t {
+            thread_pool_size,
+            ..Default::default()
+        },
+    )
+}
+
+/// @brief 存储空间上传器参数
+/// @details 该结构是个简单的开放结构体，用于为存储空间上传器提供可选参数
+#[repr(C)]
+#[derive(Copy, Clone, Default)]
+pub struct qiniu_ng_bucket_uploader_params_t {
+    /// @brief 上传线程池大小，如果传入 `0`，则使用默认的线程池策略
+    pub thread_pool_size: size_t,
+    /// @brief 为存储空间上传器的所有上传指定带宽限制器
+    /// @details
+    ///     带宽限制器可以被多个存储空间上传器共用，以限制它们的总上传速率，
+    ///     上传期间调用 `qiniu_ng_bandwidth_limiter_set_rate()` 调整速率将立即生效
+    pub bandwidth_limiter: qiniu_ng_bandwidth_limiter_t,
+    /// @brief 为存储空间上传器的所有上传指定取消令牌
+    /// @details 取消令牌被取消后，所有正在进行的上传都将尽快中止，并返回用户取消错误，之后的上传也将不再进行
+    pub cancellation_token: qiniu_ng_cancellation_token_t,
+}
+
+/// @brief 使用指定参数创建存储空间上传器实例
+/// @param[in] upload_manager 上传管理器实例
+/// @param[in] bucket 存储空间实例
+/// @param[in] params 存储空间上传器参数，如果为 `NULL`，则使用默认参数
+/// @retval qiniu_ng_bucket_uploader_t 获取创建的存储空间上传器实例
+/// @warning 务必在使用完毕后调用 `qiniu_ng_bucket_uploader_free()` 方法释放 `qiniu_ng_bucket_uploader_t`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_uploader_new_from_bucket_with_params(
+    upload_manager: qiniu_ng_upload_manager_t,
+    bucket: qiniu_ng_bucket_t,
+    params: *const qiniu_ng_bucket_uploader_params_t,
 ) -> qiniu_ng_bucket_uploader_t {
     let upload_manager = Option::<Box<UploadManager>>::from(upload_manager).unwrap();
     let bucket = Option::<Box<Bucket>>::from(bucket).unwrap();
-    let mut bucket_uploader_builder = upload_manager.for_bucket(&bucket).tap(|_| {
+    let bucket_uploader_builder = upload_manager.for_bucket(&bucket).tap(|_| {
         let _ = qiniu_ng_bucket_t::from(bucket);
         let _ = qiniu_ng_upload_manager_t::from(upload_manager);
     });
-    if thread_pool_size > 0 {
-        bucket_uploader_builder = bucket_uploader_builder.thread_pool_size(thread_pool_size);
-    }
-    bucket_uploader_builder.build().into()
+    build_bucket_uploader(
+        bucket_uploader_builder,
+        &unsafe { params.as_ref() }.cloned().unwrap_or_default(),
+    )
 }
 
-/// @brief 创建存储空间上传器实例
+/// @brief 使用指定参数创建存储空间上传器实例
 /// @param[in] upload_manager 上传管理器实例
 /// @param[in] bucket_name 存储空间名称
 /// @param[in] access_key 七牛 Access Key
-/// @param[in] thread_pool_size 上传线程池大小，如果传入 `0`，则使用默认的线程池策略
+/// @param[in] params 存储空间上传器参数，如果为 `NULL`，则使用默认参数
 /// @retval qiniu_ng_bucket_uploader_t 获取创建的存储空间上传器实例
 /// @warning 务必在使用完毕后调用 `qiniu_ng_bucket_uploader_free()` 方法释放 `qiniu_ng_bucket_uploader_t`
 #[no_mangle]
-pub extern "C" fn qiniu_ng_bucket_uploader_new_from_bucket_name(
+pub extern "C" fn qiniu_ng_bucket_uploader_new_from_bucket_name_with_params(
     upload_manager: qiniu_ng_upload_manager_t,
     bucket_name: *const qiniu_ng_char_t,
     access_key: *const qiniu_ng_char_t,
-    thread_pool_size: size_t,
+    params: *const qiniu_ng_bucket_uploader_params_t,
 ) -> qiniu_ng_bucket_uploader_t {
     let upload_manager = Option::<Box<UploadManager>>::from(upload_manager).unwrap();
-    let mut bucket_uploader_builder = upload_manager
+    let bucket_uploader_builder = upload_manager
         .for_bucket_name(
             unsafe { ucstr::from_ptr(bucket_name) }.to_string().unwrap(),
             unsafe { ucstr::from_ptr(access_key) }.to_string().unwrap(),
@@ -109,8 +175,24 @@ pub extern "C" fn qiniu_ng_bucket_uploader_new_from_bucket_name(
         .tap(|_| {
             let _ = qiniu_ng_upload_manager_t::from(upload_manager);
         });
-    if thread_pool_size > 0 {
-        bucket_uploader_builder = bucket_uploader_builder.thread_pool_size(thread_pool_size);
+    build_bucket_uploader(
+        bucket_uploader_builder,
+        &unsafe { params.as_ref() }.cloned().unwrap_or_default(),
+    )
+}
+
+fn build_bucket_uploader(
+    mut bucket_uploader_builder: BucketUploaderBuilder,
+    params: &qiniu_ng_bucket_uploader_params_t,
+) -> qiniu_ng_bucket_uploader_t {
+    if params.thread_pool_size > 0 {
+        bucket_uploader_builder = bucket_uploader_builder.thread_pool_size(params.thread_pool_size);
+    }
+    if let Some(bandwidth_limiter) = params.bandwidth_limiter.get_cloned() {
+        bucket_uploader_builder = bucket_uploader_builder.bandwidth_limiter(bandwidth_limiter);
+    }
+    if let Some(cancellation_token) = params.cancellation_token.get_cloned() {
+        bucket_uploader_builder = bucket_uploader_builder.cancellation_token(cancellation_token);
     }
     bucket_uploader_builder.build().into()
 }
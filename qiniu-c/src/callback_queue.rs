@@ -0,0 +1,306 @@
+use crate::{result::qiniu_ng_err_t, upload_response::qiniu_ng_upload_response_t};
+use libc::{c_void, size_t};
+use qiniu_ng::storage::uploader::UploadResult;
+use std::{
+    collections::{HashMap, VecDeque},
+    mem::transmute,
+    ptr::null_mut,
+    slice,
+    sync::{Arc, Condvar, Mutex},
+    time::Duration,
+};
+
+/// @brief 回调队列
+/// @details
+///     为批量上传任务设置回调队列后，上传进度和上传结果将不再通过回调函数在上传线程中通知，而是作为事件推入回调队列
+///     （为单个文件的上传设置回调队列时仅推入上传进度事件），
+///     由您自己的线程调用 `qiniu_ng_callback_queue_pop()` 批量取出处理。
+///     适用于回调函数只能在特定线程中执行的场景，例如需要持有全局解释器锁的脚本语言绑定。
+///     同一个任务尚未取出的上传进度事件将被合并为最新的一个，因此无论上传多少数据块，取出事件的次数都只与取出的频率有关。
+///     任务由 `callback_data` 区分，`callback_data` 相同（包括均为 `NULL`）的任务的上传进度事件也将被互相合并
+/// @note
+///   * 调用 `qiniu_ng_callback_queue_new()` 函数创建 `qiniu_ng_callback_queue_t` 实例。
+///   * 当 `qiniu_ng_callback_queue_t` 使用完毕后，请务必调用 `qiniu_ng_callback_queue_free()` 方法释放内存。
+///   * 设置给批量上传任务的回调队列与该实例共享事件，释放该实例不会影响已经设置的回调队列
+/// @note
+///   该结构体可以跨线程使用
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct qiniu_ng_callback_queue_t(*mut c_void);
+
+impl Default for qiniu_ng_callback_queue_t {
+    #[inline]
+    fn default() -> Self {
+        Self(null_mut())
+    }
+}
+
+impl qiniu_ng_callback_queue_t {
+    #[inline]
+    pub fn is_null(self) -> bool {
+        self.0.is_null()
+    }
+
+    /// 获取回调队列的克隆，如果为空则返回 `None`
+    pub(crate) fn get_cloned(self) -> Option<Arc<CallbackQueue>> {
+        let callback_queue = Option::<Box<Arc<CallbackQueue>>>::from(self);
+        let cloned = callback_queue.as_ref().map(|queue| queue.as_ref().to_owned());
+        let _ = qiniu_ng_callback_queue_t::from(callback_queue);
+        cloned
+    }
+}
+
+impl From<qiniu_ng_callback_queue_t> for Option<Box<Arc<CallbackQueue>>> {
+    fn from(callback_queue: qiniu_ng_callback_queue_t) -> Self {
+        if callback_queue.is_null() {
+            None
+        } else {
+            Some(unsafe { Box::from_raw(transmute(callback_queue)) })
+        }
+    }
+}
+
+impl From<Option<Box<Arc<CallbackQueue>>>> for qiniu_ng_callback_queue_t {
+    fn from(callback_queue: Option<Box<Arc<CallbackQueue>>>) -> Self {
+        callback_queue
+            .map(|callback_queue| callback_queue.into())
+            .unwrap_or_default()
+    }
+}
+
+impl From<Box<Arc<CallbackQueue>>> for qiniu_ng_callback_queue_t {
+    fn from(callback_queue: Box<Arc<CallbackQueue>>) -> Self {
+        unsafe { transmute(Box::into_raw(callback_queue)) }
+    }
+}
+
+/// @brief 回调事件类型
+#[repr(C)]
+#[derive(Copy, Clone, Debug, PartialEq, Eq)]
+#[allow(dead_code, non_camel_case_types)]
+pub enum qiniu_ng_callback_event_kind_t {
+    /// @brief 上传进度事件，`uploaded` 和 `total` 字段有效
+    qiniu_ng_callback_event_uploading_progress = 0,
+    /// @brief 上传完成事件，`response` 和 `err` 字段有效
+    qiniu_ng_callback_event_completed,
+}
+
+/// @brief 回调事件
+/// @details 该结构是个简单的开放结构体，由 `qiniu_ng_callback_queue_pop()` 填充
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct qiniu_ng_callback_event_t {
+    /// @brief 事件类型
+    pub kind: qiniu_ng_callback_event_kind_t,
+    /// @brief 产生事件的上传任务的 `callback_data` 字段，用于区分事件所属的上传任务
+    pub callback_data: *mut c_void,
+    /// @brief 已经上传的数据量，单位为字节
+    pub uploaded: u64,
+    /// @brief 需要上传的数据总量，单位为字节。如果无法预期需要上传的数据总量，则总是为 0
+    pub total: u64,
+    /// @brief 上传成功结果
+    /// @warning 一旦使用完毕，应该调用 `qiniu_ng_upload_response_free()` 释放内存
+    pub response: qiniu_ng_upload_response_t,
+    /// @brief 上传失败时的错误
+    /// @warning 应该首先判断上传是否出错，如果出错，应该调用相应的错误判断函数释放内存
+    pub err: qiniu_ng_err_t,
+}
+
+enum Event {
+    UploadingProgress { data: usize, uploaded: u64, total: u64 },
+    Completed { data: usize, result: UploadResult },
+}
+
+#[derive(Default)]
+struct Events {
+    events: VecDeque<Event>,
+    /// 已经取出的事件总数，与 `events` 中的下标相加即为事件序号
+    popped: usize,
+    /// 尚未取出的上传进度事件的序号，用于合并同一个任务的上传进度
+    pending_progresses: HashMap<usize, usize>,
+    closed: bool,
+}
+
+#[derive(Default)]
+pub struct CallbackQueue {
+    events: Mutex<Events>,
+    condvar: Condvar,
+}
+
+impl CallbackQueue {
+    pub(crate) fn push_uploading_progress(&self, data: *mut c_void, uploaded: u64, total: u64) {
+        let data = data as usize;
+        let mut events = self.events.lock().unwrap();
+        if let Some(&seq) = events.pending_progresses.get(&data) {
+            let index = seq - events.popped;
+            if let Some(Event::UploadingProgress {
+                uploaded: pending_uploaded,
+                total: pending_total,
+                ..
+            }) = events.events.get_mut(index)
+            {
+                *pending_uploaded = uploaded;
+                *pending_total = total;
+            }
+            return;
+        }
+        let seq = events.popped + events.events.len();
+        events.pending_progresses.insert(data, seq);
+        events
+            .events
+            .push_back(Event::UploadingProgress { data, uploaded, total });
+        drop(events);
+        self.condvar.notify_one();
+    }
+
+    pub(crate) fn push_completed(&self, data: *mut c_void, result: UploadResult) {
+        let data = data as usize;
+        let mut events = self.events.lock().unwrap();
+        events.pending_progresses.remove(&data);
+        events.events.push_back(Event::Completed { data, result });
+        drop(events);
+        self.condvar.notify_one();
+    }
+
+    fn pop(&self, output: &mut [qiniu_ng_callback_event_t], timeout: Option<Duration>) -> usize {
+        let mut events = self.events.lock().unwrap();
+        while events.events.is_empty() && !events.closed {
+            events = match timeout {
+                Some(timeout) => {
+                    let (events, result) = self.condvar.wait_timeout(events, timeout).unwrap();
+                    if result.timed_out() {
+                        return 0;
+                    }
+                    events
+                }
+                None => self.condvar.wait(events).unwrap(),
+            };
+        }
+        let count = output.len().min(events.events.len());
+        for output in output.iter_mut().take(count) {
+            let seq = events.popped;
+            events.popped += 1;
+            *output = match events.events.pop_front().unwrap() {
+                Event::UploadingProgress { data, uploaded, total } => {
+                    if events.pending_progresses.get(&data) == Some(&seq) {
+                        events.pending_progresses.remove(&data);
+                    }
+                    qiniu_ng_callback_event_t {
+                        kind: qiniu_ng_callback_event_kind_t::qiniu_ng_callback_event_uploading_progress,
+                        callback_data: data as *mut c_void,
+                        uploaded,
+                        total,
+                        response: Default::default(),
+                        err: Default::default(),
+                    }
+                }
+                Event::Completed { data, result } => {
+                    let (response, err) = match result {
+                        Ok(response) => (Box::new(response).into(), Default::default()),
+                        Err(ref err) => (Default::default(), err.into()),
+                    };
+                    qiniu_ng_callback_event_t {
+                        kind: qiniu_ng_callback_event_kind_t::qiniu_ng_callback_event_completed,
+                        callback_data: data as *mut c_void,
+                        uploaded: 0,
+                        total: 0,
+                        response,
+                        err,
+                    }
+                }
+            };
+        }
+        count
+    }
+
+    fn close(&self) {
+        self.events.lock().unwrap().closed = true;
+        self.condvar.notify_all();
+    }
+
+    fn is_finished(&self) -> bool {
+        let events = self.events.lock().unwrap();
+        events.closed && events.events.is_empty()
+    }
+}
+
+/// @brief 创建回调队列
+/// @retval qiniu_ng_callback_queue_t 获取创建的回调队列实例
+/// @warning 务必在使用完毕后调用 `qiniu_ng_callback_queue_free()` 方法释放 `qiniu_ng_callback_queue_t`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_callback_queue_new() -> qiniu_ng_callback_queue_t {
+    Box::new(Arc::new(CallbackQueue::default())).into()
+}
+
+/// @brief 从回调队列中批量取出事件
+/// @details 如果回调队列中没有事件，将阻塞直到有新的事件推入，回调队列被关闭，或等待超时
+/// @param[in] callback_queue 回调队列实例
+/// @param[out] events 用于返回事件的数组
+/// @param[in] events_size 事件数组的长度，至多取出该数量的事件
+/// @param[in] timeout_ms 等待超时时长，单位为毫秒，如果传入 `0`，则表示一直等待
+/// @retval size_t 取出的事件数量。如果返回 `0`，则表示等待超时或回调队列已经关闭，可以调用 `qiniu_ng_callback_queue_is_finished()` 判断
+/// @note 同一个任务的事件总是按照产生的顺序取出，上传完成事件总是该任务的最后一个事件
+/// @warning 对于取出的上传完成事件，务必释放其中的 `response` 和 `err`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_callback_queue_pop(
+    callback_queue: qiniu_ng_callback_queue_t,
+    events: *mut qiniu_ng_callback_event_t,
+    events_size: size_t,
+    timeout_ms: u64,
+) -> size_t {
+    let callback_queue = Option::<Box<Arc<CallbackQueue>>>::from(callback_queue).unwrap();
+    let output: &mut [qiniu_ng_callback_event_t] = if events.is_null() || events_size == 0 {
+        &mut []
+    } else {
+        unsafe { slice::from_raw_parts_mut(events, events_size) }
+    };
+    let timeout = if timeout_ms > 0 {
+        Some(Duration::from_millis(timeout_ms))
+    } else {
+        None
+    };
+    let count = callback_queue.pop(output, timeout);
+    let _ = qiniu_ng_callback_queue_t::from(callback_queue);
+    count
+}
+
+/// @brief 关闭回调队列
+/// @details 关闭后，正在等待事件的 `qiniu_ng_callback_queue_pop()` 将立即返回，已经推入的事件依然可以继续取出
+/// @param[in] callback_queue 回调队列实例
+/// @note 通常在 `qiniu_ng_batch_uploader_start()` 返回后调用，此时所有任务的事件都已经推入回调队列
+#[no_mangle]
+pub extern "C" fn qiniu_ng_callback_queue_close(callback_queue: qiniu_ng_callback_queue_t) {
+    let callback_queue = Option::<Box<Arc<CallbackQueue>>>::from(callback_queue).unwrap();
+    callback_queue.close();
+    let _ = qiniu_ng_callback_queue_t::from(callback_queue);
+}
+
+/// @brief 判断回调队列是否已经关闭且所有事件都已经被取出
+/// @param[in] callback_queue 回调队列实例
+/// @retval bool 如果返回 `true` 则表示不会再有事件可以取出
+#[no_mangle]
+pub extern "C" fn qiniu_ng_callback_queue_is_finished(callback_queue: qiniu_ng_callback_queue_t) -> bool {
+    let callback_queue = Option::<Box<Arc<CallbackQueue>>>::from(callback_queue).unwrap();
+    let finished = callback_queue.is_finished();
+    let _ = qiniu_ng_callback_queue_t::from(callback_queue);
+    finished
+}
+
+/// @brief 释放回调队列实例
+/// @param[in,out] callback_queue 回调队列实例地址，释放完毕后该实例将不再可用
+/// @note 尚未取出的事件将在回调队列不再被任何上传任务使用后一并释放
+#[no_mangle]
+pub extern "C" fn qiniu_ng_callback_queue_free(callback_queue: *mut qiniu_ng_callback_queue_t) {
+    if let Some(callback_queue) = unsafe { callback_queue.as_mut() } {
+        let _ = Option::<Box<Arc<CallbackQueue>>>::from(*callback_queue);
+        *callback_queue = qiniu_ng_callback_queue_t::default();
+    }
+}
+
+/// @brief 判断回调队列实例是否已经被释放
+/// @param[in] callback_queue 回调队列实例
+/// @retval bool 如果返回 `true` 则表示回调队列实例已经被释放，该实例不再可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_callback_queue_is_freed(callback_queue: qiniu_ng_callback_queue_t) -> bool {
+    callback_queue.is_null()
+}
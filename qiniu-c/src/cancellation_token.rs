@@ -0,0 +1,127 @@
+use libc::c_void;
+use qiniu_ng::http::CancellationToken;
+use std::{mem::transmute, ptr::null_mut};
+
+/// @brief 取消令牌
+/// @details
+///     用于在上传进行期间中止上传。同一个取消令牌可以被多个存储空间上传器或多个批量上传任务共用，
+///     在任意线程调用 `qiniu_ng_cancellation_token_cancel()` 都将中止所有使用该令牌的上传，被中止的上传将返回用户取消错误
+/// @note
+///   * 调用 `qiniu_ng_cancellation_token_new()` 或 `qiniu_ng_cancellation_token_new_child()` 函数创建 `qiniu_ng_cancellation_token_t` 实例。
+///   * 当 `qiniu_ng_cancellation_token_t` 使用完毕后，请务必调用 `qiniu_ng_cancellation_token_free()` 方法释放内存。
+///   * 设置给存储空间上传器或批量上传任务的取消令牌与该实例共享取消状态，释放该实例不会影响已经设置的取消令牌
+/// @note
+///   该结构体可以跨线程使用
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct qiniu_ng_cancellation_token_t(*mut c_void);
+
+impl Default for qiniu_ng_cancellation_token_t {
+    #[inline]
+    fn default() -> Self {
+        Self(null_mut())
+    }
+}
+
+impl qiniu_ng_cancellation_token_t {
+    #[inline]
+    pub fn is_null(self) -> bool {
+        self.0.is_null()
+    }
+
+    /// 获取取消令牌的克隆，如果为空则返回 `None`
+    pub(crate) fn get_cloned(self) -> Option<CancellationToken> {
+        let cancellation_token = Option::<Box<CancellationToken>>::from(self);
+        let cloned = cancellation_token.as_ref().map(|token| token.as_ref().to_owned());
+        let _ = qiniu_ng_cancellation_token_t::from(cancellation_token);
+        cloned
+    }
+}
+
+impl From<qiniu_ng_cancellation_token_t> for Option<Box<CancellationToken>> {
+    fn from(cancellation_token: qiniu_ng_cancellation_token_t) -> Self {
+        if cancellation_token.is_null() {
+            None
+        } else {
+            Some(unsafe { Box::from_raw(transmute(cancellation_token)) })
+        }
+    }
+}
+
+impl From<Option<Box<CancellationToken>>> for qiniu_ng_cancellation_token_t {
+    fn from(cancellation_token: Option<Box<CancellationToken>>) -> Self {
+        cancellation_token
+            .map(|cancellation_token| cancellation_token.into())
+            .unwrap_or_default()
+    }
+}
+
+impl From<Box<CancellationToken>> for qiniu_ng_cancellation_token_t {
+    fn from(cancellation_token: Box<CancellationToken>) -> Self {
+        unsafe { transmute(Box::into_raw(cancellation_token)) }
+    }
+}
+
+/// @brief 创建取消令牌
+/// @retval qiniu_ng_cancellation_token_t 获取创建的取消令牌实例
+/// @warning 务必在使用完毕后调用 `qiniu_ng_cancellation_token_free()` 方法释放 `qiniu_ng_cancellation_token_t`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_cancellation_token_new() -> qiniu_ng_cancellation_token_t {
+    Box::new(CancellationToken::new()).into()
+}
+
+/// @brief 创建子令牌
+/// @details 父令牌被取消时，子令牌将一并被取消，而取消子令牌则不会影响父令牌
+/// @param[in] cancellation_token 父令牌实例
+/// @retval qiniu_ng_cancellation_token_t 获取创建的子令牌实例
+/// @warning 务必在使用完毕后调用 `qiniu_ng_cancellation_token_free()` 方法释放 `qiniu_ng_cancellation_token_t`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_cancellation_token_new_child(
+    cancellation_token: qiniu_ng_cancellation_token_t,
+) -> qiniu_ng_cancellation_token_t {
+    let cancellation_token = Option::<Box<CancellationToken>>::from(cancellation_token).unwrap();
+    let child_token = cancellation_token.child_token();
+    let _ = qiniu_ng_cancellation_token_t::from(cancellation_token);
+    Box::new(child_token).into()
+}
+
+/// @brief 取消
+/// @details 所有使用该令牌的上传都将尽快中止，并返回用户取消错误，之后使用该令牌的上传也将不再进行。取消不可撤销
+/// @param[in] cancellation_token 取消令牌实例
+/// @note 被中止的上传返回的错误可以调用 `qiniu_ng_err_user_canceled_error_extract()` 判定
+#[no_mangle]
+pub extern "C" fn qiniu_ng_cancellation_token_cancel(cancellation_token: qiniu_ng_cancellation_token_t) {
+    let cancellation_token = Option::<Box<CancellationToken>>::from(cancellation_token).unwrap();
+    cancellation_token.cancel();
+    let _ = qiniu_ng_cancellation_token_t::from(cancellation_token);
+}
+
+/// @brief 判断取消令牌是否已经被取消
+/// @param[in] cancellation_token 取消令牌实例
+/// @retval bool 如果返回 `true` 则表示取消令牌或其父令牌已经被取消
+#[no_mangle]
+pub extern "C" fn qiniu_ng_cancellation_token_is_canceled(cancellation_token: qiniu_ng_cancellation_token_t) -> bool {
+    let cancellation_token = Option::<Box<CancellationToken>>::from(cancellation_token).unwrap();
+    let canceled = cancellation_token.is_canceled();
+    let _ = qiniu_ng_cancellation_token_t::from(cancellation_token);
+    canceled
+}
+
+/// @brief 释放取消令牌实例
+/// @param[in,out] cancellation_token 取消令牌实例地址，释放完毕后该实例将不再可用
+/// @note 释放实例并不会取消令牌，已经设置给上传器或上传任务的取消令牌依然有效
+#[no_mangle]
+pub extern "C" fn qiniu_ng_cancellation_token_free(cancellation_token: *mut qiniu_ng_cancellation_token_t) {
+    if let Some(cancellation_token) = unsafe { cancellation_token.as_mut() } {
+        let _ = Option::<Box<CancellationToken>>::from(*cancellation_token);
+        *cancellation_token = qiniu_ng_cancellation_token_t::default();
+    }
+}
+
+/// @brief 判断取消令牌实例是否已经被释放
+/// @param[in] cancellation_token 取消令牌实例
+/// @retval bool 如果返回 `true` 则表示取消令牌实例已经被释放，该实例不再可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_cancellation_token_is_freed(cancellation_token: qiniu_ng_cancellation_token_t) -> bool {
+    cancellation_token.is_null()
+}
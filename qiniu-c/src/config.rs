@@ -2,7 +2,7 @@ use crate::{
     http::{qiniu_ng_http_request_t, qiniu_ng_http_response_t},
     result::{qiniu_ng_err_ignore, qiniu_ng_err_t, qiniu_ng_retry_kind_t},
     string::{qiniu_ng_char_t, ucstr, UCString},
-    utils::{convert_optional_c_string_to_optional_path_buf, qiniu_ng_str_t},
+    utils::{convert_optional_c_string_to_optional_path_buf, qiniu_ng_str_list_t, qiniu_ng_str_t},
 };
 use libc::{c_void, size_t};
 use qiniu_http::{
@@ -11,13 +11,21 @@ use qiniu_http::{
 };
 use qiniu_ng::{
     config::{Config, ConfigBuilder},
-    http::{DomainsManagerBuilder, HTTPAfterAction, HTTPBeforeAction},
+    http::{DomainsManagerBuilder, HTTPAfterAction, HTTPBeforeAction, Resolver},
     storage::{
         recorder::FileSystemRecorder,
         uploader::{UploadLoggerBuilder, UploadLoggerFileLockPolicy, UploadRecorderBuilder},
     },
 };
-use std::{fs::OpenOptions, mem::transmute, ptr::null_mut, time::Duration};
+use qiniu_with_libcurl::{CurlClientBuilder, CurlMultiEngineBuilder};
+use std::{
+    fs::OpenOptions,
+    io::{Error as IOError, ErrorKind as IOErrorKind, Result as IOResult},
+    mem::transmute,
+    net::{IpAddr, SocketAddr},
+    ptr::null_mut,
+    time::Duration,
+};
 use tap::TapOps;
 
 /// @brief 七牛客户端配置生成器
@@ -37,6 +45,7 @@ struct Builder {
     upload_logger_builder: Option<UploadLoggerBuilder>,
     upload_recorder_builder: UploadRecorderBuilder,
     domains_manager_builder: DomainsManagerBuilder,
+    curl_client_builder: Option<CurlClientBuilder>,
 }
 
 impl Default for Builder {
@@ -46,10 +55,17 @@ impl Default for Builder {
             upload_logger_builder: Some(Default::default()),
             upload_recorder_builder: Default::default(),
             domains_manager_builder: Default::default(),
+            curl_client_builder: None,
         }
     }
 }
 
+impl Builder {
+    fn set_curl_client_option(&mut self, f: impl FnOnce(CurlClientBuilder) -> CurlClientBuilder) {
+        self.curl_client_builder = Some(f(self.curl_client_builder.take().unwrap_or_default()));
+    }
+}
+
 impl Default for qiniu_ng_config_builder_t {
     #[inline]
     fn default() -> Self {
@@ -280,6 +296,23 @@ pub extern "C" fn qiniu_ng_config_builder_upload_block_size(
     let _ = qiniu_ng_config_builder_t::from(builder);
 }
 
+/// @brief 指定客户端配置中的上传分块缓冲区池最大缓存尺寸
+/// @details
+///     存储空间上传器会缓存分片上传时读取分块所用的缓冲区以便复用，
+///     缓存总量不会超过该值与 `线程池大小 × 上传分块尺寸` 中的较小者，从而使每个进程的内存占用可以预期
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] max_size 最大缓存尺寸，单位为字节，传入 `0` 将禁用缓存
+/// @note 默认为 256 MB
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_upload_buffer_pool_max_size(
+    builder: qiniu_ng_config_builder_t,
+    max_size: size_t,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.config_builder = builder.config_builder.upload_buffer_pool_max_size(max_size);
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
 /// @brief 指定客户端配置中的 HTTP 请求连接超时时长
 /// @details 对 SDK 所有发出的 HTTP 请求均有效
 /// @param[in] builder 客户端配置生成器实例
@@ -424,6 +457,117 @@ pub extern "C" fn qiniu_ng_config_builder_http_request_retry_delay(
     let _ = qiniu_ng_config_builder_t::from(builder);
 }
 
+/// @brief 指定客户端配置中的 HTTP 对冲请求延迟
+/// @details
+///     对 SDK 所有请求方法为 GET 或 HEAD，或是被 SDK 标记为幂等的 HTTP 请求（包括表单上传请求和分片上传的各个请求）均有效，
+///     请求体必须已经完整加载进内存，或是长度不超过 4 MB 的数据流
+/// @details
+///     如果在该时长内仍未得到响应，SDK 将向下一个候选 URL（如果没有，则是同一个 URL 的下一个 IP 地址）再发出一个请求，
+///     采用先得到的响应，并取消另一个请求
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] http_request_hedge_delay 对冲请求延迟，单位为毫秒，传入 `0` 表示不发出对冲请求
+/// @note 默认为不发出对冲请求
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_http_request_hedge_delay(
+    builder: qiniu_ng_config_builder_t,
+    http_request_hedge_delay: u64,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    if http_request_hedge_delay > 0 {
+        builder.config_builder = builder
+            .config_builder
+            .http_request_hedge_delay(Duration::from_millis(http_request_hedge_delay));
+    }
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
+/// @brief 指定 SDK 内置的 libcurl 请求处理函数的句柄池大小
+/// @details 句柄池中的句柄共享连接缓存，因此该值同时也决定了最多可以保持的空闲连接数
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] pool_size 句柄池中最多缓存的 libcurl 句柄数
+/// @note 默认为 16
+/// @note 调用该方法将使客户端配置使用按照指定参数创建的 libcurl 请求处理函数，之前通过 `qiniu_ng_config_builder_set_http_call_handler()` 设置的回调函数将被覆盖
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_http_pool_size(builder: qiniu_ng_config_builder_t, pool_size: size_t) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.set_curl_client_option(|curl_client_builder| curl_client_builder.pool_size(pool_size));
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
+/// @brief 指定 SDK 内置的 libcurl 请求处理函数是否启用 HTTP/2
+/// @details 启用后，HTTPS 请求将优先通过 HTTP/2 发送，并在可能的情况下复用已有的 HTTP/2 连接而非建立新连接
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] http2 是否启用 HTTP/2
+/// @note 默认不启用
+/// @note 调用该方法将使客户端配置使用按照指定参数创建的 libcurl 请求处理函数，之前通过 `qiniu_ng_config_builder_set_http_call_handler()` 设置的回调函数将被覆盖
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_http2(builder: qiniu_ng_config_builder_t, http2: bool) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.set_curl_client_option(|curl_client_builder| curl_client_builder.http2(http2));
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
+/// @brief 指定 SDK 内置的 libcurl 请求处理函数是否复用 TLS 会话
+/// @details 启用后，建立新的 HTTPS 连接时可以通过会话恢复省去完整的 TLS 握手
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] tls_session_reuse 是否复用 TLS 会话
+/// @note 默认启用
+/// @note 调用该方法将使客户端配置使用按照指定参数创建的 libcurl 请求处理函数，之前通过 `qiniu_ng_config_builder_set_http_call_handler()` 设置的回调函数将被覆盖
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_http_tls_session_reuse(
+    builder: qiniu_ng_config_builder_t,
+    tls_session_reuse: bool,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.set_curl_client_option(|curl_client_builder| curl_client_builder.tls_session_reuse(tls_session_reuse));
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
+/// @brief 指定 SDK 内置的 libcurl 请求处理函数使用基于 libcurl multi 接口的传输引擎发送请求
+/// @details
+///     设置后，请求将交由引擎的事件循环线程执行，所有请求共享引擎的连接缓存，并可在 HTTP/2 连接上多路复用，
+///     从而可以用少量线程同时驱动大量传输。超出最大传输数的请求将排队等待
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] event_loop_threads 事件循环线程数，传入 `0` 表示使用默认值 `1`
+/// @param[in] max_transfers 最大同时进行的传输数，将平均分配给每个事件循环线程，传入 `0` 表示使用默认值 `64`
+/// @note 默认不使用传输引擎，每个请求都在发起请求的线程中执行
+/// @note 使用传输引擎时，上传下载进度回调将在事件循环线程中被调用
+/// @note 调用该方法将使客户端配置使用按照指定参数创建的 libcurl 请求处理函数，之前通过 `qiniu_ng_config_builder_set_http_call_handler()` 设置的回调函数将被覆盖
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_http_multi_engine(
+    builder: qiniu_ng_config_builder_t,
+    event_loop_threads: size_t,
+    max_transfers: size_t,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    let mut multi_engine_builder = CurlMultiEngineBuilder::default();
+    if event_loop_threads > 0 {
+        multi_engine_builder = multi_engine_builder.event_loop_threads(event_loop_threads);
+    }
+    if max_transfers > 0 {
+        multi_engine_builder = multi_engine_builder.max_transfers(max_transfers);
+    }
+    builder
+        .set_curl_client_option(|curl_client_builder| curl_client_builder.multi_engine(multi_engine_builder.build()));
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
+/// @brief 指定 SDK 内置的 libcurl 请求处理函数最多记录连接统计信息的主机数
+/// @details 超出该值时，将淘汰最久未发送过请求的主机的统计信息
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] max_hosts 最多记录连接统计信息的主机数，设置为 `0` 将不再记录连接统计信息
+/// @note 默认为 256
+/// @note 调用该方法将使客户端配置使用按照指定参数创建的 libcurl 请求处理函数，之前通过 `qiniu_ng_config_builder_set_http_call_handler()` 设置的回调函数将被覆盖
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_http_max_connection_stats_hosts(
+    builder: qiniu_ng_config_builder_t,
+    max_hosts: size_t,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.set_curl_client_option(|curl_client_builder| curl_client_builder.max_connection_stats_hosts(max_hosts));
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
 /// @brief 禁用上传日志记录仪
 /// @param[in] builder 客户端配置生成器实例
 /// @note 默认上传日志记录仪将被启用
@@ -529,6 +673,48 @@ pub extern "C" fn qiniu_ng_config_builder_uplog_file_max_size(builder: qiniu_ng_
     let _ = qiniu_ng_config_builder_t::from(builder);
 }
 
+/// @brief 设置上传日志的内存队列容量
+/// @details
+///     设置为大于 0 的值时，上传日志将改为内存队列模式，记录日志时仅将记录放入无锁队列，由后台线程批量上传，不再读写上传日志文件。
+///     后台线程将在待上传的日志尺寸大于上传阙值，或距离上次上传超过上传间隔时上传日志。
+///     队列已满时将丢弃最早的记录
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] queue_capacity 内存队列容量，单位为记录条数，实际容量为不小于该值的 2 的幂
+/// @note 默认为 0，即使用上传日志文件
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_uplog_queue_capacity(
+    builder: qiniu_ng_config_builder_t,
+    queue_capacity: size_t,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.upload_logger_builder = Some(
+        builder
+            .upload_logger_builder
+            .unwrap_or_default()
+            .queue_capacity(queue_capacity),
+    );
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
+/// @brief 设置内存队列模式下的上传日志上传间隔
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] flush_interval 上传间隔，单位为秒
+/// @note 默认为 10 秒
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_uplog_flush_interval(
+    builder: qiniu_ng_config_builder_t,
+    flush_interval: u64,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.upload_logger_builder = Some(
+        builder
+            .upload_logger_builder
+            .unwrap_or_default()
+            .flush_interval(Duration::from_secs(flush_interval)),
+    );
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
 /// @brief 设置上传进度记录仪文件根目录
 /// @details 每个上传的文件都会有一个对应的上传进度记录仪文件，因此需要设置根目录存储
 /// @param[in] builder 客户端配置生成器实例
@@ -583,6 +769,41 @@ pub extern "C" fn qiniu_ng_config_builder_upload_recorder_always_flush_records(
     let _ = qiniu_ng_config_builder_t::from(builder);
 }
 
+/// @brief 设置进度记录批量提交的分块数量
+/// @details
+///     分块记录将先缓存在内存中，每累计到指定数量，或距离上次提交超过批量提交间隔时，一次性写入进度记录文件并刷新。
+///     进程意外退出时，尚未提交的分块记录将会丢失，续传时这些分块需要重新上传。
+///     如果设置了进度记录文件始终刷新，则该配置无效
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] flush_every_parts 批量提交的分块数量，设置为 0 或 1 表示每条分块记录都立即写入
+/// @note 默认为 16
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_upload_recorder_flush_every_parts(
+    builder: qiniu_ng_config_builder_t,
+    flush_every_parts: size_t,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.upload_recorder_builder.flush_every_parts(flush_every_parts);
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
+/// @brief 设置进度记录批量提交的时间间隔
+/// @details 仅在写入分块记录时检查，距离上次提交超过该间隔时，缓存的分块记录将被立即提交
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] flush_interval 批量提交的时间间隔，单位为毫秒
+/// @note 默认为 1 秒
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_upload_recorder_flush_interval(
+    builder: qiniu_ng_config_builder_t,
+    flush_interval: u64,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder
+        .upload_recorder_builder
+        .flush_interval(Duration::from_millis(flush_interval));
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
 /// @brief 从指定路径加载域名管理器
 /// @details 加载后，该路径将作为域名管理器的持久化路径
 /// @param[in] builder 客户端配置生成器实例
@@ -753,6 +974,129 @@ pub extern "C" fn qiniu_ng_config_builder_domains_manager_url_resolve_retry_dela
     let _ = qiniu_ng_config_builder_t::from(builder);
 }
 
+/// @brief 设置域名管理器的域名解析超时时长
+/// @details 请求线程等待域名解析结果的最长时间。超时后请求线程将放弃该域名，但解析依然会在后台继续进行，其结果将被缓存
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] resolve_timeout 域名解析超时时长，单位为毫秒
+/// @note 默认为 5 秒
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_domains_manager_resolve_timeout(
+    builder: qiniu_ng_config_builder_t,
+    resolve_timeout: u64,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.domains_manager_builder = builder
+        .domains_manager_builder
+        .resolve_timeout(Duration::from_millis(resolve_timeout));
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
+/// @brief 设置域名管理器的域名解析失败结果的缓存生命周期
+/// @details 域名解析失败后，在该时长内对同一域名的解析将直接返回错误，而不再调用域名解析器
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] negative_resolutions_cache_lifetime 缓存生命周期，单位为秒
+/// @note 默认缓存十秒
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_domains_manager_negative_resolutions_cache_lifetime(
+    builder: qiniu_ng_config_builder_t,
+    negative_resolutions_cache_lifetime: u64,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.domains_manager_builder = builder
+        .domains_manager_builder
+        .negative_resolutions_cache_lifetime(Duration::from_secs(negative_resolutions_cache_lifetime));
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
+type QiniuNgResolveFunc =
+    extern "C" fn(host: *const qiniu_ng_char_t, port: u16, data: *mut c_void) -> qiniu_ng_str_list_t;
+
+struct QiniuNgResolver {
+    handler: QiniuNgResolveFunc,
+    data: *mut c_void,
+}
+
+impl QiniuNgResolver {
+    fn new(handler: QiniuNgResolveFunc, data: *mut c_void) -> Self {
+        Self { handler, data }
+    }
+}
+
+impl Resolver for QiniuNgResolver {
+    fn resolve(&self, host: &str, port: u16) -> IOResult<Box<[SocketAddr]>> {
+        let c_host = UCString::from_str(host).map_err(|err| IOError::new(IOErrorKind::InvalidInput, err))?;
+        let ips = Option::<Box<[Box<ucstr>]>>::from((self.handler)(c_host.as_ptr(), port, self.data))
+            .ok_or_else(|| IOError::new(IOErrorKind::NotFound, format!("Failed to resolve {}", host)))?;
+        ips.iter()
+            .map(|ip| {
+                let ip = ip
+                    .to_string()
+                    .map_err(|err| IOError::new(IOErrorKind::InvalidData, err))?;
+                ip.parse::<SocketAddr>()
+                    .or_else(|_| ip.parse::<IpAddr>().map(|ip| SocketAddr::new(ip, port)))
+                    .map_err(|err| IOError::new(IOErrorKind::InvalidData, err))
+            })
+            .collect()
+    }
+}
+unsafe impl Sync for QiniuNgResolver {}
+unsafe impl Send for QiniuNgResolver {}
+
+/// @brief 设置域名管理器的域名解析器
+/// @details
+///     SDK 默认调用操作系统提供的域名解析功能，您可以通过设置该回调函数接入自定义的域名解析或服务发现机制。
+///     SDK 总是在后台线程中调用该函数，并负责超时控制，合并相同域名的并发解析，以及缓存解析结果，因此该函数可以是阻塞的。
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] handler 回调函数。回调函数的第一个参数是需要解析的域名（IPv6 地址不含方括号），第二个参数是端口号，第三个参数总是传入本函数调用时传入的 `data` 参数，您可以根据您的需要为 `data` 设置上下文数据。回调函数需要调用 `qiniu_ng_str_list_new()` 返回解析得到的 IP 地址列表，每个 IP 地址可以带有端口号（如 `"1.2.3.4:80"` 或 `"[::1]:80"`），也可以不带（如 `"1.2.3.4"` 或 `"::1"`），不带端口号时将使用传入的端口号。如果解析失败，则返回封装 `NULL` 的字符串列表实例
+/// @param[in] data 回调函数使用的上下文指针
+/// @note 回调函数返回的字符串列表将由 SDK 负责内存回收，您无需调用 `qiniu_ng_str_list_free()` 释放
+/// @warning 该回调函数可能会被多个线程并发调用，因此需要保证实现的函数线程安全
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_domains_manager_set_resolver(
+    builder: qiniu_ng_config_builder_t,
+    handler: extern "C" fn(host: *const qiniu_ng_char_t, port: u16, data: *mut c_void) -> qiniu_ng_str_list_t,
+    data: *mut c_void,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.domains_manager_builder = builder
+        .domains_manager_builder
+        .resolver(QiniuNgResolver::new(handler, data));
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
+/// @brief 设置域名管理器的 IP 地址探测间隔时间
+/// @details 设置后，域名管理器将定期在后台对所有已解析的 IP 地址发起 TCP 连接，以连接耗时更新 IP 地址统计信息，用于优先选择更快的 IP 地址
+/// @param[in] builder 客户端配置生成器实例
+/// @param[in] socket_addr_probe_interval 探测间隔时间，单位为秒，如果传入 `0` 则表示禁止探测
+/// @note 默认不探测
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_domains_manager_socket_addr_probe_interval(
+    builder: qiniu_ng_config_builder_t,
+    socket_addr_probe_interval: u64,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.domains_manager_builder = if socket_addr_probe_interval > 0 {
+        builder
+            .domains_manager_builder
+            .socket_addr_probe_interval(Duration::from_secs(socket_addr_probe_interval))
+    } else {
+        builder.domains_manager_builder.disable_socket_addr_probe()
+    };
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
+/// @brief 设置域名管理器禁止持久化 IP 地址统计信息
+/// @param[in] builder 客户端配置生成器实例
+/// @note 默认持久化 IP 地址统计信息
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_builder_domains_manager_disable_socket_addr_stats_persistence(
+    builder: qiniu_ng_config_builder_t,
+) {
+    let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.domains_manager_builder = builder.domains_manager_builder.disable_socket_addr_stats_persistence();
+    let _ = qiniu_ng_config_builder_t::from(builder);
+}
+
 /// @brief 设置域名管理器的持久化路径
 /// @param[in] builder 客户端配置生成器实例
 /// @param[in] persistent_file_path 持久化路径，如果传入 `NULL` 则表示禁止持久化
@@ -894,6 +1238,7 @@ pub extern "C" fn qiniu_ng_config_builder_set_http_call_handler(
     data: *mut c_void,
 ) {
     let mut builder = Option::<Box<Builder>>::from(builder).unwrap();
+    builder.curl_client_builder = None;
     builder.config_builder = builder
         .config_builder
         .http_request_handler(QiniuNgHTTPCallHandler::new(handler, data));
@@ -1120,9 +1465,12 @@ pub extern "C" fn qiniu_ng_config_build(
     let builder = Option::<Box<Builder>>::from(*builder_ptr).unwrap();
     *builder_ptr = qiniu_ng_config_builder_t::default();
 
+    let mut config_builder = builder.config_builder;
+    if let Some(curl_client_builder) = builder.curl_client_builder {
+        config_builder = config_builder.http_request_handler(curl_client_builder.build());
+    }
     let config_builder = {
-        builder
-            .config_builder
+        config_builder
             .upload_logger(
                 match builder
                     .upload_logger_builder
@@ -1411,6 +1759,17 @@ pub extern "C" fn qiniu_ng_config_get_upload_block_size(config: qiniu_ng_config_
     })
 }
 
+/// @brief 获取客户端配置的上传分块缓冲区池最大缓存尺寸
+/// @param[in] config 客户端配置实例
+/// @retval size_t 上传分块缓冲区池最大缓存尺寸，单位为字节
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_get_upload_buffer_pool_max_size(config: qiniu_ng_config_t) -> size_t {
+    let config = Option::<Config>::from(config).unwrap();
+    config.upload_buffer_pool_max_size().tap(|_| {
+        let _ = qiniu_ng_config_t::from(config);
+    })
+}
+
 /// @brief 获取客户端配置的 TCP KeepAlive 空闲时长
 /// @param[in] config 客户端配置实例
 /// @retval uint64_t TCP KeepAlive 空闲时长，单位为秒
@@ -1511,6 +1870,65 @@ pub extern "C" fn qiniu_ng_config_get_http_request_retry_delay(config: qiniu_ng_
     })
 }
 
+/// @brief 获取客户端配置的 HTTP 对冲请求延迟
+/// @param[in] config 客户端配置实例
+/// @retval uint64_t HTTP 对冲请求延迟，单位为毫秒，返回 `0` 表示不发出对冲请求
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_get_http_request_hedge_delay(config: qiniu_ng_config_t) -> u64 {
+    let config = Option::<Config>::from(config).unwrap();
+    config
+        .http_request_hedge_delay()
+        .map(|delay| delay.as_millis() as u64)
+        .unwrap_or(0)
+        .tap(|_| {
+            let _ = qiniu_ng_config_t::from(config);
+        })
+}
+
+/// @brief 与单个主机之间的连接统计信息
+/// @note 无需对该结构体进行内存释放
+#[repr(C)]
+#[derive(Copy, Clone, Default)]
+pub struct qiniu_ng_http_connection_stats_t {
+    /// @brief 新建立的连接数
+    pub connections_opened: u64,
+    /// @brief 复用已有连接的请求数
+    pub connections_reused: u64,
+    /// @brief 新建立连接的握手总耗时，包括 TCP 连接和 TLS 握手，不包括域名解析，单位为毫秒
+    pub handshake_duration: u64,
+}
+
+/// @brief 获取客户端配置的 HTTP 请求处理函数与指定主机之间的连接统计信息
+/// @details 仅有 SDK 内置的 libcurl 请求处理函数会统计连接信息，通过 `qiniu_ng_config_builder_set_http_call_handler()` 设置的回调函数不会统计
+/// @param[in] config 客户端配置实例
+/// @param[in] host 主机名，不包含协议和端口，例如 `upload.qiniup.com`
+/// @param[out] stats 用于返回连接统计信息，如果传入 `NULL` 表示不获取 `stats`，但不影响返回值
+/// @retval bool 是否存在与该主机之间的连接统计信息
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_get_http_connection_stats(
+    config: qiniu_ng_config_t,
+    host: *const qiniu_ng_char_t,
+    stats: *mut qiniu_ng_http_connection_stats_t,
+) -> bool {
+    let config = Option::<Config>::from(config).unwrap();
+    let host = unsafe { ucstr::from_ptr(host) }.to_string().unwrap();
+    let found = match config.http_request_handler().connection_stats(&host) {
+        Some(connection_stats) => {
+            if let Some(stats) = unsafe { stats.as_mut() } {
+                *stats = qiniu_ng_http_connection_stats_t {
+                    connections_opened: connection_stats.connections_opened(),
+                    connections_reused: connection_stats.connections_reused(),
+                    handshake_duration: connection_stats.handshake_duration().as_millis() as u64,
+                };
+            }
+            true
+        }
+        None => false,
+    };
+    let _ = qiniu_ng_config_t::from(config);
+    found
+}
+
 /// @brief 客户端配置是否启用上传日志记录仪
 /// @param[in] config 客户端配置实例
 /// @retval bool 是否启用上传日志记录仪
@@ -1613,6 +2031,31 @@ pub extern "C" fn qiniu_ng_config_get_uplog_file_max_size(config: qiniu_ng_confi
         })
 }
 
+/// @brief 获取客户端配置中的上传日志内存队列容量
+/// @param[in] config 客户端配置实例
+/// @param[out] queue_capacity 用于返回实际使用的内存队列容量，返回 0 表示使用上传日志文件。如果传入 `NULL` 表示不获取 `queue_capacity`。但如果上传日志已经启用，返回值将依然是 `true`
+/// @retval bool 如果上传日志已经启用，则返回 `true`，否则返回 `false`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_get_uplog_queue_capacity(
+    config: qiniu_ng_config_t,
+    queue_capacity: *mut size_t,
+) -> bool {
+    let config = Option::<Config>::from(config).unwrap();
+    config
+        .upload_logger()
+        .as_ref()
+        .map(|upload_logger| {
+            if let Some(queue_capacity) = unsafe { queue_capacity.as_mut() } {
+                *queue_capacity = upload_logger.queue_capacity();
+            }
+            true
+        })
+        .unwrap_or(false)
+        .tap(|_| {
+            let _ = qiniu_ng_config_t::from(config);
+        })
+}
+
 /// @brief 获取客户端配置中的上传进度记录仪文件根目录
 /// @param[in] config 客户端配置实例
 /// @retval qiniu_ng_str_t 文件根目录
@@ -1658,6 +2101,28 @@ pub extern "C" fn qiniu_ng_config_get_upload_recorder_always_flush_records(confi
     })
 }
 
+/// @brief 获取客户端配置中的进度记录批量提交的分块数量
+/// @param[in] config 客户端配置实例
+/// @retval size_t 批量提交的分块数量
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_get_upload_recorder_flush_every_parts(config: qiniu_ng_config_t) -> size_t {
+    let config = Option::<Config>::from(config).unwrap();
+    config.upload_recorder().flush_every_parts().tap(|_| {
+        let _ = qiniu_ng_config_t::from(config);
+    })
+}
+
+/// @brief 获取客户端配置中的进度记录批量提交的时间间隔
+/// @param[in] config 客户端配置实例
+/// @retval uint64_t 批量提交的时间间隔，单位为毫秒
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_get_upload_recorder_flush_interval(config: qiniu_ng_config_t) -> u64 {
+    let config = Option::<Config>::from(config).unwrap();
+    (config.upload_recorder().flush_interval().as_millis() as u64).tap(|_| {
+        let _ = qiniu_ng_config_t::from(config);
+    })
+}
+
 /// @brief 获取客户端配置中的域名管理器的 URL 冻结时长
 /// @details
 ///     当 SDK 发送 HTTP 请求时，如果发现网络或服务异常，靠重试无法解决的，则冻结所访问的服务器 URL。
@@ -1751,6 +2216,66 @@ pub extern "C" fn qiniu_ng_config_get_domains_manager_url_resolve_retry_delay(co
     })
 }
 
+/// @brief 获取客户端配置中的域名管理器的域名解析超时时长
+/// @param[in] config 客户端配置实例
+/// @retval uint64_t 返回域名管理器的域名解析超时时长，单位为毫秒
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_get_domains_manager_resolve_timeout(config: qiniu_ng_config_t) -> u64 {
+    let config = Option::<Config>::from(config).unwrap();
+    (config.domains_manager().resolve_timeout().as_millis() as u64).tap(|_| {
+        let _ = qiniu_ng_config_t::from(config);
+    })
+}
+
+/// @brief 获取客户端配置中的域名管理器的域名解析失败结果的缓存生命周期
+/// @param[in] config 客户端配置实例
+/// @retval uint64_t 返回域名管理器的域名解析失败结果的缓存生命周期，单位为秒
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_get_domains_manager_negative_resolutions_cache_lifetime(
+    config: qiniu_ng_config_t,
+) -> u64 {
+    let config = Option::<Config>::from(config).unwrap();
+    config
+        .domains_manager()
+        .negative_resolutions_cache_lifetime()
+        .as_secs()
+        .tap(|_| {
+            let _ = qiniu_ng_config_t::from(config);
+        })
+}
+
+/// @brief 获取客户端配置中的域名管理器的 IP 地址探测间隔时间
+/// @param[in] config 客户端配置实例
+/// @retval uint64_t 返回域名管理器的 IP 地址探测间隔时间，单位为秒，如果返回 `0` 则表示不探测
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_get_domains_manager_socket_addr_probe_interval(config: qiniu_ng_config_t) -> u64 {
+    let config = Option::<Config>::from(config).unwrap();
+    config
+        .domains_manager()
+        .socket_addr_probe_interval()
+        .map(|interval| interval.as_secs())
+        .unwrap_or(0)
+        .tap(|_| {
+            let _ = qiniu_ng_config_t::from(config);
+        })
+}
+
+/// @brief 获取客户端配置中的域名管理器是否禁止持久化 IP 地址统计信息
+/// @param[in] config 客户端配置实例
+/// @retval bool 域名管理器是否禁止持久化 IP 地址统计信息
+#[no_mangle]
+pub extern "C" fn qiniu_ng_config_get_domains_manager_socket_addr_stats_persistence_disabled(
+    config: qiniu_ng_config_t,
+) -> bool {
+    let config = Option::<Config>::from(config).unwrap();
+    config
+        .domains_manager()
+        .socket_addr_stats_persistence_disabled()
+        .tap(|_| {
+            let _ = qiniu_ng_config_t::from(config);
+        })
+}
+
 /// @brief 获取客户端配置中的域名管理器的持久化路径
 /// @param[in] config 客户端配置实例
 /// @retval qiniu_ng_str_t 持久化路径，如果持久化已经被禁用，则返回的字符串实例中将封装 `NULL`
@@ -174,7 +174,7 @@ pub extern "C" fn qiniu_ng_credential_validate_qiniu_callback_request(
         );
     }
     if !body.is_null() && body_len > 0 {
-        request_builder = request_builder.body(unsafe { from_raw_parts(body.cast(), body_len) });
+        request_builder = request_builder.body(unsafe { from_raw_parts(body.cast::<u8>(), body_len) });
     }
     credential.is_valid_request(&request_builder.build()).tap(|_| {
         let _ = qiniu_ng_credential_t::from(credential);
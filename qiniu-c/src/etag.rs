@@ -4,8 +4,9 @@ use super::{
 };
 use digest::{FixedOutput, Input, Reset};
 use libc::{c_char, c_void, size_t};
-use qiniu_ng::utils::etag;
+use qiniu_ng::utils::{etag, thread_pool::etag_thread_pool};
 use std::{
+    io::{Error as IOError, ErrorKind as IOErrorKind},
     mem::{replace, transmute},
     ptr::{copy_nonoverlapping, null_mut},
     slice::from_raw_parts,
@@ -43,6 +44,49 @@ pub extern "C" fn qiniu_ng_etag_from_file_path(
     }
 }
 
+/// @brief 并行计算指定路径的文件的 七牛 Etag
+/// @details 文件将按 Etag 块尺寸切分，各个块将在多个线程中并行计算，计算结果与 `qiniu_ng_etag_from_file_path()` 完全一致
+/// @param[in] path 文件路径
+/// @param[in] threads 用于计算 Etag 的线程数量，如果传入 `0`，则表示使用与 CPU 核心数相同的线程数量
+/// @note 线程数量与上一次调用相同时将复用已经创建的线程池，线程池可以通过 `qiniu_ng_recreate_global_thread_pool()` 丢弃
+/// @param[out] result 用于返回 Etag 的内存地址，如果传入 `NULL` 表示不获取 `result`。但如果运行正常，返回值将依然是 `true`
+/// @param[out] error 用于返回错误，如果传入 `NULL` 表示不获取 `error`。但如果运行发生错误，返回值将依然是 `false`
+/// @retval bool 是否运行正常，如果返回 `true`，则表示可以读取 `result` 获得结果，如果返回 `false`，则表示可以读取 `error` 获得错误信息
+/// @warning 保证提供给 `result` 至少 `ETAG_SIZE` 长度的内存，除非 `result` 为 `NULL`
+/// @warning 对于获取的 `result` 或 `error`，一旦使用完毕，应该调用各自的内存释放方法释放内存
+#[no_mangle]
+pub extern "C" fn qiniu_ng_etag_from_file_path_parallel(
+    path: *const qiniu_ng_char_t,
+    threads: size_t,
+    result: *mut c_char,
+    error: *mut qiniu_ng_err_t,
+) -> bool {
+    let thread_pool = match etag_thread_pool(threads) {
+        Ok(thread_pool) => thread_pool,
+        Err(err) => {
+            if let Some(error) = unsafe { error.as_mut() } {
+                *error = (&IOError::new(IOErrorKind::Other, err)).into();
+            }
+            return false;
+        }
+    };
+    match etag::from_file_in_parallel(unsafe { UCString::from_ptr(path) }.into_path_buf(), &thread_pool) {
+        Ok(etag_string) => {
+            let etag_bytes = etag_string.as_bytes();
+            if let Some(result) = unsafe { result.as_mut() } {
+                unsafe { copy_nonoverlapping(etag_bytes.as_ptr(), result as *mut c_char as *mut u8, etag_bytes.len()) };
+            }
+            true
+        }
+        Err(ref err) => {
+            if let Some(error) = unsafe { error.as_mut() } {
+                *error = err.into();
+            }
+            false
+        }
+    }
+}
+
 /// @brief 计算指定二进制数据的 七牛 Etag
 /// @param[in] data 输入数据地址
 /// @param[in] data_len 输入数据长度
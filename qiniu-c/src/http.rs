@@ -253,21 +253,22 @@ pub extern "C" fn qiniu_ng_http_request_set_header(
 /// @param[out] body_ptr 用于返回 HTTP 请求体地址。如果传入 `NULL` 表示不获取 `body_ptr`，但不影响 `body_size` 的获取
 /// @param[out] body_size 用于返回 HTTP 请求体长度，单位为字节。如果传入 `NULL` 表示不获取 `body_size`，但不影响 `body_ptr` 的获取
 /// @warning 请勿修改其存储的请求体内容，您可以调用 `qiniu_ng_http_request_set_body()` 设置内容
+/// @note 如果请求体是数据流（例如表单上传的文件内容），获取 `body_ptr` 时数据流将被完整读入内存，此后该请求将直接发送内存中的请求体
+/// @warning 如果数据流读取失败，`body_ptr` 将返回 `NULL`，而 `body_size` 仍返回请求体长度
 #[no_mangle]
 pub extern "C" fn qiniu_ng_http_request_get_body(
     request: qiniu_ng_http_request_t,
     body_ptr: *mut *const c_void,
     body_size: *mut size_t,
 ) {
-    let request: &Request = request.into();
+    let request: &mut Request = request.into();
     if let Some(body_size) = unsafe { body_size.as_mut() } {
-        *body_size = request.body().len();
+        *body_size = request.body().len().try_into().unwrap_or(size_t::max_value());
     }
     if let Some(body_ptr) = unsafe { body_ptr.as_mut() } {
-        *body_ptr = if request.body().is_empty() {
-            null_mut()
-        } else {
-            request.body().as_ref().as_ptr().cast()
+        *body_ptr = match request.body_mut().buffer() {
+            Ok(body) if !body.is_empty() => body.as_ptr().cast(),
+            _ => null_mut(),
         };
     }
     let _ = qiniu_ng_http_request_t::from(request);
@@ -286,7 +287,7 @@ pub extern "C" fn qiniu_ng_http_request_set_body(
 ) {
     let request: &mut Request = request.into();
     *request.body_mut() = if body_size == 0 {
-        Cow::Borrowed(&[])
+        Default::default()
     } else {
         let mut buf = Vec::new();
         buf.extend_from_slice(unsafe { from_raw_parts(body_ptr.cast(), body_size) });
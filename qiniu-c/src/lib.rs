@@ -1,17 +1,24 @@
+mod arena;
+mod bandwidth_limiter;
 mod batch_uploader;
 mod bucket;
+mod bucket_batch;
 mod bucket_uploader;
+mod callback_queue;
+mod cancellation_token;
 mod client;
 mod config;
 mod credential;
 mod etag;
 mod http;
+mod metrics;
 mod region;
 mod result;
 mod storage;
 mod string;
 mod thread_pool;
 mod upload;
+mod upload_handle;
 mod upload_manager;
 mod upload_response;
 mod upload_token;
@@ -0,0 +1,210 @@
+use super::utils::qiniu_ng_str_t;
+use libc::c_void;
+use qiniu_ng::http::metrics::{self, Event, MetricsSink, Timing, HISTOGRAM_BUCKETS};
+use std::{sync::Arc, time::Duration};
+
+/// @brief 耗时直方图的桶数
+pub const QINIU_NG_METRICS_HISTOGRAM_BUCKETS: usize = 28;
+/// @brief 耗时统计项数量
+pub const QINIU_NG_METRICS_TIMINGS: usize = 8;
+/// @brief 事件统计项数量
+pub const QINIU_NG_METRICS_EVENTS: usize = 4;
+
+const _: [(); HISTOGRAM_BUCKETS] = [(); QINIU_NG_METRICS_HISTOGRAM_BUCKETS];
+const _: [(); QINIU_NG_METRICS_TIMINGS] = [(); Timing::ALL.len()];
+const _: [(); QINIU_NG_METRICS_EVENTS] = [(); Event::ALL.len()];
+
+/// @brief 耗时统计项
+#[repr(C)]
+#[derive(Copy, Clone, Debug, PartialEq, Eq)]
+#[allow(dead_code, non_camel_case_types)]
+pub enum qiniu_ng_metrics_timing_t {
+    /// @brief 域名解析耗时
+    qiniu_ng_metrics_timing_dns_resolution = 0,
+    /// @brief 建立 TCP 连接的耗时，不包括域名解析
+    qiniu_ng_metrics_timing_connect,
+    /// @brief TLS 握手耗时
+    qiniu_ng_metrics_timing_tls_handshake,
+    /// @brief 首字节时间，即从开始请求到收到第一个响应字节的耗时
+    qiniu_ng_metrics_timing_time_to_first_byte,
+    /// @brief 单次 HTTP 请求的耗时，不包括重试
+    qiniu_ng_metrics_timing_http_request,
+    /// @brief 单个分块的上传耗时，包括重试
+    qiniu_ng_metrics_timing_part_upload,
+    /// @brief 写入上传记录的耗时
+    qiniu_ng_metrics_timing_recorder_io,
+    /// @brief 写入上传日志的耗时
+    qiniu_ng_metrics_timing_upload_logger_io,
+}
+
+impl From<Timing> for qiniu_ng_metrics_timing_t {
+    fn from(timing: Timing) -> Self {
+        match timing {
+            Timing::DNSResolution => qiniu_ng_metrics_timing_t::qiniu_ng_metrics_timing_dns_resolution,
+            Timing::Connect => qiniu_ng_metrics_timing_t::qiniu_ng_metrics_timing_connect,
+            Timing::TLSHandshake => qiniu_ng_metrics_timing_t::qiniu_ng_metrics_timing_tls_handshake,
+            Timing::TimeToFirstByte => qiniu_ng_metrics_timing_t::qiniu_ng_metrics_timing_time_to_first_byte,
+            Timing::HTTPRequest => qiniu_ng_metrics_timing_t::qiniu_ng_metrics_timing_http_request,
+            Timing::PartUpload => qiniu_ng_metrics_timing_t::qiniu_ng_metrics_timing_part_upload,
+            Timing::RecorderIO => qiniu_ng_metrics_timing_t::qiniu_ng_metrics_timing_recorder_io,
+            Timing::UploadLoggerIO => qiniu_ng_metrics_timing_t::qiniu_ng_metrics_timing_upload_logger_io,
+        }
+    }
+}
+
+/// @brief 事件统计项
+#[repr(C)]
+#[derive(Copy, Clone, Debug, PartialEq, Eq)]
+#[allow(dead_code, non_camel_case_types)]
+pub enum qiniu_ng_metrics_event_t {
+    /// @brief 同一个 URL 上的 HTTP 请求重试
+    qiniu_ng_metrics_event_retry = 0,
+    /// @brief URL 因请求失败而被冻结
+    qiniu_ng_metrics_event_url_frozen,
+    /// @brief 发出对冲请求
+    qiniu_ng_metrics_event_hedged_request,
+    /// @brief 域名解析失败
+    qiniu_ng_metrics_event_dns_resolution_failure,
+}
+
+impl From<Event> for qiniu_ng_metrics_event_t {
+    fn from(event: Event) -> Self {
+        match event {
+            Event::Retry => qiniu_ng_metrics_event_t::qiniu_ng_metrics_event_retry,
+            Event::URLFrozen => qiniu_ng_metrics_event_t::qiniu_ng_metrics_event_url_frozen,
+            Event::HedgedRequest => qiniu_ng_metrics_event_t::qiniu_ng_metrics_event_hedged_request,
+            Event::DNSResolutionFailure => qiniu_ng_metrics_event_t::qiniu_ng_metrics_event_dns_resolution_failure,
+        }
+    }
+}
+
+/// @brief 耗时直方图
+/// @details 第 `i` 个桶记录耗时小于 `2^i` 微秒，且不小于 `2^(i-1)` 微秒的样本数量，最后一个桶记录所有更长的样本数量
+/// @note 无需对该结构体进行内存释放
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct qiniu_ng_metrics_histogram_t {
+    /// @brief 样本数量
+    pub count: u64,
+    /// @brief 样本耗时总和，单位为微秒
+    pub sum_us: u64,
+    /// @brief 各个桶中的样本数量，非累积
+    pub buckets: [u64; QINIU_NG_METRICS_HISTOGRAM_BUCKETS],
+}
+
+/// @brief 统计结果快照
+/// @details 以 `qiniu_ng_metrics_timing_t` 和 `qiniu_ng_metrics_event_t` 的值作为下标访问各个统计项
+/// @note 无需对该结构体进行内存释放
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct qiniu_ng_metrics_snapshot_t {
+    /// @brief 各个耗时统计项的直方图
+    pub timings: [qiniu_ng_metrics_histogram_t; QINIU_NG_METRICS_TIMINGS],
+    /// @brief 各个事件统计项的发生次数
+    pub events: [u64; QINIU_NG_METRICS_EVENTS],
+}
+
+/// @brief 开启统计
+/// @details 统计默认关闭，关闭时各个统计点几乎没有开销
+#[no_mangle]
+pub extern "C" fn qiniu_ng_metrics_enable() {
+    metrics::enable()
+}
+
+/// @brief 关闭统计
+/// @details 已经记录的统计结果将被保留
+#[no_mangle]
+pub extern "C" fn qiniu_ng_metrics_disable() {
+    metrics::disable()
+}
+
+/// @brief 统计是否已经开启
+/// @retval bool 统计是否已经开启
+#[no_mangle]
+pub extern "C" fn qiniu_ng_metrics_is_enabled() -> bool {
+    metrics::is_enabled()
+}
+
+/// @brief 清空所有统计结果
+#[no_mangle]
+pub extern "C" fn qiniu_ng_metrics_reset() {
+    metrics::reset()
+}
+
+/// @brief 获取当前统计结果的快照
+/// @param[out] snapshot 用于返回统计结果快照的内存地址，如果传入 `NULL` 则不做任何操作
+/// @note 快照中的各项数据分别读取，在统计的同时获取快照，各项数据之间可能存在细微的不一致
+#[no_mangle]
+pub extern "C" fn qiniu_ng_metrics_snapshot(snapshot: *mut qiniu_ng_metrics_snapshot_t) {
+    let snapshot = match unsafe { snapshot.as_mut() } {
+        Some(snapshot) => snapshot,
+        None => return,
+    };
+    let metrics_snapshot = metrics::snapshot();
+    for (&timing, histogram) in Timing::ALL.iter().zip(snapshot.timings.iter_mut()) {
+        let timing = metrics_snapshot.timing(timing);
+        histogram.count = timing.count();
+        histogram.sum_us = timing.sum().as_micros() as u64;
+        histogram.buckets.copy_from_slice(timing.buckets());
+    }
+    for (&event, count) in Event::ALL.iter().zip(snapshot.events.iter_mut()) {
+        *count = metrics_snapshot.event(event);
+    }
+}
+
+/// @brief 获取当前统计结果的 Prometheus 文本格式
+/// @retval qiniu_ng_str_t 统计结果文本
+/// @warning 当 `qiniu_ng_str_t` 使用完毕后，请务必调用 `qiniu_ng_str_free()` 方法释放内存
+#[no_mangle]
+pub extern "C" fn qiniu_ng_metrics_to_prometheus_text() -> qiniu_ng_str_t {
+    unsafe { qiniu_ng_str_t::from_string_unchecked(metrics::snapshot().to_prometheus_text()) }
+}
+
+type QiniuNgMetricsDurationFunc = extern "C" fn(timing: qiniu_ng_metrics_timing_t, duration_us: u64, data: *mut c_void);
+type QiniuNgMetricsEventFunc = extern "C" fn(event: qiniu_ng_metrics_event_t, data: *mut c_void);
+
+struct QiniuNgMetricsSink {
+    on_duration: Option<QiniuNgMetricsDurationFunc>,
+    on_event: Option<QiniuNgMetricsEventFunc>,
+    data: *mut c_void,
+}
+
+impl MetricsSink for QiniuNgMetricsSink {
+    fn on_duration(&self, timing: Timing, duration: Duration) {
+        if let Some(on_duration) = self.on_duration {
+            (on_duration)(timing.into(), duration.as_micros() as u64, self.data);
+        }
+    }
+
+    fn on_event(&self, event: Event) {
+        if let Some(on_event) = self.on_event {
+            (on_event)(event.into(), self.data);
+        }
+    }
+}
+unsafe impl Sync for QiniuNgMetricsSink {}
+unsafe impl Send for QiniuNgMetricsSink {}
+
+/// @brief 设置度量指标接收器
+/// @details 统计开启时，每一条耗时记录和每一次事件都将同步地传给回调函数，可以用于将统计结果接入您自己的监控系统
+/// @param[in] on_duration 接收耗时记录的回调函数。回调函数的第一个参数是耗时统计项，第二个参数是耗时，单位为微秒，第三个参数总是传入本函数调用时传入的 `data` 参数。如果传入 `NULL` 表示不接收耗时记录
+/// @param[in] on_event 接收事件的回调函数。回调函数的第一个参数是事件统计项，第二个参数总是传入本函数调用时传入的 `data` 参数。如果传入 `NULL` 表示不接收事件
+/// @param[in] data 回调函数使用的上下文指针
+/// @note 如果 `on_duration` 和 `on_event` 均传入 `NULL`，则将移除已经设置的接收器
+/// @warning 回调函数将在发生记录的线程中直接调用，可能会被多个线程并发调用，因此需要保证实现的函数线程安全，并尽快返回
+#[no_mangle]
+pub extern "C" fn qiniu_ng_metrics_set_sink(
+    on_duration: Option<extern "C" fn(timing: qiniu_ng_metrics_timing_t, duration_us: u64, data: *mut c_void)>,
+    on_event: Option<extern "C" fn(event: qiniu_ng_metrics_event_t, data: *mut c_void)>,
+    data: *mut c_void,
+) {
+    if on_duration.is_none() && on_event.is_none() {
+        metrics::set_sink(None);
+    } else {
+        metrics::set_sink(Some(Arc::new(QiniuNgMetricsSink {
+            on_duration,
+            on_event,
+            data,
+        })));
+    }
+}
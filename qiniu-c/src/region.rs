@@ -1,8 +1,9 @@
 use crate::{
+    arena::{qiniu_ng_arena_str_list_t, qiniu_ng_arena_t, Arena},
     config::qiniu_ng_config_t,
     result::qiniu_ng_err_t,
     string::{qiniu_ng_char_t, ucstr},
-    utils::qiniu_ng_str_list_t,
+    utils::{qiniu_ng_str_list_t, qiniu_ng_str_view_t},
 };
 use libc::{c_char, c_void, size_t};
 use qiniu_ng::storage::region::{Region, RegionBuilder, RegionId};
@@ -448,6 +449,48 @@ pub extern "C" fn qiniu_ng_region_get_up_urls(region: qiniu_ng_region_t, use_htt
     })
 }
 
+/// @brief 获取区域上传服务器 URL 列表的字符串视图
+/// @param[in] region 区域实例
+/// @param[in] use_https 是否返回 HTTPS 协议的 URL
+/// @param[out] views 提供视图数组用于返回上传服务器 URL，至多写入 `capacity` 个视图。如果传入 `NULL` 表示仅获取 URL 数量
+/// @param[in] capacity 视图数组 `views` 的容量
+/// @retval size_t 返回上传服务器 URL 的实际数量，如果该数量大于 `capacity`，可以提供更大的视图数组重新调用
+/// @note 返回的字符串视图无需释放，但仅在区域实例被释放前有效
+#[no_mangle]
+pub extern "C" fn qiniu_ng_region_get_up_urls_view(
+    region: qiniu_ng_region_t,
+    use_https: bool,
+    views: *mut qiniu_ng_str_view_t,
+    capacity: size_t,
+) -> size_t {
+    let region = Option::<Box<Cow<'static, Region>>>::from(region).unwrap();
+    unsafe { qiniu_ng_str_view_t::fill_from_str_slice(&region.up_urls_ref(use_https), views, capacity) }.tap(|_| {
+        let _ = qiniu_ng_region_t::from(region);
+    })
+}
+
+/// @brief 获取区域上传服务器 URL 列表，并将其存放在内存池中
+/// @param[in] region 区域实例
+/// @param[in] use_https 是否返回 HTTPS 协议的 URL
+/// @param[in] arena 内存池实例
+/// @retval qiniu_ng_arena_str_list_t 返回上传服务器 URL 列表
+/// @note 返回的列表无需单独释放，将在内存池被重置或释放时一并释放
+#[no_mangle]
+pub extern "C" fn qiniu_ng_region_get_up_urls_in_arena(
+    region: qiniu_ng_region_t,
+    use_https: bool,
+    arena: qiniu_ng_arena_t,
+) -> qiniu_ng_arena_str_list_t {
+    let region = Option::<Box<Cow<'static, Region>>>::from(region).unwrap();
+    let mut arena = Option::<Box<Arena>>::from(arena).unwrap();
+    arena
+        .alloc_str_list(region.up_urls_ref(use_https).iter().copied())
+        .tap(|_| {
+            let _ = qiniu_ng_arena_t::from(arena);
+            let _ = qiniu_ng_region_t::from(region);
+        })
+}
+
 /// @brief 获取区域 IO 服务器 URL 列表
 /// @param[in] region 区域实例
 /// @param[in] use_https 是否返回 HTTPS 协议的 URL
@@ -461,6 +504,48 @@ pub extern "C" fn qiniu_ng_region_get_io_urls(region: qiniu_ng_region_t, use_htt
     })
 }
 
+/// @brief 获取区域 IO 服务器 URL 列表的字符串视图
+/// @param[in] region 区域实例
+/// @param[in] use_https 是否返回 HTTPS 协议的 URL
+/// @param[out] views 提供视图数组用于返回 IO 服务器 URL，至多写入 `capacity` 个视图。如果传入 `NULL` 表示仅获取 URL 数量
+/// @param[in] capacity 视图数组 `views` 的容量
+/// @retval size_t 返回 IO 服务器 URL 的实际数量，如果该数量大于 `capacity`，可以提供更大的视图数组重新调用
+/// @note 返回的字符串视图无需释放，但仅在区域实例被释放前有效
+#[no_mangle]
+pub extern "C" fn qiniu_ng_region_get_io_urls_view(
+    region: qiniu_ng_region_t,
+    use_https: bool,
+    views: *mut qiniu_ng_str_view_t,
+    capacity: size_t,
+) -> size_t {
+    let region = Option::<Box<Cow<'static, Region>>>::from(region).unwrap();
+    unsafe { qiniu_ng_str_view_t::fill_from_str_slice(&region.io_urls_ref(use_https), views, capacity) }.tap(|_| {
+        let _ = qiniu_ng_region_t::from(region);
+    })
+}
+
+/// @brief 获取区域 IO 服务器 URL 列表，并将其存放在内存池中
+/// @param[in] region 区域实例
+/// @param[in] use_https 是否返回 HTTPS 协议的 URL
+/// @param[in] arena 内存池实例
+/// @retval qiniu_ng_arena_str_list_t 返回 IO 服务器 URL 列表
+/// @note 返回的列表无需单独释放，将在内存池被重置或释放时一并释放
+#[no_mangle]
+pub extern "C" fn qiniu_ng_region_get_io_urls_in_arena(
+    region: qiniu_ng_region_t,
+    use_https: bool,
+    arena: qiniu_ng_arena_t,
+) -> qiniu_ng_arena_str_list_t {
+    let region = Option::<Box<Cow<'static, Region>>>::from(region).unwrap();
+    let mut arena = Option::<Box<Arena>>::from(arena).unwrap();
+    arena
+        .alloc_str_list(region.io_urls_ref(use_https).iter().copied())
+        .tap(|_| {
+            let _ = qiniu_ng_arena_t::from(arena);
+            let _ = qiniu_ng_region_t::from(region);
+        })
+}
+
 /// @brief 获取区域 RS 服务器 URL 列表
 /// @param[in] region 区域实例
 /// @param[in] use_https 是否返回 HTTPS 协议的 URL
@@ -474,6 +559,48 @@ pub extern "C" fn qiniu_ng_region_get_rs_urls(region: qiniu_ng_region_t, use_htt
     })
 }
 
+/// @brief 获取区域 RS 服务器 URL 列表的字符串视图
+/// @param[in] region 区域实例
+/// @param[in] use_https 是否返回 HTTPS 协议的 URL
+/// @param[out] views 提供视图数组用于返回 RS 服务器 URL，至多写入 `capacity` 个视图。如果传入 `NULL` 表示仅获取 URL 数量
+/// @param[in] capacity 视图数组 `views` 的容量
+/// @retval size_t 返回 RS 服务器 URL 的实际数量，如果该数量大于 `capacity`，可以提供更大的视图数组重新调用
+/// @note 返回的字符串视图无需释放，但仅在区域实例被释放前有效
+#[no_mangle]
+pub extern "C" fn qiniu_ng_region_get_rs_urls_view(
+    region: qiniu_ng_region_t,
+    use_https: bool,
+    views: *mut qiniu_ng_str_view_t,
+    capacity: size_t,
+) -> size_t {
+    let region = Option::<Box<Cow<'static, Region>>>::from(region).unwrap();
+    unsafe { qiniu_ng_str_view_t::fill_from_str_slice(&region.rs_urls_ref(use_https), views, capacity) }.tap(|_| {
+        let _ = qiniu_ng_region_t::from(region);
+    })
+}
+
+/// @brief 获取区域 RS 服务器 URL 列表，并将其存放在内存池中
+/// @param[in] region 区域实例
+/// @param[in] use_https 是否返回 HTTPS 协议的 URL
+/// @param[in] arena 内存池实例
+/// @retval qiniu_ng_arena_str_list_t 返回 RS 服务器 URL 列表
+/// @note 返回的列表无需单独释放，将在内存池被重置或释放时一并释放
+#[no_mangle]
+pub extern "C" fn qiniu_ng_region_get_rs_urls_in_arena(
+    region: qiniu_ng_region_t,
+    use_https: bool,
+    arena: qiniu_ng_arena_t,
+) -> qiniu_ng_arena_str_list_t {
+    let region = Option::<Box<Cow<'static, Region>>>::from(region).unwrap();
+    let mut arena = Option::<Box<Arena>>::from(arena).unwrap();
+    arena
+        .alloc_str_list(region.rs_urls_ref(use_https).iter().copied())
+        .tap(|_| {
+            let _ = qiniu_ng_arena_t::from(arena);
+            let _ = qiniu_ng_region_t::from(region);
+        })
+}
+
 /// @brief 获取区域 RSF 服务器 URL 列表
 /// @param[in] region 区域实例
 /// @param[in] use_https 是否返回 HTTPS 协议的 URL
@@ -487,6 +614,48 @@ pub extern "C" fn qiniu_ng_region_get_rsf_urls(region: qiniu_ng_region_t, use_ht
     })
 }
 
+/// @brief 获取区域 RSF 服务器 URL 列表的字符串视图
+/// @param[in] region 区域实例
+/// @param[in] use_https 是否返回 HTTPS 协议的 URL
+/// @param[out] views 提供视图数组用于返回 RSF 服务器 URL，至多写入 `capacity` 个视图。如果传入 `NULL` 表示仅获取 URL 数量
+/// @param[in] capacity 视图数组 `views` 的容量
+/// @retval size_t 返回 RSF 服务器 URL 的实际数量，如果该数量大于 `capacity`，可以提供更大的视图数组重新调用
+/// @note 返回的字符串视图无需释放，但仅在区域实例被释放前有效
+#[no_mangle]
+pub extern "C" fn qiniu_ng_region_get_rsf_urls_view(
+    region: qiniu_ng_region_t,
+    use_https: bool,
+    views: *mut qiniu_ng_str_view_t,
+    capacity: size_t,
+) -> size_t {
+    let region = Option::<Box<Cow<'static, Region>>>::from(region).unwrap();
+    unsafe { qiniu_ng_str_view_t::fill_from_str_slice(&region.rsf_urls_ref(use_https), views, capacity) }.tap(|_| {
+        let _ = qiniu_ng_region_t::from(region);
+    })
+}
+
+/// @brief 获取区域 RSF 服务器 URL 列表，并将其存放在内存池中
+/// @param[in] region 区域实例
+/// @param[in] use_https 是否返回 HTTPS 协议的 URL
+/// @param[in] arena 内存池实例
+/// @retval qiniu_ng_arena_str_list_t 返回 RSF 服务器 URL 列表
+/// @note 返回的列表无需单独释放，将在内存池被重置或释放时一并释放
+#[no_mangle]
+pub extern "C" fn qiniu_ng_region_get_rsf_urls_in_arena(
+    region: qiniu_ng_region_t,
+    use_https: bool,
+    arena: qiniu_ng_arena_t,
+) -> qiniu_ng_arena_str_list_t {
+    let region = Option::<Box<Cow<'static, Region>>>::from(region).unwrap();
+    let mut arena = Option::<Box<Arena>>::from(arena).unwrap();
+    arena
+        .alloc_str_list(region.rsf_urls_ref(use_https).iter().copied())
+        .tap(|_| {
+            let _ = qiniu_ng_arena_t::from(arena);
+            let _ = qiniu_ng_region_t::from(region);
+        })
+}
+
 /// @brief 获取区域 API 服务器 URL 列表
 /// @param[in] region 区域实例
 /// @param[in] use_https 是否返回 HTTPS 协议的 URL
@@ -500,6 +669,48 @@ pub extern "C" fn qiniu_ng_region_get_api_urls(region: qiniu_ng_region_t, use_ht
     })
 }
 
+/// @brief 获取区域 API 服务器 URL 列表的字符串视图
+/// @param[in] region 区域实例
+/// @param[in] use_https 是否返回 HTTPS 协议的 URL
+/// @param[out] views 提供视图数组用于返回 API 服务器 URL，至多写入 `capacity` 个视图。如果传入 `NULL` 表示仅获取 URL 数量
+/// @param[in] capacity 视图数组 `views` 的容量
+/// @retval size_t 返回 API 服务器 URL 的实际数量，如果该数量大于 `capacity`，可以提供更大的视图数组重新调用
+/// @note 返回的字符串视图无需释放，但仅在区域实例被释放前有效
+#[no_mangle]
+pub extern "C" fn qiniu_ng_region_get_api_urls_view(
+    region: qiniu_ng_region_t,
+    use_https: bool,
+    views: *mut qiniu_ng_str_view_t,
+    capacity: size_t,
+) -> size_t {
+    let region = Option::<Box<Cow<'static, Region>>>::from(region).unwrap();
+    unsafe { qiniu_ng_str_view_t::fill_from_str_slice(&region.api_urls_ref(use_https), views, capacity) }.tap(|_| {
+        let _ = qiniu_ng_region_t::from(region);
+    })
+}
+
+/// @brief 获取区域 API 服务器 URL 列表，并将其存放在内存池中
+/// @param[in] region 区域实例
+/// @param[in] use_https 是否返回 HTTPS 协议的 URL
+/// @param[in] arena 内存池实例
+/// @retval qiniu_ng_arena_str_list_t 返回 API 服务器 URL 列表
+/// @note 返回的列表无需单独释放，将在内存池被重置或释放时一并释放
+#[no_mangle]
+pub extern "C" fn qiniu_ng_region_get_api_urls_in_arena(
+    region: qiniu_ng_region_t,
+    use_https: bool,
+    arena: qiniu_ng_arena_t,
+) -> qiniu_ng_arena_str_list_t {
+    let region = Option::<Box<Cow<'static, Region>>>::from(region).unwrap();
+    let mut arena = Option::<Box<Arena>>::from(arena).unwrap();
+    arena
+        .alloc_str_list(region.api_urls_ref(use_https).iter().copied())
+        .tap(|_| {
+            let _ = qiniu_ng_arena_t::from(arena);
+            let _ = qiniu_ng_region_t::from(region);
+        })
+}
+
 /// @brief 查询七牛服务器，根据存储空间名称获取区域列表
 /// @param[in] bucket_name 存储空间名称
 /// @param[in] access_key 七牛 Access Key
@@ -13,6 +13,7 @@ use qiniu_ng::{
         RetryKind as HTTPRetryKind,
     },
     storage::{
+        batch::BatchOperationError,
         manager::DropBucketError,
         uploader::{CreateUploaderError, UploadError, UploadTokenParseError},
     },
@@ -753,6 +754,19 @@ impl From<&DropBucketError> for qiniu_ng_err_t {
     }
 }
 
+impl From<&BatchOperationError> for qiniu_ng_err_t {
+    fn from(err: &BatchOperationError) -> Self {
+        match err {
+            BatchOperationError::HTTPError(e) => e.as_ref().into(),
+            BatchOperationError::ResponseStatusCodeError(status_code, error_message) => Self(
+                qiniu_ng_err_kind_t::qiniu_ng_err_kind_response_status_code_error(*status_code, unsafe {
+                    qiniu_ng_str_t::from_str_unchecked(error_message)
+                }),
+            ),
+        }
+    }
+}
+
 impl From<&UploadTokenParseError> for qiniu_ng_err_t {
     fn from(err: &UploadTokenParseError) -> Self {
         Self(qiniu_ng_err_kind_t::qiniu_ng_err_kind_invalid_upload_token_error(
@@ -5,6 +5,7 @@ use qiniu_ng::utils::thread_pool;
 /// @details
 ///     在每次 Fork 新进程后，应该在子进程内调用该方法以重建全局线程池，否则部分 SDK 功能在子进程内可能无法正常使用。
 ///     使用该方法也可以用于调整全局线程池线程数量。
+///     批量上传器使用的共享上传线程池，异步上传线程池以及并行计算 Etag 使用的线程池也将被丢弃，并在下一次使用时重新创建。
 /// @param[in] num_threads 调整全局线程池数量。如果传入 0，则表示不改变线程池数量
 #[no_mangle]
 pub extern "C" fn qiniu_ng_recreate_global_thread_pool(num_threads: size_t) {
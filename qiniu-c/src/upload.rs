@@ -1,7 +1,9 @@
 use crate::{
     bucket_uploader::qiniu_ng_bucket_uploader_t,
+    callback_queue::qiniu_ng_callback_queue_t,
     result::qiniu_ng_err_t,
     string::{qiniu_ng_char_t, ucstr, UCString},
+    upload_handle::{qiniu_ng_upload_handle_t, Notifier, UploadHandle},
     upload_manager::qiniu_ng_upload_manager_t,
     upload_response::qiniu_ng_upload_response_t,
     upload_token::qiniu_ng_upload_token_t,
@@ -12,9 +14,12 @@ use crate::{
 };
 use libc::{c_void, size_t, FILE};
 use mime::Mime;
-use qiniu_ng::storage::uploader::{BucketUploader, FileUploaderBuilder, UploadManager, UploadResult, UploadToken};
+use qiniu_ng::storage::uploader::{
+    BucketUploader, FileUploaderBuilder, UploadFuture, UploadManager, UploadResult, UploadToken,
+};
 use std::{
     collections::{hash_map::RandomState, HashMap},
+    io::{Error as IOError, ErrorKind as IOErrorKind},
     mem::drop,
     ptr::null_mut,
     result::Result,
@@ -85,6 +90,25 @@ pub struct qiniu_ng_upload_params_t {
     pub thread_pool_size: size_t,
     /// @brief 上传文件最大并发度
     pub max_concurrency: size_t,
+    /// @brief 是否在读取上传数据的同时计算本地 Etag
+    /// @details 计算结果可以通过 `qiniu_ng_upload_response_get_local_etag()` 获取，无需再调用 `qiniu_ng_etag_from_file_path()` 预先计算
+    /// @note 分片上传时，如果分块尺寸不是 4 MB 的整数倍且未启用分块自适应调节，或断点续传时已经上传的分块未与 4 MB 的 Etag 块对齐，将不会计算本地 Etag
+    pub local_etag_enabled: bool,
+    /// @brief 是否启用分片上传时的分块自适应调节
+    /// @details
+    ///     启用后，将根据已上传分块的耗时测算上传吞吐量和往返时延，据此调节之后分块的尺寸以及同时上传的分块数，
+    ///     最大并发度仍由 `max_concurrency` 或线程池大小决定。仅当使用分片上传时生效
+    pub adaptive_part_size_enabled: bool,
+    /// @brief 是否在上传文件时将其映射到内存
+    /// @details 启用后将直接从映射区域读取文件内容，避免将文件内容复制到缓冲区。默认不启用，此时文件将按位置读取
+    /// @warning 仅当可以确保上传期间文件不会被截断时才能启用，否则访问被截断的部分将导致进程收到 `SIGBUS` 信号而崩溃
+    pub memory_mapping_enabled: bool,
+    /// @brief 为上传指定回调队列
+    /// @details
+    ///     如果指定，`on_uploading_progress` 将不会被调用，上传进度将以 `callback_data` 作为标识推入回调队列，
+    ///     由调用 `qiniu_ng_callback_queue_pop()` 的线程取出处理，此时 `on_uploading_progress` 仅用于表示需要推送上传进度事件。
+    ///     上传结果依然由上传函数直接返回，不会推入回调队列，因此上传函数返回后即可调用 `qiniu_ng_callback_queue_close()` 关闭回调队列
+    pub callback_queue: qiniu_ng_callback_queue_t,
 }
 
 /// @brief 上传指定路径的文件
@@ -235,6 +259,125 @@ fn qiniu_ng_upload_manager_upload(
     result
 }
 
+/// @brief 在后台上传指定路径的文件
+/// @details 上传将在后台进行，函数将立即返回异步上传句柄，可以通过该句柄轮询、等待或取消上传
+/// @param[in] upload_manager 上传管理器
+/// @param[in] upload_token 上传凭证实例
+/// @param[in] file_path 文件路径
+/// @param[in] params 上传参数，如果为 `NULL`，则使用默认上传参数
+/// @param[out] upload_handle 用于返回异步上传句柄，不能传入 `NULL`，否则将直接返回错误，上传不会开始
+/// @param[out] err 用于返回上传错误，如果传入 `NULL` 表示不获取 `err`。但如果上传错误，返回值将依然是 `false`
+/// @retval bool 是否成功开始上传，如果返回 `true`，则表示可以通过 `upload_handle` 获取上传结果，如果返回 `false`，则表示可以读取 `error` 获得错误信息
+/// @warning 对于获取的 `upload_handle` 或 `error`，一旦使用完毕，应该调用各自的内存释放方法释放内存
+/// @warning 上传结束前，请务必保证上传参数中的回调函数及其上下文数据，以及文件实例或阅读器实例依然可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_manager_upload_file_path_async(
+    upload_manager: qiniu_ng_upload_manager_t,
+    upload_token: qiniu_ng_upload_token_t,
+    file_path: *const qiniu_ng_char_t,
+    params: *const qiniu_ng_upload_params_t,
+    upload_handle: *mut qiniu_ng_upload_handle_t,
+    err: *mut qiniu_ng_err_t,
+) -> bool {
+    qiniu_ng_upload_manager_upload_async(
+        upload_manager,
+        upload_token,
+        UploadTarget::FilePath(file_path),
+        params,
+        upload_handle,
+        err,
+    )
+}
+
+/// @brief 在后台上传文件
+/// @details 上传将在后台进行，函数将立即返回异步上传句柄，可以通过该句柄轮询、等待或取消上传
+/// @param[in] upload_manager 上传管理器
+/// @param[in] upload_token 上传凭证实例
+/// @param[in] file 文件实例，务必保证文件实例可以读取。上传完毕后，请不要忘记调用 `fclose()` 关闭文件实例
+/// @param[in] params 上传参数，如果为 `NULL`，则使用默认上传参数
+/// @param[out] upload_handle 用于返回异步上传句柄，不能传入 `NULL`，否则将直接返回错误，上传不会开始
+/// @param[out] err 用于返回上传错误，如果传入 `NULL` 表示不获取 `err`。但如果上传错误，返回值将依然是 `false`
+/// @retval bool 是否成功开始上传，如果返回 `true`，则表示可以通过 `upload_handle` 获取上传结果，如果返回 `false`，则表示可以读取 `error` 获得错误信息
+/// @warning 对于获取的 `upload_handle` 或 `error`，一旦使用完毕，应该调用各自的内存释放方法释放内存
+/// @warning 上传结束前，请务必保证上传参数中的回调函数及其上下文数据，以及文件实例或阅读器实例依然可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_manager_upload_file_async(
+    upload_manager: qiniu_ng_upload_manager_t,
+    upload_token: qiniu_ng_upload_token_t,
+    file: *mut FILE,
+    params: *const qiniu_ng_upload_params_t,
+    upload_handle: *mut qiniu_ng_upload_handle_t,
+    err: *mut qiniu_ng_err_t,
+) -> bool {
+    qiniu_ng_upload_manager_upload_async(
+        upload_manager,
+        upload_token,
+        UploadTarget::File(file),
+        params,
+        upload_handle,
+        err,
+    )
+}
+
+/// @brief 在后台上传阅读器提供的数据
+/// @details 上传将在后台进行，函数将立即返回异步上传句柄，可以通过该句柄轮询、等待或取消上传
+/// @param[in] upload_manager 上传管理器
+/// @param[in] upload_token 上传凭证实例
+/// @param[in] reader 阅读器实例，将不断从阅读器中读取数据并上传
+/// @param[in] len 阅读器预期将会读到的最大数据量，如果无法预期则传入 `0`。如果传入的值大于 `0`，最终读取的数据量将始终不大于该值
+/// @param[in] params 上传参数，如果为 `NULL`，则使用默认上传参数
+/// @param[out] upload_handle 用于返回异步上传句柄，不能传入 `NULL`，否则将直接返回错误，上传不会开始
+/// @param[out] err 用于返回上传错误，如果传入 `NULL` 表示不获取 `err`。但如果上传错误，返回值将依然是 `false`
+/// @retval bool 是否成功开始上传，如果返回 `true`，则表示可以通过 `upload_handle` 获取上传结果，如果返回 `false`，则表示可以读取 `error` 获得错误信息
+/// @warning 对于获取的 `upload_handle` 或 `error`，一旦使用完毕，应该调用各自的内存释放方法释放内存
+/// @warning 上传结束前，请务必保证上传参数中的回调函数及其上下文数据，以及文件实例或阅读器实例依然可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_manager_upload_reader_async(
+    upload_manager: qiniu_ng_upload_manager_t,
+    upload_token: qiniu_ng_upload_token_t,
+    reader: qiniu_ng_readable_t,
+    len: u64,
+    params: *const qiniu_ng_upload_params_t,
+    upload_handle: *mut qiniu_ng_upload_handle_t,
+    err: *mut qiniu_ng_err_t,
+) -> bool {
+    qiniu_ng_upload_manager_upload_async(
+        upload_manager,
+        upload_token,
+        UploadTarget::Readable { reader, len },
+        params,
+        upload_handle,
+        err,
+    )
+}
+
+fn qiniu_ng_upload_manager_upload_async(
+    upload_manager: qiniu_ng_upload_manager_t,
+    upload_token: qiniu_ng_upload_token_t,
+    upload_target: UploadTarget,
+    params: *const qiniu_ng_upload_params_t,
+    upload_handle: *mut qiniu_ng_upload_handle_t,
+    err: *mut qiniu_ng_err_t,
+) -> bool {
+    let upload_manager = Option::<Box<UploadManager>>::from(upload_manager).unwrap();
+    let upload_token = Option::<Box<UploadToken>>::from(upload_token).unwrap();
+    let result = match upload_manager
+        .for_upload_token(upload_token.as_ref().to_string())
+        .tap(|_| {
+            let _ = qiniu_ng_upload_token_t::from(upload_token);
+        }) {
+        Ok(file_uploader) => start_uploading_async(file_uploader, upload_target, params, upload_handle, err),
+        Err(ref e) => {
+            if let Some(err) = unsafe { err.as_mut() } {
+                *err = e.into();
+            }
+            false
+        }
+    };
+    let _ = qiniu_ng_upload_manager_t::from(upload_manager);
+    result
+}
+
 /// @brief 上传指定路径的文件
 /// @param[in] bucket_uploader 存储空间上传器
 /// @param[in] upload_token 上传凭证实例
@@ -374,6 +517,172 @@ fn qiniu_ng_upload(
     result
 }
 
+/// @brief 在后台上传指定路径的文件
+/// @details 上传将在后台进行，函数将立即返回异步上传句柄，可以通过该句柄轮询、等待或取消上传
+/// @param[in] bucket_uploader 存储空间上传器
+/// @param[in] upload_token 上传凭证实例
+/// @param[in] file_path 文件路径
+/// @param[in] params 上传参数，如果为 `NULL`，则使用默认上传参数
+/// @param[out] upload_handle 用于返回异步上传句柄，不能传入 `NULL`，否则将直接返回错误，上传不会开始
+/// @param[out] err 用于返回上传错误，如果传入 `NULL` 表示不获取 `err`。但如果上传错误，返回值将依然是 `false`
+/// @retval bool 是否成功开始上传，如果返回 `true`，则表示可以通过 `upload_handle` 获取上传结果，如果返回 `false`，则表示可以读取 `error` 获得错误信息
+/// @warning 对于获取的 `upload_handle` 或 `error`，一旦使用完毕，应该调用各自的内存释放方法释放内存
+/// @warning 上传结束前，请务必保证上传参数中的回调函数及其上下文数据，以及文件实例或阅读器实例依然可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_uploader_upload_file_path_async(
+    bucket_uploader: qiniu_ng_bucket_uploader_t,
+    upload_token: qiniu_ng_upload_token_t,
+    file_path: *const qiniu_ng_char_t,
+    params: *const qiniu_ng_upload_params_t,
+    upload_handle: *mut qiniu_ng_upload_handle_t,
+    err: *mut qiniu_ng_err_t,
+) -> bool {
+    qiniu_ng_upload_async(
+        bucket_uploader,
+        upload_token,
+        UploadTarget::FilePath(file_path),
+        params,
+        upload_handle,
+        err,
+    )
+}
+
+/// @brief 在后台上传文件
+/// @details 上传将在后台进行，函数将立即返回异步上传句柄，可以通过该句柄轮询、等待或取消上传
+/// @param[in] bucket_uploader 存储空间上传器
+/// @param[in] upload_token 上传凭证实例
+/// @param[in] file 文件实例，务必保证文件实例可以读取。上传完毕后，请不要忘记调用 `fclose()` 关闭文件实例
+/// @param[in] params 上传参数，如果为 `NULL`，则使用默认上传参数
+/// @param[out] upload_handle 用于返回异步上传句柄，不能传入 `NULL`，否则将直接返回错误，上传不会开始
+/// @param[out] err 用于返回上传错误，如果传入 `NULL` 表示不获取 `err`。但如果上传错误，返回值将依然是 `false`
+/// @retval bool 是否成功开始上传，如果返回 `true`，则表示可以通过 `upload_handle` 获取上传结果，如果返回 `false`，则表示可以读取 `error` 获得错误信息
+/// @warning 对于获取的 `upload_handle` 或 `error`，一旦使用完毕，应该调用各自的内存释放方法释放内存
+/// @warning 上传结束前，请务必保证上传参数中的回调函数及其上下文数据，以及文件实例或阅读器实例依然可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_uploader_upload_file_async(
+    bucket_uploader: qiniu_ng_bucket_uploader_t,
+    upload_token: qiniu_ng_upload_token_t,
+    file: *mut FILE,
+    params: *const qiniu_ng_upload_params_t,
+    upload_handle: *mut qiniu_ng_upload_handle_t,
+    err: *mut qiniu_ng_err_t,
+) -> bool {
+    qiniu_ng_upload_async(
+        bucket_uploader,
+        upload_token,
+        UploadTarget::File(file),
+        params,
+        upload_handle,
+        err,
+    )
+}
+
+/// @brief 在后台上传阅读器提供的数据
+/// @details 上传将在后台进行，函数将立即返回异步上传句柄，可以通过该句柄轮询、等待或取消上传
+/// @param[in] bucket_uploader 存储空间上传器
+/// @param[in] upload_token 上传凭证实例
+/// @param[in] reader 阅读器实例，将不断从阅读器中读取数据并上传
+/// @param[in] len 阅读器预期将会读到的最大数据量，如果无法预期则传入 `0`。如果传入的值大于 `0`，最终读取的数据量将始终不大于该值
+/// @param[in] params 上传参数，如果为 `NULL`，则使用默认上传参数
+/// @param[out] upload_handle 用于返回异步上传句柄，不能传入 `NULL`，否则将直接返回错误，上传不会开始
+/// @param[out] err 用于返回上传错误，如果传入 `NULL` 表示不获取 `err`。但如果上传错误，返回值将依然是 `false`
+/// @retval bool 是否成功开始上传，如果返回 `true`，则表示可以通过 `upload_handle` 获取上传结果，如果返回 `false`，则表示可以读取 `error` 获得错误信息
+/// @warning 对于获取的 `upload_handle` 或 `error`，一旦使用完毕，应该调用各自的内存释放方法释放内存
+/// @warning 上传结束前，请务必保证上传参数中的回调函数及其上下文数据，以及文件实例或阅读器实例依然可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_bucket_uploader_upload_reader_async(
+    bucket_uploader: qiniu_ng_bucket_uploader_t,
+    upload_token: qiniu_ng_upload_token_t,
+    reader: qiniu_ng_readable_t,
+    len: u64,
+    params: *const qiniu_ng_upload_params_t,
+    upload_handle: *mut qiniu_ng_upload_handle_t,
+    err: *mut qiniu_ng_err_t,
+) -> bool {
+    qiniu_ng_upload_async(
+        bucket_uploader,
+        upload_token,
+        UploadTarget::Readable { reader, len },
+        params,
+        upload_handle,
+        err,
+    )
+}
+
+fn qiniu_ng_upload_async(
+    bucket_uploader: qiniu_ng_bucket_uploader_t,
+    upload_token: qiniu_ng_upload_token_t,
+    upload_target: UploadTarget,
+    params: *const qiniu_ng_upload_params_t,
+    upload_handle: *mut qiniu_ng_upload_handle_t,
+    err: *mut qiniu_ng_err_t,
+) -> bool {
+    let bucket_uploader = Option::<BucketUploader>::from(bucket_uploader).unwrap();
+    let upload_token = Option::<Box<UploadToken>>::from(upload_token).unwrap();
+    let file_uploader = bucket_uploader
+        .upload_token_owned(upload_token.as_ref().to_string())
+        .tap(|_| {
+            let _ = qiniu_ng_upload_token_t::from(upload_token);
+        });
+    let result = start_uploading_async(file_uploader, upload_target, params, upload_handle, err);
+    let _ = qiniu_ng_bucket_uploader_t::from(bucket_uploader);
+    result
+}
+
+fn start_uploading_async(
+    mut file_uploader: FileUploaderBuilder<'static>,
+    upload_target: UploadTarget,
+    params: *const qiniu_ng_upload_params_t,
+    upload_handle: *mut qiniu_ng_upload_handle_t,
+    err: *mut qiniu_ng_err_t,
+) -> bool {
+    // 没有句柄就无法获取上传结果，释放时还会立即取消上传，因此必须在上传开始前拒绝
+    let upload_handle = match unsafe { upload_handle.as_mut() } {
+        Some(upload_handle) => upload_handle,
+        None => {
+            if let Some(err) = unsafe { err.as_mut() } {
+                *err = (&IOError::new(IOErrorKind::InvalidInput, "upload_handle must not be NULL")).into();
+            }
+            return false;
+        }
+    };
+    let mut file_name = String::new();
+    let mut mime: Option<Mime> = None;
+    if let Some(params) = unsafe { params.as_ref() } {
+        file_uploader = set_params_to_file_uploader(file_uploader, params);
+        file_name = unsafe { convert_optional_c_string_to_rust_string(params.file_name) };
+        match parse_mime(params.mime) {
+            Some(Ok(parsed_mime)) => {
+                mime = Some(parsed_mime);
+            }
+            Some(Err(ref e)) => {
+                if let Some(err) = unsafe { err.as_mut() } {
+                    *err = e.into();
+                }
+                return false;
+            }
+            None => {}
+        };
+    }
+    // 通知器需要在上传开始前创建，创建失败时上传将不会进行
+    match Notifier::new() {
+        Ok(notifier) => {
+            *upload_handle = Box::new(UploadHandle::new(
+                notifier,
+                upload_target.upload_async(file_uploader, file_name, mime),
+            ))
+            .into();
+            true
+        }
+        Err(ref e) => {
+            if let Some(err) = unsafe { err.as_mut() } {
+                *err = e.into();
+            }
+            false
+        }
+    }
+}
+
 fn set_params_to_file_uploader<'n>(
     mut file_uploader: FileUploaderBuilder<'n>,
     params: &qiniu_ng_upload_params_t,
@@ -407,6 +716,15 @@ fn set_params_to_file_uploader<'n>(
     } else {
         file_uploader.enable_checksum()
     };
+    if params.local_etag_enabled {
+        file_uploader = file_uploader.enable_local_etag();
+    }
+    if params.adaptive_part_size_enabled {
+        file_uploader = file_uploader.enable_adaptive_part_size();
+    }
+    if params.memory_mapping_enabled {
+        file_uploader = file_uploader.enable_memory_mapping();
+    }
     match params.resumable_policy {
         qiniu_ng_resumable_policy_t::qiniu_ng_resumable_policy_threshold => {
             file_uploader = file_uploader.upload_threshold(params.upload_threshold);
@@ -419,7 +737,12 @@ fn set_params_to_file_uploader<'n>(
         }
         qiniu_ng_resumable_policy_t::qiniu_ng_resumable_policy_default => {}
     }
-    if let Some(on_uploading_progress) = params.on_uploading_progress {
+    if let (Some(callback_queue), Some(_)) = (params.callback_queue.get_cloned(), params.on_uploading_progress) {
+        let callback_data = params.callback_data as usize;
+        file_uploader = file_uploader.on_progress(move |uploaded: u64, total: Option<u64>| {
+            callback_queue.push_uploading_progress(callback_data as *mut c_void, uploaded, total.unwrap_or(0))
+        });
+    } else if let Some(on_uploading_progress) = params.on_uploading_progress {
         let callback_data = unsafe { params.callback_data.as_ref() }.map(|data| &*data);
         file_uploader = file_uploader.on_progress(move |uploaded: u64, total: Option<u64>| {
             (on_uploading_progress)(
@@ -448,6 +771,27 @@ enum UploadTarget {
 }
 
 impl UploadTarget {
+    fn upload_async(
+        self,
+        file_uploader: FileUploaderBuilder<'static>,
+        file_name: String,
+        mime: Option<Mime>,
+    ) -> UploadFuture {
+        match self {
+            UploadTarget::FilePath(file_path) => file_uploader.upload_file_async(
+                unsafe { UCString::from_ptr(file_path) }.into_path_buf(),
+                file_name,
+                mime,
+            ),
+            UploadTarget::File(file) => {
+                let mut reader = FileReader::new(file);
+                let guess_file_size = reader.guess_file_size().unwrap_or(0);
+                file_uploader.upload_stream_async(reader, guess_file_size, file_name, mime)
+            }
+            UploadTarget::Readable { reader, len } => file_uploader.upload_stream_async(reader, len, file_name, mime),
+        }
+    }
+
     fn upload(self, file_uploader: FileUploaderBuilder, file_name: String, mime: Option<Mime>) -> UploadResult {
         match self {
             UploadTarget::FilePath(file_path) => file_uploader.upload_file(
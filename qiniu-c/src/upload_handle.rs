@@ -0,0 +1,304 @@
+use crate::{result::qiniu_ng_err_t, upload_response::qiniu_ng_upload_response_t};
+use libc::{c_int, c_void};
+use qiniu_ng::storage::uploader::{UploadFuture, UploadResult};
+use std::{
+    future::Future,
+    io::{Error as IOError, ErrorKind as IOErrorKind, Result as IOResult},
+    mem::{forget, transmute},
+    pin::Pin,
+    ptr::null_mut,
+    sync::{
+        atomic::{AtomicBool, Ordering::Relaxed},
+        Arc,
+    },
+    task::{Context, Poll, RawWaker, RawWakerVTable, Waker},
+};
+
+/// @brief 异步上传句柄
+/// @details 用于轮询、等待或取消后台进行的上传，可以将 `qiniu_ng_upload_handle_get_fd()` 获取的文件描述符注册到 `epoll` / `kqueue` / `select` 中，以便在上传结束时得到通知
+/// @note
+///   * 调用 `qiniu_ng_bucket_uploader_upload_file_path_async()` 等异步上传函数创建 `qiniu_ng_upload_handle_t` 实例。
+///   * 当 `qiniu_ng_upload_handle_t` 使用完毕后，请务必调用 `qiniu_ng_upload_handle_free()` 方法释放内存。
+/// @note
+///   该结构体不可以被多个线程同时使用
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct qiniu_ng_upload_handle_t(*mut c_void);
+
+impl Default for qiniu_ng_upload_handle_t {
+    #[inline]
+    fn default() -> Self {
+        Self(null_mut())
+    }
+}
+
+impl qiniu_ng_upload_handle_t {
+    #[inline]
+    pub fn is_null(self) -> bool {
+        self.0.is_null()
+    }
+}
+
+impl From<qiniu_ng_upload_handle_t> for Option<Box<UploadHandle>> {
+    fn from(upload_handle: qiniu_ng_upload_handle_t) -> Self {
+        if upload_handle.is_null() {
+            None
+        } else {
+            Some(unsafe { Box::from_raw(transmute(upload_handle)) })
+        }
+    }
+}
+
+impl From<Option<Box<UploadHandle>>> for qiniu_ng_upload_handle_t {
+    fn from(upload_handle: Option<Box<UploadHandle>>) -> Self {
+        upload_handle
+            .map(|upload_handle| upload_handle.into())
+            .unwrap_or_default()
+    }
+}
+
+impl From<Box<UploadHandle>> for qiniu_ng_upload_handle_t {
+    fn from(upload_handle: Box<UploadHandle>) -> Self {
+        unsafe { transmute(Box::into_raw(upload_handle)) }
+    }
+}
+
+pub(crate) struct UploadHandle {
+    future: Option<UploadFuture>,
+    result: Option<UploadResult>,
+    notifier: Arc<Notifier>,
+}
+
+impl UploadHandle {
+    pub(crate) fn new(notifier: Arc<Notifier>, future: UploadFuture) -> Self {
+        let mut upload_handle = UploadHandle {
+            future: Some(future),
+            result: None,
+            notifier,
+        };
+        // 首次轮询将通知器注册为上传的唤醒器，此后上传结束时文件描述符将变为可读
+        upload_handle.poll();
+        upload_handle
+    }
+
+    fn poll(&mut self) -> bool {
+        if self.result.is_some() {
+            return true;
+        }
+        let future = match self.future.as_mut() {
+            Some(future) => future,
+            None => return true,
+        };
+        let waker = self.notifier.to_owned().into_waker();
+        match Pin::new(future).poll(&mut Context::from_waker(&waker)) {
+            Poll::Ready(result) => {
+                self.result = Some(result);
+                self.notifier.notify();
+                true
+            }
+            Poll::Pending => false,
+        }
+    }
+
+    fn wait(&mut self) -> UploadResult {
+        let future = self.future.take();
+        match self.result.take() {
+            Some(result) => result,
+            None => match future {
+                Some(future) => future.wait(),
+                None => Err(IOError::new(IOErrorKind::Other, "Upload result has already been taken").into()),
+            },
+        }
+    }
+}
+
+/// 上传结束通知器
+///
+/// 在类 Unix 系统上持有一对非阻塞管道，上传结束时向管道写入一个字节，读取端将一直保持可读直到通知器被释放
+pub(crate) struct Notifier {
+    #[cfg(unix)]
+    fds: [c_int; 2],
+    notified: AtomicBool,
+}
+
+impl Notifier {
+    #[cfg(unix)]
+    pub(crate) fn new() -> IOResult<Arc<Notifier>> {
+        use libc::{fcntl, pipe, FD_CLOEXEC, F_GETFL, F_SETFD, F_SETFL, O_NONBLOCK};
+        let mut fds: [c_int; 2] = [-1, -1];
+        if unsafe { pipe(fds.as_mut_ptr()) } != 0 {
+            return Err(IOError::last_os_error());
+        }
+        let notifier = Notifier {
+            fds,
+            notified: AtomicBool::new(false),
+        };
+        for &fd in fds.iter() {
+            let flags = unsafe { fcntl(fd, F_GETFL) };
+            if flags < 0
+                || unsafe { fcntl(fd, F_SETFL, flags | O_NONBLOCK) } < 0
+                || unsafe { fcntl(fd, F_SETFD, FD_CLOEXEC) } < 0
+            {
+                return Err(IOError::last_os_error());
+            }
+        }
+        Ok(Arc::new(notifier))
+    }
+
+    #[cfg(not(unix))]
+    pub(crate) fn new() -> IOResult<Arc<Notifier>> {
+        Ok(Arc::new(Notifier {
+            notified: AtomicBool::new(false),
+        }))
+    }
+
+    #[cfg(unix)]
+    fn fd(&self) -> c_int {
+        self.fds[0]
+    }
+
+    #[cfg(not(unix))]
+    fn fd(&self) -> c_int {
+        -1
+    }
+
+    fn notify(&self) {
+        if self.notified.swap(true, Relaxed) {
+            return;
+        }
+        #[cfg(unix)]
+        {
+            let byte = 1u8;
+            let _ = unsafe { libc::write(self.fds[1], &byte as *const u8 as *const c_void, 1) };
+        }
+    }
+
+    fn into_waker(self: Arc<Self>) -> Waker {
+        unsafe { Waker::from_raw(RawWaker::new(Arc::into_raw(self) as *const (), &NOTIFIER_WAKER_VTABLE)) }
+    }
+}
+
+#[cfg(unix)]
+impl Drop for Notifier {
+    fn drop(&mut self) {
+        for &fd in self.fds.iter() {
+            if fd >= 0 {
+                unsafe { libc::close(fd) };
+            }
+        }
+    }
+}
+
+static NOTIFIER_WAKER_VTABLE: RawWakerVTable = RawWakerVTable::new(
+    clone_notifier_waker,
+    wake_notifier,
+    wake_notifier_by_ref,
+    drop_notifier_waker,
+);
+
+unsafe fn clone_notifier_waker(data: *const ()) -> RawWaker {
+    let notifier = Arc::from_raw(data as *const Notifier);
+    forget(notifier.to_owned());
+    RawWaker::new(Arc::into_raw(notifier) as *const (), &NOTIFIER_WAKER_VTABLE)
+}
+
+unsafe fn wake_notifier(data: *const ()) {
+    Arc::from_raw(data as *const Notifier).notify();
+}
+
+unsafe fn wake_notifier_by_ref(data: *const ()) {
+    (&*(data as *const Notifier)).notify();
+}
+
+unsafe fn drop_notifier_waker(data: *const ()) {
+    drop(Arc::from_raw(data as *const Notifier));
+}
+
+/// @brief 非阻塞地检查异步上传是否已经结束
+/// @param[in] upload_handle 异步上传句柄
+/// @retval bool 如果返回 `true` 则表示上传已经结束（包括上传成功，上传失败和被取消），此时调用 `qiniu_ng_upload_handle_wait()` 将立即返回上传结果
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_handle_poll(upload_handle: qiniu_ng_upload_handle_t) -> bool {
+    let mut upload_handle = Option::<Box<UploadHandle>>::from(upload_handle).unwrap();
+    let completed = upload_handle.poll();
+    let _ = qiniu_ng_upload_handle_t::from(upload_handle);
+    completed
+}
+
+/// @brief 等待异步上传结束，并获取上传结果
+/// @details 如果上传尚未结束，将阻塞当前线程直到上传结束。上传结果只能获取一次
+/// @param[in] upload_handle 异步上传句柄
+/// @param[out] response 用于返回上传响应，如果传入 `NULL` 表示不获取 `response`。但如果上传成功，返回值将依然是 `true`
+/// @param[out] err 用于返回上传错误，如果传入 `NULL` 表示不获取 `err`。但如果上传错误，返回值将依然是 `false`
+/// @retval bool 是否上传成功，如果返回 `true`，则表示可以读取 `response` 获得结果，如果返回 `false`，则表示可以读取 `error` 获得错误信息
+/// @warning 对于获取的 `response` 或 `error`，一旦使用完毕，应该调用各自的内存释放方法释放内存
+/// @note 对于已经被取消的上传，将返回用户取消错误，可以调用 `qiniu_ng_err_user_canceled_error_extract()` 判定
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_handle_wait(
+    upload_handle: qiniu_ng_upload_handle_t,
+    response: *mut qiniu_ng_upload_response_t,
+    err: *mut qiniu_ng_err_t,
+) -> bool {
+    let mut upload_handle = Option::<Box<UploadHandle>>::from(upload_handle).unwrap();
+    let result = match upload_handle.wait() {
+        Ok(resp) => {
+            if let Some(response) = unsafe { response.as_mut() } {
+                *response = Box::new(resp).into();
+            }
+            true
+        }
+        Err(ref e) => {
+            if let Some(err) = unsafe { err.as_mut() } {
+                *err = e.into();
+            }
+            false
+        }
+    };
+    let _ = qiniu_ng_upload_handle_t::from(upload_handle);
+    result
+}
+
+/// @brief 取消异步上传
+/// @details 尚未开始的上传将不再进行，已经开始的上传将在读取下一块数据或发送下一个请求时中止。取消后上传将立即结束，如果上传已经结束，则调用该函数无效
+/// @param[in] upload_handle 异步上传句柄
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_handle_cancel(upload_handle: qiniu_ng_upload_handle_t) {
+    let upload_handle = Option::<Box<UploadHandle>>::from(upload_handle).unwrap();
+    if let Some(future) = upload_handle.future.as_ref() {
+        future.cancel();
+    }
+    let _ = qiniu_ng_upload_handle_t::from(upload_handle);
+}
+
+/// @brief 获取异步上传的通知文件描述符
+/// @details
+///     上传结束时该文件描述符将变为可读，并一直保持可读直到异步上传句柄被释放，因此可以将其注册到 `epoll` / `kqueue` / `select` 中等待上传结束。
+///     该文件描述符由 SDK 管理，请勿读取或关闭
+/// @param[in] upload_handle 异步上传句柄
+/// @retval int 文件描述符，在不支持的平台（如 Windows）上总是返回 `-1`，此时只能调用 `qiniu_ng_upload_handle_poll()` 轮询
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_handle_get_fd(upload_handle: qiniu_ng_upload_handle_t) -> c_int {
+    let upload_handle = Option::<Box<UploadHandle>>::from(upload_handle).unwrap();
+    let fd = upload_handle.notifier.fd();
+    let _ = qiniu_ng_upload_handle_t::from(upload_handle);
+    fd
+}
+
+/// @brief 释放异步上传句柄
+/// @param[in,out] upload_handle 异步上传句柄地址，释放完毕后该句柄将不再可用
+/// @note 释放尚未结束的异步上传句柄将取消上传
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_handle_free(upload_handle: *mut qiniu_ng_upload_handle_t) {
+    if let Some(upload_handle) = unsafe { upload_handle.as_mut() } {
+        let _ = Option::<Box<UploadHandle>>::from(*upload_handle);
+        *upload_handle = qiniu_ng_upload_handle_t::default();
+    }
+}
+
+/// @brief 判断异步上传句柄是否已经被释放
+/// @param[in] upload_handle 异步上传句柄
+/// @retval bool 如果返回 `true` 则表示异步上传句柄已经被释放，该句柄不再可用
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_handle_is_freed(upload_handle: qiniu_ng_upload_handle_t) -> bool {
+    upload_handle.is_null()
+}
@@ -1,4 +1,8 @@
-use crate::utils::qiniu_ng_str_t;
+use crate::{
+    arena::{qiniu_ng_arena_t, Arena},
+    string::qiniu_ng_char_t,
+    utils::{qiniu_ng_str_t, qiniu_ng_str_view_t},
+};
 use libc::{c_void, size_t};
 use qiniu_ng::storage::uploader::UploadResponse;
 use std::{
@@ -67,6 +71,21 @@ pub extern "C" fn qiniu_ng_upload_response_get_key(upload_response: qiniu_ng_upl
     })
 }
 
+/// @brief 获取上传响应中的对象名称的字符串视图
+/// @param[in] upload_response 上传响应实例
+/// @retval qiniu_ng_str_view_t 对象名称的字符串视图
+/// @note 这里返回的 `qiniu_ng_str_view_t` 有可能为 `NULL`，请调用 `qiniu_ng_str_view_is_null()` 进行判断
+/// @note 返回的字符串视图无需释放，但仅在上传响应实例被释放前有效
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_response_get_key_view(
+    upload_response: qiniu_ng_upload_response_t,
+) -> qiniu_ng_str_view_t {
+    let upload_response = Option::<Box<UploadResponse>>::from(upload_response).unwrap();
+    qiniu_ng_str_view_t::from_optional_str(upload_response.key()).tap(|_| {
+        let _ = qiniu_ng_upload_response_t::from(upload_response);
+    })
+}
+
 /// @brief 获取上传响应中的校验和字段
 /// @param[in] upload_response 上传响应实例
 /// @param[out] result_ptr 提供内存地址用于返回校验和字段，如果传入 `NULL` 表示不获取 `result_ptr`。但如果该字段存在，返回值依然是 `true`，且不影响其他字段的获取
@@ -91,6 +110,44 @@ pub extern "C" fn qiniu_ng_upload_response_get_hash(
     let _ = qiniu_ng_upload_response_t::from(upload_response);
 }
 
+/// @brief 获取上传过程中在本地计算得到的 Etag
+/// @param[in] upload_response 上传响应实例
+/// @param[out] result_ptr 提供内存地址用于返回本地 Etag，如果传入 `NULL` 表示不获取 `result_ptr`。如果本地 Etag 存在，提供的内存长度应该不小于 `ETAG_SIZE`
+/// @param[out] result_size 用于返回本地 Etag 长度，如果传入 `NULL` 表示不获取 `result_size`。如果返回 `0`，则表明上传时没有启用本地 Etag 计算，或无法计算本地 Etag
+/// @note 仅当上传参数中的 `local_etag_enabled` 为 `true` 时才会计算本地 Etag，可以用于与 `qiniu_ng_upload_response_get_hash()` 的结果进行比较
+/// @note 分片上传的分块未与 4 MB 的 Etag 块对齐时无法计算本地 Etag，此时 `result_size` 将返回 `0`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_response_get_local_etag(
+    upload_response: qiniu_ng_upload_response_t,
+    result_ptr: *mut c_void,
+    result_size: *mut size_t,
+) {
+    let upload_response = Option::<Box<UploadResponse>>::from(upload_response).unwrap();
+    if let Some(etag) = upload_response.local_etag().map(|etag| etag.as_bytes()) {
+        if let Some(result_size) = unsafe { result_size.as_mut() } {
+            *result_size = etag.len();
+        }
+        if let Some(result_ptr) = unsafe { result_ptr.as_mut() } {
+            unsafe { copy_nonoverlapping(etag.as_ptr(), result_ptr as *mut c_void as *mut u8, etag.len()) };
+        }
+    } else if let Some(result_size) = unsafe { result_size.as_mut() } {
+        *result_size = 0;
+    }
+    let _ = qiniu_ng_upload_response_t::from(upload_response);
+}
+
+/// @brief 判断对象是否因为已经存在且内容一致而被跳过上传
+/// @param[in] upload_response 上传响应实例
+/// @retval bool 仅当批量上传器设置了 `qiniu_ng_batch_uploader_skip_if_exists()` 时才可能返回 `true`
+/// @note 被跳过上传的响应中仅包含对象名称和校验和字段，且 `qiniu_ng_upload_response_get_local_etag()` 将返回在本地计算得到的 Etag
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_response_is_skipped(upload_response: qiniu_ng_upload_response_t) -> bool {
+    let upload_response = Option::<Box<UploadResponse>>::from(upload_response).unwrap();
+    upload_response.is_skipped().tap(|_| {
+        let _ = qiniu_ng_upload_response_t::from(upload_response);
+    })
+}
+
 /// @brief 获取上传响应的字符串
 /// @param[in] upload_response 上传响应实例
 /// @retval qiniu_ng_str_t 上传响应字符串，一般是 JSON 格式的
@@ -103,6 +160,24 @@ pub extern "C" fn qiniu_ng_upload_response_get_string(upload_response: qiniu_ng_
     })
 }
 
+/// @brief 获取上传响应的字符串，并将其存放在内存池中
+/// @param[in] upload_response 上传响应实例
+/// @param[in] arena 内存池实例
+/// @retval *qiniu_ng_char_t 上传响应字符串，一般是 JSON 格式的
+/// @note 返回的字符串无需单独释放，将在内存池被重置或释放时一并释放
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_response_get_string_in_arena(
+    upload_response: qiniu_ng_upload_response_t,
+    arena: qiniu_ng_arena_t,
+) -> *const qiniu_ng_char_t {
+    let upload_response = Option::<Box<UploadResponse>>::from(upload_response).unwrap();
+    let mut arena = Option::<Box<Arena>>::from(arena).unwrap();
+    arena.alloc_str(&upload_response.to_string()).tap(|_| {
+        let _ = qiniu_ng_arena_t::from(arena);
+        let _ = qiniu_ng_upload_response_t::from(upload_response);
+    })
+}
+
 /// @brief 释放上传响应实例
 /// @param[in,out] upload_response 上传响应实例地址，释放完毕后该实例将不再可用
 #[no_mangle]
@@ -989,6 +989,37 @@ pub extern "C" fn qiniu_ng_upload_token_new_from_policy_builder(
     })
 }
 
+/// @brief 根据上传策略生成器生成上传凭证实例，优先复用此前为相同上传策略签发的上传凭证
+/// @details
+///     除凭证有效期以外内容完全相同，且由同一对 Access Key 和 Secret Key 签发的上传策略视为相同的上传策略。
+///     只有缓存的上传凭证的过期时间不早于本次上传策略要求的过期时间一分钟以上时才会被复用，否则将重新签发并替换缓存，
+///     缓存的上传凭证距离过期不足一分钟时也将重新签发。
+///     适用于使用相同上传策略频繁签发上传凭证的场景，可以避免每次都重新序列化并签名上传策略
+/// @param[in] policy_builder 上传凭证生成器实例
+/// @param[out] access_key 用于签发上传凭证的七牛 Access Key
+/// @param[out] secret_key 用于签发上传凭证的七牛 Secret Key
+/// @retval qiniu_ng_upload_token_t 返回创建的上传凭证实例
+/// @warning 务必在使用 `qiniu_ng_upload_token_t` 完毕后调用 `qiniu_ng_upload_token_free()` 方法释放 `qiniu_ng_upload_token_t`
+/// @warning 在调用完毕后 `qiniu_ng_upload_policy_builder_t` 依然需要被 `qiniu_ng_upload_policy_builder_free()` 释放
+#[no_mangle]
+pub extern "C" fn qiniu_ng_upload_token_new_cached_from_policy_builder(
+    policy_builder: qiniu_ng_upload_policy_builder_t,
+    access_key: *const qiniu_ng_char_t,
+    secret_key: *const qiniu_ng_char_t,
+) -> qiniu_ng_upload_token_t {
+    let policy_builder = Option::<Box<UploadPolicyBuilder>>::from(policy_builder).unwrap();
+    qiniu_ng_upload_token_t::from(Box::new(UploadToken::new_cached(
+        &policy_builder.build(),
+        &Credential::new(
+            unsafe { ucstr::from_ptr(access_key) }.to_string().unwrap(),
+            unsafe { ucstr::from_ptr(secret_key) }.to_string().unwrap(),
+        ),
+    )))
+    .tap(|_| {
+        let _ = qiniu_ng_upload_policy_builder_t::from(policy_builder);
+    })
+}
+
 /// @brief 根据上传策略生成上传凭证实例
 /// @param[in] policy 上传凭证实例
 /// @param[out] access_key 用于签发上传凭证的七牛 Access Key
@@ -1,5 +1,5 @@
 use crate::string::{qiniu_ng_char_t, ucstr, UCString};
-use libc::{c_int, c_void, ferror, fread, fseek, ftell, size_t, FILE, SEEK_END, SEEK_SET};
+use libc::{c_char, c_int, c_void, ferror, fread, fseek, ftell, size_t, FILE, SEEK_END, SEEK_SET};
 use std::{
     boxed::Box,
     collections::{hash_map::RandomState, HashMap},
@@ -8,6 +8,8 @@ use std::{
     mem::transmute,
     path::PathBuf,
     ptr::{null, null_mut},
+    slice,
+    str::from_utf8,
 };
 use tap::TapOps;
 
@@ -193,6 +195,81 @@ pub extern "C" fn qiniu_ng_str_is_freed(s: qiniu_ng_str_t) -> bool {
     s.is_null()
 }
 
+/// @brief 字符串视图
+/// @details
+///     直接指向所属实例内部存储的字符串，获取时不会分配内存，使用完毕后也无需释放。
+///     字符串视图仅在所属实例被释放前有效，如果需要在所属实例释放后继续使用，请自行复制，或调用 `qiniu_ng_arena_alloc_str()` 复制到内存池中
+/// @note 无论在什么平台上，字符串视图中的字符串总是 UTF-8 编码，且不以 `\0` 结尾，请务必结合 `len` 使用
+/// @note 如果 `ptr` 为 `NULL`，则表示字符串不存在，可以通过 `qiniu_ng_str_view_is_null()` 判定
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct qiniu_ng_str_view_t {
+    /// 字符串地址
+    pub ptr: *const c_char,
+    /// 字符串长度，单位为字节
+    pub len: size_t,
+}
+
+impl Default for qiniu_ng_str_view_t {
+    #[inline]
+    fn default() -> Self {
+        Self { ptr: null(), len: 0 }
+    }
+}
+
+impl qiniu_ng_str_view_t {
+    #[inline]
+    pub(crate) fn from_str(s: &str) -> Self {
+        Self {
+            ptr: s.as_ptr().cast(),
+            len: s.len(),
+        }
+    }
+
+    #[inline]
+    pub(crate) fn from_optional_str(s: Option<&str>) -> Self {
+        s.map(Self::from_str).unwrap_or_default()
+    }
+
+    /// 将字符串列表的视图写入调用方提供的视图数组，至多写入 `capacity` 个，返回字符串列表的实际长度
+    pub(crate) unsafe fn fill_from_str_slice(
+        list: &[&str],
+        views: *mut qiniu_ng_str_view_t,
+        capacity: size_t,
+    ) -> size_t {
+        if !views.is_null() {
+            for (i, s) in list.iter().take(capacity).enumerate() {
+                *views.add(i) = Self::from_str(s);
+            }
+        }
+        list.len()
+    }
+
+    /// 获取视图中的字符串，调用方需要确保视图依然有效
+    ///
+    /// 视图为空或其内容不是合法的 UTF-8 字符串时返回 `None`
+    pub(crate) unsafe fn as_str<'a>(self) -> Option<&'a str> {
+        if self.ptr.is_null() {
+            None
+        } else {
+            from_utf8(slice::from_raw_parts(self.ptr.cast(), self.len)).ok()
+        }
+    }
+
+    #[inline]
+    pub fn is_null(self) -> bool {
+        self.ptr.is_null()
+    }
+}
+
+/// @brief 判断字符串视图是否为 `NULL`
+/// @param[in] view 字符串视图
+/// @retval bool 如果返回 `true` 则表明字符串视图为 `NULL`
+#[no_mangle]
+pub extern "C" fn qiniu_ng_str_view_is_null(view: qiniu_ng_str_view_t) -> bool {
+    view.is_null()
+}
+
 /// @brief 字符串列表
 /// @details 封装一个 C 字符串列表
 /// @note
@@ -1,5 +1,6 @@
 use lazy_static::lazy_static;
 use libc::c_char;
+use qiniu_ng::utils::hash_backend;
 use tap::TapOps;
 
 lazy_static! {
@@ -16,11 +17,20 @@ lazy_static! {
                 {
                     features.push("use-libcurl");
                 }
+                #[cfg(feature = "accelerated-hash")]
+                {
+                    features.push("accelerated-hash");
+                }
             })
             .join(",")
             .into_bytes()
             .tap(|features| features.push(b'\0'))
     };
+    static ref HASH_BACKEND_C_STRING: Vec<u8> = {
+        hash_backend::description()
+            .into_bytes()
+            .tap(|backend| backend.push(b'\0'))
+    };
 }
 
 /// @brief 获取 qiniu_ng 库版本号
@@ -38,3 +48,12 @@ pub extern "C" fn qiniu_ng_version() -> *const c_char {
 pub extern "C" fn qiniu_ng_features() -> *const c_char {
     BUILD_FLAGS_C_STRING.as_ptr().cast()
 }
+
+/// @brief 获取 qiniu_ng 当前生效的哈希算法实现
+/// @details 启用 `accelerated-hash` 功能编译后，计算 SHA-1 和 CRC32 时将在运行时根据 CPU 特性选用硬件加速实现
+/// @retval *char 哈希算法实现描述字符串，格式如 `sha1=sha-ni,crc32=pclmulqdq`，未使用硬件加速的算法将显示为 `software`
+/// @warning 请勿修改其存储的字符串内容
+#[no_mangle]
+pub extern "C" fn qiniu_ng_hash_backend() -> *const c_char {
+    HASH_BACKEND_C_STRING.as_ptr().cast()
+}
@@ -15,12 +15,15 @@ void tearDown(void) {
 }
 
 int main(void) {
-    printf("Version = %s, Features = %s\n", qiniu_ng_version(), qiniu_ng_features());
+    printf("Version = %s, Features = %s, Hash Backend = %s\n", qiniu_ng_version(), qiniu_ng_features(), qiniu_ng_hash_backend());
     UNITY_BEGIN();
     RUN_TEST(test_qiniu_ng_str);
     RUN_TEST(test_qiniu_ng_str_list);
+    RUN_TEST(test_qiniu_ng_arena);
     RUN_TEST(test_qiniu_ng_str_map);
+    RUN_TEST(test_qiniu_ng_metrics);
     RUN_TEST(test_qiniu_ng_etag_from_file_path);
+    RUN_TEST(test_qiniu_ng_etag_from_file_path_parallel);
     RUN_TEST(test_qiniu_ng_etag_from_data);
     RUN_TEST(test_qiniu_ng_etag_from_large_data);
     RUN_TEST(test_qiniu_ng_etag_from_unexisted_file_path);
@@ -30,6 +33,8 @@ int main(void) {
     RUN_TEST(test_qiniu_ng_config_new_default);
     RUN_TEST(test_qiniu_ng_config_new);
     RUN_TEST(test_qiniu_ng_config_new2);
+    RUN_TEST(test_qiniu_ng_config_http_connection_reuse);
+    RUN_TEST(test_qiniu_ng_config_http_multi_engine);
     RUN_TEST(test_qiniu_ng_config_http_request_handlers);
     RUN_TEST(test_qiniu_ng_config_bad_http_request_handlers);
     RUN_TEST(test_qiniu_ng_config_bad_http_request_handlers_2);
@@ -37,24 +42,36 @@ int main(void) {
     RUN_TEST(test_qiniu_ng_config_bad_http_request_handlers_4);
     RUN_TEST(test_qiniu_ng_region_query);
     RUN_TEST(test_qiniu_ng_region_get_by_id);
+    RUN_TEST(test_qiniu_ng_region_get_urls_in_arena);
     RUN_TEST(test_qiniu_ng_storage_bucket_names);
     RUN_TEST(test_qiniu_ng_storage_bucket_create_and_drop);
     RUN_TEST(test_qiniu_ng_storage_bucket_create_duplicated);
     RUN_TEST(test_qiniu_ng_bucket_get_name);
     RUN_TEST(test_qiniu_ng_bucket_get_region);
+    RUN_TEST(test_qiniu_ng_bucket_prefetch);
     RUN_TEST(test_qiniu_ng_bucket_get_unexisted_region);
     RUN_TEST(test_qiniu_ng_bucket_get_regions);
     RUN_TEST(test_qiniu_ng_bucket_builder);
     RUN_TEST(test_qiniu_ng_bucket_get_regions_and_domains);
+    RUN_TEST(test_qiniu_ng_bucket_get_domains_in_arena);
+    RUN_TEST(test_qiniu_ng_bucket_batch_stat_unexisted_keys);
+    RUN_TEST(test_qiniu_ng_bucket_batch_stat_unexisted_keys_in_arena);
     RUN_TEST(test_qiniu_ng_make_upload_token);
+    RUN_TEST(test_qiniu_ng_make_cached_upload_token);
     RUN_TEST(test_qiniu_ng_bucket_uploader_upload_empty_file);
     RUN_TEST(test_qiniu_ng_bucket_uploader_upload_file_path_failed_by_mime);
     RUN_TEST(test_qiniu_ng_bucket_uploader_upload_file_path_failed_by_non_existed_path);
     RUN_TEST(test_qiniu_ng_bucket_uploader_upload_files);
+    RUN_TEST(test_qiniu_ng_bucket_uploader_upload_file_path_async);
+    RUN_TEST(test_qiniu_ng_bucket_uploader_upload_file_path_throttled_and_canceled);
+    RUN_TEST(test_qiniu_ng_bucket_uploader_upload_file_path_with_callback_queue);
     RUN_TEST(test_qiniu_ng_bucket_uploader_upload_huge_number_of_files);
     RUN_TEST(test_qiniu_ng_upload_manager_upload_files);
     RUN_TEST(test_qiniu_ng_batch_upload_files);
     RUN_TEST(test_qiniu_ng_batch_upload_file_paths);
+    RUN_TEST(test_qiniu_ng_batch_upload_file_paths_in_background);
+    RUN_TEST(test_qiniu_ng_batch_upload_file_paths_with_callback_queue);
+    RUN_TEST(test_qiniu_ng_batch_upload_file_paths_skip_if_exists);
     RUN_TEST(test_qiniu_ng_batch_upload_file_path_failed_by_mime);
     RUN_TEST(test_qiniu_ng_batch_upload_file_path_failed_by_non_existed_path);
     RUN_TEST(test_qiniu_ng_upload_manager_upload_file_with_null_key);
@@ -32,8 +32,11 @@ qiniu_ng_char_t* create_temp_file(size_t size);
 
 void test_qiniu_ng_str(void);
 void test_qiniu_ng_str_list(void);
+void test_qiniu_ng_arena(void);
 void test_qiniu_ng_str_map(void);
+void test_qiniu_ng_metrics(void);
 void test_qiniu_ng_etag_from_file_path(void);
+void test_qiniu_ng_etag_from_file_path_parallel(void);
 void test_qiniu_ng_etag_from_data(void);
 void test_qiniu_ng_etag_from_unexisted_file_path(void);
 void test_qiniu_ng_etag_from_large_data(void);
@@ -43,6 +46,8 @@ void test_qiniu_ng_credential_sign(void);
 void test_qiniu_ng_credential_sign_with_data(void);
 void test_qiniu_ng_config_new(void);
 void test_qiniu_ng_config_new2(void);
+void test_qiniu_ng_config_http_connection_reuse(void);
+void test_qiniu_ng_config_http_multi_engine(void);
 void test_qiniu_ng_config_http_request_handlers(void);
 void test_qiniu_ng_config_bad_http_request_handlers(void);
 void test_qiniu_ng_config_bad_http_request_handlers_2(void);
@@ -50,24 +55,36 @@ void test_qiniu_ng_config_bad_http_request_handlers_3(void);
 void test_qiniu_ng_config_bad_http_request_handlers_4(void);
 void test_qiniu_ng_region_query(void);
 void test_qiniu_ng_region_get_by_id(void);
+void test_qiniu_ng_region_get_urls_in_arena(void);
 void test_qiniu_ng_storage_bucket_names(void);
 void test_qiniu_ng_storage_bucket_create_and_drop(void);
 void test_qiniu_ng_storage_bucket_create_duplicated(void);
 void test_qiniu_ng_bucket_get_name(void);
 void test_qiniu_ng_bucket_get_region(void);
+void test_qiniu_ng_bucket_prefetch(void);
 void test_qiniu_ng_bucket_get_unexisted_region(void);
 void test_qiniu_ng_bucket_get_regions(void);
 void test_qiniu_ng_bucket_builder(void);
 void test_qiniu_ng_bucket_get_regions_and_domains(void);
+void test_qiniu_ng_bucket_get_domains_in_arena(void);
+void test_qiniu_ng_bucket_batch_stat_unexisted_keys(void);
+void test_qiniu_ng_bucket_batch_stat_unexisted_keys_in_arena(void);
 void test_qiniu_ng_make_upload_token(void);
+void test_qiniu_ng_make_cached_upload_token(void);
 void test_qiniu_ng_upload_manager_upload_files(void);
 void test_qiniu_ng_bucket_uploader_upload_files(void);
+void test_qiniu_ng_bucket_uploader_upload_file_path_async(void);
+void test_qiniu_ng_bucket_uploader_upload_file_path_throttled_and_canceled(void);
+void test_qiniu_ng_bucket_uploader_upload_file_path_with_callback_queue(void);
 void test_qiniu_ng_bucket_uploader_upload_huge_number_of_files(void);
 void test_qiniu_ng_bucket_uploader_upload_empty_file(void);
 void test_qiniu_ng_bucket_uploader_upload_file_path_failed_by_mime(void);
 void test_qiniu_ng_bucket_uploader_upload_file_path_failed_by_non_existed_path(void);
 void test_qiniu_ng_batch_upload_files(void);
 void test_qiniu_ng_batch_upload_file_paths(void);
+void test_qiniu_ng_batch_upload_file_paths_in_background(void);
+void test_qiniu_ng_batch_upload_file_paths_with_callback_queue(void);
+void test_qiniu_ng_batch_upload_file_paths_skip_if_exists(void);
 void test_qiniu_ng_batch_upload_file_path_failed_by_mime(void);
 void test_qiniu_ng_batch_upload_file_path_failed_by_non_existed_path(void);
 void test_qiniu_ng_upload_manager_upload_file_with_null_key(void);
@@ -14,6 +14,7 @@ struct callback_context {
     int file_index;
     char *etag;
     int *completed;
+    int *skipped;
 };
 
 static long long last_print_time;
@@ -66,15 +67,32 @@ static void on_completed(qiniu_ng_upload_response_t upload_response, qiniu_ng_er
     TEST_ASSERT_EQUAL_INT_MESSAGE(
         hash_size, ETAG_SIZE,
         "hash_size != ETAG_SIZE");
-    TEST_ASSERT_EQUAL_STRING_MESSAGE(
-        hash, (const char *) context->etag,
-        "hash != etag");
+    if (context->etag != NULL) {
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(
+            hash, (const char *) context->etag,
+            "hash != etag");
+    } else {
+        char local_etag[ETAG_SIZE + 1];
+        size_t local_etag_size;
+        memset(local_etag, 0, ETAG_SIZE + 1);
+        qiniu_ng_upload_response_get_local_etag(upload_response, (char *) &local_etag[0], &local_etag_size);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(
+            local_etag_size, ETAG_SIZE,
+            "local_etag_size != ETAG_SIZE");
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(
+            hash, (const char *) local_etag,
+            "hash != local_etag");
+    }
+    bool skipped = qiniu_ng_upload_response_is_skipped(upload_response);
     qiniu_ng_upload_response_free(&upload_response);
 
 #if defined(_WIN32) || defined(WIN32)
     switch (WaitForSingleObject(mutex, INFINITE)) {
     case WAIT_OBJECT_0:
         (*context->completed)++;
+        if (skipped && context->skipped != NULL) {
+            (*context->skipped)++;
+        }
         ReleaseMutex(mutex);
         break;
     case WAIT_ABANDONED:
@@ -83,6 +101,9 @@ static void on_completed(qiniu_ng_upload_response_t upload_response, qiniu_ng_er
 #else
     pthread_mutex_lock(&mutex);
     (*context->completed)++;
+    if (skipped && context->skipped != NULL) {
+        (*context->skipped)++;
+    }
     pthread_mutex_unlock(&mutex);
 #endif
 }
@@ -136,19 +157,75 @@ void test_qiniu_ng_batch_upload_file_paths(void) {
     const qiniu_ng_char_t file_keys[FILES_COUNT][256];
     const qiniu_ng_char_t *file_paths[FILES_COUNT];
     struct callback_context contexts[FILES_COUNT];
-    char etags[FILES_COUNT][ETAG_SIZE + 1];
     int completed = 0;
     for (int i = 0; i < FILES_COUNT; i++) {
         generate_file_key(file_keys[i], 256, i, 17);
         file_paths[i] = create_temp_file(17 * 1024 * 1024 + i * 1024);
-        memset(&etags[i], 0, (ETAG_SIZE + 1) * sizeof(char));
+
+        contexts[i].file_index = i;
+        contexts[i].etag = NULL;
+        contexts[i].completed = &completed;
+        contexts[i].skipped = NULL;
+
+        qiniu_ng_batch_upload_params_t params = {
+            .key = file_keys[i],
+            .file_name = file_keys[i],
+            .on_uploading_progress = print_progress,
+            .on_completed = on_completed,
+            .callback_data = (void *) &contexts[i],
+            .local_etag_enabled = true,
+        };
         TEST_ASSERT_TRUE_MESSAGE(
-            qiniu_ng_etag_from_file_path(file_paths[i], (char *) &etags[i][0], NULL),
-            "qiniu_ng_etag_from_file_path() failed");
+            qiniu_ng_batch_uploader_upload_file_path(batch_uploader, file_paths[i], &params, NULL),
+            "qiniu_ng_batch_uploader_upload_file_path() failed");
+    }
+
+    qiniu_ng_batch_uploader_start(batch_uploader);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(completed, FILES_COUNT, "completed != FILES_COUNT");
+
+    for (int i = 0; i < FILES_COUNT; i++) {
+        DELETE_FILE(file_paths[i]);
+    }
+
+    upload_done();
+    qiniu_ng_batch_uploader_free(&batch_uploader);
+    qiniu_ng_config_free(&config);
+#undef FILES_COUNT
+}
+
+void test_qiniu_ng_batch_upload_file_paths_in_background(void) {
+#define FILES_COUNT (16)
+
+    qiniu_ng_config_t config = qiniu_ng_config_new_default();
+
+    env_load("..", false);
+    qiniu_ng_upload_policy_builder_t policy_builder = qiniu_ng_upload_policy_builder_new_for_bucket(BUCKET_NAME, config);
+    qiniu_ng_upload_policy_builder_set_insert_only(policy_builder);
+    qiniu_ng_upload_token_t token = qiniu_ng_upload_token_new_from_policy_builder(policy_builder, GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_upload_policy_builder_free(&policy_builder);
+    qiniu_ng_batch_uploader_t batch_uploader;
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_batch_uploader_new_from_config(token, config, &batch_uploader),
+        "qiniu_ng_batch_uploader_new_from_config() returns unexpected value"
+    );
+    qiniu_ng_batch_uploader_set_jobs_queue_capacity(batch_uploader, 4);
+    qiniu_ng_upload_token_free(&token);
+
+    prepare_for_uploading();
+    qiniu_ng_batch_uploader_spawn(batch_uploader);
+
+    const qiniu_ng_char_t file_keys[FILES_COUNT][256];
+    const qiniu_ng_char_t *file_paths[FILES_COUNT];
+    struct callback_context contexts[FILES_COUNT];
+    int completed = 0;
+    for (int i = 0; i < FILES_COUNT; i++) {
+        generate_file_key(file_keys[i], 256, i, 5);
+        file_paths[i] = create_temp_file(5 * 1024 * 1024 + i * 1024);
 
         contexts[i].file_index = i;
-        contexts[i].etag = &etags[i][0];
+        contexts[i].etag = NULL;
         contexts[i].completed = &completed;
+        contexts[i].skipped = NULL;
 
         qiniu_ng_batch_upload_params_t params = {
             .key = file_keys[i],
@@ -156,6 +233,72 @@ void test_qiniu_ng_batch_upload_file_paths(void) {
             .on_uploading_progress = print_progress,
             .on_completed = on_completed,
             .callback_data = (void *) &contexts[i],
+            .local_etag_enabled = true,
+        };
+        TEST_ASSERT_TRUE_MESSAGE(
+            qiniu_ng_batch_uploader_upload_file_path(batch_uploader, file_paths[i], &params, NULL),
+            "qiniu_ng_batch_uploader_upload_file_path() failed");
+        if (i == FILES_COUNT / 2 - 1) {
+            qiniu_ng_batch_uploader_drain(batch_uploader);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(completed, FILES_COUNT / 2, "completed != FILES_COUNT / 2");
+        }
+    }
+
+    qiniu_ng_batch_uploader_shutdown(batch_uploader);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(completed, FILES_COUNT, "completed != FILES_COUNT");
+
+    for (int i = 0; i < FILES_COUNT; i++) {
+        DELETE_FILE(file_paths[i]);
+    }
+
+    upload_done();
+    qiniu_ng_batch_uploader_free(&batch_uploader);
+    qiniu_ng_config_free(&config);
+#undef FILES_COUNT
+}
+
+void test_qiniu_ng_batch_upload_file_paths_with_callback_queue(void) {
+#define FILES_COUNT (8)
+#define EVENTS_SIZE (4)
+
+    qiniu_ng_config_t config = qiniu_ng_config_new_default();
+
+    env_load("..", false);
+    qiniu_ng_upload_policy_builder_t policy_builder = qiniu_ng_upload_policy_builder_new_for_bucket(BUCKET_NAME, config);
+    qiniu_ng_upload_policy_builder_set_insert_only(policy_builder);
+    qiniu_ng_upload_token_t token = qiniu_ng_upload_token_new_from_policy_builder(policy_builder, GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_upload_policy_builder_free(&policy_builder);
+    qiniu_ng_batch_uploader_t batch_uploader;
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_batch_uploader_new_from_config(token, config, &batch_uploader),
+        "qiniu_ng_batch_uploader_new_from_config() returns unexpected value"
+    );
+    qiniu_ng_batch_uploader_use_shared_thread_pool(batch_uploader, true);
+    qiniu_ng_upload_token_free(&token);
+
+    prepare_for_uploading();
+
+    qiniu_ng_callback_queue_t callback_queue = qiniu_ng_callback_queue_new();
+    const qiniu_ng_char_t file_keys[FILES_COUNT][256];
+    const qiniu_ng_char_t *file_paths[FILES_COUNT];
+    struct callback_context contexts[FILES_COUNT];
+    int completed = 0;
+    for (int i = 0; i < FILES_COUNT; i++) {
+        generate_file_key(file_keys[i], 256, i, 5);
+        file_paths[i] = create_temp_file(5 * 1024 * 1024 + i * 1024);
+
+        contexts[i].file_index = i;
+        contexts[i].etag = NULL;
+        contexts[i].completed = &completed;
+        contexts[i].skipped = NULL;
+
+        qiniu_ng_batch_upload_params_t params = {
+            .key = file_keys[i],
+            .file_name = file_keys[i],
+            .callback_data = (void *) &contexts[i],
+            .on_uploading_progress = print_progress,
+            .local_etag_enabled = true,
+            .callback_queue = callback_queue,
         };
         TEST_ASSERT_TRUE_MESSAGE(
             qiniu_ng_batch_uploader_upload_file_path(batch_uploader, file_paths[i], &params, NULL),
@@ -163,15 +306,41 @@ void test_qiniu_ng_batch_upload_file_paths(void) {
     }
 
     qiniu_ng_batch_uploader_start(batch_uploader);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(completed, 0, "completed != 0");
+    TEST_ASSERT_FALSE_MESSAGE(
+        qiniu_ng_callback_queue_is_finished(callback_queue),
+        "qiniu_ng_callback_queue_is_finished() returns unexpected value");
+    qiniu_ng_callback_queue_close(callback_queue);
+
+    qiniu_ng_callback_event_t events[EVENTS_SIZE];
+    size_t events_count;
+    while ((events_count = qiniu_ng_callback_queue_pop(callback_queue, &events[0], EVENTS_SIZE, 0)) > 0) {
+        for (size_t i = 0; i < events_count; i++) {
+            switch (events[i].kind) {
+            case qiniu_ng_callback_event_uploading_progress:
+                TEST_ASSERT_TRUE_MESSAGE(events[i].uploaded <= events[i].total, "uploaded > total");
+                print_progress(events[i].uploaded, events[i].total, events[i].callback_data);
+                break;
+            case qiniu_ng_callback_event_completed:
+                on_completed(events[i].response, events[i].err, events[i].callback_data);
+                break;
+            }
+        }
+    }
     TEST_ASSERT_EQUAL_INT_MESSAGE(completed, FILES_COUNT, "completed != FILES_COUNT");
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_callback_queue_is_finished(callback_queue),
+        "qiniu_ng_callback_queue_is_finished() returns unexpected value");
 
     for (int i = 0; i < FILES_COUNT; i++) {
         DELETE_FILE(file_paths[i]);
     }
 
     upload_done();
+    qiniu_ng_callback_queue_free(&callback_queue);
     qiniu_ng_batch_uploader_free(&batch_uploader);
     qiniu_ng_config_free(&config);
+#undef EVENTS_SIZE
 #undef FILES_COUNT
 }
 
@@ -191,6 +360,8 @@ void test_qiniu_ng_batch_upload_files(void) {
         "qiniu_ng_batch_uploader_new_from_config() returns unexpected value"
     );
     qiniu_ng_batch_uploader_set_expected_jobs_count(batch_uploader, FILES_COUNT);
+    qiniu_ng_batch_uploader_set_max_in_flight_bytes(batch_uploader, 64 * 1024 * 1024);
+    qiniu_ng_batch_uploader_set_fairness_policy(batch_uploader, qiniu_ng_batch_upload_fairness_round_robin);
     qiniu_ng_upload_token_free(&token);
 
     prepare_for_uploading();
@@ -216,6 +387,7 @@ void test_qiniu_ng_batch_upload_files(void) {
         contexts[i].file_index = i;
         contexts[i].etag = &etags[i][0];
         contexts[i].completed = &completed;
+        contexts[i].skipped = NULL;
 
         qiniu_ng_batch_upload_params_t params = {
             .key = file_keys[i],
@@ -243,6 +415,86 @@ void test_qiniu_ng_batch_upload_files(void) {
 #undef FILES_COUNT
 }
 
+void test_qiniu_ng_batch_upload_file_paths_skip_if_exists(void) {
+#define FILES_COUNT (8)
+
+    qiniu_ng_config_t config = qiniu_ng_config_new_default();
+
+    env_load("..", false);
+    qiniu_ng_upload_policy_builder_t policy_builder = qiniu_ng_upload_policy_builder_new_for_bucket(BUCKET_NAME, config);
+    qiniu_ng_upload_token_t token = qiniu_ng_upload_token_new_from_policy_builder(policy_builder, GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_upload_policy_builder_free(&policy_builder);
+    qiniu_ng_batch_uploader_t batch_uploader;
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_batch_uploader_new_from_config(token, config, &batch_uploader),
+        "qiniu_ng_batch_uploader_new_from_config() returns unexpected value"
+    );
+    qiniu_ng_upload_token_free(&token);
+
+    qiniu_ng_client_t client = qiniu_ng_client_new_default(GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_bucket_t bucket = qiniu_ng_bucket_new(client, BUCKET_NAME);
+    qiniu_ng_bucket_batch_t bucket_batch = qiniu_ng_bucket_batch_new(bucket);
+    qiniu_ng_batch_uploader_skip_if_exists(batch_uploader, bucket_batch);
+    qiniu_ng_bucket_batch_free(&bucket_batch);
+    qiniu_ng_bucket_free(&bucket);
+    qiniu_ng_client_free(&client);
+
+    prepare_for_uploading();
+
+    const qiniu_ng_char_t file_keys[FILES_COUNT][256];
+    const qiniu_ng_char_t *file_paths[FILES_COUNT];
+    struct callback_context contexts[FILES_COUNT];
+    int completed = 0, skipped = 0;
+    for (int i = 0; i < FILES_COUNT; i++) {
+        generate_file_key(file_keys[i], 256, i, 1);
+        file_paths[i] = create_temp_file(1024 * 1024 + i * 1024);
+
+        contexts[i].file_index = i;
+        contexts[i].etag = NULL;
+        contexts[i].completed = &completed;
+        contexts[i].skipped = &skipped;
+    }
+
+    const qiniu_ng_char_t etag_cache_path[512];
+#if defined(_WIN32) || defined(WIN32)
+    swprintf((wchar_t *) etag_cache_path, 512, L"%ls.etag_cache", (const wchar_t *) file_paths[0]);
+#else
+    snprintf((char *) etag_cache_path, 512, "%s.etag_cache", (const char *) file_paths[0]);
+#endif
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_batch_uploader_set_etag_cache_path(batch_uploader, etag_cache_path, NULL),
+        "qiniu_ng_batch_uploader_set_etag_cache_path() failed");
+
+    // 第一轮上传时对象均不存在，第二轮上传时对象均已存在且内容一致，将全部被跳过
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < FILES_COUNT; i++) {
+            qiniu_ng_batch_upload_params_t params = {
+                .key = file_keys[i],
+                .file_name = file_keys[i],
+                .on_completed = on_completed,
+                .callback_data = (void *) &contexts[i],
+                .local_etag_enabled = true,
+            };
+            TEST_ASSERT_TRUE_MESSAGE(
+                qiniu_ng_batch_uploader_upload_file_path(batch_uploader, file_paths[i], &params, NULL),
+                "qiniu_ng_batch_uploader_upload_file_path() failed");
+        }
+        qiniu_ng_batch_uploader_start(batch_uploader);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(completed, FILES_COUNT * (round + 1), "completed != FILES_COUNT * (round + 1)");
+        TEST_ASSERT_EQUAL_INT_MESSAGE(skipped, FILES_COUNT * round, "skipped != FILES_COUNT * round");
+    }
+
+    for (int i = 0; i < FILES_COUNT; i++) {
+        DELETE_FILE(file_paths[i]);
+    }
+    DELETE_FILE(etag_cache_path);
+
+    upload_done();
+    qiniu_ng_batch_uploader_free(&batch_uploader);
+    qiniu_ng_config_free(&config);
+#undef FILES_COUNT
+}
+
 void test_qiniu_ng_batch_upload_file_path_failed_by_mime(void) {
     qiniu_ng_config_t config = qiniu_ng_config_new_default();
 
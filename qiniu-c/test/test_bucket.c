@@ -55,6 +55,37 @@ void test_qiniu_ng_bucket_get_region(void) {
     qiniu_ng_client_free(&client);
 }
 
+void test_qiniu_ng_bucket_prefetch(void) {
+    env_load("..", false);
+    qiniu_ng_client_t client = qiniu_ng_client_new_default(GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    const qiniu_ng_char_t *bucket_names[] = {QINIU_NG_CHARS("z0-bucket"), QINIU_NG_CHARS("z1-bucket"), QINIU_NG_CHARS("z2-bucket")};
+
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_bucket_prefetch(client, bucket_names, 3, NULL),
+        "qiniu_ng_bucket_prefetch() failed");
+
+    qiniu_ng_bucket_t bucket = qiniu_ng_bucket_new(client, QINIU_NG_CHARS("z1-bucket"));
+    qiniu_ng_region_t region;
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_bucket_get_region(bucket, &region, NULL),
+        "qiniu_ng_bucket_get_region() failed");
+    qiniu_ng_str_list_t io_urls = qiniu_ng_region_get_io_urls(region, false);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(
+        qiniu_ng_str_list_get(io_urls, 0), QINIU_NG_CHARS("http://iovip-z1.qbox.me"),
+        "io_url != \"http://iovip-z1.qbox.me\"");
+
+    qiniu_ng_str_list_free(&io_urls);
+    qiniu_ng_region_free(&region);
+    qiniu_ng_bucket_free(&bucket);
+
+    const qiniu_ng_char_t *unexisted_bucket_names[] = {QINIU_NG_CHARS("z0-bucket"), QINIU_NG_CHARS("not-existed-bucket")};
+    TEST_ASSERT_FALSE_MESSAGE(
+        qiniu_ng_bucket_prefetch(client, unexisted_bucket_names, 2, NULL),
+        "qiniu_ng_bucket_prefetch() returns unexpected value");
+
+    qiniu_ng_client_free(&client);
+}
+
 void test_qiniu_ng_bucket_get_unexisted_region(void) {
     env_load("..", false);
     qiniu_ng_client_t client = qiniu_ng_client_new_default(GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
@@ -289,3 +320,114 @@ void test_qiniu_ng_bucket_get_regions_and_domains(void) {
     qiniu_ng_bucket_free(&bucket);
     qiniu_ng_client_free(&client);
 }
+
+void test_qiniu_ng_bucket_get_domains_in_arena(void) {
+    env_load("..", false);
+    qiniu_ng_client_t client = qiniu_ng_client_new_default(GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_bucket_t bucket = qiniu_ng_bucket_new(client, QINIU_NG_CHARS("z0-bucket"));
+    qiniu_ng_arena_t arena = qiniu_ng_arena_new(0);
+
+    qiniu_ng_arena_str_list_t domains;
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_bucket_get_domains_in_arena(bucket, arena, &domains, NULL),
+        "qiniu_ng_bucket_get_domains_in_arena() failed");
+    qiniu_ng_bucket_free(&bucket);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        domains.len, 2,
+        "domains.len != 2");
+    for (size_t i = 0; i < domains.len; i++) {
+        TEST_ASSERT_NOT_NULL_MESSAGE(
+            domains.items[i],
+            "domains.items[i] == null");
+    }
+
+    qiniu_ng_arena_free(&arena);
+    qiniu_ng_client_free(&client);
+}
+
+static bool test_qiniu_ng_bucket_batch_stat_callback(size_t index, const qiniu_ng_object_stat_t *stat, qiniu_ng_err_t err, void *data) {
+    uint16_t status_code;
+    TEST_ASSERT_NULL_MESSAGE(
+        stat,
+        "stat != null");
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_err_response_status_code_error_extract(&err, &status_code, NULL),
+        "qiniu_ng_err_response_status_code_error_extract() failed");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        status_code, 612,
+        "status_code != 612");
+    ((bool *) data)[index] = true;
+    return true;
+}
+
+void test_qiniu_ng_bucket_batch_stat_unexisted_keys(void) {
+    env_load("..", false);
+    qiniu_ng_client_t client = qiniu_ng_client_new_default(GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_bucket_t bucket = qiniu_ng_bucket_new(client, QINIU_NG_CHARS("z0-bucket"));
+    qiniu_ng_bucket_batch_t batch = qiniu_ng_bucket_batch_new(bucket);
+    qiniu_ng_bucket_free(&bucket);
+
+    qiniu_ng_bucket_batch_set_batch_size(batch, 2);
+    qiniu_ng_bucket_batch_set_concurrency(batch, 2);
+    qiniu_ng_bucket_batch_set_thread_pool_size(batch, 2);
+    qiniu_ng_bucket_batch_stat(batch, QINIU_NG_CHARS("unexisted-key-0"));
+    qiniu_ng_bucket_batch_stat(batch, QINIU_NG_CHARS("unexisted-key-1"));
+    qiniu_ng_bucket_batch_stat(batch, QINIU_NG_CHARS("unexisted-key-2"));
+    qiniu_ng_bucket_batch_stat(batch, QINIU_NG_CHARS("unexisted-key-3"));
+    qiniu_ng_bucket_batch_stat(batch, QINIU_NG_CHARS("unexisted-key-4"));
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        qiniu_ng_bucket_batch_len(batch), 5,
+        "qiniu_ng_bucket_batch_len(batch) != 5");
+
+    bool completed[5] = {false};
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        qiniu_ng_bucket_batch_execute(batch, test_qiniu_ng_bucket_batch_stat_callback, completed), 5,
+        "qiniu_ng_bucket_batch_execute() != 5");
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE_MESSAGE(
+            completed[i],
+            "completed[i] != true");
+    }
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        qiniu_ng_bucket_batch_len(batch), 0,
+        "qiniu_ng_bucket_batch_len(batch) != 0");
+
+    qiniu_ng_bucket_batch_free(&batch);
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_bucket_batch_is_freed(batch),
+        "qiniu_ng_bucket_batch_is_freed() failed");
+    qiniu_ng_client_free(&client);
+}
+
+void test_qiniu_ng_bucket_batch_stat_unexisted_keys_in_arena(void) {
+    env_load("..", false);
+    qiniu_ng_client_t client = qiniu_ng_client_new_default(GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_bucket_t bucket = qiniu_ng_bucket_new(client, QINIU_NG_CHARS("z0-bucket"));
+    qiniu_ng_bucket_batch_t batch = qiniu_ng_bucket_batch_new(bucket);
+    qiniu_ng_bucket_free(&bucket);
+    qiniu_ng_arena_t arena = qiniu_ng_arena_new(0);
+
+    qiniu_ng_bucket_batch_set_batch_size(batch, 2);
+    qiniu_ng_bucket_batch_set_concurrency(batch, 2);
+    qiniu_ng_bucket_batch_stat(batch, QINIU_NG_CHARS("unexisted-key-0"));
+    qiniu_ng_bucket_batch_stat(batch, QINIU_NG_CHARS("unexisted-key-1"));
+    qiniu_ng_bucket_batch_stat(batch, QINIU_NG_CHARS("unexisted-key-2"));
+
+    qiniu_ng_arena_str_list_t results = qiniu_ng_bucket_batch_execute_in_arena(batch, arena);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        results.len, 3,
+        "results.len != 3");
+    for (size_t i = 0; i < results.len; i++) {
+        TEST_ASSERT_NULL_MESSAGE(
+            results.items[i],
+            "results.items[i] != null");
+    }
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        qiniu_ng_bucket_batch_len(batch), 0,
+        "qiniu_ng_bucket_batch_len(batch) != 0");
+
+    qiniu_ng_arena_reset(arena);
+    qiniu_ng_arena_free(&arena);
+    qiniu_ng_bucket_batch_free(&batch);
+    qiniu_ng_client_free(&client);
+}
@@ -28,6 +28,15 @@ void test_qiniu_ng_config_new(void) {
     TEST_ASSERT_EQUAL_INT_MESSAGE(
         qiniu_ng_config_get_upload_threshold(config), 1 << 22,
         "qiniu_ng_config_get_upload_threshold() returns unexpected value");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        qiniu_ng_config_get_upload_buffer_pool_max_size(config), 1 << 28,
+        "qiniu_ng_config_get_upload_buffer_pool_max_size() returns unexpected value");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        qiniu_ng_config_get_http_request_hedge_delay(config), 0,
+        "qiniu_ng_config_get_http_request_hedge_delay() returns unexpected value");
+    TEST_ASSERT_FALSE_MESSAGE(
+        qiniu_ng_config_get_http_connection_stats(config, QINIU_NG_CHARS("upload.qiniup.com"), NULL),
+        "qiniu_ng_config_get_http_connection_stats() returns unexpected value");
 
     qiniu_ng_str_t user_agent = qiniu_ng_config_get_user_agent(config);
     TEST_ASSERT_EQUAL_INT_MESSAGE(
@@ -65,12 +74,25 @@ void test_qiniu_ng_config_new(void) {
     TEST_ASSERT_EQUAL_UINT_MESSAGE(
         upload_threshold, 1 << 12,
         "upload_threshold != 1<<12");
+    size_t queue_capacity;
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_config_get_uplog_queue_capacity(config, &queue_capacity),
+        "qiniu_ng_config_get_uplog_queue_capacity() failed");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        queue_capacity, 0,
+        "queue_capacity != 0");
     TEST_ASSERT_EQUAL_UINT_MESSAGE(
         qiniu_ng_config_get_upload_recorder_upload_block_lifetime(config), 60 * 60 * 24 * 7,
         "qiniu_ng_config_get_upload_recorder_upload_block_lifetime() returns unexpected value");
     TEST_ASSERT_FALSE_MESSAGE(
         qiniu_ng_config_get_upload_recorder_always_flush_records(config),
         "qiniu_ng_config_get_upload_recorder_always_flush_records() returns unexpected value");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        qiniu_ng_config_get_upload_recorder_flush_every_parts(config), 16,
+        "qiniu_ng_config_get_upload_recorder_flush_every_parts() returns unexpected value");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        qiniu_ng_config_get_upload_recorder_flush_interval(config), 1000,
+        "qiniu_ng_config_get_upload_recorder_flush_interval() returns unexpected value");
 
     TEST_ASSERT_EQUAL_UINT_MESSAGE(
         qiniu_ng_config_get_domains_manager_resolutions_cache_lifetime(config), 60 * 60,
@@ -81,10 +103,30 @@ void test_qiniu_ng_config_new(void) {
     TEST_ASSERT_FALSE_MESSAGE(
         qiniu_ng_config_get_domains_manager_auto_persistent_disabled(config),
         "qiniu_ng_config_get_domains_manager_auto_persistent_disabled() returns unexpected value");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        qiniu_ng_config_get_domains_manager_resolve_timeout(config), 5000,
+        "qiniu_ng_config_get_domains_manager_resolve_timeout() returns unexpected value");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        qiniu_ng_config_get_domains_manager_negative_resolutions_cache_lifetime(config), 10,
+        "qiniu_ng_config_get_domains_manager_negative_resolutions_cache_lifetime() returns unexpected value");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        qiniu_ng_config_get_domains_manager_socket_addr_probe_interval(config), 0,
+        "qiniu_ng_config_get_domains_manager_socket_addr_probe_interval() returns unexpected value");
+    TEST_ASSERT_FALSE_MESSAGE(
+        qiniu_ng_config_get_domains_manager_socket_addr_stats_persistence_disabled(config),
+        "qiniu_ng_config_get_domains_manager_socket_addr_stats_persistence_disabled() returns unexpected value");
 
     qiniu_ng_config_free(&config);
 }
 
+static qiniu_ng_str_list_t resolve_to_localhost(const qiniu_ng_char_t *host, uint16_t port, void *data) {
+    const qiniu_ng_char_t *ips[1] = { QINIU_NG_CHARS("127.0.0.1") };
+    (void) host;
+    (void) port;
+    (void) data;
+    return qiniu_ng_str_list_new(ips, 1);
+}
+
 void test_qiniu_ng_config_new2(void) {
     qiniu_ng_config_builder_t builder = qiniu_ng_config_builder_new();
 
@@ -92,10 +134,14 @@ void test_qiniu_ng_config_new2(void) {
     qiniu_ng_config_builder_use_https(builder, false);
     qiniu_ng_config_builder_batch_max_operation_size(builder, 10000);
     qiniu_ng_config_builder_upload_threshold(builder, 1 << 23);
+    qiniu_ng_config_builder_upload_buffer_pool_max_size(builder, 1 << 24);
+    qiniu_ng_config_builder_http_request_hedge_delay(builder, 300);
     qiniu_ng_config_builder_uc_host(builder, QINIU_NG_CHARS("uc.qiniu.com"));
     qiniu_ng_config_builder_disable_uplog(builder);
     qiniu_ng_config_builder_upload_recorder_upload_block_lifetime(builder, 60 * 60 * 24 * 5);
     qiniu_ng_config_builder_upload_recorder_always_flush_records(builder, true);
+    qiniu_ng_config_builder_upload_recorder_flush_every_parts(builder, 4);
+    qiniu_ng_config_builder_upload_recorder_flush_interval(builder, 500);
 #if defined(_WIN32) || defined(WIN32)
     const qiniu_ng_char_t *home_directory = GETENV(QINIU_NG_CHARS("USERPROFILE"));
 #else
@@ -109,6 +155,11 @@ void test_qiniu_ng_config_new2(void) {
     free(temp_file);
     qiniu_ng_config_builder_domains_manager_url_frozen_duration(builder, 60 * 60 * 24);
     qiniu_ng_config_builder_domains_manager_disable_auto_persistent(builder);
+    qiniu_ng_config_builder_domains_manager_socket_addr_probe_interval(builder, 5 * 60);
+    qiniu_ng_config_builder_domains_manager_disable_socket_addr_stats_persistence(builder);
+    qiniu_ng_config_builder_domains_manager_resolve_timeout(builder, 500);
+    qiniu_ng_config_builder_domains_manager_negative_resolutions_cache_lifetime(builder, 30);
+    qiniu_ng_config_builder_domains_manager_set_resolver(builder, resolve_to_localhost, NULL);
 
     qiniu_ng_config_t config;
     TEST_ASSERT_TRUE_MESSAGE(
@@ -127,6 +178,12 @@ void test_qiniu_ng_config_new2(void) {
     TEST_ASSERT_EQUAL_INT_MESSAGE(
         qiniu_ng_config_get_upload_threshold(config), 1 << 23,
         "qiniu_ng_config_get_upload_threshold() returns unexpected value");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        qiniu_ng_config_get_upload_buffer_pool_max_size(config), 1 << 24,
+        "qiniu_ng_config_get_upload_buffer_pool_max_size() returns unexpected value");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        qiniu_ng_config_get_http_request_hedge_delay(config), 300,
+        "qiniu_ng_config_get_http_request_hedge_delay() returns unexpected value");
 
     qiniu_ng_str_t user_agent = qiniu_ng_config_get_user_agent(config);
     TEST_ASSERT_EQUAL_INT_MESSAGE(
@@ -175,6 +232,12 @@ void test_qiniu_ng_config_new2(void) {
     TEST_ASSERT_TRUE_MESSAGE(
         qiniu_ng_config_get_upload_recorder_always_flush_records(config),
         "qiniu_ng_config_get_upload_recorder_always_flush_records() returns unexpected value");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        qiniu_ng_config_get_upload_recorder_flush_every_parts(config), 4,
+        "qiniu_ng_config_get_upload_recorder_flush_every_parts() returns unexpected value");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        qiniu_ng_config_get_upload_recorder_flush_interval(config), 500,
+        "qiniu_ng_config_get_upload_recorder_flush_interval() returns unexpected value");
 
     TEST_ASSERT_EQUAL_UINT_MESSAGE(
         qiniu_ng_config_get_domains_manager_url_frozen_duration(config), 60 * 60 * 24,
@@ -185,7 +248,94 @@ void test_qiniu_ng_config_new2(void) {
     TEST_ASSERT_TRUE_MESSAGE(
         qiniu_ng_config_get_domains_manager_auto_persistent_disabled(config),
         "qiniu_ng_config_get_domains_manager_auto_persistent_disabled() returns unexpected value");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        qiniu_ng_config_get_domains_manager_resolve_timeout(config), 500,
+        "qiniu_ng_config_get_domains_manager_resolve_timeout() returns unexpected value");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        qiniu_ng_config_get_domains_manager_negative_resolutions_cache_lifetime(config), 30,
+        "qiniu_ng_config_get_domains_manager_negative_resolutions_cache_lifetime() returns unexpected value");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        qiniu_ng_config_get_domains_manager_socket_addr_probe_interval(config), 5 * 60,
+        "qiniu_ng_config_get_domains_manager_socket_addr_probe_interval() returns unexpected value");
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_config_get_domains_manager_socket_addr_stats_persistence_disabled(config),
+        "qiniu_ng_config_get_domains_manager_socket_addr_stats_persistence_disabled() returns unexpected value");
+
+    qiniu_ng_config_free(&config);
+}
+
+void test_qiniu_ng_config_http_connection_reuse(void) {
+    env_load("..", false);
+    qiniu_ng_config_builder_t builder = qiniu_ng_config_builder_new();
+    qiniu_ng_config_builder_http_pool_size(builder, 4);
+    qiniu_ng_config_builder_http2(builder, true);
+    qiniu_ng_config_builder_http_tls_session_reuse(builder, true);
+    qiniu_ng_config_builder_http_max_connection_stats_hosts(builder, 8);
+
+    qiniu_ng_config_t config;
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_config_build(&builder, &config, NULL),
+        "qiniu_ng_config_build() failed");
+    TEST_ASSERT_FALSE_MESSAGE(
+        qiniu_ng_config_get_http_connection_stats(config, QINIU_NG_CHARS("rs.qbox.me"), NULL),
+        "qiniu_ng_config_get_http_connection_stats() returns unexpected value");
+
+    qiniu_ng_client_t client = qiniu_ng_client_new(GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")), config);
+    for (int i = 0; i < 2; i++) {
+        qiniu_ng_str_list_t bucket_names;
+        TEST_ASSERT_TRUE_MESSAGE(
+            qiniu_ng_storage_bucket_names(client, &bucket_names, NULL),
+            "qiniu_ng_storage_bucket_names() failed");
+        qiniu_ng_str_list_free(&bucket_names);
+    }
+
+    qiniu_ng_http_connection_stats_t stats;
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_config_get_http_connection_stats(config, QINIU_NG_CHARS("rs.qbox.me"), &stats),
+        "qiniu_ng_config_get_http_connection_stats() returns unexpected value");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        stats.connections_opened, 1,
+        "stats.connections_opened != 1");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        stats.connections_reused, 1,
+        "stats.connections_reused != 1");
+
+    qiniu_ng_client_free(&client);
+    qiniu_ng_config_free(&config);
+}
 
+void test_qiniu_ng_config_http_multi_engine(void) {
+    env_load("..", false);
+    qiniu_ng_config_builder_t builder = qiniu_ng_config_builder_new();
+    qiniu_ng_config_builder_http_multi_engine(builder, 1, 4);
+    qiniu_ng_config_builder_http2(builder, true);
+
+    qiniu_ng_config_t config;
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_config_build(&builder, &config, NULL),
+        "qiniu_ng_config_build() failed");
+
+    qiniu_ng_client_t client = qiniu_ng_client_new(GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")), config);
+    for (int i = 0; i < 2; i++) {
+        qiniu_ng_str_list_t bucket_names;
+        TEST_ASSERT_TRUE_MESSAGE(
+            qiniu_ng_storage_bucket_names(client, &bucket_names, NULL),
+            "qiniu_ng_storage_bucket_names() failed");
+        qiniu_ng_str_list_free(&bucket_names);
+    }
+
+    qiniu_ng_http_connection_stats_t stats;
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_config_get_http_connection_stats(config, QINIU_NG_CHARS("rs.qbox.me"), &stats),
+        "qiniu_ng_config_get_http_connection_stats() returns unexpected value");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        stats.connections_opened + stats.connections_reused, 2,
+        "stats.connections_opened + stats.connections_reused != 2");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(
+        stats.connections_reused, 1,
+        "stats.connections_reused != 1");
+
+    qiniu_ng_client_free(&client);
     qiniu_ng_config_free(&config);
 }
 
@@ -27,6 +27,34 @@ void test_qiniu_ng_etag_from_file_path(void) {
     free(path);
 }
 
+void test_qiniu_ng_etag_from_file_path_parallel(void) {
+    char etag[ETAG_SIZE + 1], etag_parallel[ETAG_SIZE + 1];
+    memset(&etag, 0, (ETAG_SIZE + 1) * sizeof(char));
+    memset(&etag_parallel, 0, (ETAG_SIZE + 1) * sizeof(char));
+
+    qiniu_ng_char_t *file_path = create_temp_file(17 * 1024 * 1024 + 1);
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_etag_from_file_path(file_path, (char *) &etag, NULL),
+        "qiniu_ng_etag_from_file_path() failed");
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_etag_from_file_path_parallel(file_path, 4, (char *) &etag_parallel, NULL),
+        "qiniu_ng_etag_from_file_path_parallel() failed");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(
+        (const char *) &etag_parallel, (const char *) &etag,
+        "etag_parallel != etag");
+
+    memset(&etag_parallel, 0, (ETAG_SIZE + 1) * sizeof(char));
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_etag_from_file_path_parallel(file_path, 0, (char *) &etag_parallel, NULL),
+        "qiniu_ng_etag_from_file_path_parallel() failed");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(
+        (const char *) &etag_parallel, (const char *) &etag,
+        "etag_parallel != etag");
+
+    DELETE_FILE(file_path);
+    free(file_path);
+}
+
 void test_qiniu_ng_etag_from_data(void) {
     char etag[ETAG_SIZE + 1];
     memset(&etag, 0, (ETAG_SIZE + 1) * sizeof(char));
@@ -1,4 +1,5 @@
 #include "unity.h"
+#include <string.h>
 #include "libqiniu_ng.h"
 #include "test.h"
 
@@ -64,6 +65,25 @@ void test_qiniu_ng_region_get_by_id(void) {
     TEST_ASSERT_EQUAL_STRING_MESSAGE(
         qiniu_ng_region_id_name(id), "z0",
         "qiniu_ng_region_id_name(id) != \"z0\"");
+
+    qiniu_ng_str_view_t views[2];
+    size_t views_len = qiniu_ng_region_get_io_urls_view(region, true, views, 2);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        views_len, 1,
+        "views_len != 1");
+    TEST_ASSERT_FALSE_MESSAGE(
+        qiniu_ng_str_view_is_null(views[0]),
+        "qiniu_ng_str_view_is_null(views[0]) failed");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        views[0].len, strlen("https://iovip.qbox.me"),
+        "views[0].len != strlen(\"https://iovip.qbox.me\")");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        strncmp(views[0].ptr, "https://iovip.qbox.me", views[0].len), 0,
+        "views[0] != \"https://iovip.qbox.me\"");
+    views_len = qiniu_ng_region_get_up_urls_view(region, true, NULL, 0);
+    TEST_ASSERT_GREATER_THAN_MESSAGE(
+        0, views_len,
+        "views_len <= 0");
     qiniu_ng_region_free(&region);
 
     region = qiniu_ng_region_get_by_id(qiniu_ng_region_na0);
@@ -75,3 +95,33 @@ void test_qiniu_ng_region_get_by_id(void) {
         "qiniu_ng_region_id_name(id) != \"na0\"");
     qiniu_ng_region_free(&region);
 }
+
+void test_qiniu_ng_region_get_urls_in_arena(void) {
+    qiniu_ng_arena_t arena = qiniu_ng_arena_new(0);
+    qiniu_ng_region_t region = qiniu_ng_region_get_by_id(qiniu_ng_region_z0);
+
+    qiniu_ng_arena_str_list_t urls = qiniu_ng_region_get_io_urls_in_arena(region, true, arena);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        urls.len, 1,
+        "urls.len != 1");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(
+        urls.items[0], QINIU_NG_CHARS("https://iovip.qbox.me"),
+        "urls.items[0] != \"https://iovip.qbox.me\"");
+
+    qiniu_ng_arena_str_list_t up_urls = qiniu_ng_region_get_up_urls_in_arena(region, false, arena);
+    TEST_ASSERT_GREATER_THAN_MESSAGE(
+        0, up_urls.len,
+        "up_urls.len <= 0");
+    for (size_t i = 0; i < up_urls.len; i++) {
+        TEST_ASSERT_NOT_NULL_MESSAGE(
+            QINIU_NG_CHARS_STR(up_urls.items[i], QINIU_NG_CHARS("http://")),
+            "up_urls.items[i] is not a HTTP URL");
+    }
+    qiniu_ng_region_free(&region);
+
+    // 区域实例释放后，内存池中的 URL 列表依然有效
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(
+        urls.items[0], QINIU_NG_CHARS("https://iovip.qbox.me"),
+        "urls.items[0] != \"https://iovip.qbox.me\"");
+    qiniu_ng_arena_free(&arena);
+}
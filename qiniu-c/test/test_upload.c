@@ -33,6 +33,7 @@ static void print_progress(uint64_t uploaded, uint64_t total, void* data) {
 }
 #else
 #include <unistd.h>
+#include <poll.h>
 #include <stdatomic.h>
 #include <pthread.h>
 static pthread_mutex_t mutex;
@@ -194,6 +195,7 @@ void test_qiniu_ng_bucket_uploader_upload_files(void) {
         .key = (const qiniu_ng_char_t *) &file_key[0],
         .file_name = (const qiniu_ng_char_t *) &file_key[0],
         .on_uploading_progress = print_progress,
+        .memory_mapping_enabled = true,
     };
     qiniu_ng_upload_response_t upload_response;
     qiniu_ng_err_t err;
@@ -224,6 +226,7 @@ void test_qiniu_ng_bucket_uploader_upload_files(void) {
 
     last_print_time = (long long) time(NULL);
     generate_file_key(file_key, 256, 1, 259);
+    params.adaptive_part_size_enabled = true;
 
     FILE *file = OPEN_FILE_FOR_READING(file_path);
     TEST_ASSERT_NOT_NULL_MESSAGE(file, "file == null");
@@ -264,6 +267,209 @@ void test_qiniu_ng_bucket_uploader_upload_files(void) {
     qiniu_ng_config_free(&config);
 }
 
+void test_qiniu_ng_bucket_uploader_upload_file_path_async(void) {
+    qiniu_ng_config_t config = qiniu_ng_config_new_default();
+
+    env_load("..", false);
+    qiniu_ng_upload_manager_t upload_manager = qiniu_ng_upload_manager_new(config);
+    qiniu_ng_bucket_uploader_t bucket_uploader = qiniu_ng_bucket_uploader_new_from_bucket_name(
+        upload_manager, BUCKET_NAME, GETENV(QINIU_NG_CHARS("access_key")), 5);
+
+    const qiniu_ng_char_t file_key[256];
+    generate_file_key(file_key, 256, 0, 11);
+
+    const qiniu_ng_char_t *file_path = create_temp_file(11 * 1024 * 1024);
+    char etag[ETAG_SIZE + 1];
+    memset(&etag, 0, (ETAG_SIZE + 1) * sizeof(char));
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_etag_from_file_path(file_path, (char *) &etag[0], NULL),
+        "qiniu_ng_etag_from_file_path() failed");
+
+    qiniu_ng_upload_policy_builder_t policy_builder = qiniu_ng_upload_policy_builder_new_for_bucket(BUCKET_NAME, config);
+    qiniu_ng_upload_policy_builder_set_insert_only(policy_builder);
+    qiniu_ng_upload_token_t token = qiniu_ng_upload_token_new_from_policy_builder(policy_builder, GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_upload_policy_builder_free(&policy_builder);
+
+    prepare_for_uploading();
+    qiniu_ng_upload_params_t params = {
+        .key = (const qiniu_ng_char_t *) &file_key[0],
+        .file_name = (const qiniu_ng_char_t *) &file_key[0],
+        .on_uploading_progress = print_progress,
+    };
+    qiniu_ng_upload_handle_t upload_handle;
+    qiniu_ng_err_t err;
+    if (!qiniu_ng_bucket_uploader_upload_file_path_async(bucket_uploader, token, file_path, &params, &upload_handle, &err)) {
+        qiniu_ng_err_fputs(err, stderr);
+        TEST_FAIL_MESSAGE("qiniu_ng_bucket_uploader_upload_file_path_async() failed");
+    }
+
+#if defined(_WIN32) || defined(WIN32)
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        qiniu_ng_upload_handle_get_fd(upload_handle), -1,
+        "qiniu_ng_upload_handle_get_fd() != -1");
+    while (!qiniu_ng_upload_handle_poll(upload_handle)) {
+        Sleep(100);
+    }
+#else
+    struct pollfd pfd = {
+        .fd = qiniu_ng_upload_handle_get_fd(upload_handle),
+        .events = POLLIN,
+    };
+    TEST_ASSERT_TRUE_MESSAGE(pfd.fd >= 0, "qiniu_ng_upload_handle_get_fd() < 0");
+    while (poll(&pfd, 1, 1000) == 0) {
+        TEST_ASSERT_FALSE_MESSAGE(
+            qiniu_ng_upload_handle_poll(upload_handle),
+            "qiniu_ng_upload_handle_poll() returns true before fd is readable");
+    }
+    TEST_ASSERT_TRUE_MESSAGE(pfd.revents & POLLIN, "fd is not readable");
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_upload_handle_poll(upload_handle),
+        "qiniu_ng_upload_handle_poll() returns false after fd is readable");
+#endif
+
+    qiniu_ng_upload_response_t upload_response;
+    if (!qiniu_ng_upload_handle_wait(upload_handle, &upload_response, &err)) {
+        qiniu_ng_err_fputs(err, stderr);
+        TEST_FAIL_MESSAGE("qiniu_ng_upload_handle_wait() failed");
+    }
+    qiniu_ng_upload_handle_free(&upload_handle);
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_upload_handle_is_freed(upload_handle),
+        "qiniu_ng_upload_handle_is_freed() failed");
+
+    char hash[ETAG_SIZE + 1];
+    size_t hash_size;
+    memset(hash, 0, ETAG_SIZE + 1);
+    qiniu_ng_upload_response_get_hash(upload_response, (char *) &hash[0], &hash_size);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        hash_size, ETAG_SIZE,
+        "hash_size != ETAG_SIZE");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(
+        hash, (const char *) &etag,
+        "hash != etag");
+
+    qiniu_ng_upload_response_free(&upload_response);
+    // TODO: Clean uploaded file
+
+    generate_file_key(file_key, 256, 1, 11);
+    if (!qiniu_ng_bucket_uploader_upload_file_path_async(bucket_uploader, token, file_path, &params, &upload_handle, &err)) {
+        qiniu_ng_err_fputs(err, stderr);
+        TEST_FAIL_MESSAGE("qiniu_ng_bucket_uploader_upload_file_path_async() failed");
+    }
+    qiniu_ng_upload_handle_cancel(upload_handle);
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_upload_handle_poll(upload_handle),
+        "qiniu_ng_upload_handle_poll() returns false after canceled");
+    TEST_ASSERT_FALSE_MESSAGE(
+        qiniu_ng_upload_handle_wait(upload_handle, NULL, &err),
+        "qiniu_ng_upload_handle_wait() returns unexpected value");
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_err_user_canceled_error_extract(&err),
+        "qiniu_ng_err_user_canceled_error_extract() failed");
+    qiniu_ng_upload_handle_free(&upload_handle);
+
+    TEST_ASSERT_FALSE_MESSAGE(
+        qiniu_ng_bucket_uploader_upload_file_path_async(bucket_uploader, token, file_path, &params, NULL, &err),
+        "qiniu_ng_bucket_uploader_upload_file_path_async() returns true without upload_handle");
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_err_io_error_extract(&err, NULL),
+        "qiniu_ng_err_io_error_extract() failed");
+
+    upload_done();
+    qiniu_ng_upload_token_free(&token);
+
+    DELETE_FILE(file_path);
+    free((void *) file_path);
+
+    qiniu_ng_bucket_uploader_free(&bucket_uploader);
+    qiniu_ng_upload_manager_free(&upload_manager);
+    qiniu_ng_config_free(&config);
+}
+
+void test_qiniu_ng_bucket_uploader_upload_file_path_throttled_and_canceled(void) {
+    qiniu_ng_config_t config = qiniu_ng_config_new_default();
+
+    env_load("..", false);
+    qiniu_ng_upload_manager_t upload_manager = qiniu_ng_upload_manager_new(config);
+    qiniu_ng_bandwidth_limiter_t bandwidth_limiter = qiniu_ng_bandwidth_limiter_new(1024 * 1024);
+    qiniu_ng_cancellation_token_t cancellation_token = qiniu_ng_cancellation_token_new();
+    qiniu_ng_bucket_uploader_params_t bucket_uploader_params = {
+        .thread_pool_size = 5,
+        .bandwidth_limiter = bandwidth_limiter,
+        .cancellation_token = cancellation_token,
+    };
+    qiniu_ng_bucket_uploader_t bucket_uploader = qiniu_ng_bucket_uploader_new_from_bucket_name_with_params(
+        upload_manager, BUCKET_NAME, GETENV(QINIU_NG_CHARS("access_key")), &bucket_uploader_params);
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_bandwidth_limiter_get_rate(bandwidth_limiter) == 1024 * 1024,
+        "qiniu_ng_bandwidth_limiter_get_rate() != 1024 * 1024");
+
+    const qiniu_ng_char_t file_key[256];
+    generate_file_key(file_key, 256, 0, 11);
+    const qiniu_ng_char_t *file_path = create_temp_file(11 * 1024 * 1024);
+
+    qiniu_ng_upload_policy_builder_t policy_builder = qiniu_ng_upload_policy_builder_new_for_bucket(BUCKET_NAME, config);
+    qiniu_ng_upload_policy_builder_set_insert_only(policy_builder);
+    qiniu_ng_upload_token_t token = qiniu_ng_upload_token_new_from_policy_builder(policy_builder, GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_upload_policy_builder_free(&policy_builder);
+
+    prepare_for_uploading();
+    qiniu_ng_upload_params_t params = {
+        .key = (const qiniu_ng_char_t *) &file_key[0],
+        .file_name = (const qiniu_ng_char_t *) &file_key[0],
+        .on_uploading_progress = print_progress,
+    };
+    qiniu_ng_upload_handle_t upload_handle;
+    qiniu_ng_err_t err;
+    if (!qiniu_ng_bucket_uploader_upload_file_path_async(bucket_uploader, token, file_path, &params, &upload_handle, &err)) {
+        qiniu_ng_err_fputs(err, stderr);
+        TEST_FAIL_MESSAGE("qiniu_ng_bucket_uploader_upload_file_path_async() failed");
+    }
+
+    // 限速为 1 MB/s 时上传 11 MB 的文件至少需要数秒，调低速率后取消，上传应当立即中止
+#if defined(_WIN32) || defined(WIN32)
+    Sleep(1000);
+#else
+    sleep(1);
+#endif
+    qiniu_ng_bandwidth_limiter_set_rate(bandwidth_limiter, 1024);
+    TEST_ASSERT_FALSE_MESSAGE(
+        qiniu_ng_upload_handle_poll(upload_handle),
+        "qiniu_ng_upload_handle_poll() returns true before canceled");
+    TEST_ASSERT_FALSE_MESSAGE(
+        qiniu_ng_cancellation_token_is_canceled(cancellation_token),
+        "qiniu_ng_cancellation_token_is_canceled() returns true before canceled");
+    qiniu_ng_cancellation_token_cancel(cancellation_token);
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_cancellation_token_is_canceled(cancellation_token),
+        "qiniu_ng_cancellation_token_is_canceled() returns false after canceled");
+    TEST_ASSERT_FALSE_MESSAGE(
+        qiniu_ng_upload_handle_wait(upload_handle, NULL, &err),
+        "qiniu_ng_upload_handle_wait() returns unexpected value");
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_err_user_canceled_error_extract(&err),
+        "qiniu_ng_err_user_canceled_error_extract() failed");
+    qiniu_ng_upload_handle_free(&upload_handle);
+
+    upload_done();
+    qiniu_ng_upload_token_free(&token);
+
+    DELETE_FILE(file_path);
+    free((void *) file_path);
+
+    qiniu_ng_bucket_uploader_free(&bucket_uploader);
+    qiniu_ng_cancellation_token_free(&cancellation_token);
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_cancellation_token_is_freed(cancellation_token),
+        "qiniu_ng_cancellation_token_is_freed() failed");
+    qiniu_ng_bandwidth_limiter_free(&bandwidth_limiter);
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_bandwidth_limiter_is_freed(bandwidth_limiter),
+        "qiniu_ng_bandwidth_limiter_is_freed() failed");
+    qiniu_ng_upload_manager_free(&upload_manager);
+    qiniu_ng_config_free(&config);
+}
+
 struct upload_file_thread_context {
     const qiniu_ng_char_t *key;
     const qiniu_ng_char_t *file_path;
@@ -403,6 +609,77 @@ void test_qiniu_ng_bucket_uploader_upload_huge_number_of_files(void) {
     qiniu_ng_config_free(&config);
 }
 
+static void unexpected_progress(uint64_t uploaded, uint64_t total, void* data) {
+    TEST_FAIL_MESSAGE("on_uploading_progress should not be called when callback_queue is set");
+}
+
+void test_qiniu_ng_bucket_uploader_upload_file_path_with_callback_queue(void) {
+    qiniu_ng_config_t config = qiniu_ng_config_new_default();
+
+    env_load("..", false);
+    qiniu_ng_upload_manager_t upload_manager = qiniu_ng_upload_manager_new(config);
+    qiniu_ng_bucket_uploader_t bucket_uploader = qiniu_ng_bucket_uploader_new_from_bucket_name(
+        upload_manager, BUCKET_NAME, GETENV(QINIU_NG_CHARS("access_key")), 0);
+
+    const qiniu_ng_char_t file_key[256];
+    generate_file_key(file_key, 256, 0, 9);
+    const qiniu_ng_char_t *file_path = create_temp_file(9 * 1024 * 1024);
+
+    qiniu_ng_upload_policy_builder_t policy_builder = qiniu_ng_upload_policy_builder_new_for_bucket(BUCKET_NAME, config);
+    qiniu_ng_upload_token_t token = qiniu_ng_upload_token_new_from_policy_builder(policy_builder, GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_upload_policy_builder_free(&policy_builder);
+
+    qiniu_ng_callback_queue_t callback_queue = qiniu_ng_callback_queue_new();
+    qiniu_ng_upload_params_t params = {
+        .key = (const qiniu_ng_char_t *) &file_key[0],
+        .file_name = (const qiniu_ng_char_t *) &file_key[0],
+        .on_uploading_progress = unexpected_progress,
+        .callback_queue = callback_queue,
+    };
+    qiniu_ng_upload_response_t upload_response;
+    qiniu_ng_err_t err;
+    if (!qiniu_ng_bucket_uploader_upload_file_path(bucket_uploader, token, file_path, &params, &upload_response, &err)) {
+        qiniu_ng_err_fputs(err, stderr);
+        TEST_FAIL_MESSAGE("qiniu_ng_bucket_uploader_upload_file_path() failed");
+    }
+    qiniu_ng_upload_response_free(&upload_response);
+    qiniu_ng_callback_queue_close(callback_queue);
+
+#define EVENTS_SIZE (16)
+    qiniu_ng_callback_event_t events[EVENTS_SIZE];
+    size_t events_count, progress_events = 0;
+    uint64_t last_uploaded = 0;
+    while ((events_count = qiniu_ng_callback_queue_pop(callback_queue, &events[0], EVENTS_SIZE, 0)) > 0) {
+        for (size_t i = 0; i < events_count; i++) {
+            TEST_ASSERT_EQUAL_INT_MESSAGE(
+                events[i].kind, qiniu_ng_callback_event_uploading_progress,
+                "events[i].kind != qiniu_ng_callback_event_uploading_progress");
+            last_uploaded = events[i].uploaded;
+            progress_events++;
+        }
+    }
+#undef EVENTS_SIZE
+    TEST_ASSERT_GREATER_THAN_MESSAGE(
+        0, progress_events,
+        "progress_events <= 0");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        last_uploaded, 9 * 1024 * 1024,
+        "last_uploaded != 9 * 1024 * 1024");
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_callback_queue_is_finished(callback_queue),
+        "qiniu_ng_callback_queue_is_finished() returns unexpected value");
+    qiniu_ng_callback_queue_free(&callback_queue);
+
+    DELETE_FILE(file_path);
+    free((void *) file_path);
+
+    qiniu_ng_upload_token_free(&token);
+
+    qiniu_ng_bucket_uploader_free(&bucket_uploader);
+    qiniu_ng_upload_manager_free(&upload_manager);
+    qiniu_ng_config_free(&config);
+}
+
 void test_qiniu_ng_bucket_uploader_upload_empty_file(void) {
     qiniu_ng_config_t config = qiniu_ng_config_new_default();
 
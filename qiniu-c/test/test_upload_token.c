@@ -245,3 +245,44 @@ void test_qiniu_ng_make_upload_token(void) {
     qiniu_ng_upload_policy_free(&upload_policy_3);
     qiniu_ng_config_free(&config);
 }
+
+void test_qiniu_ng_make_cached_upload_token(void) {
+    qiniu_ng_config_t config = qiniu_ng_config_new_default();
+    env_load("..", false);
+
+    qiniu_ng_upload_policy_builder_t builder = qiniu_ng_upload_policy_builder_new_for_bucket(QINIU_NG_CHARS("test-bucket"), config);
+    qiniu_ng_upload_token_t upload_token = qiniu_ng_upload_token_new_cached_from_policy_builder(builder, GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_str_t token = qiniu_ng_upload_token_get_string(upload_token);
+    qiniu_ng_upload_token_free(&upload_token);
+
+    qiniu_ng_upload_policy_builder_set_token_lifetime(builder, 1800);
+    qiniu_ng_upload_token_t upload_token_2 = qiniu_ng_upload_token_new_cached_from_policy_builder(builder, GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_str_t token_2 = qiniu_ng_upload_token_get_string(upload_token_2);
+    qiniu_ng_upload_token_free(&upload_token_2);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(
+        qiniu_ng_str_get_ptr(token), qiniu_ng_str_get_ptr(token_2),
+        "qiniu_ng_str_get_ptr(token) != qiniu_ng_str_get_ptr(token_2)");
+    qiniu_ng_str_free(&token_2);
+
+    qiniu_ng_upload_policy_builder_set_token_lifetime(builder, 2 * 3600);
+    upload_token_2 = qiniu_ng_upload_token_new_cached_from_policy_builder(builder, GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    token_2 = qiniu_ng_upload_token_get_string(upload_token_2);
+    qiniu_ng_upload_token_free(&upload_token_2);
+    TEST_ASSERT_NOT_EQUAL_MESSAGE(
+        QINIU_NG_CHARS_CMP(qiniu_ng_str_get_ptr(token), qiniu_ng_str_get_ptr(token_2)), 0,
+        "qiniu_ng_str_get_ptr(token) == qiniu_ng_str_get_ptr(token_2)");
+    qiniu_ng_str_free(&token_2);
+
+    qiniu_ng_upload_policy_builder_set_insert_only(builder);
+    qiniu_ng_upload_token_t upload_token_3 = qiniu_ng_upload_token_new_cached_from_policy_builder(builder, GETENV(QINIU_NG_CHARS("access_key")), GETENV(QINIU_NG_CHARS("secret_key")));
+    qiniu_ng_str_t token_3 = qiniu_ng_upload_token_get_string(upload_token_3);
+    qiniu_ng_upload_token_free(&upload_token_3);
+    TEST_ASSERT_NOT_EQUAL_MESSAGE(
+        QINIU_NG_CHARS_CMP(qiniu_ng_str_get_ptr(token), qiniu_ng_str_get_ptr(token_3)), 0,
+        "qiniu_ng_str_get_ptr(token) == qiniu_ng_str_get_ptr(token_3)");
+    qiniu_ng_str_free(&token_3);
+    qiniu_ng_str_free(&token);
+
+    qiniu_ng_upload_policy_builder_free(&builder);
+    qiniu_ng_config_free(&config);
+}
@@ -59,6 +59,55 @@ void test_qiniu_ng_str_list(void) {
     qiniu_ng_str_list_free(&list);
 }
 
+void test_qiniu_ng_arena(void) {
+    qiniu_ng_arena_t arena = qiniu_ng_arena_new(8);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        qiniu_ng_arena_get_allocated_size(arena), 0,
+        "qiniu_ng_arena_get_allocated_size(arena) != 0");
+
+    qiniu_ng_str_view_t view = {"hello, qiniu", strlen("hello, qiniu")};
+    const qiniu_ng_char_t *str1 = qiniu_ng_arena_alloc_str(arena, view);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(
+        str1, QINIU_NG_CHARS("hello, qiniu"),
+        "str1 != \"hello, qiniu\"");
+    view.len = strlen("hello");
+    const qiniu_ng_char_t *str2 = qiniu_ng_arena_alloc_str(arena, view);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(
+        str2, QINIU_NG_CHARS("hello"),
+        "str2 != \"hello\"");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(
+        str1, QINIU_NG_CHARS("hello, qiniu"),
+        "str1 != \"hello, qiniu\"");
+    TEST_ASSERT_GREATER_THAN_MESSAGE(
+        0, qiniu_ng_arena_get_allocated_size(arena),
+        "qiniu_ng_arena_get_allocated_size(arena) <= 0");
+
+    qiniu_ng_str_view_t null_view = {NULL, 0};
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_str_view_is_null(null_view),
+        "qiniu_ng_str_view_is_null(null_view) failed");
+    TEST_ASSERT_NULL_MESSAGE(
+        qiniu_ng_arena_alloc_str(arena, null_view),
+        "qiniu_ng_arena_alloc_str(arena, null_view) != null");
+
+    qiniu_ng_str_view_t invalid_view = {"\xff\xfe", 2};
+    TEST_ASSERT_NULL_MESSAGE(
+        qiniu_ng_arena_alloc_str(arena, invalid_view),
+        "qiniu_ng_arena_alloc_str(arena, invalid_view) != null");
+
+    qiniu_ng_arena_reset(arena);
+    str1 = qiniu_ng_arena_alloc_str(arena, view);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(
+        str1, QINIU_NG_CHARS("hello"),
+        "str1 != \"hello\"");
+
+    qiniu_ng_arena_free(&arena);
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_arena_is_freed(arena),
+        "qiniu_ng_arena_is_freed() failed");
+    qiniu_ng_arena_free(&arena);
+}
+
 static bool test_qiniu_ng_str_map_handler(const qiniu_ng_char_t *key, const qiniu_ng_char_t *value, void *score) {
     if (QINIU_NG_CHARS_CMP(key, QINIU_NG_CHARS("qiniu")) == 0) {
         TEST_ASSERT_EQUAL_STRING_MESSAGE(
@@ -120,3 +169,50 @@ void test_qiniu_ng_str_map(void) {
     qiniu_ng_str_map_free(&map);
 }
 
+
+static void on_metrics_event(qiniu_ng_metrics_event_t event, void *data) {
+    (*(int *) data)++;
+}
+
+void test_qiniu_ng_metrics(void) {
+    qiniu_ng_metrics_disable();
+    qiniu_ng_metrics_reset();
+    TEST_ASSERT_FALSE_MESSAGE(
+        qiniu_ng_metrics_is_enabled(),
+        "qiniu_ng_metrics_is_enabled() != false");
+
+    qiniu_ng_metrics_snapshot(NULL);
+
+    qiniu_ng_metrics_snapshot_t snapshot;
+    qiniu_ng_metrics_snapshot(&snapshot);
+    for (int i = 0; i < QINIU_NG_METRICS_TIMINGS; i++) {
+        TEST_ASSERT_EQUAL_INT_MESSAGE(
+            snapshot.timings[i].count, 0,
+            "snapshot.timings[i].count != 0");
+    }
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        snapshot.events[qiniu_ng_metrics_event_retry], 0,
+        "snapshot.events[qiniu_ng_metrics_event_retry] != 0");
+
+    int events = 0;
+    qiniu_ng_metrics_set_sink(NULL, on_metrics_event, &events);
+    qiniu_ng_metrics_enable();
+    TEST_ASSERT_TRUE_MESSAGE(
+        qiniu_ng_metrics_is_enabled(),
+        "qiniu_ng_metrics_is_enabled() != true");
+
+    qiniu_ng_str_t text = qiniu_ng_metrics_to_prometheus_text();
+    TEST_ASSERT_NOT_NULL_MESSAGE(
+        QINIU_NG_CHARS_STR(qiniu_ng_str_get_ptr(text), QINIU_NG_CHARS("qiniu_ng_part_upload_seconds_count 0\n")),
+        "qiniu_ng_part_upload_seconds_count is not found");
+    TEST_ASSERT_NOT_NULL_MESSAGE(
+        QINIU_NG_CHARS_STR(qiniu_ng_str_get_ptr(text), QINIU_NG_CHARS("qiniu_ng_retries_total 0\n")),
+        "qiniu_ng_retries_total is not found");
+    qiniu_ng_str_free(&text);
+
+    qiniu_ng_metrics_disable();
+    qiniu_ng_metrics_set_sink(NULL, NULL, NULL);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(
+        events, 0,
+        "events != 0");
+}
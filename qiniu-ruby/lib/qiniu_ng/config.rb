@@ -28,6 +28,9 @@ module QiniuNg
                    uplog_host: nil,
                    batch_max_operation_size: nil,
                    http_connect_timeout: nil,
+                   http_pool_size: nil,
+                   http2: nil,
+                   http_tls_session_reuse: nil,
                    http_low_transfer_speed: nil,
                    http_low_transfer_speed_timeout: nil,
                    http_request_retries: nil,
@@ -65,6 +68,9 @@ module QiniuNg
       builder.uplog_host = uplog_host unless uplog_host.nil?
       builder.batch_max_operation_size = batch_max_operation_size unless batch_max_operation_size.nil?
       builder.http_connect_timeout = http_connect_timeout unless http_connect_timeout.nil?
+      builder.http_pool_size = http_pool_size unless http_pool_size.nil?
+      builder.http2 = http2 unless http2.nil?
+      builder.http_tls_session_reuse = http_tls_session_reuse unless http_tls_session_reuse.nil?
       builder.http_low_transfer_speed = http_low_transfer_speed unless http_low_transfer_speed.nil?
       builder.http_low_transfer_speed_timeout = http_low_transfer_speed_timeout unless http_low_transfer_speed_timeout.nil?
       builder.http_request_retries = http_request_retries unless http_request_retries.nil?
@@ -87,7 +93,7 @@ module QiniuNg
                 end
     end
 
-    # @!method initialize(use_https: nil, api_host: nil, rs_host: nil, rsf_host: nil, uc_host: nil, uplog_host: nil, batch_max_operation_size: nil, http_connect_timeout: nil, http_low_transfer_speed: nil, http_low_transfer_speed_timeout: nil, http_request_retries: nil, http_request_retry_delay: nil, http_request_timeout: nil, tcp_keepalive_idle_timeout: nil, tcp_keepalive_probe_interval: nil, upload_block_size: nil, upload_threshold: nil, upload_token_lifetime: nil, upload_recorder_always_flush_records: nil, upload_recorder_root_directory: nil, upload_recorder_upload_block_lifetime: nil, uplog_file_lock_policy: nil, uplog_file_max_size: nil, uplog_file_path: nil, uplog_file_upload_threshold: nil)
+    # @!method initialize(use_https: nil, api_host: nil, rs_host: nil, rsf_host: nil, uc_host: nil, uplog_host: nil, batch_max_operation_size: nil, http_connect_timeout: nil, http_pool_size: nil, http2: nil, http_tls_session_reuse: nil, http_low_transfer_speed: nil, http_low_transfer_speed_timeout: nil, http_request_retries: nil, http_request_retry_delay: nil, http_request_timeout: nil, tcp_keepalive_idle_timeout: nil, tcp_keepalive_probe_interval: nil, upload_block_size: nil, upload_threshold: nil, upload_token_lifetime: nil, upload_recorder_always_flush_records: nil, upload_recorder_root_directory: nil, upload_recorder_upload_block_lifetime: nil, uplog_file_lock_policy: nil, uplog_file_max_size: nil, uplog_file_path: nil, uplog_file_upload_threshold: nil)
     #   创建客户端实例
     #   @param [Boolean] use_https 是否使用 HTTPS 协议，默认为使用 HTTPS 协议
     #   @param [String] api_host API 服务器地址（仅需要指定主机地址和端口，无需包含协议），默认将会使用七牛公有云的 API 服务器地址，仅在使用私有云时才需要配置
@@ -97,6 +103,9 @@ module QiniuNg
     #   @param [String] uplog_host UpLog 服务器地址（仅需要指定主机地址和端口，无需包含协议），默认将会使用七牛公有云的 UpLog 服务器地址，仅在使用私有云时才需要配置
     #   @param [Integer] batch_max_operation_size 最大批量操作数，默认为 1000
     #   @param [Utils::Duration] http_connect_timeout HTTP 请求连接超时时长，默认为 5 秒
+    #   @param [Integer] http_pool_size 内置 libcurl 请求处理函数的句柄池大小，同时也决定了最多可以保持的空闲连接数，默认为 16
+    #   @param [Boolean] http2 内置 libcurl 请求处理函数是否启用 HTTP/2，默认不启用
+    #   @param [Boolean] http_tls_session_reuse 内置 libcurl 请求处理函数是否复用 TLS 会话，默认启用
     #   @param [Utils::Duration] http_request_timeout HTTP 请求超时时长，默认为 5 分钟
     #   @param [Utils::Duration] tcp_keepalive_idle_timeout TCP KeepAlive 空闲时长，默认为 5 分钟
     #   @param [Utils::Duration] tcp_keepalive_probe_interval TCP KeepAlive 探测包的发送间隔，默认为 5 秒
@@ -392,9 +401,29 @@ module QiniuNg
       #   设置进度记录文件始终刷新
       #   @param [Boolean] always_flush_records 进度记录文件是否始终刷新
       #   @return [Builder] 返回自身，可以形成链式调用
+      # @!method http2(http2)
+      #   设置内置 libcurl 请求处理函数是否启用 HTTP/2
+      #
+      #   启用后，HTTPS 请求将优先通过 HTTP/2 发送，并在可能的情况下复用已有的 HTTP/2 连接而非建立新连接
+      #
+      #   默认不启用
+      #
+      #   @param [Boolean] http2 是否启用 HTTP/2
+      #   @return [Builder] 返回自身，可以形成链式调用
+      # @!method http_tls_session_reuse(tls_session_reuse)
+      #   设置内置 libcurl 请求处理函数是否复用 TLS 会话
+      #
+      #   启用后，建立新的 HTTPS 连接时可以通过会话恢复省去完整的 TLS 握手
+      #
+      #   默认启用
+      #
+      #   @param [Boolean] tls_session_reuse 是否复用 TLS 会话
+      #   @return [Builder] 返回自身，可以形成链式调用
 
       # 设置布尔型参数 Setters
       %i[use_https
+         http2
+         http_tls_session_reuse
          upload_recorder_always_flush_records].each do |method|
         define_method(method) do |arg|
           @builder.public_send(method, !!arg)
@@ -430,6 +459,24 @@ module QiniuNg
       end
       alias uplog_file_lock_policy= uplog_file_lock_policy
 
+      # 使用基于 libcurl multi 接口的传输引擎发送请求
+      #
+      # 设置后，请求将交由引擎的事件循环线程执行，所有请求共享引擎的连接缓存，并可在 HTTP/2 连接上多路复用，
+      # 从而可以用少量线程同时驱动大量传输。超出最大传输数的请求将排队等待。
+      # 注意，此时上传下载进度回调将在事件循环线程中被调用
+      #
+      # @param [Integer] event_loop_threads 事件循环线程数，传入 0 表示使用默认值 1
+      # @param [Integer] max_transfers 最大同时进行的传输数，将平均分配给每个事件循环线程，传入 0 表示使用默认值 64
+      # @return [Builder] 返回自身，可以形成链式调用
+      # @raise [RangeError] 超过最大范围
+      def http_multi_engine(event_loop_threads: 0, max_transfers: 0)
+        [event_loop_threads, max_transfers].each do |arg|
+          raise RangeError, "#{arg} is out of range" if arg.to_i > 1 << 32 - 1 || arg.to_i < 0
+        end
+        @builder.http_multi_engine(event_loop_threads.to_i, max_transfers.to_i)
+        self
+      end
+
       # 创建一个新的域名管理器
       # @param [String] persistent_file 新的域名管理器的持久化路径，如果传入 nil 则表示禁止持久化
       # @return [Builder] 返回自身，可以形成链式调用
@@ -809,6 +856,26 @@ module QiniuNg
       #   @param [Utils::Duration] timeout 超时时长
       #   @return [Builder] 返回自身，可以形成链式调用
       #   @raise [RangeError] 超过最大范围
+      # @!method http_pool_size(pool_size)
+      #   设置内置 libcurl 请求处理函数的句柄池大小
+      #
+      #   句柄池中的句柄共享连接缓存，因此该值同时也决定了最多可以保持的空闲连接数
+      #
+      #   默认为 16
+      #
+      #   @param [Integer] pool_size 句柄池中最多缓存的 libcurl 句柄数
+      #   @return [Builder] 返回自身，可以形成链式调用
+      #   @raise [RangeError] 超过最大范围
+      # @!method http_max_connection_stats_hosts(max_hosts)
+      #   设置内置 libcurl 请求处理函数最多记录连接统计信息的主机数
+      #
+      #   超出该值时，将淘汰最久未发送过请求的主机的统计信息。设置为 0 将不再记录连接统计信息
+      #
+      #   默认为 256
+      #
+      #   @param [Integer] max_hosts 最多记录连接统计信息的主机数
+      #   @return [Builder] 返回自身，可以形成链式调用
+      #   @raise [RangeError] 超过最大范围
       # @!method http_low_transfer_speed_timeout(timeout)
       #   设置 HTTP 最低传输速度维持时长
       #
@@ -893,6 +960,8 @@ module QiniuNg
        [:http_connect_timeout, 0, 1 << 64 - 1, true],
        [:http_low_transfer_speed, 0, 1 << 32 - 1, false],
        [:http_low_transfer_speed_timeout, 0, 1 << 64 - 1, true],
+       [:http_max_connection_stats_hosts, 0, 1 << 32 - 1, false],
+       [:http_pool_size, 0, 1 << 32 - 1, false],
        [:http_request_retries, 0, 1 << 32 - 1, false],
        [:http_request_retry_delay, 0, 1 << 64 - 1, true],
        [:http_request_timeout, 0, 1 << 64 - 1, true],
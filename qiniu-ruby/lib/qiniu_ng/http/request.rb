@@ -69,12 +69,16 @@ module QiniuNg
       end
 
       # 获取请求体内容
+      #
+      # 如果请求体是数据流（例如表单上传的文件内容），数据流将被完整读入内存
       # @return [String] 请求体内容
+      # @raise [::IOError] 数据流读取失败
       def body
         body_ptr = Bindings::CoreFFI::Pointer.new
         body_size = Bindings::CoreFFI::Size.new
         @request.get_body(body_ptr, body_size)
         return nil unless body_size[:value] > 0
+        raise ::IOError, 'failed to read request body stream' if body_ptr[:value].null?
         body_ptr[:value].read_string(body_size[:value])
       end
 
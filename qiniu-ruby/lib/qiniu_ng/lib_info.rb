@@ -14,5 +14,11 @@ module QiniuNg
     def self.features
       Bindings::CoreFFI::qiniu_ng_features.split(',')
     end
+
+    # 获取 SDK 动态链接库当前生效的哈希算法实现
+    # @return [Hash<String, String>] 哈希算法与其实现名称的映射，如 `{ "sha1" => "sha-ni", "crc32" => "pclmulqdq" }`
+    def self.hash_backend
+      Bindings::CoreFFI::qiniu_ng_hash_backend.split(',').map { |pair| pair.split('=', 2) }.to_h
+    end
   end
 end
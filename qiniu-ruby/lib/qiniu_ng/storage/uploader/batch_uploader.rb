@@ -7,7 +7,11 @@ module QiniuNg
     class Uploader
       # 批量上传器
       #
-      # 准备批量上传多个文件或数据流，可以反复使用以上传多个批次的文件或数据
+      # 准备批量上传多个文件或数据流，可以反复使用以上传多个批次的文件或数据。
+      #
+      # 上传期间不持有全局解释器锁，上传进度和上传结果将通过回调队列传回调用 `start` 方法的线程，再依次调用各个任务的回调函数。
+      # 默认情况下，如果存储空间上传器中没有线程池，且没有设置线程池数量，则进程内所有批量上传器将共用同一个上传线程池，
+      # 可以设置 `use_shared_thread_pool = false` 改为每次上传时创建专用线程池
       class BatchUploader
         include UploaderHelper
 
@@ -15,6 +19,8 @@ module QiniuNg
         def initialize(batch_uploader_ffi)
           raise NotImplementedError, 'BatchUploader is unavailable for JRuby' if RUBY_ENGINE == 'jruby'
           @batch_uploader = batch_uploader_ffi
+          @batch_uploader.use_shared_thread_pool(true)
+          @callback_queue = nil
         end
         private_class_method :new
 
@@ -68,6 +74,18 @@ module QiniuNg
           @batch_uploader.set_thread_pool_size(thread_pool_size.to_i)
         end
 
+        # 设置是否使用进程内共享的上传线程池
+        #
+        # 默认使用。此时如果存储空间上传器中没有创建过线程池，且没有设置线程池数量，则所有使用共享线程池的批量上传器将共用同一个上传线程池。
+        # 共享线程池内的线程数量不会随批量上传器的数量增加，同时使用的批量上传器越多，每个批量上传器的并发度越低，
+        # 如果需要为当前批量上传器的每次上传创建专用线程池，请设置为 `false`
+        #
+        # @param [Boolean] use_shared_thread_pool 是否使用共享上传线程池
+        # @return [void]
+        def use_shared_thread_pool=(use_shared_thread_pool)
+          @batch_uploader.use_shared_thread_pool(!!use_shared_thread_pool)
+        end
+
         # 推送上传文件的任务
         # @param [IO] file 要上传的文件
         # @param [UploadToken,String] upload_token 专用上传凭证，如果不传入，则默认使用批量上传器的上传凭证
@@ -79,8 +97,9 @@ module QiniuNg
         # @param [Symbol] resumable_policy 分片上传策略，可以接受 `:default`, `:threshold`, `:always_be_resumeable`, `:never_be_resumeable` 四种取值
         #                                  默认且推荐使用 default 策略
         # @param [Integer] upload_threshold 分片上传策略阙值，仅当 resumable_policy 为 `:threshold` 时起效，为其设置分片上传的阙值
-        # @param [Lambda] on_uploading_progress 上传进度回调，需要提供一个带有两个参数的闭包函数，其中第一个参数为已经上传的数据量，单位为字节，第二个参数为需要上传的数据总量，单位为字节。如果无法预期需要上传的数据总量，则第二个参数将总是传入 0。该函数无需返回任何值。需要注意的是，该回调函数可能会被多个线程并发调用，因此需要保证实现的函数线程安全
-        # @yield [response, err] 上传完成后回调函数，用于接受上传完成后的结果。需要注意的是，该回调函数可能会被多个线程并发调用，因此需要保证实现的函数线程安全
+        # @param [Boolean] local_etag_enabled 是否在读取上传数据的同时计算本地 Etag，计算结果可以通过 `UploadResponse#local_etag` 获取，默认不启用
+        # @param [Lambda] on_uploading_progress 上传进度回调，需要提供一个带有两个参数的闭包函数，其中第一个参数为已经上传的数据量，单位为字节，第二个参数为需要上传的数据总量，单位为字节。如果无法预期需要上传的数据总量，则第二个参数将总是传入 0。该函数无需返回任何值。该回调函数总是在调用 `start` 方法的线程中调用，尚未处理的上传进度将被合并为最新的一次
+        # @yield [response, err] 上传完成后回调函数，用于接受上传完成后的结果。该回调函数总是在调用 `start` 方法的线程中调用
         # @yieldparam response [UploadResponse] 上传响应，应该首先判断上传是否有错误，然后再获取上传响应中的数据
         # @yieldparam err [Error] 上传错误
         # @raise [ArgumentError] 参数错误
@@ -95,6 +114,7 @@ module QiniuNg
                               resumable_policy: nil,
                               on_uploading_progress: nil,
                               upload_threshold: nil,
+                              local_etag_enabled: nil,
                               &on_completed)
           params = create_upload_params(
                     upload_token: upload_token,
@@ -107,6 +127,7 @@ module QiniuNg
                     resumable_policy: resumable_policy,
                     on_uploading_progress: on_uploading_progress,
                     upload_threshold: upload_threshold,
+                    local_etag_enabled: local_etag_enabled,
                     on_completed: on_completed)
           Error.wrap_ffi_function do
             @batch_uploader.upload_reader(normalize_io(file),
@@ -127,8 +148,9 @@ module QiniuNg
         # @param [Symbol] resumable_policy 分片上传策略，可以接受 `:default`, `:threshold`, `:always_be_resumeable`, `:never_be_resumeable` 四种取值
         #                                  默认且推荐使用 default 策略
         # @param [Integer] upload_threshold 分片上传策略阙值，仅当 resumable_policy 为 `:threshold` 时起效，为其设置分片上传的阙值
-        # @param [Lambda] on_uploading_progress 上传进度回调，需要提供一个带有两个参数的闭包函数，其中第一个参数为已经上传的数据量，单位为字节，第二个参数为需要上传的数据总量，单位为字节。如果无法预期需要上传的数据总量，则第二个参数将总是传入 0。该函数无需返回任何值。需要注意的是，该回调函数可能会被多个线程并发调用，因此需要保证实现的函数线程安全
-        # @yield [response, err] 上传完成后回调函数，用于接受上传完成后的结果。需要注意的是，该回调函数可能会被多个线程并发调用，因此需要保证实现的函数线程安全
+        # @param [Boolean] local_etag_enabled 是否在读取上传数据的同时计算本地 Etag，计算结果可以通过 `UploadResponse#local_etag` 获取，默认不启用
+        # @param [Lambda] on_uploading_progress 上传进度回调，需要提供一个带有两个参数的闭包函数，其中第一个参数为已经上传的数据量，单位为字节，第二个参数为需要上传的数据总量，单位为字节。如果无法预期需要上传的数据总量，则第二个参数将总是传入 0。该函数无需返回任何值。该回调函数总是在调用 `start` 方法的线程中调用，尚未处理的上传进度将被合并为最新的一次
+        # @yield [response, err] 上传完成后回调函数，用于接受上传完成后的结果。该回调函数总是在调用 `start` 方法的线程中调用
         # @yieldparam response [UploadResponse] 上传响应，应该首先判断上传是否有错误，然后再获取上传响应中的数据
         # @yieldparam err [Error] 上传错误
         # @raise [ArgumentError] 参数错误
@@ -143,6 +165,7 @@ module QiniuNg
                                         resumable_policy: nil,
                                         on_uploading_progress: nil,
                                         upload_threshold: nil,
+                                        local_etag_enabled: nil,
                                         &on_completed)
           params = create_upload_params(
                     upload_token: upload_token,
@@ -155,6 +178,7 @@ module QiniuNg
                     resumable_policy: resumable_policy,
                     on_uploading_progress: on_uploading_progress,
                     upload_threshold: upload_threshold,
+                    local_etag_enabled: local_etag_enabled,
                     on_completed: on_completed)
           Error.wrap_ffi_function do
             @batch_uploader.upload_file_path(file_path.to_s, params)
@@ -165,10 +189,16 @@ module QiniuNg
         #
         # 需要注意的是，该方法会持续阻塞直到上传任务全部执行完毕（不保证执行顺序）。
         # 该方法不返回任何结果，上传结果由每个上传任务内定义的代码块负责返回。
+        # 上传在后台线程中进行且不持有全局解释器锁，当前线程只负责从回调队列中取出事件并调用回调函数，因此其他 Ruby 线程可以同时运行。
         # 方法返回后，当前批量上传器的上传任务将被清空，但其他参数都将保留，可以重新添加任务并复用。
         # @return [void]
         def start
-          @batch_uploader.start
+          callback_queue = @callback_queue
+          @callback_queue = nil
+          return @batch_uploader.start if callback_queue.nil?
+
+          run_with_callback_queue(callback_queue) { @batch_uploader.start }
+          nil
         end
 
         # @!visibility private
@@ -188,6 +218,7 @@ module QiniuNg
                                  resumable_policy: nil,
                                  on_uploading_progress: nil,
                                  upload_threshold: nil,
+                                 local_etag_enabled: nil,
                                  on_completed: nil)
           params = Bindings::CoreFFI::QiniuNgBatchUploadParamsT.new
           params[:upload_token] = normalize_upload_token(upload_token).instance_variable_get(:@upload_token) unless upload_token.nil?
@@ -198,37 +229,14 @@ module QiniuNg
           params[:metadata] = create_str_map(metadata).instance unless metadata.nil?
           params[:checksum_enabled] = !!checksum_enabled unless checksum_enabled.nil?
           params[:resumable_policy] = normalize_resumable_policy(resumable_policy) unless resumable_policy.nil?
-          unless on_uploading_progress.nil?
-            params[:on_uploading_progress] = OnUploadingProgressCallback
-          end
-          params[:on_completed] = OnCompletedCallback
+          @callback_queue ||= Bindings::CallbackQueue.new!
+          params[:callback_queue] = @callback_queue.instance
           params[:callback_data] = CallbackData.put(on_uploading_progress: on_uploading_progress, on_completed: on_completed)
+          params[:on_uploading_progress] = UploadingProgressEventsEnabled unless on_uploading_progress.nil?
           params[:upload_threshold] = upload_threshold.to_i unless upload_threshold.nil?
+          params[:local_etag_enabled] = !!local_etag_enabled unless local_etag_enabled.nil?
           params
         end
-
-        OnUploadingProgressCallback = proc do |uploaded, total, idx|
-          begin
-            context = CallbackData.get(idx)
-            context[:on_uploading_progress]&.call(uploaded, total) if context
-          rescue Exception => e
-            Config::CallbackExceptionHandler.call(e)
-          end
-        end
-
-        OnCompletedCallback = proc do |response, err, idx|
-          begin
-            context = CallbackData.get(idx)
-            err = Error.send(:normalize_error, err)
-            response = UploadResponse.send(:new, Bindings::UploadResponse.new(response)) if err.nil?
-            context[:on_completed]&.call(response, err)
-          rescue Exception => e
-            Config::CallbackExceptionHandler.call(e)
-          ensure
-            CallbackData.delete(idx)
-          end
-        end
-        private_constant :OnUploadingProgressCallback, :OnCompletedCallback
       end
     end
   end
@@ -45,8 +45,9 @@ module QiniuNg
         # @param [Boolean] checksum_enabled 是否启用文件校验，默认总是启用，且不推荐禁用
         # @param [Symbol] resumable_policy 分片上传策略，可以接受 `:default`, `:threshold`, `:always_be_resumeable`, `:never_be_resumeable` 四种取值
         #                                  默认且推荐使用 default 策略
-        # @param [Lambda] on_uploading_progress 上传进度回调，需要提供一个带有两个参数的闭包函数，其中第一个参数为已经上传的数据量，单位为字节，第二个参数为需要上传的数据总量，单位为字节。如果无法预期需要上传的数据总量，则第二个参数将总是传入 0。该函数无需返回任何值。需要注意的是，该回调函数可能会被多个线程并发调用，因此需要保证实现的函数线程安全
+        # @param [Lambda] on_uploading_progress 上传进度回调，需要提供一个带有两个参数的闭包函数，其中第一个参数为已经上传的数据量，单位为字节，第二个参数为需要上传的数据总量，单位为字节。如果无法预期需要上传的数据总量，则第二个参数将总是传入 0。该函数无需返回任何值。该回调函数总是在调用当前方法的线程中调用，尚未处理的上传进度将被合并为最新的一次
         # @param [Integer] upload_threshold 分片上传策略阙值，仅当 resumable_policy 为 `:threshold` 时起效，为其设置分片上传的阙值
+        # @param [Boolean] local_etag_enabled 是否在读取上传数据的同时计算本地 Etag，计算结果可以通过 `UploadResponse#local_etag` 获取，默认不启用
         # @param [Ingeger] thread_pool_size 上传线程池尺寸，默认使用默认的线程池策略
         # @param [Ingeger] max_concurrency 最大并发度，默认与线程池大小相同
         # @return [UploadResponse] 上传响应
@@ -60,9 +61,11 @@ module QiniuNg
                                              resumable_policy: nil,
                                              on_uploading_progress: nil,
                                              upload_threshold: nil,
+                                             local_etag_enabled: nil,
                                              thread_pool_size: nil,
                                              max_concurrency: nil)
           upload_token = normalize_upload_token(upload_token)
+          callback_queue = create_callback_queue(on_uploading_progress)
           params = create_upload_params(key: key,
                                         file_name: file_name,
                                         mime: mime,
@@ -72,14 +75,18 @@ module QiniuNg
                                         resumable_policy: resumable_policy,
                                         on_uploading_progress: on_uploading_progress,
                                         upload_threshold: upload_threshold,
+                                        local_etag_enabled: local_etag_enabled,
                                         thread_pool_size: thread_pool_size,
-                                        max_concurrency: max_concurrency)
-          upload_response = QiniuNg::Error.wrap_ffi_function do
-                              @bucket_uploader.upload_reader(
-                                upload_token.instance_variable_get(:@upload_token),
-                                normalize_io(file),
-                                file.respond_to?(:size) ? file.size : 0,
-                                params)
+                                        max_concurrency: max_concurrency,
+                                        callback_queue: callback_queue)
+          upload_response = upload_with_callback_queue(callback_queue, params) do
+                              QiniuNg::Error.wrap_ffi_function do
+                                @bucket_uploader.upload_reader(
+                                  upload_token.instance_variable_get(:@upload_token),
+                                  normalize_io(file),
+                                  file.respond_to?(:size) ? file.size : 0,
+                                  params)
+                              end
                             end
           UploadResponse.send(:new, upload_response)
         end
@@ -96,8 +103,9 @@ module QiniuNg
         # @param [Boolean] checksum_enabled 是否启用文件校验，默认总是启用，且不推荐禁用
         # @param [Symbol] resumable_policy 分片上传策略，可以接受 `:default`, `:threshold`, `:always_be_resumeable`, `:never_be_resumeable` 四种取值
         #                                  默认且推荐使用 default 策略
-        # @param [Lambda] on_uploading_progress 上传进度回调，需要提供一个带有两个参数的闭包函数，其中第一个参数为已经上传的数据量，单位为字节，第二个参数为需要上传的数据总量，单位为字节。如果无法预期需要上传的数据总量，则第二个参数将总是传入 0。该函数无需返回任何值。需要注意的是，该回调函数可能会被多个线程并发调用，因此需要保证实现的函数线程安全
+        # @param [Lambda] on_uploading_progress 上传进度回调，需要提供一个带有两个参数的闭包函数，其中第一个参数为已经上传的数据量，单位为字节，第二个参数为需要上传的数据总量，单位为字节。如果无法预期需要上传的数据总量，则第二个参数将总是传入 0。该函数无需返回任何值。该回调函数总是在调用当前方法的线程中调用，尚未处理的上传进度将被合并为最新的一次
         # @param [Integer] upload_threshold 分片上传策略阙值，仅当 resumable_policy 为 `:threshold` 时起效，为其设置分片上传的阙值
+        # @param [Boolean] local_etag_enabled 是否在读取上传数据的同时计算本地 Etag，计算结果可以通过 `UploadResponse#local_etag` 获取，默认不启用
         # @param [Ingeger] thread_pool_size 上传线程池尺寸，默认使用默认的线程池策略
         # @param [Ingeger] max_concurrency 最大并发度，默认与线程池大小相同
         # @return [UploadResponse] 上传响应
@@ -111,9 +119,11 @@ module QiniuNg
                                                        resumable_policy: nil,
                                                        on_uploading_progress: nil,
                                                        upload_threshold: nil,
+                                                       local_etag_enabled: nil,
                                                        thread_pool_size: nil,
                                                        max_concurrency: nil)
           upload_token = normalize_upload_token(upload_token)
+          callback_queue = create_callback_queue(on_uploading_progress)
           params = create_upload_params(key: key,
                                         file_name: file_name,
                                         mime: mime,
@@ -123,13 +133,17 @@ module QiniuNg
                                         resumable_policy: resumable_policy,
                                         on_uploading_progress: on_uploading_progress,
                                         upload_threshold: upload_threshold,
+                                        local_etag_enabled: local_etag_enabled,
                                         thread_pool_size: thread_pool_size,
-                                        max_concurrency: max_concurrency)
-          upload_response = QiniuNg::Error.wrap_ffi_function do
-                              @bucket_uploader.upload_file_path(
-                                upload_token.instance_variable_get(:@upload_token),
-                                file_path.to_s,
-                                params)
+                                        max_concurrency: max_concurrency,
+                                        callback_queue: callback_queue)
+          upload_response = upload_with_callback_queue(callback_queue, params) do
+                              QiniuNg::Error.wrap_ffi_function do
+                                @bucket_uploader.upload_file_path(
+                                  upload_token.instance_variable_get(:@upload_token),
+                                  file_path.to_s,
+                                  params)
+                              end
                             end
           UploadResponse.send(:new, upload_response)
         end
@@ -19,8 +19,10 @@ module QiniuNg
                                  resumable_policy: nil,
                                  on_uploading_progress: nil,
                                  upload_threshold: nil,
+                                 local_etag_enabled: nil,
                                  thread_pool_size: nil,
-                                 max_concurrency: nil)
+                                 max_concurrency: nil,
+                                 callback_queue: nil)
           params = Bindings::CoreFFI::QiniuNgUploadParamsT.new
           params[:key] = FFI::MemoryPointer.from_string(key.to_s) unless key.nil?
           params[:file_name] = FFI::MemoryPointer.from_string(file_name.to_s) unless file_name.nil?
@@ -31,9 +33,15 @@ module QiniuNg
           params[:resumable_policy] = normalize_resumable_policy(resumable_policy) unless resumable_policy.nil?
           unless on_uploading_progress.nil?
             params[:callback_data] = CallbackData.put(on_uploading_progress: on_uploading_progress)
-            params[:on_uploading_progress] = OnUploadingProgressCallback
+            if callback_queue.nil?
+              params[:on_uploading_progress] = OnUploadingProgressCallback
+            else
+              params[:callback_queue] = callback_queue.instance
+              params[:on_uploading_progress] = UploadingProgressEventsEnabled
+            end
           end
           params[:upload_threshold] = upload_threshold.to_i unless upload_threshold.nil?
+          params[:local_etag_enabled] = !!local_etag_enabled unless local_etag_enabled.nil?
           unless thread_pool_size.nil?
             thread_pool_size = thread_pool_size.to_i
             raise ArgumentError, 'invalid thread_pool_size' if thread_pool_size <= 0
@@ -47,6 +55,23 @@ module QiniuNg
           params
         end
 
+        # 设置了上传进度回调时创建回调队列，使上传进度与批量上传一样经由回调队列传回调用上传方法的线程
+        #
+        # JRuby 没有全局解释器锁，依然直接在上传线程中调用上传进度回调
+        def create_callback_queue(on_uploading_progress)
+          Bindings::CallbackQueue.new! unless on_uploading_progress.nil? || RUBY_ENGINE == 'jruby'
+        end
+
+        # 如果设置了回调队列，则在后台线程中执行上传，当前线程负责取出上传进度事件并调用上传进度回调
+        def upload_with_callback_queue(callback_queue, params, &block)
+          return yield if callback_queue.nil?
+          begin
+            run_with_callback_queue(callback_queue, &block)
+          ensure
+            CallbackData.delete(params[:callback_data])
+          end
+        end
+
         OnUploadingProgressCallback = proc do |uploaded, total, idx|
           begin
             context = CallbackData.get(idx)
@@ -25,6 +25,16 @@ module QiniuNg
           data.read_string(data_len[:value])
         end
 
+        # 上传过程中在本地计算得到的 Etag
+        # @return [String,nil] 仅当上传时启用了 local_etag_enabled 且计算成功时才返回本地 Etag
+        def local_etag
+          data = FFI::MemoryPointer.new(256)
+          data_len = Bindings::CoreFFI::Size.new
+          @upload_response.get_local_etag(data, data_len)
+          return nil if data_len[:value].zero?
+          data.read_string(data_len[:value])
+        end
+
         # 上传响应中的对象名称字段
         # @return [String,nil] 返回上传响应中的对象名称字段
         def key
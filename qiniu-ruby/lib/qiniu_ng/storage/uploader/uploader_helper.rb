@@ -7,6 +7,13 @@ module QiniuNg
   module Storage
     class Uploader
       module UploaderHelper
+        # 每次从回调队列中取出的最大事件数量
+        CALLBACK_EVENTS_SIZE = 64
+
+        # 设置了回调队列的任务不会调用该函数，仅用于告知 SDK 需要推送上传进度事件
+        UploadingProgressEventsEnabled = proc { |_uploaded, _total, _data| }
+        private_constant :CALLBACK_EVENTS_SIZE, :UploadingProgressEventsEnabled
+
         private
 
         def normalize_upload_token(upload_token)
@@ -39,6 +46,52 @@ module QiniuNg
           reader
         end
 
+        # 在后台线程中执行代码块，当前线程则从回调队列中取出事件并调用回调函数，直到代码块执行完毕且所有事件都已经处理
+        #
+        # 返回代码块的返回值，代码块抛出的异常将在当前线程中重新抛出
+        def run_with_callback_queue(callback_queue)
+          running = Thread.new do
+            begin
+              # 异常将由当前线程重新抛出，无需在后台线程中报告
+              Thread.current.report_on_exception = false
+              yield
+            ensure
+              callback_queue.close
+            end
+          end
+          dispatch_callback_events(callback_queue)
+          running.value
+        end
+
+        def dispatch_callback_events(callback_queue)
+          until callback_queue.is_finished
+            # 每次取出事件都使用新的内存，因为上传响应将继续引用其中的数据
+            events = FFI::MemoryPointer.new(Bindings::CoreFFI::QiniuNgCallbackEventT, CALLBACK_EVENTS_SIZE)
+            count = Bindings::CoreFFI::qiniu_ng_callback_queue_pop(callback_queue.instance, events, CALLBACK_EVENTS_SIZE, 0)
+            count.times do |idx|
+              handle_callback_event(Bindings::CoreFFI::QiniuNgCallbackEventT.new(events[idx]))
+            end
+          end
+        end
+
+        def handle_callback_event(event)
+          context = CallbackData.get(event[:callback_data])
+          case event[:kind]
+          when :qiniu_ng_callback_event_uploading_progress
+            context[:on_uploading_progress]&.call(event[:uploaded], event[:total]) if context
+          when :qiniu_ng_callback_event_completed
+            begin
+              err = Error.send(:normalize_error, event[:err])
+              response = UploadResponse.send(:new, Bindings::UploadResponse.new(event[:response])) if err.nil?
+              context[:on_completed]&.call(response, err) if context
+            ensure
+              CallbackData.delete(event[:callback_data])
+            end
+          end
+        rescue Exception => e
+          Config::CallbackExceptionHandler.call(e)
+        end
+
         QiniuNgReadFunc = proc do |idx, data, size, have_read|
           begin
             io = CallbackData.get(idx)
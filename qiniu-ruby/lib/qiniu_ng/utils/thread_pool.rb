@@ -8,6 +8,7 @@ module QiniuNg
       #
       # 在每次 Fork 新进程后，应该在子进程内调用该方法以重建全局线程池，否则部分 SDK 功能在子进程内可能无法正常使用。
       # 使用该方法也可以用于调整全局线程池线程数量。
+      # 批量上传器共用的上传线程池也将被重建。
       #
       # @param [Integer] num_threads 调整后的线程池数量，默认为不调整
       # @return [void]
@@ -166,6 +166,37 @@ RSpec.describe QiniuNg::Config do
       end.to raise_error(RangeError)
     end
 
+    it 'should send requests with customized libcurl options' do
+      builder = QiniuNg::Config::Builder.new
+      expect do
+        builder.http_pool_size = -1
+      end.to raise_error(RangeError)
+
+      builder.http_pool_size = 4
+      builder.http2 = true
+      builder.http_tls_session_reuse = true
+      builder.http_max_connection_stats_hosts = 8
+      client = QiniuNg::Client.new access_key: ENV['access_key'],
+                                   secret_key: ENV['secret_key'],
+                                   config: builder.build!
+      2.times { expect(client.bucket_names).to include('z0-bucket') }
+    end
+
+    it 'should send requests by libcurl multi engine' do
+      builder = QiniuNg::Config::Builder.new
+      expect do
+        builder.http_multi_engine(max_transfers: -1)
+      end.to raise_error(RangeError)
+
+      builder.http_multi_engine(event_loop_threads: 1, max_transfers: 4).http2 = true
+      client = QiniuNg::Client.new access_key: ENV['access_key'],
+                                   secret_key: ENV['secret_key'],
+                                   config: builder.build!
+      4.times.map { Thread.new { client.bucket_names } }.each do |thread|
+        expect(thread.value).to include('z0-bucket')
+      end
+    end
+
     it 'could accept value to be nil' do
       builder = QiniuNg::Config::Builder.new
       builder.api_host = nil
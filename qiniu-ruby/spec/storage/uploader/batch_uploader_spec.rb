@@ -84,6 +84,63 @@ RSpec.describe QiniuNg::Storage::Uploader::BatchUploader do
         expect(completed.value).to eq 8
         expect(errref.get).to be_nil
       end
+
+      it 'should call callbacks in the current thread without blocking other threads' do
+        config = QiniuNg::Config.new
+        upload_token = QiniuNg::Storage::Uploader::UploadPolicy::Builder.new_for_bucket(upload_bucket_name, config).
+                                                                         build_token(access_key: ENV['access_key'],
+                                                                                     secret_key: ENV['secret_key'])
+        batch_uploader = QiniuNg::Storage::Uploader.new(config).
+                                                    batch_uploader(upload_token, config: config)
+        callback_threads = []
+        tempfiles = 4.times.map do |idx|
+          tempfile = Tempfile.create('测试', encoding: 'ascii-8bit')
+          tempfile.write(SecureRandom.random_bytes(1 << 22))
+          tempfile.flush
+          key = "测试-#{idx}-#{Time.now.to_i}"
+          on_uploading_progress = ->(_uploaded, _total) { callback_threads << Thread.current }
+          batch_uploader.upload_file_path(tempfile.path, key: key, on_uploading_progress: on_uploading_progress) do |response, err|
+            expect(err).to be_nil
+            expect(response.key).to eq key
+            callback_threads << Thread.current
+          end
+          tempfile
+        end
+        ticks = Concurrent::AtomicFixnum.new
+        ticker = Thread.new { loop { ticks.increment; sleep 0.01 } }
+        batch_uploader.start
+        ticker.kill
+        expect(callback_threads.size).to be >= 4
+        expect(callback_threads.uniq).to eq [Thread.current]
+        expect(ticks.value).to be > 1
+        tempfiles.each(&:close)
+      end
+
+      it 'should upload files without the shared thread pool' do
+        config = QiniuNg::Config.new
+        upload_token = QiniuNg::Storage::Uploader::UploadPolicy::Builder.new_for_bucket(upload_bucket_name, config).
+                                                                         build_token(access_key: ENV['access_key'],
+                                                                                     secret_key: ENV['secret_key'])
+        batch_uploader = QiniuNg::Storage::Uploader.new(config).
+                                                    batch_uploader(upload_token, config: config)
+        batch_uploader.use_shared_thread_pool = false
+        completed = Concurrent::AtomicFixnum.new
+        tempfiles = 2.times.map do |idx|
+          tempfile = Tempfile.create('测试', encoding: 'ascii-8bit')
+          tempfile.write(SecureRandom.random_bytes(1 << 20))
+          tempfile.flush
+          key = "测试-#{idx}-#{Time.now.to_i}"
+          batch_uploader.upload_file_path(tempfile.path, key: key) do |response, err|
+            expect(err).to be_nil
+            expect(response.key).to eq key
+            completed.increment
+          end
+          tempfile
+        end
+        batch_uploader.start
+        expect(completed.value).to eq 2
+        tempfiles.each(&:close)
+      end
     end
   end
 end
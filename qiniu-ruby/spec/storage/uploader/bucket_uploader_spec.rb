@@ -136,5 +136,51 @@ RSpec.describe QiniuNg::Storage::Uploader::BucketUploader do
         expect(last_uploaded.value).to eq file_size
       end
     end
+
+    it 'should call uploading progress callback in the current thread without blocking other threads' do
+      config = QiniuNg::Config.new
+      upload_token = QiniuNg::Storage::Uploader::UploadPolicy::Builder.new_for_bucket(upload_bucket_name, config).
+                                                                       build_token(access_key: ENV['access_key'],
+                                                                                   secret_key: ENV['secret_key'])
+      bucket_uploader = QiniuNg::Storage::Uploader.new(config).
+                                                   bucket_uploader(bucket_name: upload_bucket_name,
+                                                                   access_key: ENV['access_key'])
+      Tempfile.create('测试', encoding: 'ascii-8bit') do |file|
+        file.write(SecureRandom.random_bytes(1 << 24))
+        file.flush
+        key = "测试-#{Time.now.to_i}"
+        callback_threads = []
+        last_uploaded = -1
+        on_uploading_progress = ->(uploaded, _total) do
+                                  callback_threads << Thread.current
+                                  last_uploaded = uploaded
+                                end
+        ticks = Concurrent::AtomicFixnum.new
+        ticker = Thread.new { loop { ticks.increment; sleep 0.01 } }
+        response = bucket_uploader.upload_file_path(file.path, upload_token: upload_token,
+                                                               key: key,
+                                                               on_uploading_progress: on_uploading_progress)
+        ticker.kill
+        expect(response.key).to eq(key)
+        expect(callback_threads).not_to be_empty
+        expect(callback_threads.uniq).to eq [Thread.current]
+        expect(last_uploaded).to eq file.size
+        expect(ticks.value).to be > 1
+      end
+    end
+
+    it 'should raise upload error in the current thread when uploading progress callback is set' do
+      config = QiniuNg::Config.new
+      bucket_uploader = QiniuNg::Storage::Uploader.new(config).
+                                                   bucket_uploader(bucket_name: upload_bucket_name,
+                                                                   access_key: ENV['access_key'])
+      upload_token = QiniuNg::Storage::Uploader::UploadPolicy::Builder.new_for_bucket(upload_bucket_name, config).
+                                                                       build_token(access_key: ENV['access_key'],
+                                                                                   secret_key: ENV['secret_key'])
+      expect do
+        bucket_uploader.upload_file_path('/不存在的文件', upload_token: upload_token,
+                                                      on_uploading_progress: ->(_uploaded, _total) {})
+      end.to raise_error(QiniuNg::Error::OSError)
+    end
   end
 end
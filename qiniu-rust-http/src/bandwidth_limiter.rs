@@ -0,0 +1,172 @@
+use super::CancellationToken;
+use std::{
+    fmt,
+    sync::{Arc, Mutex},
+    thread::sleep,
+    time::{Duration, Instant},
+};
+
+/// 每次等待的最长时长，等待期间将定期检查取消令牌和速率是否发生变化
+const MAX_WAIT_INTERVAL: Duration = Duration::from_millis(100);
+
+/// 带宽限制器
+///
+/// 基于令牌桶算法限制传输速率，桶容量为一秒的传输量。限制器可以被克隆，克隆出的限制器共享同一个令牌桶，
+/// 因此同一个限制器可以被多个上传器或多个任务共用，限制它们的总传输速率。
+///
+/// 速率可以在传输进行期间随时调整，正在等待的传输将在下一次检查时按照新的速率继续
+#[derive(Clone)]
+pub struct BandwidthLimiter {
+    inner: Arc<Mutex<TokenBucket>>,
+}
+
+struct TokenBucket {
+    rate: u64,
+    tokens: f64,
+    last_refill: Instant,
+}
+
+impl BandwidthLimiter {
+    /// 创建带宽限制器
+    ///
+    /// 速率单位为字节每秒，`0` 表示不限制速率
+    pub fn new(bytes_per_second: u64) -> BandwidthLimiter {
+        BandwidthLimiter {
+            inner: Arc::new(Mutex::new(TokenBucket {
+                rate: bytes_per_second,
+                tokens: bytes_per_second as f64,
+                last_refill: Instant::now(),
+            })),
+        }
+    }
+
+    /// 获取当前速率，单位为字节每秒，`0` 表示不限制速率
+    pub fn rate(&self) -> u64 {
+        self.inner.lock().unwrap().rate
+    }
+
+    /// 调整速率，单位为字节每秒，`0` 表示不限制速率
+    pub fn set_rate(&self, bytes_per_second: u64) {
+        let mut bucket = self.inner.lock().unwrap();
+        bucket.refill();
+        bucket.rate = bytes_per_second;
+        if bytes_per_second == 0 {
+            bucket.tokens = 0f64;
+        } else {
+            bucket.tokens = bucket.tokens.min(bytes_per_second as f64);
+        }
+    }
+
+    /// 申请传输指定字节数
+    ///
+    /// 如果令牌不足，将阻塞当前线程直到令牌足够为止。
+    /// 如果等待期间取消令牌被取消，则立即返回 `false`，否则返回 `true`
+    pub fn consume(&self, size: usize, cancellation_token: Option<&CancellationToken>) -> bool {
+        let mut wait = {
+            let mut bucket = self.inner.lock().unwrap();
+            if bucket.rate == 0 {
+                return true;
+            }
+            bucket.refill();
+            // 允许令牌数为负，即使单次申请超过桶容量，也只需等待令牌补足即可
+            bucket.tokens -= size as f64;
+            bucket.wait_duration()
+        };
+        while let Some(duration) = wait {
+            if cancellation_token.map_or(false, |token| token.is_canceled()) {
+                return false;
+            }
+            sleep(duration.min(MAX_WAIT_INTERVAL));
+            let mut bucket = self.inner.lock().unwrap();
+            bucket.refill();
+            wait = bucket.wait_duration();
+        }
+        !cancellation_token.map_or(false, |token| token.is_canceled())
+    }
+}
+
+impl TokenBucket {
+    fn refill(&mut self) {
+        let now = Instant::now();
+        let elapsed = now.duration_since(self.last_refill);
+        self.last_refill = now;
+        if self.rate > 0 {
+            let rate = self.rate as f64;
+            self.tokens = (self.tokens + elapsed.as_secs_f64() * rate).min(rate);
+        }
+    }
+
+    fn wait_duration(&self) -> Option<Duration> {
+        if self.rate == 0 || self.tokens >= 0f64 {
+            None
+        } else {
+            Some(Duration::from_secs_f64(-self.tokens / self.rate as f64))
+        }
+    }
+}
+
+impl fmt::Debug for BandwidthLimiter {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_struct("BandwidthLimiter").field("rate", &self.rate()).finish()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::thread;
+
+    #[test]
+    fn test_bandwidth_limiter_unlimited() {
+        let limiter = BandwidthLimiter::new(0);
+        let begin_at = Instant::now();
+        for _ in 0..1000 {
+            assert!(limiter.consume(1 << 20, None));
+        }
+        assert!(begin_at.elapsed() < Duration::from_millis(100));
+    }
+
+    #[test]
+    fn test_bandwidth_limiter_throttle() {
+        let limiter = BandwidthLimiter::new(1000);
+        let begin_at = Instant::now();
+        assert!(limiter.consume(1000, None));
+        assert!(begin_at.elapsed() < Duration::from_millis(100));
+        assert!(limiter.consume(500, None));
+        let elapsed = begin_at.elapsed();
+        assert!(elapsed >= Duration::from_millis(400));
+        assert!(elapsed < Duration::from_millis(1000));
+    }
+
+    #[test]
+    fn test_bandwidth_limiter_cancel() {
+        let limiter = BandwidthLimiter::new(1);
+        let token = CancellationToken::new();
+        {
+            let token = token.to_owned();
+            thread::spawn(move || {
+                thread::sleep(Duration::from_millis(200));
+                token.cancel();
+            });
+        }
+        let begin_at = Instant::now();
+        assert!(!limiter.consume(1 << 20, Some(&token)));
+        assert!(begin_at.elapsed() < Duration::from_secs(2));
+    }
+
+    #[test]
+    fn test_bandwidth_limiter_set_rate() {
+        let limiter = BandwidthLimiter::new(1);
+        {
+            let limiter = limiter.to_owned();
+            thread::spawn(move || {
+                thread::sleep(Duration::from_millis(200));
+                limiter.set_rate(0);
+            });
+        }
+        let begin_at = Instant::now();
+        assert!(limiter.consume(1 << 20, None));
+        assert!(begin_at.elapsed() < Duration::from_secs(2));
+        assert_eq!(limiter.rate(), 0);
+    }
+}
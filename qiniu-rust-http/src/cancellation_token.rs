@@ -0,0 +1,90 @@
+use std::sync::{
+    atomic::{AtomicBool, Ordering::Relaxed},
+    Arc,
+};
+
+/// 取消令牌
+///
+/// 用于在传输进行期间中止 HTTP 请求。令牌可以被克隆，克隆出的令牌共享同一个取消状态，
+/// 因此同一个令牌可以被多个上传器或多个任务共用，在任意线程调用 `cancel()` 都将中止所有使用该令牌的传输。
+///
+/// 通过 `child_token()` 创建的子令牌，将在父令牌被取消时一并被取消，而取消子令牌则不会影响父令牌
+#[derive(Clone, Default, Debug)]
+pub struct CancellationToken {
+    inner: Arc<TokenInner>,
+}
+
+#[derive(Default, Debug)]
+struct TokenInner {
+    canceled: AtomicBool,
+    parent: Option<CancellationToken>,
+}
+
+impl CancellationToken {
+    /// 创建取消令牌
+    pub fn new() -> CancellationToken {
+        Default::default()
+    }
+
+    /// 创建子令牌
+    pub fn child_token(&self) -> CancellationToken {
+        CancellationToken {
+            inner: Arc::new(TokenInner {
+                canceled: AtomicBool::new(false),
+                parent: Some(self.to_owned()),
+            }),
+        }
+    }
+
+    /// 取消
+    ///
+    /// 正在进行的传输将尽快中止，并返回用户取消错误，之后使用该令牌的传输将不再进行。
+    /// 取消不可撤销
+    pub fn cancel(&self) {
+        self.inner.canceled.store(true, Relaxed);
+    }
+
+    /// 是否已经被取消
+    ///
+    /// 如果父令牌已经被取消，子令牌也被视为已经被取消
+    pub fn is_canceled(&self) -> bool {
+        let mut token = self;
+        loop {
+            if token.inner.canceled.load(Relaxed) {
+                return true;
+            }
+            match token.inner.parent.as_ref() {
+                Some(parent) => token = parent,
+                None => return false,
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::thread;
+
+    #[test]
+    fn test_cancellation_token() {
+        let token = CancellationToken::new();
+        let cloned = token.to_owned();
+        assert!(!token.is_canceled());
+        thread::spawn(move || cloned.cancel()).join().unwrap();
+        assert!(token.is_canceled());
+    }
+
+    #[test]
+    fn test_cancellation_child_token() {
+        let parent = CancellationToken::new();
+        let first = parent.child_token();
+        let second = first.child_token();
+        second.cancel();
+        assert!(second.is_canceled());
+        assert!(!first.is_canceled());
+        assert!(!parent.is_canceled());
+        parent.cancel();
+        assert!(first.is_canceled());
+    }
+}
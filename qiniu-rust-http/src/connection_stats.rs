@@ -0,0 +1,33 @@
+use getset::CopyGetters;
+use std::time::Duration;
+
+/// 与单个主机之间的连接统计信息
+///
+/// 由 HTTP 客户端在每次请求结束后记录，用于观察连接复用的效果
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq, CopyGetters)]
+pub struct ConnectionStats {
+    /// 新建立的连接数
+    #[get_copy = "pub"]
+    connections_opened: u64,
+
+    /// 复用已有连接的请求数
+    #[get_copy = "pub"]
+    connections_reused: u64,
+
+    /// 新建立连接的握手总耗时，包括 TCP 连接和 TLS 握手，不包括域名解析
+    #[get_copy = "pub"]
+    handshake_duration: Duration,
+}
+
+impl ConnectionStats {
+    /// 记录新建立的连接及其握手耗时
+    pub fn record_opened(&mut self, connections: u64, handshake_duration: Duration) {
+        self.connections_opened += connections;
+        self.handshake_duration += handshake_duration;
+    }
+
+    /// 记录一次复用已有连接的请求
+    pub fn record_reused(&mut self) {
+        self.connections_reused += 1;
+    }
+}
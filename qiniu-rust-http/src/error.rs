@@ -56,7 +56,7 @@ pub enum ErrorKind {
     /// IO 错误
     IOError(io::Error),
     /// 未知错误
-    UnknownError(Box<dyn StdError + Send>),
+    UnknownError(Box<dyn StdError + Send + Sync>),
     /// 响应状态码错误
     ResponseStatusCodeError(StatusCode, Box<str>),
     /// 用户取消
@@ -74,12 +74,12 @@ pub struct HTTPCallerError {
 
     /// 错误内容
     #[get = "pub"]
-    inner: Box<dyn StdError + Send>,
+    inner: Box<dyn StdError + Send + Sync>,
 }
 
 impl ErrorKind {
     /// 创建 HTTP 调用错误
-    pub fn new_http_caller_error_kind(kind: HTTPCallerErrorKind, error: impl StdError + Send + 'static) -> Self {
+    pub fn new_http_caller_error_kind(kind: HTTPCallerErrorKind, error: impl StdError + Send + Sync + 'static) -> Self {
         ErrorKind::HTTPCallerError(HTTPCallerError {
             kind,
             inner: Box::new(error),
@@ -25,20 +25,51 @@
 //! 因此，对于容易发生错误的请求（例如上传下载之类的），要尽可能将其 HTTP 调用设置为幂等，
 //! 否则就可能因为发生错误的时机不佳而无法重试。
 
+mod bandwidth_limiter;
+mod cancellation_token;
+mod connection_stats;
 mod error;
 mod header;
 mod method;
+pub mod metrics;
 mod request;
 mod response;
+pub use bandwidth_limiter::BandwidthLimiter;
+pub use cancellation_token::CancellationToken;
+pub use connection_stats::ConnectionStats;
 pub use error::{Error, ErrorKind, HTTPCallerError, HTTPCallerErrorKind, Result, RetryKind};
 pub use header::{HeaderName, HeaderValue, Headers};
 pub use method::Method;
-pub use request::{Body as RequestBody, ProgressCallback, Request, RequestBuilder, URL};
+pub use request::{
+    Body as RequestBody, BodyStream as RequestBodyStream, ProgressCallback, Request, RequestBuilder, URL,
+};
 pub use response::{Body as ResponseBody, Response, ResponseBuilder, StatusCode};
 
+/// HTTP 请求完成回调函数
+///
+/// 第一个参数是被交还的 HTTP 请求，第二个参数是请求结果
+pub type HTTPCallback = Box<dyn FnOnce(Request<'static>, Result<Response>) + Send>;
+
 /// HTTP 请求处理函数
 ///
 /// 实现该接口，即可处理所有七牛 SDK 发送的 HTTP 请求
 pub trait HTTPCaller: Send + Sync {
     fn call(&self, request: &Request) -> Result<Response>;
+
+    /// 异步发送 HTTP 请求，请求结束后调用 `on_completed`，并将请求交还给回调函数
+    ///
+    /// 默认实现将在当前线程中调用 `call()` 同步发送请求，然后立即调用 `on_completed`。
+    /// 支持异步发送的实现可以在提交请求后立即返回，并在其他线程中调用 `on_completed`，
+    /// 因此回调函数不应执行耗时操作
+    fn call_async(&self, request: Request<'static>, on_completed: HTTPCallback) {
+        let result = self.call(&request);
+        on_completed(request, result)
+    }
+
+    /// 获取与指定主机之间的连接统计信息
+    ///
+    /// 默认实现不做任何统计，总是返回 `None`
+    fn connection_stats(&self, _host: &str) -> Option<ConnectionStats> {
+        None
+    }
 }
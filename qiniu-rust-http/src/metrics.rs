@@ -0,0 +1,458 @@
+//! 度量指标
+//!
+//! 在进程内统计 SDK 热路径上各个环节的耗时分布与事件次数，包括域名解析，建立连接，TLS 握手，首字节时间，
+//! 单次 HTTP 请求，分块上传，以及上传记录和上传日志的 I/O 耗时，和重试，冻结 URL 等事件。
+//!
+//! 统计默认关闭，调用 [`enable()`](fn.enable.html) 后才开始记录，关闭时每个统计点仅需读取一次原子变量，因此可以在生产环境中长期开启。
+//! 统计结果可以通过 [`snapshot()`](fn.snapshot.html) 获取快照，并转换为 Prometheus 文本格式，
+//! 也可以通过 [`set_sink()`](fn.set_sink.html) 设置接收器实时接收每一条记录。
+//! 启用 `tracing` 功能后，每一条记录还将以 `qiniu_ng::metrics` 为目标发出 `tracing` 事件
+
+use lazy_static::lazy_static;
+use std::{
+    fmt::Write,
+    sync::{
+        atomic::{AtomicBool, AtomicU64, Ordering::Relaxed},
+        Arc, RwLock,
+    },
+    time::{Duration, Instant},
+};
+
+/// 耗时直方图的桶数
+///
+/// 第 `i` 个桶记录耗时小于 `2^i` 微秒，且不小于 `2^(i-1)` 微秒的样本，最后一个桶记录所有更长的样本
+pub const HISTOGRAM_BUCKETS: usize = 28;
+
+/// 耗时统计项
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum Timing {
+    /// 域名解析耗时
+    DNSResolution,
+    /// 建立 TCP 连接的耗时，不包括域名解析
+    Connect,
+    /// TLS 握手耗时
+    TLSHandshake,
+    /// 首字节时间，即从开始请求到收到第一个响应字节的耗时
+    TimeToFirstByte,
+    /// 单次 HTTP 请求的耗时，不包括重试
+    HTTPRequest,
+    /// 单个分块的上传耗时，包括重试
+    PartUpload,
+    /// 写入上传记录的耗时
+    RecorderIO,
+    /// 写入上传日志的耗时
+    UploadLoggerIO,
+}
+
+impl Timing {
+    /// 所有耗时统计项
+    pub const ALL: [Timing; 8] = [
+        Timing::DNSResolution,
+        Timing::Connect,
+        Timing::TLSHandshake,
+        Timing::TimeToFirstByte,
+        Timing::HTTPRequest,
+        Timing::PartUpload,
+        Timing::RecorderIO,
+        Timing::UploadLoggerIO,
+    ];
+
+    /// 统计项名称
+    pub fn name(self) -> &'static str {
+        match self {
+            Timing::DNSResolution => "dns_resolution",
+            Timing::Connect => "connect",
+            Timing::TLSHandshake => "tls_handshake",
+            Timing::TimeToFirstByte => "time_to_first_byte",
+            Timing::HTTPRequest => "http_request",
+            Timing::PartUpload => "part_upload",
+            Timing::RecorderIO => "recorder_io",
+            Timing::UploadLoggerIO => "upload_logger_io",
+        }
+    }
+}
+
+/// 事件统计项
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum Event {
+    /// 同一个 URL 上的 HTTP 请求重试
+    Retry,
+    /// URL 因请求失败而被冻结
+    URLFrozen,
+    /// 发出对冲请求
+    HedgedRequest,
+    /// 域名解析失败
+    DNSResolutionFailure,
+}
+
+impl Event {
+    /// 所有事件统计项
+    pub const ALL: [Event; 4] = [
+        Event::Retry,
+        Event::URLFrozen,
+        Event::HedgedRequest,
+        Event::DNSResolutionFailure,
+    ];
+
+    /// 统计项名称
+    pub fn name(self) -> &'static str {
+        match self {
+            Event::Retry => "retries",
+            Event::URLFrozen => "frozen_urls",
+            Event::HedgedRequest => "hedged_requests",
+            Event::DNSResolutionFailure => "dns_resolution_failures",
+        }
+    }
+}
+
+/// 度量指标接收器
+///
+/// 统计开启时，每一条记录都将同步地传给接收器，接收器可能会被多个线程并发调用，应当尽快返回
+pub trait MetricsSink: Send + Sync {
+    /// 接收一条耗时记录
+    fn on_duration(&self, _timing: Timing, _duration: Duration) {}
+
+    /// 接收一次事件
+    fn on_event(&self, _event: Event) {}
+}
+
+struct Histogram {
+    count: AtomicU64,
+    sum_micros: AtomicU64,
+    buckets: Vec<AtomicU64>,
+}
+
+impl Histogram {
+    fn new() -> Self {
+        Histogram {
+            count: AtomicU64::new(0),
+            sum_micros: AtomicU64::new(0),
+            buckets: (0..HISTOGRAM_BUCKETS).map(|_| AtomicU64::new(0)).collect(),
+        }
+    }
+
+    fn record(&self, micros: u64) {
+        self.count.fetch_add(1, Relaxed);
+        self.sum_micros.fetch_add(micros, Relaxed);
+        self.buckets[bucket_index(micros)].fetch_add(1, Relaxed);
+    }
+
+    fn snapshot(&self) -> HistogramSnapshot {
+        let mut buckets = [0u64; HISTOGRAM_BUCKETS];
+        for (bucket, counter) in buckets.iter_mut().zip(self.buckets.iter()) {
+            *bucket = counter.load(Relaxed);
+        }
+        HistogramSnapshot {
+            count: self.count.load(Relaxed),
+            sum: Duration::from_micros(self.sum_micros.load(Relaxed)),
+            buckets,
+        }
+    }
+
+    fn reset(&self) {
+        self.count.store(0, Relaxed);
+        self.sum_micros.store(0, Relaxed);
+        for bucket in self.buckets.iter() {
+            bucket.store(0, Relaxed);
+        }
+    }
+}
+
+#[inline]
+fn bucket_index(micros: u64) -> usize {
+    ((64 - micros.leading_zeros()) as usize).min(HISTOGRAM_BUCKETS - 1)
+}
+
+struct Registry {
+    timings: Vec<Histogram>,
+    events: Vec<AtomicU64>,
+}
+
+static ENABLED: AtomicBool = AtomicBool::new(false);
+static SINK_INSTALLED: AtomicBool = AtomicBool::new(false);
+
+lazy_static! {
+    static ref REGISTRY: Registry = Registry {
+        timings: Timing::ALL.iter().map(|_| Histogram::new()).collect(),
+        events: Event::ALL.iter().map(|_| AtomicU64::new(0)).collect(),
+    };
+    static ref SINK: RwLock<Option<Arc<dyn MetricsSink>>> = RwLock::new(None);
+}
+
+/// 开启统计
+pub fn enable() {
+    ENABLED.store(true, Relaxed);
+}
+
+/// 关闭统计，已经记录的统计结果将被保留
+pub fn disable() {
+    ENABLED.store(false, Relaxed);
+}
+
+/// 统计是否已经开启
+#[inline]
+pub fn is_enabled() -> bool {
+    ENABLED.load(Relaxed)
+}
+
+/// 设置度量指标接收器，传入 `None` 将移除已经设置的接收器
+pub fn set_sink(sink: Option<Arc<dyn MetricsSink>>) {
+    let mut guard = SINK.write().unwrap();
+    SINK_INSTALLED.store(sink.is_some(), Relaxed);
+    *guard = sink;
+}
+
+/// 记录一次耗时
+///
+/// 统计未开启时将直接返回
+#[inline]
+pub fn record_duration(timing: Timing, duration: Duration) {
+    if is_enabled() {
+        record_duration_slow(timing, duration);
+    }
+}
+
+fn record_duration_slow(timing: Timing, duration: Duration) {
+    let micros = duration.as_micros().min(u128::from(u64::max_value())) as u64;
+    REGISTRY.timings[timing as usize].record(micros);
+    if SINK_INSTALLED.load(Relaxed) {
+        if let Some(sink) = SINK.read().unwrap().as_ref() {
+            sink.on_duration(timing, duration);
+        }
+    }
+    #[cfg(feature = "tracing")]
+    tracing::trace!(target: "qiniu_ng::metrics", timing = timing.name(), duration_us = micros);
+}
+
+/// 记录一次事件
+///
+/// 统计未开启时将直接返回
+#[inline]
+pub fn record_event(event: Event) {
+    if is_enabled() {
+        record_event_slow(event);
+    }
+}
+
+fn record_event_slow(event: Event) {
+    REGISTRY.events[event as usize].fetch_add(1, Relaxed);
+    if SINK_INSTALLED.load(Relaxed) {
+        if let Some(sink) = SINK.read().unwrap().as_ref() {
+            sink.on_event(event);
+        }
+    }
+    #[cfg(feature = "tracing")]
+    tracing::trace!(target: "qiniu_ng::metrics", event = event.name());
+}
+
+/// 计时器
+///
+/// 仅在统计开启时读取时钟，统计未开启时创建和记录计时器几乎没有开销
+#[derive(Debug, Clone, Copy)]
+pub struct Stopwatch(Option<Instant>);
+
+impl Stopwatch {
+    /// 开始计时
+    #[inline]
+    pub fn start() -> Self {
+        Stopwatch(if is_enabled() { Some(Instant::now()) } else { None })
+    }
+
+    /// 记录从开始计时到现在的耗时
+    #[inline]
+    pub fn record(&self, timing: Timing) {
+        if let Some(started_at) = self.0 {
+            record_duration(timing, started_at.elapsed());
+        }
+    }
+}
+
+/// 获取当前统计结果的快照
+///
+/// 快照中的各项数据分别读取，在统计的同时获取快照，各项数据之间可能存在细微的不一致
+pub fn snapshot() -> MetricsSnapshot {
+    MetricsSnapshot {
+        timings: REGISTRY.timings.iter().map(Histogram::snapshot).collect(),
+        events: REGISTRY.events.iter().map(|counter| counter.load(Relaxed)).collect(),
+    }
+}
+
+/// 清空所有统计结果
+pub fn reset() {
+    for histogram in REGISTRY.timings.iter() {
+        histogram.reset();
+    }
+    for counter in REGISTRY.events.iter() {
+        counter.store(0, Relaxed);
+    }
+}
+
+/// 耗时直方图快照
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct HistogramSnapshot {
+    count: u64,
+    sum: Duration,
+    buckets: [u64; HISTOGRAM_BUCKETS],
+}
+
+impl HistogramSnapshot {
+    /// 样本数量
+    pub fn count(&self) -> u64 {
+        self.count
+    }
+
+    /// 样本耗时总和，精确到微秒
+    pub fn sum(&self) -> Duration {
+        self.sum
+    }
+
+    /// 各个桶中的样本数量，非累积
+    pub fn buckets(&self) -> &[u64] {
+        &self.buckets
+    }
+
+    /// 指定桶的耗时上限（不包含），最后一个桶没有上限，将返回 `None`
+    pub fn bucket_upper_bound(index: usize) -> Option<Duration> {
+        if index + 1 < HISTOGRAM_BUCKETS {
+            Some(Duration::from_micros(1 << index))
+        } else {
+            None
+        }
+    }
+}
+
+/// 统计结果快照
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct MetricsSnapshot {
+    timings: Vec<HistogramSnapshot>,
+    events: Vec<u64>,
+}
+
+impl MetricsSnapshot {
+    /// 获取指定耗时统计项的直方图快照
+    pub fn timing(&self, timing: Timing) -> &HistogramSnapshot {
+        &self.timings[timing as usize]
+    }
+
+    /// 获取指定事件的发生次数
+    pub fn event(&self, event: Event) -> u64 {
+        self.events[event as usize]
+    }
+
+    /// 转换为 Prometheus 文本格式
+    ///
+    /// 耗时统计项将输出为以秒为单位的 `qiniu_ng_<name>_seconds` 直方图，事件统计项则输出为 `qiniu_ng_<name>_total` 计数器
+    pub fn to_prometheus_text(&self) -> String {
+        let mut text = String::new();
+        for &timing in Timing::ALL.iter() {
+            let histogram = self.timing(timing);
+            let name = timing.name();
+            let _ = writeln!(text, "# TYPE qiniu_ng_{}_seconds histogram", name);
+            let mut cumulative = 0;
+            for (index, &count) in histogram.buckets.iter().enumerate() {
+                cumulative += count;
+                match HistogramSnapshot::bucket_upper_bound(index) {
+                    Some(upper_bound) => {
+                        let _ = writeln!(
+                            text,
+                            "qiniu_ng_{}_seconds_bucket{{le=\"{}\"}} {}",
+                            name,
+                            upper_bound.as_secs_f64(),
+                            cumulative
+                        );
+                    }
+                    None => {
+                        let _ = writeln!(text, "qiniu_ng_{}_seconds_bucket{{le=\"+Inf\"}} {}", name, cumulative);
+                    }
+                }
+            }
+            let _ = writeln!(text, "qiniu_ng_{}_seconds_sum {}", name, histogram.sum.as_secs_f64());
+            let _ = writeln!(text, "qiniu_ng_{}_seconds_count {}", name, histogram.count);
+        }
+        for &event in Event::ALL.iter() {
+            let _ = writeln!(text, "# TYPE qiniu_ng_{}_total counter", event.name());
+            let _ = writeln!(text, "qiniu_ng_{}_total {}", event.name(), self.event(event));
+        }
+        text
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::{error::Error, result::Result, sync::Mutex};
+
+    #[derive(Default)]
+    struct RecordingSink {
+        durations: Mutex<Vec<(Timing, Duration)>>,
+        events: Mutex<Vec<Event>>,
+    }
+
+    impl MetricsSink for RecordingSink {
+        fn on_duration(&self, timing: Timing, duration: Duration) {
+            self.durations.lock().unwrap().push((timing, duration));
+        }
+
+        fn on_event(&self, event: Event) {
+            self.events.lock().unwrap().push(event);
+        }
+    }
+
+    #[test]
+    fn test_metrics_record_and_snapshot() -> Result<(), Box<dyn Error>> {
+        disable();
+        reset();
+        record_duration(Timing::PartUpload, Duration::from_millis(3));
+        record_event(Event::Retry);
+        assert_eq!(snapshot().timing(Timing::PartUpload).count(), 0);
+        assert_eq!(snapshot().event(Event::Retry), 0);
+
+        let sink = Arc::new(RecordingSink::default());
+        set_sink(Some(sink.to_owned()));
+        enable();
+        record_duration(Timing::PartUpload, Duration::from_micros(0));
+        record_duration(Timing::PartUpload, Duration::from_micros(3));
+        record_duration(Timing::PartUpload, Duration::from_secs(3600));
+        record_event(Event::Retry);
+        record_event(Event::Retry);
+        record_event(Event::URLFrozen);
+        disable();
+        set_sink(None);
+
+        let snapshot = snapshot();
+        let histogram = snapshot.timing(Timing::PartUpload);
+        assert_eq!(histogram.count(), 3);
+        assert_eq!(histogram.sum(), Duration::from_micros(3_600_000_003));
+        assert_eq!(histogram.buckets()[0], 1);
+        assert_eq!(histogram.buckets()[2], 1);
+        assert_eq!(histogram.buckets()[HISTOGRAM_BUCKETS - 1], 1);
+        assert_eq!(snapshot.timing(Timing::Connect).count(), 0);
+        assert_eq!(snapshot.event(Event::Retry), 2);
+        assert_eq!(snapshot.event(Event::URLFrozen), 1);
+        assert_eq!(sink.durations.lock().unwrap().len(), 3);
+        assert_eq!(sink.events.lock().unwrap().len(), 3);
+
+        let text = snapshot.to_prometheus_text();
+        assert!(text.contains("qiniu_ng_part_upload_seconds_bucket{le=\"0.000004\"} 2\n"));
+        assert!(text.contains("qiniu_ng_part_upload_seconds_bucket{le=\"+Inf\"} 3\n"));
+        assert!(text.contains("qiniu_ng_part_upload_seconds_count 3\n"));
+        assert!(text.contains("qiniu_ng_retries_total 2\n"));
+
+        reset();
+        assert_eq!(super::snapshot().timing(Timing::PartUpload).count(), 0);
+        assert_eq!(super::snapshot().event(Event::Retry), 0);
+        Ok(())
+    }
+
+    #[test]
+    fn test_metrics_bucket_index() {
+        assert_eq!(bucket_index(0), 0);
+        assert_eq!(bucket_index(1), 1);
+        assert_eq!(bucket_index(2), 2);
+        assert_eq!(bucket_index(3), 2);
+        assert_eq!(bucket_index(4), 3);
+        assert_eq!(bucket_index(u64::max_value()), HISTOGRAM_BUCKETS - 1);
+        assert_eq!(HistogramSnapshot::bucket_upper_bound(3), Some(Duration::from_micros(8)));
+        assert_eq!(HistogramSnapshot::bucket_upper_bound(HISTOGRAM_BUCKETS - 1), None);
+    }
+}
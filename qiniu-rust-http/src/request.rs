@@ -1,12 +1,43 @@
-use super::{HeaderName, HeaderValue, Headers, Method};
+use super::{CancellationToken, HeaderName, HeaderValue, Headers, Method};
 use getset::{CopyGetters, Getters, MutGetters};
-use std::{borrow::Cow, ffi::c_void, fmt, net::SocketAddr, ptr::null_mut, time::Duration};
+use std::{
+    borrow::Cow,
+    convert::TryInto,
+    ffi::c_void,
+    fmt,
+    io::{Error as IOError, ErrorKind as IOErrorKind, Result as IOResult},
+    net::SocketAddr,
+    ptr::null_mut,
+    time::Duration,
+};
 
 /// 请求 URL
 pub type URL<'b> = Cow<'b, str>;
 
 /// 请求体
-pub type Body<'b> = Cow<'b, [u8]>;
+pub enum Body<'b> {
+    /// 二进制数据
+    Bytes(Cow<'b, [u8]>),
+
+    /// 已知长度的数据流
+    Stream(&'b (dyn BodyStream + 'b)),
+}
+
+/// 请求体数据流
+///
+/// 用于发送无需预先全部加载进内存的请求体。
+/// 数据流长度必须预先可知，并且能够倒回到任意位置，HTTP 客户端在每次发送请求前，以及重试或重定向需要重新发送请求体时，都将调用 `seek()` 重新定位。
+/// 由于 HTTP 请求只以不可变引用的形式传递给 HTTP 客户端，实现时需要自行保证内部可变性
+pub trait BodyStream {
+    /// 数据流总长度，单位为字节
+    fn size(&self) -> u64;
+
+    /// 从当前位置读取数据，返回读取的字节数，返回 `0` 表示已经读到数据流末尾
+    fn read(&self, buf: &mut [u8]) -> IOResult<usize>;
+
+    /// 将当前位置移动到距离数据流开头 `offset` 字节处
+    fn seek(&self, offset: u64) -> IOResult<()>;
+}
 
 /// 进度回调闭包
 #[derive(Copy, Clone)]
@@ -71,6 +102,13 @@ pub struct Request<'b> {
     #[get_mut = "pub"]
     on_downloading_progress: Option<ProgressCallback<'b>>,
 
+    /// 取消令牌
+    ///
+    /// 令牌被取消后，HTTP 客户端应该尽快中止传输，并返回不可重试的用户取消错误
+    #[get_copy = "pub"]
+    #[get_mut = "pub"]
+    cancellation_token: Option<&'b CancellationToken>,
+
     /// 连接超时时长
     #[get_copy = "pub"]
     #[get_mut = "pub"]
@@ -199,6 +237,12 @@ impl<'r> RequestBuilder<'r> {
         self
     }
 
+    /// 设置取消令牌
+    pub fn cancellation_token(mut self, cancellation_token: &'r CancellationToken) -> RequestBuilder<'r> {
+        self.request.cancellation_token = Some(cancellation_token);
+        self
+    }
+
     /// 设置连接超时时长
     pub fn connect_timeout(mut self, timeout: Duration) -> RequestBuilder<'r> {
         self.request.connect_timeout = timeout;
@@ -247,12 +291,13 @@ impl Default for Request<'_> {
             url: "http://localhost".into(),
             method: Method::GET,
             headers: Headers::new(),
-            body: Cow::Borrowed(&[]),
+            body: Body::Bytes(Cow::Borrowed(&[])),
             user_agent: Cow::Borrowed(""),
             follow_redirection: false,
             resolved_socket_addrs: Cow::Borrowed(&[]),
             on_uploading_progress: None,
             on_downloading_progress: None,
+            cancellation_token: None,
             custom_data: null_mut(),
             connect_timeout: Duration::from_secs(5),
             request_timeout: Duration::from_secs(300),
@@ -290,6 +335,7 @@ impl fmt::Debug for Request<'_> {
                     &"Not Installed"
                 },
             )
+            .field("cancellation_token", &self.cancellation_token)
             .field("connect_timeout", &self.connect_timeout)
             .field("request_timeout", &self.request_timeout)
             .field("tcp_keepalive_idle_timeout", &self.tcp_keepalive_idle_timeout)
@@ -300,6 +346,109 @@ impl fmt::Debug for Request<'_> {
     }
 }
 
+impl<'b> Body<'b> {
+    /// 请求体长度，单位为字节
+    pub fn len(&self) -> u64 {
+        match self {
+            Body::Bytes(bytes) => bytes.len().try_into().unwrap_or(u64::max_value()),
+            Body::Stream(stream) => stream.size(),
+        }
+    }
+
+    /// 请求体是否为空
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// 获取二进制请求体的内容
+    ///
+    /// 对于数据流请求体，将返回 `None`
+    pub fn as_bytes(&self) -> Option<&[u8]> {
+        match self {
+            Body::Bytes(bytes) => Some(bytes.as_ref()),
+            Body::Stream(_) => None,
+        }
+    }
+
+    /// 将数据流请求体完整读入内存，转换为二进制请求体，并返回其内容
+    ///
+    /// 对于二进制请求体，将直接返回其内容。读取前后都将调用 `seek(0)`，因此不影响之后发送请求体。
+    /// 如果读取失败，或读取到的数据长度与数据流声明的长度不一致，将返回错误，且请求体保持不变
+    pub fn buffer(&mut self) -> IOResult<&[u8]> {
+        if let Body::Stream(stream) = *self {
+            let size = stream.size();
+            let mut bytes = Vec::with_capacity(size.try_into().unwrap_or(0));
+            let mut chunk = [0u8; 1 << 16];
+            stream.seek(0)?;
+            loop {
+                let have_read = stream.read(&mut chunk)?;
+                if have_read == 0 {
+                    break;
+                }
+                bytes.extend_from_slice(&chunk[..have_read]);
+            }
+            stream.seek(0)?;
+            if bytes.len().try_into().unwrap_or(u64::max_value()) != size {
+                return Err(IOError::new(
+                    IOErrorKind::UnexpectedEof,
+                    format!("Body stream size mismatch: expected {}, read {}", size, bytes.len()),
+                ));
+            }
+            *self = Body::Bytes(Cow::Owned(bytes));
+        }
+        Ok(self.as_bytes().unwrap_or_default())
+    }
+
+    /// 借用当前请求体，生成一个新的请求体
+    ///
+    /// 二进制数据不会被复制，数据流则共享同一个实例
+    pub fn as_borrowed(&self) -> Body {
+        match self {
+            Body::Bytes(bytes) => Body::Bytes(Cow::Borrowed(bytes.as_ref())),
+            Body::Stream(stream) => Body::Stream(*stream),
+        }
+    }
+}
+
+impl Default for Body<'_> {
+    fn default() -> Self {
+        Body::Bytes(Cow::Borrowed(&[]))
+    }
+}
+
+impl<'b> From<Cow<'b, [u8]>> for Body<'b> {
+    fn from(bytes: Cow<'b, [u8]>) -> Self {
+        Body::Bytes(bytes)
+    }
+}
+
+impl<'b> From<&'b [u8]> for Body<'b> {
+    fn from(bytes: &'b [u8]) -> Self {
+        Body::Bytes(Cow::Borrowed(bytes))
+    }
+}
+
+impl From<Vec<u8>> for Body<'_> {
+    fn from(bytes: Vec<u8>) -> Self {
+        Body::Bytes(Cow::Owned(bytes))
+    }
+}
+
+impl<'b> From<&'b (dyn BodyStream + 'b)> for Body<'b> {
+    fn from(stream: &'b (dyn BodyStream + 'b)) -> Self {
+        Body::Stream(stream)
+    }
+}
+
+impl fmt::Debug for Body<'_> {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        match self {
+            Body::Bytes(bytes) => f.debug_tuple("Bytes").field(bytes).finish(),
+            Body::Stream(stream) => f.debug_struct("Stream").field("size", &stream.size()).finish(),
+        }
+    }
+}
+
 impl ProgressCallback<'_> {
     // 调用进度回调闭包
     pub fn call(&self, uploaded: u64, total: u64) {
@@ -321,3 +470,59 @@ impl From<fn(u64, u64)> for ProgressCallback<'_> {
         Self(_ProgressCallback::Fn(f))
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::Mutex;
+
+    struct MemoryStream {
+        data: Vec<u8>,
+        size: u64,
+        position: Mutex<usize>,
+    }
+
+    impl BodyStream for MemoryStream {
+        fn size(&self) -> u64 {
+            self.size
+        }
+
+        fn read(&self, buf: &mut [u8]) -> IOResult<usize> {
+            let mut position = self.position.lock().unwrap();
+            let have_read = buf.len().min(self.data.len() - *position);
+            buf[..have_read].copy_from_slice(&self.data[*position..*position + have_read]);
+            *position += have_read;
+            Ok(have_read)
+        }
+
+        fn seek(&self, offset: u64) -> IOResult<()> {
+            *self.position.lock().unwrap() = offset.try_into().unwrap();
+            Ok(())
+        }
+    }
+
+    #[test]
+    fn test_buffer_stream_body() -> IOResult<()> {
+        let data = (0..(1 << 17) + 7).map(|i| i as u8).collect::<Vec<_>>();
+        let stream = MemoryStream {
+            data: data.to_owned(),
+            size: data.len() as u64,
+            position: Mutex::new(3),
+        };
+        let mut body = Body::from(&stream as &dyn BodyStream);
+        assert!(body.as_bytes().is_none());
+        assert_eq!(body.buffer()?, data.as_slice());
+        assert_eq!(body.as_bytes(), Some(data.as_slice()));
+        assert_eq!(*stream.position.lock().unwrap(), 0);
+
+        let truncated = MemoryStream {
+            data: data.to_owned(),
+            size: data.len() as u64 + 1,
+            position: Mutex::new(0),
+        };
+        let mut body = Body::from(&truncated as &dyn BodyStream);
+        assert_eq!(body.buffer().unwrap_err().kind(), IOErrorKind::UnexpectedEof);
+        assert!(body.as_bytes().is_none());
+        Ok(())
+    }
+}
@@ -9,7 +9,6 @@ use serde::Serialize;
 use std::{
     borrow::Cow,
     boxed::Box,
-    convert::TryInto,
     io::{Error as IOError, ErrorKind as IOErrorKind},
     marker::{Send, Sync},
     sync::{
@@ -198,7 +197,7 @@ impl<T: HTTPCaller> UploadingProgressErrorMock<T> {
 impl<T: HTTPCaller> HTTPCaller for UploadingProgressErrorMock<T> {
     fn call(&self, request: &Request) -> Result<Response> {
         let mut rng = thread_rng();
-        let total_size: u64 = request.body().as_ref().len().try_into().unwrap_or(u64::max_value());
+        let total_size: u64 = request.body().len();
         let packet_size: u64 = self.packet_size.into();
         for i in 1..=total_size {
             if i % packet_size != total_size % packet_size {
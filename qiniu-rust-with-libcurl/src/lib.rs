@@ -1,28 +1,37 @@
 use curl::{
-    easy::{Easy2, Handler, List, ReadError, SeekResult, WriteError},
+    easy::{Easy2, Handler, HttpVersion, List, ReadError, SeekResult, WriteError},
     Version,
 };
 use derive_builder::Builder;
 use lazy_static::lazy_static;
-use object_pool::Pool;
+use multi::{Transfer, TransferResult};
+use pool::EasyPool;
 use qiniu_http::{
-    Error, ErrorKind, HTTPCaller, HTTPCallerErrorKind, Headers, Method, ProgressCallback, Request, Response,
-    ResponseBuilder, Result, StatusCode,
+    metrics::{self, Timing},
+    CancellationToken, ConnectionStats, Error, ErrorKind, HTTPCallback, HTTPCaller, HTTPCallerErrorKind, Headers,
+    Method, ProgressCallback, Request, RequestBody, RequestBodyStream, Response, ResponseBuilder, Result, StatusCode,
 };
+use share::Share;
 use std::{
-    convert::TryInto,
+    collections::HashMap,
     default::Default,
     env,
     fs::File,
-    io::{Cursor, Read, Seek, SeekFrom, Write},
-    mem::{size_of, transmute, transmute_copy},
+    io::{Cursor, Error as IOError, ErrorKind as IOErrorKind, Read, Seek, SeekFrom, Write},
+    mem::transmute,
     net::IpAddr,
     path::{Path, PathBuf},
     result,
-    sync::Once,
+    sync::{Arc, Mutex, Once},
+    time::{Duration, Instant},
 };
 use url::Url;
 
+mod multi;
+mod pool;
+mod share;
+pub use multi::{CurlMultiEngine, CurlMultiEngineBuilder};
+
 static INITIALIZER: Once = Once::new();
 lazy_static! {
     static ref IPV6_SUPPORT: bool = Version::get().feature_ipv6();
@@ -36,7 +45,6 @@ lazy_static! {
     .into();
     static ref PART_USER_AGENT: Box<str> = format!("libcurl-{}", Version::get().version()).into();
     static ref TEMP_DIR: PathBuf = env::temp_dir();
-    static ref CURL_POOL: Pool<'static, Easy2ContextRef> = Pool::new(16, Easy2ContextRef::default);
 }
 
 #[derive(Debug, Builder)]
@@ -54,37 +62,209 @@ pub struct CurlClient {
 
     #[builder(default, setter(skip))]
     user_agent: Option<String>,
+
+    /// 使用 libcurl multi 接口的传输引擎发送请求
+    ///
+    /// 设置后，请求将交由引擎的事件循环线程执行，所有请求共享引擎的连接缓存，并发数由引擎的最大传输数控制。
+    /// 此时通过 `call_async()` 发送的请求不会阻塞调用方线程。
+    /// 注意，此时上传下载进度回调和请求体数据流将在事件循环线程中被调用
+    #[builder(default)]
+    multi_engine: Option<CurlMultiEngine>,
+
+    /// 句柄池中最多缓存的 libcurl 句柄数，默认为 16
+    ///
+    /// 句柄池中的句柄通过共享句柄共享连接缓存，因此该值同时也决定了最多可以保持的空闲连接数。
+    /// 使用传输引擎时，句柄由引擎管理，该值不再生效
+    #[builder(default = "16")]
+    pool_size: usize,
+
+    /// 是否启用 HTTP/2，默认不启用
+    ///
+    /// 启用后，HTTPS 请求将优先通过 HTTP/2 发送，并在可能的情况下等待复用已有的 HTTP/2 连接而非建立新连接。
+    /// 与传输引擎配合使用时，发往同一主机的分块上传请求将在同一个连接上多路复用
+    #[builder(default)]
+    http2: bool,
+
+    /// 是否复用 TLS 会话，默认启用
+    ///
+    /// 启用后，句柄池中的所有句柄共享 TLS 会话缓存，建立新连接时可以通过会话恢复省去完整的 TLS 握手
+    #[builder(default = "true")]
+    tls_session_reuse: bool,
+
+    /// 最多记录连接统计信息的主机数，默认为 256
+    ///
+    /// 超出该值时，将淘汰最久未发送过请求的主机的统计信息。设置为 `0` 将不再记录连接统计信息
+    #[builder(default = "256")]
+    max_connection_stats_hosts: usize,
+
+    #[builder(default, setter(skip))]
+    easy_pool: Option<EasyPool>,
+
+    #[builder(default, setter(skip))]
+    share: Option<Share>,
+
+    #[builder(default, setter(skip))]
+    connection_stats: Arc<ConnectionStatsRecorder>,
 }
 
+/// 按主机记录连接统计信息
+///
+/// 异步请求在事件循环线程中结束，因此记录仪需要被 `CurlClient` 和尚未结束的异步请求共同持有
+#[derive(Debug, Default)]
+struct ConnectionStatsRecorder {
+    stats: Mutex<HashMap<Box<str>, (ConnectionStats, Instant)>>,
+    max_hosts: usize,
+}
+
+/// 尚未结束的异步请求
+///
+/// 请求和临时文件目录由传输完成回调函数持有，直到传输结束后才交还给调用方，因此传输期间上下文中借用的数据始终有效。
+/// 与 `Transfer` 相同，传输期间只有事件循环线程会访问该请求
+struct AsyncCall {
+    request: Box<Request<'static>>,
+    temp_dir: Option<PathBuf>,
+}
+
+unsafe impl Send for AsyncCall {}
+
 impl HTTPCaller for CurlClient {
     fn call(&self, request: &Request) -> Result<Response> {
-        let r: &mut Easy2ContextRef = &mut *CURL_POOL.pull();
-        let mut easy: Box<Easy2<Context>> = r.into();
+        if let Some(multi_engine) = &self.multi_engine {
+            return self.call_by_multi_engine(multi_engine, request);
+        }
+        let easy_pool = self.easy_pool.as_ref().unwrap();
+        // 句柄池中的句柄不借用任何数据，这里只是将其生命周期限定到当前请求上，句柄归还句柄池前也会清空上下文
+        let mut easy: Easy2<Context> = unsafe { transmute(easy_pool.take().0) };
         self.reset_context(&mut easy);
         self.set_context(easy.get_mut(), request);
         let result = self.perform(&mut easy, request);
-        let _: Easy2ContextRef = easy.into();
+        Share::detach(&mut easy);
+        easy_pool.recycle(Transfer(unsafe { transmute(easy) }));
         result
     }
+
+    fn call_async(&self, request: Request<'static>, on_completed: HTTPCallback) {
+        match &self.multi_engine {
+            Some(multi_engine) => self.call_async_by_multi_engine(multi_engine, request, on_completed),
+            None => {
+                let result = self.call(&request);
+                on_completed(request, result)
+            }
+        }
+    }
+
+    fn connection_stats(&self, host: &str) -> Option<ConnectionStats> {
+        self.connection_stats.get(host)
+    }
 }
 
 impl CurlClient {
+    fn call_by_multi_engine(&self, multi_engine: &CurlMultiEngine, request: &Request) -> Result<Response> {
+        // 引擎中的句柄不借用任何数据，这里只是将其生命周期限定到当前请求上。
+        // 提交传输后当前线程将阻塞直到传输结束，因此传输期间上下文中借用的请求始终有效，句柄归还引擎前也会清空上下文
+        let mut easy: Easy2<Context> = unsafe { transmute(multi_engine.take_easy().0) };
+        self.reset_context(&mut easy);
+        self.set_context(easy.get_mut(), request);
+        if let Err(err) = self.prepare(&mut easy, request) {
+            Share::detach(&mut easy);
+            multi_engine.recycle_easy(Transfer(unsafe { transmute(easy) }));
+            return Err(err);
+        }
+        match multi_engine.submit(Transfer(unsafe { transmute(easy) })).wait() {
+            TransferResult::Completed(transfer, result) => {
+                let mut easy: Easy2<Context> = unsafe { transmute(transfer.0) };
+                self.connection_stats.record(&mut easy, request);
+                let response =
+                    Self::handle_if_err(result, request).and_then(|_| Self::read_response(&mut easy, request));
+                Share::detach(&mut easy);
+                multi_engine.recycle_easy(Transfer(unsafe { transmute(easy) }));
+                response
+            }
+            TransferResult::Failed(message) => Err(Self::multi_engine_error(message, request)),
+        }
+    }
+
+    fn call_async_by_multi_engine(
+        &self,
+        multi_engine: &CurlMultiEngine,
+        request: Request<'static>,
+        on_completed: HTTPCallback,
+    ) {
+        let call = AsyncCall {
+            request: Box::new(request),
+            temp_dir: self.temp_dir.to_owned(),
+        };
+        let mut easy: Easy2<Context> = unsafe { transmute(multi_engine.take_easy().0) };
+        self.reset_context(&mut easy);
+        self.set_context(easy.get_mut(), &call.request);
+        if let Some(temp_dir) = &call.temp_dir {
+            easy.get_mut().temp_dir = temp_dir.as_path();
+        }
+        if let Err(err) = self.prepare(&mut easy, &call.request) {
+            Share::detach(&mut easy);
+            multi_engine.recycle_easy(Transfer(unsafe { transmute(easy) }));
+            return on_completed(*call.request, Err(err));
+        }
+        let handle = multi_engine.submit(Transfer(unsafe { transmute(easy) }));
+        let connection_stats = self.connection_stats.to_owned();
+        let multi_engine = multi_engine.to_owned();
+        handle.on_completed(Box::new(move |result| {
+            let AsyncCall { request, temp_dir } = call;
+            let response = match result {
+                TransferResult::Completed(transfer, result) => {
+                    let mut easy: Easy2<Context> = unsafe { transmute(transfer.0) };
+                    connection_stats.record(&mut easy, &request);
+                    let response =
+                        Self::handle_if_err(result, &request).and_then(|_| Self::read_response(&mut easy, &request));
+                    Share::detach(&mut easy);
+                    multi_engine.recycle_easy(Transfer(unsafe { transmute(easy) }));
+                    response
+                }
+                TransferResult::Failed(message) => Err(Self::multi_engine_error(message, &request)),
+            };
+            // 句柄归还引擎时已经清空了上下文，此后才能释放其借用的临时文件目录
+            drop(temp_dir);
+            on_completed(*request, response)
+        }));
+    }
+
+    fn multi_engine_error(message: String, request: &Request) -> Error {
+        Error::new_retryable_error_from_req_resp(
+            ErrorKind::new_http_caller_error_kind(
+                HTTPCallerErrorKind::UnknownError,
+                IOError::new(IOErrorKind::Other, message),
+            ),
+            false,
+            request,
+            None,
+        )
+    }
+
     fn perform(&self, easy: &mut Easy2<Context>, request: &Request) -> Result<Response> {
+        self.prepare(easy, request)?;
+        let result = easy.perform();
+        self.connection_stats.record(easy, request);
+        Self::handle_if_err(result, request)?;
+        Self::read_response(easy, request)
+    }
+
+    fn prepare(&self, easy: &mut Easy2<Context>, request: &Request) -> Result<()> {
         self.set_method(easy, request)?;
         self.set_url(easy, request)?;
         self.set_headers(easy, request)?;
         self.set_body(easy, request)?;
-        self.set_options(easy, request)?;
-        Self::handle_if_err(easy.perform(), request)?;
+        self.set_options(easy, request)
+    }
+
+    fn read_response(easy: &mut Easy2<Context>, request: &Request) -> Result<Response> {
         let status_code = Self::handle_if_err(easy.response_code(), request)? as StatusCode;
         let server_ip: Option<IpAddr> =
             Self::handle_if_err(easy.primary_ip().map(|s| s.and_then(|s| s.parse().ok())), request)?;
         let server_port = Self::handle_if_err(easy.primary_port(), request)?;
-        self.build_response(easy.get_mut(), request, status_code, server_ip, server_port)
+        Self::build_response(easy.get_mut(), request, status_code, server_ip, server_port)
     }
 
     fn build_response(
-        &self,
         context: &mut Context,
         request: &Request,
         status_code: StatusCode,
@@ -129,9 +309,16 @@ impl CurlClient {
     fn set_context<'r>(&self, mut context: &mut Context<'r>, request: &'r Request<'r>) {
         context.upload_progress = request.on_uploading_progress();
         context.download_progress = request.on_downloading_progress();
+        context.cancellation_token = request.cancellation_token();
 
-        if !request.body().is_empty() {
-            context.request_body = Some(Cursor::new(request.body()));
+        match request.body() {
+            RequestBody::Bytes(bytes) if !bytes.is_empty() => {
+                context.request_body = Some(RequestBodyReader::Bytes(Cursor::new(bytes.as_ref())));
+            }
+            RequestBody::Stream(stream) => {
+                context.request_body = Some(RequestBodyReader::Stream(*stream));
+            }
+            _ => {}
         }
 
         match request.method() {
@@ -167,8 +354,14 @@ impl CurlClient {
     }
 
     fn set_body<T>(&self, easy: &mut Easy2<T>, request: &Request) -> Result<()> {
+        if let RequestBody::Stream(stream) = request.body() {
+            // 数据流可能已经在之前的请求中被读取过，因此每次发送前都需要倒回开头
+            stream.seek(0).map_err(|err| {
+                Error::new_unretryable_error_from_req_resp(ErrorKind::IOError(err), request, None)
+            })?;
+        }
         if !request.body().is_empty() {
-            Self::handle_if_err(easy.post_field_size(request.body().len().try_into().unwrap()), request)?;
+            Self::handle_if_err(easy.post_field_size(request.body().len()), request)?;
         }
         Ok(())
     }
@@ -218,8 +411,20 @@ impl CurlClient {
             request,
         )?;
         Self::handle_if_err(easy.show_header(false), request)?;
+        if self.http2 {
+            Self::handle_if_err(easy.http_version(HttpVersion::V2TLS), request)?;
+            Self::handle_if_err(easy.pipewait(true), request)?;
+        }
+        if let Some(share) = &self.share {
+            share.attach(easy);
+        }
         Self::handle_if_err(
-            easy.progress(request.on_uploading_progress().is_some() || request.on_downloading_progress().is_some()),
+            // 设置了取消令牌时，同样需要进度回调，以便在传输进行期间检查令牌是否已经被取消
+            easy.progress(
+                request.on_uploading_progress().is_some()
+                    || request.on_downloading_progress().is_some()
+                    || request.cancellation_token().is_some(),
+            ),
             request,
         )?;
         Ok(())
@@ -229,7 +434,14 @@ impl CurlClient {
         match result {
             Ok(result) => Ok(result),
             Err(err) => {
-                if err.is_partial_file() || err.is_read_error() {
+                if request.cancellation_token().map_or(false, |token| token.is_canceled()) {
+                    // 由取消令牌中止的传输，无论 libcurl 返回何种错误，均视为用户取消
+                    Err(Error::new_unretryable_error_from_req_resp(
+                        ErrorKind::UserCanceled,
+                        request,
+                        None,
+                    ))
+                } else if err.is_partial_file() || err.is_read_error() {
                     Err(Error::new_retryable_error_from_req_resp(
                         ErrorKind::new_http_caller_error_kind(HTTPCallerErrorKind::UnknownError, err),
                         false,
@@ -324,7 +536,7 @@ enum ProgressStatus {
 }
 
 struct Context<'r> {
-    request_body: Option<Cursor<&'r [u8]>>,
+    request_body: Option<RequestBodyReader<'r>>,
     response_body: Option<ResponseBody>,
     response_headers: Option<Headers<'static>>,
     buffer_size: usize,
@@ -332,6 +544,12 @@ struct Context<'r> {
     progress_status: ProgressStatus,
     upload_progress: Option<ProgressCallback<'r>>,
     download_progress: Option<ProgressCallback<'r>>,
+    cancellation_token: Option<&'r CancellationToken>,
+}
+
+enum RequestBodyReader<'r> {
+    Bytes(Cursor<&'r [u8]>),
+    Stream(&'r dyn RequestBodyStream),
 }
 
 enum ResponseBody {
@@ -361,19 +579,30 @@ impl<'r> Handler for Context<'r> {
     }
 
     fn read(&mut self, data: &mut [u8]) -> result::Result<usize, ReadError> {
-        self.request_body.as_mut().map_or(Ok(0), |request_body| {
-            request_body.read(data).map_err(|_| ReadError::Abort)
-        })
+        if self.is_canceled() {
+            return Err(ReadError::Abort);
+        }
+        match &mut self.request_body {
+            Some(RequestBodyReader::Bytes(request_body)) => request_body.read(data).map_err(|_| ReadError::Abort),
+            Some(RequestBodyReader::Stream(request_body)) => request_body.read(data).map_err(|_| ReadError::Abort),
+            None => Ok(0),
+        }
     }
 
     fn seek(&mut self, whence: SeekFrom) -> SeekResult {
-        if let Some(request_body) = &mut self.request_body {
-            match request_body.seek(whence) {
+        match (&mut self.request_body, whence) {
+            (Some(RequestBodyReader::Bytes(request_body)), whence) => match request_body.seek(whence) {
                 Ok(_) => SeekResult::Ok,
                 Err(_) => SeekResult::Fail,
+            },
+            // libcurl 仅会以 SEEK_SET 的方式倒回请求体
+            (Some(RequestBodyReader::Stream(request_body)), SeekFrom::Start(offset)) => {
+                match request_body.seek(offset) {
+                    Ok(_) => SeekResult::Ok,
+                    Err(_) => SeekResult::Fail,
+                }
             }
-        } else {
-            SeekResult::CantSeek
+            _ => SeekResult::CantSeek,
         }
     }
 
@@ -412,6 +641,10 @@ impl<'r> Handler for Context<'r> {
         let ultotal = ultotal as u64;
         let ulnow = ulnow as u64;
 
+        // 返回 false 将使 libcurl 立即中止传输
+        if self.is_canceled() {
+            return false;
+        }
         if dltotal == 0 && ultotal == 0 {
             return true;
         }
@@ -461,14 +694,95 @@ impl<'r> Handler for Context<'r> {
 
 impl Default for CurlClient {
     fn default() -> Self {
-        INITIALIZER.call_once(curl::init);
         CurlClientBuilder::default().build()
     }
 }
 
 impl CurlClientBuilder {
-    fn build(self) -> CurlClient {
-        self.inner_build().unwrap()
+    /// 创建 libcurl 客户端
+    pub fn build(self) -> CurlClient {
+        INITIALIZER.call_once(curl::init);
+        let mut client = self.inner_build().unwrap();
+        client.easy_pool = Some(EasyPool::new(client.pool_size));
+        client.share = Share::new(client.tls_session_reuse);
+        client.connection_stats = Arc::new(ConnectionStatsRecorder::new(client.max_connection_stats_hosts));
+        client
+    }
+}
+
+impl ConnectionStatsRecorder {
+    fn new(max_hosts: usize) -> Self {
+        Self {
+            stats: Default::default(),
+            max_hosts,
+        }
+    }
+
+    fn get(&self, host: &str) -> Option<ConnectionStats> {
+        self.stats.lock().unwrap().get(host).map(|(stats, _)| *stats)
+    }
+
+    /// 记录请求所使用的连接是新建立的还是复用的，以及新建立连接的握手耗时
+    fn record<T>(&self, easy: &mut Easy2<T>, request: &Request) {
+        if self.max_hosts == 0 {
+            return;
+        }
+        let host = match Url::parse(request.url()) {
+            Ok(url) => match url.host_str() {
+                Some(host) => host.to_owned(),
+                None => return,
+            },
+            Err(_) => return,
+        };
+        let connections = match easy.num_connects() {
+            Ok(connections) => u64::from(connections),
+            Err(_) => return,
+        };
+        let namelookup_time = easy.namelookup_time().unwrap_or_default();
+        let connect_time = easy.connect_time().unwrap_or_default();
+        let appconnect_time = easy.appconnect_time().unwrap_or_default();
+        if metrics::is_enabled() {
+            if connections > 0 {
+                if let Some(duration) = connect_time.checked_sub(namelookup_time) {
+                    metrics::record_duration(Timing::Connect, duration);
+                }
+                // 仅 HTTPS 请求存在 TLS 握手，否则 appconnect_time 总为 0
+                if appconnect_time > Duration::from_secs(0) {
+                    if let Some(duration) = appconnect_time.checked_sub(connect_time) {
+                        metrics::record_duration(Timing::TLSHandshake, duration);
+                    }
+                }
+            }
+            if let Ok(starttransfer_time) = easy.starttransfer_time() {
+                metrics::record_duration(Timing::TimeToFirstByte, starttransfer_time);
+            }
+        }
+        let now = Instant::now();
+        let mut connection_stats = self.stats.lock().unwrap();
+        if connection_stats.len() >= self.max_hosts && !connection_stats.contains_key(host.as_str()) {
+            // 主机数通常很少，仅在记录新主机且已达上限时才遍历查找最久未使用的主机
+            let least_recently_used = connection_stats
+                .iter()
+                .min_by_key(|(_, (_, last_used))| *last_used)
+                .map(|(host, _)| host.to_owned());
+            if let Some(least_recently_used) = least_recently_used {
+                connection_stats.remove(&least_recently_used);
+            }
+        }
+        let (stats, last_used) = connection_stats
+            .entry(host.into())
+            .or_insert_with(|| (Default::default(), now));
+        *last_used = now;
+        if connections > 0 {
+            // 对于 HTTPS 请求，TLS 握手完成的时刻晚于 TCP 连接建立的时刻，取两者中较晚的一个
+            let handshake_duration = appconnect_time
+                .max(connect_time)
+                .checked_sub(namelookup_time)
+                .unwrap_or_else(|| Duration::from_secs(0));
+            stats.record_opened(connections, handshake_duration);
+        } else {
+            stats.record_reused();
+        }
     }
 }
 
@@ -482,6 +796,11 @@ impl<'r> Context<'r> {
         self.progress_status = ProgressStatus::Initialized;
         self.upload_progress = None;
         self.download_progress = None;
+        self.cancellation_token = None;
+    }
+
+    fn is_canceled(&self) -> bool {
+        self.cancellation_token.map_or(false, |token| token.is_canceled())
     }
 }
 
@@ -496,47 +815,7 @@ impl<'r> Default for Context<'r> {
             progress_status: ProgressStatus::Initialized,
             upload_progress: None,
             download_progress: None,
+            cancellation_token: None,
         }
     }
 }
-
-struct Easy2ContextRef([u8; size_of::<*mut Easy2<Context<'static>>>()]);
-
-impl Default for Easy2ContextRef {
-    fn default() -> Self {
-        Box::new(Easy2::new(Context::default())).into()
-    }
-}
-
-impl<'r> From<Easy2ContextRef> for Box<Easy2<Context<'r>>> {
-    fn from(r: Easy2ContextRef) -> Self {
-        unsafe {
-            let ptr: *mut Easy2<Context<'r>> = transmute(r);
-            Box::from_raw(ptr)
-        }
-    }
-}
-
-impl<'r> From<&'r Easy2ContextRef> for Box<Easy2<Context<'r>>> {
-    fn from(r: &'r Easy2ContextRef) -> Self {
-        unsafe {
-            let ptr: *mut Easy2<Context<'r>> = transmute_copy(r);
-            Box::from_raw(ptr)
-        }
-    }
-}
-
-impl<'r> From<&'r mut Easy2ContextRef> for Box<Easy2<Context<'r>>> {
-    fn from(r: &'r mut Easy2ContextRef) -> Self {
-        unsafe {
-            let ptr: *mut Easy2<Context<'r>> = transmute_copy(r);
-            Box::from_raw(ptr)
-        }
-    }
-}
-
-impl<'r> From<Box<Easy2<Context<'r>>>> for Easy2ContextRef {
-    fn from(context: Box<Easy2<Context<'r>>>) -> Self {
-        unsafe { transmute(Box::into_raw(context)) }
-    }
-}
@@ -0,0 +1,519 @@
+use super::{pool::EasyPool, Context, INITIALIZER};
+use curl::{
+    easy::Easy2,
+    multi::{Easy2Handle, Multi, Socket, WaitFd},
+};
+use derive_builder::Builder;
+use std::{
+    collections::{HashMap, VecDeque},
+    fmt,
+    io::{ErrorKind as IOErrorKind, Result as IOResult},
+    net::{Ipv4Addr, UdpSocket},
+    sync::{
+        atomic::{AtomicUsize, Ordering::Relaxed},
+        mpsc::{channel, Receiver, Sender, TryRecvError},
+        Arc, Condvar, Mutex,
+    },
+    thread::Builder as ThreadBuilder,
+    time::Duration,
+};
+
+#[cfg(unix)]
+use std::os::unix::io::AsRawFd;
+#[cfg(windows)]
+use std::os::windows::io::AsRawSocket;
+
+/// 基于 libcurl multi 接口的传输引擎
+///
+/// 由少量事件循环线程同时驱动大量 HTTP 传输，所有传输共享连接缓存，并可在 HTTP/2 连接上多路复用。
+/// 通过 `HTTPCaller::call()` 发起的请求依然会阻塞调用方线程直到传输结束，
+/// 而通过 `HTTPCaller::call_async()` 发起的请求在提交后立即返回，传输结束后将在事件循环线程中调用完成回调函数，期间不占用调用方线程。
+/// 并发数以同时进行的传输数计算，超出并发数的传输将排队等待。
+/// 引擎可以被克隆，克隆出的引擎共享同一组事件循环线程和连接缓存
+#[derive(Builder, Clone)]
+#[builder(pattern = "owned", build_fn(name = "inner_build", private))]
+pub struct CurlMultiEngine {
+    /// 事件循环线程数，默认为 1
+    #[builder(default = "1")]
+    event_loop_threads: usize,
+
+    /// 最大同时进行的传输数，默认为 64，将平均分配给每个事件循环线程
+    #[builder(default = "64")]
+    max_transfers: usize,
+
+    /// 是否在 HTTP/2 连接上多路复用传输，默认启用
+    ///
+    /// 启用后，发往同一主机的 HTTP/2 传输将共用同一个连接，仅对启用了 HTTP/2 的 `CurlClient` 发送的请求有效
+    #[builder(default = "true")]
+    multiplexing: bool,
+
+    #[builder(setter(skip))]
+    inner: Option<Arc<EngineInner>>,
+}
+
+struct EngineInner {
+    event_loops: Vec<EventLoopHandle>,
+    next_event_loop: AtomicUsize,
+    easy_pool: EasyPool,
+}
+
+struct EventLoopHandle {
+    sender: Mutex<Sender<Job>>,
+    wakeup: Option<Wakeup>,
+}
+
+/// 唤醒事件循环线程的本地 UDP 套接字
+///
+/// 事件循环线程在等待网络事件时同时监听该套接字，提交传输后向该套接字发送一个字节即可立即唤醒事件循环线程，
+/// 因此等待期间无需频繁超时醒来检查新任务
+struct Wakeup(UdpSocket);
+
+/// 提交给事件循环线程的传输
+///
+/// libcurl 的句柄及其回调上下文本身并不保证线程安全，这里由引擎保证同一时刻只有一个线程访问它：
+/// 提交后直到完成前，只有事件循环线程会访问该传输，而提交者只能通过 `TransferHandle` 等待其完成或设置完成回调函数
+pub(super) struct Transfer(pub(super) Easy2<Context<'static>>);
+
+unsafe impl Send for Transfer {}
+
+struct Job {
+    transfer: Transfer,
+    state: Arc<TransferState>,
+}
+
+/// 传输结果
+pub(super) enum TransferResult {
+    /// 传输已经结束，附带 libcurl 句柄和传输结果
+    Completed(Transfer, Result<(), curl::Error>),
+
+    /// 传输未能被 libcurl multi 接口执行，附带错误信息，此时 libcurl 句柄已被释放
+    Failed(String),
+}
+
+/// 传输完成回调函数，将在事件循环线程中被调用
+pub(super) type TransferCallback = Box<dyn FnOnce(TransferResult) + Send>;
+
+#[derive(Default)]
+struct TransferState {
+    status: Mutex<TransferStatus>,
+    condvar: Condvar,
+}
+
+#[derive(Default)]
+struct TransferStatus {
+    result: Option<TransferResult>,
+    on_completed: Option<TransferCallback>,
+}
+
+/// 等待传输完成的句柄
+///
+/// 同步请求的提交者线程将调用 `wait()` 阻塞等待传输结束，异步请求则调用 `on_completed()` 设置完成回调函数后立即返回
+pub(super) struct TransferHandle {
+    state: Arc<TransferState>,
+}
+
+impl CurlMultiEngine {
+    /// 提交传输，返回等待传输完成的句柄
+    pub(super) fn submit(&self, transfer: Transfer) -> TransferHandle {
+        let inner = self.inner.as_ref().unwrap();
+        let state = Arc::new(TransferState::default());
+        let index = inner.next_event_loop.fetch_add(1, Relaxed) % inner.event_loops.len();
+        let event_loop = &inner.event_loops[index];
+        let job = Job {
+            transfer,
+            state: state.to_owned(),
+        };
+        match event_loop.sender.lock().unwrap().send(job) {
+            Ok(()) => {
+                if let Some(wakeup) = &event_loop.wakeup {
+                    wakeup.wake();
+                }
+            }
+            Err(err) => {
+                // 事件循环线程只会在引擎被销毁后退出，因此这里只是防御性处理
+                err.0
+                    .state
+                    .complete(TransferResult::Failed("Curl multi event loop is stopped".to_owned()));
+            }
+        }
+        TransferHandle { state }
+    }
+
+    /// 取出一个空闲的 libcurl 句柄，如果没有则创建一个
+    pub(super) fn take_easy(&self) -> Transfer {
+        self.inner.as_ref().unwrap().easy_pool.take()
+    }
+
+    /// 归还 libcurl 句柄，以便之后的传输复用
+    pub(super) fn recycle_easy(&self, transfer: Transfer) {
+        self.inner.as_ref().unwrap().easy_pool.recycle(transfer)
+    }
+
+    fn run_event_loop(receiver: Receiver<Job>, wakeup: Option<Wakeup>, max_transfers: usize, multiplexing: bool) {
+        let mut multi = Multi::new();
+        let _ = multi.pipelining(false, multiplexing);
+        let mut pending = VecDeque::<Job>::new();
+        let mut running = HashMap::<usize, (Easy2Handle<Context<'static>>, Arc<TransferState>)>::new();
+        let mut next_token = 0usize;
+        let mut disconnected = false;
+        loop {
+            if running.is_empty() && pending.is_empty() {
+                if disconnected {
+                    return;
+                }
+                // 没有正在进行的传输时阻塞等待新任务，不占用 CPU
+                match receiver.recv() {
+                    Ok(job) => pending.push_back(job),
+                    Err(_) => return,
+                }
+            }
+            loop {
+                match receiver.try_recv() {
+                    Ok(job) => pending.push_back(job),
+                    Err(TryRecvError::Empty) => break,
+                    Err(TryRecvError::Disconnected) => {
+                        disconnected = true;
+                        break;
+                    }
+                }
+            }
+            while running.len() < max_transfers {
+                let job = match pending.pop_front() {
+                    Some(job) => job,
+                    None => break,
+                };
+                match multi.add2(job.transfer.0) {
+                    Ok(mut handle) => match handle.set_token(next_token) {
+                        Ok(()) => {
+                            running.insert(next_token, (handle, job.state));
+                            next_token = next_token.wrapping_add(1);
+                        }
+                        Err(err) => match multi.remove2(handle) {
+                            Ok(easy) => job.state.complete(TransferResult::Completed(Transfer(easy), Err(err))),
+                            Err(err) => job.state.complete(TransferResult::Failed(err.to_string())),
+                        },
+                    },
+                    Err(err) => job.state.complete(TransferResult::Failed(err.to_string())),
+                }
+            }
+            if running.is_empty() {
+                continue;
+            }
+
+            if let Err(err) = multi.perform() {
+                for (_, (handle, state)) in running.drain() {
+                    let _ = multi.remove2(handle);
+                    state.complete(TransferResult::Failed(err.to_string()));
+                }
+                continue;
+            }
+            let mut completed = Vec::new();
+            multi.messages(|message| {
+                if let (Ok(token), Some(result)) = (message.token(), message.result()) {
+                    completed.push((token, result));
+                }
+            });
+            for (token, result) in completed {
+                if let Some((handle, state)) = running.remove(&token) {
+                    match multi.remove2(handle) {
+                        Ok(easy) => state.complete(TransferResult::Completed(Transfer(easy), result)),
+                        Err(err) => state.complete(TransferResult::Failed(err.to_string())),
+                    }
+                }
+            }
+            if !running.is_empty() {
+                // libcurl 会将等待时长缩短到其内部下一个超时时刻，新任务则通过唤醒套接字立即打断等待。
+                // 仅在无法创建唤醒套接字时才退化为短超时轮询，此时超时时长决定了新任务最长的排队延迟
+                match &wakeup {
+                    Some(wakeup) => {
+                        let _ = multi.wait(&mut [wakeup.wait_fd()], Duration::from_secs(1));
+                    }
+                    None => {
+                        let _ = multi.wait(&mut [], Duration::from_millis(10));
+                    }
+                }
+            }
+            if let Some(wakeup) = &wakeup {
+                wakeup.drain();
+            }
+        }
+    }
+}
+
+impl CurlMultiEngineBuilder {
+    /// 创建传输引擎，并启动事件循环线程
+    pub fn build(self) -> CurlMultiEngine {
+        INITIALIZER.call_once(curl::init);
+        let mut engine = self.inner_build().unwrap();
+        let event_loop_threads = engine.event_loop_threads.max(1);
+        let max_transfers = engine.max_transfers.max(1);
+        let max_transfers_per_thread = (max_transfers + event_loop_threads - 1) / event_loop_threads;
+        let multiplexing = engine.multiplexing;
+        let event_loops = (0..event_loop_threads)
+            .map(|index| {
+                let (sender, receiver) = channel();
+                let (wakeup, event_loop_wakeup) = match Wakeup::new() {
+                    Ok((wakeup, event_loop_wakeup)) => (Some(wakeup), Some(event_loop_wakeup)),
+                    Err(_) => (None, None),
+                };
+                ThreadBuilder::new()
+                    .name(format!("curl_multi_event_loop_{}", index))
+                    .spawn(move || {
+                        CurlMultiEngine::run_event_loop(
+                            receiver,
+                            event_loop_wakeup,
+                            max_transfers_per_thread,
+                            multiplexing,
+                        )
+                    })
+                    .unwrap();
+                EventLoopHandle {
+                    sender: Mutex::new(sender),
+                    wakeup,
+                }
+            })
+            .collect();
+        engine.inner = Some(Arc::new(EngineInner {
+            event_loops,
+            next_event_loop: AtomicUsize::new(0),
+            easy_pool: EasyPool::new(max_transfers),
+        }));
+        engine
+    }
+}
+
+impl Wakeup {
+    /// 创建一对共享同一个套接字的唤醒句柄，前者用于唤醒，后者交给事件循环线程监听
+    fn new() -> IOResult<(Self, Self)> {
+        let socket = UdpSocket::bind((Ipv4Addr::LOCALHOST, 0))?;
+        socket.connect(socket.local_addr()?)?;
+        socket.set_nonblocking(true)?;
+        Ok((Self(socket.try_clone()?), Self(socket)))
+    }
+
+    fn wake(&self) {
+        // 发送缓冲区已满时，说明已经有尚未处理的唤醒，忽略即可
+        let _ = self.0.send(&[0]);
+    }
+
+    fn drain(&self) {
+        let mut buf = [0u8; 64];
+        loop {
+            match self.0.recv(&mut buf) {
+                Ok(_) => continue,
+                Err(ref err) if err.kind() == IOErrorKind::Interrupted => continue,
+                Err(_) => return,
+            }
+        }
+    }
+
+    fn wait_fd(&self) -> WaitFd {
+        let mut wait_fd = WaitFd::new();
+        wait_fd.set_fd(self.raw_socket());
+        wait_fd.poll_on_read(true);
+        wait_fd
+    }
+
+    #[cfg(unix)]
+    fn raw_socket(&self) -> Socket {
+        self.0.as_raw_fd() as Socket
+    }
+
+    #[cfg(windows)]
+    fn raw_socket(&self) -> Socket {
+        self.0.as_raw_socket() as Socket
+    }
+}
+
+impl TransferState {
+    fn complete(&self, result: TransferResult) {
+        let mut status = self.status.lock().unwrap();
+        match status.on_completed.take() {
+            Some(on_completed) => {
+                // 回调函数内可能会再次提交传输，因此调用前先释放锁
+                drop(status);
+                on_completed(result);
+            }
+            None => {
+                status.result = Some(result);
+                self.condvar.notify_all();
+            }
+        }
+    }
+}
+
+impl TransferHandle {
+    /// 阻塞等待传输完成
+    pub(super) fn wait(self) -> TransferResult {
+        let mut status = self.state.status.lock().unwrap();
+        loop {
+            if let Some(result) = status.result.take() {
+                return result;
+            }
+            status = self.state.condvar.wait(status).unwrap();
+        }
+    }
+
+    /// 设置传输完成回调函数，不阻塞当前线程
+    ///
+    /// 如果传输已经结束，将在当前线程中立即调用回调函数，否则将在传输结束后由事件循环线程调用
+    pub(super) fn on_completed(self, on_completed: TransferCallback) {
+        let mut status = self.state.status.lock().unwrap();
+        match status.result.take() {
+            Some(result) => {
+                drop(status);
+                on_completed(result);
+            }
+            None => status.on_completed = Some(on_completed),
+        }
+    }
+}
+
+impl fmt::Debug for CurlMultiEngine {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_struct("CurlMultiEngine")
+            .field("event_loop_threads", &self.event_loop_threads)
+            .field("max_transfers", &self.max_transfers)
+            .field("multiplexing", &self.multiplexing)
+            .finish()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::{super::CurlClientBuilder, *};
+    use qiniu_http::{HTTPCaller, Method, RequestBuilder};
+    use std::{
+        error::Error,
+        io::{Read, Write},
+        net::{SocketAddr, TcpListener, TcpStream},
+        result::Result,
+        sync::mpsc::RecvTimeoutError,
+        thread,
+        time::Instant,
+    };
+
+    /// 仅用于测试的 HTTP 服务器，每个连接均保持长连接，收到放行信号后才开始响应请求
+    fn start_server(released: Arc<(Mutex<bool>, Condvar)>) -> Result<SocketAddr, Box<dyn Error>> {
+        let listener = TcpListener::bind((Ipv4Addr::LOCALHOST, 0))?;
+        let addr = listener.local_addr()?;
+        thread::spawn(move || {
+            for stream in listener.incoming() {
+                if let Ok(stream) = stream {
+                    let released = released.to_owned();
+                    thread::spawn(move || serve(stream, released));
+                }
+            }
+        });
+        Ok(addr)
+    }
+
+    fn serve(mut stream: TcpStream, released: Arc<(Mutex<bool>, Condvar)>) {
+        let mut request = Vec::new();
+        let mut buf = [0u8; 1024];
+        loop {
+            match stream.read(&mut buf) {
+                Ok(0) | Err(_) => return,
+                Ok(n) => request.extend_from_slice(&buf[..n]),
+            }
+            while let Some(end) = request.windows(4).position(|window| window == b"\r\n\r\n") {
+                request.drain(..end + 4);
+                {
+                    let (lock, condvar) = &*released;
+                    let mut released = lock.lock().unwrap();
+                    // 最多等待 10 秒，避免测试失败时服务器线程永远无法退出
+                    while !*released {
+                        released = condvar.wait_timeout(released, Duration::from_secs(10)).unwrap().0;
+                        *released = true;
+                    }
+                }
+                if stream
+                    .write_all(b"HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: keep-alive\r\n\r\nok")
+                    .is_err()
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    fn release(released: &(Mutex<bool>, Condvar)) {
+        *released.0.lock().unwrap() = true;
+        released.1.notify_all();
+    }
+
+    #[test]
+    fn test_curl_multi_engine_concurrent_async_calls() -> Result<(), Box<dyn Error>> {
+        let released = Arc::new((Mutex::new(false), Condvar::new()));
+        let addr = start_server(released.to_owned())?;
+        let client = CurlClientBuilder::default()
+            .multi_engine(CurlMultiEngineBuilder::default().max_transfers(4).build())
+            .build();
+        let (sender, receiver) = channel();
+        let begin_at = Instant::now();
+        for i in 0..16 {
+            let sender = sender.to_owned();
+            let request = RequestBuilder::default()
+                .method(Method::GET)
+                .url(format!("http://{}/{}", addr, i))
+                .build();
+            client.call_async(
+                request,
+                Box::new(move |request, result| {
+                    let _ = sender.send((request.url().to_owned(), result.map(|response| response.status_code())));
+                }),
+            );
+        }
+        // 服务器放行之前所有传输都无法结束，因此提交传输时不应阻塞当前线程
+        assert!(begin_at.elapsed() < Duration::from_secs(5));
+        match receiver.recv_timeout(Duration::from_millis(100)) {
+            Err(RecvTimeoutError::Timeout) => {}
+            _ => panic!("Transfer should not be completed before released"),
+        }
+        release(&released);
+
+        let mut urls = Vec::with_capacity(16);
+        for _ in 0..16 {
+            let (url, status_code) = receiver.recv_timeout(Duration::from_secs(30))?;
+            assert_eq!(status_code?, 200);
+            urls.push(url);
+        }
+        urls.sort();
+        urls.dedup();
+        assert_eq!(urls.len(), 16);
+        let stats = client.connection_stats(&addr.ip().to_string()).unwrap();
+        assert_eq!(stats.connections_opened() + stats.connections_reused(), 16);
+        assert!(stats.connections_opened() <= 4);
+        Ok(())
+    }
+
+    #[test]
+    fn test_curl_multi_engine_concurrent_sync_calls() -> Result<(), Box<dyn Error>> {
+        let released = Arc::new((Mutex::new(true), Condvar::new()));
+        let addr = start_server(released)?;
+        let client = Arc::new(
+            CurlClientBuilder::default()
+                .multi_engine(CurlMultiEngineBuilder::default().max_transfers(2).build())
+                .build(),
+        );
+        let threads = (0..8)
+            .map(|i| {
+                let client = client.to_owned();
+                thread::spawn(move || {
+                    let request = RequestBuilder::default()
+                        .method(Method::GET)
+                        .url(format!("http://{}/{}", addr, i))
+                        .build();
+                    client.call(&request).map(|response| response.status_code())
+                })
+            })
+            .collect::<Vec<_>>();
+        for thread in threads {
+            assert_eq!(thread.join().unwrap()?, 200);
+        }
+        let stats = client.connection_stats(&addr.ip().to_string()).unwrap();
+        assert_eq!(stats.connections_opened() + stats.connections_reused(), 8);
+        assert!(stats.connections_opened() <= 2);
+        Ok(())
+    }
+}
@@ -0,0 +1,48 @@
+use super::{multi::Transfer, Context};
+use curl::easy::Easy2;
+use std::{fmt, sync::Mutex};
+
+/// libcurl 句柄池
+///
+/// 缓存已经使用过的 libcurl 句柄，复用句柄的同时也就复用了句柄内缓存的连接，避免每个请求都重新建立连接。
+/// 池内缓存的句柄数不会超过创建时指定的最大值，超出的句柄在归还时将直接释放
+pub(super) struct EasyPool {
+    idle_easies: Mutex<Vec<Transfer>>,
+    max_idle_easies: usize,
+}
+
+impl EasyPool {
+    pub(super) fn new(max_idle_easies: usize) -> EasyPool {
+        EasyPool {
+            idle_easies: Mutex::new(Vec::with_capacity(max_idle_easies)),
+            max_idle_easies,
+        }
+    }
+
+    /// 取出一个空闲的 libcurl 句柄，如果没有则创建一个
+    pub(super) fn take(&self) -> Transfer {
+        self.idle_easies
+            .lock()
+            .unwrap()
+            .pop()
+            .unwrap_or_else(|| Transfer(Easy2::new(Context::default())))
+    }
+
+    /// 归还 libcurl 句柄，以便之后的请求复用
+    pub(super) fn recycle(&self, mut transfer: Transfer) {
+        transfer.0.get_mut().reset();
+        let mut idle_easies = self.idle_easies.lock().unwrap();
+        if idle_easies.len() < self.max_idle_easies {
+            idle_easies.push(transfer);
+        }
+    }
+}
+
+impl fmt::Debug for EasyPool {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_struct("EasyPool")
+            .field("idle_easies", &self.idle_easies.lock().unwrap().len())
+            .field("max_idle_easies", &self.max_idle_easies)
+            .finish()
+    }
+}
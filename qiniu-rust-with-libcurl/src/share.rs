@@ -0,0 +1,119 @@
+use curl::{easy::Easy2, Version};
+use curl_sys::{curl_easy_setopt, curl_share_cleanup, curl_share_init, curl_share_setopt, CURL, CURLOPT_SHARE, CURLSH};
+use std::{
+    fmt,
+    os::raw::{c_int, c_void},
+    ptr::null_mut,
+    sync::{Condvar, Mutex},
+};
+
+// 以下常量与 curl/curl.h 中的定义保持一致
+const CURLSHOPT_SHARE: c_int = 1;
+const CURLSHOPT_LOCKFUNC: c_int = 3;
+const CURLSHOPT_UNLOCKFUNC: c_int = 4;
+const CURLSHOPT_USERDATA: c_int = 5;
+const CURL_LOCK_DATA_DNS: c_int = 3;
+const CURL_LOCK_DATA_SSL_SESSION: c_int = 4;
+const CURL_LOCK_DATA_CONNECT: c_int = 5;
+const CURL_LOCK_DATA_LAST: usize = 7;
+
+/// libcurl 共享句柄
+///
+/// 令多个 libcurl 句柄共享 DNS 缓存，TLS 会话缓存以及连接缓存（libcurl 7.57.0 及以上版本），
+/// 从而使得从句柄池中取出的任意句柄都可以复用其他句柄建立的连接或 TLS 会话。
+/// libcurl 要求由调用方为共享数据加锁，这里为每一类共享数据各分配一把锁
+pub(super) struct Share {
+    handle: *mut CURLSH,
+    locks: Box<[ShareLock; CURL_LOCK_DATA_LAST]>,
+}
+
+#[derive(Default)]
+struct ShareLock {
+    locked: Mutex<bool>,
+    condvar: Condvar,
+}
+
+unsafe impl Send for Share {}
+unsafe impl Sync for Share {}
+
+impl Share {
+    pub(super) fn new(tls_session_reuse: bool) -> Option<Share> {
+        let handle = unsafe { curl_share_init() };
+        if handle.is_null() {
+            return None;
+        }
+        let mut share = Share {
+            handle,
+            locks: Default::default(),
+        };
+        let lock_func: extern "C" fn(*mut CURL, c_int, c_int, *mut c_void) = lock;
+        let unlock_func: extern "C" fn(*mut CURL, c_int, *mut c_void) = unlock;
+        let locks: *mut [ShareLock; CURL_LOCK_DATA_LAST] = &mut *share.locks;
+        unsafe {
+            curl_share_setopt(handle, CURLSHOPT_USERDATA, locks as *mut c_void);
+            curl_share_setopt(handle, CURLSHOPT_LOCKFUNC, lock_func);
+            curl_share_setopt(handle, CURLSHOPT_UNLOCKFUNC, unlock_func);
+            curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            if tls_session_reuse {
+                curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+            }
+            if Version::get().version_num() >= 0x07_39_00 {
+                curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+            }
+        }
+        Some(share)
+    }
+
+    /// 令 libcurl 句柄使用共享数据
+    pub(super) fn attach<H>(&self, easy: &mut Easy2<H>) {
+        unsafe {
+            curl_easy_setopt(easy.raw(), CURLOPT_SHARE, self.handle);
+        }
+    }
+
+    /// 令 libcurl 句柄不再使用共享数据
+    ///
+    /// `curl_easy_reset()` 并不会解除句柄与共享句柄之间的关联，句柄在归还句柄池前必须调用本方法，
+    /// 以免句柄存活得比共享句柄更久
+    pub(super) fn detach<H>(easy: &mut Easy2<H>) {
+        unsafe {
+            curl_easy_setopt(easy.raw(), CURLOPT_SHARE, null_mut::<CURLSH>());
+        }
+    }
+}
+
+impl Drop for Share {
+    fn drop(&mut self) {
+        unsafe {
+            curl_share_cleanup(self.handle);
+        }
+    }
+}
+
+impl fmt::Debug for Share {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_struct("Share").field("handle", &self.handle).finish()
+    }
+}
+
+extern "C" fn lock(_handle: *mut CURL, data: c_int, _access: c_int, userptr: *mut c_void) {
+    if let Some(share_lock) = share_lock(data, userptr) {
+        let mut locked = share_lock.locked.lock().unwrap();
+        while *locked {
+            locked = share_lock.condvar.wait(locked).unwrap();
+        }
+        *locked = true;
+    }
+}
+
+extern "C" fn unlock(_handle: *mut CURL, data: c_int, userptr: *mut c_void) {
+    if let Some(share_lock) = share_lock(data, userptr) {
+        *share_lock.locked.lock().unwrap() = false;
+        share_lock.condvar.notify_one();
+    }
+}
+
+fn share_lock<'l>(data: c_int, userptr: *mut c_void) -> Option<&'l ShareLock> {
+    let locks = unsafe { &*(userptr as *const [ShareLock; CURL_LOCK_DATA_LAST]) };
+    locks.get(data as usize)
+}
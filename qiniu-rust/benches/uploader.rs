@@ -0,0 +1,96 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use qiniu_http::{Response, ResponseBuilder, Result as HTTPResult};
+use qiniu_ng::{
+    benchmark::bucket_uploader_builder,
+    http::{DomainsManagerBuilder, Headers, Method},
+    storage::uploader::{UploadPolicyBuilder, UploadToken},
+    ConfigBuilder, Credential,
+};
+use qiniu_test_utils::{
+    http_call_mock::{fake_req_id, CallHandlers},
+    temp_file::create_temp_file,
+};
+use serde_json::{json, Value};
+
+const FILE_SIZE: usize = 1 << 25;
+const CONCURRENCY: &[usize] = &[1, 2, 4, 8];
+
+fn json_response(body: Value) -> HTTPResult<Response> {
+    let mut headers = Headers::new();
+    headers.insert("Content-Type".into(), "application/json".into());
+    headers.insert("X-Reqid".into(), fake_req_id().into());
+    Ok(ResponseBuilder::default()
+        .status_code(200u16)
+        .headers(headers)
+        .bytes_as_body(body.to_string())
+        .build())
+}
+
+/// 模拟七牛上传服务器，所有请求都立即成功，以便测量 SDK 自身的开销
+fn mock_up_server() -> CallHandlers {
+    CallHandlers::new(|request| {
+        panic!("Unexpected Request: {} {}", request.method(), request.url());
+    })
+    .install(Method::POST, "^http://up.example.com/?$", |_, _| {
+        json_response(json!({"hash": "bench-hash", "key": "bench-key"}))
+    })
+    .install(
+        Method::POST,
+        "^http://up.example.com/buckets/[^/]+/objects/[^/]+/uploads$",
+        |_, _| json_response(json!({"uploadId": "bench-upload-id"})),
+    )
+    .install(
+        Method::PUT,
+        "^http://up.example.com/buckets/[^/]+/objects/[^/]+/uploads/bench-upload-id/\\d+$",
+        |_, n| json_response(json!({ "etag": format!("etag_{}", n) })),
+    )
+    .install(
+        Method::POST,
+        "^http://up.example.com/buckets/[^/]+/objects/[^/]+/uploads/bench-upload-id$",
+        |_, _| json_response(json!({"hash": "bench-hash", "key": "bench-key"})),
+    )
+}
+
+fn bench_upload_file(c: &mut Criterion) {
+    let config = ConfigBuilder::default()
+        .upload_logger(None)
+        .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+        .http_request_handler(mock_up_server())
+        .build();
+    let policy = UploadPolicyBuilder::new_policy_for_bucket("bench-bucket", &config).build();
+    let upload_token = UploadToken::new(policy, Credential::new("abcdefghklmnopq", "1234567890")).to_string();
+    let temp_path = create_temp_file(FILE_SIZE).unwrap().into_temp_path();
+
+    let mut group = c.benchmark_group("upload_file");
+    group.throughput(Throughput::Bytes(FILE_SIZE as u64));
+    for &concurrency in CONCURRENCY {
+        let bucket_uploader = bucket_uploader_builder("bench-bucket", &["http://up.example.com"], config.to_owned())
+            .thread_pool_size(concurrency)
+            .build();
+        group.bench_function(BenchmarkId::new("form", concurrency), |b| {
+            b.iter(|| {
+                bucket_uploader
+                    .upload_token(upload_token.as_str())
+                    .key("bench-key")
+                    .never_be_resumable()
+                    .upload_file(&temp_path, "", None)
+                    .unwrap()
+            })
+        });
+        group.bench_function(BenchmarkId::new("resumable", concurrency), |b| {
+            b.iter(|| {
+                bucket_uploader
+                    .upload_token(upload_token.as_str())
+                    .key("bench-key")
+                    .always_be_resumable()
+                    .max_concurrency(concurrency)
+                    .upload_file(&temp_path, "", None)
+                    .unwrap()
+            })
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_upload_file);
+criterion_main!(benches);
@@ -0,0 +1,139 @@
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use qiniu_ng::{
+    benchmark::{crc32_from_bytes, read_all_parts, CacheMap, PartReadMode},
+    http::DomainsManagerBuilder,
+    utils::etag,
+};
+use qiniu_test_utils::temp_file::create_temp_file;
+use rayon::ThreadPoolBuilder;
+use std::{
+    fs::File,
+    time::{Duration, SystemTime},
+};
+
+const DATA_SIZES: &[usize] = &[1 << 12, 1 << 20, (1 << 22) + 1, 1 << 24];
+const THREADS: &[usize] = &[1, 4, 8];
+
+fn make_data(size: usize) -> Vec<u8> {
+    (0..size).map(|i| (i % 251) as u8).collect()
+}
+
+fn bench_etag(c: &mut Criterion) {
+    let mut group = c.benchmark_group("etag");
+    for &size in DATA_SIZES {
+        let data = make_data(size);
+        group.throughput(Throughput::Bytes(size as u64));
+        group.bench_with_input(BenchmarkId::new("from_bytes", size), &data, |b, data| {
+            b.iter(|| etag::from_bytes(data))
+        });
+    }
+
+    let size = (1 << 26) + 1;
+    let temp_path = create_temp_file(size).unwrap().into_temp_path();
+    group.throughput(Throughput::Bytes(size as u64));
+    group.bench_function(BenchmarkId::new("from_file", size), |b| {
+        b.iter(|| etag::from_file(&temp_path).unwrap())
+    });
+    for &threads in THREADS {
+        let thread_pool = ThreadPoolBuilder::new().num_threads(threads).build().unwrap();
+        group.bench_function(BenchmarkId::new("from_file_in_parallel", threads), |b| {
+            b.iter(|| etag::from_file_in_parallel(&temp_path, &thread_pool).unwrap())
+        });
+    }
+    group.finish();
+}
+
+fn bench_crc32(c: &mut Criterion) {
+    let mut group = c.benchmark_group("crc32");
+    for &size in DATA_SIZES {
+        let data = make_data(size);
+        group.throughput(Throughput::Bytes(size as u64));
+        group.bench_with_input(BenchmarkId::new("from_bytes", size), &data, |b, data| {
+            b.iter(|| crc32_from_bytes(data))
+        });
+    }
+    group.finish();
+}
+
+fn bench_io_status_manager(c: &mut Criterion) {
+    let mut group = c.benchmark_group("io_status_manager");
+    let size = 1 << 26;
+    let temp_path = create_temp_file(size).unwrap().into_temp_path();
+    let file = File::open(&temp_path).unwrap();
+    group.throughput(Throughput::Bytes(size as u64));
+    for &mode in &[PartReadMode::Sequential, PartReadMode::Positional, PartReadMode::Mapped] {
+        for &threads in THREADS {
+            let thread_pool = ThreadPoolBuilder::new().num_threads(threads).build().unwrap();
+            group.bench_function(BenchmarkId::new(format!("{:?}", mode), threads), |b| {
+                b.iter(|| read_all_parts(&file, size as u64, 1 << 22, mode, &thread_pool).unwrap())
+            });
+        }
+    }
+    group.finish();
+}
+
+fn bench_cache_map(c: &mut Criterion) {
+    const ENTRIES: usize = 4096;
+    let mut group = c.benchmark_group("cache_map");
+    let keys = (0..ENTRIES).map(|i| format!("key-{}", i)).collect::<Vec<_>>();
+    let expired_at = SystemTime::now() + Duration::from_secs(3600);
+    let cache_map = CacheMap::with_max_capacity(ENTRIES, true);
+    for key in keys.iter() {
+        cache_map.insert(key.to_owned(), key.len(), expired_at);
+    }
+    group.throughput(Throughput::Elements(ENTRIES as u64));
+    group.bench_function("get", |b| {
+        b.iter(|| keys.iter().filter(|key| cache_map.get(key.as_str()).is_some()).count())
+    });
+    group.bench_function("insert", |b| {
+        b.iter(|| {
+            for key in keys.iter() {
+                cache_map.insert(key.to_owned(), key.len(), expired_at);
+            }
+        })
+    });
+    for &threads in THREADS {
+        let thread_pool = ThreadPoolBuilder::new().num_threads(threads).build().unwrap();
+        group.bench_function(BenchmarkId::new("concurrent_get_or_insert", threads), |b| {
+            b.iter(|| {
+                thread_pool.scope(|s| {
+                    for _ in 0..threads {
+                        s.spawn(|_| {
+                            for key in keys.iter() {
+                                cache_map.get_or_insert(key.to_owned(), || Some((key.len(), expired_at)));
+                            }
+                        });
+                    }
+                })
+            })
+        });
+    }
+    group.finish();
+}
+
+fn bench_domains_manager_choose(c: &mut Criterion) {
+    let mut group = c.benchmark_group("domains_manager");
+    let domains_manager = DomainsManagerBuilder::default().disable_url_resolution().build();
+    let base_urls = &[
+        "http://upload.qiniup.com",
+        "http://up.qiniup.com",
+        "http://upload-jjh.qiniup.com",
+        "http://upload-xs.qiniup.com",
+    ][..];
+    group.bench_function("choose", |b| b.iter(|| domains_manager.choose(base_urls).unwrap()));
+    domains_manager.freeze_url(base_urls[0]).unwrap();
+    group.bench_function("choose_with_frozen_url", |b| {
+        b.iter(|| domains_manager.choose(base_urls).unwrap())
+    });
+    group.finish();
+}
+
+criterion_group!(
+    benches,
+    bench_etag,
+    bench_crc32,
+    bench_io_status_manager,
+    bench_cache_map,
+    bench_domains_manager_choose
+);
+criterion_main!(benches);
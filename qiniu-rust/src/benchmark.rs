@@ -0,0 +1,11 @@
+//! 基准测试辅助模块
+//!
+//! 仅在启用 `benchmark` 功能时编译，为 `benches` 目录下的基准测试暴露内部组件，不属于公开 API，随时可能改变
+
+pub use crate::{
+    storage::uploader::benchmark::{bucket_uploader_builder, read_all_parts, PartReadMode},
+    utils::{
+        cache_map::CacheMap,
+        crc32::{from_bytes as crc32_from_bytes, from_file as crc32_from_file},
+    },
+};
@@ -6,7 +6,16 @@ use crate::{
 use assert_impl::assert_impl;
 use derive_builder::Builder;
 use getset::{CopyGetters, Getters};
-use std::{borrow::Cow, boxed::Box, default::Default, env::consts::ARCH, fmt, ops::Deref, sync::Arc, time::Duration};
+use std::{
+    borrow::Cow,
+    boxed::Box,
+    default::Default,
+    env::consts::ARCH,
+    fmt,
+    ops::Deref,
+    sync::{Arc, Weak},
+    time::Duration,
+};
 use sys_info::{linux_os_release, os_release, os_type};
 
 #[derive(Builder, Getters, CopyGetters)]
@@ -102,6 +111,17 @@ pub struct ConfigInner {
     #[builder(default = "default::upload_block_size()")]
     upload_block_size: u32,
 
+    /// 上传分块缓冲区池最大缓存尺寸
+    ///
+    /// 存储空间上传器会缓存分片上传时读取分块所用的缓冲区以便复用，
+    /// 缓存总量不会超过该值与 `线程池大小 × 上传分块尺寸` 中的较小者，从而使每个进程的内存占用可以预期。
+    /// 设置为 `0` 将禁用缓存
+    ///
+    /// 单位为字节，默认为 256 MB
+    #[get_copy = "pub"]
+    #[builder(default = "default::upload_buffer_pool_max_size()")]
+    upload_buffer_pool_max_size: usize,
+
     /// 上传日志记录仪
     ///
     /// 默认情况下，七牛 Rust SDK 会收集文件上传相关日志信息，并自动以异步的形式上传到 Uplog 服务器，并由七牛工作人员进行统计或定位问题
@@ -202,6 +222,18 @@ pub struct ConfigInner {
     #[builder(default = "default::http_request_retry_delay()")]
     http_request_retry_delay: Duration,
 
+    /// HTTP 对冲请求延迟
+    ///
+    /// 对于请求方法为 GET 或 HEAD，或是被 SDK 标记为幂等的 HTTP 请求（包括表单上传请求和分片上传的各个请求），
+    /// 在请求体已经完整加载进内存或是长度不超过 4 MB 的数据流时，如果在该时长内仍未得到响应，
+    /// SDK 将向下一个候选 URL（如果没有，则是同一个 URL 的下一个 IP 地址）再发出一个请求，采用先得到的响应，并取消另一个请求。
+    /// 对冲请求可以避免在服务器响应缓慢但并未失效时长时间等待超时，但会增加服务器的负载，建议设置为正常响应时长的 P95 至 P99 值。
+    ///
+    /// 默认为不发出对冲请求
+    #[get_copy = "pub"]
+    #[builder(default, setter(strip_option))]
+    http_request_hedge_delay: Option<Duration>,
+
     /// HTTP 请求前回调函数
     ///
     /// 在每次发送 HTTP 请求前将逐一回调列表中所有函数
@@ -309,6 +341,11 @@ mod default {
         1 << 22
     }
 
+    #[inline]
+    pub const fn upload_buffer_pool_max_size() -> usize {
+        1 << 28
+    }
+
     #[inline]
     pub fn upload_logger() -> Option<UploadLogger> {
         UploadLoggerBuilder::default().build().map(Some).unwrap_or(None)
@@ -381,10 +418,12 @@ impl fmt::Debug for ConfigInner {
             .field("batch_max_operation_size", &self.batch_max_operation_size)
             .field("upload_threshold", &self.upload_threshold)
             .field("upload_block_size", &self.upload_block_size)
+            .field("upload_buffer_pool_max_size", &self.upload_buffer_pool_max_size)
             .field("upload_recorder", &self.upload_recorder)
             .field("upload_logger", &self.upload_logger)
             .field("http_request_retries", &self.http_request_retries)
             .field("http_request_retry_delay", &self.http_request_retry_delay)
+            .field("http_request_hedge_delay", &self.http_request_hedge_delay)
             .field("domains_manager", &self.domains_manager)
             .finish()
     }
@@ -576,6 +615,11 @@ impl Config {
         Config(Arc::from_raw(ptr))
     }
 
+    /// 生成客户端配置的弱引用
+    pub(crate) fn downgrade(&self) -> WeakConfig {
+        WeakConfig(Arc::downgrade(&self.0))
+    }
+
     #[allow(dead_code)]
     fn ignore() {
         assert_impl!(Send: Self);
@@ -583,6 +627,19 @@ impl Config {
     }
 }
 
+/// 七牛客户端配置的弱引用
+///
+/// 不会阻止客户端配置被释放，供客户端配置间接持有的对象使用，避免形成循环引用
+#[derive(Clone, Debug)]
+pub(crate) struct WeakConfig(Weak<ConfigInner>);
+
+impl WeakConfig {
+    /// 获取客户端配置，如果客户端配置已经被释放，则返回 `None`
+    pub(crate) fn upgrade(&self) -> Option<Config> {
+        self.0.upgrade().map(Config)
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -20,12 +20,21 @@ use std::{
 };
 use url::Url;
 
-#[derive(Clone, Eq, PartialEq)]
 struct CredentialInner {
     access_key: Cow<'static, str>,
     secret_key: Cow<'static, str>,
+    // 已经用 Secret Key 完成内外填充的 HMAC-SHA1 状态，每次签名时复制使用，无需重新处理密钥
+    hmac: Hmac<Sha1>,
 }
 
+impl PartialEq for CredentialInner {
+    fn eq(&self, other: &Self) -> bool {
+        self.access_key == other.access_key && self.secret_key == other.secret_key
+    }
+}
+
+impl Eq for CredentialInner {}
+
 /// 认证信息
 ///
 /// 该结构体仅用于为其他 SDK 类提供认证信息，本身并不会验证认证信息的有效性
@@ -47,9 +56,11 @@ impl Credential {
     /// let credential = Credential::new("[Access Key]", "[Secret Key]");
     /// ```
     pub fn new(access_key: impl Into<Cow<'static, str>>, secret_key: impl Into<Cow<'static, str>>) -> Credential {
+        let secret_key = secret_key.into();
         Credential(Arc::new(CredentialInner {
             access_key: access_key.into(),
-            secret_key: secret_key.into(),
+            hmac: Hmac::<Sha1>::new_varkey(secret_key.as_bytes()).unwrap(),
+            secret_key,
         }))
     }
 
@@ -184,16 +195,16 @@ impl Credential {
     }
 
     fn base64ed_hmac_digest(&self, data: &[u8]) -> String {
-        let mut hmac = Hmac::<Sha1>::new_varkey(self.secret_key().as_bytes()).unwrap();
+        let mut hmac = self.0.hmac.to_owned();
         hmac.input(data);
         base64::urlsafe(&hmac.result().code())
     }
 
-    fn will_push_body_v1(content_type: &str) -> bool {
+    pub(crate) fn will_push_body_v1(content_type: &str) -> bool {
         mime::FORM_MIME.eq_ignore_ascii_case(content_type)
     }
 
-    fn will_push_body_v2(content_type: &str) -> bool {
+    pub(crate) fn will_push_body_v2(content_type: &str) -> bool {
         !mime::BINARY_MIME.eq_ignore_ascii_case(content_type)
     }
 
@@ -208,7 +219,7 @@ impl Credential {
                 == &self.authorization_v1_for_request(
                     req.url(),
                     req.headers().get(&"Content-Type".into()).unwrap_or(&"".into()),
-                    req.body().as_ref(),
+                    req.body().as_bytes().unwrap_or_default(),
                 )?)
         } else {
             Ok(false)
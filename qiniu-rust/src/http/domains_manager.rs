@@ -1,13 +1,25 @@
 //! 域名管理 模块
 //!
 //! 对七牛 Rust SDK 所用的所有域名及域名解析后的 IP 地址进行管理。功能包含域名预解析和缓存，冻结域名，并会对这些状态进行持久化存储。
+//!
+//! 持久化文件采用带版本号和校验和的二进制快照格式，加载时通过内存映射直接解码，同时兼容旧版本 SDK 写入的 JSON 格式。
+//! 仅当状态发生变化时才会自动持久化，写入时先写临时文件再原子地替换持久化文件。
+//!
+//! 域名管理器还会根据实际请求结果统计每个 IP 地址的延迟和错误率，并优先选择延迟更低，错误更少的 IP 地址。
+//!
+//! 域名解析通过可替换的域名解析器在后台线程中进行，请求线程最多等待解析超时时长，相同域名的并发解析将被合并，解析失败的结果也将被短暂缓存。
 
+use super::{
+    metrics::{self, Event, Stopwatch, Timing},
+    resolver::{Resolver, SystemResolver},
+};
 use crate::{
     config::Config,
     storage::region::Region,
     utils::{
         cache_map::{CacheMap, PersistentEntry},
-        global_thread_pool,
+        global_thread_pool, mmap,
+        snapshot::{is_snapshot, SnapshotReader, SnapshotWriter},
     },
 };
 use assert_impl::assert_impl;
@@ -20,45 +32,68 @@ use std::{
     borrow::Cow,
     boxed::Box,
     cell::RefCell,
-    collections::HashSet,
+    cmp::Ordering,
+    collections::{HashMap, HashSet},
     env::temp_dir,
+    fmt,
     fs::{create_dir_all, File, OpenOptions},
-    io::{Error as IOError, Result as IOResult},
-    net::{SocketAddr, ToSocketAddrs},
+    io::{Error as IOError, ErrorKind as IOErrorKind, Read, Result as IOResult, Seek, SeekFrom, Write},
+    mem::take,
+    net::{SocketAddr, TcpStream},
     path::{Path, PathBuf},
-    sync::{Arc, Mutex},
-    thread::sleep,
+    sync::{
+        atomic::{AtomicBool, Ordering::Relaxed},
+        Arc, Condvar, Mutex,
+    },
+    thread::{sleep, Builder as ThreadBuilder},
     time::{Duration, Instant, SystemTime},
 };
 use tap::TapOps;
+use tempfile::NamedTempFile;
 use thiserror::Error;
 use url::Url;
 
+pub use crate::utils::cache_map::CacheMapStats as CacheStats;
+
 #[derive(Debug, Clone)]
 struct DomainsManagerInnerData {
     frozen_urls: CacheMap<Box<str>, ()>,
     resolutions: CacheMap<Box<str>, Box<[SocketAddr]>>,
+    negative_resolutions: CacheMap<Box<str>, ()>,
+    socket_addr_stats: CacheMap<SocketAddr, SocketAddrStats>,
+    region_queries: CacheMap<Box<str>, Box<str>>,
     url_frozen_duration: Duration,
     resolutions_cache_lifetime: Duration,
+    negative_resolutions_cache_lifetime: Duration,
+    resolve_timeout: Duration,
     url_resolution_disabled: bool,
     persistent_interval: Option<Duration>,
     refresh_resolutions_interval: Option<Duration>,
     url_resolve_retries: usize,
     url_resolve_retry_delay: Duration,
+    socket_addr_stats_persistence_disabled: bool,
+    socket_addr_probe_interval: Option<Duration>,
 }
 
 impl Default for DomainsManagerInnerData {
     fn default() -> Self {
         DomainsManagerInnerData {
-            frozen_urls: CacheMap::new(false),
-            resolutions: CacheMap::new(false),
+            frozen_urls: CacheMap::with_max_capacity(default::frozen_urls_max_capacity(), false),
+            resolutions: CacheMap::with_max_capacity(default::resolutions_max_capacity(), false),
+            negative_resolutions: CacheMap::with_max_capacity(default::negative_resolutions_max_capacity(), true),
+            socket_addr_stats: CacheMap::with_max_capacity(default::socket_addr_stats_max_capacity(), false),
+            region_queries: CacheMap::with_max_capacity(default::region_queries_max_capacity(), false),
             url_frozen_duration: default::url_frozen_duration(),
             resolutions_cache_lifetime: default::resolutions_cache_lifetime(),
+            negative_resolutions_cache_lifetime: default::negative_resolutions_cache_lifetime(),
+            resolve_timeout: default::resolve_timeout(),
             url_resolution_disabled: default::url_resolution_disabled(),
             persistent_interval: default::persistent_interval(),
             refresh_resolutions_interval: default::refresh_resolutions_interval(),
             url_resolve_retries: default::url_resolve_retries(),
             url_resolve_retry_delay: default::url_resolve_retry_delay(),
+            socket_addr_stats_persistence_disabled: default::socket_addr_stats_persistence_disabled(),
+            socket_addr_probe_interval: default::socket_addr_probe_interval(),
         }
     }
 }
@@ -76,6 +111,16 @@ mod default {
         Duration::from_secs(60 * 60)
     }
 
+    #[inline]
+    pub const fn negative_resolutions_cache_lifetime() -> Duration {
+        Duration::from_secs(10)
+    }
+
+    #[inline]
+    pub const fn resolve_timeout() -> Duration {
+        Duration::from_secs(5)
+    }
+
     #[inline]
     pub const fn url_resolution_disabled() -> bool {
         false
@@ -100,46 +145,318 @@ mod default {
     pub const fn url_resolve_retry_delay() -> Duration {
         Duration::from_secs(1)
     }
+
+    #[inline]
+    pub const fn socket_addr_stats_persistence_disabled() -> bool {
+        false
+    }
+
+    #[inline]
+    pub const fn socket_addr_probe_interval() -> Option<Duration> {
+        None
+    }
+
+    #[inline]
+    pub const fn frozen_urls_max_capacity() -> usize {
+        1024
+    }
+
+    #[inline]
+    pub const fn resolutions_max_capacity() -> usize {
+        4096
+    }
+
+    #[inline]
+    pub const fn negative_resolutions_max_capacity() -> usize {
+        1024
+    }
+
+    #[inline]
+    pub const fn socket_addr_stats_max_capacity() -> usize {
+        4096
+    }
+
+    #[inline]
+    pub const fn region_queries_max_capacity() -> usize {
+        4096
+    }
+}
+
+/// 域名管理器各个缓存的命中统计
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct DomainsManagerCacheStats {
+    /// 冻结 URL 缓存
+    pub frozen_urls: CacheStats,
+    /// 域名解析结果缓存
+    pub resolutions: CacheStats,
+    /// 域名解析失败结果缓存
+    pub negative_resolutions: CacheStats,
+    /// IP 地址统计信息缓存
+    pub socket_addr_stats: CacheStats,
+    /// 存储空间区域查询结果缓存
+    pub region_queries: CacheStats,
+}
+
+/// IP 地址统计信息的指数加权移动平均系数，越大则越偏重最近的请求结果
+const SOCKET_ADDR_STATS_EWMA_ALPHA: f64 = 0.3;
+/// 计算 IP 地址权重时成功率的下限，保证错误率很高的 IP 地址依然有机会被选中，从而在恢复后可以被重新发现
+const MIN_SOCKET_ADDR_SUCCESS_RATE: f64 = 0.01;
+/// 探测 IP 地址时建立 TCP 连接的超时时长
+const SOCKET_ADDR_PROBE_TIMEOUT: Duration = Duration::from_secs(3);
+
+/// IP 地址统计信息
+///
+/// 记录请求该 IP 地址的延迟和错误率的指数加权移动平均值
+#[derive(Serialize, Deserialize, Debug, Clone, Copy, Default)]
+struct SocketAddrStats {
+    latency_millis: f64,
+    failure_rate: f64,
+    successes: u64,
+    failures: u64,
+}
+
+impl SocketAddrStats {
+    fn record_success(&mut self, elapsed: Duration) {
+        let latency_millis = elapsed.as_secs_f64() * 1000.0;
+        self.latency_millis = if self.successes > 0 {
+            SOCKET_ADDR_STATS_EWMA_ALPHA * latency_millis + (1.0 - SOCKET_ADDR_STATS_EWMA_ALPHA) * self.latency_millis
+        } else {
+            latency_millis
+        };
+        self.failure_rate *= 1.0 - SOCKET_ADDR_STATS_EWMA_ALPHA;
+        self.successes = self.successes.saturating_add(1);
+    }
+
+    fn record_failure(&mut self) {
+        self.failure_rate = SOCKET_ADDR_STATS_EWMA_ALPHA + (1.0 - SOCKET_ADDR_STATS_EWMA_ALPHA) * self.failure_rate;
+        self.failures = self.failures.saturating_add(1);
+    }
+
+    /// 延迟越低，错误率越低，权重越高。尚未成功过的 IP 地址使用 `default_latency_millis` 作为其延迟
+    fn weight(&self, default_latency_millis: f64) -> f64 {
+        let latency_millis = if self.successes > 0 {
+            self.latency_millis
+        } else {
+            default_latency_millis
+        };
+        (1.0 - self.failure_rate).max(MIN_SOCKET_ADDR_SUCCESS_RATE) / latency_millis.max(1.0)
+    }
 }
 
 #[derive(Serialize, Deserialize, Debug, Clone)]
 struct PersistentDomainsManager {
     frozen_urls: Vec<PersistentEntry<Box<str>, ()>>,
     resolutions: Vec<PersistentEntry<Box<str>, Box<[SocketAddr]>>>,
+    #[serde(default)]
+    socket_addr_stats: Vec<PersistentEntry<SocketAddr, SocketAddrStats>>,
+    #[serde(default)]
+    region_queries: Vec<PersistentEntry<Box<str>, Box<str>>>,
     url_frozen_duration: Duration,
     resolutions_cache_lifetime: Duration,
+    #[serde(default = "default::negative_resolutions_cache_lifetime")]
+    negative_resolutions_cache_lifetime: Duration,
+    #[serde(default = "default::resolve_timeout")]
+    resolve_timeout: Duration,
     url_resolution_disabled: bool,
     persistent_interval: Option<Duration>,
     refresh_resolutions_interval: Option<Duration>,
     url_resolve_retries: usize,
     url_resolve_retry_delay: Duration,
+    #[serde(default)]
+    socket_addr_stats_persistence_disabled: bool,
+    #[serde(default)]
+    socket_addr_probe_interval: Option<Duration>,
 }
 
+const SNAPSHOT_MAGIC: &[u8; 4] = b"QNDM";
+/// 版本 2 新增存储空间区域查询结果
+const SNAPSHOT_VERSION: u32 = 2;
+
 impl DomainsManagerInnerData {
+    /// 加载持久化文件
+    ///
+    /// 普通文件将被映射到内存后直接解码，无法映射的文件则回退到普通的读取方式
     fn load_from_file(path: &Path) -> PersistentResult<Self> {
-        let persistent: PersistentDomainsManager = serde_json::from_reader(File::open(path)?)?;
+        let mut file = File::open(path)?;
+        let file_size = file.metadata()?.len();
+        let persistent = match mmap::map(&file, file_size) {
+            Some(mapped) => PersistentDomainsManager::from_bytes(&mapped)?,
+            None => {
+                let mut buf = Vec::new();
+                file.read_to_end(&mut buf)?;
+                PersistentDomainsManager::from_bytes(&buf)?
+            }
+        };
         Ok(persistent.into())
     }
 
-    fn save_to_file(&self, file: &mut File) -> PersistentResult<()> {
-        let persistent: PersistentDomainsManager = self.to_owned().into();
-        serde_json::to_writer(file, &persistent)?;
-        Ok(())
+    fn to_snapshot(&self) -> Vec<u8> {
+        PersistentDomainsManager::from(self.to_owned()).to_snapshot()
+    }
+}
+
+impl PersistentDomainsManager {
+    /// 以魔数开头的数据按照二进制快照格式解码，否则按照 JSON 格式解码
+    fn from_bytes(bytes: &[u8]) -> PersistentResult<Self> {
+        if is_snapshot(bytes, SNAPSHOT_MAGIC) {
+            let reader = SnapshotReader::new(bytes, SNAPSHOT_MAGIC, SNAPSHOT_VERSION)?;
+            Ok(Self::from_snapshot(reader)?)
+        } else {
+            Ok(serde_json::from_slice(bytes)?)
+        }
+    }
+
+    fn to_snapshot(&self) -> Vec<u8> {
+        let mut writer = SnapshotWriter::new();
+        writer
+            .put_duration(self.url_frozen_duration)
+            .put_duration(self.resolutions_cache_lifetime)
+            .put_duration(self.negative_resolutions_cache_lifetime)
+            .put_duration(self.resolve_timeout)
+            .put_bool(self.url_resolution_disabled)
+            .put_optional_duration(self.persistent_interval)
+            .put_optional_duration(self.refresh_resolutions_interval)
+            .put_u64(self.url_resolve_retries as u64)
+            .put_duration(self.url_resolve_retry_delay)
+            .put_bool(self.socket_addr_stats_persistence_disabled)
+            .put_optional_duration(self.socket_addr_probe_interval);
+
+        writer.put_len(self.frozen_urls.len());
+        for entry in self.frozen_urls.iter() {
+            writer.put_str(entry.key()).put_system_time(entry.expired_at());
+        }
+        writer.put_len(self.resolutions.len());
+        for entry in self.resolutions.iter() {
+            writer
+                .put_str(entry.key())
+                .put_system_time(entry.expired_at())
+                .put_len(entry.value().len());
+            for socket_addr in entry.value().iter() {
+                writer.put_socket_addr(socket_addr);
+            }
+        }
+        writer.put_len(self.socket_addr_stats.len());
+        for entry in self.socket_addr_stats.iter() {
+            let stats = entry.value();
+            writer
+                .put_socket_addr(entry.key())
+                .put_system_time(entry.expired_at())
+                .put_f64(stats.latency_millis)
+                .put_f64(stats.failure_rate)
+                .put_u64(stats.successes)
+                .put_u64(stats.failures);
+        }
+        writer.put_len(self.region_queries.len());
+        for entry in self.region_queries.iter() {
+            writer
+                .put_str(entry.key())
+                .put_system_time(entry.expired_at())
+                .put_str(entry.value());
+        }
+        writer.finish(SNAPSHOT_MAGIC, SNAPSHOT_VERSION)
+    }
+
+    fn from_snapshot(mut reader: SnapshotReader) -> IOResult<Self> {
+        let mut persistent = PersistentDomainsManager {
+            url_frozen_duration: reader.get_duration()?,
+            resolutions_cache_lifetime: reader.get_duration()?,
+            negative_resolutions_cache_lifetime: reader.get_duration()?,
+            resolve_timeout: reader.get_duration()?,
+            url_resolution_disabled: reader.get_bool()?,
+            persistent_interval: reader.get_optional_duration()?,
+            refresh_resolutions_interval: reader.get_optional_duration()?,
+            url_resolve_retries: reader.get_u64()? as usize,
+            url_resolve_retry_delay: reader.get_duration()?,
+            socket_addr_stats_persistence_disabled: reader.get_bool()?,
+            socket_addr_probe_interval: reader.get_optional_duration()?,
+            frozen_urls: Vec::new(),
+            resolutions: Vec::new(),
+            socket_addr_stats: Vec::new(),
+            region_queries: Vec::new(),
+        };
+
+        let count = reader.get_len()?;
+        persistent.frozen_urls.reserve(count);
+        for _ in 0..count {
+            let url = reader.get_str()?;
+            let expired_at = reader.get_system_time()?;
+            persistent
+                .frozen_urls
+                .push(PersistentEntry::new(url.into(), (), expired_at));
+        }
+        let count = reader.get_len()?;
+        persistent.resolutions.reserve(count);
+        for _ in 0..count {
+            let url = reader.get_str()?;
+            let expired_at = reader.get_system_time()?;
+            let socket_addrs = (0..reader.get_len()?)
+                .map(|_| reader.get_socket_addr())
+                .collect::<IOResult<Box<[SocketAddr]>>>()?;
+            persistent
+                .resolutions
+                .push(PersistentEntry::new(url.into(), socket_addrs, expired_at));
+        }
+        let count = reader.get_len()?;
+        persistent.socket_addr_stats.reserve(count);
+        for _ in 0..count {
+            let socket_addr = reader.get_socket_addr()?;
+            let expired_at = reader.get_system_time()?;
+            let stats = SocketAddrStats {
+                latency_millis: reader.get_f64()?,
+                failure_rate: reader.get_f64()?,
+                successes: reader.get_u64()?,
+                failures: reader.get_u64()?,
+            };
+            persistent
+                .socket_addr_stats
+                .push(PersistentEntry::new(socket_addr, stats, expired_at));
+        }
+        if reader.version() >= 2 {
+            let count = reader.get_len()?;
+            persistent.region_queries.reserve(count);
+            for _ in 0..count {
+                let key = reader.get_str()?;
+                let expired_at = reader.get_system_time()?;
+                let response = reader.get_str()?;
+                persistent
+                    .region_queries
+                    .push(PersistentEntry::new(key.into(), response.into(), expired_at));
+            }
+        }
+        if !reader.is_empty() {
+            return Err(IOError::new(IOErrorKind::InvalidData, "Unexpected data after snapshot"));
+        }
+        Ok(persistent)
     }
 }
 
 impl From<PersistentDomainsManager> for DomainsManagerInnerData {
     fn from(persistent: PersistentDomainsManager) -> Self {
         Self {
-            frozen_urls: CacheMap::from_persistent(persistent.frozen_urls, false),
-            resolutions: CacheMap::from_persistent(persistent.resolutions, false),
+            frozen_urls: CacheMap::from_persistent(persistent.frozen_urls, default::frozen_urls_max_capacity(), false),
+            resolutions: CacheMap::from_persistent(persistent.resolutions, default::resolutions_max_capacity(), false),
+            negative_resolutions: CacheMap::with_max_capacity(default::negative_resolutions_max_capacity(), true),
+            socket_addr_stats: CacheMap::from_persistent(
+                persistent.socket_addr_stats,
+                default::socket_addr_stats_max_capacity(),
+                false,
+            ),
+            region_queries: CacheMap::from_persistent(
+                persistent.region_queries,
+                default::region_queries_max_capacity(),
+                false,
+            ),
             url_frozen_duration: persistent.url_frozen_duration,
             resolutions_cache_lifetime: persistent.resolutions_cache_lifetime,
+            negative_resolutions_cache_lifetime: persistent.negative_resolutions_cache_lifetime,
+            resolve_timeout: persistent.resolve_timeout,
             url_resolution_disabled: persistent.url_resolution_disabled,
             persistent_interval: persistent.persistent_interval,
             refresh_resolutions_interval: persistent.refresh_resolutions_interval,
             url_resolve_retries: persistent.url_resolve_retries,
             url_resolve_retry_delay: persistent.url_resolve_retry_delay,
+            socket_addr_stats_persistence_disabled: persistent.socket_addr_stats_persistence_disabled,
+            socket_addr_probe_interval: persistent.socket_addr_probe_interval,
         }
     }
 }
@@ -149,13 +466,23 @@ impl From<DomainsManagerInnerData> for PersistentDomainsManager {
         Self {
             frozen_urls: domains_manager.frozen_urls.into_persistent(),
             resolutions: domains_manager.resolutions.into_persistent(),
+            socket_addr_stats: if domains_manager.socket_addr_stats_persistence_disabled {
+                Vec::new()
+            } else {
+                domains_manager.socket_addr_stats.into_persistent()
+            },
+            region_queries: domains_manager.region_queries.into_persistent(),
             url_frozen_duration: domains_manager.url_frozen_duration,
             resolutions_cache_lifetime: domains_manager.resolutions_cache_lifetime,
+            negative_resolutions_cache_lifetime: domains_manager.negative_resolutions_cache_lifetime,
+            resolve_timeout: domains_manager.resolve_timeout,
             url_resolution_disabled: domains_manager.url_resolution_disabled,
             persistent_interval: domains_manager.persistent_interval,
             refresh_resolutions_interval: domains_manager.refresh_resolutions_interval,
             url_resolve_retries: domains_manager.url_resolve_retries,
             url_resolve_retry_delay: domains_manager.url_resolve_retry_delay,
+            socket_addr_stats_persistence_disabled: domains_manager.socket_addr_stats_persistence_disabled,
+            socket_addr_probe_interval: domains_manager.socket_addr_probe_interval,
         }
     }
 }
@@ -167,6 +494,7 @@ pub struct DomainsManagerBuilder {
     inner_data: DomainsManagerInnerData,
     pre_resolution_urls: HashSet<Cow<'static, str>>,
     persistent: Option<PersistentBuilder>,
+    resolver: Arc<dyn Resolver>,
 }
 
 struct PersistentBuilder {
@@ -194,6 +522,34 @@ impl DomainsManagerBuilder {
         self
     }
 
+    /// 域名解析失败结果的缓存生命周期
+    ///
+    /// 域名解析失败后，在该时长内对同一域名的解析将直接返回错误，而不再调用域名解析器
+    ///
+    /// 默认缓存十秒
+    pub fn negative_resolutions_cache_lifetime(mut self, negative_resolutions_cache_lifetime: Duration) -> Self {
+        self.inner_data.negative_resolutions_cache_lifetime = negative_resolutions_cache_lifetime;
+        self
+    }
+
+    /// 域名解析超时时长
+    ///
+    /// 请求线程等待域名解析结果的最长时间。超时后请求线程将放弃该域名，但解析依然会在后台继续进行，其结果将被缓存
+    ///
+    /// 默认为 5 秒
+    pub fn resolve_timeout(mut self, resolve_timeout: Duration) -> Self {
+        self.inner_data.resolve_timeout = resolve_timeout;
+        self
+    }
+
+    /// 设置域名解析器
+    ///
+    /// 默认使用 `SystemResolver`，即调用操作系统提供的域名解析功能
+    pub fn resolver(mut self, resolver: impl Resolver + 'static) -> Self {
+        self.resolver = Arc::new(resolver);
+        self
+    }
+
     /// 禁止 URL 域名预解析
     ///
     /// 默认启用 URL 域名预解析
@@ -250,6 +606,94 @@ impl DomainsManagerBuilder {
         self
     }
 
+    /// 禁止持久化 IP 地址统计信息
+    ///
+    /// 禁止后，域名管理器持久化时将不再保存每个 IP 地址的延迟和错误统计，重新加载后这些统计将从头开始。
+    ///
+    /// 默认持久化 IP 地址统计信息
+    pub fn disable_socket_addr_stats_persistence(mut self) -> Self {
+        self.inner_data.socket_addr_stats_persistence_disabled = true;
+        self
+    }
+
+    /// 启用持久化 IP 地址统计信息
+    ///
+    /// 默认持久化 IP 地址统计信息
+    pub fn enable_socket_addr_stats_persistence(mut self) -> Self {
+        self.inner_data.socket_addr_stats_persistence_disabled = false;
+        self
+    }
+
+    /// IP 地址探测间隔时间
+    ///
+    /// 设置后，域名管理器将定期在后台对所有已解析的 IP 地址发起 TCP 连接，以连接耗时更新 IP 地址统计信息，
+    /// 从而在没有实际请求的情况下依然能保持统计信息的有效性。
+    ///
+    /// 默认不探测
+    pub fn socket_addr_probe_interval(mut self, socket_addr_probe_interval: Duration) -> Self {
+        self.inner_data.socket_addr_probe_interval = Some(socket_addr_probe_interval);
+        self
+    }
+
+    /// 禁止探测 IP 地址
+    ///
+    /// 默认不探测
+    pub fn disable_socket_addr_probe(mut self) -> Self {
+        self.inner_data.socket_addr_probe_interval = None;
+        self
+    }
+
+    /// 设置冻结 URL 缓存的最大容量
+    ///
+    /// 超出容量时将淘汰最近未被访问的记录，已经缓存的记录超出新的容量时也将被淘汰。
+    ///
+    /// 默认为 1024
+    pub fn frozen_urls_max_capacity(mut self, max_capacity: usize) -> Self {
+        self.inner_data.frozen_urls = take(&mut self.inner_data.frozen_urls).resize(max_capacity.max(1));
+        self
+    }
+
+    /// 设置域名解析结果缓存的最大容量
+    ///
+    /// 超出容量时将淘汰最近未被访问的记录，已经缓存的记录超出新的容量时也将被淘汰。
+    ///
+    /// 默认为 4096
+    pub fn resolutions_max_capacity(mut self, max_capacity: usize) -> Self {
+        self.inner_data.resolutions = take(&mut self.inner_data.resolutions).resize(max_capacity.max(1));
+        self
+    }
+
+    /// 设置域名解析失败结果缓存的最大容量
+    ///
+    /// 超出容量时将淘汰最近未被访问的记录，已经缓存的记录超出新的容量时也将被淘汰。
+    ///
+    /// 默认为 1024
+    pub fn negative_resolutions_max_capacity(mut self, max_capacity: usize) -> Self {
+        self.inner_data.negative_resolutions =
+            take(&mut self.inner_data.negative_resolutions).resize(max_capacity.max(1));
+        self
+    }
+
+    /// 设置 IP 地址统计信息缓存的最大容量
+    ///
+    /// 超出容量时将淘汰最近未被访问的记录，已经缓存的记录超出新的容量时也将被淘汰。
+    ///
+    /// 默认为 4096
+    pub fn socket_addr_stats_max_capacity(mut self, max_capacity: usize) -> Self {
+        self.inner_data.socket_addr_stats = take(&mut self.inner_data.socket_addr_stats).resize(max_capacity.max(1));
+        self
+    }
+
+    /// 设置存储空间区域查询结果缓存的最大容量
+    ///
+    /// 超出容量时将淘汰最近未被访问的记录，已经缓存的记录超出新的容量时也将被淘汰。
+    ///
+    /// 默认为 4096
+    pub fn region_queries_max_capacity(mut self, max_capacity: usize) -> Self {
+        self.inner_data.region_queries = take(&mut self.inner_data.region_queries).resize(max_capacity.max(1));
+        self
+    }
+
     /// 设置持久化路径
     ///
     /// 一旦设置持久化路径，域名管理器可以以手动或自动的方式保存自身状态到文件系统。
@@ -303,8 +747,12 @@ impl DomainsManagerBuilder {
                     file: Mutex::new(persistent.file),
                     file_path: persistent.file_path,
                 }),
+                dirty: AtomicBool::new(false),
                 last_persistent_time: Mutex::new(Instant::now()),
                 last_refresh_time: Mutex::new(Instant::now()),
+                last_probe_time: Mutex::new(Instant::now()),
+                resolver: self.resolver,
+                resolvings: Default::default(),
             }),
         };
         if !domains_manager.inner.inner_data.url_resolution_disabled {
@@ -368,6 +816,7 @@ impl DomainsManagerBuilder {
                 file_path: persistent_file_path,
             }),
             pre_resolution_urls: Default::default(),
+            resolver: Arc::new(SystemResolver),
         })
     }
 
@@ -386,6 +835,7 @@ impl DomainsManagerBuilder {
                 })
                 .map_or(Ok(None), |r| r.map(Some))?,
             pre_resolution_urls: Self::default_pre_resolve_urls(),
+            resolver: Arc::new(SystemResolver),
         })
     }
 }
@@ -401,8 +851,10 @@ impl Default for DomainsManagerBuilder {
     ///
     /// 默认的持久化路径规则如下：
     ///   1. 尝试在[操作系统特定的缓存目录](https://docs.rs/dirs/2.0.2/dirs/fn.cache_dir.html)下创建 `qiniu_sdk` 目录。
-    ///   2. 如果成功，则使用 `qiniu_sdk` 目录下的 `domains_manager.json` 文件。
-    ///   3. 如果失败，则使用临时目录下的 `domains_manager.json` 文件。
+    ///   2. 如果成功，则使用 `qiniu_sdk` 目录下的 `domains_manager.bin` 文件。
+    ///   3. 如果失败，则使用临时目录下的 `domains_manager.bin` 文件。
+    ///
+    /// 如果 `domains_manager.bin` 文件无法加载，还将尝试加载同一目录下旧版本 SDK 使用的 `domains_manager.json` 文件
     fn default() -> Self {
         let persistent_file_path = {
             let mut default_path = cache_dir().unwrap_or_else(temp_dir);
@@ -410,11 +862,12 @@ impl Default for DomainsManagerBuilder {
             default_path = create_dir_all(&default_path)
                 .map(|_| default_path)
                 .unwrap_or_else(|_| temp_dir());
-            default_path.push("domains_manager.json");
+            default_path.push("domains_manager.bin");
             default_path
         };
 
         DomainsManagerInnerData::load_from_file(&persistent_file_path)
+            .or_else(|_| DomainsManagerInnerData::load_from_file(&persistent_file_path.with_extension("json")))
             .map(|inner_data| DomainsManagerBuilder {
                 inner_data,
                 persistent: Some(PersistentBuilder {
@@ -422,6 +875,7 @@ impl Default for DomainsManagerBuilder {
                     file_path: persistent_file_path.to_owned(),
                 }),
                 pre_resolution_urls: Default::default(),
+                resolver: Arc::new(SystemResolver),
             })
             .unwrap_or_else(|_| DomainsManagerBuilder {
                 inner_data: Default::default(),
@@ -430,6 +884,7 @@ impl Default for DomainsManagerBuilder {
                     file_path: persistent_file_path,
                 }),
                 pre_resolution_urls: Self::default_pre_resolve_urls(),
+                resolver: Arc::new(SystemResolver),
             })
     }
 }
@@ -440,12 +895,65 @@ struct Persistent {
     file: Mutex<File>,
 }
 
-#[derive(Debug)]
 struct DomainsManagerInner {
     inner_data: DomainsManagerInnerData,
     persistent: Option<Persistent>,
+    // 自上次持久化以来状态是否发生过变化，自动持久化仅在发生变化时进行
+    dirty: AtomicBool,
     last_persistent_time: Mutex<Instant>,
     last_refresh_time: Mutex<Instant>,
+    last_probe_time: Mutex<Instant>,
+    resolver: Arc<dyn Resolver>,
+    resolvings: Mutex<HashMap<Box<str>, Arc<Resolving>>>,
+}
+
+impl fmt::Debug for DomainsManagerInner {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_struct("DomainsManagerInner")
+            .field("inner_data", &self.inner_data)
+            .field("persistent", &self.persistent)
+            .field("dirty", &self.dirty)
+            .field("last_persistent_time", &self.last_persistent_time)
+            .field("last_refresh_time", &self.last_refresh_time)
+            .field("last_probe_time", &self.last_probe_time)
+            .finish()
+    }
+}
+
+/// 正在进行的域名解析
+///
+/// 对同一域名的并发解析将等待同一个解析结果，而不会重复调用域名解析器
+#[derive(Default)]
+struct Resolving {
+    result: Mutex<Option<Result<Box<[SocketAddr]>, (IOErrorKind, String)>>>,
+    condvar: Condvar,
+}
+
+impl Resolving {
+    fn wait(&self, timeout: Duration) -> IOResult<Box<[SocketAddr]>> {
+        let deadline = Instant::now() + timeout;
+        let mut result = self.result.lock().unwrap();
+        loop {
+            if let Some(result) = result.as_ref() {
+                return result.to_owned().map_err(|(kind, message)| IOError::new(kind, message));
+            }
+            let now = Instant::now();
+            if now >= deadline {
+                return Err(IOError::new(IOErrorKind::TimedOut, "Resolve timed out"));
+            }
+            result = self.condvar.wait_timeout(result, deadline - now).unwrap().0;
+        }
+    }
+
+    fn complete(&self, result: &IOResult<Box<[SocketAddr]>>) {
+        *self.result.lock().unwrap() = Some(
+            result
+                .as_ref()
+                .map(|socket_addrs| socket_addrs.to_owned())
+                .map_err(|err| (err.kind(), err.to_string())),
+        );
+        self.condvar.notify_all();
+    }
 }
 
 /// 域名管理器
@@ -459,7 +967,8 @@ pub struct DomainsManager {
 impl DomainsManager {
     /// 持久化域名管理器的状态
     ///
-    /// 将域名管理器状态持久化到指定的持久化路径
+    /// 将域名管理器状态持久化到指定的持久化路径。
+    /// 状态将先被写入持久化路径所在目录下的临时文件，再原子地替换持久化文件，因此其他进程不会读到写了一半的文件
     ///
     /// 注意，持久化期间，部分域名管理器功能可能会被阻塞
     pub fn persistent(&self) -> Option<PersistentResult<()>> {
@@ -472,6 +981,9 @@ impl DomainsManager {
 
     fn try_to_persistent_if_needed(&self) {
         if let Some(persistent_interval) = self.inner.inner_data.persistent_interval {
+            if !self.inner.dirty.load(Relaxed) {
+                return;
+            }
             let mut last_persistent_time = self.inner.last_persistent_time.lock().unwrap();
             if last_persistent_time.elapsed() > persistent_interval {
                 let _ = self.persistent_without_lock();
@@ -483,11 +995,41 @@ impl DomainsManager {
     fn persistent_without_lock(&self) -> Option<PersistentResult<()>> {
         self.inner.persistent.as_ref().map(|persistent| {
             let mut persistent_file = persistent.file.lock().unwrap();
-            persistent_file.set_len(0)?;
-            self.inner.inner_data.save_to_file(&mut persistent_file)
+            // 先清除标记再生成快照，这样生成快照期间发生的变化将在下次自动持久化时写入
+            self.inner.dirty.store(false, Relaxed);
+            let snapshot = self.inner.inner_data.to_snapshot();
+            write_persistent_file(&persistent.file_path, &mut persistent_file, &snapshot).map_err(|err| {
+                self.inner.dirty.store(true, Relaxed);
+                PersistentError::from(err)
+            })
         })
     }
 
+    #[inline]
+    fn mark_dirty(&self) {
+        self.inner.dirty.store(true, Relaxed);
+    }
+
+    /// 获取缓存的存储空间区域查询结果，以及该结果需要刷新的时刻
+    ///
+    /// 查询结果随域名管理器一同持久化，因此在进程重启或 Fork 新进程后依然可用。需要刷新的结果依然会被返回，由调用方决定如何刷新
+    pub(crate) fn region_query(&self, key: &str) -> Option<(Box<str>, SystemTime)> {
+        self.inner
+            .inner_data
+            .region_queries
+            .get(key)
+            .map(|cache_entry| (cache_entry.data().to_owned(), cache_entry.expired_at()))
+    }
+
+    /// 缓存存储空间区域查询结果
+    ///
+    /// 该方法可能会触发自动持久化。
+    pub(crate) fn cache_region_query(&self, key: Box<str>, response: Box<str>, refresh_at: SystemTime) {
+        self.inner.inner_data.region_queries.insert(key, response, refresh_at);
+        self.mark_dirty();
+        self.try_to_persistent_if_needed();
+    }
+
     /// 选择域名并给出域名解析结果
     ///
     /// 从给出的候选 URL 中排除被冻结的域名，然后对每个候选 URL 给出一组域名解析结果。
@@ -527,6 +1069,7 @@ impl DomainsManager {
                 domains_manager.try_to_persistent_if_needed();
                 if !domains_manager.inner.inner_data.url_resolution_disabled {
                     domains_manager.try_to_async_refresh_resolutions_if_needed();
+                    domains_manager.try_to_probe_socket_addrs_if_needed();
                 }
             })
         }
@@ -542,6 +1085,7 @@ impl DomainsManager {
             (),
             SystemTime::now() + self.inner.inner_data.url_frozen_duration,
         );
+        self.mark_dirty();
         self.try_to_persistent_if_needed();
         Ok(())
     }
@@ -551,6 +1095,7 @@ impl DomainsManager {
     /// 该方法可能会触发自动持久化。
     pub fn unfreeze_urls(&self) {
         self.inner.inner_data.frozen_urls.clear();
+        self.mark_dirty();
         self.try_to_persistent_if_needed();
     }
 
@@ -578,17 +1123,129 @@ impl DomainsManager {
                 socket_addrs: Vec::new().into(),
             });
         }
-        self.resolve(base_url)
+        self.resolve(base_url, true)
             .ok()
             .map(|mut socket_addrs| {
-                // TODO: Think about IP address speed testing
-                socket_addrs.shuffle(rng);
+                self.sort_socket_addrs(&mut socket_addrs, rng);
                 socket_addrs
             })
             .map(|socket_addrs| Choice { base_url, socket_addrs })
     }
 
-    fn resolve(&self, url: &str) -> ResolveResult<Box<[SocketAddr]>> {
+    /// 按照 IP 地址统计信息对 IP 地址进行加权随机排序
+    ///
+    /// 每个 IP 地址排在首位的概率与其权重成正比，这样既优先选择更快的 IP 地址，又能将请求分散到多个 IP 地址上。
+    /// 没有统计信息的 IP 地址被视为与已知最快的 IP 地址一样快，以便尽快获得其统计信息
+    fn sort_socket_addrs(&self, socket_addrs: &mut [SocketAddr], rng: &mut ThreadRng) {
+        if socket_addrs.len() <= 1 {
+            return;
+        }
+        let now = SystemTime::now();
+        let stats: Vec<Option<SocketAddrStats>> = socket_addrs
+            .iter()
+            .map(|socket_addr| {
+                self.inner
+                    .inner_data
+                    .socket_addr_stats
+                    .get(socket_addr)
+                    .filter(|cache_entry| cache_entry.expired_at() >= now)
+                    .map(|cache_entry| *cache_entry.data())
+            })
+            .collect();
+        if stats.iter().all(Option::is_none) {
+            socket_addrs.shuffle(rng);
+            return;
+        }
+        let default_latency_millis = stats
+            .iter()
+            .filter_map(|stats| stats.filter(|stats| stats.successes > 0))
+            .map(|stats| stats.latency_millis)
+            .fold(None, |min: Option<f64>, latency_millis| {
+                Some(min.map_or(latency_millis, |min| min.min(latency_millis)))
+            })
+            .unwrap_or(1.0);
+        let mut keyed_socket_addrs: Vec<(f64, SocketAddr)> = socket_addrs
+            .iter()
+            .zip(stats.into_iter())
+            .map(|(&socket_addr, stats)| {
+                let weight = stats.unwrap_or_default().weight(default_latency_millis);
+                (rng.gen::<f64>().ln() / weight, socket_addr)
+            })
+            .collect();
+        keyed_socket_addrs.sort_by(|(key1, _), (key2, _)| key2.partial_cmp(key1).unwrap_or(Ordering::Equal));
+        socket_addrs
+            .iter_mut()
+            .zip(keyed_socket_addrs.into_iter())
+            .for_each(|(socket_addr, (_, sorted))| *socket_addr = sorted);
+    }
+
+    /// 记录一次对指定 IP 地址的成功请求及其耗时
+    ///
+    /// SDK 在每次得到 HTTP 响应后都会调用该方法，以更新 IP 地址统计信息
+    pub fn record_socket_addr_success(&self, socket_addr: SocketAddr, elapsed: Duration) {
+        self.update_socket_addr_stats(socket_addr, |stats| stats.record_success(elapsed));
+    }
+
+    /// 记录一次对指定 IP 地址的失败请求
+    ///
+    /// SDK 在每次连接失败或超时后都会调用该方法，以更新 IP 地址统计信息
+    pub fn record_socket_addr_failure(&self, socket_addr: SocketAddr) {
+        self.update_socket_addr_stats(socket_addr, SocketAddrStats::record_failure);
+    }
+
+    fn update_socket_addr_stats(&self, socket_addr: SocketAddr, f: impl FnOnce(&mut SocketAddrStats)) {
+        let expired_at = SystemTime::now() + self.inner.inner_data.resolutions_cache_lifetime;
+        self.inner
+            .inner_data
+            .socket_addr_stats
+            .alter(socket_addr, |cache_entry| {
+                let mut stats = cache_entry
+                    .filter(|(_, stats_expired_at)| *stats_expired_at >= SystemTime::now())
+                    .map(|(stats, _)| stats)
+                    .unwrap_or_default();
+                f(&mut stats);
+                Some((stats, expired_at))
+            });
+        if !self.inner.inner_data.socket_addr_stats_persistence_disabled {
+            self.mark_dirty();
+        }
+    }
+
+    fn try_to_probe_socket_addrs_if_needed(&self) {
+        if let Some(socket_addr_probe_interval) = self.inner.inner_data.socket_addr_probe_interval {
+            let mut last_probe_time = self.inner.last_probe_time.lock().unwrap();
+            if last_probe_time.elapsed() > socket_addr_probe_interval {
+                *last_probe_time = Instant::now();
+                self.async_probe_socket_addrs();
+            }
+        }
+    }
+
+    fn async_probe_socket_addrs(&self) {
+        let socket_addrs = RefCell::new(HashSet::new());
+        self.inner
+            .inner_data
+            .resolutions
+            .for_each_effective(|_, resolutions, _| {
+                socket_addrs.borrow_mut().extend(resolutions.iter().copied());
+            });
+        let socket_addrs = socket_addrs.into_inner();
+        if socket_addrs.is_empty() {
+            return;
+        }
+        let domains_manager = self.clone();
+        global_thread_pool.read().unwrap().spawn(move || {
+            for socket_addr in socket_addrs.into_iter() {
+                let timer = Instant::now();
+                match TcpStream::connect_timeout(&socket_addr, SOCKET_ADDR_PROBE_TIMEOUT) {
+                    Ok(_) => domains_manager.record_socket_addr_success(socket_addr, timer.elapsed()),
+                    Err(_) => domains_manager.record_socket_addr_failure(socket_addr),
+                }
+            }
+        });
+    }
+
+    fn resolve(&self, url: &str, negative_cache_enabled: bool) -> ResolveResult<Box<[SocketAddr]>> {
         let url = Self::host_with_port(url)?;
         match self.inner.inner_data.resolutions.get(&url) {
             Some(cache_entry) => {
@@ -598,59 +1255,107 @@ impl DomainsManager {
                     Ok(cache_entry.data().clone())
                 }
             }
-            None => self.resolve_and_update_cache(&url),
+            None => self.resolve_and_update_cache(&url, negative_cache_enabled),
         }
     }
 
     fn async_update_cache(&self, url: Box<str>) {
-        let domains_manager = self.clone();
-        global_thread_pool.read().unwrap().spawn(move || {
-            let _ = domains_manager.resolve_and_update_cache(&url);
-        });
+        if !self.is_negative_resolution(&url) {
+            self.start_resolving(url);
+        }
     }
 
-    fn resolve_and_update_cache(&self, url: &str) -> ResolveResult<Box<[SocketAddr]>> {
-        let mut result: Option<ResolveResult<Box<[SocketAddr]>>> = None;
+    /// 在后台线程中解析域名，并最多等待解析超时时长
+    ///
+    /// 解析期间不持有域名解析缓存的锁，因此不会阻塞其他域名的解析
+    fn resolve_and_update_cache(&self, url: &str, negative_cache_enabled: bool) -> ResolveResult<Box<[SocketAddr]>> {
+        if let Some(cache_entry) = self.inner.inner_data.resolutions.get(url) {
+            if cache_entry.expired_at() >= SystemTime::now() {
+                return Ok(cache_entry.data().clone());
+            }
+        }
+        if negative_cache_enabled && self.is_negative_resolution(url) {
+            return Err(IOError::new(IOErrorKind::Other, "Resolve failed recently").into());
+        }
+        Ok(self
+            .start_resolving(url.into())
+            .wait(self.inner.inner_data.resolve_timeout)?)
+    }
+
+    fn is_negative_resolution(&self, url: &str) -> bool {
         self.inner
             .inner_data
-            .resolutions
-            .alter(url.into(), |resolution| match resolution {
-                Some((socket_addrs, expired_at)) => {
-                    if expired_at < SystemTime::now() {
-                        match self.make_resolution(url) {
-                            Ok((socket_addrs, expired_at)) => {
-                                result = Some(Ok(socket_addrs.to_owned()));
-                                Some((socket_addrs, expired_at))
-                            }
-                            Err(err) => {
-                                result = Some(Err(err));
-                                None
-                            }
-                        }
-                    } else {
-                        result = Some(Ok(socket_addrs.to_owned()));
-                        Some((socket_addrs, expired_at))
-                    }
+            .negative_resolutions
+            .get(url)
+            .map_or(false, |cache_entry| cache_entry.expired_at() >= SystemTime::now())
+    }
+
+    /// 如果该域名已经在解析中，则返回正在进行的解析，否则在新的后台线程中开始解析
+    fn start_resolving(&self, url: Box<str>) -> Arc<Resolving> {
+        let resolving = {
+            let mut resolvings = self.inner.resolvings.lock().unwrap();
+            if let Some(resolving) = resolvings.get(&url) {
+                return resolving.to_owned();
+            }
+            let resolving = Arc::new(Resolving::default());
+            resolvings.insert(url.to_owned(), resolving.to_owned());
+            resolving
+        };
+        let spawned = {
+            let domains_manager = self.clone();
+            let url = url.to_owned();
+            let resolving = resolving.to_owned();
+            ThreadBuilder::new().name("qiniu_ng_resolver".into()).spawn(move || {
+                let stopwatch = Stopwatch::start();
+                let result = domains_manager.make_resolution(&url);
+                stopwatch.record(Timing::DNSResolution);
+                if result.is_err() {
+                    metrics::record_event(Event::DNSResolutionFailure);
                 }
-                None => match self.make_resolution(url) {
-                    Ok((socket_addrs, expired_at)) => {
-                        result = Some(Ok(socket_addrs.to_owned()));
-                        Some((socket_addrs, expired_at))
-                    }
-                    Err(err) => {
-                        result = Some(Err(err));
-                        None
-                    }
-                },
-            });
-        result.unwrap()
+                domains_manager.finish_resolving(&url, &resolving, result);
+            })
+        };
+        if let Err(err) = spawned {
+            self.finish_resolving(&url, &resolving, Err(err));
+        }
+        resolving
+    }
+
+    fn make_resolution(&self, url: &str) -> IOResult<Box<[SocketAddr]>> {
+        let (host, port) = split_host_port(url)
+            .ok_or_else(|| IOError::new(IOErrorKind::InvalidInput, format!("Invalid host with port: {}", url)))?;
+        let socket_addrs = self.inner.resolver.resolve(host, port)?;
+        if socket_addrs.is_empty() {
+            return Err(IOError::new(
+                IOErrorKind::NotFound,
+                format!("No address is resolved for {}", url),
+            ));
+        }
+        Ok(socket_addrs)
     }
 
-    fn make_resolution(&self, url: &str) -> ResolveResult<(Box<[SocketAddr]>, SystemTime)> {
-        Ok((
-            url.to_socket_addrs()?.collect::<Box<[_]>>(),
-            SystemTime::now() + self.inner.inner_data.resolutions_cache_lifetime,
-        ))
+    fn finish_resolving(&self, url: &str, resolving: &Resolving, result: IOResult<Box<[SocketAddr]>>) {
+        let inner_data = &self.inner.inner_data;
+        match &result {
+            Ok(socket_addrs) => {
+                inner_data.resolutions.insert(
+                    url.into(),
+                    socket_addrs.to_owned(),
+                    SystemTime::now() + inner_data.resolutions_cache_lifetime,
+                );
+                inner_data.negative_resolutions.remove(url);
+                self.mark_dirty();
+            }
+            Err(_) => {
+                inner_data.negative_resolutions.insert(
+                    url.into(),
+                    (),
+                    SystemTime::now() + inner_data.negative_resolutions_cache_lifetime,
+                );
+            }
+        }
+        self.inner.resolvings.lock().unwrap().remove(url);
+        resolving.complete(&result);
     }
 
     fn host_with_port(url: &str) -> URLParseResult<Box<str>> {
@@ -749,7 +1454,7 @@ impl DomainsManager {
         for _ in 0..self.inner.inner_data.url_resolve_retries {
             urls = urls
                 .into_iter()
-                .map(|url| (self.resolve(&url), url))
+                .map(|url| (self.resolve(&url, false), url))
                 .filter_map(|(result, url)| result.err().map(|_| url))
                 .collect();
             if urls.is_empty() {
@@ -775,6 +1480,18 @@ impl DomainsManager {
         self.inner.inner_data.resolutions_cache_lifetime
     }
 
+    /// 域名解析失败结果的缓存生命周期
+    #[inline]
+    pub fn negative_resolutions_cache_lifetime(&self) -> Duration {
+        self.inner.inner_data.negative_resolutions_cache_lifetime
+    }
+
+    /// 域名解析超时时长
+    #[inline]
+    pub fn resolve_timeout(&self) -> Duration {
+        self.inner.inner_data.resolve_timeout
+    }
+
     /// 是否禁止 URL 域名解析
     #[inline]
     pub fn url_resolution_disabled(&self) -> bool {
@@ -805,6 +1522,62 @@ impl DomainsManager {
         self.inner.inner_data.url_resolve_retry_delay
     }
 
+    /// 是否禁止持久化 IP 地址统计信息
+    #[inline]
+    pub fn socket_addr_stats_persistence_disabled(&self) -> bool {
+        self.inner.inner_data.socket_addr_stats_persistence_disabled
+    }
+
+    /// IP 地址探测间隔时间
+    #[inline]
+    pub fn socket_addr_probe_interval(&self) -> Option<Duration> {
+        self.inner.inner_data.socket_addr_probe_interval
+    }
+
+    /// 冻结 URL 缓存的最大容量
+    #[inline]
+    pub fn frozen_urls_max_capacity(&self) -> usize {
+        self.inner.inner_data.frozen_urls.max_capacity().unwrap()
+    }
+
+    /// 域名解析结果缓存的最大容量
+    #[inline]
+    pub fn resolutions_max_capacity(&self) -> usize {
+        self.inner.inner_data.resolutions.max_capacity().unwrap()
+    }
+
+    /// 域名解析失败结果缓存的最大容量
+    #[inline]
+    pub fn negative_resolutions_max_capacity(&self) -> usize {
+        self.inner.inner_data.negative_resolutions.max_capacity().unwrap()
+    }
+
+    /// IP 地址统计信息缓存的最大容量
+    #[inline]
+    pub fn socket_addr_stats_max_capacity(&self) -> usize {
+        self.inner.inner_data.socket_addr_stats.max_capacity().unwrap()
+    }
+
+    /// 存储空间区域查询结果缓存的最大容量
+    #[inline]
+    pub fn region_queries_max_capacity(&self) -> usize {
+        self.inner.inner_data.region_queries.max_capacity().unwrap()
+    }
+
+    /// 各个缓存的命中统计
+    ///
+    /// 统计从域名管理器生成时开始，各个分片独立计数，并发读写时结果只是近似值
+    pub fn cache_stats(&self) -> DomainsManagerCacheStats {
+        let inner_data = &self.inner.inner_data;
+        DomainsManagerCacheStats {
+            frozen_urls: inner_data.frozen_urls.stats(),
+            resolutions: inner_data.resolutions.stats(),
+            negative_resolutions: inner_data.negative_resolutions.stats(),
+            socket_addr_stats: inner_data.socket_addr_stats.stats(),
+            region_queries: inner_data.region_queries.stats(),
+        }
+    }
+
     /// 持久化路径
     #[inline]
     pub fn persistent_file_path(&self) -> Option<&Path> {
@@ -845,10 +1618,47 @@ pub struct Choice<'a> {
     pub socket_addrs: Box<[SocketAddr]>,
 }
 
+/// 将形如 `host:port` 的字符串拆分为主机和端口，IPv6 地址的方括号将被去除
+fn split_host_port(host_with_port: &str) -> Option<(&str, u16)> {
+    let mut parts = host_with_port.rsplitn(2, ':');
+    let port = parts.next()?.parse().ok()?;
+    let host = parts.next()?;
+    let host = if host.starts_with('[') && host.ends_with(']') {
+        &host[1..host.len() - 1]
+    } else {
+        host
+    };
+    Some((host, port))
+}
+
 fn open_persistent_file(path: &Path) -> IOResult<File> {
     OpenOptions::new().write(true).create(true).open(path)
 }
 
+/// 写入持久化文件
+///
+/// 优先写入同一目录下的临时文件，再将其原子地重命名为持久化文件，已经映射了旧文件的读取方不受影响。
+/// 如果无法在该目录下创建临时文件，则回退到直接覆盖已经打开的持久化文件
+fn write_persistent_file(path: &Path, file: &mut File, content: &[u8]) -> IOResult<()> {
+    let dir = path
+        .parent()
+        .filter(|dir| !dir.as_os_str().is_empty())
+        .unwrap_or_else(|| Path::new("."));
+    match NamedTempFile::new_in(dir) {
+        Ok(mut temp_file) => {
+            temp_file.write_all(content)?;
+            temp_file.as_file().sync_data()?;
+            *file = temp_file.persist(path).map_err(|err| err.error)?;
+            Ok(())
+        }
+        Err(_) => {
+            file.set_len(0)?;
+            file.seek(SeekFrom::Start(0))?;
+            file.write_all(content)
+        }
+    }
+}
+
 /// URL 解析错误
 #[derive(Error, Debug)]
 pub enum URLParseError {
@@ -898,7 +1708,14 @@ pub type PersistentResult<T> = Result<T, PersistentError>;
 mod tests {
     use super::*;
     use qiniu_test_utils::temp_file;
-    use std::{boxed::Box, error::Error, result::Result, thread};
+    use std::{
+        boxed::Box,
+        error::Error,
+        fs::{remove_file, write},
+        result::Result,
+        sync::atomic::{AtomicUsize, Ordering::Relaxed},
+        thread,
+    };
 
     #[test]
     fn test_domains_manager_in_multiple_threads() -> Result<(), Box<dyn Error>> {
@@ -983,6 +1800,28 @@ mod tests {
         Ok(())
     }
 
+    #[test]
+    fn test_domains_manager_cache_max_capacity() -> Result<(), Box<dyn Error>> {
+        let domains_manager = DomainsManagerBuilder::default()
+            .disable_url_resolution()
+            .frozen_urls_max_capacity(2)
+            .resolutions_max_capacity(16)
+            .build();
+        assert_eq!(domains_manager.frozen_urls_max_capacity(), 2);
+        assert_eq!(domains_manager.resolutions_max_capacity(), 16);
+        assert_eq!(
+            domains_manager.negative_resolutions_max_capacity(),
+            default::negative_resolutions_max_capacity()
+        );
+        domains_manager.freeze_url("http://up-z0.qiniup.com")?;
+        domains_manager.freeze_url("http://up-z1.qiniup.com")?;
+        domains_manager.freeze_url("http://up-z2.qiniup.com")?;
+        let stats = domains_manager.cache_stats();
+        assert_eq!(stats.frozen_urls.evictions, 1);
+        assert_eq!(stats.resolutions, CacheStats::default());
+        Ok(())
+    }
+
     #[test]
     fn test_domains_manager_persistent() -> Result<(), Box<dyn Error>> {
         let temp_path = temp_file::create_temp_file(0)?.into_temp_path();
@@ -1026,6 +1865,231 @@ mod tests {
         thread::sleep(Duration::from_secs(1));
         domains_manager.freeze_url("http://up-z1.qiniup.com")?;
         DomainsManagerInnerData::load_from_file(temp_path)?;
+
+        remove_file(temp_path)?;
+        thread::sleep(Duration::from_secs(1));
+        domains_manager.choose(&["http://up-z2.qiniup.com"])?;
+        assert!(!temp_path.exists());
+        domains_manager.freeze_url("http://up-z2.qiniup.com")?;
+        assert!(DomainsManagerInnerData::load_from_file(temp_path)?
+            .frozen_urls
+            .contains_key("up-z2.qiniup.com:80"));
+        Ok(())
+    }
+
+    #[test]
+    fn test_domains_manager_persistent_formats() -> Result<(), Box<dyn Error>> {
+        let temp_path = temp_file::create_temp_file(0)?.into_temp_path();
+        let temp_path: &Path = temp_path.as_ref();
+        let socket_addr: SocketAddr = "[::1]:8080".parse()?;
+        let domains_manager = new_domains_manager_builder(SystemResolver).build();
+        domains_manager.freeze_url("http://up-z0.qiniup.com")?;
+        domains_manager.inner.inner_data.resolutions.insert(
+            "up-z1.qiniup.com:80".into(),
+            vec![socket_addr].into(),
+            SystemTime::now() + Duration::from_secs(60),
+        );
+        domains_manager.record_socket_addr_success(socket_addr, Duration::from_millis(100));
+        domains_manager.cache_region_query(
+            "https://uc.qbox.me/ak:bucket".into(),
+            "{\"hosts\":[]}".into(),
+            SystemTime::now() - Duration::from_secs(60),
+        );
+
+        let snapshot = domains_manager.inner.inner_data.to_snapshot();
+        assert!(snapshot.starts_with(SNAPSHOT_MAGIC));
+        write(temp_path, &snapshot)?;
+        let inner = DomainsManagerInnerData::load_from_file(temp_path)?;
+        assert!(inner.frozen_urls.contains_key("up-z0.qiniup.com:80"));
+        assert_eq!(
+            inner.resolutions.get("up-z1.qiniup.com:80").unwrap().data().as_ref(),
+            &[socket_addr]
+        );
+        assert_eq!(inner.socket_addr_stats.get(&socket_addr).unwrap().successes, 1);
+        assert_eq!(
+            inner
+                .region_queries
+                .get("https://uc.qbox.me/ak:bucket")
+                .unwrap()
+                .data()
+                .as_ref(),
+            "{\"hosts\":[]}"
+        );
+        assert_eq!(inner.resolve_timeout, default::resolve_timeout());
+
+        let mut corrupted = snapshot.to_owned();
+        *corrupted.last_mut().unwrap() ^= 0xff;
+        write(temp_path, &corrupted)?;
+        DomainsManagerInnerData::load_from_file(temp_path).unwrap_err();
+
+        let persistent = PersistentDomainsManager::from(domains_manager.inner.inner_data.to_owned());
+        write(temp_path, serde_json::to_vec(&persistent)?)?;
+        let inner = DomainsManagerInnerData::load_from_file(temp_path)?;
+        assert!(inner.frozen_urls.contains_key("up-z0.qiniup.com:80"));
+        assert!(inner.resolutions.contains_key("up-z1.qiniup.com:80"));
+        assert!(inner.region_queries.contains_key("https://uc.qbox.me/ak:bucket"));
+        Ok(())
+    }
+
+    #[test]
+    fn test_domains_manager_choose_by_socket_addr_stats() -> Result<(), Box<dyn Error>> {
+        let fast_addr: SocketAddr = "192.168.1.1:80".parse()?;
+        let slow_addr: SocketAddr = "192.168.1.2:80".parse()?;
+        let failed_addr: SocketAddr = "192.168.1.3:80".parse()?;
+        let domains_manager = new_domains_manager_builder(SystemResolver).build();
+        domains_manager.inner.inner_data.resolutions.insert(
+            "up.example.com:80".into(),
+            vec![slow_addr, failed_addr, fast_addr].into(),
+            SystemTime::now() + Duration::from_secs(60),
+        );
+        for _ in 0..5 {
+            domains_manager.record_socket_addr_success(fast_addr, Duration::from_millis(10));
+            domains_manager.record_socket_addr_success(slow_addr, Duration::from_secs(1));
+            domains_manager.record_socket_addr_failure(failed_addr);
+        }
+
+        let mut fast_addr_chosen = 0;
+        for _ in 0..100 {
+            let choices = domains_manager.choose(&["http://up.example.com"])?;
+            assert_eq!(choices.len(), 1);
+            assert_eq!(choices.first().unwrap().socket_addrs.len(), 3);
+            if choices.first().unwrap().socket_addrs.first() == Some(&fast_addr) {
+                fast_addr_chosen += 1;
+            }
+        }
+        assert!(fast_addr_chosen > 60);
+        Ok(())
+    }
+
+    #[test]
+    fn test_domains_manager_socket_addr_stats() -> Result<(), Box<dyn Error>> {
+        let mut stats = SocketAddrStats::default();
+        stats.record_success(Duration::from_millis(100));
+        assert_eq!(stats.latency_millis.round() as u64, 100);
+        stats.record_success(Duration::from_millis(200));
+        assert_eq!(stats.latency_millis.round() as u64, 130);
+        stats.record_failure();
+        stats.record_failure();
+        assert_eq!((stats.failure_rate * 100.0).round() as u64, 51);
+        assert_eq!(stats.successes, 2);
+        assert_eq!(stats.failures, 2);
+        assert!(stats.weight(1.0) < SocketAddrStats::default().weight(130.0));
+
+        let temp_path = temp_file::create_temp_file(0)?.into_temp_path();
+        let temp_path: &Path = temp_path.as_ref();
+        let socket_addr: SocketAddr = "192.168.1.1:80".parse()?;
+        let domains_manager = DomainsManagerBuilder::create_new(Some(temp_path))?
+            .disable_url_resolution()
+            .build();
+        domains_manager.record_socket_addr_success(socket_addr, Duration::from_millis(100));
+        domains_manager.persistent().unwrap()?;
+        let inner = DomainsManagerInnerData::load_from_file(temp_path)?;
+        assert_eq!(inner.socket_addr_stats.get(&socket_addr).unwrap().successes, 1);
+
+        let domains_manager = DomainsManagerBuilder::load_from_file(temp_path)?
+            .disable_socket_addr_stats_persistence()
+            .build();
+        assert!(domains_manager.socket_addr_stats_persistence_disabled());
+        domains_manager.persistent().unwrap()?;
+        let inner = DomainsManagerInnerData::load_from_file(temp_path)?;
+        assert!(inner.socket_addr_stats.is_empty());
         Ok(())
     }
+
+    #[test]
+    fn test_domains_manager_resolve_concurrently() -> Result<(), Box<dyn Error>> {
+        let resolver = FakeResolver::new(Duration::from_millis(500), false);
+        let resolver_calls = resolver.calls.to_owned();
+        let domains_manager = new_domains_manager_builder(resolver).build();
+        let threads: Vec<_> = (0..10)
+            .map(|_| {
+                let domains_manager = domains_manager.to_owned();
+                thread::spawn(move || {
+                    let choices = domains_manager.choose(&["http://up.example.com"]).unwrap();
+                    assert_eq!(choices.len(), 1);
+                    assert_eq!(
+                        choices.first().unwrap().socket_addrs.as_ref(),
+                        &["127.0.0.1:80".parse::<SocketAddr>().unwrap()]
+                    );
+                })
+            })
+            .collect();
+        threads.into_iter().for_each(|thread| thread.join().unwrap());
+        assert_eq!(resolver_calls.load(Relaxed), 1);
+        assert!(domains_manager
+            .inner
+            .inner_data
+            .resolutions
+            .contains_key("up.example.com:80"));
+        Ok(())
+    }
+
+    #[test]
+    fn test_domains_manager_resolve_timeout_and_negative_cache() -> Result<(), Box<dyn Error>> {
+        let resolver = FakeResolver::new(Duration::from_millis(300), true);
+        let resolver_calls = resolver.calls.to_owned();
+        let domains_manager = new_domains_manager_builder(resolver)
+            .resolve_timeout(Duration::from_millis(100))
+            .negative_resolutions_cache_lifetime(Duration::from_secs(5))
+            .build();
+
+        let err = domains_manager.resolve("http://up.example.com", true).unwrap_err();
+        assert!(matches!(err, ResolveError::ResolveError(ref err) if err.kind() == IOErrorKind::TimedOut));
+        thread::sleep(Duration::from_millis(400));
+        assert_eq!(resolver_calls.load(Relaxed), 1);
+
+        let timer = Instant::now();
+        domains_manager.resolve("http://up.example.com", true).unwrap_err();
+        assert!(timer.elapsed() < Duration::from_millis(100));
+        assert_eq!(resolver_calls.load(Relaxed), 1);
+
+        domains_manager.resolve("http://up.example.com", false).unwrap_err();
+        thread::sleep(Duration::from_millis(400));
+        assert_eq!(resolver_calls.load(Relaxed), 2);
+        Ok(())
+    }
+
+    #[test]
+    fn test_split_host_port() {
+        assert_eq!(split_host_port("up.qiniup.com:80"), Some(("up.qiniup.com", 80)));
+        assert_eq!(split_host_port("[::1]:8080"), Some(("::1", 8080)));
+        assert_eq!(split_host_port("up.qiniup.com"), None);
+    }
+
+    fn new_domains_manager_builder(resolver: impl Resolver + 'static) -> DomainsManagerBuilder {
+        DomainsManagerBuilder {
+            inner_data: Default::default(),
+            persistent: None,
+            pre_resolution_urls: Default::default(),
+            resolver: Arc::new(resolver),
+        }
+    }
+
+    struct FakeResolver {
+        calls: Arc<AtomicUsize>,
+        delay: Duration,
+        failed: bool,
+    }
+
+    impl FakeResolver {
+        fn new(delay: Duration, failed: bool) -> Self {
+            FakeResolver {
+                calls: Default::default(),
+                delay,
+                failed,
+            }
+        }
+    }
+
+    impl Resolver for FakeResolver {
+        fn resolve(&self, host: &str, port: u16) -> IOResult<Box<[SocketAddr]>> {
+            self.calls.fetch_add(1, Relaxed);
+            thread::sleep(self.delay);
+            if self.failed {
+                Err(IOError::new(IOErrorKind::NotFound, format!("{} is not found", host)))
+            } else {
+                Ok(vec![SocketAddr::new("127.0.0.1".parse().unwrap(), port)].into())
+            }
+        }
+    }
 }
@@ -3,9 +3,10 @@
 //! 负责对整个 SDK 的 HTTP 逻辑进行处理，包含 HTTP 请求的重试逻辑，HTTP 请求中间件和域名管理等。
 
 pub use qiniu_http::{
-    Error, ErrorKind, HTTPCaller, HTTPCallerErrorKind, HeaderName, HeaderValue, Headers, Method, Result, RetryKind,
-    StatusCode,
+    BandwidthLimiter, CancellationToken, Error, ErrorKind, HTTPCallback, HTTPCaller, HTTPCallerErrorKind, HeaderName,
+    HeaderValue, Headers, Method, Result, RetryKind, StatusCode,
 };
+pub use qiniu_http::metrics;
 mod client;
 pub(crate) use client::Client;
 
@@ -19,6 +20,9 @@ pub(crate) use handler::PanickedHTTPCaller;
 mod middleware;
 pub use middleware::{HTTPAfterAction, HTTPBeforeAction};
 
+pub mod resolver;
+pub use resolver::{Resolver, SystemResolver};
+
 pub(crate) mod request;
 mod response;
 pub(crate) use response::Response;
@@ -3,7 +3,7 @@ use super::{
         token::{Token, Version},
         DomainsManager, Response,
     },
-    HTTPError, HTTPResult, HeaderName, HeaderValue, Headers, Method, Parts, Request,
+    CancellationToken, HTTPError, HTTPResult, HeaderName, HeaderValue, Headers, Method, Parts, Request, RequestBody,
 };
 use crate::{utils::mime, Config, Credential};
 use serde::Serialize;
@@ -25,13 +25,14 @@ impl<'a> Builder<'a> {
                 path,
                 query: HashMap::new(),
                 headers: Headers::new(),
-                body: Vec::new(),
+                body: Default::default(),
                 token: None,
                 read_body: false,
                 idempotent: false,
                 follow_redirection: false,
                 on_uploading_progress: None,
                 on_downloading_progress: None,
+                cancellation_token: None,
                 on_response: None,
                 on_error: None,
             },
@@ -68,6 +69,11 @@ impl<'a> Builder<'a> {
         self
     }
 
+    pub(crate) fn cancellation_token(mut self, cancellation_token: Option<&'a CancellationToken>) -> Builder<'a> {
+        self.parts.cancellation_token = cancellation_token;
+        self
+    }
+
     pub(crate) fn on_downloading_progress(mut self, callback: &'a dyn Fn(u64, u64)) -> Builder<'a> {
         self.parts.on_downloading_progress = Some(callback);
         self
@@ -97,7 +103,7 @@ impl<'a> Builder<'a> {
         self.build()
     }
 
-    pub(crate) fn raw_body<T: Into<Vec<u8>>, S: Into<HeaderValue<'a>>>(
+    pub(crate) fn raw_body<T: Into<RequestBody<'a>>, S: Into<HeaderValue<'a>>>(
         mut self,
         content_type: S,
         body: T,
@@ -110,7 +116,7 @@ impl<'a> Builder<'a> {
     pub(crate) fn json_body<T: Serialize>(mut self, body: &T) -> serde_json::Result<Request<'a>> {
         let serialized_body = serde_json::to_vec(body)?;
         self = self.header("Content-Type", mime::JSON_MIME);
-        self.parts.body = serialized_body;
+        self.parts.body = serialized_body.into();
         Ok(self.build())
     }
 
@@ -118,6 +124,7 @@ impl<'a> Builder<'a> {
         Request {
             parts: self.parts,
             domains_manager: self.domains_manager,
+            hedges: Default::default(),
         }
     }
 }
@@ -0,0 +1,347 @@
+use super::{
+    super::{
+        metrics::{self, Event},
+        response::Response,
+        token::Token,
+        Choice, DomainsManager,
+    },
+    Request,
+};
+use crate::{utils::thread_pool::hedge_thread_pool, Config};
+use qiniu_http::{
+    CancellationToken, Error as HTTPError, ErrorKind as HTTPErrorKind, Headers, Method, RequestBody,
+    Response as HTTPResponse, ResponseBody as HTTPResponseBody, ResponseBuilder as HTTPResponseBuilder,
+    Result as HTTPResult, StatusCode,
+};
+use std::{
+    borrow::Cow,
+    io::Result as IOResult,
+    net::{IpAddr, SocketAddr},
+    sync::{
+        atomic::Ordering::Relaxed,
+        mpsc::{channel, RecvTimeoutError},
+        Arc, Mutex,
+    },
+    time::{Duration, Instant},
+};
+
+/// 可以复制给对冲请求的请求体数据流的最大长度
+///
+/// 更长的数据流复制开销过大，不发出对冲请求
+const MAX_HEDGE_STREAM_BODY_SIZE: u64 = 1 << 22;
+
+impl<'a> Request<'a> {
+    /// 仅当配置了对冲请求延迟，请求可以安全地重复发送，且请求体可以被复制时，才会发出对冲请求
+    ///
+    /// 请求方法为 GET 或 HEAD，或被调用方明确标记为幂等的请求（例如分片上传的各个请求和表单上传请求），才被视为可以安全地重复发送。
+    /// 仅以 PUT 方法发出而未被标记为幂等的请求不发出对冲请求。
+    /// 请求体已经完整加载进内存，或是长度不超过 4 MB 的可倒回数据流时，才可以被复制
+    pub(super) fn hedge_delay(&self) -> Option<Duration> {
+        let hedge_delay = self.parts.config.http_request_hedge_delay()?;
+        let idempotent = match self.parts.method {
+            Method::GET | Method::HEAD => true,
+            _ => self.parts.idempotent,
+        };
+        let copyable = match &self.parts.body {
+            RequestBody::Bytes(_) => true,
+            RequestBody::Stream(stream) => stream.size() <= MAX_HEDGE_STREAM_BODY_SIZE,
+        };
+        Some(hedge_delay).filter(|_| idempotent && copyable)
+    }
+
+    /// 复制请求体，以便传递给对冲请求线程池
+    ///
+    /// 数据流读取完毕后不必倒回，HTTP 客户端在发送请求前总是会重新定位
+    fn copy_body(&self) -> IOResult<Vec<u8>> {
+        match &self.parts.body {
+            RequestBody::Bytes(body) => Ok(body.to_vec()),
+            RequestBody::Stream(stream) => {
+                let mut body = vec![0u8; stream.size() as usize];
+                stream.seek(0)?;
+                let mut have_read = 0;
+                while have_read < body.len() {
+                    match stream.read(&mut body[have_read..])? {
+                        0 => break,
+                        n => have_read += n,
+                    }
+                }
+                body.truncate(have_read);
+                Ok(body)
+            }
+        }
+    }
+
+    /// 向 `choice` 发出请求，如果在 `hedge_delay` 内仍未得到结果，则再向 `next_choice` 发出对冲请求
+    ///
+    /// 如果没有 `next_choice`，则对 `choice` 的下一个 IP 地址发出对冲请求。
+    /// 对冲请求由对冲请求线程池在延迟到期后发出，原请求在延迟内完成时不会发出对冲请求。
+    /// 两个请求中先成功的一个将被采用，另一个将被取消。
+    /// 如果对冲请求尚未发出 `choice` 就已经得到结果，`next_choice` 将被原样返回，以便调用方继续尝试
+    pub(super) fn race_choices(
+        &self,
+        choice: Choice<'a>,
+        next_choice: Option<Choice<'a>>,
+        hedge_delay: Duration,
+    ) -> (HTTPResult<Response<'a>>, Option<Choice<'a>>) {
+        let (hedge_choice, is_next_choice) = match next_choice {
+            Some(next_choice) => (next_choice, true),
+            None if choice.socket_addrs.len() > 1 => {
+                let mut socket_addrs = choice.socket_addrs.to_vec();
+                socket_addrs.rotate_left(1);
+                let hedge_choice = Choice {
+                    base_url: choice.base_url,
+                    socket_addrs: socket_addrs.into(),
+                };
+                (hedge_choice, false)
+            }
+            None => return (self.try_choice(choice, self.parts.cancellation_token), None),
+        };
+        let (attempt, body_len) = match (self.make_url(hedge_choice.base_url), self.copy_body()) {
+            (Ok(url), Ok(body)) => {
+                let body_len = body.len();
+                let attempt = HedgeAttempt {
+                    config: self.parts.config.to_owned(),
+                    domains_manager: self.domains_manager.to_owned(),
+                    method: self.parts.method,
+                    url,
+                    headers: self
+                        .parts
+                        .headers
+                        .iter()
+                        .map(|(name, value)| (name.as_ref().to_owned().into(), value.as_ref().to_owned().into()))
+                        .collect(),
+                    body,
+                    token: self.parts.token.as_ref().map(Token::to_static),
+                    follow_redirection: self.parts.follow_redirection,
+                    socket_addrs: hedge_choice.socket_addrs.to_owned(),
+                };
+                (attempt, body_len)
+            }
+            _ => {
+                let result = self.try_choice(choice, self.parts.cancellation_token);
+                return (result, Some(hedge_choice).filter(|_| is_next_choice));
+            }
+        };
+
+        let choice_token = self.new_child_token();
+        let hedge_token = self.new_child_token();
+        let status = Arc::new(Mutex::new(HedgeStatus::Pending));
+        let (stop_sender, stop_receiver) = channel::<()>();
+        let (result_sender, result_receiver) = channel();
+        {
+            let deadline = Instant::now() + hedge_delay;
+            let (status, choice_token, hedge_token) =
+                (status.to_owned(), choice_token.to_owned(), hedge_token.to_owned());
+            hedge_thread_pool().spawn(move || {
+                // 在线程池中排队的时间也计入对冲请求延迟
+                let now = Instant::now();
+                let timeout = if deadline > now {
+                    deadline - now
+                } else {
+                    Duration::from_secs(0)
+                };
+                match stop_receiver.recv_timeout(timeout) {
+                    Err(RecvTimeoutError::Timeout) => {}
+                    _ => return,
+                }
+                {
+                    let mut status = status.lock().unwrap();
+                    if *status == HedgeStatus::Abandoned {
+                        return;
+                    }
+                    *status = HedgeStatus::Started;
+                }
+                metrics::record_event(Event::HedgedRequest);
+                let timer = Instant::now();
+                let result = attempt.send(&hedge_token);
+                if result.is_ok() {
+                    choice_token.cancel();
+                }
+                let _ = result_sender.send((result, timer.elapsed()));
+            });
+        }
+        let result = self.try_choice(choice, Some(&choice_token));
+        let started = {
+            let mut status = status.lock().unwrap();
+            if *status == HedgeStatus::Pending {
+                *status = HedgeStatus::Abandoned;
+                false
+            } else {
+                self.hedges.fetch_add(1, Relaxed);
+                true
+            }
+        };
+        drop(stop_sender);
+        match &result {
+            Err(err) if self.is_choice_failed(err) => {}
+            _ => hedge_token.cancel(),
+        }
+        let hedge_result = if started { result_receiver.recv().ok() } else { None };
+
+        match (result, hedge_result) {
+            (result, None) => (result, Some(hedge_choice).filter(|_| is_next_choice)),
+            (Ok(response), Some((hedge_result, elapsed))) => {
+                if let Err(err) = hedge_result {
+                    self.handle_hedge_error(&hedge_choice, is_next_choice, &hedge_token, &err, elapsed);
+                }
+                (Ok(response), None)
+            }
+            (Err(_), Some((Ok(hedge_response), elapsed))) => {
+                if let Err(err) = self.check_canceled(self.parts.cancellation_token) {
+                    return (Err(err), None);
+                }
+                let result = self.accept_hedged_response(hedge_choice.base_url, hedge_response, body_len, elapsed);
+                (result, None)
+            }
+            (Err(err), Some((Err(hedge_err), elapsed))) => {
+                self.handle_hedge_error(&hedge_choice, is_next_choice, &hedge_token, &hedge_err, elapsed);
+                (Err(err), None)
+            }
+        }
+    }
+
+    fn new_child_token(&self) -> CancellationToken {
+        self.parts
+            .cancellation_token
+            .map(CancellationToken::child_token)
+            .unwrap_or_default()
+    }
+
+    /// 被主动取消的对冲请求不视为失败，对于指向同一个 URL 的对冲请求，失败时不冻结该 URL
+    fn handle_hedge_error(
+        &self,
+        hedge_choice: &Choice,
+        is_next_choice: bool,
+        hedge_token: &CancellationToken,
+        err: &HTTPError,
+        elapsed: Duration,
+    ) {
+        if hedge_token.is_canceled() {
+            return;
+        }
+        if let Some(on_error) = &self.parts.on_error {
+            (on_error)(Some(hedge_choice.base_url), err, elapsed);
+        }
+        if is_next_choice && self.is_choice_failed(err) {
+            self.domains_manager.freeze_url(hedge_choice.base_url).unwrap();
+        }
+    }
+
+    fn accept_hedged_response(
+        &self,
+        base_url: &'a str,
+        hedged_response: HedgedResponse,
+        body_len: usize,
+        elapsed: Duration,
+    ) -> HTTPResult<Response<'a>> {
+        let mut response = Response {
+            inner: hedged_response.into_response(),
+            method: self.parts.method,
+            base_url,
+            path: self.parts.path,
+            hedges: self.hedges.load(Relaxed),
+        };
+        // 对冲请求不回调进度函数，因此在采用其响应时补充一次完成进度
+        if let Some(on_uploading_progress) = self.parts.on_uploading_progress {
+            (on_uploading_progress)(body_len as u64, body_len as u64);
+        }
+        if let Some(on_response) = &self.parts.on_response {
+            (on_response)(&mut response, elapsed)?;
+        }
+        Ok(response)
+    }
+}
+
+/// 对冲请求的状态，由原请求和对冲请求共同维护，以确保原请求完成后不再发出对冲请求
+#[derive(Debug, Copy, Clone, PartialEq, Eq)]
+enum HedgeStatus {
+    Pending,
+    Started,
+    Abandoned,
+}
+
+/// 对冲请求所需的请求内容
+///
+/// 所有内容均已复制，可以传递给对冲请求线程池，因此对冲请求不回调进度函数，也不进行重试
+struct HedgeAttempt {
+    config: Config,
+    domains_manager: DomainsManager,
+    method: Method,
+    url: String,
+    headers: Headers<'static>,
+    body: Vec<u8>,
+    token: Option<Token<'static>>,
+    follow_redirection: bool,
+    socket_addrs: Box<[SocketAddr]>,
+}
+
+impl HedgeAttempt {
+    fn send(&self, cancellation_token: &CancellationToken) -> HTTPResult<HedgedResponse> {
+        let mut request = Request::new_request_builder(
+            &self.config,
+            self.method,
+            self.url.to_owned(),
+            self.follow_redirection,
+            self.headers.to_owned(),
+            RequestBody::Bytes(Cow::Borrowed(self.body.as_slice())),
+            &self.socket_addrs,
+        )
+        .cancellation_token(cancellation_token)
+        .build();
+        if let Some(token) = &self.token {
+            token.sign(&mut request).map_err(|err| {
+                HTTPError::new_unretryable_error_from_req_resp(HTTPErrorKind::IOError(err), &request, None)
+            })?;
+        }
+        let timer = Instant::now();
+        let result = Request::do_request(&self.config, &mut request);
+        Request::record_socket_addr_stats(&self.domains_manager, &self.socket_addrs, &result, timer.elapsed());
+        result
+            .and_then(|response| Request::check_response(response, &request))
+            .and_then(|response| Request::fulfill_body(response, &request))
+            .map(HedgedResponse::from)
+    }
+}
+
+/// 对冲请求得到的 HTTP 响应
+///
+/// 响应体已经被完整读出，因此可以从发出对冲请求的线程传回
+struct HedgedResponse {
+    status_code: StatusCode,
+    headers: Headers<'static>,
+    body: Option<Vec<u8>>,
+    server_ip: Option<IpAddr>,
+    server_port: u16,
+}
+
+impl From<HTTPResponse> for HedgedResponse {
+    fn from(mut response: HTTPResponse) -> Self {
+        let body = match response.take_body() {
+            Some(HTTPResponseBody::Bytes(body)) => Some(body),
+            _ => None,
+        };
+        HedgedResponse {
+            status_code: response.status_code(),
+            headers: response.headers().to_owned(),
+            body,
+            server_ip: response.server_ip(),
+            server_port: response.server_port(),
+        }
+    }
+}
+
+impl HedgedResponse {
+    fn into_response(self) -> HTTPResponse {
+        let mut builder = HTTPResponseBuilder::default()
+            .status_code(self.status_code)
+            .headers(self.headers)
+            .server_port(self.server_port);
+        if let Some(server_ip) = self.server_ip {
+            builder = builder.server_ip(server_ip);
+        }
+        if let Some(body) = self.body {
+            builder = builder.bytes_as_body(body);
+        }
+        builder.build()
+    }
+}
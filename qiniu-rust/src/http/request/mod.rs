@@ -1,21 +1,28 @@
 mod builder;
+mod hedge;
 mod parts;
 
 pub(crate) use builder::Builder;
 pub(crate) use parts::Parts;
 
-use super::{response::Response, Choice, DomainsManager};
-use crate::utils::mime;
+use super::{
+    metrics::{self, Event, Timing},
+    response::Response,
+    Choice, DomainsManager,
+};
+use crate::{utils::mime, Config};
 use qiniu_http::{
-    Error as HTTPError, ErrorKind as HTTPErrorKind, HeaderName, HeaderValue, Headers, Method, Request as HTTPRequest,
-    RequestBuilder, Response as HTTPResponse, ResponseBody as HTTPResponseBody, Result as HTTPResult,
-    RetryKind as HTTPRetryKind, StatusCode,
+    CancellationToken, Error as HTTPError, ErrorKind as HTTPErrorKind, HTTPCallerErrorKind, HeaderName, HeaderValue,
+    Headers, Method, Request as HTTPRequest, RequestBody, RequestBuilder, Response as HTTPResponse,
+    ResponseBody as HTTPResponseBody, Result as HTTPResult, RetryKind as HTTPRetryKind, StatusCode,
 };
 use rand::{thread_rng, Rng};
 use serde::Deserialize;
 use std::{
     fmt,
     io::{Error as IOError, ErrorKind as IOErrorKind, Read},
+    net::SocketAddr,
+    sync::atomic::{AtomicUsize, Ordering::Relaxed},
     thread::sleep,
     time::{Duration, Instant},
 };
@@ -29,6 +36,7 @@ pub(super) struct RequestErrorResponse {
 pub(crate) struct Request<'a> {
     pub(super) parts: Parts<'a>,
     pub(super) domains_manager: DomainsManager,
+    hedges: AtomicUsize,
 }
 
 impl<'a> Request<'a> {
@@ -43,71 +51,108 @@ impl<'a> Request<'a> {
                 None,
             )
         })?;
-        for choice in choices {
+        let hedge_delay = self.hedge_delay();
+        let mut choices = choices.into_iter();
+        let mut next_choice = choices.next();
+        while let Some(choice) = next_choice.take() {
+            self.check_canceled(self.parts.cancellation_token)?;
+            next_choice = choices.next();
             let base_url = choice.base_url;
             let timer = Instant::now();
-            match self.try_choice(choice) {
+            let result = match hedge_delay {
+                Some(hedge_delay) => {
+                    let (result, unused_choice) = self.race_choices(choice, next_choice.take(), hedge_delay);
+                    next_choice = unused_choice.or_else(|| choices.next());
+                    result
+                }
+                None => self.try_choice(choice, self.parts.cancellation_token),
+            };
+            match result {
                 Ok(resp) => {
                     return Ok(resp);
                 }
-                Err(err) => match err.retry_kind() {
-                    HTTPRetryKind::RetryableError | HTTPRetryKind::HostUnretryableError if self.is_retry_safe(&err) => {
+                Err(err) => {
+                    if let Some(on_error) = &self.parts.on_error {
+                        (on_error)(Some(base_url), &err, timer.elapsed());
+                    }
+                    if self.is_choice_failed(&err) {
                         self.domains_manager.freeze_url(base_url).unwrap();
-                        if let Some(on_error) = &self.parts.on_error {
-                            (on_error)(Some(base_url), &err, timer.elapsed());
-                        }
+                        metrics::record_event(Event::URLFrozen);
                         prev_err = Some(err);
                         continue;
                     }
-                    _ => {
-                        if let Some(on_error) = &self.parts.on_error {
-                            (on_error)(Some(base_url), &err, timer.elapsed());
-                        }
-                        return Err(err);
-                    }
-                },
+                    return Err(err);
+                }
             }
         }
         Err(prev_err.unwrap())
     }
 
-    fn try_choice(&self, choice: Choice<'a>) -> HTTPResult<Response<'a>> {
+    /// 判断错误是否应该冻结当前 URL 并尝试下一个 URL
+    fn is_choice_failed(&self, err: &HTTPError) -> bool {
+        match err.retry_kind() {
+            HTTPRetryKind::RetryableError | HTTPRetryKind::HostUnretryableError => self.is_retry_safe(err),
+            _ => false,
+        }
+    }
+
+    /// 取消令牌被取消后，不再尝试其他域名，也不再重试
+    fn check_canceled(&self, cancellation_token: Option<&CancellationToken>) -> HTTPResult<()> {
+        if cancellation_token.map_or(false, CancellationToken::is_canceled) {
+            Err(HTTPError::new_unretryable_error(
+                HTTPErrorKind::UserCanceled,
+                Some(self.parts.method),
+                None,
+                None,
+            ))
+        } else {
+            Ok(())
+        }
+    }
+
+    fn try_choice(
+        &self,
+        choice: Choice<'a>,
+        cancellation_token: Option<&CancellationToken>,
+    ) -> HTTPResult<Response<'a>> {
         let mut request = {
-            let mut builder = RequestBuilder::default()
-                .method(self.parts.method)
-                .url(self.make_url(choice.base_url)?)
-                .user_agent(self.parts.config.user_agent())
-                .connect_timeout(self.parts.config.http_connect_timeout())
-                .request_timeout(self.parts.config.http_request_timeout())
-                .tcp_keepalive_idle_timeout(self.parts.config.tcp_keepalive_idle_timeout())
-                .tcp_keepalive_probe_interval(self.parts.config.tcp_keepalive_probe_interval())
-                .low_transfer_speed(self.parts.config.http_low_transfer_speed())
-                .low_transfer_speed_timeout(self.parts.config.http_low_transfer_speed_timeout())
-                .follow_redirection(self.parts.follow_redirection)
-                .headers(self.parts.headers.to_owned())
-                .body(self.parts.body.as_slice());
-            if !choice.socket_addrs.is_empty() {
-                builder = builder.resolved_socket_addrs(choice.socket_addrs.as_ref());
-            }
+            let mut builder = Self::new_request_builder(
+                &self.parts.config,
+                self.parts.method,
+                self.make_url(choice.base_url)?,
+                self.parts.follow_redirection,
+                self.parts.headers.to_owned(),
+                self.parts.body.as_borrowed(),
+                choice.socket_addrs.as_ref(),
+            );
             if let Some(on_uploading_progress) = self.parts.on_uploading_progress {
                 builder = builder.on_uploading_progress(on_uploading_progress);
             }
             if let Some(on_downloading_progress) = self.parts.on_downloading_progress {
                 builder = builder.on_downloading_progress(on_downloading_progress);
             }
+            if let Some(cancellation_token) = cancellation_token {
+                builder = builder.cancellation_token(cancellation_token);
+            }
             builder.build()
         };
         if let Some(token) = &self.parts.token {
-            token.sign(&mut request);
+            token.sign(&mut request).map_err(|err| {
+                HTTPError::new_unretryable_error_from_req_resp(HTTPErrorKind::IOError(err), &request, None)
+            })?;
         }
 
         let mut prev_err: Option<HTTPError> = None;
         let retries = self.parts.config.http_request_retries();
         assert!(retries > 0);
         for _ in 0..=retries {
+            self.check_canceled(cancellation_token)?;
             let timer = Instant::now();
-            match self
-                .do_request(&mut request)
+            let result = Self::do_request(&self.parts.config, &mut request);
+            let elapsed = timer.elapsed();
+            metrics::record_duration(Timing::HTTPRequest, elapsed);
+            Self::record_socket_addr_stats(&self.domains_manager, &choice.socket_addrs, &result, elapsed);
+            match result
                 .and_then(|response| Self::check_response(response, &request))
                 .and_then(|response| self.fulfill_body_if_needed(response, &request))
                 .map(|response| Response {
@@ -115,6 +160,7 @@ impl<'a> Request<'a> {
                     method: self.parts.method,
                     base_url: choice.base_url,
                     path: self.parts.path,
+                    hedges: self.hedges.load(Relaxed),
                 })
                 .and_then(|mut response| {
                     if let Some(on_response) = &self.parts.on_response {
@@ -130,6 +176,7 @@ impl<'a> Request<'a> {
                         if let Some(on_error) = &self.parts.on_error {
                             (on_error)(Some(&choice.base_url), &err, timer.elapsed());
                         }
+                        metrics::record_event(Event::Retry);
                         prev_err = Some(err);
                         let delay_nanos = self.parts.config.http_request_retry_delay().as_nanos() as u64;
                         if delay_nanos > 0 {
@@ -148,20 +195,82 @@ impl<'a> Request<'a> {
         Err(prev_err.unwrap())
     }
 
-    fn do_request(&self, request: &mut HTTPRequest) -> HTTPResult<HTTPResponse> {
-        for handler in self.parts.config.http_request_before_action_handlers().iter() {
+    fn new_request_builder<'r>(
+        config: &'r Config,
+        method: Method,
+        url: String,
+        follow_redirection: bool,
+        headers: Headers<'r>,
+        body: RequestBody<'r>,
+        socket_addrs: &'r [SocketAddr],
+    ) -> RequestBuilder<'r> {
+        let mut builder = RequestBuilder::default()
+            .method(method)
+            .url(url)
+            .user_agent(config.user_agent())
+            .connect_timeout(config.http_connect_timeout())
+            .request_timeout(config.http_request_timeout())
+            .tcp_keepalive_idle_timeout(config.tcp_keepalive_idle_timeout())
+            .tcp_keepalive_probe_interval(config.tcp_keepalive_probe_interval())
+            .low_transfer_speed(config.http_low_transfer_speed())
+            .low_transfer_speed_timeout(config.http_low_transfer_speed_timeout())
+            .follow_redirection(follow_redirection)
+            .headers(headers)
+            .body(body);
+        if !socket_addrs.is_empty() {
+            builder = builder.resolved_socket_addrs(socket_addrs);
+        }
+        builder
+    }
+
+    fn do_request(config: &Config, request: &mut HTTPRequest) -> HTTPResult<HTTPResponse> {
+        for handler in config.http_request_before_action_handlers().iter() {
             handler.before_call(request)?;
         }
-        let mut response = self.parts.config.http_request_handler().call(&request)?;
-        for handler in self.parts.config.http_request_after_action_handlers().iter() {
+        let mut response = config.http_request_handler().call(&request)?;
+        for handler in config.http_request_after_action_handlers().iter() {
             handler.after_call(request, &mut response)?;
         }
-        if let Some(handler) = self.parts.config.http_request_final_handler() {
+        if let Some(handler) = config.http_request_final_handler() {
             handler.after_call(request, &mut response)?;
         }
         Ok(response)
     }
 
+    /// 以实际的请求结果更新 IP 地址统计信息，以便域名管理器优先选择更快的 IP 地址
+    ///
+    /// 只要得到 HTTP 响应，就记录响应所来自 IP 地址的耗时。
+    /// 对于连接失败或超时的情况，则记录在优先尝试的 IP 地址上
+    fn record_socket_addr_stats(
+        domains_manager: &DomainsManager,
+        socket_addrs: &[SocketAddr],
+        result: &HTTPResult<HTTPResponse>,
+        elapsed: Duration,
+    ) {
+        match result {
+            Ok(response) => {
+                if let Some(server_ip) = response.server_ip() {
+                    domains_manager
+                        .record_socket_addr_success(SocketAddr::new(server_ip, response.server_port()), elapsed);
+                }
+            }
+            Err(err) => {
+                if let (HTTPErrorKind::HTTPCallerError(caller_error), Some(&socket_addr)) =
+                    (err.error_kind(), socket_addrs.first())
+                {
+                    match caller_error.kind() {
+                        HTTPCallerErrorKind::ConnectionError
+                        | HTTPCallerErrorKind::SSLError
+                        | HTTPCallerErrorKind::TimeoutError => {
+                            domains_manager.record_socket_addr_failure(socket_addr);
+                        }
+                        _ => {}
+                    }
+                }
+            }
+        }
+    }
+
     fn make_url(&self, base_url: &str) -> HTTPResult<String> {
         let mut url = base_url.to_owned() + self.parts.path;
         if !self.parts.query.is_empty() {
@@ -338,6 +447,7 @@ mod tests {
         },
         Builder, *,
     };
+    use qiniu_http::{RequestBodyStream, ResponseBuilder};
     use qiniu_test_utils::http_call_mock::{CounterCallMock, ErrorResponseMock};
     use std::{
         boxed::Box,
@@ -346,7 +456,7 @@ mod tests {
         result::Result as StdResult,
         sync::{
             atomic::{AtomicUsize, Ordering::Relaxed},
-            Arc,
+            Arc, Mutex,
         },
         time::Duration,
     };
@@ -412,6 +522,222 @@ mod tests {
         Ok(())
     }
 
+    #[derive(Debug, Clone)]
+    struct HTTPCanceler {
+        cancellation_token: CancellationToken,
+    }
+
+    impl HTTPCaller for HTTPCanceler {
+        fn call(&self, request: &HTTPRequest) -> HTTPResult<HTTPResponse> {
+            assert!(request.cancellation_token().is_some());
+            self.cancellation_token.cancel();
+            Err(HTTPError::new_retryable_error(
+                HTTPErrorKind::IOError(io::Error::new(io::ErrorKind::Other, "Test Error")),
+                true,
+                None,
+                None,
+                None,
+            ))
+        }
+    }
+
+    #[test]
+    fn test_canceled_request() -> StdResult<(), Box<dyn StdError>> {
+        let cancellation_token = CancellationToken::new();
+        let mock = CounterCallMock::new(HTTPCanceler {
+            cancellation_token: cancellation_token.to_owned(),
+        });
+        let config: Config = ConfigBuilder::default()
+            .http_request_retries(RETRIES)
+            .http_request_retry_delay(Duration::from_millis(1))
+            .http_request_handler(mock.clone())
+            .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+            .build();
+        let err = Builder::new(
+            config.clone(),
+            Method::GET,
+            "/test_call",
+            &["http://z1h1.com:1111", "http://z1h2.com:2222"],
+        )
+        .token(TokenVersion::V2, get_credential().into())
+        .cancellation_token(Some(&cancellation_token))
+        .no_body()
+        .send()
+        .unwrap_err();
+        assert!(match err.error_kind() {
+            HTTPErrorKind::UserCanceled => true,
+            _ => false,
+        });
+        assert_eq!(mock.call_called(), 1);
+        Ok(())
+    }
+
+    #[derive(Debug, Clone)]
+    struct HTTPStaller;
+
+    impl HTTPCaller for HTTPStaller {
+        fn call(&self, request: &HTTPRequest) -> HTTPResult<HTTPResponse> {
+            if request.url().starts_with("http://z1h2.com") {
+                return Ok(ResponseBuilder::default().status_code(200).build());
+            }
+            let cancellation_token = request.cancellation_token().unwrap();
+            let timer = Instant::now();
+            while !cancellation_token.is_canceled() {
+                assert!(timer.elapsed() < Duration::from_secs(5));
+                sleep(Duration::from_millis(10));
+            }
+            Err(HTTPError::new_unretryable_error(
+                HTTPErrorKind::UserCanceled,
+                None,
+                None,
+                None,
+            ))
+        }
+    }
+
+    #[test]
+    fn test_hedged_request() -> StdResult<(), Box<dyn StdError>> {
+        let mock = CounterCallMock::new(HTTPStaller);
+        let config: Config = ConfigBuilder::default()
+            .http_request_retries(RETRIES)
+            .http_request_retry_delay(Duration::from_millis(1))
+            .http_request_hedge_delay(Duration::from_millis(100))
+            .http_request_handler(mock.clone())
+            .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+            .build();
+        let response = Builder::new(
+            config,
+            Method::GET,
+            "/test_call",
+            &["http://z1h1.com:1111", "http://z1h2.com:2222"],
+        )
+        .token(TokenVersion::V2, get_credential().into())
+        .send()?;
+        assert_eq!(response.base_url(), "http://z1h2.com:2222");
+        assert_eq!(response.hedges(), 1);
+        assert_eq!(mock.call_called(), 2);
+        Ok(())
+    }
+
+    #[test]
+    fn test_hedged_idempotent_put_request() -> StdResult<(), Box<dyn StdError>> {
+        let mock = CounterCallMock::new(HTTPStaller);
+        let config: Config = ConfigBuilder::default()
+            .http_request_retries(RETRIES)
+            .http_request_retry_delay(Duration::from_millis(1))
+            .http_request_hedge_delay(Duration::from_millis(100))
+            .http_request_handler(mock.clone())
+            .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+            .build();
+        let on_uploading_progress_called = AtomicUsize::new(0);
+        let response = Builder::new(
+            config,
+            Method::PUT,
+            "/test_call",
+            &["http://z1h1.com:1111", "http://z1h2.com:2222"],
+        )
+        .idempotent()
+        .on_uploading_progress(&|uploaded, total| {
+            assert_eq!(uploaded, total);
+            on_uploading_progress_called.fetch_add(1, Relaxed);
+        })
+        .raw_body(mime::JSON_MIME, b"{\"test\":123}".as_ref())
+        .send()?;
+        assert_eq!(response.base_url(), "http://z1h2.com:2222");
+        assert_eq!(response.hedges(), 1);
+        assert_eq!(on_uploading_progress_called.load(Relaxed), 1);
+        assert_eq!(mock.call_called(), 2);
+        Ok(())
+    }
+
+    struct MemoryStream {
+        data: Vec<u8>,
+        position: Mutex<usize>,
+    }
+
+    impl RequestBodyStream for MemoryStream {
+        fn size(&self) -> u64 {
+            self.data.len() as u64
+        }
+
+        fn read(&self, buf: &mut [u8]) -> io::Result<usize> {
+            let mut position = self.position.lock().unwrap();
+            let have_read = buf.len().min(self.data.len() - *position);
+            buf[..have_read].copy_from_slice(&self.data[*position..*position + have_read]);
+            *position += have_read;
+            Ok(have_read)
+        }
+
+        fn seek(&self, offset: u64) -> io::Result<()> {
+            *self.position.lock().unwrap() = offset as usize;
+            Ok(())
+        }
+    }
+
+    #[test]
+    fn test_hedged_idempotent_stream_body_request() -> StdResult<(), Box<dyn StdError>> {
+        let mock = CounterCallMock::new(HTTPStaller);
+        let config: Config = ConfigBuilder::default()
+            .http_request_retries(RETRIES)
+            .http_request_retry_delay(Duration::from_millis(1))
+            .http_request_hedge_delay(Duration::from_millis(100))
+            .http_request_handler(mock.clone())
+            .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+            .build();
+        let stream = MemoryStream {
+            data: (0..1 << 16).map(|i| i as u8).collect(),
+            position: Mutex::new(7),
+        };
+        let response = Builder::new(
+            config,
+            Method::POST,
+            "/test_call",
+            &["http://z1h1.com:1111", "http://z1h2.com:2222"],
+        )
+        .idempotent()
+        .raw_body(mime::BINARY_MIME, &stream as &dyn RequestBodyStream)
+        .send()?;
+        assert_eq!(response.base_url(), "http://z1h2.com:2222");
+        assert_eq!(response.hedges(), 1);
+        assert_eq!(mock.call_called(), 2);
+        Ok(())
+    }
+
+    #[test]
+    fn test_unhedged_put_request() -> StdResult<(), Box<dyn StdError>> {
+        let mock = CounterCallMock::new(HTTPStaller);
+        let config: Config = ConfigBuilder::default()
+            .http_request_retries(RETRIES)
+            .http_request_retry_delay(Duration::from_millis(1))
+            .http_request_hedge_delay(Duration::from_millis(100))
+            .http_request_handler(mock.clone())
+            .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+            .build();
+        let cancellation_token = CancellationToken::default();
+        let result = crossbeam_utils::thread::scope(|s| {
+            let canceler = s.spawn(|_| {
+                sleep(Duration::from_millis(500));
+                cancellation_token.cancel();
+            });
+            let result = Builder::new(
+                config,
+                Method::PUT,
+                "/test_call",
+                &["http://z1h1.com:1111", "http://z1h2.com:2222"],
+            )
+            .cancellation_token(Some(&cancellation_token))
+            .raw_body(mime::JSON_MIME, b"{\"test\":123}".as_ref())
+            .send()
+            .map(|response| response.base_url().to_owned());
+            canceler.join().unwrap();
+            result
+        })
+        .unwrap();
+        assert!(result.is_err());
+        assert_eq!(mock.call_called(), 1);
+        Ok(())
+    }
+
     #[test]
     fn test_retryable_error_case_2() -> StdResult<(), Box<dyn StdError>> {
         let mock = CounterCallMock::new(HTTPRetryer {
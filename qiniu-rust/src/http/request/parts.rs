@@ -1,6 +1,6 @@
 use super::{
     super::{response::Response, token::Token},
-    HTTPError, HTTPResult, Headers, Method,
+    CancellationToken, HTTPError, HTTPResult, Headers, Method, RequestBody,
 };
 use crate::config::Config;
 use std::{borrow::Cow, collections::HashMap, fmt, time::Duration};
@@ -11,7 +11,7 @@ pub(crate) struct Parts<'a> {
     pub(super) path: &'a str,
     pub(super) query: HashMap<Cow<'a, str>, Cow<'a, str>>,
     pub(super) headers: Headers<'a>,
-    pub(super) body: Vec<u8>,
+    pub(super) body: RequestBody<'a>,
     pub(super) config: Config,
     pub(super) token: Option<Token<'a>>,
     pub(super) read_body: bool,
@@ -19,6 +19,7 @@ pub(crate) struct Parts<'a> {
     pub(super) follow_redirection: bool,
     pub(super) on_uploading_progress: Option<&'a dyn Fn(u64, u64)>,
     pub(super) on_downloading_progress: Option<&'a dyn Fn(u64, u64)>,
+    pub(super) cancellation_token: Option<&'a CancellationToken>,
     pub(super) on_response: Option<&'a dyn Fn(&mut Response, Duration) -> HTTPResult<()>>,
     pub(super) on_error: Option<&'a dyn Fn(Option<&str>, &HTTPError, Duration)>,
 }
@@ -53,6 +54,7 @@ impl fmt::Debug for Parts<'_> {
                     &"Not Installed"
                 },
             )
+            .field("cancellation_token", &self.cancellation_token)
             .field(
                 "on_response",
                 if self.on_response.is_some() {
@@ -0,0 +1,47 @@
+//! 域名解析器 模块
+//!
+//! 定义域名管理器所用的域名解析器接口，并提供基于操作系统域名解析的默认实现。
+//! 可以通过实现该接口接入自定义的域名解析或服务发现机制。
+
+use std::{
+    io::Result as IOResult,
+    net::{SocketAddr, ToSocketAddrs},
+};
+
+/// 域名解析器
+///
+/// 域名管理器总是在专用的后台线程中调用域名解析器，因此其实现可以是阻塞的。
+/// 超时控制，相同域名并发解析的合并，以及解析结果和失败结果的缓存均由域名管理器负责
+pub trait Resolver: Send + Sync {
+    /// 解析域名
+    ///
+    /// `host` 为域名或 IP 地址（IPv6 地址不含方括号），`port` 为端口号，返回解析得到的所有 IP 地址及端口
+    fn resolve(&self, host: &str, port: u16) -> IOResult<Box<[SocketAddr]>>;
+}
+
+/// 系统域名解析器
+///
+/// 调用操作系统提供的域名解析功能，是域名管理器默认使用的域名解析器
+#[derive(Debug, Default, Clone, Copy)]
+pub struct SystemResolver;
+
+impl Resolver for SystemResolver {
+    fn resolve(&self, host: &str, port: u16) -> IOResult<Box<[SocketAddr]>> {
+        Ok((host, port).to_socket_addrs()?.collect())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::{error::Error, result::Result};
+
+    #[test]
+    fn test_system_resolver() -> Result<(), Box<dyn Error>> {
+        let socket_addrs = SystemResolver.resolve("127.0.0.1", 8080)?;
+        assert_eq!(socket_addrs.as_ref(), &["127.0.0.1:8080".parse::<SocketAddr>()?]);
+        let socket_addrs = SystemResolver.resolve("::1", 8080)?;
+        assert_eq!(socket_addrs.as_ref(), &["[::1]:8080".parse::<SocketAddr>()?]);
+        Ok(())
+    }
+}
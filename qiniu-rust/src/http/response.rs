@@ -25,6 +25,8 @@ pub(crate) struct Response<'a> {
     pub(super) base_url: &'a str,
     #[get_copy = "pub(crate)"]
     pub(super) path: &'a str,
+    #[get_copy = "pub(crate)"]
+    pub(super) hedges: usize,
 }
 
 impl<'a> Response<'a> {
@@ -128,6 +130,7 @@ impl fmt::Debug for Response<'_> {
             .field("method", &self.method)
             .field("base_url", &self.base_url)
             .field("path", &self.path)
+            .field("hedges", &self.hedges)
             .finish()
     }
 }
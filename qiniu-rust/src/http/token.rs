@@ -1,6 +1,7 @@
 use super::super::credential::Credential;
-use qiniu_http::Request;
-use std::borrow::Cow;
+use matches::matches;
+use qiniu_http::{Request, RequestBody};
+use std::{borrow::Cow, io::Result as IOResult};
 
 #[derive(Debug, Clone, Eq, PartialEq)]
 pub(crate) struct Token<'t> {
@@ -20,7 +21,21 @@ impl<'t> Token<'t> {
         Self { version, credential }
     }
 
-    pub(crate) fn sign(&self, req: &mut Request) {
+    /// 复制出不再借用认证信息的令牌，以便传递给其他线程
+    pub(crate) fn to_static(&self) -> Token<'static> {
+        Token {
+            version: self.version,
+            credential: Cow::Owned(self.credential.as_ref().to_owned()),
+        }
+    }
+
+    /// 对 HTTP 请求签名
+    ///
+    /// 如果签名需要包含数据流请求体，则将其读入内存，读取失败时返回错误，而不会以空请求体签名
+    pub(crate) fn sign(&self, req: &mut Request) -> IOResult<()> {
+        if matches!(req.body(), RequestBody::Stream(_)) && self.will_sign_body(req) {
+            req.body_mut().buffer()?;
+        }
         let url = req.url();
         let method = req.method();
 
@@ -29,19 +44,30 @@ impl<'t> Token<'t> {
                 if let Ok(authorization) = self.credential.authorization_v1_for_request(
                     &url,
                     req.headers().get(&"Content-Type".into()).unwrap_or(&"".into()),
-                    req.body().as_ref(),
+                    req.body().as_bytes().unwrap_or_default(),
                 ) {
                     req.headers_mut().insert("Authorization".into(), authorization.into());
                 }
             }
             Version::V2 => {
-                if let Ok(authorization) =
-                    self.credential
-                        .authorization_v2_for_request(method, &url, req.headers(), req.body().as_ref())
-                {
+                if let Ok(authorization) = self.credential.authorization_v2_for_request(
+                    method,
+                    &url,
+                    req.headers(),
+                    req.body().as_bytes().unwrap_or_default(),
+                ) {
                     req.headers_mut().insert("Authorization".into(), authorization.into());
                 }
             }
         }
+        Ok(())
+    }
+
+    fn will_sign_body(&self, req: &Request) -> bool {
+        match (self.version, req.headers().get(&"Content-Type".into())) {
+            (Version::V1, Some(content_type)) => Credential::will_push_body_v1(content_type.as_ref()),
+            (Version::V2, Some(content_type)) => Credential::will_push_body_v2(content_type.as_ref()),
+            (_, None) => false,
+        }
     }
 }
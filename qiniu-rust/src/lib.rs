@@ -620,3 +620,7 @@ pub use config::{Config, ConfigBuilder};
 pub mod http;
 pub mod storage;
 pub mod utils;
+
+#[cfg(feature = "benchmark")]
+#[doc(hidden)]
+pub mod benchmark;
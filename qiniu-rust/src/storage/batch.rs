@@ -0,0 +1,871 @@
+//! 批量操作模块
+//!
+//! 将大量对象操作按照 `batch_max_operation_size` 切分为多个批次，并行发送至 RS 服务器，并以流式的方式逐一返回每个操作的结果
+
+use crate::{
+    credential::Credential,
+    http::{Client, Error as HTTPError, Result as HTTPResult, RetryKind, TokenVersion},
+    utils::{base64, thread_pool::batch_operations_thread_pool},
+};
+use assert_impl::assert_impl;
+use matches::matches;
+use rayon::{ThreadPool, ThreadPoolBuilder};
+use serde::Deserialize;
+use serde_json::Value;
+use std::{
+    borrow::Borrow,
+    collections::VecDeque,
+    fmt,
+    iter::Iterator,
+    mem::take,
+    result::Result,
+    sync::{
+        atomic::{AtomicBool, AtomicUsize, Ordering},
+        mpsc::{sync_channel, Receiver, SyncSender},
+        Arc,
+    },
+    thread,
+    time::Duration,
+};
+use thiserror::Error;
+
+pub(crate) const DEFAULT_CONCURRENCY: usize = 4;
+const DEFAULT_MAX_RETRIES: usize = 3;
+const RETRY_INTERVAL: Duration = Duration::from_millis(100);
+
+/// 对象操作
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub enum BatchOperation {
+    /// 获取对象元信息
+    Stat {
+        /// 对象名称
+        key: String,
+    },
+    /// 删除对象
+    Delete {
+        /// 对象名称
+        key: String,
+    },
+    /// 复制对象
+    Copy {
+        /// 源对象名称
+        key: String,
+        /// 目标存储空间名称
+        to_bucket: String,
+        /// 目标对象名称
+        to_key: String,
+        /// 是否覆盖已经存在的目标对象
+        force: bool,
+    },
+    /// 移动对象
+    Move {
+        /// 源对象名称
+        key: String,
+        /// 目标存储空间名称
+        to_bucket: String,
+        /// 目标对象名称
+        to_key: String,
+        /// 是否覆盖已经存在的目标对象
+        force: bool,
+    },
+}
+
+impl BatchOperation {
+    fn to_op(&self, bucket: &str) -> String {
+        match self {
+            Self::Stat { key } => "/stat/".to_owned() + &encode_entry(bucket, key),
+            Self::Delete { key } => "/delete/".to_owned() + &encode_entry(bucket, key),
+            Self::Copy {
+                key,
+                to_bucket,
+                to_key,
+                force,
+            } => format!(
+                "/copy/{}/{}/force/{}",
+                encode_entry(bucket, key),
+                encode_entry(to_bucket, to_key),
+                force
+            ),
+            Self::Move {
+                key,
+                to_bucket,
+                to_key,
+                force,
+            } => format!(
+                "/move/{}/{}/force/{}",
+                encode_entry(bucket, key),
+                encode_entry(to_bucket, to_key),
+                force
+            ),
+        }
+    }
+
+    fn is_read_only(&self) -> bool {
+        matches!(self, Self::Stat { .. })
+    }
+}
+
+fn encode_entry(bucket: &str, key: &str) -> String {
+    base64::urlsafe((bucket.to_owned() + ":" + key).as_bytes())
+}
+
+/// 对象元信息
+#[derive(Debug, Clone, Deserialize)]
+pub struct ObjectStat {
+    #[serde(rename = "fsize")]
+    size: u64,
+    hash: String,
+    #[serde(rename = "mimeType")]
+    mime_type: String,
+    #[serde(rename = "putTime")]
+    put_time: u64,
+    #[serde(rename = "type", default)]
+    file_type: u8,
+}
+
+impl ObjectStat {
+    /// 对象尺寸，单位为字节
+    pub fn size(&self) -> u64 {
+        self.size
+    }
+
+    /// 对象 Etag
+    pub fn hash(&self) -> &str {
+        self.hash.as_ref()
+    }
+
+    /// 对象 MIME 类型
+    pub fn mime_type(&self) -> &str {
+        self.mime_type.as_ref()
+    }
+
+    /// 对象上传时间，单位为 100 纳秒
+    pub fn put_time(&self) -> u64 {
+        self.put_time
+    }
+
+    /// 对象存储类型，`0` 表示标准存储，`1` 表示低频存储，`2` 表示归档存储
+    pub fn file_type(&self) -> u8 {
+        self.file_type
+    }
+}
+
+/// 批量操作错误
+#[derive(Error, Debug, Clone)]
+pub enum BatchOperationError {
+    /// 批量操作请求发送失败，同一批次的所有操作共享该错误
+    #[error("Qiniu API call error: {0}")]
+    HTTPError(Arc<HTTPError>),
+    /// 操作被七牛服务器拒绝
+    #[error("Operation failed: status_code = {0}, error_message = {1}")]
+    ResponseStatusCodeError(u16, Box<str>),
+}
+
+/// 单个对象操作的结果
+#[derive(Debug)]
+pub struct BatchOperationResult {
+    index: usize,
+    result: Result<Option<ObjectStat>, BatchOperationError>,
+}
+
+impl BatchOperationResult {
+    /// 该操作在批量操作中的序号，从 0 开始，与操作的添加顺序一致
+    pub fn index(&self) -> usize {
+        self.index
+    }
+
+    /// 操作结果，对于获取对象元信息的操作，成功时将返回对象元信息
+    pub fn result(&self) -> &Result<Option<ObjectStat>, BatchOperationError> {
+        &self.result
+    }
+
+    /// 获取操作结果的所有权
+    pub fn into_result(self) -> Result<Option<ObjectStat>, BatchOperationError> {
+        self.result
+    }
+}
+
+/// 批量操作生成器
+///
+/// 通过调用 `Bucket::batch()` 方法创建，添加任意数量的对象操作后调用 `execute()` 方法执行。
+/// 所有操作将按照 `batch_max_operation_size` 切分为多个批次，由多个线程并行发送至 RS 服务器。
+/// 对于失败的批次或其中失败的操作，仅重试可重试的操作，而已经成功的操作不会被再次发送
+///
+/// ```rust,no_run
+/// use qiniu_ng::{Client, Config};
+/// # use std::{result::Result, error::Error};
+///
+/// # fn main() -> Result<(), Box<dyn Error>> {
+/// let client = Client::new("[Access Key]", "[Secret Key]", Config::default());
+/// let bucket = client.storage().bucket("[Bucket name]").build();
+/// let mut batch = bucket.batch();
+/// for i in 0..10000 {
+///     batch.delete(format!("key-{}", i));
+/// }
+/// for result in batch.execute() {
+///     if let Err(err) = result.result() {
+///         println!("Failed to delete key-{}: {}", result.index(), err);
+///     }
+/// }
+/// # Ok(())
+/// # }
+/// ```
+#[derive(Clone)]
+pub struct BatchOperations {
+    bucket_name: Box<str>,
+    credential: Credential,
+    http_client: Client,
+    rs_urls: Box<[Box<str>]>,
+    operations: Vec<BatchOperation>,
+    batch_size: usize,
+    concurrency: usize,
+    max_retries: usize,
+    thread_pool_size: usize,
+    thread_pool: Option<Arc<ThreadPool>>,
+}
+
+impl BatchOperations {
+    pub(super) fn new(
+        bucket_name: Box<str>,
+        credential: Credential,
+        http_client: Client,
+        rs_urls: Box<[Box<str>]>,
+    ) -> Self {
+        BatchOperations {
+            batch_size: http_client.config().batch_max_operation_size(),
+            bucket_name,
+            credential,
+            http_client,
+            rs_urls,
+            operations: Vec::new(),
+            concurrency: DEFAULT_CONCURRENCY,
+            max_retries: DEFAULT_MAX_RETRIES,
+            thread_pool_size: 0,
+            thread_pool: None,
+        }
+    }
+
+    /// 添加对象操作
+    pub fn push(&mut self, operation: BatchOperation) -> &mut Self {
+        self.operations.push(operation);
+        self
+    }
+
+    /// 添加获取对象元信息操作
+    pub fn stat(&mut self, key: impl Into<String>) -> &mut Self {
+        self.push(BatchOperation::Stat { key: key.into() })
+    }
+
+    /// 添加删除对象操作
+    pub fn delete(&mut self, key: impl Into<String>) -> &mut Self {
+        self.push(BatchOperation::Delete { key: key.into() })
+    }
+
+    /// 添加复制对象操作
+    pub fn copy(
+        &mut self,
+        key: impl Into<String>,
+        to_bucket: impl Into<String>,
+        to_key: impl Into<String>,
+        force: bool,
+    ) -> &mut Self {
+        self.push(BatchOperation::Copy {
+            key: key.into(),
+            to_bucket: to_bucket.into(),
+            to_key: to_key.into(),
+            force,
+        })
+    }
+
+    /// 添加移动对象操作
+    pub fn move_to(
+        &mut self,
+        key: impl Into<String>,
+        to_bucket: impl Into<String>,
+        to_key: impl Into<String>,
+        force: bool,
+    ) -> &mut Self {
+        self.push(BatchOperation::Move {
+            key: key.into(),
+            to_bucket: to_bucket.into(),
+            to_key: to_key.into(),
+            force,
+        })
+    }
+
+    /// 每个批次的最大操作数
+    ///
+    /// 默认为客户端配置中的 `batch_max_operation_size`，且总是不会超过该值
+    pub fn batch_size(&mut self, batch_size: usize) -> &mut Self {
+        self.batch_size = batch_size
+            .max(1)
+            .min(self.http_client.config().batch_max_operation_size());
+        self
+    }
+
+    /// 同时发送的最大批次数
+    ///
+    /// 实际并发数不会超过执行批量操作的线程池的线程数量。默认为 4
+    pub fn concurrency(&mut self, concurrency: usize) -> &mut Self {
+        self.concurrency = concurrency.max(1);
+        self
+    }
+
+    /// 失败操作的最大重试次数
+    ///
+    /// 仅当批量操作请求可以安全重试，或是操作被服务器以 5xx 状态码拒绝时才会重试。默认为 3
+    pub fn max_retries(&mut self, max_retries: usize) -> &mut Self {
+        self.max_retries = max_retries;
+        self
+    }
+
+    /// 为批量操作创建专用线程池指定线程池大小
+    ///
+    /// 默认情况下，所有批量操作共用进程内共享的批量操作线程池，不会在每次执行时创建新的线程。
+    /// 指定线程池大小后，将在第一次执行时创建专用线程池，之后每次执行，以及从当前生成器复制得到的生成器都将复用该线程池。
+    /// 传入 0 表示使用共享的批量操作线程池
+    pub fn thread_pool_size(&mut self, num_threads: usize) -> &mut Self {
+        if self.thread_pool_size != num_threads {
+            self.thread_pool_size = num_threads;
+            self.thread_pool = None;
+        }
+        self
+    }
+
+    pub(crate) fn bucket_name(&self) -> &str {
+        &self.bucket_name
+    }
+
+    pub(crate) fn operations_per_batch(&self) -> usize {
+        self.batch_size
+    }
+
+    /// 复制当前生成器的参数，但不复制已经添加的操作
+    pub(crate) fn to_empty(&self) -> Self {
+        BatchOperations {
+            bucket_name: self.bucket_name.to_owned(),
+            credential: self.credential.to_owned(),
+            http_client: self.http_client.to_owned(),
+            rs_urls: self.rs_urls.to_owned(),
+            operations: Vec::new(),
+            batch_size: self.batch_size,
+            concurrency: self.concurrency,
+            max_retries: self.max_retries,
+            thread_pool_size: self.thread_pool_size,
+            thread_pool: self.thread_pool.to_owned(),
+        }
+    }
+
+    /// 复制当前生成器的参数用于另一个存储空间，但不复制已经添加的操作
+    ///
+    /// 由于无法得知该存储空间所在的区域，将仅使用客户端配置中的 RS 服务器
+    pub(crate) fn to_empty_for_bucket(&self, bucket_name: &str) -> Self {
+        let mut batch_operations = self.to_empty();
+        batch_operations.bucket_name = bucket_name.into();
+        batch_operations.rs_urls = vec![self.http_client.config().rs_url().into()].into();
+        batch_operations
+    }
+
+    /// 已经添加的操作数
+    pub fn len(&self) -> usize {
+        self.operations.len()
+    }
+
+    /// 是否尚未添加任何操作
+    pub fn is_empty(&self) -> bool {
+        self.operations.is_empty()
+    }
+
+    /// 执行所有已经添加的操作
+    ///
+    /// 返回的迭代器将按照操作完成的顺序（而非添加的顺序）逐一返回每个操作的结果，可以通过 `BatchOperationResult::index()` 确定对应的操作。
+    /// 调用后当前生成器中的操作将被清空，可以继续添加新的操作再次执行。
+    /// 如果在所有结果返回前丢弃迭代器，尚未发送的批次将被放弃。
+    ///
+    /// 批次将在线程池中发送，因此不要在执行批量操作的线程池的线程中迭代返回的结果，否则可能会导致死锁
+    pub fn execute(&mut self) -> BatchOperationResults {
+        let batch_size = self.batch_size.max(1);
+        let operations: Arc<[BatchOperation]> = take(&mut self.operations).into();
+        let batches_count = (operations.len() + batch_size - 1) / batch_size;
+        let workers = self.concurrency.min(batches_count);
+        let context = Arc::new(BatchContext {
+            bucket_name: self.bucket_name.to_owned(),
+            credential: self.credential.to_owned(),
+            http_client: self.http_client.to_owned(),
+            rs_urls: self.rs_urls.to_owned(),
+            operations,
+            batch_size,
+            max_retries: self.max_retries,
+            next_batch: AtomicUsize::new(0),
+            abandoned: AtomicBool::new(false),
+        });
+        let (sender, receiver) = sync_channel(workers.max(1) * 2);
+        let thread_pool = self.thread_pool();
+        for _ in 0..workers {
+            let (context, sender) = (context.to_owned(), sender.to_owned());
+            thread_pool.spawn(move || context.work(&sender));
+        }
+        BatchOperationResults {
+            receiver: Some(receiver),
+            context,
+            pending: VecDeque::new(),
+        }
+    }
+
+    /// 获取执行批量操作的线程池
+    ///
+    /// 没有指定线程池大小时使用共享的批量操作线程池，否则创建专用线程池并缓存在生成器中
+    fn thread_pool(&mut self) -> Arc<ThreadPool> {
+        if self.thread_pool_size == 0 {
+            return batch_operations_thread_pool();
+        }
+        let thread_pool_size = self.thread_pool_size;
+        self.thread_pool
+            .get_or_insert_with(|| {
+                Arc::new(
+                    ThreadPoolBuilder::new()
+                        .num_threads(thread_pool_size)
+                        .thread_name(|index| format!("qiniu_ng_batch_operations_worker_{}", index))
+                        .build()
+                        .unwrap(),
+                )
+            })
+            .to_owned()
+    }
+}
+
+impl fmt::Debug for BatchOperations {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_struct("BatchOperations")
+            .field("bucket_name", &self.bucket_name)
+            .field("rs_urls", &self.rs_urls)
+            .field("operations", &self.operations.len())
+            .field("batch_size", &self.batch_size)
+            .field("concurrency", &self.concurrency)
+            .field("max_retries", &self.max_retries)
+            .field("thread_pool_size", &self.thread_pool_size)
+            .finish()
+    }
+}
+
+#[derive(Deserialize)]
+struct BatchOperationResponse {
+    code: u16,
+    #[serde(default)]
+    data: Option<Value>,
+}
+
+/// 工作线程发送给迭代器的一个批次的最终结果
+enum BatchOutcome {
+    Responses(Vec<(usize, BatchOperationResponse)>),
+    Failed(Vec<usize>, HTTPError),
+}
+
+struct BatchContext {
+    bucket_name: Box<str>,
+    credential: Credential,
+    http_client: Client,
+    rs_urls: Box<[Box<str>]>,
+    operations: Arc<[BatchOperation]>,
+    batch_size: usize,
+    max_retries: usize,
+    next_batch: AtomicUsize,
+    abandoned: AtomicBool,
+}
+
+impl BatchContext {
+    fn work(&self, sender: &SyncSender<BatchOutcome>) {
+        loop {
+            // 迭代器被丢弃后，仍在线程池中排队的任务直接退出
+            if self.abandoned.load(Ordering::Relaxed) {
+                return;
+            }
+            let start = self.next_batch.fetch_add(1, Ordering::Relaxed) * self.batch_size;
+            if start >= self.operations.len() {
+                return;
+            }
+            let end = (start + self.batch_size).min(self.operations.len());
+            if !self.handle_batch((start..end).collect(), sender) {
+                return;
+            }
+        }
+    }
+
+    /// 发送一个批次，仅重试其中可重试的操作，如果迭代器已经被丢弃则返回 `false`
+    fn handle_batch(&self, mut indices: Vec<usize>, sender: &SyncSender<BatchOutcome>) -> bool {
+        let mut retried = 0;
+        loop {
+            let can_retry = retried < self.max_retries;
+            let outcome = match self.send_batch(&indices) {
+                Ok(responses) => {
+                    let mut responses = responses.into_iter();
+                    let mut completed = Vec::with_capacity(indices.len());
+                    let mut failed = Vec::new();
+                    for index in take(&mut indices) {
+                        match responses.next() {
+                            Some(response) if !can_retry || !is_retryable_code(response.code) => {
+                                completed.push((index, response))
+                            }
+                            Some(_) => failed.push(index),
+                            None if can_retry => failed.push(index),
+                            None => completed.push((
+                                index,
+                                BatchOperationResponse {
+                                    code: 599,
+                                    data: Some(serde_json::json!({"error": "missing operation response"})),
+                                },
+                            )),
+                        }
+                    }
+                    indices = failed;
+                    BatchOutcome::Responses(completed)
+                }
+                Err(err) => {
+                    if can_retry && self.is_batch_retryable(&indices, &err) {
+                        BatchOutcome::Responses(Vec::new())
+                    } else {
+                        BatchOutcome::Failed(take(&mut indices), err)
+                    }
+                }
+            };
+            if !matches!(&outcome, BatchOutcome::Responses(completed) if completed.is_empty())
+                && sender.send(outcome).is_err()
+            {
+                return false;
+            }
+            if indices.is_empty() {
+                return true;
+            }
+            retried += 1;
+            thread::sleep(RETRY_INTERVAL * retried as u32);
+        }
+    }
+
+    fn send_batch(&self, indices: &[usize]) -> HTTPResult<Vec<BatchOperationResponse>> {
+        let body = serde_urlencoded::to_string(
+            indices
+                .iter()
+                .map(|&index| ("op", self.operations[index].to_op(&self.bucket_name)))
+                .collect::<Vec<_>>(),
+        )
+        .unwrap();
+        let rs_urls = self.rs_urls.iter().map(|url| url.as_ref()).collect::<Box<[&str]>>();
+        self.http_client
+            .post("/batch", &rs_urls)
+            .token(TokenVersion::V2, self.credential.borrow().into())
+            .accept_json()
+            .raw_body(mime::FORM_MIME, body.into_bytes())
+            .send()?
+            .parse_json()
+    }
+
+    /// 整个批次发送失败时，仅当请求可以安全重试时才重试，避免重复执行已经生效的修改操作
+    fn is_batch_retryable(&self, indices: &[usize], err: &HTTPError) -> bool {
+        match err.retry_kind() {
+            RetryKind::UnretryableError => false,
+            _ => err.is_retry_safe() || indices.iter().all(|&index| self.operations[index].is_read_only()),
+        }
+    }
+}
+
+/// 七牛服务器以 5xx 状态码拒绝的操作可以重试，但 `501`（不支持的操作）和 `579`（回调失败）除外
+fn is_retryable_code(code: u16) -> bool {
+    (500..600).contains(&code) && code != 501 && code != 579
+}
+
+/// 批量操作结果迭代器
+///
+/// 在迭代期间，线程池将继续发送后续批次，已经完成的结果将被缓存直到被迭代器取出
+pub struct BatchOperationResults {
+    receiver: Option<Receiver<BatchOutcome>>,
+    context: Arc<BatchContext>,
+    pending: VecDeque<BatchOperationResult>,
+}
+
+impl BatchOperationResults {
+    fn expand(&mut self, outcome: BatchOutcome) {
+        match outcome {
+            BatchOutcome::Responses(responses) => {
+                self.pending
+                    .extend(responses.into_iter().map(|(index, response)| BatchOperationResult {
+                        index,
+                        result: parse_response(response),
+                    }))
+            }
+            BatchOutcome::Failed(indices, err) => {
+                let err = Arc::new(err);
+                self.pending
+                    .extend(indices.into_iter().map(|index| BatchOperationResult {
+                        index,
+                        result: Err(BatchOperationError::HTTPError(err.to_owned())),
+                    }))
+            }
+        }
+    }
+
+    #[allow(dead_code)]
+    fn ignore() {
+        assert_impl!(Send: Self);
+        assert_impl!(Send: BatchOperationError);
+        assert_impl!(Sync: BatchOperationError);
+    }
+}
+
+fn parse_response(response: BatchOperationResponse) -> Result<Option<ObjectStat>, BatchOperationError> {
+    if (200..300).contains(&response.code) {
+        Ok(response
+            .data
+            .and_then(|data| serde_json::from_value::<ObjectStat>(data).ok()))
+    } else {
+        let message = response
+            .data
+            .as_ref()
+            .and_then(|data| data.get("error"))
+            .and_then(|error| error.as_str())
+            .unwrap_or_default();
+        Err(BatchOperationError::ResponseStatusCodeError(
+            response.code,
+            message.into(),
+        ))
+    }
+}
+
+impl Iterator for BatchOperationResults {
+    type Item = BatchOperationResult;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        loop {
+            if let Some(result) = self.pending.pop_front() {
+                return Some(result);
+            }
+            let outcome = self.receiver.as_ref().and_then(|receiver| receiver.recv().ok());
+            match outcome {
+                Some(outcome) => self.expand(outcome),
+                None => {
+                    self.receiver = None;
+                    return None;
+                }
+            }
+        }
+    }
+}
+
+/// 丢弃迭代器时不等待线程池中的任务结束，正在发送的批次完成后即会放弃后续批次
+impl Drop for BatchOperationResults {
+    fn drop(&mut self) {
+        self.context.abandoned.store(true, Ordering::Relaxed);
+        self.receiver = None;
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{
+        config::ConfigBuilder,
+        http::{DomainsManagerBuilder, Headers, Method},
+    };
+    use qiniu_http::ResponseBuilder;
+    use qiniu_test_utils::http_call_mock::{fake_req_id, CallHandlers};
+    use std::{
+        collections::{HashMap, HashSet},
+        error::Error,
+        sync::Mutex,
+    };
+
+    #[test]
+    fn test_batch_operations_chunks_and_retries() -> Result<(), Box<dyn Error>> {
+        let attempts = Arc::new(Mutex::new(HashMap::<String, usize>::new()));
+        let batch_sizes = Arc::new(Mutex::new(Vec::new()));
+        let config = ConfigBuilder::default()
+            .batch_max_operation_size(3)
+            .upload_logger(None)
+            .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+            .http_request_handler(
+                CallHandlers::new(|request| {
+                    panic!("Unexpected Request: {} {}", request.method(), request.url());
+                })
+                .install(Method::POST, "^http://rs.example.com/batch$", {
+                    let (attempts, batch_sizes) = (attempts.to_owned(), batch_sizes.to_owned());
+                    move |request, _| {
+                        let ops =
+                            serde_urlencoded::from_bytes::<Vec<(String, String)>>(request.body().as_bytes().unwrap())
+                                .unwrap();
+                        batch_sizes.lock().unwrap().push(ops.len());
+                        let responses = ops
+                            .into_iter()
+                            .map(|(_, op)| {
+                                let mut attempts = attempts.lock().unwrap();
+                                let attempt = attempts.entry(op.to_owned()).or_default();
+                                *attempt += 1;
+                                if op == "/delete/".to_owned() + &encode_entry("test-bucket", "key-4") && *attempt == 1
+                                {
+                                    serde_json::json!({"code": 599, "data": {"error": "server error"}})
+                                } else if op == "/delete/".to_owned() + &encode_entry("test-bucket", "key-5") {
+                                    serde_json::json!({"code": 612, "data": {"error": "no such file or directory"}})
+                                } else if op.starts_with("/stat/") {
+                                    serde_json::json!({"code": 200, "data": {
+                                        "fsize": 1024, "hash": "FhqTnPSdbCT5Lw2QtS8KK7-bm00n",
+                                        "mimeType": "text/plain", "putTime": 15000000000000000u64, "type": 1
+                                    }})
+                                } else {
+                                    serde_json::json!({"code": 200})
+                                }
+                            })
+                            .collect::<Vec<_>>();
+                        let mut headers = Headers::new();
+                        headers.insert("Content-Type".into(), mime::JSON_MIME.into());
+                        headers.insert("X-Reqid".into(), fake_req_id().into());
+                        Ok(ResponseBuilder::default()
+                            .status_code(298u16)
+                            .headers(headers)
+                            .bytes_as_body(serde_json::to_string(&responses).unwrap())
+                            .build())
+                    }
+                }),
+            )
+            .build();
+        let mut batch = BatchOperations::new(
+            "test-bucket".into(),
+            Credential::new("abcdefghklmnopq", "1234567890"),
+            Client::new(config),
+            vec!["http://rs.example.com".into()].into(),
+        );
+        batch.concurrency(2).max_retries(1).stat("key-0");
+        for i in 1..8 {
+            batch.delete(format!("key-{}", i));
+        }
+        assert_eq!(batch.len(), 8);
+
+        let results = batch.execute().collect::<Vec<_>>();
+        assert!(batch.is_empty());
+        assert_eq!(results.len(), 8);
+        assert_eq!(
+            results.iter().map(|result| result.index()).collect::<HashSet<_>>(),
+            (0..8).collect::<HashSet<_>>()
+        );
+        for result in results.iter() {
+            match result.index() {
+                0 => {
+                    let stat = result.result().as_ref().unwrap().as_ref().unwrap();
+                    assert_eq!(stat.size(), 1024);
+                    assert_eq!(stat.hash(), "FhqTnPSdbCT5Lw2QtS8KK7-bm00n");
+                    assert_eq!(stat.mime_type(), "text/plain");
+                    assert_eq!(stat.file_type(), 1);
+                }
+                5 => match result.result() {
+                    Err(BatchOperationError::ResponseStatusCodeError(612, message)) => {
+                        assert_eq!(message.as_ref(), "no such file or directory")
+                    }
+                    _ => panic!("Unexpected result: {:?}", result),
+                },
+                _ => assert!(result.result().as_ref().unwrap().is_none()),
+            }
+        }
+
+        let mut batch_sizes = batch_sizes.lock().unwrap().to_owned();
+        batch_sizes.sort();
+        assert_eq!(batch_sizes, vec![1, 2, 3, 3]);
+        assert_eq!(
+            attempts
+                .lock()
+                .unwrap()
+                .get(&("/delete/".to_owned() + &encode_entry("test-bucket", "key-4"))),
+            Some(&2)
+        );
+        assert_eq!(
+            attempts
+                .lock()
+                .unwrap()
+                .get(&("/delete/".to_owned() + &encode_entry("test-bucket", "key-5"))),
+            Some(&1)
+        );
+        Ok(())
+    }
+
+    #[test]
+    fn test_batch_operations_reuse_thread_pool() -> Result<(), Box<dyn Error>> {
+        let thread_names = Arc::new(Mutex::new(HashSet::new()));
+        let config = ConfigBuilder::default()
+            .batch_max_operation_size(1)
+            .upload_logger(None)
+            .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+            .http_request_handler(
+                CallHandlers::new(|request| {
+                    panic!("Unexpected Request: {} {}", request.method(), request.url());
+                })
+                .install(Method::POST, "^http://rs.example.com/batch$", {
+                    let thread_names = thread_names.to_owned();
+                    move |_, _| {
+                        thread_names
+                            .lock()
+                            .unwrap()
+                            .insert(thread::current().name().unwrap_or_default().to_owned());
+                        let mut headers = Headers::new();
+                        headers.insert("Content-Type".into(), mime::JSON_MIME.into());
+                        headers.insert("X-Reqid".into(), fake_req_id().into());
+                        Ok(ResponseBuilder::default()
+                            .status_code(200u16)
+                            .headers(headers)
+                            .bytes_as_body(r#"[{"code":200}]"#)
+                            .build())
+                    }
+                }),
+            )
+            .build();
+        let mut batch = BatchOperations::new(
+            "test-bucket".into(),
+            Credential::new("abcdefghklmnopq", "1234567890"),
+            Client::new(config),
+            vec!["http://rs.example.com".into()].into(),
+        );
+        batch.thread_pool_size(2).concurrency(4);
+        for i in 0..8 {
+            batch.delete(format!("key-{}", i));
+        }
+        assert_eq!(batch.execute().count(), 8);
+        let thread_pool = batch.thread_pool.to_owned().unwrap();
+
+        for i in 0..8 {
+            batch.delete(format!("key-{}", i));
+        }
+        assert_eq!(
+            batch
+                .to_empty()
+                .thread_pool
+                .map(|pool| Arc::ptr_eq(&pool, &thread_pool)),
+            Some(true)
+        );
+        assert_eq!(batch.execute().count(), 8);
+        assert!(Arc::ptr_eq(batch.thread_pool.as_ref().unwrap(), &thread_pool));
+
+        let thread_names = thread_names.lock().unwrap();
+        assert!(!thread_names.is_empty() && thread_names.len() <= 2);
+        assert!(thread_names
+            .iter()
+            .all(|name| name.starts_with("qiniu_ng_batch_operations_worker_")));
+        Ok(())
+    }
+
+    #[test]
+    fn test_batch_operations_encode_ops() {
+        let op = BatchOperation::Copy {
+            key: "a".to_owned(),
+            to_bucket: "b".to_owned(),
+            to_key: "c".to_owned(),
+            force: true,
+        };
+        assert_eq!(
+            op.to_op("bucket"),
+            format!(
+                "/copy/{}/{}/force/true",
+                encode_entry("bucket", "a"),
+                encode_entry("b", "c")
+            )
+        );
+        assert!(!op.is_read_only());
+        assert!(is_retryable_code(599));
+        assert!(!is_retryable_code(579));
+        assert!(!is_retryable_code(612));
+    }
+}
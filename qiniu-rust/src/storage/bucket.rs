@@ -1,6 +1,7 @@
 //! 存储空间模块
 
 use super::{
+    batch::BatchOperations,
     region::{Region, RegionId},
     uploader::{BucketUploaderBuilder, UploadManager},
 };
@@ -280,6 +281,18 @@ impl<'r> Bucket<'r> {
         self.upload_manager.for_bucket(self)
     }
 
+    /// 获取当前存储空间批量操作生成器
+    ///
+    /// 如果区域在存储空间生成前未指定，则该方法可能会连接七牛服务器查询当前存储空间所在区域，以确定 RS 服务器 URL 列表
+    pub fn batch(&self) -> BatchOperations {
+        BatchOperations::new(
+            self.name().into(),
+            self.credential.as_ref().to_owned(),
+            self.http_client.to_owned(),
+            self.rs_urls().into_iter().map(|url| url.into_owned().into()).collect(),
+        )
+    }
+
     fn rs_urls(&self) -> Vec<Cow<'static, str>> {
         let mut rs_urls = self
             .region()
@@ -309,10 +322,10 @@ mod domain {
     };
 
     lazy_static! {
-        static ref QUERY_CACHE: CacheMap<QueryCacheKey, Vec<String>> = CacheMap::new(true);
+        static ref QUERY_CACHE: CacheMap<QueryCacheKey, Vec<String>> = CacheMap::with_max_capacity(4096, true);
     }
 
-    #[derive(PartialEq, Hash, Clone, Debug)]
+    #[derive(PartialEq, Eq, Hash, Clone, Debug)]
     struct QueryCacheKey(String);
 
     impl QueryCacheKey {
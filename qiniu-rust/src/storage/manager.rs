@@ -2,7 +2,7 @@
 //!
 //! 封装存储相关管理功能
 
-use super::{bucket::BucketBuilder, uploader::UploadManager};
+use super::{bucket::BucketBuilder, region::Region, uploader::UploadManager};
 use crate::{
     config::Config,
     credential::Credential,
@@ -116,6 +116,18 @@ impl StorageManager {
         UploadManager::new(self.http_client.config().to_owned())
     }
 
+    /// 批量预取多个存储空间的区域信息
+    ///
+    /// 并发查询所有尚未缓存区域信息的存储空间，查询结果将随域名管理器持久化，之后构建这些存储空间时无需再等待区域查询。
+    /// 适合在服务启动时，或在 Fork 工作进程前调用
+    pub fn prefetch_buckets(&self, bucket_names: &[&str]) -> HTTPResult<()> {
+        Region::prefetch(
+            bucket_names,
+            self.credential.access_key(),
+            self.http_client.config().to_owned(),
+        )
+    }
+
     /// 获取存储空间实例生成器
     pub fn bucket<'b>(&'b self, bucket: impl Into<Cow<'b, str>>) -> BucketBuilder<'b> {
         BucketBuilder::new(bucket.into(), self.credential.borrow().into(), self.upload_manager())
@@ -2,6 +2,7 @@
 //!
 //! 负责对整个 SDK 存储方面的逻辑进行处理
 
+pub mod batch;
 pub mod bucket;
 pub mod manager;
 pub mod recorder;
@@ -40,7 +40,14 @@ pub trait Recorder: Debug + Sync + Send {
 /// 记录仪介质特性
 ///
 /// 提供上传日志记录仪的持久化介质相关特性
-pub trait RecordMedium: Read + Write + Send {}
+pub trait RecordMedium: Read + Write + Send {
+    /// 如果介质基于本地文件，则返回该文件
+    ///
+    /// 读取进度记录时，SDK 将尝试直接将文件映射到内存中解析，默认返回 `None`，此时将回退到普通的读取方式
+    fn as_file(&self) -> Option<&File> {
+        None
+    }
+}
 
 /// 文件系统记录仪
 ///
@@ -110,4 +117,8 @@ impl Recorder for FileSystemRecorder {
     }
 }
 
-impl RecordMedium for File {}
+impl RecordMedium for File {
+    fn as_file(&self) -> Option<&File> {
+        Some(self)
+    }
+}
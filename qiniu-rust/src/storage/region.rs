@@ -4,16 +4,21 @@
 use crate::{
     config::Config,
     http::{Client, Result},
-    utils::cache_map::CacheMap,
+    utils::{cache_map::CacheMap, global_thread_pool},
 };
 use assert_impl::assert_impl;
+use crossbeam_utils::thread::scope;
 use derive_builder::Builder;
 use getset::{CopyGetters, Getters};
 use lazy_static::lazy_static;
-use serde::Deserialize;
+use serde::{Deserialize, Serialize};
 use std::{
     borrow::Cow,
     convert::AsRef,
+    sync::{
+        atomic::{AtomicUsize, Ordering::Relaxed},
+        Mutex,
+    },
     time::{Duration, SystemTime},
 };
 
@@ -389,7 +394,9 @@ impl Region {
 
     /// 查询七牛服务器，根据存储空间名称获取区域列表
     ///
-    /// 需要注意的是，当前方法具有缓存机制，对同一 Access Key 和存储空间多次调用时，将会返回缓存结果而不会发送 HTTP 请求
+    /// 需要注意的是，当前方法具有缓存机制，对同一 Access Key 和存储空间多次调用时，将会返回缓存结果而不会发送 HTTP 请求。
+    /// 查询结果还将缓存在域名管理器中并随之持久化，因此新启动的进程可以直接使用之前的查询结果。
+    /// 查询结果在一天后需要刷新，此时将继续返回原有结果，同时在全局线程池中刷新，只有超过七天未能刷新的结果才会被丢弃并重新同步查询
     pub fn query<'a>(
         bucket: impl Into<Cow<'a, str>>,
         access_key: impl Into<Cow<'a, str>>,
@@ -397,23 +404,94 @@ impl Region {
     ) -> Result<Box<[Region]>> {
         let bucket = bucket.into();
         let access_key = access_key.into();
-        let (regions, _) = QUERY_CACHE
-            .try_get_or_insert(QueryCacheKey::new(&access_key, &bucket), || {
-                let uc_url = config.uc_url();
-                let result: RegionQueryResults = Client::new(config)
-                    .get("/v3/query", &[&uc_url])
-                    .query("ak", access_key)
-                    .query("bucket", bucket)
-                    .accept_json()
-                    .no_body()
-                    .send()?
-                    .parse_json()?;
-                Ok(Some((
-                    result.into_regions(),
-                    SystemTime::now() + Duration::from_secs(24 * 60 * 60),
-                )))
-            })?
-            .unwrap();
+        let key = QueryCacheKey::new(&config.uc_url(), &access_key, &bucket);
+        if let Some(cache_entry) = QUERY_CACHE.get(&key) {
+            return Ok(cache_entry.data().to_owned());
+        }
+        if let Some(regions) = Self::query_from_persistent_cache(&key, &bucket, &access_key, &config) {
+            return Ok(regions);
+        }
+        Self::query_from_uc(key, &bucket, &access_key, &config)
+    }
+
+    /// 批量查询多个存储空间的区域列表，以预热区域查询缓存
+    ///
+    /// 尚未缓存的存储空间将被并发查询，之后再调用 [`Region::query`](#method.query) 将直接返回缓存结果。
+    /// 全部查询完成后，将立即持久化域名管理器，以便之后启动的进程直接使用查询结果。
+    /// 即使部分存储空间查询失败，其他存储空间的查询依然会继续进行，最终返回第一个遇到的错误
+    pub fn prefetch(buckets: &[&str], access_key: &str, config: Config) -> Result<()> {
+        let next = AtomicUsize::new(0);
+        let first_error = Mutex::new(None);
+        scope(|s| {
+            for _ in 0..PREFETCH_CONCURRENCY.min(buckets.len()) {
+                s.spawn(|_| {
+                    while let Some(&bucket) = buckets.get(next.fetch_add(1, Relaxed)) {
+                        if let Err(err) = Self::query(bucket, access_key, config.to_owned()) {
+                            first_error.lock().unwrap().get_or_insert(err);
+                        }
+                    }
+                });
+            }
+        })
+        .unwrap();
+        let _ = config.domains_manager().persistent();
+        match first_error.into_inner().unwrap() {
+            Some(err) => Err(err),
+            None => Ok(()),
+        }
+    }
+
+    /// 使用域名管理器中缓存的查询结果，需要刷新的结果依然会被使用，同时在全局线程池中刷新
+    fn query_from_persistent_cache(
+        key: &QueryCacheKey,
+        bucket: &str,
+        access_key: &str,
+        config: &Config,
+    ) -> Option<Box<[Region]>> {
+        let (response, refresh_at) = config.domains_manager().region_query(&key.0)?;
+        let now = SystemTime::now();
+        if refresh_at + QUERY_CACHE_MAX_STALENESS < now {
+            return None;
+        }
+        let regions = serde_json::from_str::<RegionQueryResults>(&response)
+            .ok()?
+            .into_regions();
+        if refresh_at > now {
+            QUERY_CACHE.insert(key.to_owned(), regions.to_owned(), refresh_at);
+        } else {
+            // 短暂地在内存中缓存需要刷新的结果，避免刷新完成前重复发起刷新
+            QUERY_CACHE.insert(key.to_owned(), regions.to_owned(), now + STALE_QUERY_CACHE_LIFETIME);
+            let (key, bucket, access_key, config) = (
+                key.to_owned(),
+                bucket.to_owned(),
+                access_key.to_owned(),
+                config.to_owned(),
+            );
+            global_thread_pool.read().unwrap().spawn(move || {
+                let _ = Self::query_from_uc(key, &bucket, &access_key, &config);
+            });
+        }
+        Some(regions)
+    }
+
+    fn query_from_uc(key: QueryCacheKey, bucket: &str, access_key: &str, config: &Config) -> Result<Box<[Region]>> {
+        let uc_url = config.uc_url();
+        let result: RegionQueryResults = Client::new(config.to_owned())
+            .get("/v3/query", &[&uc_url])
+            .query("ak", access_key)
+            .query("bucket", bucket)
+            .accept_json()
+            .no_body()
+            .send()?
+            .parse_json()?;
+        let refresh_at = SystemTime::now() + QUERY_CACHE_LIFETIME;
+        if let Ok(response) = serde_json::to_string(&result) {
+            config
+                .domains_manager()
+                .cache_region_query(key.0.as_str().into(), response.into(), refresh_at);
+        }
+        let regions = result.into_regions();
+        QUERY_CACHE.insert(key, regions.to_owned(), refresh_at);
         Ok(regions)
     }
 
@@ -424,15 +502,25 @@ impl Region {
     }
 }
 
+/// 区域查询结果需要刷新前的有效时长
+const QUERY_CACHE_LIFETIME: Duration = Duration::from_secs(24 * 60 * 60);
+/// 区域查询结果需要刷新后，最多还能继续使用的时长
+const QUERY_CACHE_MAX_STALENESS: Duration = Duration::from_secs(7 * 24 * 60 * 60);
+/// 需要刷新的区域查询结果在内存中缓存的时长
+const STALE_QUERY_CACHE_LIFETIME: Duration = Duration::from_secs(60);
+/// 批量查询区域列表时的最大并发数
+const PREFETCH_CONCURRENCY: usize = 8;
+
 lazy_static! {
-    static ref QUERY_CACHE: CacheMap<QueryCacheKey, Box<[Region]>> = CacheMap::new(true);
+    static ref QUERY_CACHE: CacheMap<QueryCacheKey, Box<[Region]>> = CacheMap::with_max_capacity(4096, true);
 }
-#[derive(PartialEq, Hash, Clone, Debug)]
+#[derive(PartialEq, Eq, Hash, Clone, Debug)]
 struct QueryCacheKey(String);
 
 impl QueryCacheKey {
-    fn new(access_key: &str, bucket_name: &str) -> Self {
-        Self(access_key.to_owned() + ":" + bucket_name)
+    /// 不同的 UC 服务器（例如私有云）给出的查询结果不同，因此键中需要包含 UC 服务器地址
+    fn new(uc_url: &str, access_key: &str, bucket_name: &str) -> Self {
+        Self(uc_url.to_owned() + "/" + access_key + ":" + bucket_name)
     }
 }
 
@@ -572,23 +660,23 @@ lazy_static! {
         [Region::z0(), Region::z1(), Region::z2(), Region::na0(), Region::as0()];
 }
 
-#[derive(Deserialize, Debug, Clone)]
+#[derive(Serialize, Deserialize, Debug, Clone)]
 struct RegionQueryResults {
     hosts: Vec<RegionQueryResult>,
 }
 
-#[derive(Deserialize, Debug, Clone)]
+#[derive(Serialize, Deserialize, Debug, Clone)]
 struct RegionQueryResult {
     io: RegionQueryResultForIO,
     up: RegionQueryResultForUP,
 }
 
-#[derive(Deserialize, Debug, Clone)]
+#[derive(Serialize, Deserialize, Debug, Clone)]
 struct RegionQueryResultForIO {
     src: RegionQueryResultDomains,
 }
 
-#[derive(Deserialize, Debug, Clone)]
+#[derive(Serialize, Deserialize, Debug, Clone)]
 struct RegionQueryResultForUP {
     src: RegionQueryResultDomains,
     acc: RegionQueryResultDomains,
@@ -596,7 +684,7 @@ struct RegionQueryResultForUP {
     old_acc: RegionQueryResultDomains,
 }
 
-#[derive(Deserialize, Debug, Clone)]
+#[derive(Serialize, Deserialize, Debug, Clone)]
 struct RegionQueryResultDomains {
     main: Vec<String>,
     backup: Option<Vec<String>>,
@@ -671,9 +759,9 @@ mod tests {
         credential::Credential,
         http::{DomainsManagerBuilder, Headers},
     };
-    use qiniu_test_utils::http_call_mock::JSONCallMock;
+    use qiniu_test_utils::http_call_mock::{CounterCallMock, JSONCallMock};
     use serde_json::json;
-    use std::{boxed::Box, error::Error, result::Result};
+    use std::{boxed::Box, error::Error, path::PathBuf, result::Result, thread::sleep};
 
     #[test]
     fn test_query_region_by_expected_domain() -> Result<(), Box<dyn Error>> {
@@ -796,6 +884,74 @@ mod tests {
         Ok(())
     }
 
+    #[test]
+    fn test_prefetch_regions_and_refresh_stale_query() -> Result<(), Box<dyn Error>> {
+        clear_query_cache();
+
+        let mock = CounterCallMock::new(JSONCallMock::new(
+            200,
+            Headers::new(),
+            json!({
+                "hosts": [{
+                    "io": { "src": { "main": [ "iovip-z9.qbox.me" ] } },
+                    "up": {
+                        "acc": { "main": [ "upload-z9.qiniup.com" ] },
+                        "old_acc": { "main": [ "upload-z9.qbox.me" ] },
+                        "old_src": { "main": [ "up-z9.qbox.me" ] },
+                        "src": { "main": [ "up-z9.qiniup.com" ] }
+                    }
+                }]
+            }),
+        ));
+        let config = ConfigBuilder::default()
+            .domains_manager(
+                DomainsManagerBuilder::create_new(None::<PathBuf>)?
+                    .disable_url_resolution()
+                    .build(),
+            )
+            .http_request_handler(mock.to_owned())
+            .build();
+        let access_key = get_credential().access_key().to_owned();
+        Region::prefetch(
+            &["z9-bucket-1", "z9-bucket-2", "z9-bucket-3"],
+            &access_key,
+            config.to_owned(),
+        )?;
+        assert_eq!(mock.call_called(), 3);
+
+        clear_query_cache();
+        let regions = Region::query("z9-bucket-2", access_key.as_str(), config.to_owned())?;
+        assert_eq!(
+            regions.first().unwrap().up_http_urls().first().unwrap(),
+            "http://upload-z9.qiniup.com"
+        );
+        assert_eq!(mock.call_called(), 3);
+
+        let key = QueryCacheKey::new(&config.uc_url(), &access_key, "z9-bucket-1");
+        let (response, _) = config.domains_manager().region_query(&key.0).unwrap();
+        config.domains_manager().cache_region_query(
+            key.0.as_str().into(),
+            response,
+            SystemTime::now() - Duration::from_secs(60),
+        );
+        clear_query_cache();
+        let regions = Region::query("z9-bucket-1", access_key.as_str(), config.to_owned())?;
+        assert_eq!(
+            regions.first().unwrap().up_http_urls().first().unwrap(),
+            "http://upload-z9.qiniup.com"
+        );
+        for _ in 0..100 {
+            if mock.call_called() > 3 {
+                break;
+            }
+            sleep(Duration::from_millis(50));
+        }
+        assert_eq!(mock.call_called(), 4);
+        let (_, refresh_at) = config.domains_manager().region_query(&key.0).unwrap();
+        assert!(refresh_at > SystemTime::now());
+        Ok(())
+    }
+
     fn get_credential() -> Credential {
         Credential::new("abcdefghklmnopq", "1234567890")
     }
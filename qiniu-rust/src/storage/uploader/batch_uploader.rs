@@ -1,21 +1,28 @@
-use super::{bucket_uploader::ResumablePolicy, BucketUploader, FileUploaderBuilder, UploadResult};
-use crate::utils::ron::Ron;
+use super::{
+    bucket_uploader::ResumablePolicy, BucketUploader, EtagCache, FileUploaderBuilder, UploadResponse, UploadResult,
+};
+use crate::{
+    http::{BandwidthLimiter, CancellationToken},
+    storage::batch::BatchOperations,
+    utils::{etag, ron::Ron, thread_pool::shared_upload_thread_pool},
+};
 use mime::Mime;
 use rayon::{ThreadPool, ThreadPoolBuilder};
 use std::{
     borrow::Cow,
-    collections::HashMap,
+    collections::{HashMap, VecDeque},
     fs::File,
     io::{Read, Result},
-    mem::replace,
-    path::Path,
+    mem::{replace, transmute},
+    path::{Path, PathBuf},
+    sync::{Arc, Condvar, Mutex},
 };
 
 type OnUploadingProgressCallback = Box<dyn Fn(u64, Option<u64>) + Send + Sync>;
 type OnCompletedCallback = Box<dyn Fn(UploadResult) + Send + Sync>;
 
 enum BatchUploadTarget {
-    File(File),
+    File(File, PathBuf),
     Stream(Box<dyn Read + Send>),
 }
 
@@ -27,6 +34,7 @@ pub struct BatchUploadJob {
     vars: HashMap<String, String>,
     metadata: HashMap<String, String>,
     checksum_enabled: bool,
+    local_etag_enabled: bool,
     resumable_policy: Option<ResumablePolicy>,
     file_name: String,
     mime: Option<Mime>,
@@ -34,6 +42,9 @@ pub struct BatchUploadJob {
     on_completed: Option<OnCompletedCallback>,
     target: BatchUploadTarget,
     expected_data_size: u64,
+    bandwidth_limiter: Option<BandwidthLimiter>,
+    cancellation_token: Option<CancellationToken>,
+    existence_checked: bool,
 }
 
 /// 批量上传任务生成器，提供上传数据所需的多个参数
@@ -43,33 +54,151 @@ pub struct BatchUploadJobBuilder {
     vars: HashMap<String, String>,
     metadata: HashMap<String, String>,
     checksum_enabled: bool,
+    local_etag_enabled: bool,
     on_uploading_progress: Option<OnUploadingProgressCallback>,
     on_completed: Option<OnCompletedCallback>,
     resumable_policy: Option<ResumablePolicy>,
+    bandwidth_limiter: Option<BandwidthLimiter>,
+    cancellation_token: Option<CancellationToken>,
 }
 
+#[derive(Clone)]
 struct BatchUploaderContext {
     upload_token: String,
     bucket_uploader: BucketUploader,
     max_concurrency: usize,
     thread_pool_size: usize,
+    use_shared_thread_pool: bool,
+    max_in_flight_bytes: u64,
+    fairness_policy: FairnessPolicy,
+    jobs_queue_capacity: usize,
+    skip_if_exists: Option<BatchOperations>,
+    etag_cache: Option<EtagCache>,
+}
+
+/// 批量上传调度策略
+///
+/// 决定批量上传器在文件任务与分片上传产生的分块任务之间如何分配线程
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum FairnessPolicy {
+    /// 小文件优先
+    ///
+    /// 总是优先执行数据量最小的任务，尺寸小于分块尺寸的文件将优先于正在上传的大文件的分块执行，
+    /// 以降低大文件上传期间小文件的上传延迟。默认采用该策略
+    SmallFirst,
+
+    /// 轮流调度
+    ///
+    /// 按照提交顺序执行文件任务，并在新的文件任务与每个正在分片上传的文件之间轮流分配线程
+    RoundRobin,
+}
+
+impl Default for FairnessPolicy {
+    fn default() -> Self {
+        FairnessPolicy::SmallFirst
+    }
+}
+
+/// 由批量上传调度器调度的分块任务
+///
+/// 分片上传的文件在由批量上传器上传时，每个分块都将作为独立的任务，与其他文件任务共用同一个任务队列
+pub(super) trait PartTasks: Sync {
+    /// 下一个分块的预计尺寸，单位为字节
+    fn part_size(&self) -> u64;
+
+    /// 允许同时上传的最大分块数
+    fn concurrency(&self) -> usize;
+
+    /// 上传下一个分块，如果已经没有需要上传的分块，或上传已经失败，则返回 `false`
+    fn upload_next_part(&self) -> bool;
+}
+
+/// 批量上传调度器
+///
+/// 文件任务与分片上传产生的分块任务共用同一个任务队列，线程池内的每个线程都从中领取任务执行，
+/// 避免少数大文件的分块占满所有线程，令大量小文件排队等待，反之亦然。
+/// 调度器同时限制所有正在执行的任务的数据总量
+pub(super) struct BatchScheduler {
+    state: Mutex<SchedulerState>,
+    condvar: Condvar,
+    fairness_policy: FairnessPolicy,
+    max_in_flight_bytes: u64,
+    block_size: u64,
+    jobs_queue_capacity: usize,
+}
+
+struct SchedulerState {
+    pending_jobs: VecDeque<BatchUploadJob>,
+    running_jobs: usize,
+    running_workers: usize,
+    closed: bool,
+    part_sources: Vec<PartSource>,
+    next_source_id: usize,
+    in_flight_bytes: u64,
+    round_robin_cursor: usize,
+}
+
+struct PartSource {
+    id: usize,
+    tasks: PartTasksRef,
+    in_flight: usize,
+    exhausted: bool,
+}
+
+/// 被擦除了生命周期的分块任务引用
+///
+/// `BatchScheduler::run_parts()` 保证在所有借用该引用的分块任务执行完毕之前不会返回，因此引用总是有效的
+#[derive(Clone, Copy)]
+struct PartTasksRef(*const (dyn PartTasks + 'static));
+
+unsafe impl Send for PartTasksRef {}
+
+enum Task {
+    Job(BatchUploadJob, u64),
+    Part(usize, PartTasksRef, u64),
+}
+
+#[derive(Clone, Copy)]
+enum Until {
+    AllJobsDone,
+    SourceDone(usize),
+}
+
+/// 在后台持续运行的批量上传器
+struct StreamingUploader {
+    context: BatchUploaderContext,
+    scheduler: BatchScheduler,
+    /// 后台上传线程将一直占用线程池，因此总是使用专用线程池
+    thread_pool: ThreadPool,
 }
 
 /// 批量上传器，上传之前所有提交的任务
+///
+/// 批量上传器有两种使用方式：
+/// 提交全部任务后调用 `start` 方法上传，该方法将阻塞直到所有任务完成；
+/// 或者调用 `spawn` 方法在后台启动上传线程，之后提交的任务将立即开始上传，直到调用 `shutdown` 方法为止
 pub struct BatchUploader {
     context: BatchUploaderContext,
     jobs: Vec<BatchUploadJob>,
+    streaming: Option<Arc<StreamingUploader>>,
 }
 
 impl BatchUploader {
     pub(super) fn new(bucket_uploader: &BucketUploader, upload_token: String) -> Self {
         Self {
             jobs: Vec::new(),
+            streaming: None,
             context: BatchUploaderContext {
                 bucket_uploader: bucket_uploader.to_owned(),
                 upload_token,
                 max_concurrency: 0,
                 thread_pool_size: 0,
+                use_shared_thread_pool: false,
+                max_in_flight_bytes: 0,
+                fairness_policy: FairnessPolicy::default(),
+                jobs_queue_capacity: 1024,
+                skip_if_exists: None,
+                etag_cache: None,
             },
         }
     }
@@ -84,12 +213,23 @@ impl BatchUploader {
 
     /// 为上传器创建专用线程池指定线程池大小
     ///
-    /// 批量上传器总是优先使用存储空间上传器中的线程池，如果存储空间上传器中没有创建过线程池，则自行创建专用线程池
+    /// 调用 `start` 方法时，批量上传器总是优先使用存储空间上传器中的线程池，如果存储空间上传器中没有创建过线程池，则自行创建专用线程池。
+    /// 调用 `spawn` 方法时，则总是自行创建专用线程池
     pub fn thread_pool_size(&mut self, num_threads: usize) -> &mut Self {
         self.context.thread_pool_size = num_threads;
         self
     }
 
+    /// 是否使用进程内共享的上传线程池
+    ///
+    /// 默认情况下，如果存储空间上传器中没有线程池，每次调用 `start` 或 `spawn` 方法都将创建专用线程池。
+    /// 启用后，所有启用该选项的批量上传器将共用同一个线程池，除非调用 `thread_pool_size` 方法指定了线程池大小。
+    /// 该选项仅对 `start` 方法有效，`spawn` 方法总是自行创建专用线程池
+    pub fn use_shared_thread_pool(&mut self, use_shared_thread_pool: bool) -> &mut Self {
+        self.context.use_shared_thread_pool = use_shared_thread_pool;
+        self
+    }
+
     /// 上传文件最大并发度
     ///
     /// 默认情况下，上传文件时的最大并发度等于其使用的线程池大小。
@@ -99,66 +239,729 @@ impl BatchUploader {
         self
     }
 
+    /// 所有正在上传的数据总量上限，单位为字节
+    ///
+    /// 文件任务按照文件尺寸计算（至多计为一个分块尺寸），分块任务按照分块尺寸计算。
+    /// 即将执行的任务将令数据总量超出上限时，该任务将等待其他任务完成后再执行，但总是允许至少一个任务执行。
+    /// 默认为 `0`，表示不限制
+    pub fn max_in_flight_bytes(&mut self, max_in_flight_bytes: u64) -> &mut Self {
+        self.context.max_in_flight_bytes = max_in_flight_bytes;
+        self
+    }
+
+    /// 批量上传调度策略
+    ///
+    /// 默认采用小文件优先的策略
+    pub fn fairness_policy(&mut self, fairness_policy: FairnessPolicy) -> &mut Self {
+        self.context.fairness_policy = fairness_policy;
+        self
+    }
+
+    /// 在后台上传时，等待上传的任务数量上限
+    ///
+    /// 等待上传的任务达到上限后，提交任务将阻塞，直到有任务开始上传。
+    /// 默认为 `1024`，如果设置为 `0`，表示不限制。
+    /// 仅对调用 `spawn` 方法之后提交的任务生效
+    pub fn jobs_queue_capacity(&mut self, jobs_queue_capacity: usize) -> &mut Self {
+        self.context.jobs_queue_capacity = jobs_queue_capacity;
+        self
+    }
+
+    /// 跳过已经存在且内容一致的对象
+    ///
+    /// 启用后，对于指定了对象名称的文件任务，批量上传器将在上传前批量获取这些对象的元信息，并在等待响应期间并行计算文件的 Etag，
+    /// Etag 与已经存在的对象一致的文件将不再上传，而是直接以 `UploadResponse::is_skipped()` 返回 `true` 的上传响应调用完成上传回调。
+    /// 数据流任务，以及没有指定对象名称的任务总是会被上传。
+    ///
+    /// 调用 `start` 或 `spawn` 方法前提交的任务将在同一批次中检查，此后提交的任务将在开始上传前，与其他等待上传且尚未检查过的任务合并在同一批次中检查。
+    /// 传入的批量操作生成器应当通过上传目标存储空间的 `Bucket::batch()` 方法获取，其中已经添加的操作将被忽略，
+    /// 而批次大小，并发度和重试次数等参数将用于获取对象元信息。
+    /// 如果批量操作生成器属于其他存储空间，则将改为使用客户端配置中的 RS 服务器获取上传目标存储空间中的对象元信息
+    pub fn skip_if_exists(&mut self, batch_operations: BatchOperations) -> &mut Self {
+        let bucket_name = self.context.bucket_uploader.bucket_name();
+        self.context.skip_if_exists = Some(if batch_operations.bucket_name() == bucket_name {
+            batch_operations.to_empty()
+        } else {
+            batch_operations.to_empty_for_bucket(bucket_name)
+        });
+        self
+    }
+
+    /// 跳过已经存在的对象时使用的本地 Etag 缓存
+    ///
+    /// 文件尺寸和修改时间均未改变的文件将直接使用缓存的 Etag，而无需再次读取文件。
+    /// 如果缓存指定了持久化文件，则在 `start` 方法返回前，调用 `spawn` 方法检查完已经提交的任务后，或调用 `shutdown` 方法后，缓存都将被写回该文件
+    pub fn etag_cache(&mut self, etag_cache: EtagCache) -> &mut Self {
+        self.context.etag_cache = Some(etag_cache);
+        self
+    }
+
     /// 提交上传任务
+    ///
+    /// 如果已经调用过 `spawn` 方法，任务将被立即提交到上传队列中；
+    /// 如果等待上传的任务数量已经达到上限，该方法将阻塞直到有任务开始上传
     pub fn push_job(&mut self, job: BatchUploadJob) -> &mut Self {
-        self.jobs.push(job);
+        match &self.streaming {
+            Some(streaming) => streaming.scheduler.submit(job),
+            None => self.jobs.push(job),
+        }
         self
     }
 
     /// 开始执行上传任务
     ///
-    /// 需要注意的是，该方法会持续阻塞直到上传任务全部执行完毕（不保证执行顺序）。
+    /// 需要注意的是，该方法会持续阻塞直到上传任务全部执行完毕（执行顺序由调度策略决定，不保证完成顺序）。
     /// 该方法不返回任何结果，上传结果由每个上传任务内定义的 `on_completed` 回调负责返回。
     ///
-    /// 方法返回后，当前批量上传器的上传任务将被清空，但其他参数都将保留，可以重新添加任务并复用
+    /// 方法返回后，当前批量上传器的上传任务将被清空，但其他参数都将保留，可以重新添加任务并复用。
+    ///
+    /// 如果已经调用过 `spawn` 方法，该方法等同于 `drain` 方法
     pub fn start(&mut self) {
-        let thread_pool = build_thread_pool(&self.context);
+        if self.streaming.is_some() {
+            self.drain();
+            return;
+        }
+        let owned_thread_pool = build_thread_pool(&self.context);
         let context = &self.context;
-        let mut jobs = replace(&mut self.jobs, Vec::new());
+        let thread_pool = choose_thread_pool(context, &owned_thread_pool);
+        let jobs = replace(&mut self.jobs, Vec::new());
+        let jobs_capacity = jobs.capacity();
+        let jobs = skip_existing_jobs(context, jobs, thread_pool);
+        let scheduler = BatchScheduler::new(
+            jobs,
+            context.fairness_policy,
+            context.max_in_flight_bytes,
+            Self::block_size(context),
+        );
+        let workers = thread_pool.current_num_threads();
+        scheduler.add_workers(workers);
 
         thread_pool.scope(|s| {
-            while let Some(job) = jobs.pop() {
-                s.spawn(|_| handle_job(context, job, &thread_pool))
+            for _ in 0..workers {
+                s.spawn(|_| scheduler.work(context, thread_pool))
             }
         });
 
-        self.jobs = jobs;
+        persist_etag_cache(context);
+        self.jobs = Vec::with_capacity(jobs_capacity);
+    }
+
+    /// 在后台启动上传线程
+    ///
+    /// 该方法将立即返回。已经提交的任务和之后提交的任务都将在后台上传，上传结果由每个上传任务内定义的 `on_completed` 回调负责返回。
+    /// 可以调用 `drain` 方法等待已经提交的任务全部完成，或调用 `shutdown` 方法停止上传线程。
+    ///
+    /// 上传线程将一直占用线程池，直到调用 `shutdown` 方法或批量上传器被释放为止，
+    /// 因此该方法总是为上传线程创建专用线程池，不会占用存储空间上传器中的线程池或共享上传线程池。
+    /// 启动后修改的批量上传器参数，需要在调用 `shutdown` 后重新启动才能生效。
+    /// 如果已经启动，则该方法不做任何事情
+    pub fn spawn(&mut self) -> &mut Self {
+        if self.streaming.is_some() {
+            return self;
+        }
+        let context = self.context.to_owned();
+        let thread_pool = build_dedicated_thread_pool(&context);
+        let jobs = skip_existing_jobs(&context, replace(&mut self.jobs, Vec::new()), &thread_pool);
+        persist_etag_cache(&context);
+        let scheduler = BatchScheduler::new(
+            jobs,
+            context.fairness_policy,
+            context.max_in_flight_bytes,
+            Self::block_size(&context),
+        )
+        .streaming(context.jobs_queue_capacity);
+        let streaming = Arc::new(StreamingUploader {
+            context,
+            scheduler,
+            thread_pool,
+        });
+        let workers = streaming.thread_pool.current_num_threads();
+        streaming.scheduler.add_workers(workers);
+        for _ in 0..workers {
+            let worker = streaming.to_owned();
+            streaming
+                .thread_pool
+                .spawn(move || worker.scheduler.work(&worker.context, &worker.thread_pool));
+        }
+        self.streaming = Some(streaming);
+        self
+    }
+
+    /// 等待已经提交的任务全部完成
+    ///
+    /// 仅在调用 `spawn` 方法后有效。该方法返回后，后台上传线程依然保持运行，可以继续提交任务。
+    /// 请勿在上传任务的回调中调用该方法，否则将导致死锁
+    pub fn drain(&mut self) {
+        if let Some(streaming) = &self.streaming {
+            streaming.scheduler.drain();
+        }
+    }
+
+    /// 等待已经提交的任务全部完成，然后停止后台上传线程
+    ///
+    /// 该方法返回后，批量上传器将回到调用 `spawn` 方法前的状态，可以修改参数后重新启动。
+    /// 批量上传器被释放时，也将自动调用该方法。
+    /// 请勿在上传任务的回调中调用该方法，否则将导致死锁
+    pub fn shutdown(&mut self) {
+        if let Some(streaming) = self.streaming.take() {
+            streaming.scheduler.shutdown();
+            persist_etag_cache(&streaming.context);
+        }
+    }
+
+    fn block_size(context: &BatchUploaderContext) -> u64 {
+        context
+            .bucket_uploader
+            .http_client()
+            .config()
+            .upload_block_size()
+            .into()
+    }
+}
+
+impl Drop for BatchUploader {
+    fn drop(&mut self) {
+        self.shutdown();
+    }
+}
+
+impl BatchScheduler {
+    fn new(
+        jobs: Vec<BatchUploadJob>,
+        fairness_policy: FairnessPolicy,
+        max_in_flight_bytes: u64,
+        block_size: u64,
+    ) -> Self {
+        let mut jobs = jobs;
+        if fairness_policy == FairnessPolicy::SmallFirst {
+            // 稳定排序，尺寸相同的任务依然按照提交顺序执行
+            jobs.sort_by_key(|job| job.size_for_scheduling());
+        }
+        let pending_jobs = VecDeque::from(jobs);
+        BatchScheduler {
+            state: Mutex::new(SchedulerState {
+                pending_jobs,
+                running_jobs: 0,
+                running_workers: 0,
+                closed: true,
+                part_sources: Vec::new(),
+                next_source_id: 0,
+                in_flight_bytes: 0,
+                round_robin_cursor: 0,
+            }),
+            condvar: Condvar::new(),
+            fairness_policy,
+            max_in_flight_bytes,
+            block_size: block_size.max(1),
+            jobs_queue_capacity: 0,
+        }
+    }
+
+    /// 允许在上传期间继续提交任务，直到调用 `shutdown()` 为止
+    fn streaming(mut self, jobs_queue_capacity: usize) -> Self {
+        self.state.get_mut().unwrap().closed = false;
+        self.jobs_queue_capacity = jobs_queue_capacity;
+        self
+    }
+
+    /// 提交文件任务，如果等待上传的任务数量已经达到上限，则阻塞直到有任务开始上传
+    fn submit(&self, job: BatchUploadJob) {
+        {
+            let mut state = self.state.lock().unwrap();
+            while self.jobs_queue_capacity > 0 && state.pending_jobs.len() >= self.jobs_queue_capacity {
+                state = self.condvar.wait(state).unwrap();
+            }
+            debug_assert!(!state.closed);
+            let index = match self.fairness_policy {
+                FairnessPolicy::SmallFirst => Self::small_first_position(&state.pending_jobs, &job),
+                FairnessPolicy::RoundRobin => state.pending_jobs.len(),
+            };
+            state.pending_jobs.insert(index, job);
+        }
+        self.condvar.notify_all();
+    }
+
+    /// 取出至多指定数量的尚未检查过对象是否已经存在的等待上传的任务
+    fn take_unchecked_jobs(&self, limit: usize) -> Vec<BatchUploadJob> {
+        let mut taken = Vec::new();
+        {
+            let mut state = self.state.lock().unwrap();
+            let mut index = 0;
+            while index < state.pending_jobs.len() && taken.len() < limit {
+                if state.pending_jobs[index].existence_checked {
+                    index += 1;
+                } else {
+                    taken.extend(state.pending_jobs.remove(index));
+                }
+            }
+        }
+        if !taken.is_empty() {
+            self.condvar.notify_all();
+        }
+        taken
+    }
+
+    /// 将通过 `take_unchecked_jobs()` 取出的任务放回任务队列，不受等待上传的任务数量上限限制
+    fn requeue(&self, jobs: Vec<BatchUploadJob>) {
+        if jobs.is_empty() {
+            return;
+        }
+        {
+            let mut state = self.state.lock().unwrap();
+            match self.fairness_policy {
+                FairnessPolicy::SmallFirst => {
+                    for job in jobs {
+                        let index = Self::small_first_position(&state.pending_jobs, &job);
+                        state.pending_jobs.insert(index, job);
+                    }
+                }
+                // 这些任务早于队列中的其他任务提交，因此放回队首
+                FairnessPolicy::RoundRobin => {
+                    for job in jobs.into_iter().rev() {
+                        state.pending_jobs.push_front(job);
+                    }
+                }
+            }
+        }
+        self.condvar.notify_all();
+    }
+
+    fn small_first_position(pending_jobs: &VecDeque<BatchUploadJob>, job: &BatchUploadJob) -> usize {
+        let size = job.size_for_scheduling();
+        pending_jobs
+            .iter()
+            .position(|pending_job| pending_job.size_for_scheduling() > size)
+            .unwrap_or_else(|| pending_jobs.len())
+    }
+
+    /// 阻塞直到所有已经提交的文件任务全部完成
+    fn drain(&self) {
+        let mut state = self.state.lock().unwrap();
+        while !state.pending_jobs.is_empty() || state.running_jobs > 0 {
+            state = self.condvar.wait(state).unwrap();
+        }
+    }
+
+    /// 不再接受新的文件任务，并阻塞直到所有上传线程退出
+    fn shutdown(&self) {
+        let mut state = self.state.lock().unwrap();
+        state.closed = true;
+        self.condvar.notify_all();
+        while state.running_workers > 0 {
+            state = self.condvar.wait(state).unwrap();
+        }
+    }
+
+    fn add_workers(&self, workers: usize) {
+        self.state.lock().unwrap().running_workers += workers;
+    }
+
+    /// 上传线程的主循环，持续领取并执行文件任务和分块任务，直到不再接受新的任务且所有文件任务全部完成
+    fn work(&self, context: &BatchUploaderContext, thread_pool: &ThreadPool) {
+        let _guard = WorkerGuard { scheduler: self };
+        while let Some(task) = self.next_task(Until::AllJobsDone) {
+            match task {
+                Task::Job(job, cost) => {
+                    let _guard = JobGuard { scheduler: self, cost };
+                    handle_job(context, job, thread_pool, self);
+                }
+                Task::Part(id, tasks, cost) => self.run_part(id, tasks, cost),
+            }
+        }
+    }
+
+    /// 将文件的分块任务提交到任务队列，并阻塞直到所有分块任务执行完毕
+    ///
+    /// 等待期间当前线程也将领取分块任务执行（包括其他文件的分块任务），但不会领取新的文件任务
+    pub(super) fn run_parts(&self, tasks: &(dyn PartTasks + '_)) {
+        let tasks = PartTasksRef(unsafe { transmute::<&(dyn PartTasks + '_), &(dyn PartTasks + 'static)>(tasks) });
+        let id = {
+            let mut state = self.state.lock().unwrap();
+            let id = state.next_source_id;
+            state.next_source_id = id.wrapping_add(1);
+            state.part_sources.push(PartSource {
+                id,
+                tasks,
+                in_flight: 0,
+                exhausted: false,
+            });
+            id
+        };
+        self.condvar.notify_all();
+        // 即使分块任务发生 panic，也必须等到其他线程上正在执行的分块任务全部结束才能返回
+        let _guard = SourceGuard { scheduler: self, id };
+        while let Some(task) = self.next_task(Until::SourceDone(id)) {
+            if let Task::Part(id, tasks, cost) = task {
+                self.run_part(id, tasks, cost);
+            }
+        }
+    }
+
+    fn run_part(&self, id: usize, tasks: PartTasksRef, cost: u64) {
+        let mut guard = PartGuard {
+            scheduler: self,
+            id,
+            cost,
+            has_more: false,
+        };
+        guard.has_more = unsafe { &*tasks.0 }.upload_next_part();
+    }
+
+    fn next_task(&self, until: Until) -> Option<Task> {
+        let accept_jobs = match until {
+            Until::AllJobsDone => true,
+            Until::SourceDone(_) => false,
+        };
+        let mut state = self.state.lock().unwrap();
+        loop {
+            if let Some(task) = self.pick_task(&mut state, accept_jobs) {
+                if let Task::Job(..) = task {
+                    // 唤醒因等待上传的任务数量达到上限而阻塞的提交者
+                    drop(state);
+                    self.condvar.notify_all();
+                }
+                return Some(task);
+            }
+            match until {
+                Until::AllJobsDone => {
+                    // 分块任务总是由正在执行的文件任务提交，因此文件任务全部完成后就不会再有新的任务
+                    if state.closed && state.pending_jobs.is_empty() && state.running_jobs == 0 {
+                        return None;
+                    }
+                }
+                Until::SourceDone(id) => {
+                    if state
+                        .part_sources
+                        .iter()
+                        .find(|source| source.id == id)
+                        .map_or(true, |source| source.exhausted)
+                    {
+                        return None;
+                    }
+                }
+            }
+            state = self.condvar.wait(state).unwrap();
+        }
+    }
+
+    fn pick_task(&self, state: &mut SchedulerState, accept_jobs: bool) -> Option<Task> {
+        let admissible = |in_flight_bytes: u64, cost: u64| {
+            self.max_in_flight_bytes == 0
+                || in_flight_bytes == 0
+                || in_flight_bytes.saturating_add(cost) <= self.max_in_flight_bytes
+        };
+        // 候选任务中，0 表示队首的文件任务，其余表示对应下标的分块任务来源加一
+        let mut candidates = Vec::with_capacity(state.part_sources.len() + 1);
+        if accept_jobs {
+            if let Some(job) = state.pending_jobs.front() {
+                let cost = job.expected_data_size.min(self.block_size);
+                let cost = if cost == 0 { self.block_size } else { cost };
+                if admissible(state.in_flight_bytes, cost) {
+                    candidates.push((0, job.size_for_scheduling(), cost));
+                }
+            }
+        }
+        for (index, source) in state.part_sources.iter().enumerate() {
+            if source.exhausted {
+                continue;
+            }
+            let tasks = unsafe { &*source.tasks.0 };
+            if source.in_flight >= tasks.concurrency().max(1) {
+                continue;
+            }
+            let cost = tasks.part_size().max(1);
+            // 文件任务在等待自身分块任务期间依然占用着数据总量，
+            // 因此没有分块正在执行的来源总是可以领取下一个分块，否则数据总量上限小于两个分块尺寸时将永远无法继续
+            if source.in_flight == 0 || admissible(state.in_flight_bytes, cost) {
+                candidates.push((index + 1, cost, cost));
+            }
+        }
+        let slots = state.part_sources.len() + 1;
+        let &(slot, _, cost) = match self.fairness_policy {
+            // 尺寸相同时优先执行已经开始上传的文件的分块，使其尽早完成
+            FairnessPolicy::SmallFirst => candidates.iter().min_by_key(|&&(slot, size, _)| (size, slot == 0)),
+            FairnessPolicy::RoundRobin => {
+                let cursor = state.round_robin_cursor % slots;
+                candidates
+                    .iter()
+                    .min_by_key(|&&(slot, _, _)| (slot + slots - cursor) % slots)
+            }
+        }?;
+        state.round_robin_cursor = (slot + 1) % slots;
+        state.in_flight_bytes += cost;
+        if slot == 0 {
+            state.running_jobs += 1;
+            state.pending_jobs.pop_front().map(|job| Task::Job(job, cost))
+        } else {
+            let source = &mut state.part_sources[slot - 1];
+            source.in_flight += 1;
+            Some(Task::Part(source.id, source.tasks, cost))
+        }
+    }
+}
+
+struct WorkerGuard<'s> {
+    scheduler: &'s BatchScheduler,
+}
+
+impl Drop for WorkerGuard<'_> {
+    fn drop(&mut self) {
+        self.scheduler.state.lock().unwrap().running_workers -= 1;
+        self.scheduler.condvar.notify_all();
+    }
+}
+
+struct JobGuard<'s> {
+    scheduler: &'s BatchScheduler,
+    cost: u64,
+}
+
+impl Drop for JobGuard<'_> {
+    fn drop(&mut self) {
+        {
+            let mut state = self.scheduler.state.lock().unwrap();
+            state.running_jobs -= 1;
+            state.in_flight_bytes -= self.cost;
+        }
+        self.scheduler.condvar.notify_all();
+    }
+}
+
+struct PartGuard<'s> {
+    scheduler: &'s BatchScheduler,
+    id: usize,
+    cost: u64,
+    has_more: bool,
+}
+
+impl Drop for PartGuard<'_> {
+    fn drop(&mut self) {
+        {
+            let mut state = self.scheduler.state.lock().unwrap();
+            state.in_flight_bytes -= self.cost;
+            if let Some(source) = state.part_sources.iter_mut().find(|source| source.id == self.id) {
+                source.in_flight -= 1;
+                if !self.has_more {
+                    source.exhausted = true;
+                }
+            }
+        }
+        self.scheduler.condvar.notify_all();
+    }
+}
+
+struct SourceGuard<'s> {
+    scheduler: &'s BatchScheduler,
+    id: usize,
+}
+
+impl Drop for SourceGuard<'_> {
+    fn drop(&mut self) {
+        let mut state = self.scheduler.state.lock().unwrap();
+        while let Some(index) = state.part_sources.iter().position(|source| source.id == self.id) {
+            if state.part_sources[index].in_flight == 0 {
+                state.part_sources.remove(index);
+                break;
+            }
+            state.part_sources[index].exhausted = true;
+            state = self.scheduler.condvar.wait(state).unwrap();
+        }
+        drop(state);
+        self.scheduler.condvar.notify_all();
     }
 }
 
 /// 构建线程池
 ///
-/// 默认情况下总是使用存储空间上传器的线程池。
-/// 如果没有或该线程池尺寸只有 1，则自行创建。
+/// 默认情况下总是使用存储空间上传器的线程池，此时返回 `None`。
+/// 如果没有或该线程池尺寸只有 1，则在启用共享线程池且没有指定 `thread_pool_size` 时使用共享上传线程池，否则自行创建。
 /// 自行创建时将会使用 `thread_pool_size` 的建议，如果没有建议，就使用 CPU 数量（但如果 CPU 的数量为 1，则使用 2）。
 /// 确保返回的线程池尺寸必须大于 1，否则可能会导致死锁
-fn build_thread_pool(context: &BatchUploaderContext) -> Ron<'_, ThreadPool> {
-    context
+fn build_thread_pool(context: &BatchUploaderContext) -> Option<Arc<ThreadPool>> {
+    if context
         .bucket_uploader
         .thread_pool()
         .filter(|pool| pool.current_num_threads() > 1)
-        .map(Ron::Referenced)
-        .unwrap_or_else(|| {
-            let mut builder = ThreadPoolBuilder::new();
-            if context.thread_pool_size > 0 {
-                builder = builder.num_threads(context.thread_pool_size);
+        .is_some()
+    {
+        return None;
+    }
+    if context.use_shared_thread_pool && context.thread_pool_size == 0 {
+        return Some(shared_upload_thread_pool());
+    }
+    Some(Arc::new(build_dedicated_thread_pool(context)))
+}
+
+/// 构建批量上传器专用的线程池
+///
+/// 使用 `thread_pool_size` 的建议，如果没有建议，就使用 CPU 数量（但如果 CPU 的数量为 1，则使用 2）
+fn build_dedicated_thread_pool(context: &BatchUploaderContext) -> ThreadPool {
+    let builder = || ThreadPoolBuilder::new().thread_name(|index| format!("qiniu_ng_batch_uploader_worker_{}", index));
+    if context.thread_pool_size > 0 {
+        return builder().num_threads(context.thread_pool_size).build().unwrap();
+    }
+    let thread_pool = builder().build().unwrap();
+    if thread_pool.current_num_threads() > 1 {
+        thread_pool
+    } else {
+        builder().num_threads(2).build().unwrap()
+    }
+}
+
+/// 选择 `build_thread_pool` 构建的线程池，如果没有构建则使用存储空间上传器的线程池
+fn choose_thread_pool<'a>(
+    context: &'a BatchUploaderContext,
+    owned_thread_pool: &'a Option<Arc<ThreadPool>>,
+) -> &'a ThreadPool {
+    match owned_thread_pool {
+        Some(thread_pool) => thread_pool,
+        None => context.bucket_uploader.thread_pool().unwrap(),
+    }
+}
+
+/// 跳过已经存在且内容一致的对象，返回依然需要上传的任务
+fn skip_existing_jobs(
+    context: &BatchUploaderContext,
+    jobs: Vec<BatchUploadJob>,
+    thread_pool: &ThreadPool,
+) -> Vec<BatchUploadJob> {
+    if context.skip_if_exists.is_none() {
+        return jobs;
+    }
+    let mut jobs = jobs.into_iter().map(Some).collect::<Vec<_>>();
+    check_existing_jobs(context, &mut jobs, Some(thread_pool));
+    jobs.into_iter().flatten().collect()
+}
+
+/// 检查对象是否已经存在且内容一致，被跳过的任务将在当前线程中调用完成上传回调，并被替换为 `None`
+///
+/// 获取对象元信息的批量操作将首先在后台发送，每当获取到一个尺寸与文件一致的对象元信息，就立即计算该文件的 Etag，
+/// 对象不存在或获取元信息失败的文件不会计算 Etag。
+/// 指定线程池时 Etag 将在线程池中并行计算，否则在当前线程中依次计算。
+/// 上传线程内调用时不能指定线程池，等待线程池的期间当前线程可能会领取到其他批量上传器的上传线程主循环，从而导致死锁
+fn check_existing_jobs(
+    context: &BatchUploaderContext,
+    jobs: &mut [Option<BatchUploadJob>],
+    thread_pool: Option<&ThreadPool>,
+) {
+    let batch_operations = match &context.skip_if_exists {
+        Some(batch_operations) => batch_operations,
+        None => return,
+    };
+    let candidates = jobs
+        .iter_mut()
+        .enumerate()
+        .filter_map(|(index, job)| {
+            let job = job.as_mut()?;
+            if replace(&mut job.existence_checked, true) {
+                return None;
+            }
+            match (&job.key, &job.target) {
+                (Some(key), BatchUploadTarget::File(_, path)) => {
+                    Some((index, key.to_owned(), path.to_owned(), job.expected_data_size))
+                }
+                _ => None,
             }
-            Ron::Owned(
-                builder
-                    .thread_name(|index| format!("qiniu_ng_batch_uploader_worker_{}", index))
-                    .build()
-                    .unwrap(),
-            )
         })
+        .collect::<Vec<_>>();
+    if candidates.is_empty() {
+        return;
+    }
+
+    // 批量操作序号与候选任务下标一一对应，因此必须从空的批量操作开始添加
+    let mut batch_operations = batch_operations.to_empty();
+    for (_, key, _, _) in candidates.iter() {
+        batch_operations.stat(key.to_owned());
+    }
+    let stat_results = batch_operations.execute();
+    let skipped = Mutex::new(Vec::new());
+    // 计算候选文件的 Etag，与对象一致的文件将记录其候选任务序号，之后跳过上传
+    let check = |candidate_index: usize, hash: &str| {
+        let (_, _, path, _) = &candidates[candidate_index];
+        let etag = match &context.etag_cache {
+            Some(etag_cache) => etag_cache.etag_of(path, thread_pool),
+            None => match thread_pool {
+                Some(thread_pool) => etag::from_file_in_parallel(path, thread_pool),
+                None => etag::from_file(path),
+            },
+        };
+        if let Ok(etag) = etag {
+            if etag == hash {
+                skipped.lock().unwrap().push((candidate_index, etag));
+            }
+        }
+    };
+    // 对象不存在，获取元信息失败或尺寸不一致的，都将正常上传
+    let stats = stat_results.filter_map(|stat_result| {
+        let candidate_index = stat_result.index();
+        match stat_result.into_result() {
+            Ok(Some(stat)) => {
+                Some((candidate_index, stat)).filter(|(_, stat)| stat.size() == candidates[candidate_index].3)
+            }
+            _ => None,
+        }
+    });
+    match thread_pool {
+        Some(thread_pool) => thread_pool.scope(|s| {
+            for (candidate_index, stat) in stats {
+                let check = &check;
+                s.spawn(move |_| check(candidate_index, stat.hash()));
+            }
+        }),
+        None => {
+            for (candidate_index, stat) in stats {
+                check(candidate_index, stat.hash());
+            }
+        }
+    }
+    for (candidate_index, etag) in skipped.into_inner().unwrap() {
+        let (index, key, _, _) = &candidates[candidate_index];
+        if let Some(on_completed) = jobs[*index].take().and_then(|job| job.on_completed) {
+            on_completed(Ok(UploadResponse::skipped(key, &etag)));
+        }
+    }
 }
 
-fn handle_job(context: &BatchUploaderContext, job: BatchUploadJob, thread_pool: &ThreadPool) {
+fn persist_etag_cache(context: &BatchUploaderContext) {
+    if let Some(etag_cache) = &context.etag_cache {
+        let _ = etag_cache.persistent();
+    }
+}
+
+fn handle_job(
+    context: &BatchUploaderContext,
+    job: BatchUploadJob,
+    thread_pool: &ThreadPool,
+    scheduler: &BatchScheduler,
+) {
+    // 在开始上传后提交的任务尚未检查过对象是否已经存在，与其他等待上传且尚未检查过的任务合并在同一批次中检查
+    let job = match &context.skip_if_exists {
+        Some(batch_operations) if !job.existence_checked => {
+            let mut jobs = vec![Some(job)];
+            jobs.extend(
+                scheduler
+                    .take_unchecked_jobs(batch_operations.operations_per_batch().saturating_sub(1))
+                    .into_iter()
+                    .map(Some),
+            );
+            check_existing_jobs(context, &mut jobs, None);
+            let mut jobs = jobs.into_iter();
+            let job = jobs.next().unwrap();
+            scheduler.requeue(jobs.flatten().collect());
+            match job {
+                Some(job) => job,
+                None => return,
+            }
+        }
+        _ => job,
+    };
     let BatchUploadJob {
         key,
         upload_token,
         vars,
         metadata,
         checksum_enabled,
+        local_etag_enabled,
         resumable_policy,
         file_name,
         mime,
@@ -166,6 +969,9 @@ fn handle_job(context: &BatchUploaderContext, job: BatchUploadJob, thread_pool:
         expected_data_size,
         on_uploading_progress,
         on_completed,
+        bandwidth_limiter,
+        cancellation_token,
+        ..
     } = job;
 
     let mut builder = FileUploaderBuilder::new(
@@ -177,6 +983,7 @@ fn handle_job(context: &BatchUploaderContext, job: BatchUploadJob, thread_pool:
         },
     )
     .thread_pool(thread_pool)
+    .batch_scheduler(scheduler)
     .max_concurrency(context.max_concurrency);
     if let Some(key) = key {
         builder = builder.key(key);
@@ -192,9 +999,18 @@ fn handle_job(context: &BatchUploaderContext, job: BatchUploadJob, thread_pool:
     } else {
         builder = builder.disable_checksum();
     }
+    if local_etag_enabled {
+        builder = builder.enable_local_etag();
+    }
     if let Some(on_uploading_progress) = on_uploading_progress {
         builder = builder.on_progress(on_uploading_progress);
     }
+    if let Some(bandwidth_limiter) = bandwidth_limiter {
+        builder = builder.bandwidth_limiter(bandwidth_limiter);
+    }
+    if let Some(cancellation_token) = cancellation_token {
+        builder = builder.cancellation_token(cancellation_token);
+    }
     if let Some(resumable_policy) = resumable_policy {
         match resumable_policy {
             ResumablePolicy::Threshold(threshold) => {
@@ -209,7 +1025,7 @@ fn handle_job(context: &BatchUploaderContext, job: BatchUploadJob, thread_pool:
         }
     }
     let upload_result = match target {
-        BatchUploadTarget::File(file) => builder.upload_stream(file, expected_data_size, file_name, mime),
+        BatchUploadTarget::File(file, _) => builder.upload_stream(file, expected_data_size, file_name, mime),
         BatchUploadTarget::Stream(reader) => builder.upload_stream(reader, expected_data_size, file_name, mime),
     };
     if let Some(on_completed) = on_completed.as_ref() {
@@ -217,6 +1033,17 @@ fn handle_job(context: &BatchUploaderContext, job: BatchUploadJob, thread_pool:
     }
 }
 
+impl BatchUploadJob {
+    /// 调度时使用的任务尺寸，无法预知尺寸的数据流总是排在最后
+    fn size_for_scheduling(&self) -> u64 {
+        if self.expected_data_size > 0 {
+            self.expected_data_size
+        } else {
+            u64::max_value()
+        }
+    }
+}
+
 impl Default for BatchUploadJobBuilder {
     fn default() -> Self {
         Self {
@@ -225,9 +1052,12 @@ impl Default for BatchUploadJobBuilder {
             vars: HashMap::new(),
             metadata: HashMap::new(),
             checksum_enabled: true,
+            local_etag_enabled: false,
             on_uploading_progress: None,
             on_completed: None,
             resumable_policy: None,
+            bandwidth_limiter: None,
+            cancellation_token: None,
         }
     }
 }
@@ -280,6 +1110,21 @@ impl BatchUploadJobBuilder {
         self
     }
 
+    /// 启用本地 Etag 计算
+    ///
+    /// 启用后，将在读取上传数据的同时计算数据的 Etag，计算结果可以通过 `UploadResponse::local_etag()` 获取。
+    /// 默认不启用
+    pub fn enable_local_etag(mut self) -> Self {
+        self.local_etag_enabled = true;
+        self
+    }
+
+    /// 禁用本地 Etag 计算
+    pub fn disable_local_etag(mut self) -> Self {
+        self.local_etag_enabled = false;
+        self
+    }
+
     /// 指定分片上传策略阙值
     ///
     /// 对于上传文件的情况，如果文件尺寸大于该值，将自动使用分片上传，否则，使用表单上传。
@@ -326,6 +1171,23 @@ impl BatchUploadJobBuilder {
         self
     }
 
+    /// 为上传任务指定带宽限制器
+    ///
+    /// 默认使用存储空间上传器的带宽限制器，多个任务可以共用同一个带宽限制器以限制它们的总上传速率
+    pub fn bandwidth_limiter(mut self, bandwidth_limiter: BandwidthLimiter) -> Self {
+        self.bandwidth_limiter = Some(bandwidth_limiter);
+        self
+    }
+
+    /// 为上传任务指定取消令牌
+    ///
+    /// 默认使用存储空间上传器的取消令牌。取消令牌被取消后，尚未开始的任务将不再上传，
+    /// 正在进行的任务将尽快中止，两者均以用户取消错误回调完成上传回调
+    pub fn cancellation_token(mut self, cancellation_token: CancellationToken) -> Self {
+        self.cancellation_token = Some(cancellation_token);
+        self
+    }
+
     /// 上传文件
     ///
     /// 该方法用于生成批量上传任务，用于上传指定路径的文件
@@ -335,20 +1197,25 @@ impl BatchUploadJobBuilder {
         file_name: impl Into<String>,
         mime: Option<Mime>,
     ) -> Result<BatchUploadJob> {
-        let file = File::open(file_path.as_ref())?;
+        let file_path = file_path.as_ref();
+        let file = File::open(file_path)?;
         let job = BatchUploadJob {
             key: self.key,
             upload_token: self.upload_token,
             vars: self.vars,
             metadata: self.metadata,
             checksum_enabled: self.checksum_enabled,
+            local_etag_enabled: self.local_etag_enabled,
             resumable_policy: self.resumable_policy,
             on_uploading_progress: self.on_uploading_progress,
             on_completed: self.on_completed,
             file_name: file_name.into(),
             mime,
             expected_data_size: file.metadata()?.len(),
-            target: BatchUploadTarget::File(file),
+            target: BatchUploadTarget::File(file, file_path.to_owned()),
+            bandwidth_limiter: self.bandwidth_limiter,
+            cancellation_token: self.cancellation_token,
+            existence_checked: false,
         };
         Ok(job)
     }
@@ -369,6 +1236,7 @@ impl BatchUploadJobBuilder {
             vars: self.vars,
             metadata: self.metadata,
             checksum_enabled: self.checksum_enabled,
+            local_etag_enabled: self.local_etag_enabled,
             resumable_policy: self.resumable_policy,
             on_uploading_progress: self.on_uploading_progress,
             on_completed: self.on_completed,
@@ -376,6 +1244,447 @@ impl BatchUploadJobBuilder {
             mime,
             expected_data_size: size,
             target: BatchUploadTarget::Stream(Box::new(stream)),
+            bandwidth_limiter: self.bandwidth_limiter,
+            cancellation_token: self.cancellation_token,
+            existence_checked: false,
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::{
+        super::{BucketUploaderBuilder, UploadPolicyBuilder, UploadToken},
+        *,
+    };
+    use crate::{
+        config::ConfigBuilder,
+        credential::Credential,
+        http::{Client, DomainsManagerBuilder, Headers, Method},
+        utils::base64,
+    };
+    use qiniu_http::ResponseBuilder;
+    use qiniu_test_utils::{
+        http_call_mock::{fake_req_id, CallHandlers},
+        temp_file::create_temp_file,
+    };
+    use rayon::ThreadPoolBuilder;
+    use std::{
+        error::Error,
+        io::Cursor,
+        result::Result,
+        sync::atomic::{AtomicBool, AtomicIsize, AtomicUsize, Ordering::SeqCst},
+        thread::{current, sleep},
+        time::Duration,
+    };
+
+    struct FakeParts {
+        part_size: u64,
+        concurrency: usize,
+        remaining: AtomicIsize,
+        uploaded: AtomicUsize,
+    }
+
+    impl FakeParts {
+        fn new(parts_count: isize, part_size: u64, concurrency: usize) -> Self {
+            FakeParts {
+                part_size,
+                concurrency,
+                remaining: AtomicIsize::new(parts_count),
+                uploaded: AtomicUsize::new(0),
+            }
+        }
+    }
+
+    impl PartTasks for FakeParts {
+        fn part_size(&self) -> u64 {
+            self.part_size
+        }
+
+        fn concurrency(&self) -> usize {
+            self.concurrency
+        }
+
+        fn upload_next_part(&self) -> bool {
+            if self.remaining.fetch_sub(1, SeqCst) > 0 {
+                self.uploaded.fetch_add(1, SeqCst);
+                true
+            } else {
+                false
+            }
+        }
+    }
+
+    fn jobs_of_sizes(sizes: &[u64]) -> Vec<BatchUploadJob> {
+        sizes
+            .iter()
+            .map(|&size| BatchUploadJobBuilder::default().upload_stream(Cursor::new(Vec::new()), size, "", None))
+            .collect()
+    }
+
+    fn picked_job_size(task: Option<Task>) -> Option<u64> {
+        match task {
+            Some(Task::Job(job, _)) => Some(job.expected_data_size),
+            Some(Task::Part(..)) => panic!("Unexpected part task"),
+            None => None,
+        }
+    }
+
+    #[test]
+    fn test_storage_uploader_batch_scheduler_small_first() {
+        let scheduler = BatchScheduler::new(
+            jobs_of_sizes(&[8 << 20, 1 << 10, 0, 2 << 20]),
+            FairnessPolicy::SmallFirst,
+            6 << 20,
+            4 << 20,
+        );
+        let mut state = scheduler.state.lock().unwrap();
+        assert_eq!(picked_job_size(scheduler.pick_task(&mut state, true)), Some(1 << 10));
+        assert_eq!(picked_job_size(scheduler.pick_task(&mut state, true)), Some(2 << 20));
+        assert_eq!(state.in_flight_bytes, (2 << 20) + (1 << 10));
+        // 大文件至多按一个分块尺寸计算，但依然将超出数据总量上限
+        assert_eq!(picked_job_size(scheduler.pick_task(&mut state, true)), None);
+
+        state.running_jobs -= 1;
+        state.in_flight_bytes -= 1 << 10;
+        assert_eq!(picked_job_size(scheduler.pick_task(&mut state, true)), Some(8 << 20));
+        assert_eq!(state.in_flight_bytes, 6 << 20);
+        assert_eq!(picked_job_size(scheduler.pick_task(&mut state, false)), None);
+
+        state.running_jobs -= 2;
+        state.in_flight_bytes = 0;
+        assert_eq!(picked_job_size(scheduler.pick_task(&mut state, true)), Some(0));
+        assert!(state.pending_jobs.is_empty());
+    }
+
+    #[test]
+    fn test_storage_uploader_batch_scheduler_round_robin() {
+        let scheduler = BatchScheduler::new(jobs_of_sizes(&[3, 1, 2]), FairnessPolicy::RoundRobin, 0, 4 << 20);
+        let (first_parts, second_parts) = (FakeParts::new(8, 4 << 20, 1), FakeParts::new(8, 4 << 20, 8));
+        let mut state = scheduler.state.lock().unwrap();
+        for (id, parts) in [&first_parts, &second_parts].iter().enumerate() {
+            state.part_sources.push(PartSource {
+                id,
+                tasks: PartTasksRef(unsafe { transmute::<&dyn PartTasks, &(dyn PartTasks + 'static)>(*parts) }),
+                in_flight: 0,
+                exhausted: false,
+            });
+        }
+        let picked = (0..7)
+            .map(|_| match scheduler.pick_task(&mut state, true) {
+                Some(Task::Job(job, _)) => format!("job_{}", job.expected_data_size),
+                Some(Task::Part(id, _, _)) => format!("part_{}", id),
+                None => "none".to_owned(),
+            })
+            .collect::<Vec<_>>();
+        // 第一个分块来源的并发数为 1，因此只有第一轮可以领取到它的分块任务
+        assert_eq!(
+            picked,
+            vec!["job_3", "part_0", "part_1", "job_1", "part_1", "job_2", "part_1"]
+        );
+    }
+
+    #[test]
+    fn test_storage_uploader_batch_scheduler_run_parts() -> Result<(), Box<dyn Error>> {
+        let scheduler = BatchScheduler::new(Vec::new(), FairnessPolicy::SmallFirst, 8 << 20, 4 << 20);
+        let all_parts = (0..4).map(|_| FakeParts::new(16, 4 << 20, 2)).collect::<Vec<_>>();
+        ThreadPoolBuilder::new().num_threads(4).build()?.scope(|s| {
+            for parts in all_parts.iter() {
+                let scheduler = &scheduler;
+                s.spawn(move |_| scheduler.run_parts(parts));
+            }
+        });
+        assert!(all_parts.iter().all(|parts| parts.uploaded.load(SeqCst) == 16));
+        let state = scheduler.state.lock().unwrap();
+        assert_eq!(state.in_flight_bytes, 0);
+        assert!(state.part_sources.is_empty());
+        Ok(())
+    }
+    #[test]
+    fn test_storage_uploader_batch_scheduler_run_parts_within_small_budget() {
+        let scheduler = BatchScheduler::new(jobs_of_sizes(&[8 << 20]), FairnessPolicy::SmallFirst, 6 << 20, 4 << 20);
+        let parts = FakeParts::new(2, 4 << 20, 2);
+        match scheduler.next_task(Until::AllJobsDone) {
+            Some(Task::Job(_, cost)) => {
+                assert_eq!(cost, 4 << 20);
+                let _guard = JobGuard {
+                    scheduler: &scheduler,
+                    cost,
+                };
+                // 文件任务已经占用了一个分块尺寸，再加上一个分块将超出上限，但分块任务依然必须可以执行
+                scheduler.run_parts(&parts);
+            }
+            _ => panic!("Expected job task"),
+        }
+        assert_eq!(parts.uploaded.load(SeqCst), 2);
+        let state = scheduler.state.lock().unwrap();
+        assert_eq!(state.in_flight_bytes, 0);
+        assert_eq!(state.running_jobs, 0);
+        assert!(state.part_sources.is_empty());
+    }
+
+    #[test]
+    fn test_storage_uploader_batch_scheduler_streaming() -> Result<(), Box<dyn Error>> {
+        let scheduler = BatchScheduler::new(Vec::new(), FairnessPolicy::SmallFirst, 0, 4 << 20).streaming(2);
+        for job in jobs_of_sizes(&[3, 1]) {
+            scheduler.submit(job);
+        }
+        let submitted = AtomicBool::new(false);
+        ThreadPoolBuilder::new().num_threads(2).build()?.scope(|s| {
+            s.spawn(|_| {
+                scheduler.submit(jobs_of_sizes(&[2]).pop().unwrap());
+                submitted.store(true, SeqCst);
+            });
+            // 等待上传的任务数量已经达到上限，提交者将阻塞直到有任务开始上传
+            sleep(Duration::from_millis(100));
+            assert!(!submitted.load(SeqCst));
+            assert_eq!(picked_job_size(scheduler.next_task(Until::AllJobsDone)), Some(1));
+        });
+        assert!(submitted.load(SeqCst));
+        assert_eq!(picked_job_size(scheduler.next_task(Until::AllJobsDone)), Some(2));
+        assert_eq!(picked_job_size(scheduler.next_task(Until::AllJobsDone)), Some(3));
+        {
+            let mut state = scheduler.state.lock().unwrap();
+            state.running_jobs = 0;
+            state.in_flight_bytes = 0;
+        }
+        scheduler.drain();
+        scheduler.shutdown();
+        assert_eq!(picked_job_size(scheduler.next_task(Until::AllJobsDone)), None);
+        Ok(())
+    }
+
+    #[test]
+    fn test_storage_uploader_batch_uploader_skip_if_exists() -> Result<(), Box<dyn Error>> {
+        let temp_paths = (0..3)
+            .map(|_| create_temp_file(1 << 10).map(|file| file.into_temp_path()))
+            .collect::<std::io::Result<Vec<_>>>()?;
+        // 临时文件的内容完全一致，因此只有远端 Etag 不同的对象会被上传
+        let etag = etag::from_file(&temp_paths[0])?;
+        let uploaded = Arc::new(AtomicUsize::new(0));
+        let json_response = |body: String| {
+            let mut headers = Headers::new();
+            headers.insert("Content-Type".into(), mime::JSON_MIME.into());
+            headers.insert("X-Reqid".into(), fake_req_id().into());
+            Ok(ResponseBuilder::default()
+                .status_code(200u16)
+                .headers(headers)
+                .bytes_as_body(body)
+                .build())
+        };
+        let config = ConfigBuilder::default()
+            .upload_logger(None)
+            .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+            .http_request_handler(
+                CallHandlers::new(|request| {
+                    panic!("Unexpected Request: {} {}", request.method(), request.url());
+                })
+                .install(Method::POST, "^http://rs.example.com/batch$", {
+                    let etag = etag.to_owned();
+                    move |request, _| {
+                        let ops =
+                            serde_urlencoded::from_bytes::<Vec<(String, String)>>(request.body().as_bytes().unwrap())
+                                .unwrap();
+                        let responses = ops
+                            .into_iter()
+                            .map(|(_, op)| {
+                                assert!(op.starts_with("/stat/"), "Unexpected operation: {}", op);
+                                let stat = |hash: &str| {
+                                    serde_json::json!({"code": 200, "data": {
+                                        "fsize": 1024, "hash": hash, "mimeType": "application/octet-stream",
+                                        "putTime": 15000000000000000u64
+                                    }})
+                                };
+                                let entry = |key: &str| {
+                                    "/stat/".to_owned() + &base64::urlsafe(("test-bucket:".to_owned() + key).as_bytes())
+                                };
+                                if op == entry("unchanged") {
+                                    stat(&etag)
+                                } else if op == entry("modified") {
+                                    stat("FhqTnPSdbCT5Lw2QtS8KK7-bm00n")
+                                } else {
+                                    serde_json::json!({"code": 612, "data": {"error": "no such file or directory"}})
+                                }
+                            })
+                            .collect::<Vec<_>>();
+                        json_response(serde_json::to_string(&responses).unwrap())
+                    }
+                })
+                .install(Method::POST, "^http://up.example.com", {
+                    let uploaded = uploaded.to_owned();
+                    move |_, _| {
+                        uploaded.fetch_add(1, SeqCst);
+                        json_response(r#"{"key":"uploaded","hash":"uploaded"}"#.to_owned())
+                    }
+                }),
+            )
+            .build();
+        let policy = UploadPolicyBuilder::new_policy_for_bucket("test-bucket", &config).build();
+        let credential = Credential::new("abcdefghklmnopq", "1234567890");
+        let bucket_uploader = BucketUploaderBuilder::new(
+            "test-bucket".into(),
+            vec![vec![Box::from("http://up.example.com")].into()].into(),
+            config.to_owned(),
+        )
+        .build();
+        let mut batch_uploader =
+            bucket_uploader.batch_for_upload_token(UploadToken::new(policy, credential.to_owned()).to_string());
+        let mut batch_operations = BatchOperations::new(
+            "test-bucket".into(),
+            credential,
+            Client::new(config),
+            vec!["http://rs.example.com".into()].into(),
+        );
+        // 批量操作生成器中已经添加的操作将被忽略
+        batch_operations.delete("unchanged");
+        batch_uploader
+            .thread_pool_size(2)
+            .etag_cache(EtagCache::new())
+            .skip_if_exists(batch_operations);
+        let skipped = Arc::new(Mutex::new(Vec::new()));
+        for (key, path) in ["unchanged", "modified", "absent"].iter().zip(temp_paths.iter()) {
+            let skipped = skipped.to_owned();
+            batch_uploader.push_job(
+                BatchUploadJobBuilder::default()
+                    .key(*key)
+                    .on_completed(move |result| {
+                        let response = result.unwrap();
+                        if response.is_skipped() {
+                            skipped.lock().unwrap().push(response.key().unwrap().to_owned());
+                        }
+                    })
+                    .upload_file(path, "", None)?,
+            );
+        }
+        batch_uploader.push_job(BatchUploadJobBuilder::default().key("stream").upload_stream(
+            Cursor::new(vec![0u8; 1 << 10]),
+            1 << 10,
+            "",
+            None,
+        ));
+        batch_uploader.start();
+        assert_eq!(&*skipped.lock().unwrap(), &["unchanged".to_owned()]);
+        assert_eq!(uploaded.load(SeqCst), 3);
+        Ok(())
+    }
+
+    #[test]
+    fn test_storage_uploader_batch_uploader_shared_thread_pool() -> Result<(), Box<dyn Error>> {
+        let config = ConfigBuilder::default()
+            .upload_logger(None)
+            .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+            .http_request_handler(
+                CallHandlers::new(|request| {
+                    panic!("Unexpected Request: {} {}", request.method(), request.url());
+                })
+                .install(Method::POST, "^http://up.example.com", |_, _| {
+                    let mut headers = Headers::new();
+                    headers.insert("Content-Type".into(), mime::JSON_MIME.into());
+                    headers.insert("X-Reqid".into(), fake_req_id().into());
+                    Ok(ResponseBuilder::default()
+                        .status_code(200u16)
+                        .headers(headers)
+                        .bytes_as_body(r#"{"key":"uploaded","hash":"uploaded"}"#)
+                        .build())
+                }),
+            )
+            .build();
+        let policy = UploadPolicyBuilder::new_policy_for_bucket("test-bucket", &config).build();
+        let upload_token = UploadToken::new(policy, Credential::new("abcdefghklmnopq", "1234567890")).to_string();
+        let bucket_uploader = BucketUploaderBuilder::new(
+            "test-bucket".into(),
+            vec![vec![Box::from("http://up.example.com")].into()].into(),
+            config,
+        )
+        .build();
+        let thread_names = Arc::new(Mutex::new(Vec::new()));
+        for _ in 0..2 {
+            let mut batch_uploader = bucket_uploader.batch_for_upload_token(upload_token.to_owned());
+            batch_uploader.use_shared_thread_pool(true);
+            let thread_names = thread_names.to_owned();
+            batch_uploader.push_job(
+                BatchUploadJobBuilder::default()
+                    .key("stream")
+                    .on_completed(move |result| {
+                        result.unwrap();
+                        thread_names
+                            .lock()
+                            .unwrap()
+                            .push(current().name().unwrap_or_default().to_owned());
+                    })
+                    .upload_stream(Cursor::new(vec![0u8; 1 << 10]), 1 << 10, "", None),
+            );
+            batch_uploader.start();
+        }
+        let thread_names = thread_names.lock().unwrap();
+        assert_eq!(thread_names.len(), 2);
+        assert!(thread_names
+            .iter()
+            .all(|name| name.starts_with("qiniu_ng_shared_upload_worker_")));
+        assert!(Arc::ptr_eq(&shared_upload_thread_pool(), &shared_upload_thread_pool()));
+        Ok(())
+    }
+
+    #[test]
+    fn test_storage_uploader_batch_uploader_spawn_dedicated_thread_pool() -> Result<(), Box<dyn Error>> {
+        let config = ConfigBuilder::default()
+            .upload_logger(None)
+            .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+            .http_request_handler(
+                CallHandlers::new(|request| {
+                    panic!("Unexpected Request: {} {}", request.method(), request.url());
+                })
+                .install(Method::POST, "^http://up.example.com", |_, _| {
+                    let mut headers = Headers::new();
+                    headers.insert("Content-Type".into(), mime::JSON_MIME.into());
+                    headers.insert("X-Reqid".into(), fake_req_id().into());
+                    Ok(ResponseBuilder::default()
+                        .status_code(200u16)
+                        .headers(headers)
+                        .bytes_as_body(r#"{"key":"uploaded","hash":"uploaded"}"#)
+                        .build())
+                }),
+            )
+            .build();
+        let policy = UploadPolicyBuilder::new_policy_for_bucket("test-bucket", &config).build();
+        let upload_token = UploadToken::new(policy, Credential::new("abcdefghklmnopq", "1234567890")).to_string();
+        let bucket_uploader = BucketUploaderBuilder::new(
+            "test-bucket".into(),
+            vec![vec![Box::from("http://up.example.com")].into()].into(),
+            config,
+        )
+        .thread_pool_size(2)
+        .build();
+        let mut batch_uploader = bucket_uploader.batch_for_upload_token(upload_token);
+        batch_uploader.spawn();
+
+        // 后台上传线程不能占用存储空间上传器的线程池，否则这里将永远阻塞
+        let bucket_thread_name = bucket_uploader
+            .thread_pool()
+            .unwrap()
+            .install(|| current().name().unwrap_or_default().to_owned());
+        assert!(!bucket_thread_name.starts_with("qiniu_ng_batch_uploader_worker_"));
+
+        let thread_names = Arc::new(Mutex::new(Vec::new()));
+        {
+            let thread_names = thread_names.to_owned();
+            batch_uploader.push_job(
+                BatchUploadJobBuilder::default()
+                    .key("stream")
+                    .on_completed(move |result| {
+                        result.unwrap();
+                        thread_names
+                            .lock()
+                            .unwrap()
+                            .push(current().name().unwrap_or_default().to_owned());
+                    })
+                    .upload_stream(Cursor::new(vec![0u8; 1 << 10]), 1 << 10, "", None),
+            );
         }
+        batch_uploader.shutdown();
+        let thread_names = thread_names.lock().unwrap();
+        assert_eq!(thread_names.len(), 1);
+        assert!(thread_names[0].starts_with("qiniu_ng_batch_uploader_worker_"));
+        Ok(())
     }
 }
@@ -0,0 +1,74 @@
+//! 基准测试辅助模块
+//!
+//! 仅在启用 `benchmark` 功能时编译，为 `benches` 目录下的基准测试暴露上传器的内部组件，不属于公开 API
+
+use super::{
+    buffer_pool::BufferPool,
+    io_status_manager::{IOStatusManager, Result as IOStatusResult},
+    BucketUploaderBuilder,
+};
+use crate::{config::Config, utils::mmap};
+use rayon::ThreadPool;
+use std::{
+    fs::File,
+    io::{Error, ErrorKind, Result},
+    sync::atomic::{AtomicUsize, Ordering::Relaxed},
+};
+
+/// 分块读取方式
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum PartReadMode {
+    /// 所有线程争用同一个读取器，依次读出分块
+    Sequential,
+    /// 每个线程按位置读取各自领取的分块
+    Positional,
+    /// 每个线程直接借用内存映射中各自领取的分块
+    Mapped,
+}
+
+/// 使用指定的上传地址创建存储空间上传器生成器，无需查询存储空间所在区域
+pub fn bucket_uploader_builder(bucket_name: &str, up_urls: &[&str], config: Config) -> BucketUploaderBuilder {
+    let up_urls = up_urls.iter().map(|&url| url.into()).collect::<Box<[Box<str>]>>();
+    BucketUploaderBuilder::new(bucket_name.into(), vec![up_urls].into(), config)
+}
+
+/// 在指定线程池的所有线程中并发读出文件的全部分块，返回读出的分块数量
+///
+/// 分块数据读出后即被丢弃，缓冲区将归还缓冲区池，这与分片上传时读取分块的过程一致
+pub fn read_all_parts(
+    file: &File,
+    file_size: u64,
+    block_size: u32,
+    mode: PartReadMode,
+    thread_pool: &ThreadPool,
+) -> Result<usize> {
+    let buffer_pool = BufferPool::new(block_size as usize * thread_pool.current_num_threads());
+    let mapped = match mode {
+        PartReadMode::Mapped => Some(
+            mmap::map(file, file_size).ok_or_else(|| Error::new(ErrorKind::InvalidInput, "File cannot be mapped"))?,
+        ),
+        _ => None,
+    };
+    let io_status_manager = match (&mapped, mode) {
+        (Some(mapped), _) => IOStatusManager::new_mapped(mapped, &buffer_pool, block_size, &[], false),
+        (None, PartReadMode::Positional) => {
+            IOStatusManager::new_positional(file, &buffer_pool, file_size, block_size, &[], false)
+        }
+        _ => IOStatusManager::new(file, &buffer_pool, block_size, &[], false),
+    };
+    let parts_count = AtomicUsize::new(0);
+    thread_pool.scope(|s| {
+        for _ in 0..thread_pool.current_num_threads() {
+            s.spawn(|_| {
+                while io_status_manager.read().is_some() {
+                    parts_count.fetch_add(1, Relaxed);
+                }
+            });
+        }
+    });
+    match io_status_manager.result() {
+        IOStatusResult::Success => Ok(parts_count.into_inner()),
+        IOStatusResult::IOError(err) => Err(err),
+        IOStatusResult::HTTPError(err) => Err(Error::new(ErrorKind::Other, err.to_string())),
+    }
+}
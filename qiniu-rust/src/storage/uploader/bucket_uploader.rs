@@ -1,16 +1,18 @@
 use super::{
     super::uploader::{UploadPolicy, UploadToken},
-    batch_uploader::BatchUploader,
+    batch_uploader::{BatchScheduler, BatchUploader},
+    buffer_pool::BufferPool,
     form_uploader::FormUploaderBuilder,
     resumable_uploader::{ResumableUploader, ResumableUploaderBuilder},
+    upload_future::UploadFuture,
     upload_recorder::UploadRecorder,
     UploadLogger, UploadResponse,
 };
 use crate::{
     config::Config,
     credential::Credential,
-    http::Client,
-    utils::{rob::Rob, ron::Ron},
+    http::{BandwidthLimiter, CancellationToken, Client},
+    utils::{mmap, rob::Rob, ron::Ron, thread_pool::async_upload_thread_pool},
 };
 use assert_impl::assert_impl;
 use getset::Getters;
@@ -21,7 +23,7 @@ use std::{
     collections::HashMap,
     fs::File,
     io::{Error as IOError, Read, Result as IOResult},
-    path::Path,
+    path::{Path, PathBuf},
     sync::Arc,
 };
 use thiserror::Error;
@@ -36,6 +38,9 @@ pub struct BucketUploaderInner {
     upload_logger: Option<UploadLogger>,
     recorder: UploadRecorder,
     thread_pool: Option<ThreadPool>,
+    buffer_pool: BufferPool,
+    bandwidth_limiter: Option<BandwidthLimiter>,
+    cancellation_token: Option<CancellationToken>,
 }
 
 /// 存储空间上传器
@@ -66,6 +71,15 @@ impl BucketUploader {
     pub(super) fn thread_pool(&self) -> Option<&ThreadPool> {
         self.inner.thread_pool().as_ref()
     }
+    pub(super) fn buffer_pool(&self) -> &BufferPool {
+        self.inner.buffer_pool()
+    }
+    pub(super) fn bandwidth_limiter(&self) -> Option<&BandwidthLimiter> {
+        self.inner.bandwidth_limiter().as_ref()
+    }
+    pub(super) fn cancellation_token(&self) -> Option<&CancellationToken> {
+        self.inner.cancellation_token().as_ref()
+    }
 }
 
 /// 存储空间上传器生成器
@@ -85,6 +99,9 @@ impl BucketUploaderBuilder {
                 bucket_name,
                 up_urls_list,
                 thread_pool: None,
+                buffer_pool: BufferPool::new(0),
+                bandwidth_limiter: None,
+                cancellation_token: None,
                 recorder: config.upload_recorder().to_owned(),
                 upload_logger: config.upload_logger().to_owned(),
                 http_client: Client::new(config),
@@ -109,12 +126,46 @@ impl BucketUploaderBuilder {
         )
     }
 
+    /// 为存储空间上传器的所有上传指定带宽限制器
+    ///
+    /// 带宽限制器可以被多个存储空间上传器共用，以限制它们的总上传速率，
+    /// 之后调用 `BandwidthLimiter::set_rate()` 调整速率将立即对正在进行的上传生效
+    pub fn bandwidth_limiter(mut self, bandwidth_limiter: BandwidthLimiter) -> BucketUploaderBuilder {
+        self.inner.bandwidth_limiter = Some(bandwidth_limiter);
+        self
+    }
+
+    /// 为存储空间上传器的所有上传指定取消令牌
+    ///
+    /// 取消令牌被取消后，所有正在进行的上传都将尽快中止，并返回用户取消错误，之后的上传也将不再进行
+    pub fn cancellation_token(mut self, cancellation_token: CancellationToken) -> BucketUploaderBuilder {
+        self.inner.cancellation_token = Some(cancellation_token);
+        self
+    }
+
     /// 生成存储空间上传器
-    pub fn build(self) -> BucketUploader {
+    pub fn build(mut self) -> BucketUploader {
+        self.inner.buffer_pool = BufferPool::new(self.buffer_pool_max_size());
         BucketUploader {
             inner: Arc::new(self.inner),
         }
     }
+
+    /// 缓冲区池最多缓存每个线程一个上传分块，且不超过配置中的上限
+    fn buffer_pool_max_size(&self) -> usize {
+        let config = self.inner.http_client.config();
+        let num_threads = self
+            .inner
+            .thread_pool
+            .as_ref()
+            .map(|thread_pool| thread_pool.current_num_threads())
+            .or_else(|| sys_info::cpu_num().ok().map(|cpu_num| cpu_num as usize))
+            .unwrap_or(1);
+        usize::min(
+            num_threads.saturating_mul(config.upload_block_size() as usize),
+            config.upload_buffer_pool_max_size(),
+        )
+    }
 }
 
 impl BucketUploader {
@@ -123,6 +174,13 @@ impl BucketUploader {
         FileUploaderBuilder::new(Ron::Referenced(self), upload_token.into().to_string().into())
     }
 
+    /// 根据上传凭证创建不借用存储空间上传器的文件上传器生成器
+    ///
+    /// 生成器将持有存储空间上传器的克隆，因此可以调用 `upload_file_async()` 或 `upload_stream_async()` 在后台上传
+    pub fn upload_token_owned(&self, upload_token: impl Into<String>) -> FileUploaderBuilder<'static> {
+        FileUploaderBuilder::new(Ron::Owned(self.to_owned()), upload_token.into().into())
+    }
+
     /// 根据上传策略创建文件上传器生成器
     pub fn upload_policy<'b>(
         &'b self,
@@ -184,11 +242,17 @@ pub struct FileUploaderBuilder<'b> {
     vars: HashMap<Cow<'b, str>, Cow<'b, str>>,
     metadata: HashMap<Cow<'b, str>, Cow<'b, str>>,
     checksum_enabled: bool,
+    local_etag_enabled: bool,
+    adaptive_part_size_enabled: bool,
+    memory_mapping_enabled: bool,
     resumable_policy: ResumablePolicy,
     #[allow(clippy::type_complexity)]
     on_uploading_progress: Option<Rob<'b, dyn Fn(u64, Option<u64>) + Send + Sync>>,
     thread_pool: Option<Ron<'b, ThreadPool>>,
+    batch_scheduler: Option<&'b BatchScheduler>,
     max_concurrency: usize,
+    bandwidth_limiter: Option<BandwidthLimiter>,
+    cancellation_token: Option<CancellationToken>,
 }
 
 impl<'b> FileUploaderBuilder<'b> {
@@ -199,9 +263,15 @@ impl<'b> FileUploaderBuilder<'b> {
             vars: HashMap::new(),
             metadata: HashMap::new(),
             checksum_enabled: true,
+            local_etag_enabled: false,
+            adaptive_part_size_enabled: false,
+            memory_mapping_enabled: false,
             on_uploading_progress: None,
             thread_pool: None,
+            batch_scheduler: None,
             max_concurrency: 0,
+            bandwidth_limiter: bucket_uploader.bandwidth_limiter().cloned(),
+            cancellation_token: bucket_uploader.cancellation_token().map(|token| token.child_token()),
             resumable_policy: ResumablePolicy::Threshold(bucket_uploader.http_client().config().upload_threshold()),
             bucket_uploader,
         }
@@ -224,6 +294,12 @@ impl<'b> FileUploaderBuilder<'b> {
         )
     }
 
+    /// 由批量上传调度器调度分片上传的分块任务，而不是在线程池内为每个文件各自创建上传线程
+    pub(super) fn batch_scheduler(mut self, batch_scheduler: &'b BatchScheduler) -> Self {
+        self.batch_scheduler = Some(batch_scheduler);
+        self
+    }
+
     /// 上传文件最大并发度
     ///
     /// 默认情况下，分片上传将采用多线程并发的方式进行上传，最大并发度等于文件上传器内线程池的大小。
@@ -233,6 +309,23 @@ impl<'b> FileUploaderBuilder<'b> {
         self
     }
 
+    /// 为本次上传指定带宽限制器
+    ///
+    /// 默认使用存储空间上传器的带宽限制器，调用该方法将替换之
+    pub fn bandwidth_limiter(mut self, bandwidth_limiter: BandwidthLimiter) -> Self {
+        self.bandwidth_limiter = Some(bandwidth_limiter);
+        self
+    }
+
+    /// 为本次上传指定取消令牌
+    ///
+    /// 默认使用存储空间上传器的取消令牌，调用该方法将替换之。
+    /// 如果希望存储空间上传器的取消令牌依然生效，可以传入由其创建的子令牌
+    pub fn cancellation_token(mut self, cancellation_token: CancellationToken) -> Self {
+        self.cancellation_token = Some(cancellation_token);
+        self
+    }
+
     /// 指定上传对象的名称
     pub fn key(mut self, key: impl Into<Cow<'b, str>>) -> Self {
         self.key = Some(key.into());
@@ -271,6 +364,61 @@ impl<'b> FileUploaderBuilder<'b> {
         self
     }
 
+    /// 启用本地 Etag 计算
+    ///
+    /// 启用后，将在读取上传数据的同时计算数据的 Etag，无需为了校验上传结果而预先再读取一遍数据。
+    /// 计算结果可以通过 `UploadResponse::local_etag()` 获取，以便与服务器返回的 `hash` 进行比较。
+    ///
+    /// 分片上传时，本地 Etag 由各个分块的 SHA-1 值合并得到，因此仅当每个分块（最后一个分块除外）都与 4 MB 的 Etag 块对齐时才能计算。
+    /// 如果分块尺寸 `Config::upload_block_size()` 不是 4 MB 的整数倍且未启用分块自适应调节，
+    /// 或断点续传时已经上传的分块未与 Etag 块对齐，将不会计算本地 Etag，`UploadResponse::local_etag()` 将返回 `None`，
+    /// 依赖本地 Etag 的校验也将不会进行。
+    /// 默认不启用
+    pub fn enable_local_etag(mut self) -> Self {
+        self.local_etag_enabled = true;
+        self
+    }
+
+    /// 禁用本地 Etag 计算
+    pub fn disable_local_etag(mut self) -> Self {
+        self.local_etag_enabled = false;
+        self
+    }
+
+    /// 启用分片上传时的分块自适应调节
+    ///
+    /// 启用后，将根据已上传分块的耗时测算上传吞吐量和往返时延，据此调节之后分块的尺寸以及同时上传的分块数：
+    /// 在高速链路上使用更大的分块和更多的并发，在高延迟或丢包严重的链路上则减小分块尺寸和并发数。
+    /// 分块尺寸始终在分片上传的限制范围内，最大并发度仍由 `max_concurrency()` 或线程池大小决定。
+    /// 续传时已上传的分块将保持其原有的尺寸。
+    /// 默认不启用，此时所有分块的尺寸均为客户端配置中的分块尺寸
+    pub fn enable_adaptive_part_size(mut self) -> Self {
+        self.adaptive_part_size_enabled = true;
+        self
+    }
+
+    /// 禁用分片上传时的分块自适应调节
+    pub fn disable_adaptive_part_size(mut self) -> Self {
+        self.adaptive_part_size_enabled = false;
+        self
+    }
+
+    /// 上传文件时将其映射到内存
+    ///
+    /// 启用后，表单上传将直接在映射区域上计算 CRC32 和 Etag，分片上传的分块也直接借用映射区域，避免将文件内容复制到缓冲区。
+    /// 默认不启用，此时文件将按位置读取。
+    /// 仅当可以确保上传期间文件不会被截断时才能启用：映射期间如果文件被其他进程截断，访问被截断的部分将导致进程收到 `SIGBUS` 信号而崩溃
+    pub fn enable_memory_mapping(mut self) -> Self {
+        self.memory_mapping_enabled = true;
+        self
+    }
+
+    /// 上传文件时不将其映射到内存
+    pub fn disable_memory_mapping(mut self) -> Self {
+        self.memory_mapping_enabled = false;
+        self
+    }
+
     /// 指定分片上传策略阙值
     ///
     /// 对于上传文件的情况，如果文件尺寸大于该值，将自动使用分片上传，否则，使用表单上传。
@@ -381,7 +529,9 @@ impl<'b> FileUploaderBuilder<'b> {
     }
 
     fn upload_file_by_form<'n>(self, file_path: &Path, file_name: Cow<'n, str>, mime: Option<Mime>) -> UploadResult {
-        let mut uploader = FormUploaderBuilder::new(&self.bucket_uploader, &self.upload_token);
+        let mut uploader = FormUploaderBuilder::new(&self.bucket_uploader, &self.upload_token)
+            .bandwidth_limiter(self.bandwidth_limiter.as_ref())
+            .cancellation_token(self.cancellation_token.as_ref());
         if let Some(key) = self.key {
             uploader = uploader.key(key);
         }
@@ -394,14 +544,31 @@ impl<'b> FileUploaderBuilder<'b> {
         if let Some(callback) = &self.on_uploading_progress {
             uploader = uploader.on_uploading_progress(callback.as_ref());
         }
-        Ok(uploader
-            .seekable_stream(
-                File::open(file_path)?,
+        let file = File::open(file_path)?;
+        let file_size = file.metadata()?.len();
+        // 启用内存映射时，CRC32 和 Etag 均直接在映射区域上计算，避免先将整个文件读入内存；未启用或无法映射时读取文件
+        let mapped = if self.memory_mapping_enabled {
+            mmap::map(&file, file_size)
+        } else {
+            None
+        };
+        let uploader = match &mapped {
+            Some(mapped) => uploader.bytes(
+                mapped,
                 Self::guess_filename(file_path, file_name),
                 Self::guess_mime_from_file_path(mime, file_path),
                 self.checksum_enabled,
-            )?
-            .send()?)
+                self.local_etag_enabled,
+            )?,
+            None => uploader.seekable_stream(
+                file,
+                Self::guess_filename(file_path, file_name),
+                Self::guess_mime_from_file_path(mime, file_path),
+                self.checksum_enabled,
+                self.local_etag_enabled,
+            )?,
+        };
+        Ok(uploader.send()?)
     }
 
     fn upload_file_by_blocks<'n>(self, file_path: &Path, file_name: Cow<'n, str>, mime: Option<Mime>) -> UploadResult {
@@ -412,7 +579,12 @@ impl<'b> FileUploaderBuilder<'b> {
         }
 
         let mut uploader = ResumableUploaderBuilder::new(&self.bucket_uploader, self.upload_token)
+            .bandwidth_limiter(self.bandwidth_limiter.as_ref())
+            .cancellation_token(self.cancellation_token.as_ref())
             .max_concurrency(self.max_concurrency)
+            .local_etag(self.local_etag_enabled)
+            .adaptive_part_size(self.adaptive_part_size_enabled)
+            .memory_mapping(self.memory_mapping_enabled)
             .vars(self.vars)
             .metadata(self.metadata);
         if let Some(key) = &self.key {
@@ -424,6 +596,9 @@ impl<'b> FileUploaderBuilder<'b> {
         if let Some(thread_pool) = self.thread_pool {
             uploader = uploader.thread_pool(thread_pool);
         }
+        if let Some(batch_scheduler) = self.batch_scheduler {
+            uploader = uploader.batch_scheduler(batch_scheduler);
+        }
         let mut uploader = uploader.file(
             file,
             file_path.into(),
@@ -448,7 +623,8 @@ impl<'b> FileUploaderBuilder<'b> {
         file_path: &Path,
     ) -> IOResult<()> {
         if let Some((file_record, block_records)) = recorder.load(file_path, key)? {
-            uploader.prepare_for_resuming(file_record, block_records, recorder.open_for_appending(file_path, key)?);
+            let medium = recorder.open_for_appending(file_path, key, file_record.format)?;
+            uploader.prepare_for_resuming(file_record, block_records, medium);
         }
         Ok(())
     }
@@ -460,7 +636,9 @@ impl<'b> FileUploaderBuilder<'b> {
         file_name: Cow<str>,
         mime: Option<Mime>,
     ) -> UploadResult {
-        let mut uploader = FormUploaderBuilder::new(&self.bucket_uploader, &self.upload_token);
+        let mut uploader = FormUploaderBuilder::new(&self.bucket_uploader, &self.upload_token)
+            .bandwidth_limiter(self.bandwidth_limiter.as_ref())
+            .cancellation_token(self.cancellation_token.as_ref());
         if let Some(key) = self.key {
             uploader = uploader.key(key);
         }
@@ -475,9 +653,13 @@ impl<'b> FileUploaderBuilder<'b> {
         }
         let mime = Self::guess_mime_from_file_name(mime, file_name.as_ref());
         let upload_response = if size > 0 {
-            uploader.stream(stream.take(size), mime, file_name, None)?.send()?
+            uploader
+                .stream(stream.take(size), mime, file_name, None, self.local_etag_enabled)?
+                .send()?
         } else {
-            uploader.stream(stream, mime, file_name, None)?.send()?
+            uploader
+                .stream(stream, mime, file_name, None, self.local_etag_enabled)?
+                .send()?
         };
         Ok(upload_response)
     }
@@ -490,7 +672,11 @@ impl<'b> FileUploaderBuilder<'b> {
         mime: Option<Mime>,
     ) -> UploadResult {
         let mut uploader = ResumableUploaderBuilder::new(&self.bucket_uploader, self.upload_token)
+            .bandwidth_limiter(self.bandwidth_limiter.as_ref())
+            .cancellation_token(self.cancellation_token.as_ref())
             .max_concurrency(self.max_concurrency)
+            .local_etag(self.local_etag_enabled)
+            .adaptive_part_size(self.adaptive_part_size_enabled)
             .vars(self.vars)
             .metadata(self.metadata);
         if let Some(key) = self.key {
@@ -502,6 +688,9 @@ impl<'b> FileUploaderBuilder<'b> {
         if let Some(thread_pool) = self.thread_pool {
             uploader = uploader.thread_pool(thread_pool);
         }
+        if let Some(batch_scheduler) = self.batch_scheduler {
+            uploader = uploader.batch_scheduler(batch_scheduler);
+        }
         let mime = Self::guess_mime_from_file_name(mime, file_name.as_ref());
         let upload_response = if size > 0 {
             uploader
@@ -538,6 +727,68 @@ impl<'b> FileUploaderBuilder<'b> {
     }
 }
 
+impl FileUploaderBuilder<'static> {
+    /// 在后台上传文件
+    ///
+    /// 与 `upload_file()` 相同，但不会阻塞当前线程，而是立即返回 `UploadFuture`，可以轮询或阻塞等待上传结果。
+    /// 上传将由 SDK 的异步上传线程池驱动，分片依然在存储空间上传器的线程池内并发上传
+    ///
+    /// # Arguments
+    ///
+    /// * `file_path` - 上传文件路径
+    /// * `file_name` - 指定上传文件的文件名称，在下载文件时将会被使用
+    /// * `mime` - 指定文件的 MIME 类型，参照[文档](https://docs.rs/mime/0.3.14/mime/) 传值，如果不填写，七牛服务器将根据上传策略决定 `Content-Type`
+    pub fn upload_file_async(
+        mut self,
+        file_path: impl Into<PathBuf>,
+        file_name: impl Into<String>,
+        mime: Option<Mime>,
+    ) -> UploadFuture {
+        let file_path = file_path.into();
+        let file_name = file_name.into();
+        let cancellation_token = self.async_cancellation_token();
+        UploadFuture::spawn(&async_upload_thread_pool(), cancellation_token, move || {
+            self.upload_file(file_path, file_name, mime)
+        })
+    }
+
+    /// 在后台上传数据流
+    ///
+    /// 与 `upload_stream()` 相同，但不会阻塞当前线程，而是立即返回 `UploadFuture`，可以轮询或阻塞等待上传结果。
+    /// 上传将由 SDK 的异步上传线程池驱动，分片依然在存储空间上传器的线程池内并发上传
+    ///
+    /// # Arguments
+    ///
+    /// * `stream` - 数据流
+    /// * `size` - 数据流最大长度，如果数据流大小不可预知，则传入 `0`。如果传入的值大于 `0`，则最终读取数据量将始终不大于该值。
+    /// * `file_name` - 指定上传文件的文件名称，在下载文件时将会被使用
+    /// * `mime` - 指定文件的 MIME 类型，参照[文档](https://docs.rs/mime/0.3.14/mime/) 传值，如果不填写，七牛服务器将根据上传策略决定 `Content-Type`
+    pub fn upload_stream_async(
+        mut self,
+        stream: impl Read + Send + 'static,
+        size: u64,
+        file_name: impl Into<String>,
+        mime: Option<Mime>,
+    ) -> UploadFuture {
+        let file_name = file_name.into();
+        let cancellation_token = self.async_cancellation_token();
+        UploadFuture::spawn(&async_upload_thread_pool(), cancellation_token, move || {
+            self.upload_stream(stream, size, file_name, mime)
+        })
+    }
+
+    /// 为后台上传创建专用的取消令牌，取消 `UploadFuture` 时将中止正在进行的传输，而已经指定的取消令牌依然生效
+    fn async_cancellation_token(&mut self) -> CancellationToken {
+        let cancellation_token = self
+            .cancellation_token
+            .as_ref()
+            .map(|token| token.child_token())
+            .unwrap_or_default();
+        self.cancellation_token = Some(cancellation_token.to_owned());
+        cancellation_token
+    }
+}
+
 /// 上传错误
 #[derive(Error, Debug)]
 pub enum UploadError {
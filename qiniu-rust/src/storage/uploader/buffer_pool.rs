@@ -0,0 +1,128 @@
+use assert_impl::assert_impl;
+use std::{
+    mem::replace,
+    ops::{Deref, DerefMut},
+    sync::Mutex,
+};
+
+/// 分块缓冲区池
+///
+/// 缓存分片上传时读取分块所用的缓冲区，避免每个分块都重新分配并清零大块内存。
+/// 池内缓存的缓冲区总容量不会超过创建时指定的最大值，超出的缓冲区在归还时将直接释放
+pub(super) struct BufferPool {
+    pooled: Mutex<PooledBuffers>,
+    max_pooled_size: usize,
+}
+
+struct PooledBuffers {
+    buffers: Vec<Vec<u8>>,
+    pooled_size: usize,
+}
+
+/// 从缓冲区池中获取的缓冲区，析构时将自动归还缓冲区池
+pub(super) struct PooledBuffer<'p> {
+    buffer: Vec<u8>,
+    pool: &'p BufferPool,
+}
+
+impl BufferPool {
+    pub(super) fn new(max_pooled_size: usize) -> BufferPool {
+        BufferPool {
+            pooled: Mutex::new(PooledBuffers {
+                buffers: Vec::new(),
+                pooled_size: 0,
+            }),
+            max_pooled_size,
+        }
+    }
+
+    /// 获取一个长度为 `size` 的缓冲区
+    ///
+    /// 优先复用池内容量足够的缓冲区，复用时不会重新清零已有的内容，调用方需要自行覆盖缓冲区内的数据
+    pub(super) fn get(&self, size: usize) -> PooledBuffer {
+        let reused = {
+            let mut pooled = self.pooled.lock().unwrap();
+            let index = pooled.buffers.iter().position(|buffer| buffer.capacity() >= size);
+            index.map(|index| {
+                let buffer = pooled.buffers.swap_remove(index);
+                pooled.pooled_size -= buffer.capacity();
+                buffer
+            })
+        };
+        let mut buffer = reused.unwrap_or_else(|| Vec::with_capacity(size));
+        buffer.resize(size, 0);
+        PooledBuffer { buffer, pool: self }
+    }
+
+    /// 池内当前缓存的缓冲区总容量，单位为字节
+    pub(super) fn pooled_size(&self) -> usize {
+        self.pooled.lock().unwrap().pooled_size
+    }
+
+    fn put(&self, buffer: Vec<u8>) {
+        if buffer.capacity() == 0 {
+            return;
+        }
+        let mut pooled = self.pooled.lock().unwrap();
+        if pooled.pooled_size + buffer.capacity() <= self.max_pooled_size {
+            pooled.pooled_size += buffer.capacity();
+            pooled.buffers.push(buffer);
+        }
+    }
+
+    #[allow(dead_code)]
+    fn ignore() {
+        assert_impl!(Send: Self);
+        assert_impl!(Sync: Self);
+    }
+}
+
+impl Deref for PooledBuffer<'_> {
+    type Target = Vec<u8>;
+
+    fn deref(&self) -> &Self::Target {
+        &self.buffer
+    }
+}
+
+impl DerefMut for PooledBuffer<'_> {
+    fn deref_mut(&mut self) -> &mut Self::Target {
+        &mut self.buffer
+    }
+}
+
+impl Drop for PooledBuffer<'_> {
+    fn drop(&mut self) {
+        self.pool.put(replace(&mut self.buffer, Vec::new()));
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_storage_uploader_buffer_pool() {
+        let pool = BufferPool::new(2 * (1 << 22));
+        {
+            let first = pool.get(1 << 22);
+            let second = pool.get(1 << 22);
+            let third = pool.get(1 << 22);
+            assert_eq!(first.len(), 1 << 22);
+            assert_eq!(pool.pooled_size(), 0);
+            drop(first);
+            drop(second);
+            drop(third);
+        }
+        assert_eq!(pool.pooled_size(), 2 * (1 << 22));
+        {
+            let mut reused = pool.get(1 << 20);
+            assert_eq!(reused.len(), 1 << 20);
+            assert!(reused.capacity() >= 1 << 22);
+            assert_eq!(pool.pooled_size(), 1 << 22);
+            reused.resize(1 << 22, 0);
+        }
+        assert_eq!(pool.pooled_size(), 2 * (1 << 22));
+        assert_eq!(BufferPool::new(0).get(1 << 10).len(), 1 << 10);
+    }
+}
@@ -17,3 +17,8 @@ pub(super) fn upload_response_callback(response: &mut Response) -> HTTPResult<()
 fn with_reqid(response: &mut Response) -> bool {
     response.header("X-ReqId").is_some()
 }
+
+/// 取消令牌被取消后返回的用户取消错误
+pub(super) fn user_canceled_error() -> HTTPError {
+    HTTPError::new_unretryable_error(HTTPErrorKind::UserCanceled, None, None, None)
+}
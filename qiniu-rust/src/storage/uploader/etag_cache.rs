@@ -0,0 +1,301 @@
+use crate::utils::{
+    etag, mmap,
+    snapshot::{is_snapshot, SnapshotReader, SnapshotWriter},
+};
+use assert_impl::assert_impl;
+use rayon::ThreadPool;
+use std::{
+    collections::HashMap,
+    fmt,
+    fs::{File, Metadata},
+    io::{ErrorKind, Read, Result, Write},
+    path::{Path, PathBuf},
+    sync::{
+        atomic::{AtomicBool, Ordering::Relaxed},
+        Arc, Mutex, RwLock,
+    },
+    time::SystemTime,
+};
+use tempfile::NamedTempFile;
+
+const SNAPSHOT_MAGIC: &[u8; 4] = b"QNEC";
+const SNAPSHOT_VERSION: u32 = 1;
+
+#[derive(Debug, Clone, PartialEq, Eq)]
+struct Entry {
+    size: u64,
+    modified: SystemTime,
+    etag: Box<str>,
+}
+
+struct EtagCacheInner {
+    entries: RwLock<HashMap<PathBuf, Entry>>,
+    file_path: Option<PathBuf>,
+    persistent_lock: Mutex<()>,
+    dirty: AtomicBool,
+}
+
+/// 本地 Etag 缓存
+///
+/// 以文件路径，文件尺寸和文件修改时间为键记录文件的 Etag，三者均未改变的文件将直接使用缓存的 Etag 而无需再次读取文件。
+/// 批量上传器在跳过已经存在的对象时，将使用该缓存避免重复计算未改变的文件的 Etag。
+///
+/// 缓存可以持久化到文件中，以便在下一次同步同一个目录时复用
+#[derive(Clone)]
+pub struct EtagCache {
+    inner: Arc<EtagCacheInner>,
+}
+
+impl EtagCache {
+    /// 创建仅保存在内存中的 Etag 缓存
+    pub fn new() -> Self {
+        Self::with_entries(HashMap::new(), None)
+    }
+
+    /// 从指定的持久化文件中加载 Etag 缓存
+    ///
+    /// 如果文件不存在，或文件内容无效，将创建空的缓存。
+    /// 调用 `persistent()` 方法，或批量上传器完成一批任务后，缓存将被写回该文件
+    pub fn load(file_path: impl Into<PathBuf>) -> Result<Self> {
+        let file_path = file_path.into();
+        let entries = match File::open(&file_path) {
+            Ok(mut file) => {
+                let file_size = file.metadata()?.len();
+                match mmap::map(&file, file_size) {
+                    Some(mapped) => Self::entries_from_bytes(&mapped),
+                    None => {
+                        let mut buf = Vec::new();
+                        file.read_to_end(&mut buf)?;
+                        Self::entries_from_bytes(&buf)
+                    }
+                }
+            }
+            Err(ref err) if err.kind() == ErrorKind::NotFound => HashMap::new(),
+            Err(err) => return Err(err),
+        };
+        Ok(Self::with_entries(entries, Some(file_path)))
+    }
+
+    fn with_entries(entries: HashMap<PathBuf, Entry>, file_path: Option<PathBuf>) -> Self {
+        EtagCache {
+            inner: Arc::new(EtagCacheInner {
+                entries: RwLock::new(entries),
+                file_path,
+                persistent_lock: Mutex::new(()),
+                dirty: AtomicBool::new(false),
+            }),
+        }
+    }
+
+    /// 缓存中记录的文件数量
+    pub fn len(&self) -> usize {
+        self.inner.entries.read().unwrap().len()
+    }
+
+    /// 缓存是否为空
+    pub fn is_empty(&self) -> bool {
+        self.inner.entries.read().unwrap().is_empty()
+    }
+
+    /// 持久化文件路径
+    pub fn file_path(&self) -> Option<&Path> {
+        self.inner.file_path.as_ref().map(|path| path.as_path())
+    }
+
+    /// 获取文件的 Etag
+    ///
+    /// 如果文件尺寸和修改时间与缓存记录一致，则直接返回缓存的 Etag，否则计算 Etag 并更新缓存。
+    /// 指定线程池时将在线程池中并行计算，否则在当前线程中计算
+    pub(super) fn etag_of(&self, path: &Path, thread_pool: Option<&ThreadPool>) -> Result<String> {
+        let metadata = path.metadata()?;
+        let modified = match metadata.modified() {
+            Ok(modified) => modified,
+            // 无法获取修改时间的文件无法判断是否改变，总是重新计算
+            Err(_) => return Self::compute(path, thread_pool),
+        };
+        if let Some(entry) = self.inner.entries.read().unwrap().get(path) {
+            if entry.size == metadata.len() && entry.modified == modified {
+                return Ok(entry.etag.to_string());
+            }
+        }
+        let etag = Self::compute(path, thread_pool)?;
+        // 计算期间文件被修改过的，不写入缓存
+        if Self::is_unchanged(path, &metadata, modified) {
+            self.inner.entries.write().unwrap().insert(
+                path.to_owned(),
+                Entry {
+                    size: metadata.len(),
+                    modified,
+                    etag: etag.as_str().into(),
+                },
+            );
+            self.inner.dirty.store(true, Relaxed);
+        }
+        Ok(etag)
+    }
+
+    fn compute(path: &Path, thread_pool: Option<&ThreadPool>) -> Result<String> {
+        match thread_pool {
+            Some(thread_pool) => etag::from_file_in_parallel(path, thread_pool),
+            None => etag::from_file(path),
+        }
+    }
+
+    fn is_unchanged(path: &Path, metadata: &Metadata, modified: SystemTime) -> bool {
+        path.metadata()
+            .ok()
+            .filter(|current| current.len() == metadata.len())
+            .and_then(|current| current.modified().ok())
+            .map_or(false, |current| current == modified)
+    }
+
+    /// 将缓存写入持久化文件
+    ///
+    /// 如果没有指定持久化文件，将返回 `None`。缓存自上次持久化以来没有变化时，将不会写入文件
+    pub fn persistent(&self) -> Option<Result<()>> {
+        self.inner.file_path.as_ref().map(|file_path| {
+            let _guard = self.inner.persistent_lock.lock().unwrap();
+            if !self.inner.dirty.swap(false, Relaxed) {
+                return Ok(());
+            }
+            Self::write_file(file_path, &self.to_snapshot()).map_err(|err| {
+                self.inner.dirty.store(true, Relaxed);
+                err
+            })
+        })
+    }
+
+    fn to_snapshot(&self) -> Vec<u8> {
+        let entries = self.inner.entries.read().unwrap();
+        let mut writer = SnapshotWriter::new();
+        // 无法以 UTF-8 表示的路径不会被持久化
+        let entries = entries
+            .iter()
+            .filter_map(|(path, entry)| path.to_str().map(|path| (path, entry)))
+            .collect::<Vec<_>>();
+        writer.put_len(entries.len());
+        for (path, entry) in entries {
+            writer
+                .put_str(path)
+                .put_u64(entry.size)
+                .put_system_time(entry.modified)
+                .put_str(&entry.etag);
+        }
+        writer.finish(SNAPSHOT_MAGIC, SNAPSHOT_VERSION)
+    }
+
+    /// 缓存总是可以重新计算，因此无效的持久化数据将被直接丢弃
+    fn entries_from_bytes(bytes: &[u8]) -> HashMap<PathBuf, Entry> {
+        if !is_snapshot(bytes, SNAPSHOT_MAGIC) {
+            return HashMap::new();
+        }
+        Self::entries_from_snapshot(bytes).unwrap_or_default()
+    }
+
+    fn entries_from_snapshot(bytes: &[u8]) -> Result<HashMap<PathBuf, Entry>> {
+        let mut reader = SnapshotReader::new(bytes, SNAPSHOT_MAGIC, SNAPSHOT_VERSION)?;
+        let count = reader.get_len()?;
+        let mut entries = HashMap::with_capacity(count);
+        for _ in 0..count {
+            let path = PathBuf::from(reader.get_str()?);
+            let entry = Entry {
+                size: reader.get_u64()?,
+                modified: reader.get_system_time()?,
+                etag: reader.get_str()?.into(),
+            };
+            entries.insert(path, entry);
+        }
+        Ok(entries)
+    }
+
+    /// 优先写入同一目录下的临时文件，再将其原子地重命名为持久化文件
+    fn write_file(path: &Path, content: &[u8]) -> Result<()> {
+        let dir = path
+            .parent()
+            .filter(|dir| !dir.as_os_str().is_empty())
+            .unwrap_or_else(|| Path::new("."));
+        match NamedTempFile::new_in(dir) {
+            Ok(mut temp_file) => {
+                temp_file.write_all(content)?;
+                temp_file.as_file().sync_data()?;
+                temp_file.persist(path).map_err(|err| err.error)?;
+                Ok(())
+            }
+            Err(_) => File::create(path)?.write_all(content),
+        }
+    }
+
+    #[allow(dead_code)]
+    fn ignore() {
+        assert_impl!(Send: Self);
+        assert_impl!(Sync: Self);
+    }
+}
+
+impl Default for EtagCache {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl fmt::Debug for EtagCache {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_struct("EtagCache")
+            .field("len", &self.len())
+            .field("file_path", &self.inner.file_path)
+            .finish()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use qiniu_test_utils::temp_file::create_temp_file;
+    use rayon::ThreadPoolBuilder;
+    use std::{error::Error, fs::OpenOptions, result::Result};
+    use tempfile::tempdir;
+
+    #[test]
+    fn test_etag_cache_hits_and_persistent() -> Result<(), Box<dyn Error>> {
+        let thread_pool = ThreadPoolBuilder::new().num_threads(2).build()?;
+        let temp_path = create_temp_file((1 << 22) + 1)?.into_temp_path();
+        let expected_etag = etag::from_file(&temp_path)?;
+        let dir = tempdir()?;
+        let cache_path = dir.path().join("etag_cache");
+
+        let cache = EtagCache::load(&cache_path)?;
+        assert!(cache.is_empty());
+        assert_eq!(cache.etag_of(&temp_path, Some(&thread_pool))?, expected_etag);
+        assert_eq!(cache.len(), 1);
+        assert!(cache.persistent().unwrap().is_ok());
+        assert!(cache_path.exists());
+
+        let cache = EtagCache::load(&cache_path)?;
+        assert_eq!(cache.len(), 1);
+        assert_eq!(
+            cache
+                .inner
+                .entries
+                .read()
+                .unwrap()
+                .get(&temp_path.to_path_buf())
+                .unwrap()
+                .etag
+                .as_ref(),
+            expected_etag.as_str()
+        );
+        // 修改文件后，缓存记录将失效
+        OpenOptions::new().append(true).open(&temp_path)?.write_all(b"x")?;
+        assert_eq!(
+            cache.etag_of(&temp_path, Some(&thread_pool))?,
+            etag::from_file(&temp_path)?
+        );
+        assert_ne!(cache.etag_of(&temp_path, Some(&thread_pool))?, expected_etag);
+        assert_eq!(cache.len(), 1);
+
+        std::fs::write(&cache_path, b"invalid")?;
+        assert!(EtagCache::load(&cache_path)?.is_empty());
+        assert!(EtagCache::new().persistent().is_none());
+        Ok(())
+    }
+}
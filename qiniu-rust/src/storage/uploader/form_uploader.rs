@@ -3,63 +3,92 @@ use super::{
     UploadResponse,
 };
 use crate::{
-    http::{Error as HTTPError, Result as HTTPResult, RetryKind},
-    utils::crc32,
+    http::{BandwidthLimiter, CancellationToken, Error as HTTPError, Result as HTTPResult, RetryKind},
+    utils::{crc32, etag},
 };
 use mime::Mime;
-use qiniu_multipart::client::lazy::Multipart;
+use qiniu_http::RequestBodyStream;
+use rand::{distributions::Alphanumeric, thread_rng, Rng};
 use serde_json::Value;
 use std::{
     borrow::Cow,
+    cell::{Cell, RefCell},
     convert::TryInto,
-    io::{Read, Seek, SeekFrom},
+    io::{copy, sink, Cursor, Error as IOError, ErrorKind as IOErrorKind, Read, Result as IOResult, Seek, SeekFrom},
     result::Result,
 };
 
 pub(super) struct FormUploaderBuilder<'u> {
     bucket_uploader: &'u BucketUploader,
-    multipart: Multipart<'u, 'u>,
+    boundary: String,
+    fields: Vec<u8>,
     on_uploading_progress: Option<&'u dyn Fn(u64, Option<u64>)>,
     upload_logger: Option<TokenizedUploadLogger>,
+    local_etag: Option<Box<str>>,
+    bandwidth_limiter: Option<&'u BandwidthLimiter>,
+    cancellation_token: Option<&'u CancellationToken>,
 }
 
 pub(super) struct FormUploader<'u> {
     bucket_uploader: &'u BucketUploader,
     content_type: String,
-    body: Vec<u8>,
+    body: MultipartBody<'u>,
     on_uploading_progress: Option<&'u dyn Fn(u64, Option<u64>)>,
     upload_logger: Option<TokenizedUploadLogger>,
+    local_etag: Option<Box<str>>,
+    cancellation_token: Option<&'u CancellationToken>,
 }
 
+/// 表单上传的请求体
+///
+/// 内存中仅保存表单字段和分隔符，文件内容在发送请求时才从数据流中按需读出，重试时倒回数据流重新读取。
+/// 读出文件内容时由带宽限制器限速，取消令牌被取消后读取将出错，HTTP 客户端随之中止请求
+struct MultipartBody<'u> {
+    head: Vec<u8>,
+    tail: Vec<u8>,
+    file: RefCell<Box<dyn ReadSeek + 'u>>,
+    file_start: u64,
+    file_size: u64,
+    position: Cell<u64>,
+    bandwidth_limiter: Option<&'u BandwidthLimiter>,
+    cancellation_token: Option<&'u CancellationToken>,
+}
+
+trait ReadSeek: Read + Seek {}
+impl<T: Read + Seek> ReadSeek for T {}
+
 impl<'u> FormUploaderBuilder<'u> {
     pub(super) fn new(bucket_uploader: &'u BucketUploader, upload_token: &'u str) -> FormUploaderBuilder<'u> {
         let mut uploader = FormUploaderBuilder {
             bucket_uploader,
-            multipart: Multipart::new(),
+            boundary: thread_rng().sample_iter(&Alphanumeric).take(32).collect(),
+            fields: Vec::new(),
             on_uploading_progress: None,
             upload_logger: bucket_uploader.upload_logger().map(|upload_logger| {
                 upload_logger.tokenize(upload_token.into(), bucket_uploader.http_client().to_owned())
             }),
+            local_etag: None,
+            bandwidth_limiter: None,
+            cancellation_token: None,
         };
-        uploader.multipart.add_text("token", upload_token);
+        uploader.add_text("token", upload_token);
         uploader
     }
 
     pub(super) fn key(mut self, key: Cow<'u, str>) -> FormUploaderBuilder<'u> {
         if !key.is_empty() {
-            self.multipart.add_text("key", key);
+            self.add_text("key", &key);
         }
         self
     }
 
     pub(super) fn var(mut self, var_key: &str, var_value: Cow<'u, str>) -> FormUploaderBuilder<'u> {
-        self.multipart.add_text("x:".to_owned() + var_key, var_value);
+        self.add_text(&("x:".to_owned() + var_key), &var_value);
         self
     }
 
     pub(super) fn metadata(mut self, metadata_key: &str, metadata_value: Cow<'u, str>) -> FormUploaderBuilder<'u> {
-        self.multipart
-            .add_text("x-qn-meta-".to_owned() + metadata_key, metadata_value);
+        self.add_text(&("x-qn-meta-".to_owned() + metadata_key), &metadata_value);
         self
     }
 
@@ -68,60 +97,247 @@ impl<'u> FormUploaderBuilder<'u> {
         self
     }
 
+    pub(super) fn bandwidth_limiter(
+        mut self,
+        bandwidth_limiter: Option<&'u BandwidthLimiter>,
+    ) -> FormUploaderBuilder<'u> {
+        self.bandwidth_limiter = bandwidth_limiter;
+        self
+    }
+
+    pub(super) fn cancellation_token(
+        mut self,
+        cancellation_token: Option<&'u CancellationToken>,
+    ) -> FormUploaderBuilder<'u> {
+        self.cancellation_token = cancellation_token;
+        self
+    }
+
     pub(super) fn seekable_stream<'n: 'u, R: Read + Seek + 'u>(
         mut self,
         mut stream: R,
         file_name: Cow<'n, str>,
         mime: Option<Mime>,
         checksum_enabled: bool,
+        local_etag_enabled: bool,
     ) -> Result<FormUploader<'u>, UploadError> {
-        let mut crc32: Option<u32> = None;
-        if checksum_enabled {
-            crc32 = Some(crc32::from(&mut stream)?);
-            stream.seek(SeekFrom::Start(0))?;
-        }
-        let file_name = if file_name.is_empty() { None } else { Some(file_name) };
-        self.multipart.add_stream("file", stream, file_name, mime);
-        if let Some(crc32) = crc32 {
-            self.multipart.add_text("crc32", crc32.to_string());
+        // 先读一遍数据流，同时计算 CRC32 和 Etag，再倒回数据流，在发送请求时流式读取
+        let start = stream.seek(SeekFrom::Current(0))?;
+        let (crc32, local_etag) = match (checksum_enabled, local_etag_enabled) {
+            (false, false) => (None, None),
+            (true, false) => (Some(crc32::from(&mut stream)?), None),
+            (false, true) => (None, Some(etag::from(&mut stream)?)),
+            (true, true) => {
+                let mut crc32_reader = crc32::new_reader(&mut stream);
+                let mut etag_reader = etag::new_reader(&mut crc32_reader);
+                copy(&mut etag_reader, &mut sink())?;
+                let local_etag = etag_reader.into_etag();
+                (crc32_reader.crc32(), local_etag)
+            }
+        };
+        let size = stream.seek(SeekFrom::End(0))? - start;
+        stream.seek(SeekFrom::Start(start))?;
+        self.local_etag = local_etag.map(|etag| etag.into());
+        self.upload_multipart(Box::new(stream), size, file_name, mime, crc32)
+    }
+
+    /// 上传内存中的数据，例如文件的内存映射区域
+    ///
+    /// CRC32 和 Etag 直接在数据上计算，发送请求时也直接从数据中读取，无需额外复制一次数据
+    pub(super) fn bytes<'n: 'u>(
+        mut self,
+        data: &'u [u8],
+        file_name: Cow<'n, str>,
+        mime: Option<Mime>,
+        checksum_enabled: bool,
+        local_etag_enabled: bool,
+    ) -> Result<FormUploader<'u>, UploadError> {
+        let crc32 = if checksum_enabled {
+            Some(crc32::from_bytes(data))
+        } else {
+            None
+        };
+        if local_etag_enabled {
+            self.local_etag = Some(etag::from_bytes(data).into());
         }
-        self.upload_multipart()
+        self.upload_multipart(
+            Box::new(Cursor::new(data)),
+            data.len().try_into().unwrap_or(u64::max_value()),
+            file_name,
+            mime,
+            crc32,
+        )
     }
 
     pub(super) fn stream<'n: 'u, R: Read + 'u>(
         mut self,
-        stream: R,
+        mut stream: R,
         mime: Option<Mime>,
         file_name: Cow<'n, str>,
         crc32: Option<u32>,
+        local_etag_enabled: bool,
     ) -> Result<FormUploader<'u>, UploadError> {
-        let file_name = if file_name.is_empty() { None } else { Some(file_name) };
-        self.multipart.add_stream("file", stream, file_name, mime);
-        if let Some(crc32) = crc32 {
-            self.multipart.add_text("crc32", crc32.to_string());
+        // 不可倒回的数据流只能先读入内存，才能在重试时重新发送
+        let mut data = Vec::new();
+        if local_etag_enabled {
+            let mut reader = etag::new_reader(stream);
+            reader.read_to_end(&mut data)?;
+            self.local_etag = reader.into_etag().map(|etag| etag.into());
+        } else {
+            stream.read_to_end(&mut data)?;
         }
-        self.upload_multipart()
+        let size = data.len().try_into().unwrap_or(u64::max_value());
+        self.upload_multipart(Box::new(Cursor::new(data)), size, file_name, mime, crc32)
     }
 
-    fn upload_multipart(mut self) -> Result<FormUploader<'u>, UploadError> {
-        let mut fields = self.multipart.prepare().map_err(|err| err.error)?;
-        let mut body = Vec::with_capacity(
-            self.bucket_uploader
-                .http_client()
-                .config()
-                .upload_threshold()
-                .try_into()
-                .unwrap_or(1 << 22),
+    fn add_text(&mut self, name: &str, value: &str) {
+        self.fields.extend_from_slice(b"--");
+        self.fields.extend_from_slice(self.boundary.as_bytes());
+        self.fields.extend_from_slice(b"\r\nContent-Disposition: form-data; name=\"");
+        self.fields.extend_from_slice(escape_quoted(name).as_bytes());
+        self.fields.extend_from_slice(b"\"\r\n\r\n");
+        self.fields.extend_from_slice(value.as_bytes());
+        self.fields.extend_from_slice(b"\r\n");
+    }
+
+    fn upload_multipart(
+        mut self,
+        file: Box<dyn ReadSeek + 'u>,
+        file_size: u64,
+        file_name: Cow<str>,
+        mime: Option<Mime>,
+        crc32: Option<u32>,
+    ) -> Result<FormUploader<'u>, UploadError> {
+        if let Some(crc32) = crc32 {
+            self.add_text("crc32", &crc32.to_string());
+        }
+        // 文件字段必须是表单中的最后一个字段
+        let mut head = self.fields;
+        head.extend_from_slice(b"--");
+        head.extend_from_slice(self.boundary.as_bytes());
+        head.extend_from_slice(b"\r\nContent-Disposition: form-data; name=\"file\"");
+        if !file_name.is_empty() {
+            head.extend_from_slice(b"; filename=\"");
+            head.extend_from_slice(escape_quoted(&file_name).as_bytes());
+            head.extend_from_slice(b"\"");
+        }
+        head.extend_from_slice(b"\r\nContent-Type: ");
+        head.extend_from_slice(
+            mime.as_ref()
+                .map(|mime| mime.as_ref())
+                .unwrap_or("application/octet-stream")
+                .as_bytes(),
         );
-        fields.read_to_end(&mut body)?;
+        head.extend_from_slice(b"\r\n\r\n");
+        let tail = ("\r\n--".to_owned() + &self.boundary + "--\r\n").into_bytes();
         Ok(FormUploader {
             bucket_uploader: self.bucket_uploader,
-            content_type: "multipart/form-data; boundary=".to_owned() + fields.boundary(),
-            body,
+            content_type: "multipart/form-data; boundary=".to_owned() + &self.boundary,
+            body: MultipartBody::new(head, file, file_size, tail)?
+                .throttled(self.bandwidth_limiter, self.cancellation_token),
             on_uploading_progress: self.on_uploading_progress,
             upload_logger: self.upload_logger,
+            local_etag: self.local_etag,
+            cancellation_token: self.cancellation_token,
+        })
+    }
+}
+
+fn escape_quoted(s: &str) -> Cow<str> {
+    if s.contains(|c| c == '"' || c == '\r' || c == '\n') {
+        s.replace('"', "%22").replace('\r', "%0D").replace('\n', "%0A").into()
+    } else {
+        s.into()
+    }
+}
+
+impl<'u> MultipartBody<'u> {
+    fn new(head: Vec<u8>, mut file: Box<dyn ReadSeek + 'u>, file_size: u64, tail: Vec<u8>) -> IOResult<Self> {
+        let file_start = file.seek(SeekFrom::Current(0))?;
+        Ok(MultipartBody {
+            head,
+            tail,
+            file: RefCell::new(file),
+            file_start,
+            file_size,
+            position: Cell::new(0),
+            bandwidth_limiter: None,
+            cancellation_token: None,
         })
     }
+
+    fn throttled(
+        mut self,
+        bandwidth_limiter: Option<&'u BandwidthLimiter>,
+        cancellation_token: Option<&'u CancellationToken>,
+    ) -> Self {
+        self.bandwidth_limiter = bandwidth_limiter;
+        self.cancellation_token = cancellation_token;
+        self
+    }
+
+    fn head_size(&self) -> u64 {
+        self.head.len().try_into().unwrap_or(u64::max_value())
+    }
+}
+
+impl RequestBodyStream for MultipartBody<'_> {
+    fn size(&self) -> u64 {
+        self.head_size() + self.file_size + self.tail.len() as u64
+    }
+
+    fn read(&self, buf: &mut [u8]) -> IOResult<usize> {
+        let position = self.position.get();
+        let head_size = self.head_size();
+        let have_read = if position < head_size {
+            copy_from_slice(&self.head[position as usize..], buf)
+        } else if position < head_size + self.file_size {
+            let rest: usize = (head_size + self.file_size - position)
+                .try_into()
+                .unwrap_or(usize::max_value());
+            let buf_len = buf.len().min(rest);
+            if self.cancellation_token.map_or(false, CancellationToken::is_canceled) {
+                return Err(canceled_io_error());
+            }
+            let have_read = self.file.borrow_mut().read(&mut buf[..buf_len])?;
+            if have_read == 0 && buf_len > 0 {
+                return Err(IOError::new(
+                    IOErrorKind::UnexpectedEof,
+                    "File is truncated during uploading",
+                ));
+            }
+            if let Some(bandwidth_limiter) = self.bandwidth_limiter {
+                if !bandwidth_limiter.consume(have_read, self.cancellation_token) {
+                    return Err(canceled_io_error());
+                }
+            }
+            have_read
+        } else {
+            let offset = ((position - head_size - self.file_size) as usize).min(self.tail.len());
+            copy_from_slice(&self.tail[offset..], buf)
+        };
+        self.position.set(position + have_read as u64);
+        Ok(have_read)
+    }
+
+    fn seek(&self, offset: u64) -> IOResult<()> {
+        let file_offset = offset.saturating_sub(self.head_size()).min(self.file_size);
+        self.file
+            .borrow_mut()
+            .seek(SeekFrom::Start(self.file_start + file_offset))?;
+        self.position.set(offset.min(self.size()));
+        Ok(())
+    }
+}
+
+fn canceled_io_error() -> IOError {
+    IOError::new(IOErrorKind::Other, "Uploading is canceled")
+}
+
+fn copy_from_slice(src: &[u8], dst: &mut [u8]) -> usize {
+    let len = src.len().min(dst.len());
+    dst[..len].copy_from_slice(&src[..len]);
+    len
 }
 
 impl<'u> FormUploader<'u> {
@@ -129,7 +345,8 @@ impl<'u> FormUploader<'u> {
         let mut prev_err: Option<HTTPError> = None;
         for up_urls in self.bucket_uploader.up_urls_list().iter() {
             match self.send_form_request(&up_urls.iter().map(|url| url.as_ref()).collect::<Box<[&str]>>()) {
-                Ok(value) => {
+                Ok(mut value) => {
+                    value.set_local_etag(self.local_etag.to_owned());
                     return Ok(value);
                 }
                 Err(err) => match err.retry_kind() {
@@ -151,6 +368,7 @@ impl<'u> FormUploader<'u> {
             .bucket_uploader
             .http_client()
             .post("/", up_urls)
+            .cancellation_token(self.cancellation_token)
             .idempotent()
             .on_uploading_progress(&|uploaded, total| {
                 if let Some(on_uploading_progress) = &self.on_uploading_progress {
@@ -166,8 +384,8 @@ impl<'u> FormUploader<'u> {
                                 .response(response)
                                 .duration(duration)
                                 .up_type(UpType::Form)
-                                .sent(self.body.len().try_into().unwrap_or(u64::max_value()))
-                                .total_size(self.body.len().try_into().unwrap_or(u64::max_value()))
+                                .sent(self.body.size())
+                                .total_size(self.body.size())
                                 .build(),
                         );
                     }
@@ -181,7 +399,7 @@ impl<'u> FormUploader<'u> {
                             .duration(duration)
                             .up_type(UpType::Form)
                             .http_error(err)
-                            .total_size(self.body.len().try_into().unwrap_or(u64::max_value()));
+                            .total_size(self.body.size());
                         if let Some(base_url) = base_url {
                             builder = builder.host(base_url);
                         }
@@ -190,7 +408,7 @@ impl<'u> FormUploader<'u> {
                 }
             })
             .accept_json()
-            .raw_body(self.content_type.to_owned(), self.body.as_slice())
+            .raw_body(self.content_type.to_owned(), &self.body as &dyn RequestBodyStream)
             .send()?
             .try_parse_json::<Value>()?;
         match upload_result {
@@ -202,21 +420,72 @@ impl<'u> FormUploader<'u> {
 
 #[cfg(test)]
 mod tests {
-    use super::super::{
-        super::uploader::{UploadPolicyBuilder, UploadToken},
-        BucketUploaderBuilder,
+    use super::{
+        super::{
+            super::uploader::{UploadPolicyBuilder, UploadToken},
+            BucketUploaderBuilder,
+        },
+        MultipartBody, RequestBodyStream,
     };
     use crate::{
         config::ConfigBuilder,
         credential::Credential,
         http::{DomainsManagerBuilder, Headers},
+        utils::etag,
     };
     use qiniu_test_utils::{
         http_call_mock::{CounterCallMock, ErrorResponseMock, JSONCallMock},
         temp_file::create_temp_file,
     };
     use serde_json::json;
-    use std::{boxed::Box, error::Error, result::Result};
+    use std::{
+        boxed::Box,
+        error::Error,
+        io::{Cursor, Result as IOResult},
+        result::Result,
+    };
+
+    #[test]
+    fn test_storage_uploader_form_uploader_multipart_body() -> Result<(), Box<dyn Error>> {
+        let mut file = Cursor::new(b"xx0123456789".to_vec());
+        file.set_position(2);
+        let body = MultipartBody::new(b"head".to_vec(), Box::new(file), 10, b"tail".to_vec())?;
+        assert_eq!(body.size(), 18);
+        assert_eq!(read_all(&body)?, b"head0123456789tail");
+        body.seek(6)?;
+        assert_eq!(read_all(&body)?, b"23456789tail");
+        body.seek(15)?;
+        assert_eq!(read_all(&body)?, b"ail");
+        body.seek(0)?;
+        assert_eq!(read_all(&body)?, b"head0123456789tail");
+        Ok(())
+    }
+
+    #[test]
+    fn test_storage_uploader_form_uploader_multipart_body_canceled() -> Result<(), Box<dyn Error>> {
+        let bandwidth_limiter = BandwidthLimiter::new(0);
+        let cancellation_token = CancellationToken::new();
+        let file = Cursor::new(b"0123456789".to_vec());
+        let body = MultipartBody::new(b"head".to_vec(), Box::new(file), 10, b"tail".to_vec())?
+            .throttled(Some(&bandwidth_limiter), Some(&cancellation_token));
+        let mut buf = [0u8; 6];
+        assert_eq!(body.read(&mut buf)?, 4);
+        assert_eq!(body.read(&mut buf)?, 6);
+        cancellation_token.cancel();
+        assert!(body.read(&mut buf).is_err());
+        Ok(())
+    }
+
+    fn read_all(body: &MultipartBody) -> IOResult<Vec<u8>> {
+        let mut data = Vec::new();
+        let mut buf = [0u8; 3];
+        loop {
+            match body.read(&mut buf)? {
+                0 => return Ok(data),
+                n => data.extend_from_slice(&buf[..n]),
+            }
+        }
+    }
 
     #[test]
     fn test_storage_uploader_form_uploader_upload_file() -> Result<(), Box<dyn Error>> {
@@ -244,9 +513,11 @@ mod tests {
         .build()
         .upload_token(UploadToken::new(policy, get_credential()))
         .key("test:file")
+        .enable_local_etag()
         .upload_file(&temp_path, "", None)?;
         assert_eq!(result.key(), Some("abc"));
         assert_eq!(result.hash(), Some("def"));
+        assert_eq!(result.local_etag(), Some(etag::from_file(&temp_path)?.as_str()));
         assert_eq!(mock.call_called(), 1);
         Ok(())
     }
@@ -1,10 +1,20 @@
-use crate::http::Error as HTTPError;
+use super::{
+    buffer_pool::{BufferPool, PooledBuffer},
+    part_tuner::{PartTuner, MAX_PART_SIZE},
+    user_canceled_error,
+};
+use crate::http::{CancellationToken, Error as HTTPError};
 use assert_impl::assert_impl;
 use std::{
-    collections::HashSet,
+    collections::{HashSet, VecDeque},
     convert::TryInto,
-    io::{Error as IOError, ErrorKind as IOErrorKind, Read, Seek, SeekFrom},
-    sync::Mutex,
+    fs::File,
+    io::{Error as IOError, ErrorKind as IOErrorKind, Read, Result as IOResult, Seek, SeekFrom},
+    ops::Deref,
+    sync::{
+        atomic::{AtomicUsize, Ordering::Relaxed},
+        Mutex,
+    },
 };
 
 pub(super) enum Result {
@@ -18,66 +28,272 @@ enum Status<R: Read + Seek + Send> {
         reader: R,
         block_size: u32,
         current_part_number: usize,
+        current_offset: u64,
         uploaded_part_numbers: HashSet<usize>,
+        read_uploaded_parts: bool,
     },
     IOError(IOError),
     HTTPError(HTTPError),
     Success,
 }
 
-pub(super) struct IOStatusManager<R: Read + Seek + Send> {
-    inner: Mutex<Status<R>>,
+pub(super) struct IOStatusManager<'f, R: Read + Seek + Send> {
+    inner: Inner<'f, R>,
+    buffer_pool: &'f BufferPool,
+    part_tuner: Option<&'f PartTuner>,
+    cancellation_token: Option<&'f CancellationToken>,
+}
+
+enum Inner<'f, R: Read + Seek + Send> {
+    Sequential(Mutex<Status<R>>),
+    Positional(PositionalReader<'f>),
+}
+
+/// 基于位置读取的分块读取器
+///
+/// 每个线程通过原子计数器领取分块编号，再各自使用位置读取（`pread`）读出该分块的数据，
+/// 或是直接借用内存映射中该分块的区域，读取过程无需加锁，锁仅用于记录上传状态和错误
+struct PositionalReader<'f> {
+    source: Source<'f>,
+    file_size: u64,
+    layout: Layout,
+    read_uploaded_parts: bool,
+    failure: Mutex<Option<Result>>,
+}
+
+/// 分块布局
+enum Layout {
+    /// 所有分块尺寸相同，分块范围由分块编号直接算出
+    Fixed {
+        block_size: u32,
+        parts_count: usize,
+        next_part_number: AtomicUsize,
+        uploaded_part_numbers: HashSet<usize>,
+    },
+    /// 分块尺寸可变，分块范围由分块规划器依次划分
+    Planned(Mutex<PartPlanner>),
+}
+
+/// 分块范围
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(super) struct PartRange {
+    pub(super) part_number: usize,
+    pub(super) offset: u64,
+    pub(super) size: u64,
+}
+
+/// 分块规划器
+///
+/// 依次从文件中划分出尺寸可变的分块。续传时，已经上传的分块保持原有的编号与范围，
+/// 它们之间的空隙将被划分为编号介于两者之间的分块，最后一个已上传分块之后的数据则按照请求的尺寸继续划分
+pub(super) struct PartPlanner {
+    pending: VecDeque<(PartRange, bool)>,
+    block_size: u64,
+    next_offset: u64,
+    next_part_number: usize,
+}
+
+enum Source<'f> {
+    File(&'f File),
+    Mapped(&'f [u8]),
 }
 
-pub(super) struct PartData {
-    pub(super) data: Vec<u8>,
+pub(super) struct PartData<'f> {
+    pub(super) data: PartBuffer<'f>,
     pub(super) part_number: usize,
+    /// 分块在数据中的偏移量
+    pub(super) offset: u64,
+    /// 该分块是否已经在之前的上传中完成，这样的分块仅用于计算本地 Etag，无需再次上传
+    pub(super) uploaded: bool,
 }
 
-impl<R: Read + Seek + Send> IOStatusManager<R> {
-    pub(super) fn new(io: R, block_size: u32, uploaded_part_numbers: &[usize]) -> IOStatusManager<R> {
+impl<'f, R: Read + Seek + Send> IOStatusManager<'f, R> {
+    /// 创建 IO 状态管理器
+    ///
+    /// 如果 `read_uploaded_parts` 为 `true`，已经上传的分块将不会被跳过，而是被读出并标记为已上传，以便调用方计算完整数据的 Etag
+    pub(super) fn new(
+        io: R,
+        buffer_pool: &'f BufferPool,
+        block_size: u32,
+        uploaded_part_numbers: &[usize],
+        read_uploaded_parts: bool,
+    ) -> IOStatusManager<'f, R> {
         IOStatusManager {
-            inner: Mutex::new(Status::Uploading {
+            inner: Inner::Sequential(Mutex::new(Status::Uploading {
                 reader: io,
                 current_part_number: 0,
+                current_offset: 0,
                 block_size,
-                uploaded_part_numbers: {
-                    let mut set = HashSet::new();
-                    for &part_number in uploaded_part_numbers {
-                        set.insert(part_number);
+                uploaded_part_numbers: uploaded_part_numbers.iter().cloned().collect(),
+                read_uploaded_parts,
+            })),
+            buffer_pool,
+            part_tuner: None,
+            cancellation_token: None,
+        }
+    }
+
+    /// 创建基于位置读取的 IO 状态管理器
+    ///
+    /// 仅适用于文件，多个线程将并发读取文件的不同区域，不会相互阻塞。
+    /// 分块范围由创建时给出的文件尺寸决定
+    pub(super) fn new_positional(
+        file: &'f File,
+        buffer_pool: &'f BufferPool,
+        file_size: u64,
+        block_size: u32,
+        uploaded_part_numbers: &[usize],
+        read_uploaded_parts: bool,
+    ) -> IOStatusManager<'f, R> {
+        IOStatusManager {
+            inner: Inner::Positional(PositionalReader::new(
+                Source::File(file),
+                file_size,
+                block_size,
+                uploaded_part_numbers,
+                read_uploaded_parts,
+            )),
+            buffer_pool,
+            part_tuner: None,
+            cancellation_token: None,
+        }
+    }
+
+    /// 创建基于内存映射的 IO 状态管理器
+    ///
+    /// 分块数据直接借用映射区域，不会再复制到缓冲区中，分块范围由映射区域的长度决定
+    pub(super) fn new_mapped(
+        mapped: &'f [u8],
+        buffer_pool: &'f BufferPool,
+        block_size: u32,
+        uploaded_part_numbers: &[usize],
+        read_uploaded_parts: bool,
+    ) -> IOStatusManager<'f, R> {
+        IOStatusManager {
+            inner: Inner::Positional(PositionalReader::new(
+                Source::Mapped(mapped),
+                mapped.len() as u64,
+                block_size,
+                uploaded_part_numbers,
+                read_uploaded_parts,
+            )),
+            buffer_pool,
+            part_tuner: None,
+            cancellation_token: None,
+        }
+    }
+
+    /// 改为按照分块规划器划分分块，并由分块自适应调节器决定新分块的尺寸
+    ///
+    /// 对于基于位置读取和内存映射的 IO 状态管理器，给出分块规划器后，分块范围将完全由分块规划器决定，
+    /// 创建时给出的分块尺寸和已上传分块编号不再生效，未给出分块规划器时则保持原有的分块布局，分块自适应调节器也不生效。
+    /// 对于顺序读取的 IO 状态管理器，分块规划器总是不生效，且只有不存在已上传分块时才能改变分块尺寸
+    pub(super) fn planned(
+        mut self,
+        planner: Option<PartPlanner>,
+        part_tuner: Option<&'f PartTuner>,
+    ) -> IOStatusManager<'f, R> {
+        match &mut self.inner {
+            Inner::Positional(reader) => {
+                if let Some(planner) = planner {
+                    reader.layout = Layout::Planned(Mutex::new(planner));
+                    self.part_tuner = part_tuner;
+                }
+            }
+            Inner::Sequential(inner) => {
+                if let Status::Uploading {
+                    uploaded_part_numbers, ..
+                } = &*inner.lock().unwrap()
+                {
+                    if uploaded_part_numbers.is_empty() {
+                        self.part_tuner = part_tuner;
                     }
-                    set
-                },
-            }),
+                }
+            }
+        }
+        self
+    }
+
+    /// 在取消令牌被取消后不再读出新的分块
+    ///
+    /// 带宽限制不在这里进行，而是在分块数据被 HTTP 客户端逐段发送时按实际发送的字节数申请令牌
+    pub(super) fn cancellable(mut self, cancellation_token: Option<&'f CancellationToken>) -> IOStatusManager<'f, R> {
+        self.cancellation_token = cancellation_token;
+        self
+    }
+
+    /// 读取下一个分块
+    ///
+    /// 返回的分块数据缓冲区来自缓冲区池或是内存映射区域，分块数据被释放时缓冲区将自动归还。
+    /// 如果取消令牌已经被取消，则记录用户取消错误并返回 `None`
+    pub(super) fn read(&self) -> Option<PartData<'f>> {
+        if self.is_canceled() {
+            self.error(user_canceled_error());
+            return None;
         }
+        self.read_part()
     }
 
-    pub(super) fn read(&self) -> Option<PartData> {
-        let mut lock = self.inner.lock().unwrap();
+    fn is_canceled(&self) -> bool {
+        self.cancellation_token.map_or(false, CancellationToken::is_canceled)
+    }
+
+    fn read_part(&self) -> Option<PartData<'f>> {
+        match &self.inner {
+            Inner::Sequential(inner) => Self::read_sequentially(
+                inner,
+                self.buffer_pool,
+                self.part_tuner.map(|part_tuner| part_tuner.part_size()),
+            ),
+            Inner::Positional(reader) => reader.read(
+                self.buffer_pool,
+                self.part_tuner.map(|part_tuner| part_tuner.part_size()),
+            ),
+        }
+    }
+
+    fn read_sequentially(
+        inner: &Mutex<Status<R>>,
+        buffer_pool: &'f BufferPool,
+        part_size: Option<u32>,
+    ) -> Option<PartData<'f>> {
+        let mut lock = inner.lock().unwrap();
         match &mut *lock {
             Status::Uploading {
                 reader,
                 block_size,
                 current_part_number,
+                current_offset,
                 uploaded_part_numbers,
+                read_uploaded_parts,
             } => {
                 let mut have_read = 0;
-                let mut buf = vec![0; block_size.to_owned().try_into().unwrap_or(usize::max_value())];
+                let mut buf = buffer_pool.get(
+                    part_size
+                        .unwrap_or(*block_size)
+                        .try_into()
+                        .unwrap_or(usize::max_value()),
+                );
                 let new_part_number = {
                     let mut new_part_number = *current_part_number + 1;
-                    let mut skip_bytes = 0i64;
-                    while uploaded_part_numbers.get(&new_part_number).is_some() {
-                        new_part_number += 1;
-                        skip_bytes += *block_size as i64;
-                    }
-                    if skip_bytes > 0 {
-                        if let Err(err) = reader.seek(SeekFrom::Current(skip_bytes)) {
-                            *lock = Status::IOError(err);
-                            return None;
+                    if !*read_uploaded_parts {
+                        let mut skip_bytes = 0i64;
+                        while uploaded_part_numbers.get(&new_part_number).is_some() {
+                            new_part_number += 1;
+                            skip_bytes += *block_size as i64;
+                        }
+                        if skip_bytes > 0 {
+                            if let Err(err) = reader.seek(SeekFrom::Current(skip_bytes)) {
+                                *lock = Status::IOError(err);
+                                return None;
+                            }
+                            *current_offset += skip_bytes as u64;
                         }
                     }
                     new_part_number
                 };
+                let uploaded = uploaded_part_numbers.contains(&new_part_number);
+                let offset = *current_offset;
                 loop {
                     match reader.read(&mut buf[have_read..]) {
                         Ok(0) => {
@@ -85,8 +301,10 @@ impl<R: Read + Seek + Send> IOStatusManager<R> {
                             if have_read > 0 {
                                 buf.resize_with(have_read, Default::default);
                                 return Some(PartData {
-                                    data: buf,
+                                    data: PartBuffer::Pooled(buf),
                                     part_number: new_part_number,
+                                    offset,
+                                    uploaded,
                                 });
                             } else {
                                 return None;
@@ -96,9 +314,12 @@ impl<R: Read + Seek + Send> IOStatusManager<R> {
                             have_read += n;
                             if have_read == buf.len() {
                                 *current_part_number = new_part_number;
+                                *current_offset += have_read as u64;
                                 return Some(PartData {
-                                    data: buf,
+                                    data: PartBuffer::Pooled(buf),
                                     part_number: new_part_number,
+                                    offset,
+                                    uploaded,
                                 });
                             }
                         }
@@ -117,17 +338,27 @@ impl<R: Read + Seek + Send> IOStatusManager<R> {
     }
 
     pub(super) fn error(&self, err: HTTPError) {
-        *self.inner.lock().unwrap() = Status::HTTPError(err);
+        match &self.inner {
+            Inner::Sequential(inner) => {
+                *inner.lock().unwrap() = Status::HTTPError(err);
+            }
+            Inner::Positional(reader) => {
+                *reader.failure.lock().unwrap() = Some(Result::HTTPError(err));
+            }
+        }
     }
 
     pub(super) fn result(self) -> Result {
-        match self.inner.into_inner().unwrap() {
-            Status::Success => Result::Success,
-            Status::IOError(err) => Result::IOError(err),
-            Status::HTTPError(err) => Result::HTTPError(err),
-            Status::Uploading { .. } => {
-                panic!("Unexpected uploading status of task_manager");
-            }
+        match self.inner {
+            Inner::Sequential(inner) => match inner.into_inner().unwrap() {
+                Status::Success => Result::Success,
+                Status::IOError(err) => Result::IOError(err),
+                Status::HTTPError(err) => Result::HTTPError(err),
+                Status::Uploading { .. } => {
+                    panic!("Unexpected uploading status of task_manager");
+                }
+            },
+            Inner::Positional(reader) => reader.failure.into_inner().unwrap().unwrap_or(Result::Success),
         }
     }
 
@@ -138,9 +369,391 @@ impl<R: Read + Seek + Send> IOStatusManager<R> {
     }
 }
 
+impl<'f> PositionalReader<'f> {
+    fn new(
+        source: Source<'f>,
+        file_size: u64,
+        block_size: u32,
+        uploaded_part_numbers: &[usize],
+        read_uploaded_parts: bool,
+    ) -> PositionalReader<'f> {
+        let block_size_u64: u64 = block_size.into();
+        PositionalReader {
+            source,
+            file_size,
+            layout: Layout::Fixed {
+                block_size,
+                parts_count: ((file_size + block_size_u64 - 1) / block_size_u64)
+                    .try_into()
+                    .unwrap_or(usize::max_value()),
+                next_part_number: AtomicUsize::new(1),
+                uploaded_part_numbers: uploaded_part_numbers.iter().cloned().collect(),
+            },
+            read_uploaded_parts,
+            failure: Mutex::new(None),
+        }
+    }
+
+    fn read(&self, buffer_pool: &'f BufferPool, part_size: Option<u32>) -> Option<PartData<'f>> {
+        loop {
+            if self.failure.lock().unwrap().is_some() {
+                return None;
+            }
+            let (part, uploaded) = self.next_part(part_size)?;
+            if uploaded && !self.read_uploaded_parts {
+                continue;
+            }
+            let size: usize = part.size.try_into().unwrap_or(usize::max_value());
+            let file = match self.source {
+                Source::File(file) => file,
+                Source::Mapped(mapped) => {
+                    let offset = part.offset as usize;
+                    return Some(PartData {
+                        data: PartBuffer::Mapped(&mapped[offset..offset + size]),
+                        part_number: part.part_number,
+                        offset: part.offset,
+                        uploaded,
+                    });
+                }
+            };
+            let mut buf = buffer_pool.get(size);
+            match read_exact_at(file, &mut buf, part.offset) {
+                Ok(()) => {
+                    return Some(PartData {
+                        data: PartBuffer::Pooled(buf),
+                        part_number: part.part_number,
+                        offset: part.offset,
+                        uploaded,
+                    });
+                }
+                Err(err) => {
+                    let mut failure = self.failure.lock().unwrap();
+                    if failure.is_none() {
+                        *failure = Some(Result::IOError(err));
+                    }
+                    return None;
+                }
+            }
+        }
+    }
+
+    fn next_part(&self, part_size: Option<u32>) -> Option<(PartRange, bool)> {
+        match &self.layout {
+            Layout::Fixed {
+                block_size,
+                parts_count,
+                next_part_number,
+                uploaded_part_numbers,
+            } => {
+                let part_number = next_part_number.fetch_add(1, Relaxed);
+                if part_number > *parts_count {
+                    return None;
+                }
+                let offset = (part_number as u64 - 1) * u64::from(*block_size);
+                let part = PartRange {
+                    part_number,
+                    offset,
+                    size: u64::min((*block_size).into(), self.file_size - offset),
+                };
+                Some((part, uploaded_part_numbers.contains(&part_number)))
+            }
+            Layout::Planned(planner) => planner.lock().unwrap().next(self.file_size, part_size),
+        }
+    }
+}
+
+impl PartPlanner {
+    /// 创建分块规划器
+    ///
+    /// # Arguments
+    ///
+    /// * `file_size` - 文件尺寸
+    /// * `block_size` - 未指定新分块尺寸时所用的分块尺寸，同时也优先用于划分已上传分块之间的空隙
+    /// * `uploaded_parts` - 已经上传的分块
+    ///
+    /// 如果已上传的分块相互重叠，超出文件范围，或是空隙无法被划分到两者之间的分块编号中，将返回 `None`
+    pub(super) fn new(file_size: u64, block_size: u32, uploaded_parts: &[PartRange]) -> Option<PartPlanner> {
+        let block_size = u64::from(block_size.max(1));
+        let mut uploaded_parts = uploaded_parts.to_vec();
+        uploaded_parts.sort_unstable_by_key(|part| part.part_number);
+        let mut pending = VecDeque::with_capacity(uploaded_parts.len() * 2);
+        let mut next_offset = 0u64;
+        let mut next_part_number = 1usize;
+        for uploaded_part in uploaded_parts {
+            if uploaded_part.part_number < next_part_number
+                || uploaded_part.offset < next_offset
+                || uploaded_part.size == 0
+                || uploaded_part.offset + uploaded_part.size > file_size
+            {
+                return None;
+            }
+            let gap = uploaded_part.offset - next_offset;
+            let gap_part_numbers = (uploaded_part.part_number - next_part_number) as u64;
+            if gap > 0 {
+                // 优先按照原有的分块尺寸划分空隙，这样分块尺寸不变的续传将还原出与之前完全一致的分块
+                let gap_parts_count = if gap % block_size == 0 && gap / block_size <= gap_part_numbers {
+                    gap / block_size
+                } else {
+                    (gap + u64::from(MAX_PART_SIZE) - 1) / u64::from(MAX_PART_SIZE)
+                };
+                if gap_parts_count > gap_part_numbers {
+                    return None;
+                }
+                for index in 0..gap_parts_count {
+                    let size = gap / gap_parts_count + if index < gap % gap_parts_count { 1 } else { 0 };
+                    pending.push_back((
+                        PartRange {
+                            part_number: next_part_number,
+                            offset: next_offset,
+                            size,
+                        },
+                        false,
+                    ));
+                    next_offset += size;
+                    next_part_number += 1;
+                }
+            }
+            pending.push_back((uploaded_part, true));
+            next_offset = uploaded_part.offset + uploaded_part.size;
+            next_part_number = uploaded_part.part_number + 1;
+        }
+        Some(PartPlanner {
+            pending,
+            block_size,
+            next_offset,
+            next_part_number,
+        })
+    }
+
+    fn next(&mut self, file_size: u64, part_size: Option<u32>) -> Option<(PartRange, bool)> {
+        if let Some(part) = self.pending.pop_front() {
+            return Some(part);
+        }
+        if self.next_offset >= file_size {
+            return None;
+        }
+        let size = u64::min(
+            part_size.map(u64::from).unwrap_or(self.block_size).max(1),
+            file_size - self.next_offset,
+        );
+        let part = PartRange {
+            part_number: self.next_part_number,
+            offset: self.next_offset,
+            size,
+        };
+        self.next_offset += size;
+        self.next_part_number += 1;
+        Some((part, false))
+    }
+}
+
+/// 分块数据
+///
+/// 可能是从缓冲区池中获取的缓冲区，也可能是直接借用的内存映射区域
+pub(super) enum PartBuffer<'f> {
+    Pooled(PooledBuffer<'f>),
+    Mapped(&'f [u8]),
+}
+
+impl Deref for PartBuffer<'_> {
+    type Target = [u8];
+
+    fn deref(&self) -> &Self::Target {
+        match self {
+            PartBuffer::Pooled(buffer) => buffer.as_slice(),
+            PartBuffer::Mapped(mapped) => mapped,
+        }
+    }
+}
+
+/// 判断当前平台是否支持位置读取
+pub(super) const fn is_positional_read_supported() -> bool {
+    cfg!(any(unix, windows))
+}
+
+#[cfg(unix)]
+fn read_at(file: &File, buf: &mut [u8], offset: u64) -> IOResult<usize> {
+    use std::os::unix::fs::FileExt;
+    file.read_at(buf, offset)
+}
+
+#[cfg(windows)]
+fn read_at(file: &File, buf: &mut [u8], offset: u64) -> IOResult<usize> {
+    use std::os::windows::fs::FileExt;
+    file.seek_read(buf, offset)
+}
+
+#[cfg(not(any(unix, windows)))]
+fn read_at(_file: &File, _buf: &mut [u8], _offset: u64) -> IOResult<usize> {
+    Err(IOError::new(IOErrorKind::Other, "Positional read is not supported"))
+}
+
+fn read_exact_at(file: &File, mut buf: &mut [u8], mut offset: u64) -> IOResult<()> {
+    while !buf.is_empty() {
+        match read_at(file, buf, offset) {
+            Ok(0) => {
+                return Err(IOError::new(
+                    IOErrorKind::UnexpectedEof,
+                    "File is truncated during uploading",
+                ));
+            }
+            Ok(n) => {
+                buf = &mut buf[n..];
+                offset += n as u64;
+            }
+            Err(ref err) if err.kind() == IOErrorKind::Interrupted => {}
+            Err(err) => return Err(err),
+        }
+    }
+    Ok(())
+}
+
 impl<R: Read + Seek + Send> Status<R> {
     #[allow(dead_code)]
     fn ignore() {
         assert_impl!(Send: Self);
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use qiniu_test_utils::temp_file::create_temp_file;
+    use rayon::ThreadPoolBuilder;
+    use std::{error::Error, io::Cursor, result::Result};
+
+    #[test]
+    fn test_storage_uploader_io_status_manager_read_positionally() -> Result<(), Box<dyn Error>> {
+        let temp_path = create_temp_file(5 * (1 << 22) + 1)?.into_temp_path();
+        let file = File::open(&temp_path)?;
+        let file_size = file.metadata()?.len();
+        let buffer_pool = BufferPool::new(4 * (1 << 22));
+        let io_status_manager = IOStatusManager::<Cursor<Vec<u8>>>::new_positional(
+            &file,
+            &buffer_pool,
+            file_size,
+            1 << 22,
+            &[2, 4],
+            false,
+        );
+        let parts = Mutex::new(Vec::new());
+        ThreadPoolBuilder::new().num_threads(4).build()?.scope(|s| {
+            for _ in 0..4 {
+                s.spawn(|_| {
+                    while let Some(part_data) = io_status_manager.read() {
+                        parts.lock().unwrap().push(part_data);
+                    }
+                });
+            }
+        });
+        assert!(matches!(io_status_manager.result(), super::Result::Success));
+        let mut parts = parts.into_inner().unwrap();
+        parts.sort_unstable_by_key(|part| part.part_number);
+        assert_eq!(
+            parts.iter().map(|part| part.part_number).collect::<Vec<_>>(),
+            vec![1, 3, 5, 6]
+        );
+        assert!(parts.iter().all(|part| !part.uploaded));
+        let data = std::fs::read(&temp_path)?;
+        for part in parts.iter() {
+            let offset = (part.part_number - 1) * (1 << 22);
+            assert_eq!(&*part.data, &data[offset..usize::min(offset + (1 << 22), data.len())]);
+        }
+        Ok(())
+    }
+
+    #[test]
+    fn test_storage_uploader_io_status_manager_read_mapped() -> Result<(), Box<dyn Error>> {
+        let data = std::iter::repeat(b'q').take(3 * (1 << 22) + 2).collect::<Vec<_>>();
+        let buffer_pool = BufferPool::new(0);
+        let io_status_manager =
+            IOStatusManager::<Cursor<Vec<u8>>>::new_mapped(&data, &buffer_pool, 1 << 22, &[2], true);
+        let mut parts = Vec::new();
+        while let Some(part_data) = io_status_manager.read() {
+            parts.push(part_data);
+        }
+        assert!(matches!(io_status_manager.result(), super::Result::Success));
+        assert_eq!(
+            parts
+                .iter()
+                .map(|part| (part.part_number, part.uploaded, part.data.len()))
+                .collect::<Vec<_>>(),
+            vec![(1, false, 1 << 22), (2, true, 1 << 22), (3, false, 1 << 22), (4, false, 2)]
+        );
+        assert!(parts.iter().all(|part| matches!(part.data, PartBuffer::Mapped(_))));
+        Ok(())
+    }
+
+    #[test]
+    fn test_storage_uploader_io_status_manager_read_planned() -> Result<(), Box<dyn Error>> {
+        let data = std::iter::repeat(b'q').take(10 * (1 << 20) + 5).collect::<Vec<_>>();
+        let buffer_pool = BufferPool::new(0);
+        let planner = PartPlanner::new(
+            data.len() as u64,
+            1 << 22,
+            &[PartRange {
+                part_number: 2,
+                offset: 1 << 22,
+                size: 1 << 21,
+            }],
+        )
+        .unwrap();
+        let io_status_manager = IOStatusManager::<Cursor<Vec<u8>>>::new_mapped(&data, &buffer_pool, 1 << 22, &[], true)
+            .planned(Some(planner), None);
+        let mut parts = Vec::new();
+        while let Some(part_data) = io_status_manager.read() {
+            parts.push(part_data);
+        }
+        assert!(matches!(io_status_manager.result(), super::Result::Success));
+        assert_eq!(
+            parts
+                .iter()
+                .map(|part| (part.part_number, part.offset, part.uploaded, part.data.len()))
+                .collect::<Vec<_>>(),
+            vec![
+                (1, 0, false, 1 << 22),
+                (2, 1 << 22, true, 1 << 21),
+                (3, 6 * (1 << 20), false, 1 << 22),
+                (4, 10 * (1 << 20), false, 5)
+            ]
+        );
+
+        // 空隙无法被划分到两个已上传分块的编号之间
+        assert!(PartPlanner::new(
+            data.len() as u64,
+            1 << 22,
+            &[
+                PartRange {
+                    part_number: 1,
+                    offset: 0,
+                    size: 1 << 20,
+                },
+                PartRange {
+                    part_number: 2,
+                    offset: 1 << 21,
+                    size: 1 << 20,
+                },
+            ],
+        )
+        .is_none());
+        Ok(())
+    }
+
+    #[test]
+    fn test_storage_uploader_io_status_manager_read_canceled() -> Result<(), Box<dyn Error>> {
+        let data = std::iter::repeat(b'q').take(3 * (1 << 22)).collect::<Vec<_>>();
+        let buffer_pool = BufferPool::new(0);
+        let cancellation_token = CancellationToken::new();
+        let io_status_manager =
+            IOStatusManager::<Cursor<Vec<u8>>>::new_mapped(&data, &buffer_pool, 1 << 22, &[], false)
+                .cancellable(Some(&cancellation_token));
+        assert_eq!(io_status_manager.read().map(|part| part.part_number), Some(1));
+        cancellation_token.cancel();
+        assert!(io_status_manager.read().is_none());
+        match io_status_manager.result() {
+            super::Result::HTTPError(err) => assert!(matches!(err.error_kind(), crate::http::ErrorKind::UserCanceled)),
+            _ => panic!("Reading should be canceled"),
+        }
+        Ok(())
+    }
+}
@@ -3,23 +3,34 @@
 //! 提供对象上传相关功能
 
 mod batch_uploader;
+#[cfg(feature = "benchmark")]
+#[doc(hidden)]
+pub mod benchmark;
 mod bucket_uploader;
+mod buffer_pool;
 mod callback;
+mod etag_cache;
 mod form_uploader;
 mod io_status_manager;
+mod part_tuner;
 mod resumable_uploader;
 mod upload_logger;
+mod upload_future;
 mod upload_manager;
 mod upload_policy;
 mod upload_recorder;
 mod upload_response;
 mod upload_token;
 
-pub use batch_uploader::{BatchUploadJob, BatchUploadJobBuilder, BatchUploader};
+pub use batch_uploader::{
+    BatchUploadJob, BatchUploadJobBuilder, BatchUploader, FairnessPolicy as BatchUploadFairnessPolicy,
+};
 pub use bucket_uploader::{BucketUploader, BucketUploaderBuilder, FileUploaderBuilder, UploadError, UploadResult};
-use callback::upload_response_callback;
+use callback::{upload_response_callback, user_canceled_error};
+pub use etag_cache::EtagCache;
 pub use upload_logger::{LockPolicy as UploadLoggerFileLockPolicy, UploadLogger, UploadLoggerBuilder};
 use upload_logger::{TokenizedUploadLogger, UpType, UploadLoggerRecordBuilder};
+pub use upload_future::{UploadCompleter, UploadFuture};
 pub use upload_manager::{CreateUploaderError, CreateUploaderResult, UploadManager};
 pub use upload_policy::{UploadPolicy, UploadPolicyBuilder};
 pub use upload_recorder::{UploadRecorder, UploadRecorderBuilder};
@@ -0,0 +1,333 @@
+use assert_impl::assert_impl;
+use std::{
+    sync::{Condvar, Mutex},
+    time::Duration,
+};
+
+/// 分块尺寸下限，除最后一个分块外，每个分块都不能小于该值
+pub(super) const MIN_PART_SIZE: u32 = 1 << 20;
+
+/// 分块尺寸上限
+pub(super) const MAX_PART_SIZE: u32 = 1 << 30;
+
+/// 单个文件的分块数上限
+pub(super) const MAX_PARTS_COUNT: u64 = 10_000;
+
+/// 吞吐量与往返时延的指数加权移动平均系数
+const EWMA_ALPHA: f64 = 0.3;
+
+/// 分块上传耗时的目标下限，分块过小时请求本身的开销将占据主要耗时
+const MIN_TARGET_PART_DURATION: Duration = Duration::from_secs(2);
+
+/// 分块上传耗时至少为往返时延的倍数，以确保每个分块等待响应的时间只占其上传耗时的一小部分
+const TARGET_PART_DURATION_PER_RTT: f64 = 20.0;
+
+/// 分块自适应调节器
+///
+/// 根据已上传分块的耗时测算单个分块的上传吞吐量和往返时延，据此调节之后分块的尺寸：
+/// 链路越快分块越大，以减少请求次数；往返时延越长分块越大，以摊薄等待响应的时间。
+///
+/// 同时以轮为单位调节同时上传的分块数：每完成与当前并发数相同数量的分块记为一轮，
+/// 如果本轮的总吞吐量相比上一轮有明显提升则增加并发数，有明显下降则减少并发数；
+/// 一旦分块上传出错，则将并发数和分块尺寸同时减半，以适应丢包严重的链路
+pub(super) struct PartTuner {
+    state: Mutex<State>,
+    condvar: Condvar,
+    min_part_size: u32,
+    max_part_size: u32,
+    alignment: u32,
+    max_concurrency: usize,
+}
+
+struct State {
+    part_size: u32,
+    concurrency: usize,
+    in_flight: usize,
+    throughput: Option<f64>,
+    rtt: Option<f64>,
+    round_parts: usize,
+    round_bytes: u64,
+    round_seconds: f64,
+    last_round_throughput: Option<f64>,
+}
+
+/// 上传许可
+///
+/// 在上传分块前获取，析构时自动归还，同时持有的许可数不会超过当前的并发数
+pub(super) struct Permit<'t> {
+    tuner: &'t PartTuner,
+}
+
+impl PartTuner {
+    /// 创建分块自适应调节器
+    ///
+    /// # Arguments
+    ///
+    /// * `initial_part_size` - 初始分块尺寸
+    /// * `alignment` - 分块尺寸必须是该值的整数倍，用于确保分块与 Etag 块对齐
+    /// * `file_size` - 数据总尺寸，如果无法预知则为 `None`。
+    ///   已知数据总尺寸时，分块尺寸不会小到超出分块数上限，也不会大到无法让所有并发同时上传
+    /// * `max_concurrency` - 最大并发数
+    pub(super) fn new(
+        initial_part_size: u32,
+        alignment: u32,
+        file_size: Option<u64>,
+        max_concurrency: usize,
+    ) -> PartTuner {
+        let alignment = alignment.max(1);
+        let max_concurrency = max_concurrency.max(1);
+        let (min_part_size, max_part_size) = match file_size {
+            Some(file_size) => {
+                let min_part_size = align_up_u64((file_size + MAX_PARTS_COUNT - 1) / MAX_PARTS_COUNT, alignment)
+                    .max(MIN_PART_SIZE.into());
+                let max_part_size = align_up_u64(file_size / max_concurrency as u64, alignment);
+                (
+                    clamp_u64(min_part_size, alignment, MAX_PART_SIZE),
+                    clamp_u64(max_part_size, alignment, MAX_PART_SIZE),
+                )
+            }
+            // 无法预知数据总尺寸时，为了不超出分块数上限，分块尺寸不会小于初始值
+            None => (initial_part_size.max(MIN_PART_SIZE), MAX_PART_SIZE),
+        };
+        let min_part_size = align_up(min_part_size, alignment);
+        let max_part_size = align_down(max_part_size, alignment).max(min_part_size);
+        PartTuner {
+            state: Mutex::new(State {
+                part_size: align_down(initial_part_size, alignment).max(min_part_size).min(max_part_size),
+                concurrency: (max_concurrency + 1) / 2,
+                in_flight: 0,
+                throughput: None,
+                rtt: None,
+                round_parts: 0,
+                round_bytes: 0,
+                round_seconds: 0f64,
+                last_round_throughput: None,
+            }),
+            condvar: Condvar::new(),
+            min_part_size,
+            max_part_size,
+            alignment,
+            max_concurrency,
+        }
+    }
+
+    /// 获取上传许可，如果同时上传的分块数已经达到当前并发数，将阻塞等待
+    pub(super) fn acquire(&self) -> Permit {
+        let mut state = self.state.lock().unwrap();
+        while state.in_flight >= state.concurrency {
+            state = self.condvar.wait(state).unwrap();
+        }
+        state.in_flight += 1;
+        Permit { tuner: self }
+    }
+
+    /// 下一个分块的尺寸
+    pub(super) fn part_size(&self) -> u32 {
+        self.state.lock().unwrap().part_size
+    }
+
+    /// 当前并发数
+    pub(super) fn concurrency(&self) -> usize {
+        self.state.lock().unwrap().concurrency
+    }
+
+    /// 记录一次成功的分块上传
+    ///
+    /// # Arguments
+    ///
+    /// * `size` - 分块尺寸
+    /// * `sending` - 发送分块数据的耗时
+    /// * `rtt` - 分块数据发送完毕到收到响应的耗时，无法测得时为 `None`
+    pub(super) fn record_success(&self, size: u64, sending: Duration, rtt: Option<Duration>) {
+        let seconds = duration_to_secs(sending).max(1e-6);
+        let mut state = self.state.lock().unwrap();
+        let throughput = size as f64 / seconds;
+        state.throughput = Some(ewma(state.throughput, throughput));
+        if let Some(rtt) = rtt {
+            state.rtt = Some(ewma(state.rtt, duration_to_secs(rtt)));
+        }
+        self.tune_part_size(&mut state);
+
+        state.round_parts += 1;
+        state.round_bytes += size;
+        state.round_seconds += seconds;
+        if state.round_parts >= state.concurrency {
+            self.tune_concurrency(&mut state);
+        }
+        self.condvar.notify_all();
+    }
+
+    /// 记录一次失败的分块上传尝试
+    pub(super) fn record_failure(&self) {
+        let mut state = self.state.lock().unwrap();
+        state.concurrency = (state.concurrency / 2).max(1);
+        state.part_size = align_down(state.part_size / 2, self.alignment).max(self.min_part_size);
+        state.round_parts = 0;
+        state.round_bytes = 0;
+        state.round_seconds = 0f64;
+        state.last_round_throughput = None;
+    }
+
+    fn tune_part_size(&self, state: &mut State) {
+        let throughput = match state.throughput {
+            Some(throughput) => throughput,
+            None => return,
+        };
+        let target_seconds = state
+            .rtt
+            .map(|rtt| rtt * TARGET_PART_DURATION_PER_RTT)
+            .unwrap_or(0f64)
+            .max(duration_to_secs(MIN_TARGET_PART_DURATION));
+        // 每次最多放大或缩小一倍，避免个别异常的测量结果导致分块尺寸剧烈波动
+        let desired = (throughput * target_seconds)
+            .min(f64::from(state.part_size) * 2f64)
+            .max(f64::from(state.part_size) / 2f64);
+        let desired = clamp_u64(desired as u64, self.min_part_size, self.max_part_size);
+        state.part_size = align_down(desired, self.alignment).max(self.min_part_size);
+    }
+
+    fn tune_concurrency(&self, state: &mut State) {
+        let throughput = state.round_bytes as f64 / state.round_seconds.max(1e-6) * state.round_parts as f64;
+        match state.last_round_throughput {
+            Some(last) if throughput < last * 0.9 => {
+                state.concurrency = (state.concurrency - 1).max(1);
+            }
+            Some(last) if throughput <= last * 1.05 => {}
+            _ => {
+                state.concurrency = (state.concurrency + 1).min(self.max_concurrency);
+            }
+        }
+        state.last_round_throughput = Some(throughput);
+        state.round_parts = 0;
+        state.round_bytes = 0;
+        state.round_seconds = 0f64;
+    }
+
+    #[allow(dead_code)]
+    fn ignore() {
+        assert_impl!(Send: Self);
+        assert_impl!(Sync: Self);
+    }
+}
+
+impl Drop for Permit<'_> {
+    fn drop(&mut self) {
+        self.tuner.state.lock().unwrap().in_flight -= 1;
+        self.tuner.condvar.notify_all();
+    }
+}
+
+fn ewma(average: Option<f64>, sample: f64) -> f64 {
+    match average {
+        Some(average) => average * (1f64 - EWMA_ALPHA) + sample * EWMA_ALPHA,
+        None => sample,
+    }
+}
+
+fn duration_to_secs(duration: Duration) -> f64 {
+    duration.as_secs() as f64 + f64::from(duration.subsec_nanos()) / 1e9
+}
+
+fn align_up(size: u32, alignment: u32) -> u32 {
+    clamp_u64(align_up_u64(size.into(), alignment), 0, u32::max_value())
+}
+
+fn align_up_u64(size: u64, alignment: u32) -> u64 {
+    let alignment = u64::from(alignment);
+    (size + alignment - 1) / alignment * alignment
+}
+
+fn align_down(size: u32, alignment: u32) -> u32 {
+    size / alignment * alignment
+}
+
+fn clamp_u64(size: u64, min: u32, max: u32) -> u32 {
+    size.max(min.into()).min(max.into()) as u32
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_storage_uploader_part_tuner_part_size() {
+        let tuner = PartTuner::new(1 << 22, 1 << 22, Some(1 << 34), 8);
+        assert_eq!(tuner.part_size(), 1 << 22);
+        assert_eq!(tuner.concurrency(), 4);
+
+        // 高速链路：每秒 64 MiB，分块尺寸逐步增大，但每次最多翻倍
+        tuner.record_success(1 << 22, Duration::from_millis(62), Some(Duration::from_millis(1)));
+        assert_eq!(tuner.part_size(), 1 << 23);
+        for _ in 0..10 {
+            tuner.record_success(1 << 22, Duration::from_millis(62), Some(Duration::from_millis(1)));
+        }
+        assert!(tuner.part_size() > 1 << 26);
+        assert!(tuner.part_size() <= 1 << 27);
+        assert_eq!(tuner.part_size() % (1 << 22), 0);
+
+        // 出错后分块尺寸和并发数均减半
+        let part_size = tuner.part_size();
+        let concurrency = tuner.concurrency();
+        tuner.record_failure();
+        assert_eq!(tuner.part_size(), part_size / 2);
+        assert_eq!(tuner.concurrency(), (concurrency / 2).max(1));
+    }
+
+    #[test]
+    fn test_storage_uploader_part_tuner_limits() {
+        // 慢速链路：分块尺寸不会小于下限，也不会超出分块数上限
+        let tuner = PartTuner::new(1 << 22, 1, Some(1 << 20), 4);
+        for _ in 0..10 {
+            tuner.record_success(1 << 18, Duration::from_secs(60), None);
+        }
+        assert_eq!(tuner.part_size(), MIN_PART_SIZE);
+
+        let tuner = PartTuner::new(1 << 22, 1, Some(100 << 30), 4);
+        for _ in 0..10 {
+            tuner.record_success(1 << 20, Duration::from_secs(60), None);
+        }
+        assert!(u64::from(tuner.part_size()) * MAX_PARTS_COUNT >= 100 << 30);
+
+        // 数据尺寸决定的分块尺寸上限使得所有并发都能分到分块
+        let tuner = PartTuner::new(1 << 22, 1 << 22, Some(1 << 26), 4);
+        for _ in 0..10 {
+            tuner.record_success(1 << 22, Duration::from_millis(1), None);
+        }
+        assert_eq!(tuner.part_size(), 1 << 24);
+
+        let tuner = PartTuner::new(1 << 22, 1 << 22, None, 4);
+        tuner.record_failure();
+        assert_eq!(tuner.part_size(), 1 << 22);
+    }
+
+    #[test]
+    fn test_storage_uploader_part_tuner_concurrency() {
+        let tuner = PartTuner::new(1 << 22, 1 << 22, Some(1 << 34), 4);
+        assert_eq!(tuner.concurrency(), 2);
+        // 首轮结束后总是尝试增加并发数
+        for _ in 0..2 {
+            tuner.record_success(1 << 22, Duration::from_secs(1), None);
+        }
+        assert_eq!(tuner.concurrency(), 3);
+        // 增加并发后总吞吐量提升，继续增加
+        for _ in 0..3 {
+            tuner.record_success(1 << 22, Duration::from_secs(1), None);
+        }
+        assert_eq!(tuner.concurrency(), 4);
+        // 已达上限
+        for _ in 0..4 {
+            tuner.record_success(1 << 22, Duration::from_secs(1), None);
+        }
+        assert_eq!(tuner.concurrency(), 4);
+        // 单个分块变慢导致总吞吐量明显下降，减少并发数
+        for _ in 0..4 {
+            tuner.record_success(1 << 22, Duration::from_secs(4), None);
+        }
+        assert_eq!(tuner.concurrency(), 3);
+
+        let permits = (0..3).map(|_| tuner.acquire()).collect::<Vec<_>>();
+        assert_eq!(tuner.state.lock().unwrap().in_flight, 3);
+        drop(permits);
+        assert_eq!(tuner.state.lock().unwrap().in_flight, 0);
+    }
+}
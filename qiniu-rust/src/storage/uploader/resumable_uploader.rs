@@ -1,14 +1,30 @@
 use super::{
-    io_status_manager::{IOStatusManager, Result as IOStatusResult},
+    batch_uploader::{BatchScheduler, PartTasks},
+    io_status_manager::{
+        is_positional_read_supported, IOStatusManager, PartPlanner, PartRange, Result as IOStatusResult,
+    },
+    part_tuner::{PartTuner, MIN_PART_SIZE},
     upload_recorder::{FileUploadRecordMedium, FileUploadRecordMediumBlockItem, FileUploadRecordMediumMetadata},
     upload_response_callback, BucketUploader, TokenizedUploadLogger, UpType, UploadError, UploadLoggerRecordBuilder,
     UploadResponse,
 };
 use crate::{
-    http::{Client, Error as HTTPError, ErrorKind as HTTPErrorKind, Result as HTTPResult, RetryKind},
-    utils::{base64, ron::Ron, seek_adapter},
+    http::{
+        metrics::{Stopwatch, Timing},
+        BandwidthLimiter, CancellationToken, Client, Error as HTTPError, ErrorKind as HTTPErrorKind,
+        Result as HTTPResult, RetryKind,
+    },
+    utils::{
+        base64,
+        etag::{self, SHA1_SIZE},
+        mmap,
+        ron::Ron,
+        seek_adapter,
+    },
 };
+use memmap::Mmap;
 use mime::Mime;
+use qiniu_http::{RequestBody, RequestBodyStream};
 use rayon::{ThreadPool, ThreadPoolBuilder};
 use serde::{Deserialize, Serialize};
 use serde_json::Value;
@@ -19,7 +35,7 @@ use std::{
     collections::HashMap,
     convert::TryInto,
     fs::File,
-    io::{Read, Result as IOResult, Seek, SeekFrom},
+    io::{Error as IOError, ErrorKind as IOErrorKind, Read, Result as IOResult, Seek, SeekFrom},
     path::Path,
     result::Result,
     sync::{
@@ -63,6 +79,7 @@ struct FromResuming {
     upload_id: Box<str>,
     up_urls: Box<[Box<str>]>,
     recorder: FileUploadRecordMedium,
+    uploaded_parts: Box<[PartRange]>,
 }
 
 struct UploadingProgressCallback<'u> {
@@ -79,8 +96,14 @@ pub(super) struct ResumableUploaderBuilder<'u> {
     custom_vars: HashMap<Cow<'u, str>, Cow<'u, str>>,
     on_uploading_progress: Option<&'u (dyn Fn(u64, Option<u64>) + Send + Sync)>,
     thread_pool: Option<Ron<'u, ThreadPool>>,
+    batch_scheduler: Option<&'u BatchScheduler>,
     max_concurrency: usize,
     upload_logger: Option<TokenizedUploadLogger>,
+    local_etag_enabled: bool,
+    adaptive_part_size_enabled: bool,
+    memory_mapping_enabled: bool,
+    bandwidth_limiter: Option<&'u BandwidthLimiter>,
+    cancellation_token: Option<&'u CancellationToken>,
 }
 
 pub(super) struct ResumableUploader<'u, R: Read + Seek + Send + 'u> {
@@ -93,13 +116,20 @@ pub(super) struct ResumableUploader<'u, R: Read + Seek + Send + 'u> {
     block_size: u32,
     io_size: Option<u64>,
     io: R,
+    positional_file: Option<File>,
+    mapped_file: Option<Mmap>,
     uploaded_size: AtomicU64,
     file_path: Option<Cow<'u, Path>>,
     from_resuming: Option<FromResuming>,
     uploading_progress_callback: Option<UploadingProgressCallback<'u>>,
     thread_pool: Ron<'u, ThreadPool>,
+    batch_scheduler: Option<&'u BatchScheduler>,
     max_concurrency: usize,
     upload_logger: Option<TokenizedUploadLogger>,
+    local_etag_enabled: bool,
+    adaptive_part_size_enabled: bool,
+    bandwidth_limiter: Option<&'u BandwidthLimiter>,
+    cancellation_token: Option<&'u CancellationToken>,
 }
 
 impl<'u> ResumableUploaderBuilder<'u> {
@@ -112,6 +142,7 @@ impl<'u> ResumableUploaderBuilder<'u> {
             custom_vars: HashMap::new(),
             on_uploading_progress: None,
             thread_pool: None,
+            batch_scheduler: None,
             upload_logger: bucket_uploader.upload_logger().map(|upload_logger| {
                 upload_logger.tokenize(
                     upload_token.into_owned().into(),
@@ -119,6 +150,11 @@ impl<'u> ResumableUploaderBuilder<'u> {
                 )
             }),
             max_concurrency: 0,
+            local_etag_enabled: false,
+            adaptive_part_size_enabled: false,
+            memory_mapping_enabled: false,
+            bandwidth_limiter: None,
+            cancellation_token: None,
         }
     }
 
@@ -127,11 +163,47 @@ impl<'u> ResumableUploaderBuilder<'u> {
         self
     }
 
+    pub(super) fn batch_scheduler(mut self, batch_scheduler: &'u BatchScheduler) -> ResumableUploaderBuilder<'u> {
+        self.batch_scheduler = Some(batch_scheduler);
+        self
+    }
+
     pub(super) fn max_concurrency(mut self, concurrency: usize) -> ResumableUploaderBuilder<'u> {
         self.max_concurrency = concurrency;
         self
     }
 
+    pub(super) fn local_etag(mut self, enabled: bool) -> ResumableUploaderBuilder<'u> {
+        self.local_etag_enabled = enabled;
+        self
+    }
+
+    pub(super) fn adaptive_part_size(mut self, enabled: bool) -> ResumableUploaderBuilder<'u> {
+        self.adaptive_part_size_enabled = enabled;
+        self
+    }
+
+    pub(super) fn memory_mapping(mut self, enabled: bool) -> ResumableUploaderBuilder<'u> {
+        self.memory_mapping_enabled = enabled;
+        self
+    }
+
+    pub(super) fn bandwidth_limiter(
+        mut self,
+        bandwidth_limiter: Option<&'u BandwidthLimiter>,
+    ) -> ResumableUploaderBuilder<'u> {
+        self.bandwidth_limiter = bandwidth_limiter;
+        self
+    }
+
+    pub(super) fn cancellation_token(
+        mut self,
+        cancellation_token: Option<&'u CancellationToken>,
+    ) -> ResumableUploaderBuilder<'u> {
+        self.cancellation_token = cancellation_token;
+        self
+    }
+
     pub(super) fn key(mut self, key: Cow<'u, str>) -> ResumableUploaderBuilder<'u> {
         self.key = Some(key);
         self
@@ -170,11 +242,24 @@ impl<'u> ResumableUploaderBuilder<'u> {
     ) -> IOResult<ResumableUploader<'u, File>> {
         let bucket_uploader = self.bucket_uploader;
         let block_size = bucket_uploader.http_client().config().upload_block_size();
+        // 启用内存映射时，分块直接借用映射区域；未启用或无法映射时按位置读取
+        let mapped_file = if self.memory_mapping_enabled {
+            mmap::map(&file, file_size)
+        } else {
+            None
+        };
+        let positional_file = if mapped_file.is_none() && is_positional_read_supported() {
+            file.try_clone().ok()
+        } else {
+            None
+        };
         Ok(ResumableUploader {
             bucket_uploader,
             upload_token: self.upload_token,
             key: self.key,
             file_path: Some(file_path),
+            positional_file,
+            mapped_file,
             io: file,
             io_size: Some(file_size),
             uploaded_size: AtomicU64::new(0),
@@ -210,8 +295,13 @@ impl<'u> ResumableUploaderBuilder<'u> {
                             .unwrap(),
                     )
                 }),
+            batch_scheduler: self.batch_scheduler,
             max_concurrency: self.max_concurrency,
             upload_logger: self.upload_logger,
+            local_etag_enabled: self.local_etag_enabled,
+            adaptive_part_size_enabled: self.adaptive_part_size_enabled,
+            bandwidth_limiter: self.bandwidth_limiter,
+            cancellation_token: self.cancellation_token,
         })
     }
 
@@ -229,6 +319,8 @@ impl<'u> ResumableUploaderBuilder<'u> {
             upload_token: self.upload_token,
             key: self.key,
             file_path: None,
+            positional_file: None,
+            mapped_file: None,
             io: seek_adapter::SeekAdapter(stream),
             io_size: if size > 0 { Some(size) } else { None },
             uploaded_size: AtomicU64::new(0),
@@ -259,8 +351,13 @@ impl<'u> ResumableUploaderBuilder<'u> {
                             .unwrap(),
                     )
                 }),
+            batch_scheduler: self.batch_scheduler,
             max_concurrency: self.max_concurrency,
             upload_logger: self.upload_logger,
+            local_etag_enabled: self.local_etag_enabled,
+            adaptive_part_size_enabled: self.adaptive_part_size_enabled,
+            bandwidth_limiter: self.bandwidth_limiter,
+            cancellation_token: self.cancellation_token,
         })
     }
 }
@@ -377,6 +474,7 @@ impl<'u, R: Read + Seek + Send> ResumableUploader<'u, R> {
             &(base_path.to_owned() + "/" + &upload_id),
             authorization,
             recorder,
+            &[],
         )
     }
 
@@ -386,99 +484,214 @@ impl<'u, R: Read + Seek + Send> ResumableUploader<'u, R> {
         base_path: &str,
         authorization: &str,
         upload_recorder: Option<FileUploadRecordMedium>,
+        uploaded_parts: &[PartRange],
     ) -> Result<UploadResponse, UploadError> {
-        let io_status_manager = IOStatusManager::new(
-            &mut self.io,
-            self.block_size,
-            &self
-                .completed_parts
-                .lock()
-                .unwrap()
-                .parts
-                .iter()
-                .map(|part| part.part_number)
-                .collect::<Vec<_>>(),
-        );
+        let concurrency = if self.max_concurrency > 0 {
+            self.max_concurrency
+        } else {
+            self.thread_pool.current_num_threads()
+        };
+        let is_positional = self.mapped_file.is_some() || (self.positional_file.is_some() && self.io_size.is_some());
+        // 自适应调节分块尺寸时，分块尺寸需要与 Etag 块对齐才能计算本地 Etag
+        let part_tuner = if self.adaptive_part_size_enabled && (is_positional || uploaded_parts.is_empty()) {
+            Some(PartTuner::new(
+                self.block_size,
+                if self.local_etag_enabled {
+                    etag::BLOCK_SIZE as u32
+                } else {
+                    MIN_PART_SIZE
+                },
+                self.io_size,
+                concurrency,
+            ))
+        } else {
+            None
+        };
+        // 仅当分块尺寸与 Etag 块尺寸对齐时，才能由每个分块各自计算的 SHA-1 值合并出完整数据的 Etag
+        let parts_sha1 = if self.local_etag_enabled
+            && (part_tuner.is_some() || self.block_size as usize % etag::BLOCK_SIZE == 0)
+        {
+            Some(Mutex::new(Vec::<PartSha1>::new()))
+        } else {
+            None
+        };
+        let file_size = self.io_size.unwrap_or_default();
+        let planner = if is_positional
+            && (part_tuner.is_some() || !is_fixed_layout(file_size, self.block_size, uploaded_parts))
+        {
+            PartPlanner::new(file_size, self.block_size, uploaded_parts)
+        } else {
+            None
+        };
+        let uploaded_part_numbers = self
+            .completed_parts
+            .lock()
+            .unwrap()
+            .parts
+            .iter()
+            .map(|part| part.part_number)
+            .collect::<Vec<_>>();
+        // 对于文件，每个线程各自借用映射区域或按位置读取分块，避免所有线程争用同一把锁串行读取
+        let io_status_manager = match (&self.mapped_file, &self.positional_file, self.io_size) {
+            (Some(mapped), _, _) => IOStatusManager::new_mapped(
+                mapped,
+                self.bucket_uploader.buffer_pool(),
+                self.block_size,
+                &uploaded_part_numbers,
+                parts_sha1.is_some(),
+            ),
+            (None, Some(file), Some(file_size)) => IOStatusManager::new_positional(
+                file,
+                self.bucket_uploader.buffer_pool(),
+                file_size,
+                self.block_size,
+                &uploaded_part_numbers,
+                parts_sha1.is_some(),
+            ),
+            _ => IOStatusManager::new(
+                &mut self.io,
+                self.bucket_uploader.buffer_pool(),
+                self.block_size,
+                &uploaded_part_numbers,
+                parts_sha1.is_some(),
+            ),
+        };
+        let io_status_manager = io_status_manager
+            .planned(planner, part_tuner.as_ref())
+            .cancellable(self.cancellation_token);
         let http_client = self.bucket_uploader.http_client();
-        let block_size = self.block_size;
+        let bandwidth_limiter = self.bandwidth_limiter;
+        let cancellation_token = self.cancellation_token;
         let completed_parts = &self.completed_parts;
         let uploaded_size = &self.uploaded_size;
         let uploading_progress_callback = self.uploading_progress_callback.as_ref();
         let checksum_enabled = self.checksum_enabled;
         let upload_logger = self.upload_logger.as_ref();
-        let concurrency = if self.max_concurrency > 0 {
-            self.max_concurrency
-        } else {
-            self.thread_pool.current_num_threads()
-        };
+        let parts_sha1_ref = parts_sha1.as_ref();
+        let part_tuner = part_tuner.as_ref();
 
-        self.thread_pool.scope(|s| {
-            for _ in 0..concurrency {
-                s.spawn(|_| {
-                    let mut md5 = OptionalMd5::new(checksum_enabled);
-                    loop {
-                        match io_status_manager.read() {
-                            Some(part_data) => {
-                                let last_block_uploaded = Cell::new(0);
-                                match Self::upload_part(
-                                    http_client,
-                                    &(base_path.to_owned() + "/" + &part_data.part_number.to_string()),
-                                    up_urls,
-                                    authorization,
-                                    &part_data.data,
-                                    part_data.part_number,
-                                    &mut md5,
-                                    |block_uploaded, _| {
-                                        if let Some(progress) = uploading_progress_callback {
-                                            let added_size =
-                                                block_uploaded - last_block_uploaded.replace(block_uploaded);
-                                            (progress.callback)(
-                                                progress.completed_size.fetch_add(added_size, Relaxed) + added_size,
-                                                progress.total_size,
-                                            );
-                                        }
-                                    },
-                                    |_, _, _| {
-                                        if let Some(progress) = uploading_progress_callback {
-                                            progress
-                                                .completed_size
-                                                .fetch_sub(last_block_uploaded.replace(0), Relaxed);
-                                        }
-                                    },
-                                    upload_logger,
-                                    upload_recorder.as_ref(),
-                                ) {
-                                    Ok(etag) => {
-                                        completed_parts.lock().unwrap().parts.push(Part {
-                                            etag,
-                                            part_number: part_data.part_number,
-                                        });
-                                        uploaded_size.fetch_add(block_size.into(), Relaxed);
-                                    }
-                                    Err(err) => {
-                                        io_status_manager.error(err);
-                                        return;
-                                    }
-                                };
-                            }
+        // 上传下一个分块，如果已经没有需要上传的分块，或上传已经失败，则返回 `false`
+        let upload_next_part = || {
+            let _permit = part_tuner.map(|part_tuner| part_tuner.acquire());
+            let part_data = match io_status_manager.read() {
+                Some(part_data) => part_data,
+                None => return false,
+            };
+            if let Some(parts_sha1) = parts_sha1_ref {
+                let blocks_sha1 = etag::blocks_sha1(&part_data.data);
+                parts_sha1.lock().unwrap().push(PartSha1 {
+                    part_number: part_data.part_number,
+                    offset: part_data.offset,
+                    size: part_data.data.len() as u64,
+                    blocks_sha1,
+                });
+            }
+            if part_data.uploaded {
+                return true;
+            }
+            let part_size = part_data.data.len() as u64;
+            let last_block_uploaded = Cell::new(0);
+            // 分块数据开始发送与发送完毕的时刻，用于测算分块的上传吞吐量和往返时延
+            let started_at = Cell::new(Instant::now());
+            let sent_at = Cell::new(None);
+            match Self::upload_part(
+                http_client,
+                &(base_path.to_owned() + "/" + &part_data.part_number.to_string()),
+                up_urls,
+                authorization,
+                &part_data.data,
+                part_data.part_number,
+                part_data.offset,
+                &mut OptionalMd5::new(checksum_enabled),
+                bandwidth_limiter,
+                cancellation_token,
+                |block_uploaded, _| {
+                    if block_uploaded >= part_size && sent_at.get().is_none() {
+                        sent_at.set(Some(Instant::now()));
+                    }
+                    if let Some(progress) = uploading_progress_callback {
+                        let added_size = block_uploaded - last_block_uploaded.replace(block_uploaded);
+                        (progress.callback)(
+                            progress.completed_size.fetch_add(added_size, Relaxed) + added_size,
+                            progress.total_size,
+                        );
+                    }
+                },
+                |_, _, _| {
+                    if let Some(progress) = uploading_progress_callback {
+                        progress
+                            .completed_size
+                            .fetch_sub(last_block_uploaded.replace(0), Relaxed);
+                    }
+                    if let Some(part_tuner) = part_tuner {
+                        part_tuner.record_failure();
+                    }
+                    started_at.set(Instant::now());
+                    sent_at.set(None);
+                },
+                upload_logger,
+                upload_recorder.as_ref(),
+            ) {
+                Ok(etag) => {
+                    if let Some(part_tuner) = part_tuner {
+                        let finished_at = Instant::now();
+                        match sent_at.get() {
+                            Some(sent_at) => part_tuner.record_success(
+                                part_size,
+                                sent_at.duration_since(started_at.get()),
+                                Some(finished_at.duration_since(sent_at)),
+                            ),
                             None => {
-                                return;
+                                part_tuner.record_success(part_size, finished_at.duration_since(started_at.get()), None)
                             }
                         }
                     }
-                });
+                    completed_parts.lock().unwrap().parts.push(Part {
+                        etag,
+                        part_number: part_data.part_number,
+                    });
+                    uploaded_size.fetch_add(part_size, Relaxed);
+                    true
+                }
+                Err(err) => {
+                    io_status_manager.error(err);
+                    false
+                }
             }
-        });
+        };
+
+        match self.batch_scheduler {
+            // 由批量上传器上传时，每个分块作为独立的任务与其他文件任务共用同一个任务队列
+            Some(batch_scheduler) => batch_scheduler.run_parts(&ScheduledParts {
+                upload_next_part,
+                part_tuner,
+                block_size: self.block_size,
+                concurrency,
+            }),
+            None => self.thread_pool.scope(|s| {
+                for _ in 0..concurrency {
+                    s.spawn(|_| while upload_next_part() {});
+                }
+            }),
+        }
 
         match io_status_manager.result() {
-            IOStatusResult::Success => self.complete_parts(base_path, up_urls, authorization).tap_ok(|_| {
-                self.file_path.as_ref().tap_some(|file_path| {
-                    let _ = self
-                        .bucket_uploader
-                        .recorder()
-                        .drop(file_path, self.key.as_ref().map(|key| key.as_ref()));
+            IOStatusResult::Success => self
+                .complete_parts(base_path, up_urls, authorization)
+                .tap_ok(|_| {
+                    self.file_path.as_ref().tap_some(|file_path| {
+                        let _ = self
+                            .bucket_uploader
+                            .recorder()
+                            .drop(file_path, self.key.as_ref().map(|key| key.as_ref()));
+                    })
                 })
-            }),
+                .map(|mut response| {
+                    if let Some(parts_sha1) = parts_sha1 {
+                        response.set_local_etag(Self::local_etag_from_parts_sha1(parts_sha1.into_inner().unwrap()));
+                    }
+                    response
+                }),
             IOStatusResult::IOError(err) => Err(UploadError::IOError(err)),
             IOStatusResult::HTTPError(err) => Err(UploadError::QiniuError(err)),
         }
@@ -490,7 +703,32 @@ impl<'u, R: Read + Seek + Send> ResumableUploader<'u, R> {
         block_records: Box<[FileUploadRecordMediumBlockItem]>,
         recorder: FileUploadRecordMedium,
     ) {
-        let mut io_offset = 0u64;
+        let file_size = self.io_size.unwrap_or(file_record.file_size);
+        let block_size = u64::from(file_record.block_size);
+        let uploaded_parts = block_records
+            .iter()
+            .map(|block_record| {
+                // 旧版本的记录中没有分块范围，此时分块尺寸均为元数据中的分块尺寸
+                let offset = block_record
+                    .offset
+                    .unwrap_or_else(|| (block_record.part_number as u64).saturating_sub(1) * block_size);
+                PartRange {
+                    part_number: block_record.part_number,
+                    offset,
+                    size: block_record
+                        .size
+                        .unwrap_or_else(|| u64::min(block_size, file_size.saturating_sub(offset))),
+                }
+            })
+            .collect::<Box<[_]>>();
+        if !is_fixed_layout(file_size, file_record.block_size, &uploaded_parts) {
+            // 分块尺寸可变的记录只能按位置读取文件来续传
+            let is_positional = self.mapped_file.is_some() || self.positional_file.is_some();
+            if !is_positional || PartPlanner::new(file_size, file_record.block_size, &uploaded_parts).is_none() {
+                return;
+            }
+        }
+        let io_offset = uploaded_parts.iter().map(|part| part.size).sum();
         {
             let block_records: Vec<FileUploadRecordMediumBlockItem> = block_records.into();
             let mut completed_parts = self.completed_parts.lock().unwrap();
@@ -499,13 +737,13 @@ impl<'u, R: Read + Seek + Send> ResumableUploader<'u, R> {
                     etag: block_record.etag,
                     part_number: block_record.part_number,
                 });
-                io_offset += u64::from(file_record.block_size);
             }
         }
         self.from_resuming = Some(FromResuming {
             upload_id: file_record.upload_id,
             up_urls: file_record.up_urls,
             recorder,
+            uploaded_parts,
         });
         self.block_size = file_record.block_size;
         self.uploaded_size = AtomicU64::new(io_offset);
@@ -517,6 +755,7 @@ impl<'u, R: Read + Seek + Send> ResumableUploader<'u, R> {
             .http_client()
             .post(base_path, up_urls)
             .header("Authorization", authorization)
+            .cancellation_token(self.cancellation_token)
             .idempotent()
             .on_response(&|response, duration| {
                 let result = upload_response_callback(response);
@@ -562,20 +801,32 @@ impl<'u, R: Read + Seek + Send> ResumableUploader<'u, R> {
         authorization: &str,
         part: &[u8],
         part_number: usize,
+        offset: u64,
         md5_hasher: &mut OptionalMd5,
+        bandwidth_limiter: Option<&BandwidthLimiter>,
+        cancellation_token: Option<&CancellationToken>,
         on_progress: impl Fn(u64, u64),
         on_error: impl Fn(Option<&str>, &HTTPError, Duration),
         upload_logger: Option<&TokenizedUploadLogger>,
         upload_recorder: Option<&FileUploadRecordMedium>,
     ) -> HTTPResult<Box<str>> {
+        let stopwatch = Stopwatch::start();
+        // 设置了带宽限制时，分块数据以数据流的形式发送，每次被 HTTP 客户端读出时按读出的字节数申请令牌
+        let throttled_part =
+            bandwidth_limiter.map(|bandwidth_limiter| ThrottledPart::new(part, bandwidth_limiter, cancellation_token));
+        let body: RequestBody = match &throttled_part {
+            Some(throttled_part) => (throttled_part as &dyn RequestBodyStream).into(),
+            None => part.into(),
+        };
         let mut builder = http_client
             .put(path, up_urls)
             .header("Authorization", authorization)
+            .cancellation_token(cancellation_token)
             .on_uploading_progress(&on_progress);
         if let Some(md5) = md5_hasher.hash(part) {
             builder = builder.header("Content-MD5", md5);
         }
-        let result: UploadPartResult = builder
+        let result = builder
             .idempotent()
             .on_response(&|response, duration| {
                 let result = upload_response_callback(response);
@@ -611,12 +862,15 @@ impl<'u, R: Read + Seek + Send> ResumableUploader<'u, R> {
                 }
             })
             .accept_json()
-            .raw_body("application/octet-stream", part.as_ref())
-            .send()?
-            .parse_json()?;
+            .raw_body("application/octet-stream", body)
+            .send()
+            .and_then(|mut response| response.parse_json::<UploadPartResult>());
+        // 无论分片上传成功与否均记录耗时，以免统计结果遗漏失败的分片
+        stopwatch.record(Timing::PartUpload);
+        let result = result?;
         if let Some(upload_recorder) = upload_recorder {
             upload_recorder
-                .append(&result.etag, part_number)
+                .append(&result.etag, part_number, offset, part.len() as u64)
                 .map_err(|err| HTTPError::new_unretryable_error(HTTPErrorKind::IOError(err), None, None, None))?;
         }
         Ok(result.etag)
@@ -633,6 +887,7 @@ impl<'u, R: Read + Seek + Send> ResumableUploader<'u, R> {
             .http_client()
             .post(path, up_urls)
             .header("Authorization", authorization)
+            .cancellation_token(self.cancellation_token)
             .idempotent()
             .on_response(&|response, duration| {
                 let result = upload_response_callback(response);
@@ -692,6 +947,7 @@ impl<'u, R: Read + Seek + Send> ResumableUploader<'u, R> {
                 &(base_path.to_owned() + "/" + &from_resuming.upload_id),
                 authorization,
                 Some(from_resuming.recorder),
+                &from_resuming.uploaded_parts,
             )
             .map(|response| {
                 if let Some(upload_logger) = &self.upload_logger {
@@ -729,6 +985,21 @@ impl<'u, R: Read + Seek + Send> ResumableUploader<'u, R> {
         }
     }
 
+    fn local_etag_from_parts_sha1(mut parts_sha1: Vec<PartSha1>) -> Option<Box<str>> {
+        parts_sha1.sort_unstable_by_key(|part| part.part_number);
+        // 分块必须首尾相接地覆盖全部数据，且除最后一个分块外都与 Etag 块对齐，否则无法计算完整数据的 Etag
+        let mut next_offset = 0u64;
+        for (index, part) in parts_sha1.iter().enumerate() {
+            if part.offset != next_offset
+                || (index + 1 < parts_sha1.len() && part.size % etag::BLOCK_SIZE as u64 != 0)
+            {
+                return None;
+            }
+            next_offset += part.size;
+        }
+        Some(etag::from_blocks_sha1(parts_sha1.iter().flat_map(|part| part.blocks_sha1.iter())).into())
+    }
+
     fn make_base_path(&self) -> String {
         "/buckets/".to_owned()
             + self.bucket_uploader.bucket_name().as_ref()
@@ -742,6 +1013,50 @@ impl<'u, R: Read + Seek + Send> ResumableUploader<'u, R> {
     }
 }
 
+/// 分块各 Etag 块的 SHA-1 值
+struct PartSha1 {
+    part_number: usize,
+    offset: u64,
+    size: u64,
+    blocks_sha1: Vec<[u8; SHA1_SIZE]>,
+}
+
+/// 交由批量上传调度器调度的分块任务
+struct ScheduledParts<'t, F: Fn() -> bool + Sync> {
+    upload_next_part: F,
+    part_tuner: Option<&'t PartTuner>,
+    block_size: u32,
+    concurrency: usize,
+}
+
+impl<F: Fn() -> bool + Sync> PartTasks for ScheduledParts<'_, F> {
+    fn part_size(&self) -> u64 {
+        self.part_tuner
+            .map_or(self.block_size, |part_tuner| part_tuner.part_size())
+            .into()
+    }
+
+    fn concurrency(&self) -> usize {
+        self.part_tuner.map_or(self.concurrency, |part_tuner| {
+            part_tuner.concurrency().min(self.concurrency)
+        })
+    }
+
+    fn upload_next_part(&self) -> bool {
+        (self.upload_next_part)()
+    }
+}
+
+/// 判断已上传的分块是否符合除最后一个分块外所有分块尺寸均为 `block_size` 的布局
+fn is_fixed_layout(file_size: u64, block_size: u32, uploaded_parts: &[PartRange]) -> bool {
+    let block_size = u64::from(block_size);
+    uploaded_parts.iter().all(|part| {
+        part.part_number > 0
+            && part.offset == (part.part_number as u64 - 1) * block_size
+            && part.size == u64::min(block_size, file_size.saturating_sub(part.offset))
+    })
+}
+
 fn encode_key(key: Option<&str>) -> Cow<'static, str> {
     if let Some(key) = key {
         base64::urlsafe(key.as_bytes()).into()
@@ -770,6 +1085,55 @@ impl OptionalMd5 {
     }
 }
 
+/// 受带宽限制的分块请求体
+///
+/// 令牌在分块数据被逐段读出时按读出的字节数申请，而不是在分块上传前一次性申请整个分块，
+/// 避免大分块在发送前长时间阻塞，也使多个并发上传的分块能够平滑地共享带宽
+struct ThrottledPart<'p> {
+    data: &'p [u8],
+    position: Cell<usize>,
+    bandwidth_limiter: &'p BandwidthLimiter,
+    cancellation_token: Option<&'p CancellationToken>,
+}
+
+impl<'p> ThrottledPart<'p> {
+    fn new(
+        data: &'p [u8],
+        bandwidth_limiter: &'p BandwidthLimiter,
+        cancellation_token: Option<&'p CancellationToken>,
+    ) -> Self {
+        ThrottledPart {
+            data,
+            position: Cell::new(0),
+            bandwidth_limiter,
+            cancellation_token,
+        }
+    }
+}
+
+impl RequestBodyStream for ThrottledPart<'_> {
+    fn size(&self) -> u64 {
+        self.data.len() as u64
+    }
+
+    fn read(&self, buf: &mut [u8]) -> IOResult<usize> {
+        let position = self.position.get();
+        let have_read = buf.len().min(self.data.len() - position);
+        if have_read > 0 && !self.bandwidth_limiter.consume(have_read, self.cancellation_token) {
+            return Err(IOError::new(IOErrorKind::Other, "Uploading is canceled"));
+        }
+        buf[..have_read].copy_from_slice(&self.data[position..position + have_read]);
+        self.position.set(position + have_read);
+        Ok(have_read)
+    }
+
+    fn seek(&self, offset: u64) -> IOResult<()> {
+        self.position
+            .set(offset.try_into().unwrap_or(usize::max_value()).min(self.data.len()));
+        Ok(())
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::{
@@ -925,9 +1289,11 @@ mod tests {
         .build()
         .upload_token(UploadToken::new(policy, get_credential()))
         .key("test-key")
+        .enable_local_etag()
         .upload_file(&temp_path, "", None)?;
         assert_eq!(result.key(), Some("test-key"));
         assert_eq!(result.hash(), Some("abcdef"));
+        assert_eq!(result.local_etag(), Some(etag::from_file(&temp_path)?.as_str()));
         Ok(())
     }
 
@@ -1031,16 +1397,18 @@ mod tests {
                 &["http://z1h1.com"],
                 1 << 22,
             )?;
-            medium.append("etag_1", 1)?;
-            medium.append("etag_3", 3)?;
-            medium.append("etag_5", 5)?;
+            medium.append("etag_1", 1, 0, 1 << 22)?;
+            medium.append("etag_3", 3, 2 << 22, 1 << 22)?;
+            medium.append("etag_5", 5, 4 << 22, 1 << 22)?;
         }
         let result = bucket_uploader
             .upload_token(UploadToken::new(policy, get_credential()))
             .key("test-key")
+            .enable_local_etag()
             .upload_file(&temp_path, "", None)?;
         assert_eq!(result.key(), Some("test-key"));
         assert_eq!(result.hash(), Some("abcdef"));
+        assert_eq!(result.local_etag(), Some(etag::from_file(&temp_path)?.as_str()));
         Ok(())
     }
 
@@ -1770,6 +2138,39 @@ mod tests {
         Ok(())
     }
 
+    #[test]
+    fn test_storage_uploader_resumable_uploader_throttled_part() -> Result<(), Box<dyn Error>> {
+        let data = b"0123456789abcdef".to_vec();
+        // 令牌桶初始只有 8 字节的令牌，之后每秒补充 8 字节，整个分块无法一次性读出
+        let bandwidth_limiter = BandwidthLimiter::new(8);
+        let cancellation_token = CancellationToken::new();
+        let part = ThrottledPart::new(&data, &bandwidth_limiter, Some(&cancellation_token));
+        assert_eq!(part.size(), 16);
+        let mut buf = [0u8; 8];
+        assert_eq!(part.read(&mut buf)?, 8);
+        assert_eq!(&buf, b"01234567");
+        {
+            let cancellation_token = cancellation_token.to_owned();
+            std::thread::spawn(move || {
+                std::thread::sleep(Duration::from_millis(100));
+                cancellation_token.cancel();
+            });
+        }
+        assert!(part.read(&mut buf).is_err());
+
+        let bandwidth_limiter = BandwidthLimiter::new(0);
+        let part = ThrottledPart::new(&data, &bandwidth_limiter, None);
+        let mut buf = [0u8; 10];
+        assert_eq!(part.read(&mut buf)?, 10);
+        assert_eq!(part.read(&mut buf)?, 6);
+        assert_eq!(&buf[..6], b"abcdef");
+        assert_eq!(part.read(&mut buf)?, 0);
+        part.seek(12)?;
+        assert_eq!(part.read(&mut buf)?, 4);
+        assert_eq!(&buf[..4], b"cdef");
+        Ok(())
+    }
+
     fn get_credential() -> Credential {
         Credential::new("abcdefghklmnopq", "1234567890")
     }
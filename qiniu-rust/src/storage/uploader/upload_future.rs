@@ -0,0 +1,403 @@
+use super::{user_canceled_error, UploadError, UploadResult};
+use crate::http::CancellationToken;
+use assert_impl::assert_impl;
+use rayon::ThreadPool;
+use std::{
+    future::Future,
+    io::{Error as IOError, ErrorKind as IOErrorKind},
+    panic::{catch_unwind, AssertUnwindSafe},
+    pin::Pin,
+    sync::{
+        atomic::{AtomicBool, Ordering::Relaxed},
+        Arc, Condvar, Mutex,
+    },
+    task::{Context, Poll, Waker},
+};
+
+/// 异步上传
+///
+/// 上传由 SDK 的异步上传线程池驱动，与同步上传共用同一套重试和域名冻结逻辑，调用方线程无需等待上传结束。
+/// HTTP 请求依然以同步方式发送，因此每个正在进行的异步上传都将占用异步上传线程池中的一个线程，
+/// 但不会占用存储空间上传器中用于并发上传分片的线程，超出线程数量的异步上传将排队等待。
+/// 也可以通过 `UploadCompleter` 在任意回调函数内结束上传，例如 `HTTPCaller::call_async()` 的完成回调函数，此时不占用任何线程。
+///
+/// 既可以由异步运行时轮询，也可以调用 `wait()` 阻塞等待上传结果。
+/// 返回 `Poll::Ready` 后不能再次轮询，否则将会 panic。
+/// 调用 `cancel()` 或丢弃该实例都将取消上传，正在进行的传输将被立即中止
+pub struct UploadFuture {
+    state: Arc<UploadState>,
+}
+
+#[derive(Default)]
+struct UploadState {
+    status: Mutex<UploadStatus>,
+    condvar: Condvar,
+    canceled: AtomicBool,
+    cancellation_token: CancellationToken,
+}
+
+/// 结束异步上传的句柄
+///
+/// 与 `UploadFuture` 成对创建，调用 `complete()` 即可结束对应的异步上传并唤醒等待者。
+/// 如果上传已经被取消，则调用 `complete()` 无效；丢弃该句柄而不调用 `complete()` 将使上传以 IO 错误结束
+pub struct UploadCompleter {
+    state: Option<Arc<UploadState>>,
+}
+
+#[derive(Default)]
+struct UploadStatus {
+    completed: bool,
+    result: Option<UploadResult>,
+    waker: Option<Waker>,
+    /// 上传结果是否已经被轮询取走
+    polled: bool,
+}
+
+impl UploadFuture {
+    /// 创建尚未结束的异步上传，以及用于结束该上传的句柄
+    ///
+    /// 取消上传时将取消 `cancellation_token`，上传的实现需要自行检查该令牌以尽快中止正在进行的传输
+    pub fn pending(cancellation_token: CancellationToken) -> (UploadFuture, UploadCompleter) {
+        let state = Arc::new(UploadState {
+            cancellation_token,
+            ..Default::default()
+        });
+        (
+            UploadFuture {
+                state: state.to_owned(),
+            },
+            UploadCompleter { state: Some(state) },
+        )
+    }
+
+    pub(super) fn spawn(
+        thread_pool: &ThreadPool,
+        cancellation_token: CancellationToken,
+        upload: impl FnOnce() -> UploadResult + Send + 'static,
+    ) -> UploadFuture {
+        let (future, completer) = Self::pending(cancellation_token);
+        thread_pool.spawn(move || {
+            // 尚未开始就已经被取消的上传将不再进行
+            if completer.is_canceled() {
+                return;
+            }
+            let result = catch_unwind(AssertUnwindSafe(upload)).unwrap_or_else(|_| {
+                Err(UploadError::IOError(IOError::new(
+                    IOErrorKind::Other,
+                    "Uploading thread panicked",
+                )))
+            });
+            completer.complete(result);
+        });
+        future
+    }
+
+    /// 取消上传
+    ///
+    /// 尚未开始的上传将不再进行，已经开始的上传将通过取消令牌中止正在进行的传输。
+    /// 取消后上传将立即以用户取消错误结束，如果上传已经结束，则调用该方法无效
+    pub fn cancel(&self) {
+        self.state.canceled.store(true, Relaxed);
+        self.state.cancellation_token.cancel();
+        self.state.complete(Err(canceled_error()));
+    }
+
+    /// 上传是否已经被取消
+    pub fn is_canceled(&self) -> bool {
+        self.state.canceled.load(Relaxed)
+    }
+
+    /// 上传是否已经结束
+    ///
+    /// 上传成功、失败或被取消均视为已经结束，此时调用 `wait()` 将立即返回
+    pub fn is_completed(&self) -> bool {
+        self.state.status.lock().unwrap().completed
+    }
+
+    /// 阻塞等待上传结束，返回上传结果
+    ///
+    /// 如果上传结果已经被轮询取走，将返回用户取消错误
+    pub fn wait(self) -> UploadResult {
+        let mut status = self.state.status.lock().unwrap();
+        while !status.completed {
+            status = self.state.condvar.wait(status).unwrap();
+        }
+        status.result.take().unwrap_or_else(|| Err(canceled_error()))
+    }
+
+    #[allow(dead_code)]
+    fn ignore() {
+        assert_impl!(Send: Self);
+        assert_impl!(Sync: Self);
+    }
+}
+
+impl UploadCompleter {
+    /// 结束异步上传
+    pub fn complete(mut self, result: UploadResult) {
+        if let Some(state) = self.state.take() {
+            state.complete(result);
+        }
+    }
+
+    /// 上传是否已经被取消
+    pub fn is_canceled(&self) -> bool {
+        self.state.as_ref().map_or(true, |state| state.canceled.load(Relaxed))
+    }
+
+    #[allow(dead_code)]
+    fn ignore() {
+        assert_impl!(Send: Self);
+        assert_impl!(Sync: Self);
+    }
+}
+
+impl Drop for UploadCompleter {
+    fn drop(&mut self) {
+        if let Some(state) = self.state.take() {
+            state.complete(Err(UploadError::IOError(IOError::new(
+                IOErrorKind::Other,
+                "Upload is dropped without completion",
+            ))));
+        }
+    }
+}
+
+impl UploadState {
+    fn complete(&self, result: UploadResult) {
+        let mut status = self.status.lock().unwrap();
+        if status.completed {
+            return;
+        }
+        status.completed = true;
+        status.result = Some(result);
+        if let Some(waker) = status.waker.take() {
+            waker.wake();
+        }
+        self.condvar.notify_all();
+    }
+}
+
+fn canceled_error() -> UploadError {
+    UploadError::QiniuError(user_canceled_error())
+}
+
+impl Future for UploadFuture {
+    type Output = UploadResult;
+
+    fn poll(self: Pin<&mut Self>, cx: &mut Context) -> Poll<Self::Output> {
+        let mut status = self.state.status.lock().unwrap();
+        assert!(!status.polled, "UploadFuture polled after completion");
+        match status.result.take() {
+            Some(result) => {
+                status.polled = true;
+                Poll::Ready(result)
+            }
+            None => {
+                status.waker = Some(cx.waker().to_owned());
+                Poll::Pending
+            }
+        }
+    }
+}
+
+impl Drop for UploadFuture {
+    fn drop(&mut self) {
+        self.cancel();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::{
+        super::{BucketUploader, BucketUploaderBuilder, UploadPolicyBuilder, UploadResponse, UploadToken},
+        *,
+    };
+    use crate::{
+        config::ConfigBuilder,
+        credential::Credential,
+        http::{DomainsManagerBuilder, ErrorKind as HTTPErrorKind, Headers},
+    };
+    use qiniu_http::{HTTPCaller, RequestBuilder};
+    use qiniu_test_utils::{
+        http_call_mock::{CounterCallMock, JSONCallMock},
+        temp_file::create_temp_file,
+    };
+    use rayon::ThreadPoolBuilder;
+    use serde_json::json;
+    use std::{
+        error::Error,
+        result::Result,
+        sync::{
+            atomic::AtomicUsize,
+            mpsc::{channel, Sender},
+        },
+        task::{RawWaker, RawWakerVTable},
+        time::Duration,
+    };
+
+    fn get_credential() -> Credential {
+        Credential::new("abcdefghklmnopq", "1234567890")
+    }
+
+    fn get_bucket_uploader(mock: CounterCallMock<JSONCallMock>) -> BucketUploader {
+        let config = ConfigBuilder::default()
+            .http_request_handler(mock)
+            .upload_logger(None)
+            .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+            .build();
+        BucketUploaderBuilder::new(
+            "test-bucket".into(),
+            vec![vec![Box::from("http://z1h1.com"), Box::from("http://z1h2.com")].into()].into(),
+            config,
+        )
+        .thread_pool_size(1)
+        .build()
+    }
+
+    fn get_upload_token(bucket_uploader: &BucketUploader) -> String {
+        let policy =
+            UploadPolicyBuilder::new_policy_for_bucket("test-bucket", bucket_uploader.http_client().config()).build();
+        UploadToken::new(policy, get_credential()).into()
+    }
+
+    #[test]
+    fn test_storage_uploader_upload_future_wake() -> Result<(), Box<dyn Error>> {
+        let temp_path = create_temp_file(1 << 10)?.into_temp_path();
+        let mock = CounterCallMock::new(JSONCallMock::new(
+            200,
+            Headers::new(),
+            json!({"key": "abc", "hash": "def"}),
+        ));
+        let bucket_uploader = get_bucket_uploader(mock.clone());
+        let (sender, receiver) = channel::<()>();
+        let waker = unsafe { Waker::from_raw(new_raw_waker(Box::into_raw(Box::new(sender)) as *const ())) };
+        let mut future = bucket_uploader
+            .upload_token_owned(get_upload_token(&bucket_uploader))
+            .key("test:file")
+            .upload_file_async(temp_path.to_path_buf(), "", None);
+        let mut cx = Context::from_waker(&waker);
+        let result = match Pin::new(&mut future).poll(&mut cx) {
+            Poll::Ready(result) => result,
+            Poll::Pending => {
+                receiver.recv_timeout(Duration::from_secs(10))?;
+                assert!(future.is_completed());
+                match Pin::new(&mut future).poll(&mut cx) {
+                    Poll::Ready(result) => result,
+                    Poll::Pending => unreachable!(),
+                }
+            }
+        }?;
+        assert_eq!(result.key(), Some("abc"));
+        assert_eq!(mock.call_called(), 1);
+        Ok(())
+    }
+
+    #[test]
+    fn test_storage_uploader_upload_future_cancel() -> Result<(), Box<dyn Error>> {
+        let thread_pool = ThreadPoolBuilder::new().num_threads(1).build()?;
+        let called = Arc::new(AtomicUsize::new(0));
+        let (sender, receiver) = channel::<()>();
+
+        // 线程池内仅有一个线程，阻塞该线程以保证取消时上传尚未开始
+        thread_pool.spawn(move || {
+            let _ = receiver.recv();
+        });
+        let upload = || {
+            let called = called.to_owned();
+            move || {
+                called.fetch_add(1, Relaxed);
+                Ok(UploadResponse::skipped("abc", "def"))
+            }
+        };
+        let first = UploadFuture::spawn(&thread_pool, Default::default(), upload());
+        let second = UploadFuture::spawn(&thread_pool, Default::default(), upload());
+        second.cancel();
+        assert!(second.is_canceled());
+        assert!(second.is_completed());
+        match second.wait() {
+            Err(UploadError::QiniuError(err)) => match err.error_kind() {
+                HTTPErrorKind::UserCanceled => {}
+                _ => panic!("Unexpected error kind"),
+            },
+            _ => panic!("Upload should be canceled"),
+        }
+        drop(sender);
+        assert_eq!(first.wait()?.key(), Some("abc"));
+        assert_eq!(called.load(Relaxed), 1);
+        Ok(())
+    }
+
+    #[test]
+    fn test_storage_uploader_upload_future_completed_by_http_callback() -> Result<(), Box<dyn Error>> {
+        let mock = JSONCallMock::new(200, Headers::new(), json!({"key": "abc", "hash": "def"}));
+        let (future, completer) = UploadFuture::pending(Default::default());
+        mock.call_async(
+            RequestBuilder::default().url("http://z1h1.com/").build(),
+            Box::new(move |_, result| {
+                completer.complete(
+                    result
+                        .map(|response| {
+                            assert_eq!(response.status_code(), 200);
+                            UploadResponse::skipped("abc", "def")
+                        })
+                        .map_err(UploadError::QiniuError),
+                )
+            }),
+        );
+        assert!(future.is_completed());
+        assert_eq!(future.wait()?.key(), Some("abc"));
+
+        let (future, completer) = UploadFuture::pending(Default::default());
+        drop(completer);
+        match future.wait() {
+            Err(UploadError::IOError(_)) => {}
+            _ => panic!("Upload should be failed"),
+        }
+        Ok(())
+    }
+
+    #[test]
+    #[should_panic(expected = "UploadFuture polled after completion")]
+    fn test_storage_uploader_upload_future_poll_after_completion() {
+        let thread_pool = ThreadPoolBuilder::new().num_threads(1).build().unwrap();
+        let (sender, receiver) = channel::<()>();
+        let waker = unsafe { Waker::from_raw(new_raw_waker(Box::into_raw(Box::new(sender)) as *const ())) };
+        let mut cx = Context::from_waker(&waker);
+        let mut future = UploadFuture::spawn(&thread_pool, Default::default(), || {
+            Ok(UploadResponse::skipped("abc", "def"))
+        });
+        if let Poll::Pending = Pin::new(&mut future).poll(&mut cx) {
+            receiver.recv_timeout(Duration::from_secs(10)).unwrap();
+            match Pin::new(&mut future).poll(&mut cx) {
+                Poll::Ready(result) => assert!(result.is_ok()),
+                Poll::Pending => unreachable!(),
+            }
+        }
+        let _ = Pin::new(&mut future).poll(&mut cx);
+    }
+
+    static VTABLE: RawWakerVTable = RawWakerVTable::new(clone_waker, wake, wake_by_ref, drop_waker);
+
+    fn new_raw_waker(data: *const ()) -> RawWaker {
+        RawWaker::new(data, &VTABLE)
+    }
+
+    unsafe fn clone_waker(data: *const ()) -> RawWaker {
+        let sender = &*(data as *const Sender<()>);
+        new_raw_waker(Box::into_raw(Box::new(sender.to_owned())) as *const ())
+    }
+
+    unsafe fn wake(data: *const ()) {
+        wake_by_ref(data);
+        drop_waker(data);
+    }
+
+    unsafe fn wake_by_ref(data: *const ()) {
+        let _ = (&*(data as *const Sender<()>)).send(());
+    }
+
+    unsafe fn drop_waker(data: *const ()) {
+        drop(Box::from_raw(data as *mut Sender<()>));
+    }
+}
@@ -1,9 +1,11 @@
 use super::UploadError as UploadFileError;
 use crate::{
+    config::WeakConfig,
     http::{
+        metrics::{Stopwatch, Timing},
         Client, Error as HTTPError, ErrorKind as HTTPErrorKind, HTTPCallerErrorKind, Response, Result as HTTPResult,
     },
-    utils::global_thread_pool,
+    utils::{global_thread_pool, ring_queue::RingQueue},
 };
 use assert_impl::assert_impl;
 use derive_builder::Builder;
@@ -14,14 +16,18 @@ use std::{
     convert::TryInto,
     env::temp_dir,
     error::Error,
-    fmt,
+    fmt::{self, Write as FmtWrite},
     fs::{create_dir_all, File, OpenOptions},
     io::{Error as IOError, Read, Result as IOResult, Seek, SeekFrom, Write},
     net::IpAddr,
     path::Path,
     result::Result,
-    sync::{Arc, RwLock},
-    time::{Duration, SystemTime},
+    sync::{
+        atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering::Relaxed},
+        Arc, Condvar, Mutex, RwLock, Weak,
+    },
+    thread::Builder as ThreadBuilder,
+    time::{Duration, Instant, SystemTime},
 };
 use tap::TapOps;
 use thiserror::Error;
@@ -145,14 +151,77 @@ struct UploadLoggerValue {
     /// 该值必须大于 `upload_threshold`
     #[builder(default = "default::max_size()")]
     max_size: u32,
+
+    /// 内存队列容量
+    ///
+    /// 设置为大于 0 的值时，上传日志记录仪将改为内存队列模式。
+    /// 该模式下记录日志时仅将记录放入容量固定的无锁队列，由后台线程批量上传，不再读写日志文件，也不再使用文件锁。
+    /// 后台线程将在待上传的日志尺寸大于 `upload_threshold`，或距离上次上传超过 `flush_interval` 时上传日志，
+    /// 待上传的日志尺寸同样不会超过 `max_size`。
+    /// 队列已满时将丢弃最早的记录，被丢弃的记录数量可以通过 `dropped_records` 获取。
+    /// 单位为记录条数。
+    /// 默认为 0，即使用日志文件
+    #[builder(default)]
+    queue_capacity: usize,
+
+    /// 内存队列模式下的日志上传间隔
+    ///
+    /// 默认为 10 秒
+    #[builder(default = "default::flush_interval()")]
+    flush_interval: Duration,
 }
 
 struct UploadLoggerInner {
     log_buffer: RwLock<Vec<u8>>,
     log_file: RwLock<File>,
+    log_queue: Option<Arc<LogQueue>>,
     value: UploadLoggerValue,
 }
 
+/// 上传日志所需的凭证
+struct UploadContext {
+    http_client: Client,
+    upload_token: Box<str>,
+}
+
+/// 内存队列模式下上传日志所需的凭证
+///
+/// 只持有客户端配置的弱引用：客户端配置持有上传日志记录仪，进而持有日志队列，
+/// 如果队列中的记录持有客户端配置，上传日志记录仪将永远无法被释放
+struct QueuedContext {
+    config: WeakConfig,
+    upload_token: Box<str>,
+}
+
+struct QueuedRecord {
+    line: String,
+    context: Arc<QueuedContext>,
+}
+
+/// 后台线程中等待上传的日志
+struct QueuedBatch {
+    bytes: Vec<u8>,
+    records: u64,
+    context: Option<Arc<QueuedContext>>,
+    failures: usize,
+}
+
+/// 内存队列模式下同一批日志的最大连续上传失败次数
+const MAX_FLUSH_FAILURES: usize = 3;
+
+/// 内存队列模式下的日志队列
+///
+/// 记录日志的线程只写入无锁队列并累加待上传的日志尺寸，
+/// 仅当尺寸超过上传阙值时才唤醒后台线程，且后台线程每次取出记录前最多被唤醒一次
+struct LogQueue {
+    records: RingQueue<QueuedRecord>,
+    pending_size: AtomicUsize,
+    notified: AtomicBool,
+    dropped: AtomicU64,
+    woken: Mutex<bool>,
+    condvar: Condvar,
+}
+
 /// 上传日志记录仪
 ///
 /// 收集文件上传相关日志信息，并自动以异步的形式上传到 Uplog 服务器，并由七牛工作人员进行统计或定位问题
@@ -164,17 +233,26 @@ pub struct UploadLogger {
 #[derive(Clone)]
 pub(crate) struct TokenizedUploadLogger {
     upload_logger: UploadLogger,
-    http_client: Client,
-    upload_token: Box<str>,
+    context: Arc<UploadContext>,
+    queued_context: Option<Arc<QueuedContext>>,
     dropped: bool,
 }
 
 impl UploadLogger {
     pub(crate) fn tokenize(&self, upload_token: Box<str>, http_client: Client) -> TokenizedUploadLogger {
+        let queued_context = self.inner.log_queue.as_ref().map(|_| {
+            Arc::new(QueuedContext {
+                config: http_client.config().downgrade(),
+                upload_token: upload_token.to_owned(),
+            })
+        });
         TokenizedUploadLogger {
             upload_logger: self.clone(),
-            http_client,
-            upload_token,
+            context: Arc::new(UploadContext {
+                http_client,
+                upload_token,
+            }),
+            queued_context,
             dropped: false,
         }
     }
@@ -199,6 +277,33 @@ impl UploadLogger {
         self.inner.value.max_size
     }
 
+    /// 内存队列容量
+    ///
+    /// 返回 0 表示使用日志文件，否则为实际使用的队列容量，可能大于设置的值
+    pub fn queue_capacity(&self) -> usize {
+        self.inner
+            .log_queue
+            .as_ref()
+            .map(|log_queue| log_queue.records.capacity())
+            .unwrap_or(0)
+    }
+
+    /// 内存队列模式下的日志上传间隔
+    pub fn flush_interval(&self) -> Duration {
+        self.inner.value.flush_interval
+    }
+
+    /// 内存队列模式下被丢弃的记录数量
+    ///
+    /// 包括队列已满时被丢弃的记录，以及待上传的日志尺寸超过最大尺寸时被丢弃的记录
+    pub fn dropped_records(&self) -> u64 {
+        self.inner
+            .log_queue
+            .as_ref()
+            .map(|log_queue| log_queue.dropped.load(Relaxed))
+            .unwrap_or(0)
+    }
+
     #[allow(dead_code)]
     fn ignore() {
         assert_impl!(Send: Self);
@@ -218,17 +323,147 @@ impl UploadLoggerBuilder {
                 .create(true)
                 .open(value.log_file_path.as_ref())?,
         );
-        let log_buffer = RwLock::new(Vec::with_capacity(value.max_size as usize));
+        let log_queue = if value.queue_capacity > 0 {
+            let log_queue = Arc::new(LogQueue {
+                records: RingQueue::new(value.queue_capacity),
+                pending_size: AtomicUsize::new(0),
+                notified: AtomicBool::new(false),
+                dropped: AtomicU64::new(0),
+                woken: Mutex::new(false),
+                condvar: Condvar::new(),
+            });
+            let weak_log_queue = Arc::downgrade(&log_queue);
+            let (upload_threshold, max_size, flush_interval) =
+                (value.upload_threshold, value.max_size, value.flush_interval);
+            ThreadBuilder::new()
+                .name("qiniu_ng_uplog".into())
+                .spawn(move || LogQueue::run(weak_log_queue, upload_threshold, max_size, flush_interval))?;
+            Some(log_queue)
+        } else {
+            None
+        };
+        let log_buffer = RwLock::new(Vec::with_capacity(if log_queue.is_some() {
+            0
+        } else {
+            value.max_size as usize
+        }));
         Ok(UploadLogger {
             inner: Arc::new(UploadLoggerInner {
                 log_file,
                 log_buffer,
+                log_queue,
                 value,
             }),
         })
     }
 }
 
+impl LogQueue {
+    fn push(&self, record: QueuedRecord, upload_threshold: u32) {
+        // 先累加尺寸再写入队列，保证被读取或丢弃的记录的尺寸总是已经被累加过
+        let record_size = record.line.len();
+        let pending_size = self.pending_size.fetch_add(record_size, Relaxed);
+        self.records.push_overwrite(record, |dropped| {
+            self.pending_size.fetch_sub(dropped.line.len(), Relaxed);
+            self.dropped.fetch_add(1, Relaxed);
+        });
+        if pending_size + record_size > upload_threshold as usize
+            && self.pending_size.load(Relaxed) > upload_threshold as usize
+            && !self.notified.swap(true, Relaxed)
+        {
+            *self.woken.lock().unwrap() = true;
+            self.condvar.notify_one();
+        }
+    }
+
+    fn wait(&self, timeout: Duration) {
+        let deadline = Instant::now() + timeout;
+        let mut woken = self.woken.lock().unwrap();
+        while !*woken {
+            let now = Instant::now();
+            if now >= deadline {
+                break;
+            }
+            woken = self.condvar.wait_timeout(woken, deadline - now).unwrap().0;
+        }
+        *woken = false;
+    }
+
+    /// 后台线程的主循环
+    ///
+    /// 只持有队列的弱引用，上传日志记录仪被释放后，后台线程将退出，此时客户端配置也已经被释放，尚未上传的日志将被丢弃。
+    /// 上传失败的日志将在下次上传时重试，期间新的记录依然受到最大尺寸的限制，
+    /// 连续失败 `MAX_FLUSH_FAILURES` 次后，这批日志将被丢弃
+    fn run(log_queue: Weak<LogQueue>, upload_threshold: u32, max_size: u32, flush_interval: Duration) {
+        let (upload_threshold, max_size) = (upload_threshold as usize, max_size as usize);
+        let mut batch = QueuedBatch {
+            bytes: Vec::with_capacity(upload_threshold.min(max_size)),
+            records: 0,
+            context: None,
+            failures: 0,
+        };
+        let mut last_flush_time = Instant::now();
+        while let Some(log_queue) = log_queue.upgrade() {
+            log_queue.wait(
+                flush_interval
+                    .checked_sub(last_flush_time.elapsed())
+                    .unwrap_or_default(),
+            );
+            log_queue.notified.store(false, Relaxed);
+            while let Some(record) = log_queue.records.pop() {
+                log_queue.pending_size.fetch_sub(record.line.len(), Relaxed);
+                if batch.bytes.len() + record.line.len() > max_size {
+                    log_queue.dropped.fetch_add(1, Relaxed);
+                    continue;
+                }
+                batch.bytes.extend_from_slice(record.line.as_bytes());
+                batch.records += 1;
+                batch.context = Some(record.context);
+            }
+            if batch.bytes.len() > upload_threshold || last_flush_time.elapsed() >= flush_interval {
+                log_queue.dropped.fetch_add(batch.flush(), Relaxed);
+                last_flush_time = Instant::now();
+            }
+        }
+    }
+}
+
+impl QueuedBatch {
+    /// 上传日志，返回被丢弃的记录数量
+    ///
+    /// 上传成功或日志被丢弃时将同时释放上传凭证。
+    /// 上传期间将临时持有客户端配置，如果客户端配置已经被释放，日志将直接被丢弃
+    fn flush(&mut self) -> u64 {
+        let context = match &self.context {
+            Some(context) => context,
+            None => return 0,
+        };
+        let uploaded = context.config.upgrade().map_or(false, |config| {
+            upload_log_buffer(&Client::new(config), &context.upload_token, &self.bytes).is_ok()
+        });
+        if uploaded {
+            self.clear();
+            0
+        } else {
+            self.failures += 1;
+            if self.failures >= MAX_FLUSH_FAILURES || context.config.upgrade().is_none() {
+                let dropped = self.records;
+                self.clear();
+                dropped
+            } else {
+                0
+            }
+        }
+    }
+
+    fn clear(&mut self) {
+        self.bytes.clear();
+        self.records = 0;
+        self.context = None;
+        self.failures = 0;
+    }
+}
+
 mod default {
     use super::*;
 
@@ -252,6 +487,11 @@ mod default {
         1 << 22
     }
 
+    #[inline]
+    pub const fn flush_interval() -> Duration {
+        Duration::from_secs(10)
+    }
+
     #[inline]
     pub const fn lock_policy() -> LockPolicy {
         LockPolicy::LockSharedDuringAppendingAndLockExclusiveDuringUploading
@@ -263,12 +503,25 @@ impl fmt::Debug for UploadLogger {
         f.debug_struct("UploadLogger")
             .field("upload_threshold", &self.inner.value.upload_threshold)
             .field("max_size", &self.inner.value.max_size)
+            .field("queue_capacity", &self.inner.value.queue_capacity)
             .finish()
     }
 }
 
 impl TokenizedUploadLogger {
     pub(crate) fn log(&self, record: UploadLoggerRecord) -> IOResult<()> {
+        if let Some(log_queue) = &self.upload_logger.inner.log_queue {
+            let mut line = String::with_capacity(RECORD_CAPACITY);
+            let _ = writeln!(line, "{}", record);
+            log_queue.push(
+                QueuedRecord {
+                    line,
+                    context: self.queued_context.to_owned().unwrap(),
+                },
+                self.upload_logger.inner.value.upload_threshold,
+            );
+            return Ok(());
+        }
         self.append_record_to_log_buffer(record);
         self.append_log_buffer_to_record_or_upload_log_buffer(false)?;
         self.async_lock_log_file_and_update_then_clean_if_needed()?;
@@ -336,7 +589,9 @@ impl TokenizedUploadLogger {
                                 let mut log_buffer = self.upload_logger.inner.log_buffer.write().unwrap();
                                 log_buffer.clone().tap(|_| log_buffer.clear())
                             };
+                            let stopwatch = Stopwatch::start();
                             log_file.write_all(&log_buffer_content).tap(|_| {
+                                stopwatch.record(Timing::UploadLoggerIO);
                                 let _ = self.upload_logger.inner.value.lock_policy.unlock(&log_file);
                             })?;
                             return Ok(());
@@ -431,15 +686,7 @@ impl TokenizedUploadLogger {
     }
 
     fn upload_log_buffer(&self, log_buffer: &[u8]) -> HTTPResult<()> {
-        if !log_buffer.is_empty() {
-            self.http_client
-                .post("/log/3", &[self.http_client.config().uplog_url().as_ref()])
-                .header("Authorization", "UpToken ".to_owned() + &self.upload_token)
-                .raw_body("text/plain", log_buffer)
-                .send()?
-                .ignore_body();
-        }
-        Ok(())
+        upload_log_buffer(&self.context.http_client, &self.context.upload_token, log_buffer)
     }
 
     #[cfg(test)]
@@ -483,9 +730,22 @@ impl TokenizedUploadLogger {
     }
 }
 
+fn upload_log_buffer(http_client: &Client, upload_token: &str, log_buffer: &[u8]) -> HTTPResult<()> {
+    if !log_buffer.is_empty() {
+        http_client
+            .post("/log/3", &[http_client.config().uplog_url().as_ref()])
+            .header("Authorization", "UpToken ".to_owned() + upload_token)
+            .raw_body("text/plain", log_buffer)
+            .send()?
+            .ignore_body();
+    }
+    Ok(())
+}
+
 impl Drop for TokenizedUploadLogger {
     fn drop(&mut self) {
-        if !self.dropped {
+        // 内存队列模式下由后台线程按照上传阙值和上传间隔上传日志，无需在此处上传
+        if !self.dropped && self.upload_logger.inner.log_queue.is_none() {
             self.dropped = true;
             let _ = self.append_log_buffer_to_record_or_upload_log_buffer(true);
         }
@@ -532,6 +792,7 @@ pub(crate) struct UploadLoggerRecord<'a> {
     error_message: Cow<'a, str>,
     total_size: u64,
     timestamp: u64,
+    hedges: usize,
 }
 
 impl<'a> UploadLoggerRecordBuilder<'a> {
@@ -543,7 +804,8 @@ impl<'a> UploadLoggerRecordBuilder<'a> {
         let mut builder = self
             .status_code(response.status_code())
             .host(Url::parse(response.base_url()).unwrap().host_str().unwrap().to_owned())
-            .server_port(response.server_port());
+            .server_port(response.server_port())
+            .hedges(response.hedges());
         if let Some(request_id) = response.request_id() {
             builder = builder.request_id(request_id);
         }
@@ -626,37 +888,37 @@ impl Default for UploadLoggerRecord<'_> {
                 .duration_since(SystemTime::UNIX_EPOCH)
                 .unwrap()
                 .as_secs(),
+            hedges: 0,
         }
     }
 }
 
+/// 单条日志记录预分配的尺寸，足以容纳绝大多数记录
+const RECORD_CAPACITY: usize = 160;
+
 impl fmt::Display for UploadLoggerRecord<'_> {
     fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        match self.status_code {
+            Some(status_code) => write!(f, "{},", status_code)?,
+            None => f.write_str("null,")?,
+        }
+        write!(f, "{},{},", self.request_id, self.host)?;
+        if let Some(server_ip) = self.server_ip {
+            write!(f, "{}", server_ip)?;
+        }
+        write!(f, ",{},", self.server_port)?;
+        match self.duration {
+            Some(duration) => write!(f, "{}", duration.as_millis())?,
+            None => f.write_str("-1")?,
+        }
         write!(
             f,
-            "{},{},{},{},{},{},{},{},{},{}",
-            self.status_code
-                .map(|code| code.to_string())
-                .as_ref()
-                .map(|s| s.as_str())
-                .unwrap_or("null"),
-            self.request_id,
-            self.host,
-            self.server_ip
-                .map(|ip| ip.to_string())
-                .as_ref()
-                .map(|s| s.as_str())
-                .unwrap_or(""),
-            self.server_port,
-            self.duration
-                .map(|duration| duration.as_millis().to_string())
-                .as_ref()
-                .map(|s| s.as_str())
-                .unwrap_or("-1"),
+            ",{},{},{},{},{}",
             self.timestamp,
             self.sent,
-            self.up_type.map(|t| t.as_str()).unwrap_or(""),
+            self.up_type.map(UpType::as_str).unwrap_or(""),
             self.total_size,
+            self.hedges,
         )
     }
 }
@@ -670,11 +932,20 @@ mod tests {
     use crate::{
         config::ConfigBuilder,
         credential::Credential,
-        http::{DomainsManagerBuilder, Headers},
+        http::{DomainsManagerBuilder, HTTPCaller, Headers},
     };
+    use qiniu_http::{Request, Response as HTTPResponse};
     use qiniu_test_utils::http_call_mock::{CounterCallMock, JSONCallMock};
     use serde_json::json;
-    use std::{boxed::Box, error::Error, mem::drop, net::Ipv4Addr, result::Result, thread::sleep};
+    use std::{
+        boxed::Box,
+        error::Error,
+        mem::drop,
+        net::Ipv4Addr,
+        result::Result,
+        sync::mpsc::{channel, Receiver, Sender},
+        thread::sleep,
+    };
 
     #[test]
     fn test_storage_uploader_upload_logger_upload_and_clean() -> Result<(), Box<dyn Error>> {
@@ -793,6 +1064,157 @@ mod tests {
         Ok(())
     }
 
+    /// 每次调用时通过通道发送请求体中的日志行数
+    struct NotifiedCallMock<T: HTTPCaller> {
+        caller: T,
+        sender: Mutex<Sender<usize>>,
+    }
+
+    impl<T: HTTPCaller> NotifiedCallMock<T> {
+        fn new(caller: T) -> (Self, Receiver<usize>) {
+            let (sender, receiver) = channel();
+            (
+                NotifiedCallMock {
+                    caller,
+                    sender: Mutex::new(sender),
+                },
+                receiver,
+            )
+        }
+    }
+
+    impl<T: HTTPCaller> HTTPCaller for NotifiedCallMock<T> {
+        fn call(&self, request: &Request) -> HTTPResult<HTTPResponse> {
+            let response = self.caller.call(request);
+            let lines = request
+                .body()
+                .as_bytes()
+                .unwrap_or_default()
+                .split(|&b| b == b'\n')
+                .count()
+                - 1;
+            let _ = self.sender.lock().unwrap().send(lines);
+            response
+        }
+    }
+
+    fn new_record() -> UploadLoggerRecord<'static> {
+        UploadLoggerRecordBuilder::default()
+            .status_code(200)
+            .request_id("dPgAAABCOSlIU84V")
+            .host("upload.qiniup.com")
+            .up_type(UpType::Form)
+            .build()
+    }
+
+    #[test]
+    fn test_storage_uploader_upload_logger_queue() -> Result<(), Box<dyn Error>> {
+        let (mock, receiver) = NotifiedCallMock::new(JSONCallMock::new(200, Headers::new(), json!({})));
+        let upload_logger = new_queued_upload_logger(mock, 2, Duration::from_secs(2))?;
+        let start_time = Instant::now();
+        for _ in 0..4 {
+            upload_logger.log(new_record())?;
+        }
+        assert_eq!(upload_logger.upload_logger.dropped_records(), 2);
+        // 待上传的日志没有超过上传阙值，只有到达上传间隔后才会上传
+        assert_eq!(receiver.recv_timeout(Duration::from_secs(10))?, 2);
+        assert!(start_time.elapsed() >= Duration::from_secs(1));
+
+        let (mock, receiver) = NotifiedCallMock::new(JSONCallMock::new(200, Headers::new(), json!({})));
+        let upload_logger = new_queued_upload_logger(mock, 16, Duration::from_secs(60))?;
+        assert_eq!(upload_logger.upload_logger.queue_capacity(), 16);
+        for _ in 0..3 {
+            upload_logger.log(new_record())?;
+        }
+        assert_eq!(receiver.recv_timeout(Duration::from_secs(10))?, 3);
+        assert_eq!(upload_logger.upload_logger.dropped_records(), 0);
+        Ok(())
+    }
+
+    #[test]
+    fn test_storage_uploader_upload_logger_queue_drops_failed_batch() -> Result<(), Box<dyn Error>> {
+        let (mock, receiver) =
+            NotifiedCallMock::new(JSONCallMock::new(400, Headers::new(), json!({"error": "bad request"})));
+        let upload_logger = new_queued_upload_logger(mock, 16, Duration::from_millis(100))?;
+        for _ in 0..3 {
+            upload_logger.log(new_record())?;
+        }
+        for _ in 0..MAX_FLUSH_FAILURES {
+            assert_eq!(receiver.recv_timeout(Duration::from_secs(10))?, 3);
+        }
+        // 连续失败多次的日志被丢弃，之后的上传只包含新的记录
+        upload_logger.log(new_record())?;
+        assert_eq!(receiver.recv_timeout(Duration::from_secs(10))?, 1);
+        assert_eq!(upload_logger.upload_logger.dropped_records(), 3);
+        Ok(())
+    }
+
+    #[test]
+    fn test_storage_uploader_upload_logger_queue_releases_config() -> Result<(), Box<dyn Error>> {
+        let (mock, _receiver) = NotifiedCallMock::new(JSONCallMock::new(200, Headers::new(), json!({})));
+        let upload_logger = new_queued_upload_logger(mock, 16, Duration::from_secs(60))?;
+        upload_logger.log(new_record())?;
+        let config = upload_logger.context.http_client.config().downgrade();
+        // 队列中的记录不持有客户端配置，因此释放所有引用后客户端配置和上传日志记录仪都将被释放
+        drop(upload_logger);
+        assert!(config.upgrade().is_none());
+        Ok(())
+    }
+
+    fn new_queued_upload_logger(
+        mock: impl HTTPCaller + 'static,
+        queue_capacity: usize,
+        flush_interval: Duration,
+    ) -> Result<TokenizedUploadLogger, Box<dyn Error>> {
+        let config = ConfigBuilder::default()
+            .http_request_handler(mock)
+            .domains_manager(DomainsManagerBuilder::default().disable_url_resolution().build())
+            .upload_logger(Some(
+                UploadLoggerBuilder::default()
+                    .upload_threshold(150)
+                    .queue_capacity(queue_capacity)
+                    .flush_interval(flush_interval)
+                    .build()?,
+            ))
+            .build();
+        Ok(config.upload_logger().as_ref().unwrap().tokenize(
+            UploadToken::new(
+                UploadPolicyBuilder::new_policy_for_bucket("test_bucket", &config).build(),
+                get_credential(),
+            )
+            .to_string()
+            .into(),
+            Client::new(config.to_owned()),
+        ))
+    }
+
+    #[test]
+    fn test_storage_uploader_upload_logger_record_to_string() {
+        let record = UploadLoggerRecordBuilder::default()
+            .status_code(200)
+            .request_id("dPgAAABCOSlIU84V")
+            .host("upload.qiniup.com")
+            .up_type(UpType::Form)
+            .server_ip(IpAddr::V4(Ipv4Addr::new(115, 238, 101, 49)))
+            .server_port(80u16)
+            .duration(Duration::from_millis(123))
+            .sent(123_123u64)
+            .total_size(123_123u64)
+            .timestamp(1_577_836_800u64)
+            .build();
+        assert_eq!(
+            record.to_string(),
+            "200,dPgAAABCOSlIU84V,upload.qiniup.com,115.238.101.49,80,123,1577836800,123123,form,123123,0"
+        );
+        assert_eq!(
+            UploadLoggerRecordBuilder::default()
+                .timestamp(1_577_836_800u64)
+                .build()
+                .to_string(),
+            "null,,,,0,-1,1577836800,0,,0,0"
+        );
+    }
+
     fn get_credential() -> Credential {
         Credential::new("abcdefghklmnopq", "1234567890")
     }
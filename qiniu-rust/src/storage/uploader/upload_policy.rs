@@ -213,6 +213,15 @@ impl<'p> UploadPolicy<'p> {
         serde_json::to_string(&self).unwrap()
     }
 
+    /// 获取不含凭证有效期的 JSON 格式的上传策略，用于判断两个上传策略除有效期外是否相同
+    pub(super) fn as_json_without_deadline(&self) -> String {
+        serde_json::to_string(&UploadPolicy {
+            deadline: None,
+            ..self.to_owned()
+        })
+        .unwrap()
+    }
+
     /// 解析 JSON 格式的上传凭证
     pub fn from_json(json: impl AsRef<[u8]>) -> serde_json::Result<UploadPolicy<'static>> {
         serde_json::from_slice(json.as_ref())
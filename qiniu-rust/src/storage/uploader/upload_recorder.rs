@@ -1,16 +1,34 @@
 use super::super::recorder::{FileSystemRecorder, RecordMedium, Recorder};
+use crate::{
+    http::metrics::{Stopwatch, Timing},
+    utils::{
+        crc32, mmap,
+        snapshot::{is_snapshot, snapshot_len, SnapshotReader, SnapshotWriter},
+    },
+};
 use assert_impl::assert_impl;
 use derive_builder::Builder;
 use serde::{Deserialize, Serialize};
 use std::{
+    convert::TryInto,
     fmt,
-    io::{BufRead, BufReader, Error, ErrorKind, Result},
+    fs::Metadata,
+    io::{Error, ErrorKind, Result},
     path::Path,
+    str::from_utf8,
     sync::Arc,
     sync::Mutex,
-    time::{Duration, SystemTime},
+    time::{Duration, Instant, SystemTime},
 };
 
+/// 二进制进度记录的魔数
+const RECORD_MAGIC: &[u8; 4] = b"QNUR";
+const RECORD_VERSION: u32 = 1;
+/// 二进制分块记录的固定长度
+const BLOCK_ITEM_SIZE: usize = 96;
+/// 二进制分块记录中 Etag 的最大长度
+const BLOCK_ITEM_ETAG_CAPACITY: usize = 60;
+
 /// 上传进度记录仪
 ///
 /// 用于记录文件块上传进度，如果文件在上传期间发生错误，将可以在重试时避免再次上传已经成功上传的文件分块，实现断点续传
@@ -37,14 +55,55 @@ pub struct UploadRecorder {
 
     /// 始终刷新
     ///
-    /// 当记录上传进度后，是否始终刷新 IO 确保数据已经被持久化，默认为否
+    /// 当记录上传进度后，是否始终立即写入并刷新 IO 确保数据已经被持久化，默认为否
     #[builder(default = "default::always_flush_records()")]
     always_flush_records: bool,
+
+    /// 分块记录批量提交的数量
+    ///
+    /// 分块记录将先缓存在内存中，每累计到指定数量，或距离上次提交超过 `flush_interval` 时，一次性写入记录仪介质并刷新。
+    /// 进程意外退出时，尚未提交的分块记录将会丢失，续传时这些分块需要重新上传。
+    ///
+    /// 默认为 16，设置为 0 或 1 表示每条分块记录都立即写入。如果设置了始终刷新，则该配置无效
+    #[builder(default = "default::flush_every_parts()")]
+    flush_every_parts: usize,
+
+    /// 分块记录批量提交的时间间隔
+    ///
+    /// 仅在写入分块记录时检查，默认为 1 秒
+    #[builder(default = "default::flush_interval()")]
+    flush_interval: Duration,
 }
 
 pub(super) struct FileUploadRecordMedium {
     medium: Arc<Mutex<dyn RecordMedium>>,
+    format: RecordFormat,
     always_flush_records: bool,
+    flush_every_parts: usize,
+    flush_interval: Duration,
+    pending: Mutex<PendingBlockItems>,
+}
+
+/// 尚未提交的分块记录
+struct PendingBlockItems {
+    buf: Vec<u8>,
+    count: usize,
+    committed_at: Instant,
+}
+
+/// 进度记录格式
+///
+/// 新的进度记录总是使用二进制格式，JSON 格式仅用于续传旧版本 SDK 留下的进度记录
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(super) enum RecordFormat {
+    Json,
+    Binary,
+}
+
+impl Default for RecordFormat {
+    fn default() -> Self {
+        RecordFormat::Json
+    }
 }
 
 #[derive(Deserialize, Debug, Clone)]
@@ -54,15 +113,9 @@ pub(super) struct FileUploadRecordMediumMetadata {
     pub(super) upload_id: Box<str>,
     pub(super) up_urls: Box<[Box<str>]>,
     pub(super) block_size: u32,
-}
-
-#[derive(Serialize, Debug, Clone)]
-struct SerializableFileUploadRecordMediumMetadata<'a> {
-    file_size: u64,
-    modified_timestamp: u64,
-    upload_id: &'a str,
-    up_urls: &'a [&'a str],
-    block_size: u32,
+    /// 进度记录的格式，追加分块记录时需要与之保持一致
+    #[serde(skip)]
+    pub(super) format: RecordFormat,
 }
 
 #[derive(Deserialize, Debug, Clone)]
@@ -70,6 +123,12 @@ pub(super) struct FileUploadRecordMediumBlockItem {
     pub(super) etag: Box<str>,
     pub(super) part_number: usize,
     pub(super) created_timestamp: u64,
+    /// 分块在文件中的偏移量，旧版本的记录中不存在该字段，此时分块尺寸均为元数据中的 `block_size`
+    #[serde(default)]
+    pub(super) offset: Option<u64>,
+    /// 分块实际使用的尺寸，旧版本的记录中不存在该字段
+    #[serde(default)]
+    pub(super) size: Option<u64>,
 }
 
 #[derive(Serialize, Debug, Clone)]
@@ -77,6 +136,8 @@ struct SerializableFileUploadRecordMediumBlockItem<'a> {
     etag: &'a str,
     part_number: usize,
     created_timestamp: u64,
+    offset: u64,
+    size: u64,
 }
 
 impl UploadRecorderBuilder {
@@ -95,39 +156,50 @@ impl UploadRecorder {
         up_urls: &[&str],
         block_size: u32,
     ) -> Result<FileUploadRecordMedium> {
-        let metadata = path.metadata()?;
-        let metadata = SerializableFileUploadRecordMediumMetadata {
-            file_size: metadata.len(),
-            modified_timestamp: metadata
-                .modified()?
-                .duration_since(SystemTime::UNIX_EPOCH)
-                .expect("Incorrect last modification time in file metadata")
-                .as_secs(),
-            upload_id,
-            up_urls,
-            block_size,
-        };
+        let file_metadata = path.metadata()?;
+        let mut writer = SnapshotWriter::new();
+        writer
+            .put_u64(file_metadata.len())
+            .put_u64(modified_timestamp(&file_metadata)?)
+            .put_str(upload_id)
+            .put_len(up_urls.len());
+        for up_url in up_urls {
+            writer.put_str(up_url);
+        }
+        writer.put_u32(block_size);
         let medium = self.recorder.open(&self.generate_key(path, key), true)?;
         {
             let mut medium = medium.lock().unwrap();
-            let mut metadata = serde_json::to_string(&metadata).map_err(|err| Error::new(ErrorKind::Other, err))?;
-            metadata.push_str("\n");
-            medium.write_all(metadata.as_bytes())?;
+            medium.write_all(&writer.finish(RECORD_MAGIC, RECORD_VERSION))?;
             if self.always_flush_records {
                 medium.flush()?;
             }
         }
-        Ok(FileUploadRecordMedium {
-            medium,
-            always_flush_records: self.always_flush_records,
-        })
+        Ok(self.new_medium(medium, RecordFormat::Binary))
     }
 
-    pub(super) fn open_for_appending(&self, path: &Path, key: Option<&str>) -> Result<FileUploadRecordMedium> {
-        Ok(FileUploadRecordMedium {
-            medium: self.recorder.open(&self.generate_key(path, key), false)?,
+    pub(super) fn open_for_appending(
+        &self,
+        path: &Path,
+        key: Option<&str>,
+        format: RecordFormat,
+    ) -> Result<FileUploadRecordMedium> {
+        Ok(self.new_medium(self.recorder.open(&self.generate_key(path, key), false)?, format))
+    }
+
+    fn new_medium(&self, medium: Arc<Mutex<dyn RecordMedium>>, format: RecordFormat) -> FileUploadRecordMedium {
+        FileUploadRecordMedium {
+            medium,
+            format,
             always_flush_records: self.always_flush_records,
-        })
+            flush_every_parts: self.flush_every_parts,
+            flush_interval: self.flush_interval,
+            pending: Mutex::new(PendingBlockItems {
+                buf: Vec::new(),
+                count: 0,
+                committed_at: Instant::now(),
+            }),
+        }
     }
 
     pub(super) fn drop(&self, path: &Path, key: Option<&str>) -> Result<()> {
@@ -141,43 +213,43 @@ impl UploadRecorder {
     ) -> Result<Option<(FileUploadRecordMediumMetadata, Box<[FileUploadRecordMediumBlockItem]>)>> {
         let file_metadata = path.metadata()?;
         let medium = self.recorder.open(&self.generate_key(path, key), false)?;
-        let mut lock = medium.lock().unwrap();
-        let mut reader = BufReader::new(&mut *lock);
-        let mut line = String::new();
-        if reader.read_line(&mut line)? == 0 {
-            return Ok(None);
-        }
-        let metadata: FileUploadRecordMediumMetadata =
-            serde_json::from_str(&line).map_err(|err| Error::new(ErrorKind::Other, err))?;
+        let mut medium = medium.lock().unwrap();
+        // 基于本地文件的介质直接映射到内存中解析，否则一次性读出全部记录
+        let mapped = medium
+            .as_file()
+            .and_then(|file| mmap::map(file, file.metadata().ok()?.len()));
+        let mut buf = Vec::new();
+        let bytes = match &mapped {
+            Some(mapped) => &mapped[..],
+            None => {
+                medium.read_to_end(&mut buf)?;
+                buf.as_slice()
+            }
+        };
+        let (metadata, block_items) = if is_snapshot(bytes, RECORD_MAGIC) {
+            parse_binary_records(bytes)?
+        } else {
+            match parse_json_records(bytes)? {
+                Some(records) => records,
+                None => return Ok(None),
+            }
+        };
         if metadata.file_size != file_metadata.len()
-            || metadata.modified_timestamp
-                != file_metadata
-                    .modified()?
-                    .duration_since(SystemTime::UNIX_EPOCH)
-                    .expect("Incorrect last modification time in file metadata")
-                    .as_secs()
+            || metadata.modified_timestamp != modified_timestamp(&file_metadata)?
         {
             return Ok(None);
         }
-        let mut block_items = Vec::<FileUploadRecordMediumBlockItem>::new();
-        loop {
-            line.clear();
-            if reader.read_line(&mut line)? == 0 {
-                return Ok(Some((metadata, block_items.into())));
-            }
-            let block_item: FileUploadRecordMediumBlockItem =
-                serde_json::from_str(&line).map_err(|err| Error::new(ErrorKind::Other, err))?;
-            if SystemTime::now()
-                .duration_since(SystemTime::UNIX_EPOCH)
-                .expect("Clock may have gone backwards")
-                .as_secs()
-                > block_item.created_timestamp + self.upload_block_lifetime.as_secs()
-            {
-                return Ok(Some((metadata, block_items.into())));
-            }
-            // TODO: 验证文件内容与记录的 Etag 是否符合
-            block_items.push(block_item);
-        }
+        let expired_before = SystemTime::now()
+            .duration_since(SystemTime::UNIX_EPOCH)
+            .expect("Clock may have gone backwards")
+            .as_secs()
+            .saturating_sub(self.upload_block_lifetime.as_secs());
+        // TODO: 验证文件内容与记录的 Etag 是否符合
+        let block_items = block_items
+            .into_iter()
+            .take_while(|block_item| block_item.created_timestamp >= expired_before)
+            .collect::<Box<[_]>>();
+        Ok(Some((metadata, block_items)))
     }
 
     fn generate_key(&self, path: &Path, key: Option<&str>) -> String {
@@ -199,6 +271,16 @@ impl UploadRecorder {
         self.always_flush_records
     }
 
+    /// 获取分块记录批量提交的数量
+    pub fn flush_every_parts(&self) -> usize {
+        self.flush_every_parts
+    }
+
+    /// 获取分块记录批量提交的时间间隔
+    pub fn flush_interval(&self) -> Duration {
+        self.flush_interval
+    }
+
     #[allow(dead_code)]
     fn ignore() {
         assert_impl!(Send: Self);
@@ -212,6 +294,8 @@ impl fmt::Debug for UploadRecorder {
             .field("recorder", &self.recorder)
             .field("upload_block_lifetime", &self.upload_block_lifetime)
             .field("always_flush_records", &self.always_flush_records)
+            .field("flush_every_parts", &self.flush_every_parts)
+            .field("flush_interval", &self.flush_interval)
             .finish()
     }
 }
@@ -242,6 +326,16 @@ mod default {
         false
     }
 
+    #[inline]
+    pub const fn flush_every_parts() -> usize {
+        16
+    }
+
+    #[inline]
+    pub const fn flush_interval() -> Duration {
+        Duration::from_secs(1)
+    }
+
     pub fn id_generator(name: &str, path: &Path, key: Option<&str>) -> String {
         let mut sha1 = Sha1::default();
         if let Some(key) = key {
@@ -256,21 +350,37 @@ mod default {
 }
 
 impl FileUploadRecordMedium {
-    pub(super) fn append(&self, etag: &str, part_number: usize) -> Result<()> {
-        let mut item = serde_json::to_string(&SerializableFileUploadRecordMediumBlockItem {
-            etag,
-            part_number,
-            created_timestamp: SystemTime::now()
-                .duration_since(SystemTime::UNIX_EPOCH)
-                .expect("Clock may have gone backwards")
-                .as_secs(),
-        })
-        .map_err(|err| Error::new(ErrorKind::Other, err))?;
-        item.push_str("\n");
-        let mut medium = self.medium.lock().unwrap();
-        medium.write_all(item.as_bytes())?;
-        if self.always_flush_records {
-            medium.flush()?;
+    pub(super) fn append(&self, etag: &str, part_number: usize, offset: u64, size: u64) -> Result<()> {
+        let created_timestamp = SystemTime::now()
+            .duration_since(SystemTime::UNIX_EPOCH)
+            .expect("Clock may have gone backwards")
+            .as_secs();
+        let mut pending = self.pending.lock().unwrap();
+        match self.format {
+            RecordFormat::Binary => {
+                encode_block_item(&mut pending.buf, etag, part_number, created_timestamp, offset, size)?
+            }
+            RecordFormat::Json => {
+                serde_json::to_writer(
+                    &mut pending.buf,
+                    &SerializableFileUploadRecordMediumBlockItem {
+                        etag,
+                        part_number,
+                        created_timestamp,
+                        offset,
+                        size,
+                    },
+                )
+                .map_err(|err| Error::new(ErrorKind::Other, err))?;
+                pending.buf.push(b'\n');
+            }
+        }
+        pending.count += 1;
+        if self.always_flush_records
+            || pending.count >= self.flush_every_parts
+            || pending.committed_at.elapsed() >= self.flush_interval
+        {
+            pending.commit(&self.medium)?;
         }
         Ok(())
     }
@@ -281,3 +391,265 @@ impl FileUploadRecordMedium {
         assert_impl!(Sync: Self);
     }
 }
+
+impl Drop for FileUploadRecordMedium {
+    fn drop(&mut self) {
+        if let Ok(pending) = self.pending.get_mut() {
+            let _ = pending.commit(&self.medium);
+        }
+    }
+}
+
+impl PendingBlockItems {
+    /// 将缓存的分块记录一次性写入介质并刷新
+    ///
+    /// 无论写入是否成功，缓存都将被清空，避免之后重复写入部分已经写入的记录
+    fn commit(&mut self, medium: &Mutex<dyn RecordMedium>) -> Result<()> {
+        if self.buf.is_empty() {
+            return Ok(());
+        }
+        let stopwatch = Stopwatch::start();
+        let result = {
+            let mut medium = medium.lock().unwrap();
+            medium.write_all(&self.buf).and_then(|_| medium.flush())
+        };
+        stopwatch.record(Timing::RecorderIO);
+        self.buf.clear();
+        self.count = 0;
+        self.committed_at = Instant::now();
+        result
+    }
+}
+
+fn modified_timestamp(file_metadata: &Metadata) -> Result<u64> {
+    Ok(file_metadata
+        .modified()?
+        .duration_since(SystemTime::UNIX_EPOCH)
+        .expect("Incorrect last modification time in file metadata")
+        .as_secs())
+}
+
+/// 解析二进制格式的进度记录
+///
+/// 元数据为一个完整的快照，其后紧跟定长的分块记录。
+/// 每条分块记录依次为 4 字节分块编号，1 字节 Etag 长度，3 字节保留，8 字节创建时间戳，8 字节偏移量，8 字节分块尺寸，
+/// 60 字节 Etag（不足部分补零）以及前述内容的 4 字节 CRC32 校验和，所有整数均为小端序
+fn parse_binary_records(
+    bytes: &[u8],
+) -> Result<(FileUploadRecordMediumMetadata, Vec<FileUploadRecordMediumBlockItem>)> {
+    let metadata_len = snapshot_len(bytes)
+        .filter(|&len| len <= bytes.len())
+        .ok_or_else(|| Error::new(ErrorKind::InvalidData, "Upload record metadata is truncated"))?;
+    let (metadata_bytes, block_bytes) = bytes.split_at(metadata_len);
+    let mut reader = SnapshotReader::new(metadata_bytes, RECORD_MAGIC, RECORD_VERSION)?;
+    let file_size = reader.get_u64()?;
+    let modified_timestamp = reader.get_u64()?;
+    let upload_id = reader.get_str()?.into();
+    let up_urls = (0..reader.get_len()?)
+        .map(|_| reader.get_str().map(Box::from))
+        .collect::<Result<_>>()?;
+    let block_size = reader.get_u32()?;
+    let metadata = FileUploadRecordMediumMetadata {
+        file_size,
+        modified_timestamp,
+        upload_id,
+        up_urls,
+        block_size,
+        format: RecordFormat::Binary,
+    };
+    // 末尾不完整或校验失败的分块记录通常是提交期间进程意外退出所致，将与之后的记录一同被忽略
+    let mut block_items = Vec::with_capacity(block_bytes.len() / BLOCK_ITEM_SIZE);
+    for chunk in block_bytes.chunks_exact(BLOCK_ITEM_SIZE) {
+        match decode_block_item(chunk) {
+            Some(block_item) => block_items.push(block_item),
+            None => break,
+        }
+    }
+    Ok((metadata, block_items))
+}
+
+/// 解析旧版本 SDK 写入的 JSON 行格式的进度记录
+fn parse_json_records(
+    bytes: &[u8],
+) -> Result<Option<(FileUploadRecordMediumMetadata, Vec<FileUploadRecordMediumBlockItem>)>> {
+    let mut lines = bytes.split(|&b| b == b'\n');
+    let metadata: FileUploadRecordMediumMetadata = match lines.next().filter(|line| !line.is_empty()) {
+        Some(line) => serde_json::from_slice(line).map_err(|err| Error::new(ErrorKind::Other, err))?,
+        None => return Ok(None),
+    };
+    // 与二进制格式一致，无法解析的分块记录及其之后的记录都将被忽略
+    let block_items = lines
+        .map(serde_json::from_slice::<FileUploadRecordMediumBlockItem>)
+        .take_while(|block_item| block_item.is_ok())
+        .filter_map(|block_item| block_item.ok())
+        .collect();
+    Ok(Some((metadata, block_items)))
+}
+
+fn encode_block_item(
+    buf: &mut Vec<u8>,
+    etag: &str,
+    part_number: usize,
+    created_timestamp: u64,
+    offset: u64,
+    size: u64,
+) -> Result<()> {
+    let part_number: u32 = part_number
+        .try_into()
+        .map_err(|_| Error::new(ErrorKind::InvalidInput, "Part number is too large for upload record"))?;
+    if etag.len() > BLOCK_ITEM_ETAG_CAPACITY {
+        return Err(Error::new(
+            ErrorKind::InvalidInput,
+            "Etag is too long for upload record",
+        ));
+    }
+    let start = buf.len();
+    buf.extend_from_slice(&part_number.to_le_bytes());
+    buf.extend_from_slice(&[etag.len() as u8, 0, 0, 0]);
+    buf.extend_from_slice(&created_timestamp.to_le_bytes());
+    buf.extend_from_slice(&offset.to_le_bytes());
+    buf.extend_from_slice(&size.to_le_bytes());
+    buf.extend_from_slice(etag.as_bytes());
+    buf.resize(start + BLOCK_ITEM_SIZE - 4, 0);
+    let crc32 = crc32::from_bytes(&buf[start..]);
+    buf.extend_from_slice(&crc32.to_le_bytes());
+    Ok(())
+}
+
+fn decode_block_item(chunk: &[u8]) -> Option<FileUploadRecordMediumBlockItem> {
+    let (body, checksum) = chunk.split_at(BLOCK_ITEM_SIZE - 4);
+    if crc32::from_bytes(body) != u32::from_le_bytes(checksum.try_into().unwrap()) {
+        return None;
+    }
+    let etag_len = usize::from(body[4]);
+    if etag_len > BLOCK_ITEM_ETAG_CAPACITY {
+        return None;
+    }
+    let read_u64 = |range: std::ops::Range<usize>| u64::from_le_bytes(body[range].try_into().unwrap());
+    Some(FileUploadRecordMediumBlockItem {
+        etag: from_utf8(&body[32..32 + etag_len]).ok()?.into(),
+        part_number: u32::from_le_bytes(body[..4].try_into().unwrap()) as usize,
+        created_timestamp: read_u64(8..16),
+        offset: Some(read_u64(16..24)),
+        size: Some(read_u64(24..32)),
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use qiniu_test_utils::temp_file::create_temp_file;
+    use std::{error::Error, result::Result};
+    use tempfile::tempdir;
+
+    #[test]
+    fn test_storage_uploader_upload_recorder_binary_records() -> Result<(), Box<dyn Error>> {
+        let temp_dir = tempdir()?;
+        let temp_path = create_temp_file(1 << 20)?.into_temp_path();
+        let upload_recorder = UploadRecorderBuilder::default()
+            .recorder(FileSystemRecorder::from(temp_dir.path().to_owned()))
+            .flush_every_parts(3)
+            .flush_interval(Duration::from_secs(60 * 60))
+            .build();
+        let medium = upload_recorder.open_and_write_metadata(
+            &temp_path,
+            Some("test-key"),
+            "test_upload_id",
+            &["http://z1h1.com", "http://z1h2.com"],
+            1 << 18,
+        )?;
+        medium.append("etag_1", 1, 0, 1 << 18)?;
+        medium.append("etag_2", 2, 1 << 18, 1 << 18)?;
+        {
+            let (metadata, block_items) = upload_recorder.load(&temp_path, Some("test-key"))?.unwrap();
+            assert_eq!(metadata.format, RecordFormat::Binary);
+            assert_eq!(metadata.file_size, 1 << 20);
+            assert_eq!(metadata.upload_id.as_ref(), "test_upload_id");
+            assert_eq!(metadata.up_urls.len(), 2);
+            assert_eq!(metadata.up_urls[1].as_ref(), "http://z1h2.com");
+            assert_eq!(metadata.block_size, 1 << 18);
+            assert!(block_items.is_empty());
+        }
+        medium.append("etag_4", 4, 3 << 18, 1 << 18)?;
+        medium.append("etag_3", 3, 2 << 18, 1 << 18)?;
+        assert_eq!(upload_recorder.load(&temp_path, Some("test-key"))?.unwrap().1.len(), 3);
+        assert_eq!(
+            medium
+                .append(&"x".repeat(BLOCK_ITEM_ETAG_CAPACITY + 1), 5, 4 << 18, 1 << 18)
+                .unwrap_err()
+                .kind(),
+            ErrorKind::InvalidInput
+        );
+        drop(medium);
+
+        // 模拟提交期间进程意外退出留下的不完整记录
+        upload_recorder
+            .recorder()
+            .open(&upload_recorder.generate_key(&temp_path, Some("test-key")), false)?
+            .lock()
+            .unwrap()
+            .write_all(&[0xff; BLOCK_ITEM_SIZE / 2])?;
+        let (_, block_items) = upload_recorder.load(&temp_path, Some("test-key"))?.unwrap();
+        assert_eq!(
+            block_items
+                .iter()
+                .map(|block_item| (block_item.etag.as_ref(), block_item.part_number, block_item.offset))
+                .collect::<Vec<_>>(),
+            vec![
+                ("etag_1", 1, Some(0)),
+                ("etag_2", 2, Some(1 << 18)),
+                ("etag_4", 4, Some(3 << 18)),
+                ("etag_3", 3, Some(2 << 18)),
+            ]
+        );
+        assert!(block_items.iter().all(|block_item| block_item.size == Some(1 << 18)));
+        Ok(())
+    }
+
+    #[test]
+    fn test_storage_uploader_upload_recorder_json_records() -> Result<(), Box<dyn Error>> {
+        let temp_dir = tempdir()?;
+        let temp_path = create_temp_file(1 << 20)?.into_temp_path();
+        let upload_recorder = UploadRecorderBuilder::default()
+            .recorder(FileSystemRecorder::from(temp_dir.path().to_owned()))
+            .always_flush_records(true)
+            .build();
+        let file_metadata = temp_path.metadata()?;
+        upload_recorder
+            .recorder()
+            .open(&upload_recorder.generate_key(&temp_path, None), true)?
+            .lock()
+            .unwrap()
+            .write_all(
+                format!(
+                    "{}\n{}\n",
+                    serde_json::json!({
+                        "file_size": file_metadata.len(),
+                        "modified_timestamp": modified_timestamp(&file_metadata)?,
+                        "upload_id": "test_upload_id",
+                        "up_urls": ["http://z1h1.com"],
+                        "block_size": 1 << 18,
+                    }),
+                    serde_json::json!({
+                        "etag": "etag_1",
+                        "part_number": 1,
+                        "created_timestamp": modified_timestamp(&file_metadata)?,
+                    }),
+                )
+                .as_bytes(),
+            )?;
+        let (metadata, block_items) = upload_recorder.load(&temp_path, None)?.unwrap();
+        assert_eq!(metadata.format, RecordFormat::Json);
+        assert_eq!(block_items.len(), 1);
+        assert_eq!(block_items[0].offset, None);
+
+        upload_recorder
+            .open_for_appending(&temp_path, None, metadata.format)?
+            .append("etag_2", 2, 1 << 18, 1 << 18)?;
+        let (_, block_items) = upload_recorder.load(&temp_path, None)?.unwrap();
+        assert_eq!(block_items.len(), 2);
+        assert_eq!(block_items[1].etag.as_ref(), "etag_2");
+        assert_eq!(block_items[1].size, Some(1 << 18));
+        Ok(())
+    }
+}
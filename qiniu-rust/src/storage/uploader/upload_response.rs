@@ -1,12 +1,16 @@
 use matches::matches;
-use serde_json::{map::Map, value::Index, Value};
+use serde_json::{json, map::Map, value::Index, Value};
 use std::fmt;
 
 /// 上传响应实例
 ///
 /// 上传响应实例对上传响应中的响应体进行封装，提供一些辅助方法。
 #[derive(Debug, Clone)]
-pub struct UploadResponse(UploadResponseInner);
+pub struct UploadResponse {
+    inner: UploadResponseInner,
+    local_etag: Option<Box<str>>,
+    skipped: bool,
+}
 
 #[derive(Debug, Clone)]
 enum UploadResponseInner {
@@ -17,7 +21,7 @@ enum UploadResponseInner {
 impl UploadResponse {
     /// 当响应体为 JSON 时，且 JSON 体包含一个 `key` 属性，且属性值会字符串类型时，则返回该属性值
     pub fn key(&self) -> Option<&str> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.get("key").and_then(|k| k.as_str()),
             UploadResponseInner::Bytes(_) => None,
         }
@@ -25,20 +29,48 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且 JSON 体包含一个 `hash` 属性，且属性值会字符串类型时，则返回该属性值
     pub fn hash(&self) -> Option<&str> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.get("hash").and_then(|k| k.as_str()),
             UploadResponseInner::Bytes(_) => None,
         }
     }
 
+    /// 返回上传过程中在本地计算得到的 Etag
+    ///
+    /// 仅当上传时启用了本地 Etag 计算，且计算成功时才会返回，可以用于与 `hash()` 的返回值进行比较。
+    /// 分片上传的分块未与 4 MB 的 Etag 块对齐时无法计算本地 Etag，此时将返回 `None`，
+    /// 详见 `FileUploaderBuilder::enable_local_etag()`
+    pub fn local_etag(&self) -> Option<&str> {
+        self.local_etag.as_ref().map(|etag| etag.as_ref())
+    }
+
+    pub(super) fn set_local_etag(&mut self, local_etag: Option<Box<str>>) {
+        self.local_etag = local_etag;
+    }
+
+    /// 对象是否因为已经存在且内容一致而被跳过上传
+    ///
+    /// 仅当批量上传器启用了跳过已经存在的对象时才可能返回 `true`，此时响应体中仅包含 `key` 和 `hash` 属性，
+    /// 且 `local_etag()` 将返回在本地计算得到的 Etag
+    pub fn is_skipped(&self) -> bool {
+        self.skipped
+    }
+
+    pub(super) fn skipped(key: &str, etag: &str) -> Self {
+        let mut response = Self::from(json!({ "key": key, "hash": etag }));
+        response.local_etag = Some(etag.into());
+        response.skipped = true;
+        response
+    }
+
     /// 当响应体为 JSON 时，返回 true
     pub fn is_json_value(&self) -> bool {
-        matches!(&self.0, UploadResponseInner::JSON(_))
+        matches!(&self.inner, UploadResponseInner::JSON(_))
     }
 
     /// 当响应体为 JSON 时，返回 JSON 值
     pub fn as_json_value(&self) -> Option<&Value> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => Some(value),
             UploadResponseInner::Bytes(_) => None,
         }
@@ -46,7 +78,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，返回 JSON 值
     pub fn into_json_value(self) -> Option<Value> {
-        match self.0 {
+        match self.inner {
             UploadResponseInner::JSON(value) => Some(value),
             UploadResponseInner::Bytes(_) => None,
         }
@@ -54,7 +86,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在时，则返回该属性对应的值
     pub fn get<I: Index>(&self, index: I) -> Option<&Value> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.get(index),
             UploadResponseInner::Bytes(_) => None,
         }
@@ -62,7 +94,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为对象时，则返回 `true`
     pub fn is_object(&self) -> bool {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.is_object(),
             UploadResponseInner::Bytes(_) => false,
         }
@@ -70,7 +102,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为对象时，则返回属性值
     pub fn as_object(&self) -> Option<&Map<String, Value>> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.as_object(),
             UploadResponseInner::Bytes(_) => None,
         }
@@ -78,7 +110,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为数组时，则返回 `true`
     pub fn is_array(&self) -> bool {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.is_array(),
             UploadResponseInner::Bytes(_) => false,
         }
@@ -86,7 +118,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为数组时，则返回属性值
     pub fn as_array(&self) -> Option<&Vec<Value>> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.as_array(),
             UploadResponseInner::Bytes(_) => None,
         }
@@ -94,7 +126,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为字符串时，则返回 `true`
     pub fn is_string(&self) -> bool {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.is_string(),
             UploadResponseInner::Bytes(_) => false,
         }
@@ -102,7 +134,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为字符串时，则返回属性值
     pub fn as_str(&self) -> Option<&str> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.as_str(),
             UploadResponseInner::Bytes(_) => None,
         }
@@ -110,7 +142,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为数字时，则返回 `true`
     pub fn is_number(&self) -> bool {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.is_number(),
             UploadResponseInner::Bytes(_) => false,
         }
@@ -118,7 +150,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为合法的 64 位带符号整型时，则返回 `true`
     pub fn is_i64(&self) -> bool {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.is_i64(),
             UploadResponseInner::Bytes(_) => false,
         }
@@ -126,7 +158,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为合法的 64 位无符号整型时，则返回 `true`
     pub fn is_u64(&self) -> bool {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.is_u64(),
             UploadResponseInner::Bytes(_) => false,
         }
@@ -134,7 +166,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为合法的 64 位浮点型时，则返回 `true`
     pub fn is_f64(&self) -> bool {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.is_f64(),
             UploadResponseInner::Bytes(_) => false,
         }
@@ -142,7 +174,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为合法的 64 位带符号整型时，则返回属性值
     pub fn as_i64(&self) -> Option<i64> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.as_i64(),
             UploadResponseInner::Bytes(_) => None,
         }
@@ -150,7 +182,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为合法的 64 位无符号整型时，则返回属性值
     pub fn as_u64(&self) -> Option<u64> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.as_u64(),
             UploadResponseInner::Bytes(_) => None,
         }
@@ -158,7 +190,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为合法的 64 位浮点型时，则返回属性值
     pub fn as_f64(&self) -> Option<f64> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.as_f64(),
             UploadResponseInner::Bytes(_) => None,
         }
@@ -166,7 +198,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为布尔型时，则返回 `true`
     pub fn is_boolean(&self) -> bool {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.is_boolean(),
             UploadResponseInner::Bytes(_) => false,
         }
@@ -174,7 +206,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为布尔型时，则返回属性值
     pub fn as_bool(&self) -> Option<bool> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.as_bool(),
             UploadResponseInner::Bytes(_) => None,
         }
@@ -182,7 +214,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为 `NULL` 时，则返回 `true`
     pub fn is_null(&self) -> bool {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.is_null(),
             UploadResponseInner::Bytes(_) => false,
         }
@@ -190,7 +222,7 @@ impl UploadResponse {
 
     /// 当响应体为 JSON 时，且指定的属性存在，值为 `NULL` 时，则返回 `Ok(())`
     pub fn as_null(&self) -> Option<()> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.as_null(),
             UploadResponseInner::Bytes(_) => None,
         }
@@ -198,7 +230,7 @@ impl UploadResponse {
 
     /// 将响应体转换为二进制数据
     pub fn to_bytes(&self) -> Vec<u8> {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.to_string().into(),
             UploadResponseInner::Bytes(bytes) => bytes.to_owned(),
         }
@@ -206,7 +238,7 @@ impl UploadResponse {
 
     /// 将响应体转换为二进制数据
     pub fn into_bytes(self) -> Vec<u8> {
-        match self.0 {
+        match self.inner {
             UploadResponseInner::JSON(value) => value.to_string().into(),
             UploadResponseInner::Bytes(bytes) => bytes,
         }
@@ -215,19 +247,27 @@ impl UploadResponse {
 
 impl From<Value> for UploadResponse {
     fn from(v: Value) -> Self {
-        UploadResponse(UploadResponseInner::JSON(v))
+        UploadResponse {
+            inner: UploadResponseInner::JSON(v),
+            local_etag: None,
+            skipped: false,
+        }
     }
 }
 
 impl From<Vec<u8>> for UploadResponse {
     fn from(v: Vec<u8>) -> Self {
-        UploadResponse(UploadResponseInner::Bytes(v))
+        UploadResponse {
+            inner: UploadResponseInner::Bytes(v),
+            local_etag: None,
+            skipped: false,
+        }
     }
 }
 
 impl fmt::Display for UploadResponse {
     fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
-        match &self.0 {
+        match &self.inner {
             UploadResponseInner::JSON(value) => value.fmt(f),
             UploadResponseInner::Bytes(bytes) => String::from_utf8(bytes.to_owned()).map_err(|_| fmt::Error)?.fmt(f),
         }
@@ -1,8 +1,23 @@
 use super::upload_policy::UploadPolicy;
-use crate::{credential::Credential, utils::base64};
-use std::{borrow::Cow, convert::From, fmt, result::Result};
+use crate::{
+    credential::Credential,
+    utils::{base64, cache_map::CacheMap},
+};
+use digest::{FixedOutput, Input};
+use lazy_static::lazy_static;
+use sha1::Sha1;
+use std::{
+    borrow::Cow,
+    convert::From,
+    fmt,
+    result::Result,
+    time::{Duration, SystemTime},
+};
 use thiserror::Error;
 
+/// 缓存的上传凭证距离过期不足该时长时将不再被复用
+const UPLOAD_TOKEN_REUSE_MARGIN: Duration = Duration::from_secs(60);
+
 /// 上传凭证
 ///
 /// 可以点击[这里](https://developer.qiniu.com/kodo/manual/1208/upload-token)了解七牛安全机制。
@@ -39,6 +54,46 @@ impl<'p> UploadToken<'p> {
         }
     }
 
+    /// 根据上传策略获取上传凭证，优先复用此前为相同上传策略签发的上传凭证
+    ///
+    /// 除凭证有效期以外内容完全相同，且由同一认证信息签发的上传策略视为相同的上传策略。
+    /// 只有缓存的上传凭证的过期时间不早于本次上传策略要求的过期时间一分钟以上时才会被复用，否则将重新签发并替换缓存，
+    /// 缓存的上传凭证距离过期不足一分钟时也将重新签发。
+    /// 未设置凭证有效期，或剩余有效期不足一分钟的上传策略不会被缓存。
+    ///
+    /// 适用于使用相同上传策略频繁签发上传凭证的场景，可以避免每次都重新序列化并签名上传策略
+    pub fn new_cached(policy: &UploadPolicy, credential: &Credential) -> UploadToken<'static> {
+        let deadline = match policy.token_deadline() {
+            Some(deadline) => deadline,
+            None => return credential.sign_upload_policy(policy).into(),
+        };
+        let fingerprint = policy_fingerprint(policy, credential);
+        if let Some(cached) = UPLOAD_TOKEN_CACHE.get(&fingerprint) {
+            // 过期时间比要求的早太多的上传凭证不能复用，否则调用方将拿到比预期提前过期的上传凭证
+            if deadline
+                .checked_sub(UPLOAD_TOKEN_REUSE_MARGIN)
+                .map_or(true, |earliest_deadline| cached.deadline >= earliest_deadline)
+            {
+                return cached.token.to_string().into();
+            }
+        }
+        let token = credential.sign_upload_policy(policy);
+        if let Some(reuse_until) = deadline
+            .checked_sub(UPLOAD_TOKEN_REUSE_MARGIN)
+            .filter(|&reuse_until| reuse_until > SystemTime::now())
+        {
+            UPLOAD_TOKEN_CACHE.insert(
+                fingerprint,
+                CachedUploadToken {
+                    token: token.as_str().into(),
+                    deadline,
+                },
+                reuse_until,
+            );
+        }
+        token.into()
+    }
+
     /// 解析上传凭证，获取上传策略
     pub fn policy<'a>(&'a self) -> UploadTokenParseResult<Cow<'a, UploadPolicy<'p>>> {
         match &self.0 {
@@ -93,6 +148,31 @@ impl<'p> From<UploadToken<'p>> for String {
     }
 }
 
+lazy_static! {
+    static ref UPLOAD_TOKEN_CACHE: CacheMap<[u8; 20], CachedUploadToken> = CacheMap::with_max_capacity(4096, true);
+}
+
+/// 缓存的上传凭证及其签发时上传策略的过期时间
+struct CachedUploadToken {
+    token: Box<str>,
+    deadline: SystemTime,
+}
+
+/// 计算上传策略的指纹
+///
+/// 指纹涵盖认证信息和除凭证有效期以外的全部上传策略内容，避免复用到由其他认证信息签发，或是回调等设置不同的上传凭证
+fn policy_fingerprint(policy: &UploadPolicy, credential: &Credential) -> [u8; 20] {
+    let mut sha1 = Sha1::default();
+    sha1.input(credential.access_key().as_bytes());
+    sha1.input(b"\n");
+    sha1.input(credential.secret_key().as_bytes());
+    sha1.input(b"\n");
+    sha1.input(policy.as_json_without_deadline().as_bytes());
+    let mut fingerprint = [0u8; 20];
+    fingerprint.copy_from_slice(&sha1.fixed_result());
+    fingerprint
+}
+
 /// 上传凭证解析错误
 #[derive(Error, Debug)]
 pub enum UploadTokenParseError {
@@ -114,7 +194,7 @@ pub type UploadTokenParseResult<T> = Result<T, UploadTokenParseError>;
 mod tests {
     use super::{super::upload_policy::UploadPolicyBuilder, *};
     use crate::Config;
-    use std::{borrow::Cow, boxed::Box, error::Error, result::Result};
+    use std::{borrow::Cow, boxed::Box, error::Error, result::Result, time::Duration};
 
     #[test]
     fn test_build_upload_token_from_upload_policy() -> Result<(), Box<dyn Error>> {
@@ -131,6 +211,53 @@ mod tests {
         Ok(())
     }
 
+    #[test]
+    fn test_build_cached_upload_token() -> Result<(), Box<dyn Error>> {
+        let config = Config::default();
+        let credential = get_credential();
+        let policy = UploadPolicyBuilder::new_policy_for_object("test_bucket", "test:cached_file", &config).build();
+        let token = UploadToken::new_cached(&policy, &credential).to_string();
+        assert_eq!(token, UploadToken::new(policy, &credential).to_string());
+
+        // 仅凭证有效期不同的上传策略将复用同一个上传凭证，只要缓存的上传凭证过期时间不早于要求的过期时间
+        let policy = UploadPolicyBuilder::new_policy_for_object("test_bucket", "test:cached_file", &config)
+            .token_lifetime(Duration::from_secs(30 * 60))
+            .build();
+        assert_eq!(UploadToken::new_cached(&policy, &credential).to_string(), token);
+
+        // 要求更晚过期时，将重新签发上传凭证并替换缓存
+        let policy = UploadPolicyBuilder::new_policy_for_object("test_bucket", "test:cached_file", &config)
+            .token_lifetime(Duration::from_secs(2 * 60 * 60))
+            .build();
+        let longer_token = UploadToken::new_cached(&policy, &credential).to_string();
+        assert_ne!(longer_token, token);
+        assert_eq!(longer_token, UploadToken::new(policy, &credential).to_string());
+        let policy = UploadPolicyBuilder::new_policy_for_object("test_bucket", "test:cached_file", &config).build();
+        assert_eq!(UploadToken::new_cached(&policy, &credential).to_string(), longer_token);
+        let token = longer_token;
+
+        let policy = UploadPolicyBuilder::new_policy_for_object("test_bucket", "test:cached_file", &config)
+            .insert_only()
+            .build();
+        assert_ne!(UploadToken::new_cached(&policy, &credential).to_string(), token);
+        let policy = UploadPolicyBuilder::new_policy_for_object("test_bucket", "test:cached_file", &config).build();
+        assert_ne!(
+            UploadToken::new_cached(&policy, &Credential::new("abcdefghklmnopq", "0987654321")).to_string(),
+            token
+        );
+
+        // 即将过期的上传凭证不会被复用
+        let policy = UploadPolicyBuilder::new_policy_for_object("test_bucket", "test:expiring_file", &config)
+            .token_lifetime(Duration::from_secs(1))
+            .build();
+        let token = UploadToken::new_cached(&policy, &credential).to_string();
+        let policy = UploadPolicyBuilder::new_policy_for_object("test_bucket", "test:expiring_file", &config)
+            .token_lifetime(Duration::from_secs(60 * 60))
+            .build();
+        assert_ne!(UploadToken::new_cached(&policy, &credential).to_string(), token);
+        Ok(())
+    }
+
     fn accept_string(_: String) {}
     fn accept_upload_token(_: &UploadToken) {}
 
@@ -1,23 +1,173 @@
-use chashmap::{CHashMap, IntoIter as CIntoIter, ReadGuard as CReadGuard, WriteGuard as CWriteGuard};
 use serde::{Deserialize, Serialize};
 use std::{
     borrow::Borrow,
-    cmp::PartialEq,
-    hash::Hash,
+    collections::{
+        hash_map::{Entry as HashMapEntry, RandomState},
+        HashMap, VecDeque,
+    },
+    fmt,
+    hash::{BuildHasher, Hash, Hasher},
     iter::Iterator,
+    mem::{replace, take},
     ops::{Deref, DerefMut},
     result::Result,
+    sync::{
+        atomic::{AtomicBool, AtomicU64, Ordering::Relaxed},
+        RwLock, RwLockReadGuard, RwLockWriteGuard,
+    },
     time::SystemTime,
+    vec::IntoIter as VecIntoIter,
 };
 
-#[derive(Debug, Clone, Serialize, Deserialize)]
+/// 分片数量，不同分片之间的读写互不阻塞
+const SHARDS: usize = 16;
+
+/// 过期时间轮的槽数，每个槽对应一秒
+const WHEEL_SLOTS: u64 = 64;
+
 struct Entry<Data> {
     expired_at: SystemTime,
     data: Data,
+    generation: u64,
+    // CLOCK 算法的访问标记，读取时只需原子地设置，无需获取写锁
+    referenced: AtomicBool,
+}
+
+impl<Data: Clone> Clone for Entry<Data> {
+    fn clone(&self) -> Self {
+        Entry {
+            expired_at: self.expired_at,
+            data: self.data.to_owned(),
+            generation: self.generation,
+            referenced: AtomicBool::new(self.referenced.load(Relaxed)),
+        }
+    }
+}
+
+impl<Data: fmt::Debug> fmt::Debug for Entry<Data> {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_struct("Entry")
+            .field("expired_at", &self.expired_at)
+            .field("data", &self.data)
+            .finish()
+    }
+}
+
+#[derive(Debug, Clone)]
+struct Shard<K, V> {
+    map: HashMap<K, Entry<V>>,
+    // CLOCK 算法的环形队列，记录键及其插入时的代数，代数不一致的记录已经失效
+    clock: VecDeque<(K, u64)>,
+    next_generation: u64,
+    wheel: TimerWheel<K>,
+}
+
+impl<K, V> Default for Shard<K, V> {
+    fn default() -> Self {
+        Shard {
+            map: Default::default(),
+            clock: Default::default(),
+            next_generation: 0,
+            wheel: Default::default(),
+        }
+    }
+}
+
+/// 过期时间轮
+///
+/// 仅用于自动清理过期记录的缓存表。记录按照过期时刻所在的秒数放入对应的槽，每次写入时只需处理上次写入之后经过的槽，
+/// 即可移除已经过期的记录，均摊时间复杂度为 O(1)。过期时刻超出时间轮一圈的记录在经过时重新放入对应的槽
+#[derive(Debug, Clone)]
+struct TimerWheel<K> {
+    // 每个槽记录键及其插入时的代数，代数不一致的记录已经失效
+    slots: Vec<Vec<(K, u64)>>,
+    current_tick: Option<u64>,
+}
+
+impl<K> Default for TimerWheel<K> {
+    fn default() -> Self {
+        TimerWheel {
+            slots: Vec::new(),
+            current_tick: None,
+        }
+    }
+}
+
+impl<K> TimerWheel<K> {
+    fn schedule(&mut self, key: K, generation: u64, expired_at: SystemTime) {
+        if self.slots.is_empty() {
+            self.slots = (0..WHEEL_SLOTS).map(|_| Vec::new()).collect();
+        }
+        let tick = tick_of(expired_at).max(self.current_tick.unwrap_or(0));
+        self.slots[(tick % WHEEL_SLOTS) as usize].push((key, generation));
+    }
+}
+
+#[inline]
+fn tick_of(time: SystemTime) -> u64 {
+    time.duration_since(SystemTime::UNIX_EPOCH)
+        .map(|duration| duration.as_secs())
+        .unwrap_or(0)
+}
+
+/// 缓存命中统计
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct CacheMapStats {
+    /// 命中次数
+    pub hits: u64,
+    /// 未命中次数
+    pub misses: u64,
+    /// 因超出最大容量而被淘汰的记录数
+    pub evictions: u64,
+    /// 因过期而被时间轮移除的记录数
+    pub expirations: u64,
 }
-#[derive(Default, Debug, Clone)]
+
+/// 缓存命中计数器
+///
+/// 每个分片各自计数，并按缓存行对齐，读取不同分片的线程不会争用同一个缓存行
+#[repr(align(64))]
+#[derive(Debug, Default)]
+struct Counters {
+    hits: AtomicU64,
+    misses: AtomicU64,
+    evictions: AtomicU64,
+    expirations: AtomicU64,
+}
+
+impl Counters {
+    #[inline]
+    fn record_lookup(&self, hit: bool) {
+        if hit {
+            self.hits.fetch_add(1, Relaxed);
+        } else {
+            self.misses.fetch_add(1, Relaxed);
+        }
+    }
+
+    #[inline]
+    fn record_eviction(&self) {
+        self.evictions.fetch_add(1, Relaxed);
+    }
+
+    #[inline]
+    fn record_expiration(&self) {
+        self.expirations.fetch_add(1, Relaxed);
+    }
+}
+
+/// 分片缓存表
+///
+/// 读取仅需获取对应分片的读锁。
+/// 如果设置了最大容量，则每个分片在超出容量时以 CLOCK 算法淘汰最近未被访问的记录，扫描到的过期记录无论是否被访问过都将被直接淘汰。
+/// 淘汰在插入时进行，每次只扫描必要的记录，因此不需要遍历整个分片。
+/// 自动清理过期记录的缓存表还将在写入时通过过期时间轮移除已经过期的记录
 pub struct CacheMap<K, V> {
-    map: CHashMap<K, Entry<V>>,
+    shards: Box<[RwLock<Shard<K, V>>]>,
+    counters: Box<[Counters]>,
+    hash_builder: RandomState,
+    max_capacity: Option<usize>,
+    shard_max_capacity: Option<usize>,
     auto_clean: bool,
 }
 #[derive(Debug, Serialize, Deserialize, Clone)]
@@ -26,11 +176,15 @@ pub struct PersistentEntry<K, V> {
     value: V,
     expired_at: SystemTime,
 }
-pub struct IntoIter<K, V>(CIntoIter<K, Entry<V>>);
-#[derive(Debug)]
-pub struct ReadGuard<'a, K: 'a, V: 'a>(CReadGuard<'a, K, Entry<V>>);
-#[derive(Debug)]
-pub struct WriteGuard<'a, K: 'a, V: 'a>(CWriteGuard<'a, K, Entry<V>>);
+pub struct IntoIter<K, V>(VecIntoIter<(K, Entry<V>)>);
+pub struct ReadGuard<'a, K: 'a, V: 'a> {
+    _guard: RwLockReadGuard<'a, Shard<K, V>>,
+    entry: *const Entry<V>,
+}
+pub struct WriteGuard<'a, K: 'a, V: 'a> {
+    _guard: RwLockWriteGuard<'a, Shard<K, V>>,
+    entry: *mut Entry<V>,
+}
 
 enum ForEachSelector {
     Effective,
@@ -41,20 +195,54 @@ enum ForEachSelector {
 impl<K, V> CacheMap<K, V> {
     #[inline]
     pub fn with_capacity(cap: usize, auto_clean: bool) -> Self {
-        CacheMap {
-            map: CHashMap::with_capacity(cap),
-            auto_clean,
-        }
+        Self::new_with_shards(SHARDS, cap, None, auto_clean)
     }
 
     #[inline]
     pub fn new(auto_clean: bool) -> Self {
+        Self::with_capacity(0, auto_clean)
+    }
+
+    /// 创建有最大容量的缓存表
+    ///
+    /// 最大容量较小时仅使用一个分片，以保证容量限制准确
+    pub fn with_max_capacity(max_capacity: usize, auto_clean: bool) -> Self {
+        assert!(max_capacity > 0);
+        let shards = if max_capacity < SHARDS * 4 { 1 } else { SHARDS };
+        let mut map = Self::new_with_shards(shards, 0, Some((max_capacity + shards - 1) / shards), auto_clean);
+        map.max_capacity = Some(max_capacity);
+        map
+    }
+
+    fn new_with_shards(shards: usize, cap: usize, shard_max_capacity: Option<usize>, auto_clean: bool) -> Self {
+        let shard_cap = (cap + shards - 1) / shards;
         CacheMap {
-            map: CHashMap::new(),
+            shards: (0..shards)
+                .map(|_| {
+                    RwLock::new(Shard {
+                        map: HashMap::with_capacity(shard_cap),
+                        ..Default::default()
+                    })
+                })
+                .collect(),
+            counters: Self::new_counters(shards),
+            hash_builder: Default::default(),
+            max_capacity: None,
+            shard_max_capacity,
             auto_clean,
         }
     }
 
+    fn new_counters(shards: usize) -> Box<[Counters]> {
+        (0..shards).map(|_| Default::default()).collect()
+    }
+
+    /// 最大容量，没有设置最大容量时返回 `None`
+    #[inline]
+    pub fn max_capacity(&self) -> Option<usize> {
+        self.max_capacity
+    }
+
     #[inline]
     pub fn auto_clean(&self) -> bool {
         self.auto_clean
@@ -62,27 +250,52 @@ impl<K, V> CacheMap<K, V> {
 
     #[inline]
     pub fn len(&self) -> usize {
-        self.map.len()
+        self.shards.iter().map(|shard| shard.read().unwrap().map.len()).sum()
     }
 
     #[inline]
     pub fn capacity(&self) -> usize {
-        self.map.capacity()
+        self.shards
+            .iter()
+            .map(|shard| shard.read().unwrap().map.capacity())
+            .sum()
     }
 
     #[inline]
     pub fn is_empty(&self) -> bool {
-        self.map.is_empty()
+        self.shards.iter().all(|shard| shard.read().unwrap().map.is_empty())
     }
 
-    #[inline]
+    /// 清空缓存表，并将清空前的记录作为新的缓存表返回
     pub fn clear(&self) -> Self {
         CacheMap {
-            map: self.map.clear(),
+            shards: self
+                .shards
+                .iter()
+                .map(|shard| RwLock::new(take(&mut *shard.write().unwrap())))
+                .collect(),
+            counters: Self::new_counters(self.shards.len()),
+            hash_builder: self.hash_builder.to_owned(),
+            max_capacity: self.max_capacity,
+            shard_max_capacity: self.shard_max_capacity,
             auto_clean: self.auto_clean,
         }
     }
 
+    /// 缓存命中统计
+    ///
+    /// 汇总所有分片的计数，各个分片的计数之间没有同步，因此并发读写时结果只是近似值
+    pub fn stats(&self) -> CacheMapStats {
+        self.counters
+            .iter()
+            .fold(CacheMapStats::default(), |stats, counters| CacheMapStats {
+                hits: stats.hits + counters.hits.load(Relaxed),
+                misses: stats.misses + counters.misses.load(Relaxed),
+                evictions: stats.evictions + counters.evictions.load(Relaxed),
+                expirations: stats.expirations + counters.expirations.load(Relaxed),
+            })
+    }
+
     #[inline]
     pub fn for_each_effective(&self, handler: impl Fn(&K, &V, &SystemTime)) {
         self.for_each_inner(ForEachSelector::Effective, handler)
@@ -100,21 +313,29 @@ impl<K, V> CacheMap<K, V> {
 
     fn for_each_inner(&self, selector: ForEachSelector, handler: impl Fn(&K, &V, &SystemTime)) {
         let now = SystemTime::now();
-        self.map.retain(|key, value| {
-            let matched = match selector {
-                ForEachSelector::Effective => value.expired_at > now,
-                ForEachSelector::Expired => value.expired_at <= now,
-                ForEachSelector::All => true,
-            };
-            if matched {
-                handler(key, &value.data, &value.expired_at);
-            }
+        let is_matched = |entry: &Entry<V>| match selector {
+            ForEachSelector::Effective => entry.expired_at > now,
+            ForEachSelector::Expired => entry.expired_at <= now,
+            ForEachSelector::All => true,
+        };
+        for shard in self.shards.iter() {
             if self.auto_clean {
-                value.expired_at > now
+                shard.write().unwrap().map.retain(|key, entry| {
+                    if is_matched(entry) {
+                        handler(key, &entry.data, &entry.expired_at);
+                    }
+                    entry.expired_at > now
+                });
             } else {
-                true
+                shard
+                    .read()
+                    .unwrap()
+                    .map
+                    .iter()
+                    .filter(|&(_, entry)| is_matched(entry))
+                    .for_each(|(key, entry)| handler(key, &entry.data, &entry.expired_at));
             }
-        })
+        }
     }
 
     pub fn into_persistent(self) -> Vec<PersistentEntry<K, V>> {
@@ -122,163 +343,373 @@ impl<K, V> CacheMap<K, V> {
             .map(|(key, value, expired_at)| PersistentEntry { key, value, expired_at })
             .collect()
     }
+
+    #[inline]
+    fn is_effective(&self, entry: &Entry<V>) -> bool {
+        !self.auto_clean || entry.expired_at > SystemTime::now()
+    }
+
+    /// 自动清理过期记录时返回当前时间，在获取锁之前调用，以免在持有锁期间读取时钟
+    #[inline]
+    fn now_if_auto_clean(&self) -> Option<SystemTime> {
+        if self.auto_clean {
+            Some(SystemTime::now())
+        } else {
+            None
+        }
+    }
 }
 
-impl<K: PartialEq + Hash, V> CacheMap<K, V> {
+impl<K: Eq + Hash, V> CacheMap<K, V> {
+    fn shard_index<Q: ?Sized + Hash>(&self, key: &Q) -> usize {
+        if self.shards.len() == 1 {
+            return 0;
+        }
+        let mut hasher = self.hash_builder.build_hasher();
+        key.hash(&mut hasher);
+        hasher.finish() as usize % self.shards.len()
+    }
+
+    #[inline]
+    fn shard<Q: ?Sized + Hash>(&self, key: &Q) -> &RwLock<Shard<K, V>> {
+        &self.shards[self.shard_index(key)]
+    }
+
     pub fn get<Q: ?Sized>(&self, key: &Q) -> Option<ReadGuard<K, V>>
     where
         K: Borrow<Q>,
-        Q: Hash + PartialEq,
+        Q: Hash + Eq,
     {
-        self.map
+        let index = self.shard_index(key);
+        let now = self.now_if_auto_clean();
+        let guard = self.shards[index].read().unwrap();
+        let entry = guard
+            .map
             .get(key)
-            .filter(|guard| {
-                if self.auto_clean {
-                    guard.expired_at > SystemTime::now()
-                } else {
-                    true
-                }
-            })
-            .map(ReadGuard)
+            .filter(|entry| now.map_or(true, |now| entry.expired_at > now))
+            .map(|entry| {
+                entry.referenced.store(true, Relaxed);
+                entry as *const Entry<V>
+            });
+        self.counters[index].record_lookup(entry.is_some());
+        entry.map(|entry| ReadGuard { _guard: guard, entry })
     }
 
     pub fn get_mut<Q: ?Sized>(&self, key: &Q) -> Option<WriteGuard<K, V>>
     where
         K: Borrow<Q>,
-        Q: Hash + PartialEq,
+        Q: Hash + Eq,
     {
-        self.map
+        let index = self.shard_index(key);
+        let now = self.now_if_auto_clean();
+        let mut guard = self.shards[index].write().unwrap();
+        let entry = guard
+            .map
             .get_mut(key)
-            .filter(|guard| {
-                if self.auto_clean {
-                    guard.expired_at > SystemTime::now()
-                } else {
-                    true
-                }
-            })
-            .map(WriteGuard)
+            .filter(|entry| now.map_or(true, |now| entry.expired_at > now))
+            .map(|entry| {
+                entry.referenced.store(true, Relaxed);
+                entry as *mut Entry<V>
+            });
+        self.counters[index].record_lookup(entry.is_some());
+        entry.map(|entry| WriteGuard { _guard: guard, entry })
     }
 
     #[inline]
     pub fn contains_key<Q: ?Sized>(&self, key: &Q) -> bool
     where
         K: Borrow<Q>,
-        Q: Hash + PartialEq,
+        Q: Hash + Eq,
     {
-        if self.auto_clean {
-            if let Some(guard) = self.map.get(key) {
-                if guard.expired_at > SystemTime::now() {
-                    true
-                } else {
-                    self.remove(key);
-                    false
-                }
-            } else {
+        let effective = self
+            .shard(key)
+            .read()
+            .unwrap()
+            .map
+            .get(key)
+            .map(|entry| self.is_effective(entry));
+        match effective {
+            Some(true) => true,
+            Some(false) => {
+                self.remove(key);
                 false
             }
-        } else {
-            self.map.contains_key(key)
+            None => false,
         }
     }
 
-    pub fn insert(&self, key: K, val: V, expired_at: SystemTime) -> Option<(V, SystemTime)> {
-        self.map
-            .insert(key, Entry { expired_at, data: val })
-            .filter(|entry| {
-                if self.auto_clean {
-                    entry.expired_at > SystemTime::now()
-                } else {
-                    true
-                }
-            })
+    pub fn remove<Q: ?Sized>(&self, key: &Q) -> Option<(V, SystemTime)>
+    where
+        K: Borrow<Q>,
+        Q: Hash + Eq,
+    {
+        self.shard(key)
+            .write()
+            .unwrap()
+            .map
+            .remove(key)
             .map(|entry| (entry.data, entry.expired_at))
     }
+}
 
-    pub fn alter(&self, key: K, f: impl FnOnce(Option<(V, SystemTime)>) -> Option<(V, SystemTime)>) {
-        self.map.alter(key, move |v| {
-            let result = if let Some(v) = v {
-                if self.auto_clean {
-                    if v.expired_at > SystemTime::now() {
-                        f(Some((v.data, v.expired_at)))
-                    } else {
-                        f(None)
-                    }
-                } else {
-                    f(Some((v.data, v.expired_at)))
-                }
-            } else {
-                f(None)
-            };
-            result.map(|(data, expired_at)| Entry { expired_at, data })
-        })
+impl<K: Eq + Hash + Clone, V> CacheMap<K, V> {
+    pub fn insert(&self, key: K, val: V, expired_at: SystemTime) -> Option<(V, SystemTime)> {
+        let index = self.shard_index(&key);
+        let now = self.now_if_auto_clean();
+        let mut guard = self.shards[index].write().unwrap();
+        let shard = &mut *guard;
+        if let Some(now) = now {
+            Self::expire_entries(shard, &self.counters[index], now);
+        }
+        let old_entry = match shard.map.entry(key) {
+            HashMapEntry::Occupied(mut occupied) => {
+                let entry = occupied.get_mut();
+                let old_data = replace(&mut entry.data, val);
+                let old_expired_at = replace(&mut entry.expired_at, expired_at);
+                Some((old_data, old_expired_at))
+            }
+            HashMapEntry::Vacant(vacant) => {
+                let key = vacant.key().to_owned();
+                let generation = shard.next_generation;
+                vacant.insert(Self::new_entry(val, expired_at, generation));
+                self.track_new_key(shard, &self.counters[index], key, generation, expired_at);
+                None
+            }
+        };
+        old_entry.filter(|(_, expired_at)| now.map_or(true, |now| *expired_at > now))
     }
 
-    pub fn remove<Q: ?Sized>(&self, key: &Q) -> Option<(V, SystemTime)>
-    where
-        K: Borrow<Q>,
-        Q: Hash + PartialEq,
-    {
-        self.map.remove(key).map(|v| (v.data, v.expired_at))
+    pub fn alter(&self, key: K, f: impl FnOnce(Option<(V, SystemTime)>) -> Option<(V, SystemTime)>) {
+        let index = self.shard_index(&key);
+        let now = self.now_if_auto_clean();
+        let mut shard = self.shards[index].write().unwrap();
+        if let Some(now) = now {
+            Self::expire_entries(&mut shard, &self.counters[index], now);
+        }
+        let (old_entry, generation) = match shard.map.remove(&key) {
+            Some(entry) => {
+                let generation = entry.generation;
+                let effective = now.map_or(true, |now| entry.expired_at > now);
+                (
+                    Some((entry.data, entry.expired_at)).filter(|_| effective),
+                    Some(generation),
+                )
+            }
+            None => (None, None),
+        };
+        if let Some((data, expired_at)) = f(old_entry) {
+            match generation {
+                // 键没有被移出 CLOCK 队列，沿用原来的代数即可
+                Some(generation) => {
+                    shard.map.insert(key, Self::new_entry(data, expired_at, generation));
+                }
+                None => {
+                    let generation = shard.next_generation;
+                    shard
+                        .map
+                        .insert(key.to_owned(), Self::new_entry(data, expired_at, generation));
+                    self.track_new_key(&mut shard, &self.counters[index], key, generation, expired_at);
+                }
+            }
+        }
     }
 
-    pub fn from_persistent(entries: Vec<PersistentEntry<K, V>>, auto_clean: bool) -> Self {
-        let map = Self::with_capacity(entries.len(), auto_clean);
+    /// 从持久化记录中恢复有最大容量的缓存表，超出最大容量的记录将被淘汰
+    pub fn from_persistent(entries: Vec<PersistentEntry<K, V>>, max_capacity: usize, auto_clean: bool) -> Self {
+        let map = Self::with_max_capacity(max_capacity, auto_clean);
         entries.into_iter().for_each(|entry| {
             map.insert(entry.key, entry.value, entry.expired_at);
         });
         map
     }
-}
 
-impl<K: PartialEq + Hash, V: Clone> CacheMap<K, V> {
-    pub fn get_or_insert(&self, key: K, f: impl FnOnce() -> Option<(V, SystemTime)>) -> Option<(V, SystemTime)> {
-        if let Some(cache_entry) = self.get(&key) {
-            if !self.auto_clean || cache_entry.expired_at() <= SystemTime::now() {
-                return Some((cache_entry.data().to_owned(), cache_entry.expired_at()));
+    /// 以新的最大容量重建缓存表，超出最大容量的记录将被淘汰
+    pub fn resize(self, max_capacity: usize) -> Self {
+        let auto_clean = self.auto_clean;
+        Self::from_persistent(self.into_persistent(), max_capacity, auto_clean)
+    }
+
+    fn new_entry(data: V, expired_at: SystemTime, generation: u64) -> Entry<V> {
+        Entry {
+            expired_at,
+            data,
+            generation,
+            referenced: AtomicBool::new(false),
+        }
+    }
+
+    /// 将新插入的键加入过期时间轮和 CLOCK 队列，并在分片超出容量时淘汰记录
+    fn track_new_key(
+        &self,
+        shard: &mut Shard<K, V>,
+        counters: &Counters,
+        key: K,
+        generation: u64,
+        expired_at: SystemTime,
+    ) {
+        shard.next_generation = shard.next_generation.wrapping_add(1);
+        if self.auto_clean {
+            shard.wheel.schedule(key.to_owned(), generation, expired_at);
+        }
+        let shard_max_capacity = match self.shard_max_capacity {
+            Some(shard_max_capacity) => shard_max_capacity,
+            None => return,
+        };
+        shard.clock.push_back((key, generation));
+        let now = SystemTime::now();
+        while shard.map.len() > shard_max_capacity {
+            let (key, generation) = match shard.clock.pop_front() {
+                Some(clock_entry) => clock_entry,
+                None => break,
+            };
+            let evict = match shard.map.get(&key) {
+                Some(entry) if entry.generation == generation => {
+                    entry.expired_at <= now || !entry.referenced.swap(false, Relaxed)
+                }
+                // 已经被移除或重新插入的键，其记录已经失效
+                _ => continue,
+            };
+            if evict {
+                shard.map.remove(&key);
+                counters.record_eviction();
+            } else {
+                shard.clock.push_back((key, generation));
             }
         }
-        let mut result: Option<(V, SystemTime)> = None;
-        self.alter(key, |cache_entry| match cache_entry {
-            Some((data, expired_at)) => {
-                result = Some((data, expired_at));
-                result.to_owned()
+        // 被移除的键会在 CLOCK 队列中留下失效的记录，当失效记录过多时将其清理，保证队列长度与分片容量相当
+        if shard.clock.len() > shard_max_capacity.max(shard.map.len()) * 2 {
+            let Shard { map, clock, .. } = shard;
+            clock.retain(|(key, generation)| map.get(key).map_or(false, |entry| entry.generation == *generation));
+        }
+    }
+
+    /// 推进过期时间轮，移除上次推进之后经过的槽中已经过期的记录
+    ///
+    /// 最多处理一圈的槽，槽中尚未过期的记录将按照其最新的过期时刻重新放入时间轮
+    fn expire_entries(shard: &mut Shard<K, V>, counters: &Counters, now: SystemTime) {
+        let now_tick = tick_of(now);
+        let current_tick = match shard.wheel.current_tick.replace(now_tick) {
+            Some(current_tick) if current_tick < now_tick => current_tick,
+            Some(current_tick) => {
+                shard.wheel.current_tick = Some(current_tick);
+                return;
             }
-            None => {
-                result = f();
-                result.to_owned()
+            None => return,
+        };
+        if shard.wheel.slots.is_empty() {
+            return;
+        }
+        let mut rescheduled = Vec::new();
+        for tick in current_tick..current_tick + (now_tick - current_tick).min(WHEEL_SLOTS) {
+            for (key, generation) in take(&mut shard.wheel.slots[(tick % WHEEL_SLOTS) as usize]) {
+                let expired_at = match shard.map.get(&key) {
+                    Some(entry) if entry.generation == generation => entry.expired_at,
+                    // 已经被移除或重新插入的键，其记录已经失效
+                    _ => continue,
+                };
+                if expired_at <= now {
+                    shard.map.remove(&key);
+                    counters.record_expiration();
+                } else {
+                    rescheduled.push((key, generation, expired_at));
+                }
             }
-        });
-        result
+        }
+        for (key, generation, expired_at) in rescheduled {
+            shard.wheel.schedule(key, generation, expired_at);
+        }
     }
+}
 
+impl<K: Eq + Hash + Clone, V: Clone> CacheMap<K, V> {
+    /// 获取缓存记录，如果不存在则调用 `f` 生成并插入
+    ///
+    /// `f` 在不持有锁的情况下被调用，因此对同一个键的并发调用可能会多次调用 `f`，但只有第一个结果会被存入缓存
+    pub fn get_or_insert(&self, key: K, f: impl FnOnce() -> Option<(V, SystemTime)>) -> Option<(V, SystemTime)> {
+        match self.try_get_or_insert(key, || Ok::<_, ()>(f())) {
+            Ok(result) => result,
+            Err(()) => unreachable!(),
+        }
+    }
+
+    /// 获取缓存记录，如果不存在则调用 `f` 生成并插入
+    ///
+    /// `f` 在不持有锁的情况下被调用，因此对同一个键的并发调用可能会多次调用 `f`，但只有第一个结果会被存入缓存
     pub fn try_get_or_insert<E>(
         &self,
         key: K,
         f: impl FnOnce() -> Result<Option<(V, SystemTime)>, E>,
     ) -> Result<Option<(V, SystemTime)>, E> {
         if let Some(cache_entry) = self.get(&key) {
-            if !self.auto_clean || cache_entry.expired_at() <= SystemTime::now() {
-                return Ok(Some((cache_entry.data().to_owned(), cache_entry.expired_at())));
-            }
+            return Ok(Some((cache_entry.data().to_owned(), cache_entry.expired_at())));
         }
-        let mut result: Result<Option<(V, SystemTime)>, E> = Ok(None);
-        self.alter(key, |cache_entry| match cache_entry {
-            Some((data, expired_at)) => {
-                result = Ok(Some((data.to_owned(), expired_at)));
-                Some((data, expired_at))
-            }
-            None => match f() {
-                Ok(r) => {
-                    result = Ok(r.to_owned());
-                    r
-                }
-                Err(err) => {
-                    result = Err(err);
-                    None
-                }
-            },
+        let created = match f()? {
+            Some(created) => created,
+            None => return Ok(None),
+        };
+        let mut result = None;
+        self.alter(key, |cache_entry| {
+            let cache_entry = cache_entry.unwrap_or(created);
+            result = Some(cache_entry.to_owned());
+            Some(cache_entry)
         });
-        result
+        Ok(result)
+    }
+}
+
+impl<K, V> PersistentEntry<K, V> {
+    #[inline]
+    pub fn new(key: K, value: V, expired_at: SystemTime) -> Self {
+        PersistentEntry { key, value, expired_at }
+    }
+
+    #[inline]
+    pub fn key(&self) -> &K {
+        &self.key
+    }
+
+    #[inline]
+    pub fn value(&self) -> &V {
+        &self.value
+    }
+
+    #[inline]
+    pub fn expired_at(&self) -> SystemTime {
+        self.expired_at
+    }
+}
+
+impl<K, V> Default for CacheMap<K, V> {
+    #[inline]
+    fn default() -> Self {
+        Self::new(false)
+    }
+}
+
+impl<K: Clone, V: Clone> Clone for CacheMap<K, V> {
+    fn clone(&self) -> Self {
+        CacheMap {
+            shards: self
+                .shards
+                .iter()
+                .map(|shard| RwLock::new(shard.read().unwrap().to_owned()))
+                .collect(),
+            counters: Self::new_counters(self.shards.len()),
+            hash_builder: self.hash_builder.to_owned(),
+            max_capacity: self.max_capacity,
+            shard_max_capacity: self.shard_max_capacity,
+            auto_clean: self.auto_clean,
+        }
+    }
+}
+
+impl<K: fmt::Debug, V: fmt::Debug> fmt::Debug for CacheMap<K, V> {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        let mut map = f.debug_map();
+        for shard in self.shards.iter() {
+            map.entries(shard.read().unwrap().map.iter());
+        }
+        map.finish()
     }
 }
 
@@ -286,9 +717,15 @@ impl<K, V> IntoIterator for CacheMap<K, V> {
     type Item = (K, V, SystemTime);
     type IntoIter = IntoIter<K, V>;
 
-    #[inline]
     fn into_iter(self) -> Self::IntoIter {
-        IntoIter(self.map.into_iter())
+        IntoIter(
+            self.shards
+                .into_vec()
+                .into_iter()
+                .flat_map(|shard| shard.into_inner().unwrap().map.into_iter())
+                .collect::<Vec<_>>()
+                .into_iter(),
+        )
     }
 }
 
@@ -303,12 +740,18 @@ impl<K, V> Iterator for IntoIter<K, V> {
 impl<'a, K, V> ReadGuard<'a, K, V> {
     #[inline]
     pub fn data(&self) -> &V {
-        &self.0.data
+        &self.entry().data
     }
 
     #[inline]
     pub fn expired_at(&self) -> SystemTime {
-        self.0.expired_at
+        self.entry().expired_at
+    }
+
+    #[inline]
+    fn entry(&self) -> &Entry<V> {
+        // 记录的地址来自读锁所保护的分片，读锁在守护对象存续期间一直被持有，因此记录不会被移动或释放
+        unsafe { &*self.entry }
     }
 }
 
@@ -317,19 +760,36 @@ impl<'a, K, V> Deref for ReadGuard<'a, K, V> {
 
     #[inline]
     fn deref(&self) -> &Self::Target {
-        &self.0.data
+        self.data()
+    }
+}
+
+impl<'a, K, V: fmt::Debug> fmt::Debug for ReadGuard<'a, K, V> {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_tuple("ReadGuard").field(self.entry()).finish()
     }
 }
 
 impl<'a, K, V> WriteGuard<'a, K, V> {
     #[inline]
     pub fn data(&mut self) -> &mut V {
-        &mut self.0.data
+        &mut self.entry_mut().data
     }
 
     #[inline]
     pub fn expired_at(&mut self) -> &mut SystemTime {
-        &mut self.0.expired_at
+        &mut self.entry_mut().expired_at
+    }
+
+    #[inline]
+    fn entry(&self) -> &Entry<V> {
+        // 记录的地址来自写锁所保护的分片，写锁在守护对象存续期间一直被持有，因此记录不会被移动或释放
+        unsafe { &*self.entry }
+    }
+
+    #[inline]
+    fn entry_mut(&mut self) -> &mut Entry<V> {
+        unsafe { &mut *self.entry }
     }
 }
 
@@ -338,13 +798,181 @@ impl<'a, K, V> Deref for WriteGuard<'a, K, V> {
 
     #[inline]
     fn deref(&self) -> &Self::Target {
-        &self.0.data
+        &self.entry().data
     }
 }
 
 impl<'a, K, V> DerefMut for WriteGuard<'a, K, V> {
     #[inline]
     fn deref_mut(&mut self) -> &mut V {
-        &mut self.0.data
+        &mut self.entry_mut().data
+    }
+}
+
+impl<'a, K, V: fmt::Debug> fmt::Debug for WriteGuard<'a, K, V> {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_tuple("WriteGuard").field(self.entry()).finish()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::{sync::Arc, thread, time::Duration};
+
+    #[test]
+    fn test_cache_map_insert_and_get() {
+        let map = CacheMap::<Box<str>, usize>::new(true);
+        let now = SystemTime::now();
+        assert!(map.insert("a".into(), 1, now + Duration::from_secs(60)).is_none());
+        assert!(map.insert("b".into(), 2, now - Duration::from_secs(1)).is_none());
+        assert_eq!(*map.get("a").unwrap(), 1);
+        assert!(map.get("b").is_none());
+        assert!(!map.contains_key("b"));
+        assert_eq!(map.len(), 1);
+        assert_eq!(
+            map.insert("a".into(), 3, now + Duration::from_secs(60)).map(|(v, _)| v),
+            Some(1)
+        );
+        *map.get_mut("a").unwrap() += 1;
+        assert_eq!(*map.get("a").unwrap(), 4);
+        assert_eq!(
+            map.stats(),
+            CacheMapStats {
+                hits: 3,
+                misses: 1,
+                evictions: 0,
+                expirations: 0,
+            }
+        );
+    }
+
+    #[test]
+    fn test_cache_map_eviction() {
+        let map = CacheMap::<usize, usize>::with_max_capacity(3, false);
+        let expired_at = SystemTime::now() + Duration::from_secs(60);
+        map.insert(0, 0, expired_at);
+        map.insert(1, 1, expired_at);
+        map.insert(2, 2, SystemTime::now() - Duration::from_secs(1));
+        for i in 0..3 {
+            assert!(map.get(&i).is_some());
+        }
+        map.insert(3, 3, expired_at);
+        assert_eq!(map.len(), 3);
+        assert!(!map.contains_key(&2));
+        assert_eq!(map.stats().evictions, 1);
+
+        map.insert(4, 4, expired_at);
+        assert_eq!(map.len(), 3);
+        assert!(map.contains_key(&0));
+        assert!(map.contains_key(&1));
+        assert!(!map.contains_key(&3));
+        assert_eq!(map.stats().evictions, 2);
+
+        for i in 0..100 {
+            map.remove(&5);
+            map.insert(5, i, expired_at);
+        }
+        assert_eq!(map.len(), 3);
+        assert!(map.shards[0].read().unwrap().clock.len() <= 6);
+    }
+
+    #[test]
+    fn test_cache_map_timer_wheel() {
+        let map = CacheMap::<usize, usize>::with_max_capacity(16, true);
+        let now = SystemTime::now();
+        map.insert(0, 0, now + Duration::from_secs(1));
+        map.insert(1, 1, now + Duration::from_secs(120));
+        map.insert(2, 2, now - Duration::from_secs(1));
+        assert_eq!(map.len(), 3);
+
+        CacheMap::expire_entries(
+            &mut map.shards[0].write().unwrap(),
+            &map.counters[0],
+            now + Duration::from_secs(3),
+        );
+        assert_eq!(map.len(), 1);
+        assert_eq!(map.stats().expirations, 2);
+
+        CacheMap::expire_entries(
+            &mut map.shards[0].write().unwrap(),
+            &map.counters[0],
+            now + Duration::from_secs(200),
+        );
+        assert!(map.is_empty());
+        assert_eq!(map.stats().expirations, 3);
+        assert_eq!(map.stats().evictions, 0);
+    }
+
+    #[test]
+    fn test_cache_map_resize() {
+        let expired_at = SystemTime::now() + Duration::from_secs(60);
+        let map = CacheMap::<usize, usize>::with_max_capacity(8, false);
+        for i in 0..8 {
+            map.insert(i, i, expired_at);
+        }
+        assert_eq!(map.max_capacity(), Some(8));
+        let map = map.resize(4);
+        assert_eq!(map.max_capacity(), Some(4));
+        assert_eq!(map.len(), 4);
+    }
+
+    #[test]
+    fn test_cache_map_from_persistent_with_max_capacity() {
+        let expired_at = SystemTime::now() + Duration::from_secs(60);
+        let entries = (0..10).map(|i| PersistentEntry::new(i, i, expired_at)).collect();
+        let map = CacheMap::<usize, usize>::from_persistent(entries, 4, false);
+        assert_eq!(map.len(), 4);
+        assert_eq!(map.stats().evictions, 6);
+    }
+
+    #[test]
+    fn test_cache_map_get_or_insert() {
+        let map = CacheMap::<Box<str>, usize>::with_max_capacity(1024, true);
+        let expired_at = SystemTime::now() + Duration::from_secs(60);
+        assert_eq!(
+            map.get_or_insert("a".into(), || Some((1, expired_at))).map(|(v, _)| v),
+            Some(1)
+        );
+        assert_eq!(
+            map.get_or_insert("a".into(), || Some((2, expired_at))).map(|(v, _)| v),
+            Some(1)
+        );
+        assert!(map.get_or_insert("b".into(), || None).is_none());
+        assert_eq!(
+            map.try_get_or_insert::<()>("a".into(), || panic!("should not be called"))
+                .unwrap()
+                .map(|(v, _)| v),
+            Some(1)
+        );
+        assert!(map.try_get_or_insert("c".into(), || Err(())).is_err());
+        assert_eq!(map.len(), 1);
+    }
+
+    #[test]
+    fn test_cache_map_in_multiple_threads() {
+        let map = Arc::new(CacheMap::<usize, usize>::with_max_capacity(256, true));
+        let expired_at = SystemTime::now() + Duration::from_secs(60);
+        let threads: Vec<_> = (0..8)
+            .map(|thread_id| {
+                let map = map.to_owned();
+                thread::spawn(move || {
+                    for i in 0..1000 {
+                        let key = thread_id * 1000 + i;
+                        map.insert(key, key, expired_at);
+                        if let Some(value) = map.get(&key) {
+                            assert_eq!(*value, key);
+                        }
+                    }
+                })
+            })
+            .collect();
+        threads.into_iter().for_each(|thread| thread.join().unwrap());
+        assert!(map.len() <= 256);
+        assert_eq!(map.stats().evictions as usize, 8000 - map.len());
+        assert_eq!(CacheMap::clone(&map).into_iter().count(), map.len());
+        let len = map.len();
+        assert_eq!(map.clear().len(), len);
+        assert!(map.is_empty());
     }
 }
@@ -1,4 +1,5 @@
-use crc::crc32::{Digest, Hasher32, IEEE};
+#[cfg(not(feature = "accelerated-hash"))]
+use crc::crc32::{Hasher32, IEEE};
 use getset::CopyGetters;
 use std::{
     fs::File,
@@ -24,7 +25,7 @@ pub fn new_reader<'io, IO: Read + 'io>(io: &'io mut IO) -> Reader<IO> {
         io,
         crc32: None,
         have_read: 0,
-        digest: Digest::new(IEEE),
+        digest: Digest::new(),
     }
 }
 
@@ -53,7 +54,7 @@ pub fn from<IO: Read>(mut io: &mut IO) -> Result<u32> {
 }
 
 pub fn from_bytes<S: AsRef<[u8]>>(buf: S) -> u32 {
-    let mut digest = Digest::new(IEEE);
+    let mut digest = Digest::new();
     digest.write(buf.as_ref());
     digest.sum32()
 }
@@ -62,6 +63,57 @@ pub fn from_file<P: AsRef<Path>>(path: P) -> Result<u32> {
     from(&mut File::open(path)?)
 }
 
+/// 当前生效的 CRC32 实现名称
+pub(crate) fn backend() -> &'static str {
+    #[cfg(all(feature = "accelerated-hash", any(target_arch = "x86", target_arch = "x86_64")))]
+    {
+        if is_x86_feature_detected!("pclmulqdq") && is_x86_feature_detected!("sse4.1") {
+            return "pclmulqdq";
+        }
+    }
+    "software"
+}
+
+/// CRC32 (IEEE) 计算器
+///
+/// 启用 `accelerated-hash` 功能后，将使用 `crc32fast` 库，在运行时根据 CPU 特性选用 PCLMULQDQ 等硬件加速实现，
+/// 否则使用 `crc` 库的查表实现
+#[cfg(feature = "accelerated-hash")]
+struct Digest(crc32fast::Hasher);
+
+#[cfg(feature = "accelerated-hash")]
+impl Digest {
+    fn new() -> Digest {
+        Digest(crc32fast::Hasher::new())
+    }
+
+    fn write(&mut self, buf: &[u8]) {
+        self.0.update(buf)
+    }
+
+    fn sum32(&self) -> u32 {
+        self.0.clone().finalize()
+    }
+}
+
+#[cfg(not(feature = "accelerated-hash"))]
+struct Digest(crc::crc32::Digest);
+
+#[cfg(not(feature = "accelerated-hash"))]
+impl Digest {
+    fn new() -> Digest {
+        Digest(crc::crc32::Digest::new(IEEE))
+    }
+
+    fn write(&mut self, buf: &[u8]) {
+        self.0.write(buf)
+    }
+
+    fn sum32(&self) -> u32 {
+        self.0.sum32()
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -1,36 +1,47 @@
 //! 七牛 Etag 计算库
 
-use super::base64;
+use super::{base64, sha1::Sha1};
 use digest::{
     generic_array::{typenum::U28, GenericArray},
     FixedOutput, Input, Reset,
 };
-use sha1::Sha1;
+use rayon::{prelude::*, ThreadPool};
 use std::{
+    convert::TryInto,
     fs::File,
-    io::{copy, sink, Read, Result},
+    io::{copy, sink, Read, Result, Seek, SeekFrom},
     mem::replace,
     option::Option,
     path::Path,
 };
 use tap::TapResultOps;
 
-const BLOCK_SIZE: usize = 1 << 22;
+pub(crate) const BLOCK_SIZE: usize = 1 << 22;
+pub(crate) const SHA1_SIZE: usize = 20;
 
 /// Etag 字符串固定长度
 pub const ETAG_SIZE: usize = 28;
 
 /// 七牛 Etag 计算器
+///
+/// 输入的数据将直接输入当前块的 SHA-1 计算器中，不会缓存整块数据，
+/// 每个块的 SHA-1 值在块结束时即被合并，因此计算器占用的内存固定，输入数据时不会分配内存
 pub struct Etag {
-    buffer: Vec<u8>,
-    sha1s: Vec<Vec<u8>>,
+    block_sha1: Sha1,
+    block_written: usize,
+    first_block_sha1: [u8; SHA1_SIZE],
+    blocks_sha1: Sha1,
+    blocks_count: usize,
 }
 
 /// 创建一个 Etag 计算器
 pub fn new() -> Etag {
     Etag {
-        buffer: Vec::new(),
-        sha1s: Vec::new(),
+        block_sha1: Sha1::default(),
+        block_written: 0,
+        first_block_sha1: [0u8; SHA1_SIZE],
+        blocks_sha1: Sha1::default(),
+        blocks_count: 0,
     }
 }
 
@@ -43,16 +54,16 @@ impl Default for Etag {
 impl Input for Etag {
     /// 向 Etag 计算器输入数据
     fn input<B: AsRef<[u8]>>(&mut self, data: B) {
-        self.buffer.extend_from_slice(data.as_ref());
-        let mut iter = self.buffer.chunks_exact(BLOCK_SIZE);
-        for block in iter.by_ref() {
-            self.sha1s.push(Self::sha1(block));
+        let mut data = data.as_ref();
+        while !data.is_empty() {
+            let (current, rest) = data.split_at(data.len().min(BLOCK_SIZE - self.block_written));
+            self.block_sha1.input(current);
+            self.block_written += current.len();
+            if self.block_written == BLOCK_SIZE {
+                self.finish_block();
+            }
+            data = rest;
         }
-        self.buffer = {
-            let mut new_buffer = Vec::new();
-            new_buffer.extend_from_slice(iter.remainder());
-            new_buffer
-        };
     }
 }
 
@@ -61,54 +72,62 @@ impl FixedOutput for Etag {
 
     /// 从 Etag 计算器获取结果
     fn fixed_result(mut self) -> GenericArray<u8, Self::OutputSize> {
-        if !self.buffer.is_empty() {
-            self.sha1s.push(Self::sha1(&self.buffer));
-            self.buffer.clear();
+        if self.block_written > 0 {
+            self.finish_block();
+        }
+        let mut fixed_result = [0u8; ETAG_SIZE];
+        let mut buf = [0u8; SHA1_SIZE + 1];
+        match self.blocks_count {
+            0 => {
+                fixed_result.copy_from_slice(b"Fto5o-5ea0sNMlW_75VgGJCv2AcJ");
+            }
+            1 => {
+                buf[0] = 0x16u8;
+                buf[1..].copy_from_slice(&self.first_block_sha1);
+                base64::urlsafe_slice(&buf, &mut fixed_result);
+            }
+            _ => {
+                buf[0] = 0x96u8;
+                buf[1..].copy_from_slice(&self.blocks_sha1.fixed_result());
+                base64::urlsafe_slice(&buf, &mut fixed_result);
+            }
         }
-        self.encode_sha1s()
+        fixed_result.into()
     }
 }
 
 impl Reset for Etag {
     /// 重置 Etag 计算器
     fn reset(&mut self) {
-        self.buffer.clear();
-        self.sha1s.clear();
+        self.block_sha1.reset();
+        self.block_written = 0;
+        self.blocks_sha1.reset();
+        self.blocks_count = 0;
     }
 }
 
 impl Etag {
-    fn sha1(bytes: &[u8]) -> Vec<u8> {
+    fn sha1(bytes: &[u8]) -> [u8; SHA1_SIZE] {
         let mut sha1 = Sha1::default();
         sha1.input(bytes);
-        sha1.fixed_result().to_vec()
+        let mut result = [0u8; SHA1_SIZE];
+        result.copy_from_slice(&sha1.fixed_result());
+        result
     }
 
-    fn encode_sha1s(self) -> GenericArray<u8, U28> {
-        let mut fixed_result = [0u8; ETAG_SIZE];
-        match self.sha1s.len() {
-            0 => {
-                fixed_result.copy_from_slice(b"Fto5o-5ea0sNMlW_75VgGJCv2AcJ");
-            }
-            1 => {
-                let mut buf = Vec::with_capacity(32);
-                buf.push(0x16u8);
-                buf.extend_from_slice(self.sha1s.first().unwrap());
-                base64::urlsafe_slice(&buf, &mut fixed_result);
-            }
-            _ => {
-                let mut buf = Vec::with_capacity(1024);
-                for sha1 in self.sha1s.iter() {
-                    buf.extend_from_slice(&sha1);
-                }
-                let sha1 = Self::sha1(&buf);
-                buf.clear();
-                buf.push(0x96u8);
-                buf.extend_from_slice(&sha1);
-                base64::urlsafe_slice(&buf, &mut fixed_result);
-            }
+    fn finish_block(&mut self) {
+        let mut block_sha1 = [0u8; SHA1_SIZE];
+        block_sha1.copy_from_slice(&replace(&mut self.block_sha1, Sha1::default()).fixed_result());
+        self.block_written = 0;
+        self.push_block_sha1(&block_sha1);
+    }
+
+    fn push_block_sha1(&mut self, block_sha1: &[u8; SHA1_SIZE]) {
+        if self.blocks_count == 0 {
+            self.first_block_sha1 = *block_sha1;
         }
-        fixed_result.into()
+        self.blocks_sha1.input(block_sha1);
+        self.blocks_count += 1;
     }
 }
 
@@ -193,10 +212,58 @@ pub fn from_file<P: AsRef<Path>>(path: P) -> Result<String> {
     from(File::open(path)?)
 }
 
+/// 根据给出的文件内容并行计算 Etag
+///
+/// 文件将按 Etag 块尺寸切分，每个块的 SHA-1 在指定的线程池中并行计算，最后按块顺序合并为 Etag。
+/// 计算结果与 `from_file()` 完全一致，适合为大文件计算 Etag
+pub fn from_file_in_parallel<P: AsRef<Path>>(path: P, thread_pool: &ThreadPool) -> Result<String> {
+    let path = path.as_ref();
+    let block_size = BLOCK_SIZE as u64;
+    let blocks_count: usize = ((path.metadata()?.len() + block_size - 1) / block_size)
+        .try_into()
+        .unwrap_or(usize::max_value());
+    let sha1s = thread_pool.install(|| {
+        (0..blocks_count)
+            .into_par_iter()
+            .map_init(
+                || (None, Vec::with_capacity(BLOCK_SIZE)),
+                |(file, buf): &mut (Option<File>, Vec<u8>), block_index| -> Result<[u8; SHA1_SIZE]> {
+                    if file.is_none() {
+                        *file = Some(File::open(path)?);
+                    }
+                    let file = file.as_mut().unwrap();
+                    file.seek(SeekFrom::Start(block_index as u64 * block_size))?;
+                    buf.clear();
+                    file.take(block_size).read_to_end(buf)?;
+                    Ok(Etag::sha1(buf))
+                },
+            )
+            .collect::<Result<Vec<_>>>()
+    })?;
+    Ok(from_blocks_sha1(sha1s.iter()))
+}
+
+/// 将数据按 Etag 块尺寸切分，计算每个块的 SHA-1 值
+///
+/// 数据起始位置必须与 Etag 块边界对齐，除最后一块外，每块尺寸均为 Etag 块尺寸
+pub(crate) fn blocks_sha1(data: &[u8]) -> Vec<[u8; SHA1_SIZE]> {
+    data.chunks(BLOCK_SIZE).map(Etag::sha1).collect()
+}
+
+/// 根据按顺序给出的每个块的 SHA-1 值计算 Etag
+pub(crate) fn from_blocks_sha1<'a>(blocks_sha1: impl IntoIterator<Item = &'a [u8; SHA1_SIZE]>) -> String {
+    let mut etag_digest = new();
+    for block_sha1 in blocks_sha1 {
+        etag_digest.push_block_sha1(block_sha1);
+    }
+    String::from_utf8(etag_digest.fixed_result().to_vec()).unwrap()
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
     use qiniu_test_utils::temp_file;
+    use rayon::ThreadPoolBuilder;
     use std::{
         boxed::Box,
         error::Error,
@@ -235,4 +302,73 @@ mod tests {
         );
         Ok(())
     }
+
+    #[test]
+    fn test_etag_from_small_chunks() -> Result<(), Box<dyn Error>> {
+        let data = temp_file::create_temp_file(9 * (1 << 20))?;
+        let data = std::fs::read(data.path())?;
+        for &chunk_size in [1 << 14, 1 << 16, 3 * (1 << 20), 1 << 22, 5 * (1 << 20)].iter() {
+            let mut etag_digest = new();
+            for chunk in data.chunks(chunk_size) {
+                etag_digest.input(chunk);
+            }
+            assert_eq!(
+                String::from_utf8(etag_digest.fixed_result().to_vec())?,
+                "ljgVjMtyMsOgIySv79U8Qz4TrUO4"
+            );
+        }
+        let mut etag_digest = new();
+        etag_digest.input(&data);
+        etag_digest.reset();
+        etag_digest.input(b"etag");
+        assert_eq!(
+            String::from_utf8(etag_digest.fixed_result().to_vec())?,
+            "FpLiADEaVoALPkdb8tJEJyRTXoe_"
+        );
+        Ok(())
+    }
+
+    #[test]
+    fn test_etag_from_file_in_parallel() -> Result<(), Box<dyn Error>> {
+        let thread_pool = ThreadPoolBuilder::new().num_threads(4).build()?;
+        assert_eq!(
+            from_file_in_parallel(temp_file::create_temp_file(0)?, &thread_pool)?,
+            "Fto5o-5ea0sNMlW_75VgGJCv2AcJ",
+        );
+        assert_eq!(
+            from_file_in_parallel(temp_file::create_temp_file(1 << 20)?, &thread_pool)?,
+            "Foyl8onxBLWeRLL5oItRJphv6i4b",
+        );
+        assert_eq!(
+            from_file_in_parallel(temp_file::create_temp_file(4 * (1 << 20))?, &thread_pool)?,
+            "FicHOveBNs5Kn9d74M3b9tI4D-8r",
+        );
+        assert_eq!(
+            from_file_in_parallel(temp_file::create_temp_file(5 * (1 << 20))?, &thread_pool)?,
+            "lg-Eb5KFCuZn-cUfj_oS2PPOU9xy",
+        );
+        assert_eq!(
+            from_file_in_parallel(temp_file::create_temp_file(9 * (1 << 20))?, &thread_pool)?,
+            "ljgVjMtyMsOgIySv79U8Qz4TrUO4",
+        );
+        let temp_file = temp_file::create_temp_file(17 * (1 << 20) + 1)?;
+        assert_eq!(
+            from_file_in_parallel(temp_file.path(), &thread_pool)?,
+            from_file(temp_file.path())?
+        );
+        Ok(())
+    }
+
+    #[test]
+    fn test_etag_from_blocks_sha1() -> Result<(), Box<dyn Error>> {
+        let data = std::fs::read(temp_file::create_temp_file(9 * (1 << 20))?.path())?;
+        let sha1s = data
+            .chunks(2 * BLOCK_SIZE)
+            .flat_map(|part| blocks_sha1(part))
+            .collect::<Vec<_>>();
+        assert_eq!(sha1s.len(), 3);
+        assert_eq!(from_blocks_sha1(sha1s.iter()), "ljgVjMtyMsOgIySv79U8Qz4TrUO4");
+        assert_eq!(from_blocks_sha1(blocks_sha1(&[]).iter()), "Fto5o-5ea0sNMlW_75VgGJCv2AcJ");
+        Ok(())
+    }
 }
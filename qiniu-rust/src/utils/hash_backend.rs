@@ -0,0 +1,25 @@
+//! 哈希算法实现查询
+//!
+//! 启用 `accelerated-hash` 功能后，SDK 计算 Etag 和 CRC32 时将在运行时根据 CPU 特性自动选用硬件加速实现，
+//! 不支持的平台将使用原有的软件实现。该模块用于确认当前实际生效的实现
+
+/// 获取当前生效的 SHA-1 实现名称
+///
+/// 返回 `sha-ni` 表示使用 x86_64 SHA 扩展指令集，返回 `software` 表示使用软件实现
+pub fn sha1() -> &'static str {
+    super::sha1::backend()
+}
+
+/// 获取当前生效的 CRC32 实现名称
+///
+/// 返回 `pclmulqdq` 表示使用 PCLMULQDQ 指令集，返回 `software` 表示使用软件实现
+pub fn crc32() -> &'static str {
+    super::crc32::backend()
+}
+
+/// 获取当前生效的哈希算法实现描述
+///
+/// 格式如 `sha1=sha-ni,crc32=pclmulqdq`
+pub fn description() -> String {
+    format!("sha1={},crc32={}", sha1(), crc32())
+}
@@ -0,0 +1,39 @@
+use memmap::{Mmap, MmapOptions};
+use std::{convert::TryInto, fs::File};
+
+/// 以只读方式将文件映射到内存
+///
+/// 仅对长度与 `expected_size` 一致的普通文件生效。
+/// 对于管道、设备文件、空文件以及不支持内存映射的文件系统（如部分 Windows 网络共享），将返回 `None`，调用方应当回退到普通的读取方式。
+///
+/// 映射期间文件如果被截断，访问被截断的部分将触发 `SIGBUS`，因此只能用于 SDK 自身管理的文件，
+/// 或是用户显式启用了内存映射的文件
+pub(crate) fn map(file: &File, expected_size: u64) -> Option<Mmap> {
+    let metadata = file.metadata().ok()?;
+    if !metadata.is_file() || metadata.len() == 0 || metadata.len() != expected_size {
+        return None;
+    }
+    let len: usize = expected_size.try_into().ok()?;
+    // 映射期间文件内容如果被其他进程修改，读到的数据将随之变化，这与直接读取文件的行为一致
+    unsafe { MmapOptions::new().len(len).map(file) }.ok()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use qiniu_test_utils::temp_file::create_temp_file;
+    use std::{error::Error, fs::read, result::Result};
+
+    #[test]
+    fn test_mmap_map_file() -> Result<(), Box<dyn Error>> {
+        let temp_path = create_temp_file((1 << 20) + 1)?.into_temp_path();
+        let file = File::open(&temp_path)?;
+        let mapped = map(&file, (1 << 20) + 1).unwrap();
+        assert_eq!(&mapped[..], read(&temp_path)?.as_slice());
+        assert!(map(&file, 1 << 20).is_none());
+
+        let empty_path = create_temp_file(0)?.into_temp_path();
+        assert!(map(&File::open(&empty_path)?, 0).is_none());
+        Ok(())
+    }
+}
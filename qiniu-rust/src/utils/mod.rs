@@ -5,9 +5,14 @@ pub(crate) mod bool;
 pub(crate) mod cache_map;
 pub(crate) mod crc32;
 pub mod etag;
+pub mod hash_backend;
 pub(crate) mod mime;
+pub(crate) mod mmap;
+pub(crate) mod ring_queue;
 pub(crate) mod rob;
 pub(crate) mod ron;
 pub(crate) mod seek_adapter;
+pub(crate) mod sha1;
+pub(crate) mod snapshot;
 pub mod thread_pool;
 pub(crate) use thread_pool::THREAD_POOL as global_thread_pool;
@@ -0,0 +1,217 @@
+use std::{
+    cell::UnsafeCell,
+    fmt,
+    mem::MaybeUninit,
+    sync::atomic::{AtomicUsize, Ordering},
+};
+
+struct Slot<T> {
+    // 槽位序号，用于判断该槽位当前可写入还是可读取
+    sequence: AtomicUsize,
+    value: UnsafeCell<MaybeUninit<T>>,
+}
+
+/// 无锁有界环形队列
+///
+/// 基于 Dmitry Vyukov 的有界 MPMC 队列算法，写入和读取均只需要原子操作。
+/// 队列满时可以选择直接失败，或丢弃最早写入的记录后再写入
+pub(crate) struct RingQueue<T> {
+    slots: Box<[Slot<T>]>,
+    mask: usize,
+    enqueue_pos: AtomicUsize,
+    dequeue_pos: AtomicUsize,
+}
+
+unsafe impl<T: Send> Send for RingQueue<T> {}
+unsafe impl<T: Send> Sync for RingQueue<T> {}
+
+impl<T> RingQueue<T> {
+    /// 创建环形队列，实际容量为不小于 `capacity` 的 2 的幂
+    pub(crate) fn new(capacity: usize) -> Self {
+        let capacity = capacity.max(2).next_power_of_two();
+        RingQueue {
+            slots: (0..capacity)
+                .map(|i| Slot {
+                    sequence: AtomicUsize::new(i),
+                    value: UnsafeCell::new(MaybeUninit::uninit()),
+                })
+                .collect(),
+            mask: capacity - 1,
+            enqueue_pos: AtomicUsize::new(0),
+            dequeue_pos: AtomicUsize::new(0),
+        }
+    }
+
+    #[inline]
+    pub(crate) fn capacity(&self) -> usize {
+        self.slots.len()
+    }
+
+    /// 写入记录，队列已满时将记录原样返回
+    pub(crate) fn try_push(&self, value: T) -> Result<(), T> {
+        let mut pos = self.enqueue_pos.load(Ordering::Relaxed);
+        loop {
+            let slot = &self.slots[pos & self.mask];
+            let sequence = slot.sequence.load(Ordering::Acquire);
+            let diff = sequence.wrapping_sub(pos) as isize;
+            if diff == 0 {
+                match self.enqueue_pos.compare_exchange_weak(
+                    pos,
+                    pos.wrapping_add(1),
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        unsafe { (*slot.value.get()).as_mut_ptr().write(value) };
+                        slot.sequence.store(pos.wrapping_add(1), Ordering::Release);
+                        return Ok(());
+                    }
+                    Err(current) => pos = current,
+                }
+            } else if diff < 0 {
+                return Err(value);
+            } else {
+                pos = self.enqueue_pos.load(Ordering::Relaxed);
+            }
+        }
+    }
+
+    /// 写入记录，队列已满时丢弃最早写入的记录，被丢弃的记录将被传给 `on_dropped`
+    pub(crate) fn push_overwrite(&self, mut value: T, mut on_dropped: impl FnMut(T)) {
+        loop {
+            match self.try_push(value) {
+                Ok(()) => return,
+                Err(returned) => {
+                    value = returned;
+                    if let Some(dropped) = self.pop() {
+                        on_dropped(dropped);
+                    }
+                }
+            }
+        }
+    }
+
+    /// 读取最早写入的记录，队列为空时返回 `None`
+    pub(crate) fn pop(&self) -> Option<T> {
+        let mut pos = self.dequeue_pos.load(Ordering::Relaxed);
+        loop {
+            let slot = &self.slots[pos & self.mask];
+            let sequence = slot.sequence.load(Ordering::Acquire);
+            let diff = sequence.wrapping_sub(pos.wrapping_add(1)) as isize;
+            if diff == 0 {
+                match self.dequeue_pos.compare_exchange_weak(
+                    pos,
+                    pos.wrapping_add(1),
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        let value = unsafe { (*slot.value.get()).as_ptr().read() };
+                        slot.sequence
+                            .store(pos.wrapping_add(self.mask).wrapping_add(1), Ordering::Release);
+                        return Some(value);
+                    }
+                    Err(current) => pos = current,
+                }
+            } else if diff < 0 {
+                return None;
+            } else {
+                pos = self.dequeue_pos.load(Ordering::Relaxed);
+            }
+        }
+    }
+
+    /// 队列当前的记录数量，并发写入或读取时仅为近似值
+    pub(crate) fn len(&self) -> usize {
+        let dequeue_pos = self.dequeue_pos.load(Ordering::Relaxed);
+        let enqueue_pos = self.enqueue_pos.load(Ordering::Relaxed);
+        enqueue_pos.wrapping_sub(dequeue_pos).min(self.capacity())
+    }
+}
+
+impl<T> Drop for RingQueue<T> {
+    fn drop(&mut self) {
+        while self.pop().is_some() {}
+    }
+}
+
+impl<T> fmt::Debug for RingQueue<T> {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_struct("RingQueue")
+            .field("capacity", &self.capacity())
+            .field("len", &self.len())
+            .finish()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::{
+        collections::HashSet,
+        sync::{atomic::AtomicBool, Arc},
+        thread,
+    };
+
+    #[test]
+    fn test_ring_queue_push_and_pop() {
+        let queue = RingQueue::new(3);
+        assert_eq!(queue.capacity(), 4);
+        assert_eq!(queue.len(), 0);
+        for i in 0..4 {
+            queue.try_push(i).unwrap();
+        }
+        assert_eq!(queue.try_push(4), Err(4));
+        let mut dropped = Vec::new();
+        queue.push_overwrite(4, |value| dropped.push(value));
+        queue.push_overwrite(5, |value| dropped.push(value));
+        assert_eq!(dropped, vec![0, 1]);
+        assert_eq!(queue.len(), 4);
+        assert_eq!((0..4).filter_map(|_| queue.pop()).collect::<Vec<_>>(), vec![2, 3, 4, 5]);
+        assert_eq!(queue.pop(), None);
+
+        let queue = RingQueue::new(2);
+        queue.try_push(Arc::new(1)).unwrap();
+        let value = Arc::new(2);
+        queue.try_push(value.to_owned()).unwrap();
+        drop(queue);
+        assert_eq!(Arc::strong_count(&value), 1);
+    }
+
+    #[test]
+    fn test_ring_queue_in_multiple_threads() {
+        let queue = Arc::new(RingQueue::new(64));
+        let producers: Vec<_> = (0..8)
+            .map(|thread_id| {
+                let queue = queue.to_owned();
+                thread::spawn(move || {
+                    let mut dropped = 0;
+                    for i in 0..1000 {
+                        queue.push_overwrite(thread_id * 1000 + i, |_| dropped += 1);
+                    }
+                    dropped
+                })
+            })
+            .collect();
+        let done = Arc::new(AtomicBool::new(false));
+        let consumer = {
+            let (queue, done) = (queue.to_owned(), done.to_owned());
+            thread::spawn(move || {
+                let mut popped = Vec::new();
+                loop {
+                    let finished = done.load(Ordering::Acquire);
+                    match queue.pop() {
+                        Some(value) => popped.push(value),
+                        None if finished => return popped,
+                        None => thread::yield_now(),
+                    }
+                }
+            })
+        };
+        let dropped: usize = producers.into_iter().map(|producer| producer.join().unwrap()).sum();
+        done.store(true, Ordering::Release);
+        let values = consumer.join().unwrap();
+        assert_eq!(values.len() + dropped, 8000);
+        assert_eq!(values.iter().collect::<HashSet<_>>().len(), values.len());
+    }
+}
@@ -0,0 +1,254 @@
+//! SHA-1 计算器
+//!
+//! 启用 `accelerated-hash` 功能后，如果运行时检测到 CPU 支持 x86_64 SHA 扩展指令集，将自动使用硬件加速的 SHA-1 实现，
+//! 否则依然使用 `sha-1` 库提供的软件实现
+
+#[cfg(not(all(feature = "accelerated-hash", target_arch = "x86_64")))]
+pub(crate) use sha1::Sha1;
+
+#[cfg(all(feature = "accelerated-hash", target_arch = "x86_64"))]
+pub(crate) use accelerated::Sha1;
+
+/// 当前生效的 SHA-1 实现名称
+pub(crate) fn backend() -> &'static str {
+    #[cfg(all(feature = "accelerated-hash", target_arch = "x86_64"))]
+    {
+        if accelerated::is_supported() {
+            return "sha-ni";
+        }
+    }
+    "software"
+}
+
+#[cfg(all(feature = "accelerated-hash", target_arch = "x86_64"))]
+mod accelerated {
+    use digest::{
+        generic_array::{typenum::U20, GenericArray},
+        FixedOutput, Input, Reset,
+    };
+    use lazy_static::lazy_static;
+    use std::arch::x86_64::*;
+
+    const BLOCK_SIZE: usize = 64;
+    const INITIAL_STATE: [u32; 5] = [0x6745_2301, 0xefcd_ab89, 0x98ba_dcfe, 0x1032_5476, 0xc3d2_e1f0];
+
+    lazy_static! {
+        static ref SHA_NI_SUPPORTED: bool = is_x86_feature_detected!("sha")
+            && is_x86_feature_detected!("sse2")
+            && is_x86_feature_detected!("ssse3")
+            && is_x86_feature_detected!("sse4.1");
+    }
+
+    pub(super) fn is_supported() -> bool {
+        *SHA_NI_SUPPORTED
+    }
+
+    #[derive(Clone)]
+    pub(crate) enum Sha1 {
+        Software(sha1::Sha1),
+        ShaNi(ShaNiSha1),
+    }
+
+    impl Default for Sha1 {
+        fn default() -> Self {
+            if is_supported() {
+                Sha1::ShaNi(ShaNiSha1::default())
+            } else {
+                Sha1::Software(sha1::Sha1::default())
+            }
+        }
+    }
+
+    impl Input for Sha1 {
+        fn input<B: AsRef<[u8]>>(&mut self, data: B) {
+            match self {
+                Sha1::Software(sha1) => sha1.input(data),
+                Sha1::ShaNi(sha1) => sha1.update(data.as_ref()),
+            }
+        }
+    }
+
+    impl FixedOutput for Sha1 {
+        type OutputSize = U20;
+
+        fn fixed_result(self) -> GenericArray<u8, Self::OutputSize> {
+            match self {
+                Sha1::Software(sha1) => sha1.fixed_result(),
+                Sha1::ShaNi(sha1) => sha1.finalize(),
+            }
+        }
+    }
+
+    impl Reset for Sha1 {
+        fn reset(&mut self) {
+            match self {
+                Sha1::Software(sha1) => sha1.reset(),
+                Sha1::ShaNi(sha1) => *sha1 = ShaNiSha1::default(),
+            }
+        }
+    }
+
+    #[derive(Clone)]
+    pub(crate) struct ShaNiSha1 {
+        state: [u32; 5],
+        buffer: [u8; BLOCK_SIZE],
+        buffer_len: usize,
+        total_len: u64,
+    }
+
+    impl Default for ShaNiSha1 {
+        fn default() -> Self {
+            ShaNiSha1 {
+                state: INITIAL_STATE,
+                buffer: [0u8; BLOCK_SIZE],
+                buffer_len: 0,
+                total_len: 0,
+            }
+        }
+    }
+
+    impl ShaNiSha1 {
+        fn update(&mut self, mut data: &[u8]) {
+            self.total_len = self.total_len.wrapping_add(data.len() as u64);
+            if self.buffer_len > 0 {
+                let n = data.len().min(BLOCK_SIZE - self.buffer_len);
+                self.buffer[self.buffer_len..self.buffer_len + n].copy_from_slice(&data[..n]);
+                self.buffer_len += n;
+                data = &data[n..];
+                if self.buffer_len < BLOCK_SIZE {
+                    return;
+                }
+                unsafe { compress(&mut self.state, &self.buffer) };
+                self.buffer_len = 0;
+            }
+            let blocks_len = data.len() - data.len() % BLOCK_SIZE;
+            if blocks_len > 0 {
+                unsafe { compress(&mut self.state, &data[..blocks_len]) };
+            }
+            let rest = &data[blocks_len..];
+            self.buffer[..rest.len()].copy_from_slice(rest);
+            self.buffer_len = rest.len();
+        }
+
+        fn finalize(mut self) -> GenericArray<u8, U20> {
+            let bit_len = self.total_len.wrapping_mul(8);
+            let mut padding = [0u8; BLOCK_SIZE];
+            padding[0] = 0x80;
+            let padding_len = if self.buffer_len < 56 {
+                56 - self.buffer_len
+            } else {
+                120 - self.buffer_len
+            };
+            self.update(&padding[..padding_len]);
+            self.update(&bit_len.to_be_bytes());
+            let mut result = GenericArray::default();
+            for (bytes, word) in result.chunks_exact_mut(4).zip(self.state.iter()) {
+                bytes.copy_from_slice(&word.to_be_bytes());
+            }
+            result
+        }
+    }
+
+    macro_rules! rounds4 {
+        ($h0:ident, $h1:ident, $wk:expr, $i:expr) => {
+            _mm_sha1rnds4_epu32($h0, _mm_sha1nexte_epu32($h1, $wk), $i)
+        };
+    }
+
+    macro_rules! schedule {
+        ($v0:expr, $v1:expr, $v2:expr, $v3:expr) => {
+            _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32($v0, $v1), $v2), $v3)
+        };
+    }
+
+    macro_rules! schedule_rounds4 {
+        ($h0:ident, $h1:ident, $w0:expr, $w1:expr, $w2:expr, $w3:expr, $w4:expr, $i:expr) => {
+            $w4 = schedule!($w0, $w1, $w2, $w3);
+            $h1 = rounds4!($h0, $h1, $w4, $i);
+        };
+    }
+
+    /// 使用 SHA 扩展指令集压缩数据块，`blocks` 的长度必须是 64 的整数倍
+    #[target_feature(enable = "sha,sse2,ssse3,sse4.1")]
+    unsafe fn compress(state: &mut [u32; 5], blocks: &[u8]) {
+        let mask = _mm_set_epi64x(0x0001_0203_0405_0607, 0x0809_0a0b_0c0d_0e0f);
+        let mut state_abcd = _mm_set_epi32(state[0] as i32, state[1] as i32, state[2] as i32, state[3] as i32);
+        let mut state_e = _mm_set_epi32(state[4] as i32, 0, 0, 0);
+
+        for block in blocks.chunks_exact(BLOCK_SIZE) {
+            #[allow(clippy::cast_ptr_alignment)]
+            let block_ptr = block.as_ptr() as *const __m128i;
+            let mut w0 = _mm_shuffle_epi8(_mm_loadu_si128(block_ptr), mask);
+            let mut w1 = _mm_shuffle_epi8(_mm_loadu_si128(block_ptr.add(1)), mask);
+            let mut w2 = _mm_shuffle_epi8(_mm_loadu_si128(block_ptr.add(2)), mask);
+            let mut w3 = _mm_shuffle_epi8(_mm_loadu_si128(block_ptr.add(3)), mask);
+            let mut w4;
+
+            let mut h0 = state_abcd;
+            let mut h1 = _mm_add_epi32(state_e, w0);
+
+            // 第 0 - 19 轮
+            h1 = _mm_sha1rnds4_epu32(h0, h1, 0);
+            h0 = rounds4!(h1, h0, w1, 0);
+            h1 = rounds4!(h0, h1, w2, 0);
+            h0 = rounds4!(h1, h0, w3, 0);
+            schedule_rounds4!(h0, h1, w0, w1, w2, w3, w4, 0);
+
+            // 第 20 - 39 轮
+            schedule_rounds4!(h1, h0, w1, w2, w3, w4, w0, 1);
+            schedule_rounds4!(h0, h1, w2, w3, w4, w0, w1, 1);
+            schedule_rounds4!(h1, h0, w3, w4, w0, w1, w2, 1);
+            schedule_rounds4!(h0, h1, w4, w0, w1, w2, w3, 1);
+            schedule_rounds4!(h1, h0, w0, w1, w2, w3, w4, 1);
+
+            // 第 40 - 59 轮
+            schedule_rounds4!(h0, h1, w1, w2, w3, w4, w0, 2);
+            schedule_rounds4!(h1, h0, w2, w3, w4, w0, w1, 2);
+            schedule_rounds4!(h0, h1, w3, w4, w0, w1, w2, 2);
+            schedule_rounds4!(h1, h0, w4, w0, w1, w2, w3, 2);
+            schedule_rounds4!(h0, h1, w0, w1, w2, w3, w4, 2);
+
+            // 第 60 - 79 轮
+            schedule_rounds4!(h1, h0, w1, w2, w3, w4, w0, 3);
+            schedule_rounds4!(h0, h1, w2, w3, w4, w0, w1, 3);
+            schedule_rounds4!(h1, h0, w3, w4, w0, w1, w2, 3);
+            schedule_rounds4!(h0, h1, w4, w0, w1, w2, w3, 3);
+            schedule_rounds4!(h1, h0, w0, w1, w2, w3, w4, 3);
+
+            state_abcd = _mm_add_epi32(state_abcd, h0);
+            state_e = _mm_sha1nexte_epu32(h1, state_e);
+        }
+
+        state[0] = _mm_extract_epi32(state_abcd, 3) as u32;
+        state[1] = _mm_extract_epi32(state_abcd, 2) as u32;
+        state[2] = _mm_extract_epi32(state_abcd, 1) as u32;
+        state[3] = _mm_extract_epi32(state_abcd, 0) as u32;
+        state[4] = _mm_extract_epi32(state_e, 3) as u32;
+    }
+
+    #[cfg(test)]
+    mod tests {
+        use super::*;
+        use std::{boxed::Box, error::Error, result::Result};
+
+        #[test]
+        fn test_sha_ni_sha1_matches_software_sha1() -> Result<(), Box<dyn Error>> {
+            if !is_supported() {
+                return Ok(());
+            }
+            let data = (0..10000u32).map(|i| (i * 7 + i / 13) as u8).collect::<Vec<_>>();
+            for &len in [0, 1, 3, 55, 56, 63, 64, 65, 119, 120, 128, 1000, 10000].iter() {
+                for &chunk_size in [1, 7, 64, 100, 10000].iter() {
+                    let mut accelerated = ShaNiSha1::default();
+                    let mut software = sha1::Sha1::default();
+                    for chunk in data[..len].chunks(chunk_size) {
+                        accelerated.update(chunk);
+                        software.input(chunk);
+                    }
+                    assert_eq!(accelerated.finalize(), software.fixed_result());
+                }
+            }
+            Ok(())
+        }
+    }
+}
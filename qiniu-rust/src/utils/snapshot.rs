@@ -0,0 +1,320 @@
+//! 二进制快照格式
+//!
+//! 快照由固定长度的头部和正文组成。
+//! 头部依次为 4 字节魔数，4 字节格式版本号，8 字节正文长度以及 4 字节正文 CRC32 校验和，所有整数均为小端序。
+//! 读取时将逐一校验头部的各项内容，任何一项不符都视为数据无效，调用方应当回退到其他格式或丢弃快照。
+//!
+//! 读取器直接在传入的字节切片（通常是文件的内存映射）上解码，字符串等数据无需复制即可读取
+
+use super::crc32;
+use std::{
+    convert::TryInto,
+    io::{Error as IOError, ErrorKind as IOErrorKind, Result as IOResult},
+    net::{IpAddr, Ipv4Addr, Ipv6Addr, SocketAddr},
+    str::from_utf8,
+    time::{Duration, SystemTime, UNIX_EPOCH},
+};
+
+const HEADER_SIZE: usize = 20;
+
+/// 判断数据是否以指定魔数开头
+pub(crate) fn is_snapshot(bytes: &[u8], magic: &[u8; 4]) -> bool {
+    bytes.starts_with(magic)
+}
+
+/// 获取数据开头的快照的完整长度，用于快照之后还有其他数据的场合
+///
+/// 仅解析头部中记录的正文长度，不校验快照内容，数据不足一个头部时返回 `None`
+pub(crate) fn snapshot_len(bytes: &[u8]) -> Option<usize> {
+    let body_len = u64::from_le_bytes(bytes.get(8..16)?.try_into().unwrap());
+    (HEADER_SIZE as u64).checked_add(body_len)?.try_into().ok()
+}
+
+/// 快照写入器
+pub(crate) struct SnapshotWriter {
+    buf: Vec<u8>,
+}
+
+impl SnapshotWriter {
+    pub(crate) fn new() -> Self {
+        SnapshotWriter {
+            buf: vec![0; HEADER_SIZE],
+        }
+    }
+
+    pub(crate) fn put_u8(&mut self, value: u8) -> &mut Self {
+        self.buf.push(value);
+        self
+    }
+
+    pub(crate) fn put_bool(&mut self, value: bool) -> &mut Self {
+        self.put_u8(value as u8)
+    }
+
+    pub(crate) fn put_u16(&mut self, value: u16) -> &mut Self {
+        self.buf.extend_from_slice(&value.to_le_bytes());
+        self
+    }
+
+    pub(crate) fn put_u32(&mut self, value: u32) -> &mut Self {
+        self.buf.extend_from_slice(&value.to_le_bytes());
+        self
+    }
+
+    pub(crate) fn put_u64(&mut self, value: u64) -> &mut Self {
+        self.buf.extend_from_slice(&value.to_le_bytes());
+        self
+    }
+
+    pub(crate) fn put_f64(&mut self, value: f64) -> &mut Self {
+        self.put_u64(value.to_bits())
+    }
+
+    /// 写入长度或数量，超过 `u32` 范围将 Panic
+    pub(crate) fn put_len(&mut self, len: usize) -> &mut Self {
+        self.put_u32(len.try_into().expect("Length is too large for snapshot"))
+    }
+
+    pub(crate) fn put_str(&mut self, value: &str) -> &mut Self {
+        self.put_len(value.len());
+        self.buf.extend_from_slice(value.as_bytes());
+        self
+    }
+
+    pub(crate) fn put_duration(&mut self, value: Duration) -> &mut Self {
+        self.put_u64(value.as_secs()).put_u32(value.subsec_nanos())
+    }
+
+    pub(crate) fn put_optional_duration(&mut self, value: Option<Duration>) -> &mut Self {
+        match value {
+            Some(value) => self.put_bool(true).put_duration(value),
+            None => self.put_bool(false),
+        }
+    }
+
+    /// 早于 UNIX 纪元的时间将被记录为 UNIX 纪元
+    pub(crate) fn put_system_time(&mut self, value: SystemTime) -> &mut Self {
+        self.put_duration(value.duration_since(UNIX_EPOCH).unwrap_or_default())
+    }
+
+    /// IPv6 地址的流标签和范围 ID 不会被记录
+    pub(crate) fn put_socket_addr(&mut self, value: &SocketAddr) -> &mut Self {
+        match value.ip() {
+            IpAddr::V4(ip) => {
+                self.put_u8(4);
+                self.buf.extend_from_slice(&ip.octets());
+            }
+            IpAddr::V6(ip) => {
+                self.put_u8(6);
+                self.buf.extend_from_slice(&ip.octets());
+            }
+        }
+        self.put_u16(value.port())
+    }
+
+    /// 填写头部并返回完整的快照数据
+    pub(crate) fn finish(mut self, magic: &[u8; 4], version: u32) -> Vec<u8> {
+        let body_len = (self.buf.len() - HEADER_SIZE) as u64;
+        let crc32 = crc32::from_bytes(&self.buf[HEADER_SIZE..]);
+        self.buf[..4].copy_from_slice(magic);
+        self.buf[4..8].copy_from_slice(&version.to_le_bytes());
+        self.buf[8..16].copy_from_slice(&body_len.to_le_bytes());
+        self.buf[16..20].copy_from_slice(&crc32.to_le_bytes());
+        self.buf
+    }
+}
+
+/// 快照读取器
+pub(crate) struct SnapshotReader<'a> {
+    version: u32,
+    buf: &'a [u8],
+}
+
+impl<'a> SnapshotReader<'a> {
+    /// 校验快照头部，并创建快照读取器
+    ///
+    /// 快照版本号高于 `max_version` 时将返回错误，较低版本的快照应由调用方根据 `version()` 自行兼容
+    pub(crate) fn new(bytes: &'a [u8], magic: &[u8; 4], max_version: u32) -> IOResult<Self> {
+        if bytes.len() < HEADER_SIZE || !is_snapshot(bytes, magic) {
+            return Err(invalid_data("Invalid snapshot header"));
+        }
+        let version = u32::from_le_bytes(bytes[4..8].try_into().unwrap());
+        if version == 0 || version > max_version {
+            return Err(invalid_data(format!("Unsupported snapshot version: {}", version)));
+        }
+        let body_len = u64::from_le_bytes(bytes[8..16].try_into().unwrap());
+        let body = &bytes[HEADER_SIZE..];
+        if body.len() as u64 != body_len {
+            return Err(invalid_data("Snapshot is truncated"));
+        }
+        if crc32::from_bytes(body) != u32::from_le_bytes(bytes[16..20].try_into().unwrap()) {
+            return Err(invalid_data("Snapshot checksum mismatch"));
+        }
+        Ok(SnapshotReader { version, buf: body })
+    }
+
+    #[inline]
+    pub(crate) fn version(&self) -> u32 {
+        self.version
+    }
+
+    #[inline]
+    pub(crate) fn is_empty(&self) -> bool {
+        self.buf.is_empty()
+    }
+
+    fn take(&mut self, len: usize) -> IOResult<&'a [u8]> {
+        if self.buf.len() < len {
+            return Err(invalid_data("Unexpected end of snapshot"));
+        }
+        let (taken, rest) = self.buf.split_at(len);
+        self.buf = rest;
+        Ok(taken)
+    }
+
+    pub(crate) fn get_u8(&mut self) -> IOResult<u8> {
+        Ok(self.take(1)?[0])
+    }
+
+    pub(crate) fn get_bool(&mut self) -> IOResult<bool> {
+        match self.get_u8()? {
+            0 => Ok(false),
+            1 => Ok(true),
+            value => Err(invalid_data(format!("Invalid bool value: {}", value))),
+        }
+    }
+
+    pub(crate) fn get_u16(&mut self) -> IOResult<u16> {
+        Ok(u16::from_le_bytes(self.take(2)?.try_into().unwrap()))
+    }
+
+    pub(crate) fn get_u32(&mut self) -> IOResult<u32> {
+        Ok(u32::from_le_bytes(self.take(4)?.try_into().unwrap()))
+    }
+
+    pub(crate) fn get_u64(&mut self) -> IOResult<u64> {
+        Ok(u64::from_le_bytes(self.take(8)?.try_into().unwrap()))
+    }
+
+    pub(crate) fn get_f64(&mut self) -> IOResult<f64> {
+        Ok(f64::from_bits(self.get_u64()?))
+    }
+
+    /// 读取长度或数量
+    ///
+    /// 由于每条记录至少占用一个字节，超过剩余数据长度的数量必然无效，这样可以避免按照损坏的数量预分配内存
+    pub(crate) fn get_len(&mut self) -> IOResult<usize> {
+        let len = self.get_u32()? as usize;
+        if len > self.buf.len() {
+            return Err(invalid_data("Unexpected end of snapshot"));
+        }
+        Ok(len)
+    }
+
+    pub(crate) fn get_str(&mut self) -> IOResult<&'a str> {
+        let len = self.get_len()?;
+        from_utf8(self.take(len)?).map_err(|err| invalid_data(err.to_string()))
+    }
+
+    pub(crate) fn get_duration(&mut self) -> IOResult<Duration> {
+        let secs = self.get_u64()?;
+        let nanos = self.get_u32()?;
+        if nanos >= 1_000_000_000 {
+            return Err(invalid_data("Invalid duration"));
+        }
+        Ok(Duration::new(secs, nanos))
+    }
+
+    pub(crate) fn get_optional_duration(&mut self) -> IOResult<Option<Duration>> {
+        if self.get_bool()? {
+            self.get_duration().map(Some)
+        } else {
+            Ok(None)
+        }
+    }
+
+    pub(crate) fn get_system_time(&mut self) -> IOResult<SystemTime> {
+        let duration = self.get_duration()?;
+        UNIX_EPOCH
+            .checked_add(duration)
+            .ok_or_else(|| invalid_data("Invalid system time"))
+    }
+
+    pub(crate) fn get_socket_addr(&mut self) -> IOResult<SocketAddr> {
+        let ip = match self.get_u8()? {
+            4 => {
+                let octets: [u8; 4] = self.take(4)?.try_into().unwrap();
+                IpAddr::V4(Ipv4Addr::from(octets))
+            }
+            6 => {
+                let octets: [u8; 16] = self.take(16)?.try_into().unwrap();
+                IpAddr::V6(Ipv6Addr::from(octets))
+            }
+            family => return Err(invalid_data(format!("Invalid address family: {}", family))),
+        };
+        Ok(SocketAddr::new(ip, self.get_u16()?))
+    }
+}
+
+fn invalid_data(message: impl Into<String>) -> IOError {
+    IOError::new(IOErrorKind::InvalidData, message.into())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::{error::Error, result::Result};
+
+    const MAGIC: &[u8; 4] = b"TEST";
+
+    #[test]
+    fn test_snapshot_write_and_read() -> Result<(), Box<dyn Error>> {
+        let now = UNIX_EPOCH + Duration::new(1_577_836_800, 123);
+        let mut writer = SnapshotWriter::new();
+        writer
+            .put_bool(true)
+            .put_u16(8080)
+            .put_f64(0.25)
+            .put_str("up.qiniup.com:80")
+            .put_optional_duration(Some(Duration::from_millis(1500)))
+            .put_optional_duration(None)
+            .put_system_time(now)
+            .put_socket_addr(&"127.0.0.1:80".parse()?)
+            .put_socket_addr(&"[::1]:443".parse()?);
+        let snapshot = writer.finish(MAGIC, 2);
+        assert!(is_snapshot(&snapshot, MAGIC));
+        assert_eq!(snapshot_len(&snapshot), Some(snapshot.len()));
+        assert_eq!(snapshot_len(&snapshot[..15]), None);
+
+        let mut reader = SnapshotReader::new(&snapshot, MAGIC, 2)?;
+        assert_eq!(reader.version(), 2);
+        assert_eq!(reader.get_bool()?, true);
+        assert_eq!(reader.get_u16()?, 8080);
+        assert_eq!(reader.get_f64()?, 0.25);
+        assert_eq!(reader.get_str()?, "up.qiniup.com:80");
+        assert_eq!(reader.get_optional_duration()?, Some(Duration::from_millis(1500)));
+        assert_eq!(reader.get_optional_duration()?, None);
+        assert_eq!(reader.get_system_time()?, now);
+        assert_eq!(reader.get_socket_addr()?, "127.0.0.1:80".parse()?);
+        assert_eq!(reader.get_socket_addr()?, "[::1]:443".parse()?);
+        assert!(reader.is_empty());
+        assert!(reader.get_u8().is_err());
+        Ok(())
+    }
+
+    #[test]
+    fn test_snapshot_reject_invalid_data() -> Result<(), Box<dyn Error>> {
+        let mut writer = SnapshotWriter::new();
+        writer.put_str("up.qiniup.com:80");
+        let snapshot = writer.finish(MAGIC, 1);
+
+        assert!(SnapshotReader::new(&snapshot, b"ABCD", 1).is_err());
+        assert!(SnapshotReader::new(&snapshot, MAGIC, 0).is_err());
+        assert!(SnapshotReader::new(&snapshot[..snapshot.len() - 1], MAGIC, 1).is_err());
+        let mut corrupted = snapshot.to_owned();
+        *corrupted.last_mut().unwrap() ^= 0xff;
+        assert!(SnapshotReader::new(&corrupted, MAGIC, 1).is_err());
+        assert!(SnapshotReader::new(b"{}", MAGIC, 1).is_err());
+        Ok(())
+    }
+}
@@ -2,20 +2,33 @@
 //!
 //! 为 Rust SDK 提供线程池，以实现类似于异步持久化，异步上传日志之类的功能
 //!
-//! 目前，该线程池中仅有最多一个线程
+//! 目前，该线程池中仅有最多一个线程。
+//!
+//! 此外还提供一个按需创建的共享上传线程池，供选择共享线程池的批量上传器共同使用，避免每次批量上传都创建新的线程池。
+//! 以及一个按需创建的异步上传线程池，专门用于驱动异步上传，不占用存储空间上传器中用于并发上传分片的线程。
+//! 以及一个按需创建的 Etag 线程池，供并行计算 Etag 时复用。
+//! 以及一个按需创建的对冲请求线程池，用于等待对冲请求延迟并发出对冲请求。
+//! 以及一个按需创建的批量操作线程池，供未指定专用线程池的批量操作共同使用
 
+use crate::storage::batch::DEFAULT_CONCURRENCY as DEFAULT_BATCH_OPERATIONS_CONCURRENCY;
 use lazy_static::lazy_static;
-use rayon::{ThreadPool, ThreadPoolBuilder};
-use std::sync::RwLock;
+use rayon::{ThreadPool, ThreadPoolBuildError, ThreadPoolBuilder};
+use std::sync::{Arc, Mutex, RwLock};
 
 lazy_static! {
     pub(crate) static ref THREAD_POOL: RwLock<ThreadPool> = RwLock::new(create_thread_pool(1));
+    static ref SHARED_UPLOAD_THREAD_POOL: Mutex<Option<Arc<ThreadPool>>> = Mutex::new(None);
+    static ref ASYNC_UPLOAD_THREAD_POOL: Mutex<Option<Arc<ThreadPool>>> = Mutex::new(None);
+    static ref ETAG_THREAD_POOL: Mutex<Option<(usize, Arc<ThreadPool>)>> = Mutex::new(None);
+    static ref HEDGE_THREAD_POOL: Mutex<Option<Arc<ThreadPool>>> = Mutex::new(None);
+    static ref BATCH_OPERATIONS_THREAD_POOL: Mutex<Option<Arc<ThreadPool>>> = Mutex::new(None);
 }
 
 /// 重建线程池
 ///
 /// 在每次 Fork 新进程后，应该在子进程内调用该方法以重建全局线程池，否则部分 SDK 功能在子进程内可能无法正常使用。
 /// 使用该方法也可以用于调整全局线程池线程数量。
+/// 共享上传线程池，异步上传线程池，Etag 线程池，对冲请求线程池和批量操作线程池也将被丢弃，并在下一次使用时重新创建。
 ///
 /// # Arguments
 ///
@@ -26,6 +39,121 @@ pub fn recreate_thread_pool(mut num_threads: usize) {
         num_threads = thread_pool.current_num_threads();
     }
     *thread_pool = create_thread_pool(num_threads);
+    SHARED_UPLOAD_THREAD_POOL.lock().unwrap().take();
+    ASYNC_UPLOAD_THREAD_POOL.lock().unwrap().take();
+    ETAG_THREAD_POOL.lock().unwrap().take();
+    HEDGE_THREAD_POOL.lock().unwrap().take();
+    BATCH_OPERATIONS_THREAD_POOL.lock().unwrap().take();
+}
+
+/// 获取共享上传线程池，如果尚未创建则立即创建
+///
+/// 线程数量等于 CPU 数量，但至少为 2，以免批量上传时嵌套使用线程池导致死锁。
+/// 正在使用旧线程池的上传不受线程池重建的影响
+pub(crate) fn shared_upload_thread_pool() -> Arc<ThreadPool> {
+    SHARED_UPLOAD_THREAD_POOL
+        .lock()
+        .unwrap()
+        .get_or_insert_with(|| {
+            let builder =
+                || ThreadPoolBuilder::new().thread_name(|index| format!("qiniu_ng_shared_upload_worker_{}", index));
+            let thread_pool = builder().build().unwrap();
+            if thread_pool.current_num_threads() > 1 {
+                Arc::new(thread_pool)
+            } else {
+                Arc::new(builder().num_threads(2).build().unwrap())
+            }
+        })
+        .to_owned()
+}
+
+/// 获取异步上传线程池，如果尚未创建则立即创建
+///
+/// 线程数量等于 CPU 数量，超出线程数量的异步上传将排队等待，尚未开始即被取消的异步上传不会占用线程。
+/// 正在使用旧线程池的上传不受线程池重建的影响
+pub(crate) fn async_upload_thread_pool() -> Arc<ThreadPool> {
+    ASYNC_UPLOAD_THREAD_POOL
+        .lock()
+        .unwrap()
+        .get_or_insert_with(|| {
+            Arc::new(
+                ThreadPoolBuilder::new()
+                    .thread_name(|index| format!("qiniu_ng_async_upload_worker_{}", index))
+                    .build()
+                    .unwrap(),
+            )
+        })
+        .to_owned()
+}
+
+/// 获取对冲请求线程池，如果尚未创建则立即创建
+///
+/// 线程数量等于 CPU 数量，超出线程数量的对冲请求将排队等待，在排队期间原请求已经完成的对冲请求将直接放弃。
+/// 正在使用旧线程池的请求不受线程池重建的影响
+pub(crate) fn hedge_thread_pool() -> Arc<ThreadPool> {
+    HEDGE_THREAD_POOL
+        .lock()
+        .unwrap()
+        .get_or_insert_with(|| {
+            Arc::new(
+                ThreadPoolBuilder::new()
+                    .thread_name(|index| format!("qiniu_ng_hedge_worker_{}", index))
+                    .build()
+                    .unwrap(),
+            )
+        })
+        .to_owned()
+}
+
+/// 获取共享的批量操作线程池，如果尚未创建则立即创建
+///
+/// 批量操作的线程大部分时间都在等待网络响应，因此线程数量等于 CPU 数量，但至少等于批量操作的默认并发数。
+/// 正在使用旧线程池的批量操作不受线程池重建的影响
+pub(crate) fn batch_operations_thread_pool() -> Arc<ThreadPool> {
+    BATCH_OPERATIONS_THREAD_POOL
+        .lock()
+        .unwrap()
+        .get_or_insert_with(|| {
+            let builder =
+                || ThreadPoolBuilder::new().thread_name(|index| format!("qiniu_ng_batch_operations_worker_{}", index));
+            let thread_pool = builder().build().unwrap();
+            if thread_pool.current_num_threads() >= DEFAULT_BATCH_OPERATIONS_CONCURRENCY {
+                Arc::new(thread_pool)
+            } else {
+                Arc::new(
+                    builder()
+                        .num_threads(DEFAULT_BATCH_OPERATIONS_CONCURRENCY)
+                        .build()
+                        .unwrap(),
+                )
+            }
+        })
+        .to_owned()
+}
+
+/// 获取用于并行计算 Etag 的线程池
+///
+/// 线程数量与上一次调用时相同则复用已经创建的线程池，否则将创建新的线程池并替换之前的线程池。
+/// 正在使用旧线程池的计算不受线程池替换的影响
+///
+/// # Arguments
+///
+/// * `num_threads` - 线程池线程数量。如果传入 0，则表示使用与 CPU 核心数相同的线程数量。
+pub fn etag_thread_pool(num_threads: usize) -> Result<Arc<ThreadPool>, ThreadPoolBuildError> {
+    let mut cached = ETAG_THREAD_POOL.lock().unwrap();
+    if let Some((cached_num_threads, thread_pool)) = cached.as_ref() {
+        if *cached_num_threads == num_threads {
+            return Ok(thread_pool.to_owned());
+        }
+    }
+    let thread_pool = Arc::new(
+        ThreadPoolBuilder::new()
+            .num_threads(num_threads)
+            .thread_name(|index| format!("qiniu_ng_etag_thread_{}", index))
+            .build()?,
+    );
+    *cached = Some((num_threads, thread_pool.to_owned()));
+    Ok(thread_pool)
 }
 
 fn create_thread_pool(num_threads: usize) -> ThreadPool {